@@ -249,6 +249,13 @@ function(parse_automake AM_FILE_NAME)
     list(APPEND AM_PROGRAMS ${AM_TARGET})
   endforeach()
 
+  # Search for programs with benchmarks
+  set(AM_BENCHMARKS)
+  foreach(AM_FILE ${BENCHMARKS})
+    am_target_name(${AM_FOLDER} ${AM_FILE} AM_TARGET)
+    list(APPEND AM_BENCHMARKS ${AM_TARGET})
+  endforeach()
+
   set(AM_MAN1_MANS)
   foreach(AM_MAN ${dist_man1_MANS})
     list(APPEND AM_MAN1_MANS ${AM_MAN})
@@ -271,6 +278,7 @@ function(parse_automake AM_FILE_NAME)
   set(AM_TARGETS ${AM_TARGETS} PARENT_SCOPE)
   set(AM_STATIC_LIBRARIES ${AM_STATIC_LIBRARIES} PARENT_SCOPE)
   set(AM_PROGRAMS ${AM_PROGRAMS} PARENT_SCOPE)
+  set(AM_BENCHMARKS ${AM_BENCHMARKS} PARENT_SCOPE)
   set(AM_MAN1_MANS ${AM_MAN1_MANS} PARENT_SCOPE)
   set(AM_MAN6_MANS ${AM_MAN6_MANS} PARENT_SCOPE)
   set(AM_DOCS ${AM_DOCS} PARENT_SCOPE)
@@ -50,89 +50,73 @@ static const uint32 kVersion2b = MKTAG('V', '2', '.', 'b');
 
 namespace Aurora {
 
-TwoDARow::TwoDARow(TwoDAFile &parent) : _parent(&parent) {
+TwoDARow::TwoDARow(TwoDAFile &parent, size_t row) : _parent(&parent), _row(row) {
 }
 
 TwoDARow::~TwoDARow() {
 }
 
 const Common::UString &TwoDARow::getString(size_t column) const {
-	const Common::UString &cell = getCell(column);
-	if (cell.empty() || (cell == "****"))
+	const TwoDAFile::Column *c = _parent->getColumn(_row, column);
+	if (!c || c->empty[_row])
 		return _parent->_defaultString;
 
-	return cell;
+	return _parent->_strings[c->strings[_row]];
 }
 
 const Common::UString &TwoDARow::getString(const Common::UString &column) const {
-	const Common::UString &cell = getCell(_parent->headerToColumn(column));
-	if (cell.empty() || (cell == "****"))
-		return _parent->_defaultString;
-
-	return cell;
+	return getString(_parent->headerToColumn(column));
 }
 
 int32 TwoDARow::getInt(size_t column) const {
-	const Common::UString &cell = getCell(column);
-	if (cell.empty() || (cell == "****"))
+	const TwoDAFile::Column *c = _parent->getColumn(_row, column);
+	if (!c)
 		return _parent->_defaultInt;
 
-	return _parent->parseInt(cell);
+	return c->ints[_row];
 }
 
 int32 TwoDARow::getInt(const Common::UString &column) const {
-	const Common::UString &cell = getCell(_parent->headerToColumn(column));
-	if (cell.empty() || (cell == "****"))
-		return _parent->_defaultInt;
-
-	return _parent->parseInt(cell);
+	return getInt(_parent->headerToColumn(column));
 }
 
 float TwoDARow::getFloat(size_t column) const {
-	const Common::UString &cell = getCell(column);
-	if (cell.empty() || (cell == "****"))
+	const TwoDAFile::Column *c = _parent->getColumn(_row, column);
+	if (!c)
 		return _parent->_defaultFloat;
 
-	return _parent->parseFloat(cell);
+	return c->floats[_row];
 }
 
 float TwoDARow::getFloat(const Common::UString &column) const {
-	const Common::UString &cell = getCell(_parent->headerToColumn(column));
-	if (cell.empty() || (cell == "****"))
-		return _parent->_defaultFloat;
-
-	return _parent->parseFloat(cell);
+	return getFloat(_parent->headerToColumn(column));
 }
 
 bool TwoDARow::empty(size_t column) const {
-	const Common::UString &cell = getCell(column);
-	if (cell.empty() || (cell == "****"))
+	const TwoDAFile::Column *c = _parent->getColumn(_row, column);
+	if (!c)
 		return true;
 
-	return false;
+	return c->empty[_row];
 }
 
 bool TwoDARow::empty(const Common::UString &column) const {
 	return empty(_parent->headerToColumn(column));
 }
 
-static const Common::UString kEmpty;
-const Common::UString &TwoDARow::getCell(size_t n) const {
-	if (n >= _data.size())
-		return kEmpty;
 
-	return _data[n];
+TwoDAFile::Column::Column() : indexed(false) {
 }
 
 
 TwoDAFile::TwoDAFile(Common::SeekableReadStream &twoda) :
-	_defaultInt(0), _defaultFloat(0.0f), _emptyRow(*this) {
+	_defaultInt(0), _defaultFloat(0.0f), _emptyRow(*this, SIZE_MAX) {
 
 	load(twoda);
 }
 
 TwoDAFile::TwoDAFile(const GDAFile &gda) :
-	_defaultInt(0), _defaultFloat(0.0f), _emptyRow(*this) {
+	_defaultInt(0), _defaultFloat(0.0f), _emptyRow(*this, SIZE_MAX) {
 
 	load(gda);
 }
@@ -162,6 +146,9 @@ void TwoDAFile::load(Common::SeekableReadStream &twoda) {
 		// Create the map to quickly translate headers to column indices
 		createHeaderMap();
 
+		// Parse all cells into ints and floats
+		parseColumns();
+
 	} catch (Common::Exception &e) {
 		e.add("Failed reading 2DA file");
 		throw;
@@ -184,13 +171,19 @@ void TwoDAFile::read2a(Common::SeekableReadStream &twoda) {
 
 	readDefault2a(twoda, tokenize);
 	readHeaders2a(twoda, tokenize);
+
+	createColumns();
+
 	readRows2a(twoda, tokenize);
 }
 
 void TwoDAFile::read2b(Common::SeekableReadStream &twoda) {
 	readHeaders2b(twoda);
-	skipRowNames2b(twoda);
-	readRows2b(twoda);
+
+	createColumns();
+
+	const size_t rowCount = skipRowNames2b(twoda);
+	readRows2b(twoda, rowCount);
 }
 
 void TwoDAFile::readDefault2a(Common::SeekableReadStream &twoda,
@@ -231,9 +224,10 @@ void TwoDAFile::readRows2a(Common::SeekableReadStream &twoda,
 
 	const size_t columnCount = _headers.size();
 
-	while (!twoda.eos()) {
-		Common::ScopedPtr<TwoDARow> row(new TwoDARow(*this));
+	StringIndex stringIndex;
+	std::vector<Common::UString> cells;
 
+	while (!twoda.eos()) {
 		/* Skip the first token, which is the row index, possibly indented.
 		 * The row index is implicit in the data and its use in the 2DA
 		 * file is only meant as a guideline for people editing the file by
@@ -242,7 +236,7 @@ void TwoDAFile::readRows2a(Common::SeekableReadStream &twoda,
 		tokenize.skipToken(twoda);
 
 		// Read all the cells in the row
-		size_t count = tokenize.getTokens(twoda, row->_data, columnCount, columnCount, "****");
+		size_t count = tokenize.getTokens(twoda, cells, columnCount, columnCount, "****");
 
 		// And move to the next line
 		tokenize.nextChunk(twoda);
@@ -251,7 +245,7 @@ void TwoDAFile::readRows2a(Common::SeekableReadStream &twoda,
 		if (count == 0)
 			continue;
 
-		_rows.push_back(row.release());
+		addRow(cells, stringIndex);
 	}
 }
 
@@ -272,7 +266,7 @@ void TwoDAFile::readHeaders2b(Common::SeekableReadStream &twoda) {
 	}
 }
 
-void TwoDAFile::skipRowNames2b(Common::SeekableReadStream &twoda) {
+size_t TwoDAFile::skipRowNames2b(Common::SeekableReadStream &twoda) {
 	/* Next up are the row names / indices. Like for the ASCII 2DA files,
 	 * the actual row indices are implicit in the data, so we're just
 	 * ignoring them. The only information we care about is how many rows
@@ -280,7 +274,6 @@ void TwoDAFile::skipRowNames2b(Common::SeekableReadStream &twoda) {
 	 */
 
 	const uint32 rowCount = twoda.readUint32LE();
-	_rows.resize(rowCount, 0);
 
 	Common::StreamTokenizer tokenize(Common::StreamTokenizer::kRuleHeed);
 
@@ -289,9 +282,11 @@ void TwoDAFile::skipRowNames2b(Common::SeekableReadStream &twoda) {
 	tokenize.addSeparator('\0');
 
 	tokenize.skipToken(twoda, rowCount);
+
+	return rowCount;
 }
 
-void TwoDAFile::readRows2b(Common::SeekableReadStream &twoda) {
+void TwoDAFile::readRows2b(Common::SeekableReadStream &twoda, size_t rowCount) {
 	/* And now read the cells. In binary 2DA files, each cell only
 	 * stores a single 16-bit number, the offset into the data segment
 	 * where the data for this cell can be found. Moreover, a single
@@ -300,7 +295,6 @@ void TwoDAFile::readRows2b(Common::SeekableReadStream &twoda) {
 	 */
 
 	const size_t columnCount = _headers.size();
-	const size_t rowCount    = _rows.size();
 	const size_t cellCount   = columnCount * rowCount;
 
 	Common::ScopedArray<uint32> offsets(new uint32[cellCount]);
@@ -316,20 +310,23 @@ void TwoDAFile::readRows2b(Common::SeekableReadStream &twoda) {
 
 	const size_t dataOffset = twoda.pos();
 
-	for (size_t i = 0; i < rowCount; i++) {
-		_rows[i] = new TwoDARow(*this);
+	StringIndex stringIndex;
+	std::vector<Common::UString> cells(columnCount);
 
-		_rows[i]->_data.resize(columnCount);
+	_rows.reserve(rowCount);
 
+	for (size_t i = 0; i < rowCount; i++) {
 		for (size_t j = 0; j < columnCount; j++) {
 			const size_t offset = dataOffset + offsets[i * columnCount + j];
 
 			twoda.seek(offset);
 
-			_rows[i]->_data[j] = tokenize.getToken(twoda);
-			if (_rows[i]->_data[j].empty())
-				_rows[i]->_data[j] = "****";
+			cells[j] = tokenize.getToken(twoda);
+			if (cells[j].empty())
+				cells[j] = "****";
 		}
+
+		addRow(cells, stringIndex);
 	}
 }
 
@@ -338,6 +335,120 @@ void TwoDAFile::createHeaderMap() {
 		_headerMap.insert(std::make_pair(_headers[i], i));
 }
 
+void TwoDAFile::createColumns() {
+	_columns.resize(_headers.size(), 0);
+	for (size_t i = 0; i < _columns.size(); i++)
+		_columns[i] = new Column;
+}
+
+void TwoDAFile::addRow(const std::vector<Common::UString> &cells, StringIndex &stringIndex) {
+	assert(cells.size() == _columns.size());
+
+	/* Store each distinct cell string only once. Most 2DAs repeat
+	 * the same handful of values over and over again. */
+
+	for (size_t i = 0; i < cells.size(); i++) {
+		const Common::UString &cell = cells[i];
+
+		StringIndex::const_iterator string = stringIndex.find(cell);
+		if (string == stringIndex.end()) {
+			string = stringIndex.insert(std::make_pair(cell, (uint32) _strings.size())).first;
+
+			_strings.push_back(cell);
+		}
+
+		_columns[i]->strings.push_back(string->second);
+		_columns[i]->empty.push_back(cell.empty() || (cell == "****"));
+	}
+
+	_rows.push_back(new TwoDARow(*this, _rows.size()));
+}
+
+/** Could this string be parsed into a number at all?
+ *
+ *  A string that can't is parsed as 0 anyway, so checking this first
+ *  saves us the expensive failed parse for the usual label strings.
+ */
+static bool couldBeNumber(const Common::UString &str, bool isFloat) {
+	Common::UString::iterator c = str.begin();
+	while ((c != str.end()) && Common::UString::isSpace(*c))
+		++c;
+
+	if (c == str.end())
+		return false;
+
+	if (Common::UString::isDigit(*c) || (*c == '-') || (*c == '+'))
+		return true;
+
+	// strtof() additionally understands ".5", "inf" and "nan"
+	const uint32 lower = Common::UString::toLower(*c);
+	if (isFloat && ((*c == '.') || (lower == 'i') || (lower == 'n')))
+		return true;
+
+	return false;
+}
+
+void TwoDAFile::parseColumns() {
+	/* Parse every distinct cell string into an int and a float once,
+	 * and then spread the values over the columns. Empty cells hold
+	 * the default values, so that reading a cell is a simple lookup. */
+
+	std::vector<int32> ints(_strings.size(), 0);
+	std::vector<float> floats(_strings.size(), 0.0f);
+
+	for (size_t i = 0; i < _strings.size(); i++) {
+		if (couldBeNumber(_strings[i], false))
+			ints[i] = parseInt(_strings[i]);
+		if (couldBeNumber(_strings[i], true))
+			floats[i] = parseFloat(_strings[i]);
+	}
+
+	for (Common::PtrVector<Column>::iterator c = _columns.begin(); c != _columns.end(); ++c) {
+		Column &column = **c;
+
+		column.ints.resize(column.strings.size());
+		column.floats.resize(column.strings.size());
+
+		for (size_t i = 0; i < column.strings.size(); i++) {
+			column.ints  [i] = column.empty[i] ? _defaultInt   : ints  [column.strings[i]];
+			column.floats[i] = column.empty[i] ? _defaultFloat : floats[column.strings[i]];
+		}
+	}
+}
+
+static const Common::UString kEmpty;
+const Common::UString &TwoDAFile::getCell(size_t row, size_t column) const {
+	const Column *c = getColumn(row, column);
+	if (!c)
+		return kEmpty;
+
+	return _strings[c->strings[row]];
+}
+
+const TwoDAFile::Column *TwoDAFile::getColumn(size_t row, size_t column) const {
+	if ((row >= _rows.size()) || (column >= _columns.size()))
+		return 0;
+
+	return _columns[column];
+}
+
+const TwoDAFile::RowIndex &TwoDAFile::getRowIndex(size_t column) const {
+	/* Index the rows by their (case-insensitive) values in this column.
+	 * Like a linear search, this finds the first row with a value, and
+	 * empty cells have the default string as their value. */
+
+	const Column &c = *_columns[column];
+	if (c.indexed)
+		return c.index;
+
+	c.index.reserve(_rows.size());
+	for (size_t i = 0; i < _rows.size(); i++)
+		c.index.insert(std::make_pair(_rows[i]->getString(column), i));
+
+	c.indexed = true;
+	return c.index;
+}
+
 void TwoDAFile::load(const GDAFile &gda) {
 	try {
 
@@ -351,31 +462,35 @@ void TwoDAFile::load(const GDAFile &gda) {
 			_headers[i] = headerString ? headerString : Common::UString::format("[%u]", headers[i].hash);
 		}
 
-		_rows.resize(gda.getRowCount(), 0);
+		createColumns();
+
+		StringIndex stringIndex;
+		std::vector<Common::UString> cells(gda.getColumnCount());
+
+		_rows.reserve(gda.getRowCount());
 		for (size_t i = 0; i < gda.getRowCount(); i++) {
 			const GFF4Struct *row = gda.getRow(i);
 
-			_rows[i] = new TwoDARow(*this);
-			_rows[i]->_data.resize(gda.getColumnCount());
-
 			for (size_t j = 0; j < gda.getColumnCount(); j++) {
+				cells[j].clear();
+
 				if (row) {
 					switch (headers[j].type) {
 						case GDAFile::kTypeString:
 						case GDAFile::kTypeResource:
-							_rows[i]->_data[j] = row->getString(headers[j].field);
+							cells[j] = row->getString(headers[j].field);
 							break;
 
 						case GDAFile::kTypeInt:
-							_rows[i]->_data[j] = Common::UString::format("%d", (int) row->getSint(headers[j].field));
+							cells[j] = Common::UString::format("%d", (int) row->getSint(headers[j].field));
 							break;
 
 						case GDAFile::kTypeFloat:
-							_rows[i]->_data[j] = Common::UString::format("%f", row->getDouble(headers[j].field));
+							cells[j] = Common::UString::format("%f", row->getDouble(headers[j].field));
 							break;
 
 						case GDAFile::kTypeBool:
-							_rows[i]->_data[j] = Common::UString::format("%u", (uint) row->getUint(headers[j].field));
+							cells[j] = Common::UString::format("%u", (uint) row->getUint(headers[j].field));
 							break;
 
 						default:
@@ -383,10 +498,12 @@ void TwoDAFile::load(const GDAFile &gda) {
 					}
 				}
 
-				if (_rows[i]->_data[j].empty())
-					_rows[i]->_data[j] = "****";
+				if (cells[j].empty())
+					cells[j] = "****";
 
 			}
+
+			addRow(cells, stringIndex);
 		}
 
 	} catch (Common::Exception &e) {
@@ -395,6 +512,7 @@ void TwoDAFile::load(const GDAFile &gda) {
 	}
 
 	createHeaderMap();
+	parseColumns();
 }
 
 size_t TwoDAFile::getRowCount() const {
@@ -431,13 +549,16 @@ const TwoDARow &TwoDAFile::getRow(const Common::UString &header, const Common::U
 	if (columnIndex == kFieldIDInvalid)
 		return _emptyRow;
 
-	for (std::vector<TwoDARow *>::const_iterator row = _rows.begin(); row != _rows.end(); ++row) {
-		if ((*row)->getString(columnIndex).equalsIgnoreCase(value))
-			return **row;
-	}
+	std::lock_guard<std::mutex> lock(_indexMutex);
+
+	const RowIndex &index = getRowIndex(columnIndex);
+
+	RowIndex::const_iterator row = index.find(value);
+	if (row == index.end())
+		// No such row
+		return _emptyRow;
 
-	// No such row
-	return _emptyRow;
+	return *_rows[row->second];
 }
 
 void TwoDAFile::writeASCII(Common::WriteStream &out) const {
@@ -460,9 +581,9 @@ void TwoDAFile::writeASCII(Common::WriteStream &out) const {
 		colLength[i + 1] = _headers[i].size();
 
 	for (size_t i = 0; i < _rows.size(); i++) {
-		for (size_t j = 0; j < _rows[i]->_data.size(); j++) {
-			const bool   needQuote = _rows[i]->_data[j].contains(' ');
-			const size_t length    = needQuote ? _rows[i]->_data[j].size() + 2 : _rows[i]->_data[j].size();
+		for (size_t j = 0; j < _columns.size(); j++) {
+			const bool   needQuote = getCell(i, j).contains(' ');
+			const size_t length    = needQuote ? getCell(i, j).size() + 2 : getCell(i, j).size();
 
 			colLength[j + 1] = MAX<size_t>(colLength[j + 1], length);
 		}
@@ -482,14 +603,14 @@ void TwoDAFile::writeASCII(Common::WriteStream &out) const {
 	for (size_t i = 0; i < _rows.size(); i++) {
 		out.writeString(Common::UString::format("%*u", (int)colLength[0], (uint)i));
 
-		for (size_t j = 0; j < _rows[i]->_data.size(); j++) {
-			const bool needQuote = _rows[i]->_data[j].contains(' ');
+		for (size_t j = 0; j < _columns.size(); j++) {
+			const bool needQuote = getCell(i, j).contains(' ');
 
 			Common::UString cellString;
 			if (needQuote)
-				cellString = Common::UString::format("\"%s\"", _rows[i]->_data[j].c_str());
+				cellString = Common::UString::format("\"%s\"", getCell(i, j).c_str());
 			else
-				cellString = _rows[i]->_data[j];
+				cellString = getCell(i, j);
 
 			out.writeString(Common::UString::format(" %-*s", (int)colLength[j + 1], cellString.c_str()));
 
@@ -641,19 +762,19 @@ void TwoDAFile::writeCSV(Common::WriteStream &out) const {
 	// Write array
 
 	for (size_t i = 0; i < _rows.size(); i++) {
-		for (size_t j = 0; j < _rows[i]->_data.size(); j++) {
-			const bool needQuote = _rows[i]->_data[j].contains(',');
+		for (size_t j = 0; j < _columns.size(); j++) {
+			const bool needQuote = getCell(i, j).contains(',');
 
 			if (needQuote)
 				out.writeByte('"');
 
-			if (_rows[i]->_data[j] != "****")
-				out.writeString(_rows[i]->_data[j]);
+			if (getCell(i, j) != "****")
+				out.writeString(getCell(i, j));
 
 			if (needQuote)
 				out.writeByte('"');
 
-			if (j < (_rows[i]->_data.size() - 1))
+			if (j < (_columns.size() - 1))
 				out.writeByte(',');
 		}
 
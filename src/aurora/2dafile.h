@@ -27,8 +27,10 @@
 
 #include <vector>
 #include <map>
+#include <mutex>
 
 #include <boost/noncopyable.hpp>
+#include <boost/unordered/unordered_map.hpp>
 
 #include "src/common/types.h"
 #include "src/common/ustring.h"
@@ -83,13 +85,11 @@ public:
 private:
 	TwoDAFile *_parent; ///< The parent 2DA.
 
-	std::vector<Common::UString> _data;
+	size_t _row; ///< The index of this row within the parent 2DA.
 
-	TwoDARow(TwoDAFile &parent);
+	TwoDARow(TwoDAFile &parent, size_t row);
 	~TwoDARow();
 
-	const Common::UString &getCell(size_t n) const;
-
 	friend class TwoDAFile;
 
 	template<typename T>
@@ -119,6 +119,11 @@ private:
  *  be read and modified with a simple text editor. The binary
  *  version cannot.
  *
+ *  Internally, the cells are stored column by column. Each distinct
+ *  cell string is only stored once, and each column is parsed into
+ *  ints and floats once, when loading. Looking up a row by the value
+ *  of a column builds a hash index of that column on first use.
+ *
  *  See also classes TwoDARow and TwoDARegistry.
  */
 class TwoDAFile : boost::noncopyable, public AuroraFile {
@@ -165,6 +170,26 @@ public:
 private:
 	typedef std::map<Common::UString, size_t, Common::UString::iless> HeaderMap;
 
+	/** Maps a cell value (case-insensitively) to the first row containing it. */
+	typedef boost::unordered_map<Common::UString, size_t,
+	                             Common::hashUStringCaseInsensitive, Common::UString::iequal> RowIndex;
+	/** Maps a cell string to its index in the string table. */
+	typedef boost::unordered_map<Common::UString, uint32, Common::hashUStringCaseSensitive> StringIndex;
+
+	/** All cells of one column. */
+	struct Column {
+		std::vector<uint32> strings; ///< For each row, the index of the cell string in the string table.
+		std::vector<bool>   empty;   ///< For each row, is the cell empty ("****")?
+
+		std::vector<int32> ints;   ///< For each row, the cell parsed as an int.
+		std::vector<float> floats; ///< For each row, the cell parsed as a float.
+
+		mutable bool     indexed; ///< Has the row index been built yet?
+		mutable RowIndex index;   ///< The rows, indexed by their values in this column.
+
+		Column();
+	};
+
 	Common::UString _defaultString; ///< The default string to return should a cell not exist.
 	int32           _defaultInt;    ///< The default int to return should a cell not exist.
 	float           _defaultFloat;  ///< The default float to return should a cell not exist.
@@ -175,6 +200,12 @@ private:
 	TwoDARow _emptyRow;
 	Common::PtrVector<TwoDARow> _rows;
 
+	std::vector<Common::UString> _strings; ///< All distinct cell strings.
+	Common::PtrVector<Column>    _columns; ///< The cells, column by column.
+
+	/** Protects the lazily built row indices of the columns. */
+	mutable std::mutex _indexMutex;
+
 	// Loading helpers
 	void load(Common::SeekableReadStream &twoda);
 	void read2a(Common::SeekableReadStream &twoda);
@@ -186,15 +217,28 @@ private:
 	void readRows2a   (Common::SeekableReadStream &twoda, Common::StreamTokenizer &tokenize);
 
 	// Binary loading helpers
-	void readHeaders2b (Common::SeekableReadStream &twoda);
-	void skipRowNames2b(Common::SeekableReadStream &twoda);
-	void readRows2b    (Common::SeekableReadStream &twoda);
+	void   readHeaders2b (Common::SeekableReadStream &twoda);
+	size_t skipRowNames2b(Common::SeekableReadStream &twoda);
+	void   readRows2b    (Common::SeekableReadStream &twoda, size_t rowCount);
 
 	// GDA loading/conversion helpers
 	void load(const GDAFile &gda);
 
 	void createHeaderMap();
 
+	// Cell storage helpers
+	void createColumns();
+	void addRow(const std::vector<Common::UString> &cells, StringIndex &stringIndex);
+	void parseColumns();
+
+	/** Return the raw string of a cell, or an empty string if the cell doesn't exist. */
+	const Common::UString &getCell(size_t row, size_t column) const;
+	/** Return the column, or 0 if the cell doesn't exist. */
+	const Column *getColumn(size_t row, size_t column) const;
+
+	/** Return the row index of this column, building it if necessary. */
+	const RowIndex &getRowIndex(size_t column) const;
+
 	static int32 parseInt(const Common::UString &str);
 	static float parseFloat(const Common::UString &str);
 
@@ -22,7 +22,12 @@
  *  Handling various archive files.
  */
 
+#include <cstring>
+
 #include "src/common/system.h"
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+#include "src/common/mappedfile.h"
 
 #include "src/aurora/archive.h"
 
@@ -45,6 +50,10 @@ Common::HashAlgo Archive::getNameHashAlgo() const {
 	return Common::kHashNone;
 }
 
+bool Archive::hasPackedResources() const {
+	return false;
+}
+
 uint32 Archive::findResource(uint64 hash) const {
 	if (getNameHashAlgo() == Common::kHashNone)
 		return 0xFFFFFFFF;
@@ -64,4 +73,34 @@ uint32 Archive::findResource(const Common::UString &name, FileType type) const {
 	return 0xFFFFFFFF;
 }
 
+Common::MemoryReadStream *Archive::readStreamAt(Common::SeekableReadStream &stream, size_t offset,
+                                                size_t size, bool tryNoCopy) const {
+
+	// A mapped stream always hands out views, and they keep the mapping alive
+	const Common::MappedReadStream *mapped = dynamic_cast<const Common::MappedReadStream *>(&stream);
+	if (mapped)
+		return mapped->getSubStream(offset, offset + size);
+
+	// Other memory streams can be read directly, without seeking
+	const Common::MemoryReadStream *memory = dynamic_cast<const Common::MemoryReadStream *>(&stream);
+	if (memory) {
+		if ((offset > memory->size()) || (size > (memory->size() - offset)))
+			throw Common::Exception(Common::kReadError);
+
+		if (tryNoCopy)
+			return new Common::MemoryReadStream(memory->getData() + offset, size);
+
+		byte *data = new byte[size];
+		std::memcpy(data, memory->getData() + offset, size);
+
+		return new Common::MemoryReadStream(data, size, true);
+	}
+
+	std::lock_guard<std::mutex> lock(_streamMutex);
+
+	stream.seek(offset);
+
+	return stream.readStream(size);
+}
+
 } // End of namespace Aurora
@@ -32,16 +32,22 @@
 #include "src/common/types.h"
 #include "src/common/ustring.h"
 #include "src/common/hash.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/types.h"
 
 namespace Common {
 	class SeekableReadStream;
+	class MemoryReadStream;
 }
 
 namespace Aurora {
 
-/** An abstract file archive. */
+/** An abstract file archive.
+ *
+ *  All methods of an archive can be called from several threads at once,
+ *  once the archive has been loaded.
+ */
 class Archive : boost::noncopyable {
 public:
 	/** A resource within the archive. */
@@ -76,10 +82,34 @@ public:
 	/** Return with which algorithm the name is hashed. */
 	virtual Common::HashAlgo getNameHashAlgo() const;
 
+	/** Are the resources stored compressed or encrypted, so that reading one is more than a copy? */
+	virtual bool hasPackedResources() const;
+
 	/** Return the index of the resource matching the hash, or 0xFFFFFFFF if not found. */
 	uint32 findResource(uint64 hash) const;
 	/** Return the index of the resource matching the name and type, or 0xFFFFFFFF if not found. */
 	uint32 findResource(const Common::UString &name, FileType type) const;
+
+protected:
+	/** Guards the position of an archive stream that has to be seeked to read from it. */
+	mutable std::mutex _streamMutex;
+
+	/** Read a part of an archive stream into a stream of its own.
+	 *
+	 *  This is a positional read: it does not rely on the current position
+	 *  of the archive stream, so several threads can read out of the same
+	 *  archive at once. Memory-mapped and other memory streams are read
+	 *  without any seeking. All other streams are seeked and read while
+	 *  holding the archive's stream mutex.
+	 *
+	 *  @param  stream The archive stream, shared by all readers.
+	 *  @param  offset The offset of the part within the archive stream.
+	 *  @param  size The size of the part.
+	 *  @param  tryNoCopy Try to return a view into the archive stream instead of copying.
+	 *  @return A stream of the part's contents.
+	 */
+	Common::MemoryReadStream *readStreamAt(Common::SeekableReadStream &stream, size_t offset, size_t size,
+	                                       bool tryNoCopy = false) const;
 };
 
 } // End of namespace Aurora
@@ -141,12 +141,7 @@ uint32 BIFFile::getResourceSize(uint32 index) const {
 Common::SeekableReadStream *BIFFile::getResource(uint32 index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	if (tryNoCopy)
-		return new Common::SeekableSubReadStream(_bif.get(), res.offset, res.offset + res.size);
-
-	_bif->seek(res.offset);
-
-	return _bif->readStream(res.size);
+	return readStreamAt(*_bif, res.offset, res.size, tryNoCopy);
 }
 
 } // End of namespace Aurora
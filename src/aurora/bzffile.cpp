@@ -145,13 +145,18 @@ uint32 BZFFile::getResourceSize(uint32 index) const {
 Common::SeekableReadStream *BZFFile::getResource(uint32 index, bool UNUSED(tryNoCopy)) const {
 	const IResource &res = getIResource(index);
 
-	_bzf->seek(res.offset);
-
 #ifdef ENABLE_LZMA
-	return Common::decompressLZMA1(*_bzf, res.packedSize, res.size, true);
+	Common::ScopedPtr<Common::MemoryReadStream> packed(readStreamAt(*_bzf, res.offset, res.packedSize, true));
+
+	return Common::decompressLZMA1(*packed, res.packedSize, res.size, true);
 #else
 	throw Common::Exception("LZMA decompression disabled when building without liblzma");
 #endif
 }
 
+bool BZFFile::hasPackedResources() const {
+	// All BZF resources are LZMA-compressed
+	return true;
+}
+
 } // End of namespace Aurora
@@ -67,6 +67,9 @@ public:
 	/** Return a stream of the resource's contents. */
 	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
 
+	/** Are the resources stored compressed or encrypted? */
+	bool hasPackedResources() const;
+
 	/** Merge information from the KEY into the data file.
 	 *
 	 *  Without this step, this data file archive does not contain any
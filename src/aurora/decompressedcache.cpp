@@ -0,0 +1,185 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A cache of decompressed archive resources.
+ */
+
+#include "src/common/scopedptr.h"
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/decompressedcache.h"
+
+namespace Aurora {
+
+/** The decompressed data of a resource. */
+struct DecompressedCache::Data {
+	Common::ScopedArray<byte> data;
+	size_t size;
+
+	Data(size_t s) : data(new byte[s]), size(s) {
+	}
+};
+
+/** A stream reading out of cached resource data, keeping it alive. */
+class DecompressedCacheStream : public Common::MemoryReadStream {
+public:
+	DecompressedCacheStream(const boost::shared_ptr<const void> &owner, const byte *data, size_t size) :
+		Common::MemoryReadStream(data, size), _owner(owner) {
+	}
+
+	~DecompressedCacheStream() {
+	}
+
+private:
+	boost::shared_ptr<const void> _owner;
+};
+
+
+DecompressedCache::Statistics::Statistics() : hits(0), misses(0), evictions(0), count(0), size(0), budget(0) {
+}
+
+
+DecompressedCache::DecompressedCache() : _budget(0) {
+}
+
+DecompressedCache::~DecompressedCache() {
+}
+
+void DecompressedCache::setBudget(size_t budget) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_budget = budget;
+
+	evict();
+}
+
+size_t DecompressedCache::getBudget() const {
+	return _budget;
+}
+
+Common::SeekableReadStream *DecompressedCache::get(const Archive *archive, uint32 index) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	EntryMap::iterator entry = _entryMap.find(Key(archive, index));
+	if (entry == _entryMap.end()) {
+		_statistics.misses++;
+		return 0;
+	}
+
+	// Move the resource to the front, as the most recently used one
+	_entries.splice(_entries.begin(), _entries, entry->second);
+
+	_statistics.hits++;
+	return createStream(entry->second->data);
+}
+
+Common::SeekableReadStream *DecompressedCache::add(const Archive *archive, uint32 index,
+                                                   Common::SeekableReadStream *stream) {
+
+	Common::ScopedPtr<Common::SeekableReadStream> resource(stream);
+
+	const size_t size = resource->size();
+	if ((size == 0) || (size > _budget))
+		return resource.release();
+
+	// Read the whole resource outside of the lock, this might still be decompressing
+	boost::shared_ptr<Data> data(new Data(size));
+
+	resource->seek(0);
+	if (resource->read(data->data.get(), size) != size)
+		throw Common::Exception(Common::kReadError);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Another thread might have added the same resource in the meantime. Keep that one
+	EntryMap::iterator existing = _entryMap.find(Key(archive, index));
+	if (existing != _entryMap.end()) {
+		_entries.splice(_entries.begin(), _entries, existing->second);
+
+		return createStream(existing->second->data);
+	}
+
+	_entries.push_front(Entry());
+	_entries.front().key  = Key(archive, index);
+	_entries.front().data = data;
+
+	_entryMap.insert(std::make_pair(Key(archive, index), _entries.begin()));
+
+	_statistics.count++;
+	_statistics.size += size;
+
+	evict();
+
+	return createStream(data);
+}
+
+void DecompressedCache::remove(const Archive *archive) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	for (EntryList::iterator entry = _entries.begin(); entry != _entries.end(); ) {
+		if (entry->key.first == archive)
+			removeEntry(entry++);
+		else
+			++entry;
+	}
+}
+
+void DecompressedCache::clear() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_entries.clear();
+	_entryMap.clear();
+
+	_statistics.count = 0;
+	_statistics.size  = 0;
+}
+
+DecompressedCache::Statistics DecompressedCache::getStatistics() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Statistics statistics = _statistics;
+	statistics.budget = _budget;
+
+	return statistics;
+}
+
+void DecompressedCache::evict() {
+	while (!_entries.empty() && (_statistics.size > _budget)) {
+		removeEntry(--_entries.end());
+
+		_statistics.evictions++;
+	}
+}
+
+void DecompressedCache::removeEntry(EntryList::iterator entry) {
+	_statistics.count--;
+	_statistics.size -= entry->data->size;
+
+	_entryMap.erase(entry->key);
+	_entries.erase(entry);
+}
+
+Common::SeekableReadStream *DecompressedCache::createStream(const boost::shared_ptr<Data> &data) {
+	return new DecompressedCacheStream(data, data->data.get(), data->size);
+}
+
+} // End of namespace Aurora
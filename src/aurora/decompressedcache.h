@@ -0,0 +1,134 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A cache of decompressed archive resources.
+ */
+
+#ifndef AURORA_DECOMPRESSEDCACHE_H
+#define AURORA_DECOMPRESSEDCACHE_H
+
+#include <list>
+#include <utility>
+#include <atomic>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered/unordered_map.hpp>
+
+#include "src/common/types.h"
+#include "src/common/mutex.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+
+class Archive;
+
+/** A byte-budgeted LRU cache of decompressed archive resources.
+ *
+ *  Reading a resource out of a compressed or encrypted archive means
+ *  decrypting and decompressing it anew on every request. Some resources,
+ *  like 2DA and GFF files, are requested over and over during a single
+ *  area load. This cache keeps the decompressed data of the most recently
+ *  read resources, keyed by their archive and index, and hands out read-only
+ *  memory streams sharing that data. Data stays valid as long as a stream
+ *  still uses it, even after it has been evicted from the cache.
+ *
+ *  The cache is disabled while its budget is 0. All methods are thread-safe.
+ */
+class DecompressedCache : boost::noncopyable {
+public:
+	/** Statistics about the use of the cache. */
+	struct Statistics {
+		uint64 hits;      ///< Number of requests that were served from the cache.
+		uint64 misses;    ///< Number of requests that had to decompress the resource.
+		uint64 evictions; ///< Number of resources dropped to stay within the budget.
+
+		size_t count;  ///< Number of resources currently in the cache.
+		size_t size;   ///< Number of bytes currently in the cache.
+		size_t budget; ///< Maximum number of bytes to keep in the cache.
+
+		Statistics();
+	};
+
+	DecompressedCache();
+	~DecompressedCache();
+
+	/** Set the maximum number of bytes of decompressed data to keep. 0 disables the cache. */
+	void setBudget(size_t budget);
+	/** Return the maximum number of bytes of decompressed data to keep. */
+	size_t getBudget() const;
+
+	/** Return a stream of the cached data of an archive resource, or 0 if it's not cached. */
+	Common::SeekableReadStream *get(const Archive *archive, uint32 index);
+
+	/** Cache the data of an archive resource, and return a stream of it.
+	 *
+	 *  Takes over the stream. Data larger than the whole budget is not
+	 *  cached, and the stream is returned as it is.
+	 */
+	Common::SeekableReadStream *add(const Archive *archive, uint32 index, Common::SeekableReadStream *stream);
+
+	/** Drop all cached data of an archive. */
+	void remove(const Archive *archive);
+
+	/** Drop all cached data. */
+	void clear();
+
+	/** Return the current statistics of the cache. */
+	Statistics getStatistics() const;
+
+private:
+	struct Data;
+
+	typedef std::pair<const Archive *, uint32> Key;
+
+	struct Entry {
+		Key key;
+		boost::shared_ptr<Data> data;
+	};
+
+	/** All cached resources, most recently used first. */
+	typedef std::list<Entry> EntryList;
+	typedef boost::unordered_map<Key, EntryList::iterator> EntryMap;
+
+	std::atomic<size_t> _budget;
+
+	EntryList _entries;
+	EntryMap  _entryMap;
+
+	Statistics _statistics;
+
+	mutable std::mutex _mutex;
+
+	/** Drop the least recently used resources until we're within the budget. */
+	void evict();
+
+	void removeEntry(EntryList::iterator entry);
+
+	static Common::SeekableReadStream *createStream(const boost::shared_ptr<Data> &data);
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_DECOMPRESSEDCACHE_H
@@ -712,13 +712,11 @@ uint32 ERFFile::getResourceSize(uint32 index) const {
 Common::SeekableReadStream *ERFFile::getResource(uint32 index, bool tryNoCopy) const {
 	const IResource &res = getIResource(index);
 
-	if (tryNoCopy && (_header.encryption == kEncryptionNone) && (_header.compression == kCompressionNone))
-		return new Common::SeekableSubReadStream(_erf.get(), res.offset, res.offset + res.packedSize);
+	// Read. Only unencrypted, uncompressed data can be handed out without copying
+	const bool noCopy = tryNoCopy &&
+	                    (_header.encryption == kEncryptionNone) && (_header.compression == kCompressionNone);
 
-	_erf->seek(res.offset);
-
-	// Read
-	Common::MemoryReadStream *stream = _erf->readStream(res.packedSize);
+	Common::MemoryReadStream *stream = readStreamAt(*_erf, res.offset, res.packedSize, noCopy);
 
 	// Decrypt
 	if (_header.encryption != kEncryptionNone)
@@ -850,6 +848,10 @@ Common::HashAlgo ERFFile::getNameHashAlgo() const {
 	return (_version == kVersion30) ? Common::kHashFNV64 : Common::kHashNone;
 }
 
+bool ERFFile::hasPackedResources() const {
+	return (_header.encryption != kEncryptionNone) || (_header.compression != kCompressionNone);
+}
+
 LocString ERFFile::getDescription(Common::SeekableReadStream &erf) {
 	uint32 id, version;
 	bool ut16le;
@@ -140,6 +140,9 @@ public:
 	/** Return with which algorithm the name is hashed. */
 	Common::HashAlgo getNameHashAlgo() const;
 
+	/** Are the resources stored compressed or encrypted? */
+	bool hasPackedResources() const;
+
 	static LocString getDescription(Common::SeekableReadStream &erf);
 	static LocString getDescription(const Common::UString &fileName);
 
@@ -28,6 +28,8 @@
 
 #include <cassert>
 
+#include <algorithm>
+
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
 #include "src/common/encoding.h"
@@ -44,6 +46,8 @@ static const uint32 kVersion33 = MKTAG('V', '3', '.', '3'); // Found in The Witc
 
 namespace Aurora {
 
+const uint32 GFF3File::kLabelNone;
+
 GFF3File::Header::Header() {
 }
 
@@ -64,9 +68,11 @@ void GFF3File::Header::read(Common::SeekableReadStream &gff3) {
 
 
 GFF3File::GFF3File(Common::SeekableReadStream *gff3, uint32 id, bool repairNWNPremium) :
-	_stream(gff3), _repairNWNPremium(repairNWNPremium), _offsetCorrection(0) {
+	_repairNWNPremium(repairNWNPremium), _offsetCorrection(0) {
+
+	assert(gff3);
 
-	assert(_stream);
+	_stream.reset(Common::toMemoryStream(gff3));
 
 	load(id);
 }
@@ -74,10 +80,12 @@ GFF3File::GFF3File(Common::SeekableReadStream *gff3, uint32 id, bool repairNWNPr
 GFF3File::GFF3File(const Common::UString &gff3, FileType type, uint32 id, bool repairNWNPremium) :
 	_repairNWNPremium(repairNWNPremium), _offsetCorrection(0) {
 
-	_stream.reset(ResMan.getResource(gff3, type));
-	if (!_stream)
+	Common::SeekableReadStream *stream = ResMan.getResource(gff3, type);
+	if (!stream)
 		throw Common::Exception("No such GFF3 \"%s\"", TypeMan.setFileType(gff3, type).c_str());
 
+	_stream.reset(Common::toMemoryStream(stream));
+
 	load(id);
 }
 
@@ -92,6 +100,21 @@ const GFF3Struct &GFF3File::getTopLevel() const {
 	return getStruct(0);
 }
 
+uint32 GFF3File::getLabelID(const Common::UString &label) const {
+	LabelMap::const_iterator id = _labelIDs.find(label);
+	if (id == _labelIDs.end())
+		return kLabelNone;
+
+	return id->second;
+}
+
+const Common::UString &GFF3File::getLabel(uint32 id) const {
+	if (id >= _labels.size())
+		throw Common::Exception("GFF3: Label ID out of range (%u >= %u)", id, (uint) _labels.size());
+
+	return _labels[id];
+}
+
 // --- Loader ---
 
 void GFF3File::load(uint32 id) {
@@ -180,12 +203,63 @@ void GFF3File::loadHeader(uint32 id) {
 		throw Common::Exception("GFF3 header broken: section offset points outside stream");
 }
 
+void GFF3File::readSection(std::vector<byte> &data, uint32 offset, uint32 count, uint32 size) {
+	if (((uint64) offset + (uint64) count * size) > _stream->size())
+		throw Common::Exception("GFF3: Section at %u with %u entries reaches outside the stream", offset, count);
+
+	data.resize(count * size);
+	if (data.empty())
+		return;
+
+	_stream->seek(offset);
+	if (_stream->read(data.data(), data.size()) != data.size())
+		throw Common::Exception(Common::kReadError);
+}
+
+void GFF3File::loadLabels(std::vector<uint32> &labelIDs) {
+	/* Read all field labels once, and give every distinct label an ID.
+	 * The structs then only need to remember the ID of each field's label,
+	 * and finding a field by name is a single hash lookup, followed by a
+	 * binary search over integers within the struct. */
+
+	std::vector<byte> labels;
+	readSection(labels, _header.labelOffset, _header.labelCount, 16);
+
+	labelIDs.resize(_header.labelCount);
+	for (uint32 i = 0; i < _header.labelCount; i++) {
+		Common::MemoryReadStream labelStream(labels.data() + i * 16, 16);
+		const Common::UString label = Common::readStringFixed(labelStream, Common::kEncodingASCII, 16);
+
+		std::pair<LabelMap::iterator, bool> id = _labelIDs.insert(std::make_pair(label, (uint32) _labels.size()));
+		if (id.second)
+			_labels.push_back(label);
+
+		labelIDs[i] = id.first->second;
+	}
+}
+
 void GFF3File::loadStructs() {
 	static const uint32 kStructSize = 12;
+	static const uint32 kFieldSize  = 12;
+
+	std::vector<uint32> labelIDs;
+	loadLabels(labelIDs);
+
+	// Read the field and field indices tables in one go. The structs pick their fields out of them
+	std::vector<byte> fields, fieldIndices;
+	readSection(fields      , _header.fieldOffset       , _header.fieldCount       , kFieldSize);
+	readSection(fieldIndices, _header.fieldIndicesOffset, _header.fieldIndicesCount, 1);
+
+	std::vector<byte> structs;
+	readSection(structs, _header.structOffset, _header.structCount, kStructSize);
 
 	_structs.reserve(_header.structCount);
-	for (uint32 i = 0; i < _header.structCount; i++)
-		_structs.push_back(new GFF3Struct(*this, _header.structOffset + i * kStructSize));
+	for (uint32 i = 0; i < _header.structCount; i++) {
+		const byte *strct = structs.data() + i * kStructSize;
+
+		_structs.push_back(new GFF3Struct(*this, READ_LE_UINT32(strct)));
+		_structs.back()->load(READ_LE_UINT32(strct + 4), READ_LE_UINT32(strct + 8), fields, fieldIndices, labelIDs);
+	}
 }
 
 void GFF3File::loadLists() {
@@ -272,37 +346,36 @@ const GFF3List &GFF3File::getList(uint32 i) const {
 	return _lists[listIndex];
 }
 
-Common::SeekableReadStream &GFF3File::getStream(uint32 offset) const {
-	_stream->seek(offset);
+class GFF3File::FieldData : public Common::MemoryReadStream {
+public:
+	/** Create a view into the GFF3's data, seeked to this offset into the field data. */
+	FieldData(const GFF3File &gff3, uint32 offset) :
+		Common::MemoryReadStream(gff3._stream->getData(), gff3._stream->size()) {
 
-	return *_stream;
-}
-
-Common::SeekableReadStream &GFF3File::getFieldData() const {
-	return getStream(_header.fieldDataOffset);
-}
+		seek((size_t) gff3._header.fieldDataOffset + offset);
+	}
+};
 
 
-GFF3Struct::Field::Field() : type(kFieldTypeNone), data(0), extended(false) {
+GFF3Struct::Field::Field(uint32 l, FieldType t, uint32 d, uint32 o) : label(l), type(t), data(d), order(o) {
 }
 
-GFF3Struct::Field::Field(FieldType t, uint32 d) : type(t), data(d) {
+bool GFF3Struct::Field::isExtended() const {
 	// These field types need extended field data
-	extended = (type == kFieldTypeUint64     ) ||
-	           (type == kFieldTypeSint64     ) ||
-	           (type == kFieldTypeDouble     ) ||
-	           (type == kFieldTypeExoString  ) ||
-	           (type == kFieldTypeResRef     ) ||
-	           (type == kFieldTypeLocString  ) ||
-	           (type == kFieldTypeVoid       ) ||
-	           (type == kFieldTypeOrientation) ||
-	           (type == kFieldTypeVector     ) ||
-	           (type == kFieldTypeStrRef     );
+	return (type == kFieldTypeUint64     ) ||
+	       (type == kFieldTypeSint64     ) ||
+	       (type == kFieldTypeDouble     ) ||
+	       (type == kFieldTypeExoString  ) ||
+	       (type == kFieldTypeResRef     ) ||
+	       (type == kFieldTypeLocString  ) ||
+	       (type == kFieldTypeVoid       ) ||
+	       (type == kFieldTypeOrientation) ||
+	       (type == kFieldTypeVector     ) ||
+	       (type == kFieldTypeStrRef     );
 }
 
 
-GFF3Struct::GFF3Struct(const GFF3File &parent, uint32 offset) : _parent(&parent) {
-	load(offset);
+GFF3Struct::GFF3Struct(const GFF3File &parent, uint32 id) : _parent(&parent), _id(id) {
 }
 
 GFF3Struct::~GFF3Struct() {
@@ -314,81 +387,58 @@ uint32 GFF3Struct::getID() const {
 
 // --- Loader ---
 
-void GFF3Struct::load(uint32 offset) {
-	Common::SeekableReadStream &data = _parent->getStream(offset);
-
-	_id         = data.readUint32LE();
-	_fieldIndex = data.readUint32LE();
-	_fieldCount = data.readUint32LE();
-
-	// Read the field(s)
-	if      (_fieldCount == 1)
-		readField (data, _fieldIndex);
-	else if (_fieldCount > 1)
-		readFields(data, _fieldIndex, _fieldCount);
-}
-
-void GFF3Struct::readField(Common::SeekableReadStream &data, uint32 index) {
-	// Sanity check
-	if (index > _parent->_header.fieldCount)
-		throw Common::Exception("GFF3: Field index out of range (%d/%d)",
-				index, _parent->_header.fieldCount);
-
-	// Seek
-	data.seek(_parent->_header.fieldOffset + index * 12);
+void GFF3Struct::load(uint32 fieldIndex, uint32 fieldCount, const std::vector<byte> &fields,
+                      const std::vector<byte> &fieldIndices, const std::vector<uint32> &labelIDs) {
 
-	// Read the field data
-	const uint32 fieldType  = data.readUint32LE();
-	const uint32 fieldLabel = data.readUint32LE();
-	const uint32 fieldData  = data.readUint32LE();
+	if (fieldCount == 0)
+		return;
 
-	// Read the name
-	Common::UString fieldName = readLabel(data, fieldLabel);
+	// A single field is referenced directly, several fields through the field indices
+	if (fieldCount == 1) {
+		readField(fields, fieldIndex, labelIDs, 0);
+		return;
+	}
 
-	// And add the field to the map and name list
-	_fields[fieldName] = Field((FieldType) fieldType, fieldData);
+	if (((uint64) fieldIndex + (uint64) fieldCount * 4) > fieldIndices.size())
+		throw Common::Exception("GFF3: Field indices index out of range (%u+%u/%u)",
+		                        fieldIndex, fieldCount, (uint) fieldIndices.size());
 
-	_fieldNames.push_back(fieldName);
-}
+	_fields.reserve(fieldCount);
+	for (uint32 i = 0; i < fieldCount; i++)
+		readField(fields, READ_LE_UINT32(fieldIndices.data() + fieldIndex + i * 4), labelIDs, i);
 
-void GFF3Struct::readFields(Common::SeekableReadStream &data, uint32 index, uint32 count) {
-	// Sanity check
-	if (index > _parent->_header.fieldIndicesCount)
-		throw Common::Exception("GFF3: Field indices index out of range (%d/%d)",
-		                        index , _parent->_header.fieldIndicesCount);
+	std::stable_sort(_fields.begin(), _fields.end(), [](const Field &a, const Field &b) {
+		return a.label < b.label;
+	});
 
-	// Seek
-	data.seek(_parent->_header.fieldIndicesOffset + index);
+	// If a label appears more than once, the last field with it wins
+	FieldArray::iterator last = _fields.begin();
+	for (FieldArray::const_iterator f = _fields.begin(); f != _fields.end(); ++f)
+		if (((f + 1) == _fields.end()) || ((f + 1)->label != f->label))
+			*last++ = *f;
 
-	// Read the field indices
-	std::vector<uint32> indices;
-	readIndices(data, indices, count);
-
-	// Read the fields
-	for (std::vector<uint32>::const_iterator i = indices.begin(); i != indices.end(); ++i)
-		readField(data, *i);
+	_fields.erase(last, _fields.end());
 }
 
-void GFF3Struct::readIndices(Common::SeekableReadStream &data,
-                             std::vector<uint32> &indices, uint32 count) const {
-	indices.reserve(count);
-	while (count-- > 0)
-		indices.push_back(data.readUint32LE());
-}
+void GFF3Struct::readField(const std::vector<byte> &fields, uint32 index,
+                           const std::vector<uint32> &labelIDs, uint32 order) {
 
-Common::UString GFF3Struct::readLabel(Common::SeekableReadStream &data, uint32 index) const {
-	data.seek(_parent->_header.labelOffset + index * 16);
+	// Sanity check
+	if (index >= _parent->_header.fieldCount)
+		throw Common::Exception("GFF3: Field index out of range (%d/%d)",
+				index, _parent->_header.fieldCount);
 
-	return Common::readStringFixed(data, Common::kEncodingASCII, 16);
-}
+	const byte *field = fields.data() + index * 12;
 
-Common::SeekableReadStream &GFF3Struct::getData(const Field &field) const {
-	assert(field.extended);
+	const uint32 fieldType  = READ_LE_UINT32(field);
+	const uint32 fieldLabel = READ_LE_UINT32(field + 4);
+	const uint32 fieldData  = READ_LE_UINT32(field + 8);
 
-	Common::SeekableReadStream &data = _parent->getFieldData();
-	data.skip(field.data);
+	if (fieldLabel >= labelIDs.size())
+		throw Common::Exception("GFF3: Field label index out of range (%d/%d)",
+		                        fieldLabel, (uint) labelIDs.size());
 
-	return data;
+	_fields.push_back(Field(labelIDs[fieldLabel], (FieldType) fieldType, fieldData, order));
 }
 
 // --- Field properties ---
@@ -401,11 +451,34 @@ bool GFF3Struct::hasField(const Common::UString &field) const {
 	return getField(field) != 0;
 }
 
-const std::vector<Common::UString> &GFF3Struct::getFieldNames() const {
-	return _fieldNames;
+bool GFF3Struct::hasField(uint32 field) const {
+	return getField(field) != 0;
+}
+
+std::vector<Common::UString> GFF3Struct::getFieldNames() const {
+	FieldArray fields = _fields;
+	std::sort(fields.begin(), fields.end(), [](const Field &a, const Field &b) {
+		return a.order < b.order;
+	});
+
+	std::vector<Common::UString> fieldNames;
+	fieldNames.reserve(fields.size());
+
+	for (FieldArray::const_iterator f = fields.begin(); f != fields.end(); ++f)
+		fieldNames.push_back(_parent->getLabel(f->label));
+
+	return fieldNames;
+}
+
+uint32 GFF3Struct::getLabelID(const Common::UString &label) const {
+	return _parent->getLabelID(label);
 }
 
 GFF3Struct::FieldType GFF3Struct::getFieldType(const Common::UString &field) const {
+	return getFieldType(_parent->getLabelID(field));
+}
+
+GFF3Struct::FieldType GFF3Struct::getFieldType(uint32 field) const {
 	const Field *f = getField(field);
 	if (!f)
 		return kFieldTypeNone;
@@ -416,14 +489,24 @@ GFF3Struct::FieldType GFF3Struct::getFieldType(const Common::UString &field) con
 // --- Field value reader helpers ---
 
 const GFF3Struct::Field *GFF3Struct::getField(const Common::UString &name) const {
-	FieldMap::const_iterator field = _fields.find(name);
-	if (field == _fields.end())
+	return getField(_parent->getLabelID(name));
+}
+
+const GFF3Struct::Field *GFF3Struct::getField(uint32 label) const {
+	FieldArray::const_iterator field = std::lower_bound(_fields.begin(), _fields.end(), label,
+			[](const Field &f, uint32 l) { return f.label < l; });
+
+	if ((field == _fields.end()) || (field->label != label))
 		return 0;
 
-	return &field->second;
+	return &*field;
 }
 
 char GFF3Struct::getChar(const Common::UString &field, char def) const {
+	return getChar(_parent->getLabelID(field), def);
+}
+
+char GFF3Struct::getChar(uint32 field, char def) const {
 	const Field *f = getField(field);
 	if (!f)
 		return def;
@@ -434,6 +517,10 @@ char GFF3Struct::getChar(const Common::UString &field, char def) const {
 }
 
 uint64 GFF3Struct::getUint(const Common::UString &field, uint64 def) const {
+	return getUint(_parent->getLabelID(field), def);
+}
+
+uint64 GFF3Struct::getUint(uint32 field, uint64 def) const {
 	const Field *f = getField(field);
 	if (!f)
 		return def;
@@ -452,13 +539,13 @@ uint64 GFF3Struct::getUint(const Common::UString &field, uint64 def) const {
 	if (f->type == kFieldTypeSint32)
 		return (uint64) ((int64) ((int32) ((uint32) f->data)));
 	if (f->type == kFieldTypeUint64)
-		return (uint64) getData(*f).readUint64LE();
+		return (uint64) GFF3File::FieldData(*_parent, f->data).readUint64LE();
 	if (f->type == kFieldTypeSint64)
-		return ( int64) getData(*f).readUint64LE();
+		return ( int64) GFF3File::FieldData(*_parent, f->data).readUint64LE();
 
 	// StrRef, a numerical reference to a string in a talk table
 	if (f->type == kFieldTypeStrRef) {
-		Common::SeekableReadStream &data = getData(*f);
+		GFF3File::FieldData data(*_parent, f->data);
 
 		const uint32 size = data.readUint32LE();
 		if (size != 4)
@@ -471,6 +558,10 @@ uint64 GFF3Struct::getUint(const Common::UString &field, uint64 def) const {
 }
 
 int64 GFF3Struct::getSint(const Common::UString &field, int64 def) const {
+	return getSint(_parent->getLabelID(field), def);
+}
+
+int64 GFF3Struct::getSint(uint32 field, int64 def) const {
 	const Field *f = getField(field);
 	if (!f)
 		return def;
@@ -489,13 +580,13 @@ int64 GFF3Struct::getSint(const Common::UString &field, int64 def) const {
 	if (f->type == kFieldTypeSint32)
 		return (int64) ((int32) ((uint32) f->data));
 	if (f->type == kFieldTypeUint64)
-		return (int64) getData(*f).readUint64LE();
+		return (int64) GFF3File::FieldData(*_parent, f->data).readUint64LE();
 	if (f->type == kFieldTypeSint64)
-		return (int64) getData(*f).readUint64LE();
+		return (int64) GFF3File::FieldData(*_parent, f->data).readUint64LE();
 
 	// StrRef, a numerical reference to a string in a talk table
 	if (f->type == kFieldTypeStrRef) {
-		Common::SeekableReadStream &data = getData(*f);
+		GFF3File::FieldData data(*_parent, f->data);
 
 		const uint32 size = data.readUint32LE();
 		if (size != 4)
@@ -508,10 +599,18 @@ int64 GFF3Struct::getSint(const Common::UString &field, int64 def) const {
 }
 
 bool GFF3Struct::getBool(const Common::UString &field, bool def) const {
+	return getBool(_parent->getLabelID(field), def);
+}
+
+bool GFF3Struct::getBool(uint32 field, bool def) const {
 	return getUint(field, def) != 0;
 }
 
 double GFF3Struct::getDouble(const Common::UString &field, double def) const {
+	return getDouble(_parent->getLabelID(field), def);
+}
+
+double GFF3Struct::getDouble(uint32 field, double def) const {
 	const Field *f = getField(field);
 	if (!f)
 		return def;
@@ -519,7 +618,7 @@ double GFF3Struct::getDouble(const Common::UString &field, double def) const {
 	if (f->type == kFieldTypeFloat)
 		return convertIEEEFloat(f->data);
 	if (f->type == kFieldTypeDouble)
-		return getData(*f).readIEEEDoubleLE();
+		return GFF3File::FieldData(*_parent, f->data).readIEEEDoubleLE();
 
 	throw Common::Exception("GFF3: Field is not a double type");
 }
@@ -527,13 +626,19 @@ double GFF3Struct::getDouble(const Common::UString &field, double def) const {
 Common::UString GFF3Struct::getString(const Common::UString &field,
                                       const Common::UString &def) const {
 
+	return getString(_parent->getLabelID(field), def);
+}
+
+Common::UString GFF3Struct::getString(uint32 field,
+                                      const Common::UString &def) const {
+
 	const Field *f = getField(field);
 	if (!f)
 		return def;
 
 	// Direct string
 	if (f->type == kFieldTypeExoString) {
-		Common::SeekableReadStream &data = getData(*f);
+		GFF3File::FieldData data(*_parent, f->data);
 
 		const uint32 length = data.readUint32LE();
 		return Common::readStringFixed(data, Common::kEncodingASCII, length);
@@ -547,7 +652,7 @@ Common::UString GFF3Struct::getString(const Common::UString &field,
 		 * however, this limit has been lifted, and a full 255 characters
 		 * are available in ResRef string fields. */
 
-		Common::SeekableReadStream &data = getData(*f);
+		GFF3File::FieldData data(*_parent, f->data);
 
 		const uint32 length = data.readByte();
 		return Common::readStringFixed(data, Common::kEncodingASCII, length);
@@ -612,6 +717,10 @@ Common::UString GFF3Struct::getString(const Common::UString &field,
 }
 
 bool GFF3Struct::getLocString(const Common::UString &field, LocString &str) const {
+	return getLocString(_parent->getLabelID(field), str);
+}
+
+bool GFF3Struct::getLocString(uint32 field, LocString &str) const {
 	const Field *f = getField(field);
 	if (!f || (f->type != kFieldTypeLocString))
 		return false;
@@ -620,10 +729,13 @@ bool GFF3Struct::getLocString(const Common::UString &field, LocString &str) cons
 
 	try {
 
-		Common::SeekableReadStream &data = getData(*f);
+		GFF3File::FieldData data(*_parent, f->data);
 
 		const uint32 size = data.readUint32LE();
-		Common::SeekableSubReadStream locStringData(&data, data.pos(), data.pos() + size);
+		if (size > (data.size() - data.pos()))
+			throw Common::Exception(Common::kReadError);
+
+		Common::MemoryReadStream locStringData(data.getData() + data.pos(), size);
 
 		locString.readLocString(locStringData);
 
@@ -636,6 +748,10 @@ bool GFF3Struct::getLocString(const Common::UString &field, LocString &str) cons
 }
 
 Common::SeekableReadStream *GFF3Struct::getData(const Common::UString &field) const {
+	return getData(_parent->getLabelID(field));
+}
+
+Common::SeekableReadStream *GFF3Struct::getData(uint32 field) const {
 	const Field *f = getField(field);
 	if (!f)
 		return 0;
@@ -644,7 +760,7 @@ Common::SeekableReadStream *GFF3Struct::getData(const Common::UString &field) co
 	    (f->type != kFieldTypeResRef))
 		throw Common::Exception("GFF3: Field is not a data type");
 
-	Common::SeekableReadStream &data = getData(*f);
+	GFF3File::FieldData data(*_parent, f->data);
 
 	uint32 size = 0;
 	if      ((f->type == kFieldTypeVoid) || (f->type == kFieldTypeExoString))
@@ -660,13 +776,19 @@ Common::SeekableReadStream *GFF3Struct::getData(const Common::UString &field) co
 void GFF3Struct::getVector(const Common::UString &field,
                            float &x, float &y, float &z) const {
 
+	getVector(_parent->getLabelID(field), x, y, z);
+}
+
+void GFF3Struct::getVector(uint32 field,
+                           float &x, float &y, float &z) const {
+
 	const Field *f = getField(field);
 	if (!f)
 		return;
 	if (f->type != kFieldTypeVector)
 		throw Common::Exception("GFF3: Field is not a vector type");
 
-	Common::SeekableReadStream &data = getData(*f);
+	GFF3File::FieldData data(*_parent, f->data);
 
 	x = data.readIEEEFloatLE();
 	y = data.readIEEEFloatLE();
@@ -676,13 +798,19 @@ void GFF3Struct::getVector(const Common::UString &field,
 void GFF3Struct::getOrientation(const Common::UString &field,
                                 float &a, float &b, float &c, float &d) const {
 
+	getOrientation(_parent->getLabelID(field), a, b, c, d);
+}
+
+void GFF3Struct::getOrientation(uint32 field,
+                                float &a, float &b, float &c, float &d) const {
+
 	const Field *f = getField(field);
 	if (!f)
 		return;
 	if (f->type != kFieldTypeOrientation)
 		throw Common::Exception("GFF3: Field is not an orientation type");
 
-	Common::SeekableReadStream &data = getData(*f);
+	GFF3File::FieldData data(*_parent, f->data);
 
 	a = data.readIEEEFloatLE();
 	b = data.readIEEEFloatLE();
@@ -693,13 +821,19 @@ void GFF3Struct::getOrientation(const Common::UString &field,
 void GFF3Struct::getVector(const Common::UString &field,
                            double &x, double &y, double &z) const {
 
+	getVector(_parent->getLabelID(field), x, y, z);
+}
+
+void GFF3Struct::getVector(uint32 field,
+                           double &x, double &y, double &z) const {
+
 	const Field *f = getField(field);
 	if (!f)
 		return;
 	if (f->type != kFieldTypeVector)
 		throw Common::Exception("GFF3: Field is not a vector type");
 
-	Common::SeekableReadStream &data = getData(*f);
+	GFF3File::FieldData data(*_parent, f->data);
 
 	x = data.readIEEEFloatLE();
 	y = data.readIEEEFloatLE();
@@ -709,13 +843,19 @@ void GFF3Struct::getVector(const Common::UString &field,
 void GFF3Struct::getOrientation(const Common::UString &field,
                                 double &a, double &b, double &c, double &d) const {
 
+	getOrientation(_parent->getLabelID(field), a, b, c, d);
+}
+
+void GFF3Struct::getOrientation(uint32 field,
+                                double &a, double &b, double &c, double &d) const {
+
 	const Field *f = getField(field);
 	if (!f)
 		return;
 	if (f->type != kFieldTypeOrientation)
 		throw Common::Exception("GFF3: Field is not an orientation type");
 
-	Common::SeekableReadStream &data = getData(*f);
+	GFF3File::FieldData data(*_parent, f->data);
 
 	a = data.readIEEEFloatLE();
 	b = data.readIEEEFloatLE();
@@ -726,6 +866,10 @@ void GFF3Struct::getOrientation(const Common::UString &field,
 // --- Struct reader ---
 
 const GFF3Struct &GFF3Struct::getStruct(const Common::UString &field) const {
+	return getStruct(_parent->getLabelID(field));
+}
+
+const GFF3Struct &GFF3Struct::getStruct(uint32 field) const {
 	const Field *f = getField(field);
 	if (!f)
 		throw Common::Exception("GFF3: No such field");
@@ -739,6 +883,10 @@ const GFF3Struct &GFF3Struct::getStruct(const Common::UString &field) const {
 // --- Struct list reader ---
 
 const GFF3List &GFF3Struct::getList(const Common::UString &field) const {
+	return getList(_parent->getLabelID(field));
+}
+
+const GFF3List &GFF3Struct::getList(uint32 field) const {
 	const Field *f = getField(field);
 	if (!f)
 		throw Common::Exception("GFF3: No such field");
@@ -26,9 +26,9 @@
 #define AURORA_GFF3FILE_H
 
 #include <vector>
-#include <map>
 
 #include <boost/noncopyable.hpp>
+#include <boost/unordered/unordered_map.hpp>
 
 #include "src/common/types.h"
 #include "src/common/scopedptr.h"
@@ -40,6 +40,7 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class MemoryReadStream;
 }
 
 namespace Aurora {
@@ -79,6 +80,12 @@ class GFF3Struct;
  *  LocStrings is different. Since xoreos has more flexible handling of
  *  language IDs anyway, this doesn't concern us.
  *
+ *  All field labels of a GFF3 are read once when loading, and each distinct
+ *  label gets a numerical ID. These IDs are only valid within the same GFF3
+ *  file. Callers that repeatedly read the same fields from many structs can
+ *  look up the IDs once with getLabelID() and then use the GFF3Struct
+ *  methods that take label IDs, skipping all string comparisons.
+ *
  *  See also: GFF4File in gff4file.h for the later V4.0/V4.1 versions of
  *  the GFF format.
  */
@@ -96,6 +103,14 @@ public:
 	/** Returns the top-level struct. */
 	const GFF3Struct &getTopLevel() const;
 
+	/** The label ID of a label that no field in this GFF3 uses. */
+	static const uint32 kLabelNone = 0xFFFFFFFF;
+
+	/** Return the ID of this field label, or kLabelNone if no field in this GFF3 uses it. */
+	uint32 getLabelID(const Common::UString &label) const;
+	/** Return the field label with this ID. */
+	const Common::UString &getLabel(uint32 id) const;
+
 
 private:
 	/** A GFF3 header. */
@@ -121,8 +136,11 @@ private:
 	typedef Common::PtrVector<GFF3Struct> StructArray;
 	typedef std::vector<GFF3List> ListArray;
 
+	typedef boost::unordered_map<Common::UString, uint32, Common::hashUStringCaseSensitive> LabelMap;
+
 
-	Common::ScopedPtr<Common::SeekableReadStream> _stream;
+	/** The complete GFF3, in memory. Only seeked while loading. */
+	Common::ScopedPtr<Common::MemoryReadStream> _stream;
 
 	Header _header; ///< The GFF3's header.
 
@@ -134,6 +152,9 @@ private:
 	StructArray _structs; ///< Our structs.
 	ListArray   _lists;   ///< Our lists.
 
+	std::vector<Common::UString> _labels; ///< All distinct field labels, indexed by their ID.
+	LabelMap _labelIDs;                   ///< The IDs of all field labels.
+
 	/** To convert list offsets found in GFF3 to real indices. */
 	std::vector<uint32> _listOffsetToIndex;
 
@@ -141,15 +162,20 @@ private:
 	// .--- Loading helpers
 	void load(uint32 id);
 	void loadHeader(uint32 id);
+	void loadLabels(std::vector<uint32> &labelIDs);
 	void loadStructs();
 	void loadLists();
+
+	void readSection(std::vector<byte> &data, uint32 offset, uint32 count, uint32 size);
 	// '---
 
 	// .--- Helper methods called by GFF3Struct
-	/** Return the GFF3 stream. */
-	Common::SeekableReadStream &getStream(uint32 offset) const;
-	/** Return the GFF3 stream seeked to the start of the field data. */
-	Common::SeekableReadStream &getFieldData() const;
+	/** A private view into the GFF3's field data, with its own read position.
+	 *
+	 *  Reading field data never touches the shared stream, so any number of
+	 *  threads can read fields of the same GFF3 concurrently.
+	 */
+	class FieldData;
 
 	/** Return a struct within the GFF3. */
 	const GFF3Struct &getStruct(uint32 i) const;
@@ -203,8 +229,8 @@ public:
 	/** Does this specific field exist? */
 	bool hasField(const Common::UString &field) const;
 
-	/** Return a list of all field names in this struct. */
-	const std::vector<Common::UString> &getFieldNames() const;
+	/** Return a list of all field names in this struct, in the order they're stored in the GFF3. */
+	std::vector<Common::UString> getFieldNames() const;
 
 	/** Return the type of this field, or kFieldTypeNone if such a field doesn't exist. */
 	FieldType getFieldType(const Common::UString &field) const;
@@ -241,51 +267,81 @@ public:
 	const GFF3List   &getList  (const Common::UString &field) const;
 	// '---
 
+	/** Return the ID of this field label within the GFF3 this struct belongs to.
+	 *
+	 *  See GFF3File::getLabelID().
+	 */
+	uint32 getLabelID(const Common::UString &label) const;
+
+	// .--- Read field values by label ID
+	bool hasField(uint32 field) const;
+
+	FieldType getFieldType(uint32 field) const;
+
+	char   getChar(uint32 field, char   def = '\0' ) const;
+	uint64 getUint(uint32 field, uint64 def = 0    ) const;
+	 int64 getSint(uint32 field,  int64 def = 0    ) const;
+	bool   getBool(uint32 field, bool   def = false) const;
+
+	double getDouble(uint32 field, double def = 0.0) const;
+
+	Common::UString getString(uint32 field, const Common::UString &def = "") const;
+
+	bool getLocString(uint32 field, LocString &str) const;
+
+	void getVector     (uint32 field, float &x, float &y, float &z) const;
+	void getOrientation(uint32 field, float &a, float &b, float &c, float &d) const;
+
+	void getVector     (uint32 field, double &x, double &y, double &z) const;
+	void getOrientation(uint32 field, double &a, double &b, double &c, double &d) const;
+
+	Common::SeekableReadStream *getData(uint32 field) const;
+
+	const GFF3Struct &getStruct(uint32 field) const;
+	const GFF3List   &getList  (uint32 field) const;
+	// '---
+
 private:
 	/** A field in the GFF3 struct. */
 	struct Field {
-		FieldType type;     ///< Type of the field.
-		uint32    data;     ///< Data of the field.
-		bool      extended; ///< Does this field need extended data?
+		uint32    label; ///< ID of the field's label.
+		FieldType type;  ///< Type of the field.
+		uint32    data;  ///< Data of the field.
+		uint32    order; ///< Position of the field within the struct in the GFF3.
 
-		Field();
-		Field(FieldType t, uint32 d);
+		Field(uint32 l, FieldType t, uint32 d, uint32 o);
+
+		/** Does this field need extended data? */
+		bool isExtended() const;
 	};
 
-	typedef std::map<Common::UString, Field> FieldMap;
+	/** The fields of a struct, sorted by their label ID. */
+	typedef std::vector<Field> FieldArray;
 
 
 	const GFF3File *_parent; ///< The parent GFF3.
 
-	uint32 _id;         ///< The struct's ID.
-	uint32 _fieldIndex; ///< Field / Field indices index.
-	uint32 _fieldCount; ///< Field count.
-
-	FieldMap _fields; ///< The fields, indexed by their label.
+	uint32 _id; ///< The struct's ID.
 
-	/** The names of all fields in this struct. */
-	std::vector<Common::UString> _fieldNames;
+	FieldArray _fields; ///< The fields, sorted by their label ID.
 
 
 	// .--- Loader
-	GFF3Struct(const GFF3File &parent, uint32 offset);
+	GFF3Struct(const GFF3File &parent, uint32 id);
 	~GFF3Struct();
 
-	void load(uint32 offset);
-
-	void readField  (Common::SeekableReadStream &data, uint32 index);
-	void readFields (Common::SeekableReadStream &data, uint32 index, uint32 count);
-	void readIndices(Common::SeekableReadStream &data,
-	                 std::vector<uint32> &indices, uint32 count) const;
+	void load(uint32 fieldIndex, uint32 fieldCount, const std::vector<byte> &fields,
+	          const std::vector<byte> &fieldIndices, const std::vector<uint32> &labelIDs);
 
-	Common::UString readLabel(Common::SeekableReadStream &data, uint32 index) const;
+	void readField(const std::vector<byte> &fields, uint32 index,
+	               const std::vector<uint32> &labelIDs, uint32 order);
 	// '---
 
 	// .--- Field and field data accessors
-	/** Returns the field with this tag. */
+	/** Returns the field with this label. */
 	const Field *getField(const Common::UString &name) const;
-	/** Returns the extended field data for this field. */
-	Common::SeekableReadStream &getData(const Field &field) const;
+	/** Returns the field with this label ID. */
+	const Field *getField(uint32 label) const;
 	// '---
 
 	friend class GFF3File;
@@ -32,6 +32,7 @@
 
 #include "src/common/error.h"
 #include "src/common/readstream.h"
+#include "src/common/memreadstream.h"
 #include "src/common/encoding.h"
 #include "src/common/strutil.h"
 
@@ -76,10 +77,23 @@ bool GFF4File::Header::isBigEndian() const {
 }
 
 
+class GFF4File::DataStream : public Common::MemoryReadStreamEndian {
+public:
+	/** Create a view into the GFF4's data, seeked to this offset. */
+	DataStream(const GFF4File &gff4, uint32 offset = 0) :
+		Common::MemoryReadStreamEndian(gff4._stream->getData(), gff4._stream->size(), gff4.isBigEndian()) {
+
+		seek(offset);
+	}
+};
+
+
 GFF4File::GFF4File(Common::SeekableReadStream *gff4, uint32 type) :
-	_origStream(gff4), _topLevelStruct(0) {
+	_topLevelStruct(0) {
 
-	assert(_origStream);
+	assert(gff4);
+
+	_stream.reset(Common::toMemoryStream(gff4));
 
 	load(type);
 }
@@ -87,10 +101,12 @@ GFF4File::GFF4File(Common::SeekableReadStream *gff4, uint32 type) :
 GFF4File::GFF4File(const Common::UString &gff4, FileType fileType, uint32 type) :
 	_topLevelStruct(0) {
 
-	_origStream.reset(ResMan.getResource(gff4, fileType));
-	if (!_origStream)
+	Common::SeekableReadStream *stream = ResMan.getResource(gff4, fileType);
+	if (!stream)
 		throw Common::Exception("No such GFF4 \"%s\"", TypeMan.setFileType(gff4, fileType).c_str());
 
+	_stream.reset(Common::toMemoryStream(stream));
+
 	load(type);
 }
 
@@ -99,7 +115,6 @@ GFF4File::~GFF4File() {
 }
 
 void GFF4File::clear() {
-	_origStream.reset();
 	_stream.reset();
 
 	for (StructMap::iterator s = _structs.begin(); s != _structs.end(); ++s)
@@ -156,7 +171,7 @@ void GFF4File::load(uint32 type) {
 }
 
 void GFF4File::loadHeader(uint32 type) {
-	readHeader(*_origStream);
+	readHeader(*_stream);
 
 	if (_id != kGFFID)
 		throw Common::Exception("Not a GFF4 file");
@@ -164,12 +179,7 @@ void GFF4File::loadHeader(uint32 type) {
 	if ((_version != kVersion40) && (_version != kVersion41))
 		throw Common::Exception("Unsupported GFF4 file version %s", Common::debugTag(_version).c_str());
 
-	_header.read(*_origStream, _version);
-
-	const size_t pos = _origStream->pos();
-	_stream.reset(new Common::SeekableSubReadStreamEndian(_origStream.get(), 0, _origStream->size(),
-	                                                      _header.isBigEndian(), false));
-	_stream->seek(pos);
+	_header.read(*_stream, _version);
 
 	if ((type != 0xFFFFFFFF) && (_header.type != type))
 		throw Common::Exception("GFF4 has invalid type (want %s, got %s)",
@@ -194,21 +204,23 @@ void GFF4File::loadStructs() {
 	static const uint32 kStructTemplateSize = 16;
 	const uint32 structTemplateStart = _stream->pos();
 
+	DataStream data(*this);
+
 	_structTemplates.resize(_header.structCount);
 	for (uint32 i = 0; i < _header.structCount; i++) {
-		_stream->seek(structTemplateStart + i * kStructTemplateSize);
+		data.seek(structTemplateStart + i * kStructTemplateSize);
 
 		StructTemplate &strct = _structTemplates[i];
 
 		// Read struct properties
 
 		strct.index = i;
-		strct.label = _stream->readUint32BE();
+		strct.label = data.readUint32BE();
 
-		const uint32 fieldCount  = _stream->readUint32();
-		const uint32 fieldOffset = _stream->readUint32();
+		const uint32 fieldCount  = data.readUint32();
+		const uint32 fieldOffset = data.readUint32();
 
-		strct.size = _stream->readUint32();
+		strct.size = data.readUint32();
 
 		// Check if we need to read fields
 		if (fieldOffset == 0xFFFFFFFF) {
@@ -218,7 +230,7 @@ void GFF4File::loadStructs() {
 			continue;
 		}
 
-		_stream->seek(fieldOffset);
+		data.seek(fieldOffset);
 
 		// Read the field declarations
 
@@ -226,13 +238,13 @@ void GFF4File::loadStructs() {
 		for (uint32 j = 0; j < fieldCount; j++) {
 			StructTemplate::Field &field = strct.fields[j];
 
-			field.label  = _stream->readUint32();
+			field.label  = data.readUint32();
 
-			const uint32 typeAndFlags = _stream->readUint32();
+			const uint32 typeAndFlags = data.readUint32();
 			field.type  = (typeAndFlags & 0x0000FFFF);
 			field.flags = (typeAndFlags & 0xFFFF0000) >> 16;
 
-			field.offset = _stream->readUint32();
+			field.offset = data.readUint32();
 		}
 	}
 
@@ -254,9 +266,9 @@ void GFF4File::loadStrings() {
 
 	_sharedStrings.resize(_header.stringCount);
 
-	_stream->seek(_header.stringOffset);
+	DataStream data(*this, _header.stringOffset);
 	for (uint32 i = 0; i < _header.stringCount; i++)
-		_sharedStrings[i] = Common::readString(*_stream, Common::kEncodingUTF8);
+		_sharedStrings[i] = Common::readString(data, Common::kEncodingUTF8);
 }
 
 // --- Helpers for GFF4Struct ---
@@ -291,12 +303,6 @@ GFF4Struct *GFF4File::findStruct(uint64 id) {
 	return s->second;
 }
 
-Common::SeekableSubReadStreamEndian &GFF4File::getStream(uint32 offset) const {
-	_stream->seek(offset);
-
-	return *_stream;
-}
-
 uint32 GFF4File::getDataOffset() const {
 	return _header.dataOffset;
 }
@@ -465,7 +471,7 @@ void GFF4Struct::loadStructs(GFF4File &parent, Field &field) {
 
 	const GFF4File::StructTemplate &tmplt = parent.getStructTemplate(field.structIndex);
 
-	Common::SeekableSubReadStreamEndian &data = parent.getStream(field.offset);
+	GFF4File::DataStream data(parent, field.offset);
 
 	const uint32 structCount = getListCount(data, field);
 	const uint32 structSize  = field.isReference ? 4 : tmplt.size;
@@ -512,7 +518,7 @@ void GFF4Struct::load(GFF4File &parent, const Field &genericParent) {
 
 	static const uint32 kGenericSize = 8;
 
-	Common::SeekableSubReadStreamEndian &data = parent.getStream(genericParent.offset);
+	GFF4File::DataStream data(parent, genericParent.offset);
 
 	const uint32 genericCount = genericParent.isList ? data.readUint32() : 1;
 	const uint32 genericStart = data.pos();
@@ -611,7 +617,7 @@ uint32 GFF4Struct::getDataOffset(bool isReference, uint32 offset) const {
 	if (!isReference || (offset == 0xFFFFFFFF))
 		return offset;
 
-	Common::SeekableSubReadStreamEndian &data = _parent->getStream(offset);
+	GFF4File::DataStream data(*_parent, offset);
 
 	offset = data.readUint32();
 	if (offset == 0xFFFFFFFF)
@@ -627,19 +633,20 @@ uint32 GFF4Struct::getDataOffset(const Field &field) const {
 	return getDataOffset(field.isReference, field.offset);
 }
 
-Common::SeekableSubReadStreamEndian *GFF4Struct::getData(const Field &field) const {
+bool GFF4Struct::getData(const Field &field, Common::MemoryReadStreamEndian &data) const {
 	const uint32 offset = getDataOffset(field);
 	if (offset == 0xFFFFFFFF)
-		return 0;
+		return false;
 
-	return &_parent->getStream(offset);
+	data.seek(offset);
+	return true;
 }
 
-Common::SeekableSubReadStreamEndian *GFF4Struct::getField(uint32 fieldID, const Field *&field) const {
+bool GFF4Struct::getField(uint32 fieldID, const Field *&field, Common::MemoryReadStreamEndian &data) const {
 	if (!(field = getField(fieldID)))
-		return 0;
+		return false;
 
-	return getData(*field);
+	return getData(*field, data);
 }
 
 uint32 GFF4Struct::getVectorMatrixLength(const Field &field, uint32 minLength, uint32 maxLength) const {
@@ -663,7 +670,7 @@ uint32 GFF4Struct::getVectorMatrixLength(const Field &field, uint32 minLength, u
 	return length;
 }
 
-uint32 GFF4Struct::getListCount(Common::SeekableSubReadStreamEndian &data, const Field &field) const {
+uint32 GFF4Struct::getListCount(Common::MemoryReadStreamEndian &data, const Field &field) const {
 	if (!field.isList)
 		return 1;
 
@@ -727,7 +734,7 @@ uint32 GFF4Struct::getFieldSize(FieldType type) const {
 
 // --- Low-level value readers ---
 
-uint64 GFF4Struct::getUint(Common::SeekableSubReadStreamEndian &data, FieldType type) const {
+uint64 GFF4Struct::getUint(Common::MemoryReadStreamEndian &data, FieldType type) const {
 	switch (type) {
 		case kFieldTypeUint8:
 			return (uint64) data.readByte();
@@ -760,7 +767,7 @@ uint64 GFF4Struct::getUint(Common::SeekableSubReadStreamEndian &data, FieldType
 	throw Common::Exception("GFF4: Field is not an int type");
 }
 
-int64 GFF4Struct::getSint(Common::SeekableSubReadStreamEndian &data, FieldType type) const {
+int64 GFF4Struct::getSint(Common::MemoryReadStreamEndian &data, FieldType type) const {
 	switch (type) {
 		case kFieldTypeUint8:
 			return (int64) ((uint64) data.readByte());
@@ -793,7 +800,7 @@ int64 GFF4Struct::getSint(Common::SeekableSubReadStreamEndian &data, FieldType t
 	throw Common::Exception("GFF4: Field is not an int type");
 }
 
-double GFF4Struct::getDouble(Common::SeekableSubReadStreamEndian &data, FieldType type) const {
+double GFF4Struct::getDouble(Common::MemoryReadStreamEndian &data, FieldType type) const {
 	switch (type) {
 		case kFieldTypeFloat32:
 			return (double) data.readIEEEFloat();
@@ -811,7 +818,7 @@ double GFF4Struct::getDouble(Common::SeekableSubReadStreamEndian &data, FieldTyp
 	throw Common::Exception("GFF4: Field is not a float type");
 }
 
-float GFF4Struct::getFloat(Common::SeekableSubReadStreamEndian &data, FieldType type) const {
+float GFF4Struct::getFloat(Common::MemoryReadStreamEndian &data, FieldType type) const {
 	switch (type) {
 		case kFieldTypeFloat32:
 			return (float) data.readIEEEFloat();
@@ -829,7 +836,7 @@ float GFF4Struct::getFloat(Common::SeekableSubReadStreamEndian &data, FieldType
 	throw Common::Exception("GFF4: Field is not a float type");
 }
 
-Common::UString GFF4Struct::getString(Common::SeekableSubReadStreamEndian &data, Common::Encoding encoding) const {
+Common::UString GFF4Struct::getString(Common::MemoryReadStreamEndian &data, Common::Encoding encoding) const {
 	/* When the string is encoded in UTF-8, then length field specifies the length in bytes.
 	 * Otherwise, it's the length in characters. */
 	const size_t lengthMult = encoding == Common::kEncodingUTF8 ? 1 : Common::getBytesPerCodepoint(encoding);
@@ -847,7 +854,7 @@ Common::UString GFF4Struct::getString(Common::SeekableSubReadStreamEndian &data,
 	return Common::UString::format("GFF4: Invalid string encoding (0x%08X)", (uint) offset);
 }
 
-Common::UString GFF4Struct::getString(Common::SeekableSubReadStreamEndian &data, Common::Encoding encoding,
+Common::UString GFF4Struct::getString(Common::MemoryReadStreamEndian &data, Common::Encoding encoding,
                                       uint32 offset) const {
 
 	const uint32 pos = data.seek(offset);
@@ -859,7 +866,7 @@ Common::UString GFF4Struct::getString(Common::SeekableSubReadStreamEndian &data,
 	return str;
 }
 
-Common::UString GFF4Struct::getString(Common::SeekableSubReadStreamEndian &data, const Field &field,
+Common::UString GFF4Struct::getString(Common::MemoryReadStreamEndian &data, const Field &field,
                                       Common::Encoding encoding) const {
 
 	if (field.type == kFieldTypeString) {
@@ -888,26 +895,26 @@ Common::UString GFF4Struct::getString(Common::SeekableSubReadStreamEndian &data,
 
 uint64 GFF4Struct::getUint(uint32 field, uint64 def) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return def;
 
 	if (f->isList)
 		throw Common::Exception("GFF4: Tried reading list as singular value");
 
-	return getUint(*data, f->type);
+	return getUint(data, f->type);
 }
 
 int64 GFF4Struct::getSint(uint32 field, int64 def) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return def;
 
 	if (f->isList)
 		throw Common::Exception("GFF4: Tried reading list as singular value");
 
-	return getSint(*data, f->type);
+	return getSint(data, f->type);
 }
 
 bool GFF4Struct::getBool(uint32 field, bool def) const {
@@ -916,40 +923,40 @@ bool GFF4Struct::getBool(uint32 field, bool def) const {
 
 double GFF4Struct::getDouble(uint32 field, double def) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return def;
 
 	if (f->isList)
 		throw Common::Exception("GFF4: Tried reading list as singular value");
 
-	return getDouble(*data, f->type);
+	return getDouble(data, f->type);
 }
 
 float GFF4Struct::getFloat(uint32 field, float def) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return def;
 
 	if (f->isList)
 		throw Common::Exception("GFF4: Tried reading list as singular value");
 
-	return getFloat(*data, f->type);
+	return getFloat(data, f->type);
 }
 
 Common::UString GFF4Struct::getString(uint32 field, Common::Encoding encoding,
                                       const Common::UString &def) const {
 
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return def;
 
 	if (f->isList)
 		throw Common::Exception("GFF4: Tried reading list as singular value");
 
-	return getString(*data, *f, encoding);
+	return getString(data, *f, encoding);
 }
 
 Common::UString GFF4Struct::getString(uint32 field, const Common::UString &def) const {
@@ -960,8 +967,8 @@ bool GFF4Struct::getTalkString(uint32 field, Common::Encoding encoding,
                                uint32 &strRef, Common::UString &str) const {
 
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	if (f->type != kFieldTypeTlkString)
@@ -969,16 +976,16 @@ bool GFF4Struct::getTalkString(uint32 field, Common::Encoding encoding,
 	if (f->isList)
 		throw Common::Exception("GFF4: Tried reading list as singular value");
 
-	strRef = getUint(*data, kFieldTypeUint32);
+	strRef = getUint(data, kFieldTypeUint32);
 
-	const uint32 offset = getUint(*data, kFieldTypeUint32);
+	const uint32 offset = getUint(data, kFieldTypeUint32);
 
 	str.clear();
 	if (offset != 0xFFFFFFFF) {
 		if (_parent->hasSharedStrings())
 			str = _parent->getSharedString(offset);
 		else if (offset != 0)
-			str = getString(*data, encoding, _parent->getDataOffset() + offset);
+			str = getString(data, encoding, _parent->getDataOffset() + offset);
 	}
 
 	return true;
@@ -990,8 +997,8 @@ bool GFF4Struct::getTalkString(uint32 field, uint32 &strRef, Common::UString &st
 
 bool GFF4Struct::getVector3(uint32 field, double &v1, double &v2, double &v3) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	if (f->isList)
@@ -999,17 +1006,17 @@ bool GFF4Struct::getVector3(uint32 field, double &v1, double &v2, double &v3) co
 
 	getVectorMatrixLength(*f, 3, 3);
 
-	v1 = getDouble(*data, kFieldTypeFloat32);
-	v2 = getDouble(*data, kFieldTypeFloat32);
-	v3 = getDouble(*data, kFieldTypeFloat32);
+	v1 = getDouble(data, kFieldTypeFloat32);
+	v2 = getDouble(data, kFieldTypeFloat32);
+	v3 = getDouble(data, kFieldTypeFloat32);
 
 	return true;
 }
 
 bool GFF4Struct::getVector3(uint32 field, float &v1, float &v2, float &v3) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	if (f->isList)
@@ -1017,17 +1024,17 @@ bool GFF4Struct::getVector3(uint32 field, float &v1, float &v2, float &v3) const
 
 	getVectorMatrixLength(*f, 3, 3);
 
-	v1 = getFloat(*data, kFieldTypeFloat32);
-	v2 = getFloat(*data, kFieldTypeFloat32);
-	v3 = getFloat(*data, kFieldTypeFloat32);
+	v1 = getFloat(data, kFieldTypeFloat32);
+	v2 = getFloat(data, kFieldTypeFloat32);
+	v3 = getFloat(data, kFieldTypeFloat32);
 
 	return true;
 }
 
 bool GFF4Struct::getVector4(uint32 field, double &v1, double &v2, double &v3, double &v4) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	if (f->isList)
@@ -1035,18 +1042,18 @@ bool GFF4Struct::getVector4(uint32 field, double &v1, double &v2, double &v3, do
 
 	getVectorMatrixLength(*f, 4, 4);
 
-	v1 = getDouble(*data, kFieldTypeFloat32);
-	v2 = getDouble(*data, kFieldTypeFloat32);
-	v3 = getDouble(*data, kFieldTypeFloat32);
-	v4 = getDouble(*data, kFieldTypeFloat32);
+	v1 = getDouble(data, kFieldTypeFloat32);
+	v2 = getDouble(data, kFieldTypeFloat32);
+	v3 = getDouble(data, kFieldTypeFloat32);
+	v4 = getDouble(data, kFieldTypeFloat32);
 
 	return true;
 }
 
 bool GFF4Struct::getVector4(uint32 field, float &v1, float &v2, float &v3, float &v4) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	if (f->isList)
@@ -1054,18 +1061,18 @@ bool GFF4Struct::getVector4(uint32 field, float &v1, float &v2, float &v3, float
 
 	getVectorMatrixLength(*f, 4, 4);
 
-	v1 = getFloat(*data, kFieldTypeFloat32);
-	v2 = getFloat(*data, kFieldTypeFloat32);
-	v3 = getFloat(*data, kFieldTypeFloat32);
-	v4 = getFloat(*data, kFieldTypeFloat32);
+	v1 = getFloat(data, kFieldTypeFloat32);
+	v2 = getFloat(data, kFieldTypeFloat32);
+	v3 = getFloat(data, kFieldTypeFloat32);
+	v4 = getFloat(data, kFieldTypeFloat32);
 
 	return true;
 }
 
 bool GFF4Struct::getMatrix4x4(uint32 field, double (&m)[16]) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	if (f->isList)
@@ -1073,15 +1080,15 @@ bool GFF4Struct::getMatrix4x4(uint32 field, double (&m)[16]) const {
 
 	const uint32 length = getVectorMatrixLength(*f, 16, 16);
 	for (uint32 i = 0; i < length; i++)
-		m[i] = getDouble(*data, kFieldTypeFloat32);
+		m[i] = getDouble(data, kFieldTypeFloat32);
 
 	return true;
 }
 
 bool GFF4Struct::getMatrix4x4(uint32 field, float (&m)[16]) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	if (f->isList)
@@ -1089,7 +1096,7 @@ bool GFF4Struct::getMatrix4x4(uint32 field, float (&m)[16]) const {
 
 	const uint32 length = getVectorMatrixLength(*f, 16, 16);
 	for (uint32 i = 0; i < length; i++)
-		m[i] = getFloat(*data, kFieldTypeFloat32);
+		m[i] = getFloat(data, kFieldTypeFloat32);
 
 	return true;
 }
@@ -1105,8 +1112,8 @@ bool GFF4Struct::getMatrix4x4(uint32 field, glm::mat4 &m) const {
 
 bool GFF4Struct::getVectorMatrix(uint32 field, std::vector<double> &vectorMatrix) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	if (f->isList)
@@ -1116,15 +1123,15 @@ bool GFF4Struct::getVectorMatrix(uint32 field, std::vector<double> &vectorMatrix
 
 	vectorMatrix.resize(length);
 	for (uint32 i = 0; i < length; i++)
-		vectorMatrix[i] = getDouble(*data, kFieldTypeFloat32);
+		vectorMatrix[i] = getDouble(data, kFieldTypeFloat32);
 
 	return true;
 }
 
 bool GFF4Struct::getVectorMatrix(uint32 field, std::vector<float> &vectorMatrix) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	if (f->isList)
@@ -1134,7 +1141,7 @@ bool GFF4Struct::getVectorMatrix(uint32 field, std::vector<float> &vectorMatrix)
 
 	vectorMatrix.resize(length);
 	for (uint32 i = 0; i < length; i++)
-		vectorMatrix[i] = getFloat(*data, kFieldTypeFloat32);
+		vectorMatrix[i] = getFloat(data, kFieldTypeFloat32);
 
 	return true;
 }
@@ -1143,75 +1150,75 @@ bool GFF4Struct::getVectorMatrix(uint32 field, std::vector<float> &vectorMatrix)
 
 bool GFF4Struct::getUint(uint32 field, std::vector<uint64> &list) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
-	const uint32 count = getListCount(*data, *f);
+	const uint32 count = getListCount(data, *f);
 
 	list.resize(count);
 	for (uint32 i = 0; i < count; i++)
-		list[i] = getUint(*data, f->type);
+		list[i] = getUint(data, f->type);
 
 	return true;
 }
 
 bool GFF4Struct::getSint(uint32 field, std::vector<int64> &list) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
-	const uint32 count = getListCount(*data, *f);
+	const uint32 count = getListCount(data, *f);
 
 	list.resize(count);
 	for (uint32 i = 0; i < count; i++)
-		list[i] = getSint(*data, f->type);
+		list[i] = getSint(data, f->type);
 
 	return true;
 }
 
 bool GFF4Struct::getBool(uint32 field, std::vector<bool> &list) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
-	const uint32 count = getListCount(*data, *f);
+	const uint32 count = getListCount(data, *f);
 
 	list.resize(count);
 	for (uint32 i = 0; i < count; i++)
-		list[i] = getUint(*data, f->type) != 0;
+		list[i] = getUint(data, f->type) != 0;
 
 	return true;
 }
 
 bool GFF4Struct::getDouble(uint32 field, std::vector<double> &list) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
-	const uint32 count = getListCount(*data, *f);
+	const uint32 count = getListCount(data, *f);
 
 	list.resize(count);
 	for (uint32 i = 0; i < count; i++)
-		list[i] = getDouble(*data, f->type);
+		list[i] = getDouble(data, f->type);
 
 	return true;
 }
 
 bool GFF4Struct::getFloat(uint32 field, std::vector<float> &list) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
-	const uint32 count = getListCount(*data, *f);
+	const uint32 count = getListCount(data, *f);
 
 	list.resize(count);
 	for (uint32 i = 0; i < count; i++)
-		list[i] = getFloat(*data, f->type);
+		list[i] = getFloat(data, f->type);
 
 	return true;
 }
@@ -1220,8 +1227,8 @@ bool GFF4Struct::getString(uint32 field, Common::Encoding encoding,
                            std::vector<Common::UString> &list) const {
 
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data) {
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data)) {
 		if (f && !f->isList) {
 			list.push_back("");
 			return true;
@@ -1230,11 +1237,11 @@ bool GFF4Struct::getString(uint32 field, Common::Encoding encoding,
 		return false;
 	}
 
-	const uint32 count = getListCount(*data, *f);
+	const uint32 count = getListCount(data, *f);
 
 	list.resize(count);
 	for (uint32 i = 0; i < count; i++)
-		list[i] = getString(*data, *f, encoding);
+		list[i] = getString(data, *f, encoding);
 
 	return true;
 }
@@ -1248,14 +1255,14 @@ bool GFF4Struct::getTalkString(uint32 field, Common::Encoding encoding,
 
 
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	if (f->type != kFieldTypeTlkString)
 		throw Common::Exception("GFF4: Field is not of TalkString type");
 
-	const uint32 count = getListCount(*data, *f);
+	const uint32 count = getListCount(data, *f);
 
 	strRefs.resize(count);
 	strs.resize(count);
@@ -1264,15 +1271,15 @@ bool GFF4Struct::getTalkString(uint32 field, Common::Encoding encoding,
 	offsets.resize(count);
 
 	for (uint32 i = 0; i < count; i++) {
-		strRefs[i] = getUint(*data, kFieldTypeUint32);
+		strRefs[i] = getUint(data, kFieldTypeUint32);
 
-		const uint32 offset = getUint(*data, kFieldTypeUint32);
+		const uint32 offset = getUint(data, kFieldTypeUint32);
 
 		if (offset != 0xFFFFFFFF) {
 			if (_parent->hasSharedStrings())
 				strs[i] = _parent->getSharedString(offset);
 			else if (offset != 0)
-				strs[i] = getString(*data, encoding, _parent->getDataOffset() + offset);
+				strs[i] = getString(data, encoding, _parent->getDataOffset() + offset);
 		}
 	}
 
@@ -1287,19 +1294,19 @@ bool GFF4Struct::getTalkString(uint32 field,
 
 bool GFF4Struct::getVectorMatrix(uint32 field, std::vector< std::vector<double> > &list) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	const uint32 length = getVectorMatrixLength(*f, 0, 16);
-	const uint32 count  = getListCount(*data, *f);
+	const uint32 count  = getListCount(data, *f);
 
 	list.resize(count);
 	for (uint32 i = 0; i < count; i++) {
 
 		list[i].resize(length);
 		for (uint32 j = 0; j < length; j++)
-			list[i][j] = getDouble(*data, kFieldTypeFloat32);
+			list[i][j] = getDouble(data, kFieldTypeFloat32);
 	}
 
 	return true;
@@ -1307,19 +1314,19 @@ bool GFF4Struct::getVectorMatrix(uint32 field, std::vector< std::vector<double>
 
 bool GFF4Struct::getVectorMatrix(uint32 field, std::vector< std::vector<float> > &list) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	const uint32 length = getVectorMatrixLength(*f, 0, 16);
-	const uint32 count  = getListCount(*data, *f);
+	const uint32 count  = getListCount(data, *f);
 
 	list.resize(count);
 	for (uint32 i = 0; i < count; i++) {
 
 		list[i].resize(length);
 		for (uint32 j = 0; j < length; j++)
-			list[i][j] = getFloat(*data, kFieldTypeFloat32);
+			list[i][j] = getFloat(data, kFieldTypeFloat32);
 	}
 
 	return true;
@@ -1327,19 +1334,19 @@ bool GFF4Struct::getVectorMatrix(uint32 field, std::vector< std::vector<float> >
 
 bool GFF4Struct::getMatrix4x4(uint32 field, std::vector<glm::mat4> &list) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return false;
 
 	const uint32 length = getVectorMatrixLength(*f, 0, 16);
-	const uint32 count  = getListCount(*data, *f);
+	const uint32 count  = getListCount(data, *f);
 
 	list.resize(count);
 	for (uint32 i = 0; i < count; i++) {
 		float m[16];
 
 		for (uint32 j = 0; j < length; j++)
-			m[j] = getFloat(*data, kFieldTypeFloat32);
+			m[j] = getFloat(data, kFieldTypeFloat32);
 
 		list[i] = glm::make_mat4(m);
 	}
@@ -1398,25 +1405,24 @@ const GFF4List &GFF4Struct::getList(uint32 field) const {
 
 Common::SeekableReadStream *GFF4Struct::getData(uint32 field) const {
 	const Field *f;
-	Common::SeekableSubReadStreamEndian *data = getField(field, f);
-	if (!data)
+	GFF4File::DataStream data(*_parent);
+	if (!getField(field, f, data))
 		return 0;
 
-	const uint32 count = getListCount(*data, *f);
+	const uint32 count = getListCount(data, *f);
 	const uint32 size  = getFieldSize(f->type);
 
 	if ((size == 0) || (count == 0))
 		return 0;
 
 	const size_t dataSize  = count * size;
-	const size_t dataBegin = data->pos();
-	const size_t dataEnd   = data->pos() + dataSize;
+	const size_t dataBegin = data.pos();
 
-	if ((dataBegin >= data->size()) || ((data->size() - dataBegin) < dataSize))
+	if ((dataBegin >= data.size()) || ((data.size() - dataBegin) < dataSize))
 		throw Common::Exception("Invalid data offset (%u, %u, %u)",
-		                        (uint) dataBegin, (uint) dataSize, (uint) data->size());
+		                        (uint) dataBegin, (uint) dataSize, (uint) data.size());
 
-	return new Common::SeekableSubReadStream(data, dataBegin, dataEnd);
+	return new Common::MemoryReadStream(data.getData() + dataBegin, dataSize);
 }
 
 } // End of namespace Aurora
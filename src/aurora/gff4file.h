@@ -43,7 +43,8 @@
 
 namespace Common {
 	class SeekableReadStream;
-	class SeekableSubReadStreamEndian;
+	class MemoryReadStream;
+	class MemoryReadStreamEndian;
 }
 
 namespace Aurora {
@@ -159,8 +160,8 @@ private:
 
 
 
-	Common::ScopedPtr<Common::SeekableReadStream> _origStream;
-	Common::ScopedPtr<Common::SeekableSubReadStreamEndian> _stream;
+	/** The complete GFF4, in memory. Only seeked while loading the header. */
+	Common::ScopedPtr<Common::MemoryReadStream> _stream;
 
 	/** This GFF4's header. */
 	Header          _header;
@@ -190,7 +191,13 @@ private:
 	void unregisterStruct(uint64 id);
 	GFF4Struct *findStruct(uint64 id);
 
-	Common::SeekableSubReadStreamEndian &getStream(uint32 offset) const;
+	/** A private, endian-aware view into the GFF4's data, with its own read position.
+	 *
+	 *  Reading field data never touches the shared stream, so any number of
+	 *  threads can read fields of the same GFF4 concurrently.
+	 */
+	class DataStream;
+
 	const StructTemplate &getStructTemplate(uint32 i) const;
 	uint32 getDataOffset() const;
 
@@ -407,24 +414,26 @@ private:
 	uint32 getDataOffset(bool isReference, uint32 offset) const;
 	uint32 getDataOffset(const Field &field) const;
 
-	Common::SeekableSubReadStreamEndian *getData(const Field &field) const;
-	Common::SeekableSubReadStreamEndian *getField(uint32 fieldID, const Field *&field) const;
+	/** Seek the stream to the field's data. Returns false if the field has no data. */
+	bool getData(const Field &field, Common::MemoryReadStreamEndian &data) const;
+	/** Find the field and seek the stream to its data. Returns false if there's no data. */
+	bool getField(uint32 fieldID, const Field *&field, Common::MemoryReadStreamEndian &data) const;
 	// '---
 
 	// .--- Field reader helpers
-	uint32 getListCount(Common::SeekableSubReadStreamEndian &data, const Field &field) const;
+	uint32 getListCount(Common::MemoryReadStreamEndian &data, const Field &field) const;
 	uint32 getFieldSize(FieldType type) const;
 
-	uint64 getUint(Common::SeekableSubReadStreamEndian &data, FieldType type) const;
-	 int64 getSint(Common::SeekableSubReadStreamEndian &data, FieldType type) const;
+	uint64 getUint(Common::MemoryReadStreamEndian &data, FieldType type) const;
+	 int64 getSint(Common::MemoryReadStreamEndian &data, FieldType type) const;
 
-	double getDouble(Common::SeekableSubReadStreamEndian &data, FieldType type) const;
-	float  getFloat (Common::SeekableSubReadStreamEndian &data, FieldType type) const;
+	double getDouble(Common::MemoryReadStreamEndian &data, FieldType type) const;
+	float  getFloat (Common::MemoryReadStreamEndian &data, FieldType type) const;
 
-	Common::UString getString(Common::SeekableSubReadStreamEndian &data, Common::Encoding encoding) const;
-	Common::UString getString(Common::SeekableSubReadStreamEndian &data, Common::Encoding encoding,
+	Common::UString getString(Common::MemoryReadStreamEndian &data, Common::Encoding encoding) const;
+	Common::UString getString(Common::MemoryReadStreamEndian &data, Common::Encoding encoding,
 	                          uint32 offset) const;
-	Common::UString getString(Common::SeekableSubReadStreamEndian &data, const Field &field,
+	Common::UString getString(Common::MemoryReadStreamEndian &data, const Field &field,
 	                          Common::Encoding encoding) const;
 
 	uint32 getVectorMatrixLength(const Field &field, uint32 minLength, uint32 maxLength) const;
@@ -330,6 +330,9 @@ Common::SeekableReadStream *NSBTXFile::getResource(uint32 index, bool UNUSED(try
 
 	Common::MemoryWriteStreamDynamic stream(true, getITEXSize(_textures[index]));
 
+	// The texture is read by seeking in the shared NSBTX stream
+	std::lock_guard<std::mutex> lock(_streamMutex);
+
 	ReadContext ctx(*_nsbtx, _textures[index], stream);
 	writeITEXHeader(ctx);
 
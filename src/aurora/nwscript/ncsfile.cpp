@@ -34,21 +34,15 @@
 #include "src/common/error.h"
 #include "src/common/maths.h"
 #include "src/common/ustring.h"
-#include "src/common/readstream.h"
-#include "src/common/encoding.h"
 #include "src/common/debug.h"
 
-#include "src/aurora/resman.h"
-
 #include "src/aurora/nwscript/ncsfile.h"
+#include "src/aurora/nwscript/ncsreg.h"
 #include "src/aurora/nwscript/object.h"
 #include "src/aurora/nwscript/functionman.h"
 
 using Common::kDebugScripts;
 
-static const uint32 kNCSTag    = MKTAG('N', 'C', 'S', ' ');
-static const uint32 kVersion10 = MKTAG('V', '1', '.', '0');
-
 static const uint32 kScriptObjectSelf        = 0x00000000;
 static const uint32 kScriptObjectInvalid     = 0x00000001;
 static const uint32 kScriptObjectInvalid2    = 0xFFFFFFFF;
@@ -146,7 +140,7 @@ void NCSStack::setRelBP(int32 pos, const Variable &obj) {
 	at(stackPos) = obj;
 }
 
-int32 NCSStack::getStackPtr() {
+int32 NCSStack::getStackPtr() const {
 	return (_stackPtr + 1) * -4;
 }
 
@@ -160,7 +154,7 @@ void NCSStack::setStackPtr(int32 pos) {
 		resize(_stackPtr + 1);
 }
 
-int32 NCSStack::getBasePtr() {
+int32 NCSStack::getBasePtr() const {
 	return (_basePtr + 1) * -4;
 }
 
@@ -274,18 +268,18 @@ void NCSFile::setupOpcodes() {
 
 #undef OPCODE
 
-NCSFile::NCSFile(Common::SeekableReadStream *ncs) : _script(ncs) {
-	assert(_script);
+NCSFile::Engine NCSFile::_defaultEngine = NCSFile::kEngineInterpreter;
+
+NCSFile::NCSFile(Common::SeekableReadStream *ncs) : _engine(_defaultEngine),
+	_program(new NCSProgram(ncs)) {
 
-	load();
+	init();
 }
 
-NCSFile::NCSFile(const Common::UString &ncs) : _name(ncs) {
-	_script.reset(ResMan.getResource(ncs, kFileTypeNCS));
-	if (!_script)
-		throw Common::Exception("No such NCS \"%s\"", ncs.c_str());
+NCSFile::NCSFile(const Common::UString &ncs) : _name(ncs), _engine(_defaultEngine),
+	_program(NCSReg.get(ncs)) {
 
-	load();
+	init();
 }
 
 NCSFile::~NCSFile() {
@@ -311,24 +305,40 @@ ScriptState NCSFile::getEmptyState() {
 	return state;
 }
 
-void NCSFile::load() {
-	readHeader(*_script);
+NCSFile::Engine NCSFile::getDefaultEngine() {
+	return _defaultEngine;
+}
+
+void NCSFile::setDefaultEngine(Engine engine) {
+	_defaultEngine = engine;
+}
+
+NCSFile::Engine NCSFile::getEngine() const {
+	return _engine;
+}
+
+void NCSFile::setEngine(Engine engine) {
+	_engine = engine;
+}
+
+std::vector<Variable> NCSFile::getStack() const {
+	std::vector<Variable> stack;
 
-	if (_id != kNCSTag)
-		throw Common::Exception("Try to load non-NCS file");
+	if (_engine == kEngineThreaded) {
+		_typedStack.getVariables(stack);
+		return stack;
+	}
 
-	if (_version != kVersion10)
-		throw Common::Exception("Unsupported NCS file version %08X", _version);
+	const size_t size = _stack.getStackPtr() / -4;
+	stack.assign(_stack.begin(), _stack.begin() + size);
 
-	byte lengthOpcode = _script->readByte();
-	if (lengthOpcode != 0x42)
-		throw Common::Exception("Script size opcode != 0x42 (0x%02X)", lengthOpcode);
+	return stack;
+}
 
-	uint32 length = _script->readUint32BE();
-	if (length > ((uint32) _script->size()))
-		throw Common::Exception("Script size %u > stream size %u", length, (uint)_script->size());
-	if (length < ((uint32) _script->size()))
-		warning("TODO: NCSFile::load(): Script size %u < stream size %u", length, (uint)_script->size());
+void NCSFile::init() {
+	_id      = _program->getID();
+	_version = _program->getVersion();
+	_utf16le = _program->isUTF16LE();
 
 	setupOpcodes();
 
@@ -337,6 +347,7 @@ void NCSFile::load() {
 
 void NCSFile::reset() {
 	_stack.reset();
+	_typedStack.reset();
 
 	while (!_returnOffsets.empty())
 		_returnOffsets.pop();
@@ -344,7 +355,23 @@ void NCSFile::reset() {
 	_storedState.setType(kTypeVoid);
 	_return.setType(kTypeVoid);
 
-	_script->seek(13); // 8 byte header + 5 byte program size dummy op
+	_pc    = _program->findInstruction(getEmptyState().offset);
+	_instr = 0;
+}
+
+/** Push the global and local variables of a script state onto a stack. */
+template<typename Stack>
+static void pushState(Stack &stack, const ScriptState &state) {
+	// Push global variables
+	std::vector<class Variable>::const_reverse_iterator var;
+	for (var = state.globals.rbegin(); var != state.globals.rend(); ++var)
+		stack.push(*var);
+
+	stack.setBasePtr(stack.getStackPtr());
+
+	// Push local variables
+	for (var = state.locals.rbegin(); var != state.locals.rend(); ++var)
+		stack.push(*var);
 }
 
 const Variable &NCSFile::run(Object *owner, Object *triggerer) {
@@ -365,18 +392,14 @@ const Variable &NCSFile::run(const ScriptState &state, const ObjectReference own
 
 	reset();
 
-	_script->seek(state.offset);
+	_pc = _program->findInstruction(state.offset);
+	if (_pc == NCSProgram::kInvalidTarget)
+		throw Common::Exception("NCSFile::run(): Invalid script offset %u", state.offset);
 
-	// Push global variables
-	std::vector<class Variable>::const_reverse_iterator var;
-	for (var = state.globals.rbegin(); var != state.globals.rend(); ++var)
-		_stack.push(*var);
-
-	_stack.setBasePtr(_stack.getStackPtr());
-
-	// Push local variables
-	for (var = state.locals.rbegin(); var != state.locals.rend(); ++var)
-		_stack.push(*var);
+	if (_engine == kEngineThreaded)
+		pushState(_typedStack, state);
+	else
+		pushState(_stack, state);
 
 	return execute(owner, triggerer);
 }
@@ -385,15 +408,23 @@ const Variable &NCSFile::execute(const ObjectReference owner, const ObjectRefere
 	_owner     = owner;
 	_triggerer = triggerer;
 
-	while (executeStep())
-		;
+	if (_engine == kEngineThreaded) {
+		executeThreaded();
+
+		if (!_typedStack.empty())
+			_return = _typedStack.top();
+
+	} else {
+		while (executeStep())
+			;
 
-	if (!_stack.empty())
-		_return = _stack.top();
+		if (!_stack.empty())
+			_return = _stack.top();
+	}
 
-	if (!_stack.empty() && (_stack.top().getType() == kTypeInt))
+	if (_return.getType() == kTypeInt)
 		debugC(kDebugScripts, 1, "=> Script\"%s\" returns: %d",
-		       _name.c_str(), _stack.top().getInt());
+		       _name.c_str(), _return.getInt());
 
 	_owner     = 0;
 	_triggerer = 0;
@@ -402,14 +433,14 @@ const Variable &NCSFile::execute(const ObjectReference owner, const ObjectRefere
 }
 
 bool NCSFile::executeStep() {
-	byte opcode, type;
-
-	try {
-		opcode = _script->readByte();
-		type   = _script->readByte();
-	} catch (...) {
+	if (_pc >= _program->size())
 		return false;
-	}
+
+	_instr = &(*_program)[_pc];
+	_pc    = _instr->next;
+
+	const byte opcode = _instr->opcode;
+	const byte type   = _instr->type;
 
 	if ((opcode >= _opcodeListSize) || (!_opcodes[opcode].proc))
 		throw Common::Exception("NCSFile::executeStep(): Illegal instruction 0x%02x", opcode);
@@ -420,18 +451,21 @@ bool NCSFile::executeStep() {
 
 	_stack.print();
 	debugC(kDebugScripts, 2, "[RETURN: %d]",
-	       _returnOffsets.empty() ? -1 : _returnOffsets.top());
+	       _returnOffsets.empty() ? -1 : (int) _returnOffsets.top());
 
 	return true;
 }
 
-void NCSFile::decompile() {
-	uint32 oldScriptPos = _script->pos();
-	_script->seek(13); // 8 byte header + 5 byte program size dummy op
+void NCSFile::jump() {
+	if (_instr->target == NCSProgram::kInvalidTarget)
+		throw Common::Exception("NCSFile::jump(): Invalid jump from %u by %d",
+		                        _instr->address, _instr->args[0]);
 
-	// TODO
+	_pc = _instr->target;
+}
 
-	_script->seek(oldScriptPos);
+void NCSFile::illegalType() const {
+	throw Common::Exception("NCSFile::%s(): Illegal type %d", _opcodes[_instr->opcode].desc, _instr->type);
 }
 
 // OPCODES!
@@ -482,16 +516,16 @@ void NCSFile::o_rsadd(InstructionType type) {
 void NCSFile::o_const(InstructionType type) {
 	switch (type) {
 		case kInstTypeInt:
-			_stack.push(_script->readSint32BE());
+			_stack.push(_instr->args[0]);
 			break;
 
 		case kInstTypeFloat:
-			_stack.push(_script->readIEEEFloatBE());
+			_stack.push(_instr->constFloat);
 			break;
 
 		case kInstTypeString:
 		case kInstTypeResource: {
-			_stack.push(Common::readStringFixed(*_script, Common::kEncodingASCII, _script->readUint16BE()));
+			_stack.push(_program->getString(_instr->args[0]));
 			break;
 		}
 
@@ -504,7 +538,7 @@ void NCSFile::o_const(InstructionType type) {
 			 * magic values. They *should* all have the same effect, though.
 			 */
 
-			uint32 objectID = _script->readUint32BE();
+			uint32 objectID = (uint32) _instr->args[0];
 
 			if      (objectID == kScriptObjectSelf)
 				_stack.push(_owner);
@@ -526,7 +560,8 @@ void NCSFile::o_const(InstructionType type) {
 }
 
 /** Helper function for o_action(), doing the actual engine function calling. */
-void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
+template<typename Stack>
+void NCSFile::callEngine(Stack &stack, Aurora::NWScript::FunctionContext &ctx,
                          uint32 function, uint8 argCount) {
 
 	if ((argCount < ctx.getParamMin()) || (argCount > ctx.getParamMax()))
@@ -544,7 +579,7 @@ void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
 
 		Type type = param.getType();
 		if (type == kTypeAny)
-			type = _stack.top().getType();
+			type = stack.top().getType();
 
 		switch (type) {
 			case kTypeInt:
@@ -554,15 +589,15 @@ void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
 			case kTypeEngineType:
 			case kTypeReference:
 			case kTypeArray:
-				param = _stack.pop();
+				param = stack.pop();
 				break;
 
 			case kTypeVector: {
 				// A vector is held as three floats on the stack
 
-				float z = _stack.pop().getFloat();
-				float y = _stack.pop().getFloat();
-				float x = _stack.pop().getFloat();
+				float z = stack.pop().getFloat();
+				float y = stack.pop().getFloat();
+				float x = stack.pop().getFloat();
 
 				param.setVector(x, y, z);
 				break;
@@ -599,7 +634,7 @@ void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
 		case kTypeObject:
 		case kTypeEngineType:
 		case kTypeArray:
-			_stack.push(retVal);
+			stack.push(retVal);
 			break;
 
 		case kTypeVector: {
@@ -608,9 +643,9 @@ void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
 			float x, y, z;
 			retVal.getVector(x, y, z);
 
-			_stack.push(x);
-			_stack.push(y);
-			_stack.push(z);
+			stack.push(x);
+			stack.push(y);
+			stack.push(z);
 			break;
 		}
 
@@ -621,18 +656,22 @@ void NCSFile::callEngine(Aurora::NWScript::FunctionContext &ctx,
 	}
 }
 
+// The threaded engine, in ncsfile_threaded.cpp, calls engine functions on its typed stack
+template void NCSFile::callEngine(NCSTypedStack &stack, Aurora::NWScript::FunctionContext &ctx,
+                                  uint32 function, uint8 argCount);
+
 /** ACTION: call a game-specific engine function. */
 void NCSFile::o_action(InstructionType type) {
 	if (type != kInstTypeNone)
 		throw Common::Exception("NCSFile::o_action(): Illegal type %d", type);
 
-	uint16 routineNumber = _script->readUint16BE();
-	uint8  argCount      = _script->readByte();
+	uint16 routineNumber = _instr->args[0];
+	uint8  argCount      = _instr->args[1];
 
 	Aurora::NWScript::FunctionContext ctx = FunctionMan.createContext(routineNumber);
 
 	try {
-		callEngine(ctx, routineNumber, argCount);
+		callEngine(_stack, ctx, routineNumber, argCount);
 	} catch (Common::Exception &e) {
 		e.add("Failed running engine function \"%s\" (%d)",
 		      ctx.getName().c_str(), routineNumber);
@@ -697,7 +736,7 @@ void NCSFile::o_eq(InstructionType type) {
 	if (type == kInstTypeStructStruct) {
 		// Comparisons between two structs (or two vectors) come with the size of the type
 
-		const size_t size = _script->readUint16BE();
+		const size_t size = _instr->args[0];
 
 		if ((size % 4) != 0)
 			throw Common::Exception("NCSFile::o_eq(): size %% 4 != 0");
@@ -726,7 +765,7 @@ void NCSFile::o_neq(InstructionType type) {
 	if (type == kInstTypeStructStruct) {
 		// Comparisons between two structs (or two vectors) come with the size of the type
 
-		const size_t size = _script->readUint16BE();
+		const size_t size = _instr->args[0];
 
 		if ((size % 4) != 0)
 			throw Common::Exception("NCSFile::o_neq(): size %% 4 != 0");
@@ -935,7 +974,7 @@ void NCSFile::o_movsp(InstructionType type) {
 	if (type != kInstTypeNone)
 		throw Common::Exception("NCSFile::o_movsp(): Illegal type %d", type);
 
-	_stack.setStackPtr(_stack.getStackPtr() - _script->readSint32BE());
+	_stack.setStackPtr(_stack.getStackPtr() - _instr->args[0]);
 }
 
 /** JMP: jump directly to a different script offset. */
@@ -943,8 +982,7 @@ void NCSFile::o_jmp(InstructionType type) {
 	if (type != kInstTypeNone)
 		throw Common::Exception("NCSFile::o_jmp(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
-	_script->skip(offset - 6);
+	jump();
 }
 
 /** JZ: jump conditionally if the top-most stack element is 0. */
@@ -952,10 +990,8 @@ void NCSFile::o_jz(InstructionType type) {
 	if (type != kInstTypeNone)
 		throw Common::Exception("NCSFile::o_jz(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
-
 	if (!_stack.pop().getInt())
-		_script->skip(offset - 6);
+		jump();
 }
 
 /** NOT: boolean-negate the top-most stack element (!). */
@@ -971,7 +1007,7 @@ void NCSFile::o_decsp(InstructionType type) {
 	if (type != kInstTypeInt)
 		throw Common::Exception("NCSFile::o_decsp(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
+	int32 offset = _instr->args[0];
 
 	_stack.setRelSP(offset, _stack.getRelSP(offset).getInt() - 1);
 }
@@ -981,7 +1017,7 @@ void NCSFile::o_incsp(InstructionType type) {
 	if (type != kInstTypeInt)
 		throw Common::Exception("NCSFile::o_incsp(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
+	int32 offset = _instr->args[0];
 
 	_stack.setRelSP(offset, _stack.getRelSP(offset).getInt() + 1);
 }
@@ -991,10 +1027,8 @@ void NCSFile::o_jnz(InstructionType type) {
 	if (type != kInstTypeNone)
 		throw Common::Exception("NCSFile::o_jnz(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
-
 	if (_stack.pop().getInt())
-		_script->skip(offset - 6);
+		jump();
 }
 
 /** DECBP: decrement the value of a base-pointer stack element (--). */
@@ -1002,7 +1036,7 @@ void NCSFile::o_decbp(InstructionType type) {
 	if (type != kInstTypeInt)
 		throw Common::Exception("NCSFile::o_decbp(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
+	int32 offset = _instr->args[0];
 
 	_stack.setRelBP(offset, _stack.getRelBP(offset).getInt() - 1);
 }
@@ -1012,7 +1046,7 @@ void NCSFile::o_incbp(InstructionType type) {
 	if (type != kInstTypeInt)
 		throw Common::Exception("NCSFile::o_incbp(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
+	int32 offset = _instr->args[0];
 
 	_stack.setRelBP(offset, _stack.getRelBP(offset).getInt() + 1);
 }
@@ -1050,8 +1084,8 @@ void NCSFile::o_cpdownsp(InstructionType type) {
 	if (type != kInstTypeDirect)
 		throw Common::Exception("NCSFile::o_cpdownsp(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
-	int16 size   = _script->readSint16BE();
+	int32 offset = _instr->args[0];
+	int16 size   = _instr->args[1];
 
 	if ((size % 4) != 0)
 		throw Common::Exception("NCSFile::o_cpdownsp(): Illegal size %d", size);
@@ -1071,8 +1105,8 @@ void NCSFile::o_cptopsp(InstructionType type) {
 	if (type != kInstTypeDirect)
 		throw Common::Exception("NCSFile::o_cptopsp(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
-	int16 size   = _script->readSint16BE();
+	int32 offset = _instr->args[0];
+	int16 size   = _instr->args[1];
 
 	if ((size % 4) != 0)
 		throw Common::Exception("NCSFile::o_cptopsp(): Illegal size %d", size);
@@ -1363,23 +1397,21 @@ void NCSFile::o_jsr(InstructionType type) {
 	if (type != kInstTypeNone)
 		throw Common::Exception("NCSFile::o_jsr(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
-
 	// Push the current script position
-	_returnOffsets.push(_script->pos());
+	_returnOffsets.push(_pc);
 
-	_script->skip(offset - 6);
+	jump();
 }
 
 /** RETN: return from a subroutine call. */
 void NCSFile::o_retn(InstructionType UNUSED(type)) {
-	uint32 returnAddress = _script->size();
+	size_t returnAddress = _program->size();
 	if (!_returnOffsets.empty()) {
 		returnAddress = _returnOffsets.top();
 		_returnOffsets.pop();
 	}
 
-	_script->seek(returnAddress);
+	_pc = returnAddress;
 }
 
 /** DESTRUCT: remove elements from the stack.
@@ -1387,9 +1419,9 @@ void NCSFile::o_retn(InstructionType UNUSED(type)) {
  *  Used to isolate struct elements.
  */
 void NCSFile::o_destruct(InstructionType UNUSED(type)) {
-	int16 stackSize        = _script->readSint16BE();
-	int16 dontRemoveOffset = _script->readSint16BE();
-	int16 dontRemoveSize   = _script->readSint16BE();
+	int16 stackSize        = _instr->args[0];
+	int16 dontRemoveOffset = _instr->args[1];
+	int16 dontRemoveSize   = _instr->args[2];
 
 	if ((stackSize % 4) != 0)
 		throw Common::Exception("NCSFile::o_destruct(): Illegal stack size %d", stackSize);
@@ -1424,8 +1456,8 @@ void NCSFile::o_cpdownbp(InstructionType type) {
 	if (type != kInstTypeDirect)
 		throw Common::Exception("NCSFile::o_cpdownbp(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE() - 4;
-	int16 size   = _script->readSint16BE();
+	int32 offset = _instr->args[0] - 4;
+	int16 size   = _instr->args[1];
 
 	if ((size % 4) != 0)
 		throw Common::Exception("NCSFile::o_cpdownbp(): Illegal size %d", size);
@@ -1448,8 +1480,8 @@ void NCSFile::o_cptopbp(InstructionType type) {
 	if (type != kInstTypeDirect)
 		throw Common::Exception("NCSFile::o_cptopbp(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE() - 4;
-	int16 size   = _script->readSint16BE();
+	int32 offset = _instr->args[0] - 4;
+	int16 size   = _instr->args[1];
 
 	if ((size % 4) != 0)
 		throw Common::Exception("NCSFile::o_cptopbp(): Illegal size %d", size);
@@ -1469,8 +1501,8 @@ void NCSFile::o_cptopbp(InstructionType type) {
  */
 void NCSFile::o_storestate(InstructionType type) {
 	uint8  offset = (uint8) type;
-	uint32 sizeBP = _script->readUint32BE();
-	uint32 sizeSP = _script->readUint32BE();
+	uint32 sizeBP = (uint32) _instr->args[0];
+	uint32 sizeSP = (uint32) _instr->args[1];
 
 	if ((sizeBP % 4) != 0)
 		throw Common::Exception("NCSFile::o_storestate(): Illegal BP size %d", sizeBP);
@@ -1480,7 +1512,7 @@ void NCSFile::o_storestate(InstructionType type) {
 	_storedState.setType(kTypeScriptState);
 	ScriptState &state = _storedState.getScriptState();
 
-	state.offset = _script->pos() - 10 + offset;
+	state.offset = _instr->address + offset;
 
 	sizeBP /= 4;
 	sizeSP /= 4;
@@ -1507,8 +1539,8 @@ void NCSFile::o_writearray(InstructionType type) {
 	if (type != kInstTypeDirect)
 		throw Common::Exception("NCSFile::o_writearray(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
-	int16 size   = _script->readSint16BE();
+	int32 offset = _instr->args[0];
+	int16 size   = _instr->args[1];
 
 	if (size != 4)
 		throw Common::Exception("NCSFile::o_writearray(): Invalid size %d", size);
@@ -1542,8 +1574,8 @@ void NCSFile::o_readarray(InstructionType type) {
 	if (type != kInstTypeDirect)
 		throw Common::Exception("NCSFile::o_readarray(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
-	int16 size   = _script->readSint16BE();
+	int32 offset = _instr->args[0];
+	int16 size   = _instr->args[1];
 
 	if (size != 4)
 		throw Common::Exception("NCSFile::o_readarray(): Invalid size %d", size);
@@ -1574,8 +1606,8 @@ void NCSFile::o_getref(InstructionType type) {
 	if (type != kInstTypeDirect)
 		throw Common::Exception("NCSFile::o_getref(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
-	int16 size   = _script->readSint16BE();
+	int32 offset = _instr->args[0];
+	int16 size   = _instr->args[1];
 
 	if (size != 4)
 		throw Common::Exception("NCSFile::o_getref(): Invalid size %d", size);
@@ -1605,8 +1637,8 @@ void NCSFile::o_getrefarray(InstructionType type) {
 	if (type != kInstTypeDirect)
 		throw Common::Exception("NCSFile::o_getrefarray(): Illegal type %d", type);
 
-	int32 offset = _script->readSint32BE();
-	int16 size   = _script->readSint16BE();
+	int32 offset = _instr->args[0];
+	int16 size   = _instr->args[1];
 
 	if (size != 4)
 		throw Common::Exception("NCSFile::o_getrefarray(): Invalid size %d", size);
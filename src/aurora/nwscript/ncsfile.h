@@ -28,8 +28,9 @@
 #include <vector>
 #include <stack>
 
+#include <boost/shared_ptr.hpp>
+
 #include "src/common/types.h"
-#include "src/common/scopedptr.h"
 
 #include "src/aurora/types.h"
 #include "src/aurora/aurorafile.h"
@@ -38,6 +39,7 @@
 #include "src/aurora/nwscript/variable.h"
 #include "src/aurora/nwscript/variablecontainer.h"
 #include "src/aurora/nwscript/objectref.h"
+#include "src/aurora/nwscript/ncsprogram.h"
 
 namespace Common {
 	class UString;
@@ -67,10 +69,10 @@ public:
 	Variable &getRelBP(int32 pos);
 	void setRelBP(int32 pos, const Variable &obj);
 
-	int32 getStackPtr();
+	int32 getStackPtr() const;
 	void  setStackPtr(int32 pos);
 
-	int32 getBasePtr();
+	int32 getBasePtr() const;
 	void  setBasePtr(int32 pos);
 
 	void print() const;
@@ -80,12 +82,112 @@ private:
 	int32 _basePtr;
 };
 
+/** A script stack that stores ints and floats directly.
+ *
+ *  Used by the threaded execution engine. Ints and floats (and with them
+ *  vectors, which are held as three floats) live in plain stack slots.
+ *  Only strings, objects, engine types, arrays and references are boxed
+ *  into a full Variable.
+ *
+ *  Once a full Variable has been requested for an element, for example
+ *  to create a reference to it, that element stays boxed until the stack
+ *  is reset. That way, whoever holds the reference sees all later writes.
+ *
+ *  Stack and base pointer work exactly like the ones of NCSStack.
+ */
+class NCSTypedStack {
+public:
+	NCSTypedStack();
+	~NCSTypedStack();
+
+	void reset();
+
+	bool empty() const;
+
+	Variable top() const;
+	Variable pop();
+	int32 popInt();
+	float popFloat();
+
+	void push(int32 value);
+	void push(float value);
+	void push(const Variable &var);
+	/** Push a copy of the element at this index. */
+	void pushCopy(size_t index);
+
+	/** Pop two sequences of n elements each and compare them for equality. */
+	bool popCompare(size_t n);
+
+	/** Return the index of an element relative to the stack pointer. */
+	size_t getIndexRelSP(int32 pos) const;
+	/** Return the index of an element relative to the base pointer. */
+	size_t getIndexRelBP(int32 pos) const;
+
+	Variable get(size_t index) const;
+	void set(size_t index, const Variable &var);
+
+	int32 getInt(size_t index) const;
+	void  setInt(size_t index, int32 value);
+
+	/** Copy the element at one index over the element at another index. */
+	void copy(size_t to, size_t from);
+
+	/** Return the full variable at this index, boxing it for good. */
+	Variable &getVariable(size_t index);
+
+	int32 getStackPtr() const;
+	void  setStackPtr(int32 pos);
+
+	int32 getBasePtr() const;
+	void  setBasePtr(int32 pos);
+
+	/** Copy all elements into a vector, bottom-most element first. */
+	void getVariables(std::vector<Variable> &vars) const;
+
+private:
+	struct Slot {
+		Type type;   ///< The type of an unboxed element.
+		bool boxed;  ///< Does the element live in _boxes?
+		bool pinned; ///< Does the element have to stay boxed?
+
+		union {
+			int32 i;
+			float f;
+		} value;
+
+		Slot();
+	};
+
+	std::vector<Slot>     _slots;
+	std::vector<Variable> _boxes;
+
+	int32 _stackPtr;
+	int32 _basePtr;
+
+	void grow();
+	void unbox(Slot &slot, size_t index);
+	bool equals(size_t a, size_t b) const;
+};
+
 #define DECLARE_OPCODE(x) void x(InstructionType type)
 
 /** An NCS, BioWare's NWN Compile Script. */
 class NCSFile : public AuroraFile {
 public:
+	/** The engines that can execute a script. */
+	enum Engine {
+		/** Call one handler per instruction, on a stack of full variables.
+		 *
+		 *  The stack is printed after every step, when script debugging is enabled.
+		 */
+		kEngineInterpreter,
+		/** Run all instructions in one dispatch loop, on an NCSTypedStack. */
+		kEngineThreaded
+	};
+
+	/** Take over this stream and decode the NCS within. */
 	NCSFile(Common::SeekableReadStream *ncs);
+	/** Get the decoded NCS of this name out of the NCSRegistry. */
 	NCSFile(const Common::UString &ncs);
 	~NCSFile();
 
@@ -115,59 +217,36 @@ public:
 
 	static ScriptState getEmptyState();
 
+	/** Return the engine new scripts are executed with. */
+	static Engine getDefaultEngine();
+	/** Set the engine new scripts are executed with. */
+	static void setDefaultEngine(Engine engine);
+
+	/** Return the engine this script is executed with. */
+	Engine getEngine() const;
+	/** Set the engine this script is executed with. */
+	void setEngine(Engine engine);
+
+	/** Return a copy of the stack as left by the last run, bottom-most element first. */
+	std::vector<Variable> getStack() const;
+
 private:
-	enum InstructionType {
-		// Unary
-		kInstTypeNone        =  0,
-		kInstTypeDirect      =  1,
-		kInstTypeInt         =  3,
-		kInstTypeFloat       =  4,
-		kInstTypeString      =  5,
-		kInstTypeObject      =  6,
-		kInstTypeResource    = 96,
-		kInstTypeEngineType0 = 16, // NWN:     effect        DA: event
-		kInstTypeEngineType1 = 17, // NWN:     event         DA: location
-		kInstTypeEngineType2 = 18, // NWN:     location      DA: command
-		kInstTypeEngineType3 = 19, // NWN:     talent        DA: effect
-		kInstTypeEngineType4 = 20, // NWN:     itemproperty  DA: itemproperty
-		kInstTypeEngineType5 = 21, // Witcher: mod           DA: player
-
-		// Arrays
-		kInstTypeIntArray          = 64,
-		kInstTypeFloatArray        = 65,
-		kInstTypeStringArray       = 66,
-		kInstTypeObjectArray       = 67,
-		kInstTypeResourceArray     = 68,
-		kInstTypeEngineType0Array  = 80,
-		kInstTypeEngineType1Array  = 81,
-		kInstTypeEngineType2Array  = 82,
-		kInstTypeEngineType3Array  = 83,
-		kInstTypeEngineType4Array  = 84,
-		kInstTypeEngineType5Array  = 85,
-
-		// Binary
-		kInstTypeIntInt                 = 32,
-		kInstTypeFloatFloat             = 33,
-		kInstTypeObjectObject           = 34,
-		kInstTypeStringString           = 35,
-		kInstTypeStructStruct           = 36,
-		kInstTypeIntFloat               = 37,
-		kInstTypeFloatInt               = 38,
-		kInstTypeEngineType0EngineType0 = 48,
-		kInstTypeEngineType1EngineType1 = 49,
-		kInstTypeEngineType2EngineType2 = 50,
-		kInstTypeEngineType3EngineType3 = 51,
-		kInstTypeEngineType4EngineType4 = 52,
-		kInstTypeEngineType5EngineType5 = 53,
-		kInstTypeVectorVector           = 58,
-		kInstTypeVectorFloat            = 59,
-		kInstTypeFloatVector            = 60
-	};
+	static Engine _defaultEngine;
 
 	Common::UString _name;
 
-	NCSStack _stack;
-	Common::ScopedPtr<Common::SeekableReadStream> _script;
+	Engine _engine;
+
+	NCSStack      _stack;
+	NCSTypedStack _typedStack;
+
+	/** The decoded script, possibly shared with other NCSFile instances. */
+	boost::shared_ptr<const NCSProgram> _program;
+
+	/** Index of the next instruction to execute. */
+	size_t _pc;
+	/** The instruction currently being executed. */
+	const NCSProgram::Instruction *_instr;
 
 	Variable _return;
 
@@ -176,7 +255,8 @@ private:
 
 	VariableContainer _env;
 
-	std::stack<uint32> _returnOffsets;
+	/** Instruction indices to return to from subroutines. */
+	std::stack<size_t> _returnOffsets;
 
 	Variable _storedState;
 
@@ -189,7 +269,7 @@ private:
 	size_t _opcodeListSize;
 	void setupOpcodes();
 
-	void load();
+	void init();
 
 	/** Reset the script for another execution. */
 	void reset();
@@ -200,9 +280,19 @@ private:
 	/** Execute one script step. */
 	bool executeStep();
 
-	void decompile(); // TODO
+	/** Execute the whole script with the threaded engine. */
+	void executeThreaded();
+	/** Execute an ADD, SUB, MUL or DIV instruction with the threaded engine. */
+	void executeArithmetic();
+
+	/** Continue execution at the target of the current jump instruction. */
+	void jump();
+
+	/** Throw an exception about the type of the current instruction. */
+	void NORETURN_PRE illegalType() const NORETURN_POST;
 
-	void callEngine(Aurora::NWScript::FunctionContext &ctx, uint32 function, uint8 argCount);
+	template<typename Stack>
+	void callEngine(Stack &stack, Aurora::NWScript::FunctionContext &ctx, uint32 function, uint8 argCount);
 
 	// Opcode declarations
 	DECLARE_OPCODE(o_nop);
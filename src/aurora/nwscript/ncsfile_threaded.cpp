@@ -0,0 +1,1082 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  The threaded execution engine for BioWare's NWN Compiled Scripts.
+ */
+
+/* Instead of calling one handler method per instruction, the threaded engine
+ * runs the whole pre-decoded NCSProgram in a single switch dispatch loop, on
+ * an NCSTypedStack. Ints and floats never leave their stack slots, so simple
+ * arithmetic, comparisons and jumps don't construct any Variable at all.
+ *
+ * The engine has to behave exactly like the interpreter in ncsfile.cpp. The
+ * unit tests in tests/aurora/ncsfile.cpp run both on the same scripts and compare
+ * their results.
+ */
+
+#include <boost/make_shared.hpp>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+#include "src/aurora/nwscript/ncsfile.h"
+#include "src/aurora/nwscript/functionman.h"
+
+static const uint32 kScriptObjectSelf        = 0x00000000;
+static const uint32 kScriptObjectInvalid     = 0x00000001;
+static const uint32 kScriptObjectInvalid2    = 0xFFFFFFFF;
+static const uint32 kScriptObjectTypeInvalid = 0x7F000000;
+
+/** The number of stack elements to make room for up-front. */
+static const size_t kInitialStackSize = 128;
+
+namespace Aurora {
+
+namespace NWScript {
+
+NCSTypedStack::Slot::Slot() : type(kTypeVoid), boxed(false), pinned(false) {
+	value.i = 0;
+}
+
+
+NCSTypedStack::NCSTypedStack() {
+	_slots.reserve(kInitialStackSize);
+	_boxes.reserve(kInitialStackSize);
+
+	reset();
+}
+
+NCSTypedStack::~NCSTypedStack() {
+}
+
+void NCSTypedStack::reset() {
+	_slots.clear();
+	_boxes.clear();
+
+	_stackPtr = -1;
+	_basePtr  = -1;
+}
+
+bool NCSTypedStack::empty() const {
+	return _stackPtr < 0;
+}
+
+void NCSTypedStack::grow() {
+	_slots.push_back(Slot());
+	_boxes.push_back(Variable());
+}
+
+void NCSTypedStack::unbox(Slot &slot, size_t index) {
+	// Free whatever was boxed here before
+	if (slot.boxed)
+		_boxes[index].setType(kTypeVoid);
+
+	slot.boxed = false;
+}
+
+Variable NCSTypedStack::top() const {
+	if (_stackPtr == -1)
+		throw Common::Exception("NCSTypedStack: Stack underflow");
+
+	return get(_stackPtr);
+}
+
+Variable NCSTypedStack::pop() {
+	if (_stackPtr == -1)
+		throw Common::Exception("NCSTypedStack: Stack underflow");
+
+	return get(_stackPtr--);
+}
+
+int32 NCSTypedStack::popInt() {
+	if (_stackPtr == -1)
+		throw Common::Exception("NCSTypedStack: Stack underflow");
+
+	return getInt(_stackPtr--);
+}
+
+float NCSTypedStack::popFloat() {
+	if (_stackPtr == -1)
+		throw Common::Exception("NCSTypedStack: Stack underflow");
+
+	const size_t index = _stackPtr--;
+
+	const Slot &slot = _slots[index];
+	if (slot.boxed)
+		return _boxes[index].getFloat();
+
+	if (slot.type != kTypeFloat)
+		throw Common::Exception("Can't get a float value from a non-float variable");
+
+	return slot.value.f;
+}
+
+void NCSTypedStack::push(int32 value) {
+	if (_stackPtr == (int32)_slots.size() - 1)
+		grow();
+
+	setInt(++_stackPtr, value);
+}
+
+void NCSTypedStack::push(float value) {
+	if (_stackPtr == (int32)_slots.size() - 1)
+		grow();
+
+	const size_t index = ++_stackPtr;
+
+	Slot &slot = _slots[index];
+	if (slot.pinned) {
+		_boxes[index] = Variable(value);
+		return;
+	}
+
+	unbox(slot, index);
+
+	slot.type    = kTypeFloat;
+	slot.value.f = value;
+}
+
+void NCSTypedStack::push(const Variable &var) {
+	if (_stackPtr == 0x7FFFFFFF) // Like this will ever happen :P
+		throw Common::Exception("NCSTypedStack: Stack overflow");
+
+	if (_stackPtr == (int32)_slots.size() - 1)
+		grow();
+
+	set(++_stackPtr, var);
+}
+
+void NCSTypedStack::pushCopy(size_t index) {
+	if (_stackPtr == (int32)_slots.size() - 1)
+		grow();
+
+	copy(++_stackPtr, index);
+}
+
+bool NCSTypedStack::equals(size_t a, size_t b) const {
+	const Slot &slotA = _slots[a];
+	const Slot &slotB = _slots[b];
+
+	if (slotA.boxed || slotB.boxed)
+		return get(a) == get(b);
+
+	if (slotA.type != slotB.type)
+		return false;
+
+	if (slotA.type == kTypeInt)
+		return slotA.value.i == slotB.value.i;
+	if (slotA.type == kTypeFloat)
+		return slotA.value.f == slotB.value.f;
+
+	return true;
+}
+
+bool NCSTypedStack::popCompare(size_t n) {
+	if ((int64)(2 * n) > (_stackPtr + 1))
+		throw Common::Exception("NCSTypedStack: Stack underflow");
+
+	bool result = true;
+	for (size_t i = 0; (i < n) && result; i++)
+		result = equals(_stackPtr - i, _stackPtr - n - i);
+
+	_stackPtr -= 2 * n;
+
+	return result;
+}
+
+size_t NCSTypedStack::getIndexRelSP(int32 pos) const {
+	if ((pos > -4) || ((pos % 4) != 0))
+		throw Common::Exception("NCSTypedStack::get(): Illegal position %d", pos);
+
+	int32 stackPos = _stackPtr - ((pos / -4) - 1);
+	if (stackPos < 0)
+		throw Common::Exception("NCSTypedStack::get(): Position %d below the bottom", pos);
+
+	return stackPos;
+}
+
+size_t NCSTypedStack::getIndexRelBP(int32 pos) const {
+	if ((pos > -4) || ((pos % 4) != 0))
+		throw Common::Exception("NCSTypedStack::get(): Illegal position %d", pos);
+
+	int32 stackPos = _basePtr - ((pos / -4) - 1);
+	if (stackPos < 0)
+		throw Common::Exception("NCSTypedStack::get(): Position %d below the bottom", pos);
+
+	if (stackPos >= (int32)_slots.size())
+		throw Common::Exception("NCSTypedStack::get(): Position %d above the top", pos);
+
+	return stackPos;
+}
+
+Variable NCSTypedStack::get(size_t index) const {
+	const Slot &slot = _slots[index];
+	if (slot.boxed)
+		return _boxes[index];
+
+	if (slot.type == kTypeInt)
+		return Variable(slot.value.i);
+	if (slot.type == kTypeFloat)
+		return Variable(slot.value.f);
+
+	return Variable(slot.type);
+}
+
+void NCSTypedStack::set(size_t index, const Variable &var) {
+	Slot &slot = _slots[index];
+
+	const Type type = var.getType();
+	if (slot.pinned || ((type != kTypeVoid) && (type != kTypeInt) && (type != kTypeFloat))) {
+		_boxes[index] = var;
+		slot.boxed = true;
+		return;
+	}
+
+	unbox(slot, index);
+
+	slot.type = type;
+
+	if      (type == kTypeInt)
+		slot.value.i = var.getInt();
+	else if (type == kTypeFloat)
+		slot.value.f = var.getFloat();
+}
+
+int32 NCSTypedStack::getInt(size_t index) const {
+	const Slot &slot = _slots[index];
+	if (slot.boxed)
+		return _boxes[index].getInt();
+
+	if (slot.type != kTypeInt)
+		throw Common::Exception("Can't get an int value from a non-int variable");
+
+	return slot.value.i;
+}
+
+void NCSTypedStack::setInt(size_t index, int32 value) {
+	Slot &slot = _slots[index];
+	if (slot.pinned) {
+		_boxes[index] = Variable(value);
+		return;
+	}
+
+	unbox(slot, index);
+
+	slot.type    = kTypeInt;
+	slot.value.i = value;
+}
+
+void NCSTypedStack::copy(size_t to, size_t from) {
+	if (to == from)
+		return;
+
+	const Slot &slotFrom = _slots[from];
+	      Slot &slotTo   = _slots[to];
+
+	if (slotFrom.boxed || slotTo.pinned) {
+		set(to, get(from));
+		return;
+	}
+
+	unbox(slotTo, to);
+
+	slotTo.type  = slotFrom.type;
+	slotTo.value = slotFrom.value;
+}
+
+Variable &NCSTypedStack::getVariable(size_t index) {
+	Slot &slot = _slots[index];
+	if (!slot.boxed)
+		_boxes[index] = get(index);
+
+	slot.boxed  = true;
+	slot.pinned = true;
+
+	return _boxes[index];
+}
+
+int32 NCSTypedStack::getStackPtr() const {
+	return (_stackPtr + 1) * -4;
+}
+
+void NCSTypedStack::setStackPtr(int32 pos) {
+	if ((pos > 0) || ((pos % 4) != 0))
+		throw Common::Exception("NCSTypedStack::setStackPtr(): Illegal position %d", pos);
+
+	_stackPtr = (pos / -4) - 1;
+
+	while ((int32)_slots.size() < (_stackPtr + 1))
+		grow();
+}
+
+int32 NCSTypedStack::getBasePtr() const {
+	return (_basePtr + 1) * -4;
+}
+
+void NCSTypedStack::setBasePtr(int32 pos) {
+	if ((pos > 0) || ((pos % 4) != 0))
+		throw Common::Exception("NCSTypedStack::setBasePtr(): Illegal position %d", pos);
+
+	_basePtr = (pos / -4) - 1;
+}
+
+void NCSTypedStack::getVariables(std::vector<Variable> &vars) const {
+	vars.clear();
+	vars.reserve(_stackPtr + 1);
+
+	for (int32 i = 0; i <= _stackPtr; i++)
+		vars.push_back(get(i));
+}
+
+
+/** Perform the arithmetic operation of an ADD, SUB, MUL or DIV instruction. */
+template<typename T>
+static inline T calculate(byte opcode, T op1, T op2) {
+	switch (opcode) {
+		case kOpcodeADD:
+			return op1 + op2;
+		case kOpcodeSUB:
+			return op1 - op2;
+		case kOpcodeMUL:
+			return op1 * op2;
+		default:
+			break;
+	}
+
+	return op1 / op2;
+}
+
+void NCSFile::executeThreaded() {
+	const NCSProgram &program = *_program;
+	const size_t programSize  = program.size();
+
+	NCSTypedStack &stack = _typedStack;
+
+	while (_pc < programSize) {
+		_instr = &program[_pc];
+		_pc    = _instr->next;
+
+		const NCSProgram::Instruction &instr = *_instr;
+		const byte type = instr.type;
+
+		switch (instr.opcode) {
+			case kOpcodeNOP:
+			case kOpcodeNOP2:
+				break;
+
+			case kOpcodeRSADD:
+				switch (type) {
+					case kInstTypeInt:
+						stack.push((int32) 0);
+						break;
+					case kInstTypeFloat:
+						stack.push(0.0f);
+						break;
+					case kInstTypeString:
+					case kInstTypeResource:
+						stack.push(Variable(kTypeString));
+						break;
+					case kInstTypeObject:
+						stack.push(Variable(kTypeObject));
+						break;
+					case kInstTypeEngineType0:
+					case kInstTypeEngineType1:
+					case kInstTypeEngineType2:
+					case kInstTypeEngineType3:
+					case kInstTypeEngineType4:
+					case kInstTypeEngineType5:
+						stack.push(Variable(kTypeEngineType));
+						break;
+					case kInstTypeIntArray:
+					case kInstTypeFloatArray:
+					case kInstTypeStringArray:
+					case kInstTypeObjectArray:
+					case kInstTypeResourceArray:
+					case kInstTypeEngineType0Array:
+					case kInstTypeEngineType1Array:
+					case kInstTypeEngineType2Array:
+					case kInstTypeEngineType3Array:
+					case kInstTypeEngineType4Array:
+					case kInstTypeEngineType5Array:
+						stack.push(Variable(kTypeArray));
+						break;
+					default:
+						illegalType();
+				}
+				break;
+
+			case kOpcodeCONST:
+				switch (type) {
+					case kInstTypeInt:
+						stack.push((int32) instr.args[0]);
+						break;
+
+					case kInstTypeFloat:
+						stack.push(instr.constFloat);
+						break;
+
+					case kInstTypeString:
+					case kInstTypeResource:
+						stack.push(Variable(program.getString(instr.args[0])));
+						break;
+
+					case kInstTypeObject: {
+						// See NCSFile::o_const()
+						const uint32 objectID = (uint32) instr.args[0];
+
+						if      (objectID == kScriptObjectSelf)
+							stack.push(Variable(_owner));
+						else if ((objectID == kScriptObjectInvalid) || (objectID == kScriptObjectInvalid2) ||
+						         (objectID == kScriptObjectTypeInvalid))
+							stack.push(Variable((Object *) 0));
+						else
+							throw Common::Exception("NCSFile::o_const(): Illegal object ID %d", objectID);
+
+						break;
+					}
+
+					default:
+						illegalType();
+				}
+				break;
+
+			case kOpcodeACTION: {
+				if (type != kInstTypeNone)
+					illegalType();
+
+				const uint16 routineNumber = instr.args[0];
+				const uint8  argCount      = instr.args[1];
+
+				Aurora::NWScript::FunctionContext ctx = FunctionMan.createContext(routineNumber);
+
+				try {
+					callEngine(stack, ctx, routineNumber, argCount);
+				} catch (Common::Exception &e) {
+					e.add("Failed running engine function \"%s\" (%d)",
+					      ctx.getName().c_str(), routineNumber);
+					throw;
+				}
+				break;
+			}
+
+			case kOpcodeLOGAND: {
+				if (type != kInstTypeIntInt)
+					illegalType();
+
+				const int32 arg1 = stack.popInt();
+				const int32 arg2 = stack.popInt();
+				stack.push((int32) (arg1 && arg2));
+				break;
+			}
+
+			case kOpcodeLOGOR: {
+				if (type != kInstTypeIntInt)
+					illegalType();
+
+				const int32 arg1 = stack.popInt();
+				const int32 arg2 = stack.popInt();
+				stack.push((int32) (arg1 || arg2));
+				break;
+			}
+
+			case kOpcodeINCOR: {
+				if (type != kInstTypeIntInt)
+					illegalType();
+
+				const int32 arg1 = stack.popInt();
+				const int32 arg2 = stack.popInt();
+				stack.push((int32) (arg1 | arg2));
+				break;
+			}
+
+			case kOpcodeEXCOR: {
+				if (type != kInstTypeIntInt)
+					illegalType();
+
+				const int32 arg1 = stack.popInt();
+				const int32 arg2 = stack.popInt();
+				stack.push((int32) (arg1 ^ arg2));
+				break;
+			}
+
+			case kOpcodeBOOLAND: {
+				if (type != kInstTypeIntInt)
+					illegalType();
+
+				const int32 arg1 = stack.popInt();
+				const int32 arg2 = stack.popInt();
+				stack.push((int32) (arg1 & arg2));
+				break;
+			}
+
+			case kOpcodeEQ:
+			case kOpcodeNEQ: {
+				size_t n = 1;
+
+				if (type == kInstTypeStructStruct) {
+					// Comparisons between two structs (or two vectors) come with the size of the type
+
+					const size_t size = instr.args[0];
+					if ((size % 4) != 0)
+						throw Common::Exception("NCSFile::%s(): size %% 4 != 0", _opcodes[instr.opcode].desc);
+
+					n = size / 4;
+				}
+
+				const bool equal = stack.popCompare(n);
+				stack.push((int32) ((instr.opcode == kOpcodeEQ) ? equal : !equal));
+				break;
+			}
+
+			case kOpcodeGEQ:
+				if        (type == kInstTypeIntInt) {
+					const int32 arg1 = stack.popInt();
+					const int32 arg2 = stack.popInt();
+					stack.push((int32) (arg2 >= arg1));
+				} else if (type == kInstTypeFloatFloat) {
+					const float arg1 = stack.popFloat();
+					const float arg2 = stack.popFloat();
+					stack.push((int32) (arg2 >= arg1));
+				} else
+					illegalType();
+				break;
+
+			case kOpcodeGT:
+				if        (type == kInstTypeIntInt) {
+					const int32 arg1 = stack.popInt();
+					const int32 arg2 = stack.popInt();
+					stack.push((int32) (arg2 > arg1));
+				} else if (type == kInstTypeFloatFloat) {
+					const float arg1 = stack.popFloat();
+					const float arg2 = stack.popFloat();
+					stack.push((int32) (arg2 > arg1));
+				} else
+					illegalType();
+				break;
+
+			case kOpcodeLT:
+				if        (type == kInstTypeIntInt) {
+					const int32 arg1 = stack.popInt();
+					const int32 arg2 = stack.popInt();
+					stack.push((int32) (arg2 < arg1));
+				} else if (type == kInstTypeFloatFloat) {
+					const float arg1 = stack.popFloat();
+					const float arg2 = stack.popFloat();
+					stack.push((int32) (arg2 < arg1));
+				} else
+					illegalType();
+				break;
+
+			case kOpcodeLEQ:
+				if        (type == kInstTypeIntInt) {
+					const int32 arg1 = stack.popInt();
+					const int32 arg2 = stack.popInt();
+					stack.push((int32) (arg2 <= arg1));
+				} else if (type == kInstTypeFloatFloat) {
+					const float arg1 = stack.popFloat();
+					const float arg2 = stack.popFloat();
+					stack.push((int32) (arg2 <= arg1));
+				} else
+					illegalType();
+				break;
+
+			case kOpcodeSHLEFT: {
+				if (type != kInstTypeIntInt)
+					illegalType();
+
+				const int32 arg1 = stack.popInt();
+				const int32 arg2 = stack.popInt();
+				stack.push((int32) (arg2 << arg1));
+				break;
+			}
+
+			case kOpcodeSHRIGHT: {
+				// See NCSFile::o_shright()
+				if (type != kInstTypeIntInt)
+					illegalType();
+
+				const int32 arg1 = stack.popInt();
+				const int32 arg2 = stack.popInt();
+
+				if (arg2 < 0)
+					stack.push((int32) -((-arg2) >> arg1));
+				else
+					stack.push((int32) (arg2 >> arg1));
+				break;
+			}
+
+			case kOpcodeUSHRIGHT: {
+				// See NCSFile::o_ushright()
+				if (type != kInstTypeIntInt)
+					illegalType();
+
+				const int32 arg1 = stack.popInt();
+				const int32 arg2 = stack.popInt();
+				stack.push((int32) (arg2 >> arg1));
+				break;
+			}
+
+			case kOpcodeADD:
+			case kOpcodeSUB:
+			case kOpcodeMUL:
+			case kOpcodeDIV:
+				executeArithmetic();
+				break;
+
+			case kOpcodeMOD: {
+				if (type != kInstTypeIntInt)
+					illegalType();
+
+				const int32 arg1 = stack.popInt();
+				const int32 arg2 = stack.popInt();
+
+				if (arg1 == 0)
+					throw Common::Exception("NCSFile::o_mod(): Modulus by zero");
+				else if (arg1 < 0 || arg2 < 0)
+					throw Common::Exception("NCSFile::o_mod(): Modulus by negative number (%d %% %d)", arg2, arg1);
+
+				stack.push((int32) (arg2 % arg1));
+				break;
+			}
+
+			case kOpcodeNEG:
+				if      (type == kInstTypeInt)
+					stack.push((int32) -stack.popInt());
+				else if (type == kInstTypeFloat)
+					stack.push(-stack.popFloat());
+				else
+					illegalType();
+				break;
+
+			case kOpcodeCOMP:
+				if (type != kInstTypeInt)
+					illegalType();
+
+				stack.push((int32) ~stack.popInt());
+				break;
+
+			case kOpcodeMOVSP:
+				if (type != kInstTypeNone)
+					illegalType();
+
+				stack.setStackPtr(stack.getStackPtr() - instr.args[0]);
+				break;
+
+			case kOpcodeSTORESTATEALL:
+				// See NCSFile::o_storestateall()
+				warning("TODO: NCSFile::o_storestateall(): %d", type);
+				break;
+
+			case kOpcodeJMP:
+				if (type != kInstTypeNone)
+					illegalType();
+
+				jump();
+				break;
+
+			case kOpcodeJSR:
+				if (type != kInstTypeNone)
+					illegalType();
+
+				// Push the current script position
+				_returnOffsets.push(_pc);
+
+				jump();
+				break;
+
+			case kOpcodeJZ:
+				if (type != kInstTypeNone)
+					illegalType();
+
+				if (!stack.popInt())
+					jump();
+				break;
+
+			case kOpcodeJNZ:
+				if (type != kInstTypeNone)
+					illegalType();
+
+				if (stack.popInt())
+					jump();
+				break;
+
+			case kOpcodeRETN:
+				if (_returnOffsets.empty()) {
+					_pc = programSize;
+					break;
+				}
+
+				_pc = _returnOffsets.top();
+				_returnOffsets.pop();
+				break;
+
+			case kOpcodeDESTRUCT: {
+				// See NCSFile::o_destruct()
+				int16 stackSize              = instr.args[0];
+				const int16 dontRemoveOffset = instr.args[1];
+				const int16 dontRemoveSize   = instr.args[2];
+
+				if ((stackSize % 4) != 0)
+					throw Common::Exception("NCSFile::o_destruct(): Illegal stack size %d", stackSize);
+				if ((dontRemoveOffset % 4) != 0)
+					throw Common::Exception("NCSFile::o_destruct(): Illegal offset %d", dontRemoveOffset);
+				if ((dontRemoveSize % 4) != 0)
+					throw Common::Exception("NCSFile::o_destruct(): Illegal size %d", dontRemoveSize);
+
+				std::vector<Variable> tmp;
+				tmp.reserve(dontRemoveSize / 4);
+
+				while (stackSize > 0) {
+					if ((stackSize <= (dontRemoveOffset + dontRemoveSize)) &&
+					    (stackSize >   dontRemoveOffset))
+						tmp.push_back(stack.top());
+
+					stack.pop();
+
+					stackSize -= 4;
+				}
+
+				for (std::vector<Variable>::reverse_iterator t = tmp.rbegin(); t != tmp.rend(); ++t)
+					stack.push(*t);
+				break;
+			}
+
+			case kOpcodeNOT:
+				if (type != kInstTypeInt)
+					illegalType();
+
+				stack.push((int32) !stack.popInt());
+				break;
+
+			case kOpcodeDECSP:
+			case kOpcodeINCSP: {
+				if (type != kInstTypeInt)
+					illegalType();
+
+				const size_t index = stack.getIndexRelSP(instr.args[0]);
+				stack.setInt(index, stack.getInt(index) + ((instr.opcode == kOpcodeINCSP) ? 1 : -1));
+				break;
+			}
+
+			case kOpcodeDECBP:
+			case kOpcodeINCBP: {
+				if (type != kInstTypeInt)
+					illegalType();
+
+				const size_t index = stack.getIndexRelBP(instr.args[0]);
+				stack.setInt(index, stack.getInt(index) + ((instr.opcode == kOpcodeINCBP) ? 1 : -1));
+				break;
+			}
+
+			case kOpcodeCPDOWNSP:
+			case kOpcodeCPDOWNBP: {
+				if (type != kInstTypeDirect)
+					illegalType();
+
+				const bool bp = instr.opcode == kOpcodeCPDOWNBP;
+
+				int32 offset = bp ? (instr.args[0] - 4) : instr.args[0];
+				int16 size   = instr.args[1];
+
+				if ((size % 4) != 0)
+					throw Common::Exception("NCSFile::%s(): Illegal size %d", _opcodes[instr.opcode].desc, size);
+
+				int32 startPos = -size;
+				while (size > 0) {
+					const size_t from = stack.getIndexRelSP(startPos);
+					const size_t to   = bp ? stack.getIndexRelBP(offset) : stack.getIndexRelSP(offset);
+
+					stack.copy(to, from);
+
+					startPos += 4;
+					offset   += 4;
+					size     -= 4;
+				}
+				break;
+			}
+
+			case kOpcodeCPTOPSP: {
+				if (type != kInstTypeDirect)
+					illegalType();
+
+				const int32 offset = instr.args[0];
+				int16 size = instr.args[1];
+
+				if ((size % 4) != 0)
+					throw Common::Exception("NCSFile::o_cptopsp(): Illegal size %d", size);
+
+				while (size > 0) {
+					stack.pushCopy(stack.getIndexRelSP(offset));
+
+					size -= 4;
+				}
+				break;
+			}
+
+			case kOpcodeCPTOPBP: {
+				if (type != kInstTypeDirect)
+					illegalType();
+
+				int32 offset = instr.args[0] - 4;
+				int16 size   = instr.args[1];
+
+				if ((size % 4) != 0)
+					throw Common::Exception("NCSFile::o_cptopbp(): Illegal size %d", size);
+
+				while (size > 0) {
+					stack.pushCopy(stack.getIndexRelBP(offset));
+
+					size   -= 4;
+					offset += 4;
+				}
+				break;
+			}
+
+			case kOpcodeSAVEBP:
+				if (type != kInstTypeNone)
+					illegalType();
+
+				stack.push((int32) stack.getBasePtr());
+				stack.setBasePtr(stack.getStackPtr());
+				break;
+
+			case kOpcodeRESTOREBP:
+				if (type != kInstTypeNone)
+					illegalType();
+
+				stack.setBasePtr(stack.popInt());
+				break;
+
+			case kOpcodeSTORESTATE: {
+				// See NCSFile::o_storestate()
+				const uint8  offset = (uint8) type;
+				      uint32 sizeBP = (uint32) instr.args[0];
+				      uint32 sizeSP = (uint32) instr.args[1];
+
+				if ((sizeBP % 4) != 0)
+					throw Common::Exception("NCSFile::o_storestate(): Illegal BP size %d", sizeBP);
+				if ((sizeSP % 4) != 0)
+					throw Common::Exception("NCSFile::o_storestate(): Illegal SP size %d", sizeSP);
+
+				_storedState.setType(kTypeScriptState);
+				ScriptState &state = _storedState.getScriptState();
+
+				state.offset = instr.address + offset;
+
+				sizeBP /= 4;
+				sizeSP /= 4;
+
+				for (int32 posBP = -4; sizeBP > 0; sizeBP--, posBP -= 4)
+					state.globals.push_back(stack.get(stack.getIndexRelBP(posBP)));
+
+				for (int32 posSP = -4; sizeSP > 0; sizeSP--, posSP -= 4)
+					state.locals.push_back(stack.get(stack.getIndexRelSP(posSP)));
+				break;
+			}
+
+			case kOpcodeWRITEARRAY: {
+				// See NCSFile::o_writearray()
+				if (type != kInstTypeDirect)
+					illegalType();
+
+				if (instr.args[1] != 4)
+					throw Common::Exception("NCSFile::o_writearray(): Invalid size %d", instr.args[1]);
+
+				const size_t arrayIndex = stack.getIndexRelSP(instr.args[0]);
+
+				const int32 index = stack.popInt();
+				const Variable value = stack.top();
+
+				if (index < 0)
+					throw Common::Exception("NCSFile::o_writearray(): Invalid index %d", index);
+
+				Variable &arrayVar = stack.getVariable(arrayIndex);
+
+				arrayVar.growArray(value.getType(), index + 1);
+				arrayVar.getArray()[index] = boost::make_shared<Variable>(value);
+				break;
+			}
+
+			case kOpcodeREADARRAY:
+			case kOpcodeGETREFARRAY: {
+				// See NCSFile::o_readarray() and NCSFile::o_getrefarray()
+				if (type != kInstTypeDirect)
+					illegalType();
+
+				if (instr.args[1] != 4)
+					throw Common::Exception("NCSFile::%s(): Invalid size %d", _opcodes[instr.opcode].desc, instr.args[1]);
+
+				Variable::Array &array = stack.getVariable(stack.getIndexRelSP(instr.args[0])).getArray();
+
+				const int32 index = stack.popInt();
+				if ((index < 0) || ((uint)index >= array.size()))
+					throw Common::Exception("NCSFile::%s(): Index out of range (%d, %u)",
+					                        _opcodes[instr.opcode].desc, index, (uint) array.size());
+
+				if (instr.opcode == kOpcodeREADARRAY) {
+					stack.push(*array[index]);
+					break;
+				}
+
+				Variable reference(kTypeReference);
+				reference.setReference(&*array[index]);
+
+				stack.push(reference);
+				break;
+			}
+
+			case kOpcodeGETREF: {
+				// See NCSFile::o_getref()
+				if (type != kInstTypeDirect)
+					illegalType();
+
+				if (instr.args[1] != 4)
+					throw Common::Exception("NCSFile::o_getref(): Invalid size %d", instr.args[1]);
+
+				const size_t index = stack.getIndexRelSP(instr.args[0]);
+
+				// Push first, so that growing the stack can't invalidate the reference
+				stack.push(Variable(kTypeReference));
+
+				Variable &var = stack.getVariable(index);
+				stack.getVariable(stack.getIndexRelSP(-4)).setReference(&var);
+				break;
+			}
+
+			default:
+				throw Common::Exception("NCSFile::executeThreaded(): Illegal instruction 0x%02x", instr.opcode);
+		}
+	}
+}
+
+void NCSFile::executeArithmetic() {
+	NCSTypedStack &stack = _typedStack;
+
+	const byte opcode = _instr->opcode;
+	const byte type   = _instr->type;
+
+	switch (type) {
+		case kInstTypeIntInt: {
+			if ((opcode != kOpcodeADD) && (opcode != kOpcodeSUB) &&
+			    (opcode != kOpcodeMUL) && (opcode != kOpcodeDIV))
+				illegalType();
+
+			const int32 op2 = stack.popInt();
+			const int32 op1 = stack.popInt();
+
+			if (opcode == kOpcodeDIV) {
+				if (op2 == 0)
+					throw Common::Exception("NCSFile::o_div(): Divide by zero");
+
+				if (op1 == INT32_MIN && op2 == -1)
+					throw Common::Exception("NCSFile::o_div: Quotient overflow");
+			}
+
+			stack.push(calculate(opcode, op1, op2));
+			break;
+		}
+
+		case kInstTypeFloatFloat:
+		case kInstTypeIntFloat:
+		case kInstTypeFloatInt: {
+			const float op2 = (type == kInstTypeFloatInt) ? (float) stack.popInt() : stack.popFloat();
+			const float op1 = (type == kInstTypeIntFloat) ? (float) stack.popInt() : stack.popFloat();
+
+			if ((opcode == kOpcodeDIV) && (op2 == 0.0f))
+				throw Common::Exception("NCSFile::o_div(): Divide by zero");
+
+			stack.push(calculate(opcode, op1, op2));
+			break;
+		}
+
+		case kInstTypeStringString: {
+			if (opcode != kOpcodeADD)
+				illegalType();
+
+			const Variable op2 = stack.pop();
+			const Variable op1 = stack.pop();
+
+			stack.push(Variable(op1.getString() + op2.getString()));
+			break;
+		}
+
+		case kInstTypeVectorVector: {
+			if ((opcode != kOpcodeADD) && (opcode != kOpcodeSUB))
+				illegalType();
+
+			const float op2z = stack.popFloat();
+			const float op2y = stack.popFloat();
+			const float op2x = stack.popFloat();
+			const float op1z = stack.popFloat();
+			const float op1y = stack.popFloat();
+			const float op1x = stack.popFloat();
+
+			// Yes, this is the order the interpreter pushes the results in
+			stack.push(calculate(opcode, op1z, op2z));
+			stack.push(calculate(opcode, op1y, op2y));
+			stack.push(calculate(opcode, op1x, op2x));
+			break;
+		}
+
+		case kInstTypeVectorFloat: {
+			if ((opcode != kOpcodeMUL) && (opcode != kOpcodeDIV))
+				illegalType();
+
+			const float op2  = stack.popFloat();
+			const float op1z = stack.popFloat();
+			const float op1y = stack.popFloat();
+			const float op1x = stack.popFloat();
+
+			if ((opcode == kOpcodeDIV) && (op2 == 0.0f))
+				throw Common::Exception("NCSFile::o_div(): Divide by zero");
+
+			stack.push(calculate(opcode, op1z, op2));
+			stack.push(calculate(opcode, op1y, op2));
+			stack.push(calculate(opcode, op1x, op2));
+			break;
+		}
+
+		case kInstTypeFloatVector: {
+			if ((opcode != kOpcodeMUL) && (opcode != kOpcodeDIV))
+				illegalType();
+
+			const float op2z = stack.popFloat();
+			const float op2y = stack.popFloat();
+			const float op2x = stack.popFloat();
+			const float op1  = stack.popFloat();
+
+			if ((opcode == kOpcodeDIV) && (op2x == 0.0f || op2y == 0.0f || op2z == 0.0f))
+				throw Common::Exception("NCSFile::o_div(): Divide by zero");
+
+			stack.push(calculate(opcode, op1, op2z));
+			stack.push(calculate(opcode, op1, op2y));
+			stack.push(calculate(opcode, op1, op2x));
+			break;
+		}
+
+		default:
+			illegalType();
+	}
+}
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
@@ -0,0 +1,336 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A decoded BioWare NWN Compiled Script.
+ */
+
+/* Based on the NCS specs by Torlack.
+ *
+ * Torlack's own site is down, but our docs repository hosts a
+ * a mirror (<https://github.com/xoreos/xoreos-docs>).
+ */
+
+#include <cassert>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/scopedptr.h"
+#include "src/common/readstream.h"
+#include "src/common/encoding.h"
+
+#include "src/aurora/nwscript/ncsprogram.h"
+
+static const uint32 kNCSTag    = MKTAG('N', 'C', 'S', ' ');
+static const uint32 kVersion10 = MKTAG('V', '1', '.', '0');
+
+namespace Aurora {
+
+namespace NWScript {
+
+const size_t NCSProgram::kInvalidTarget;
+
+NCSProgram::Instruction::Instruction() : address(0), opcode(kOpcodeNOP), type(kInstTypeNone),
+	constFloat(0.0f), target(kInvalidTarget), next(0) {
+
+	args[0] = args[1] = args[2] = 0;
+}
+
+
+NCSProgram::NCSProgram(Common::SeekableReadStream *ncs) : _endAddress(0) {
+	assert(ncs);
+
+	Common::ScopedPtr<Common::SeekableReadStream> stream(ncs);
+	load(*stream);
+}
+
+NCSProgram::NCSProgram(Common::SeekableReadStream &ncs) : _endAddress(0) {
+	load(ncs);
+}
+
+NCSProgram::~NCSProgram() {
+}
+
+size_t NCSProgram::size() const {
+	return _instructions.size();
+}
+
+const NCSProgram::Instruction &NCSProgram::operator[](size_t index) const {
+	assert(index < _instructions.size());
+
+	return _instructions[index];
+}
+
+const Common::UString &NCSProgram::getString(size_t index) const {
+	if (index >= _strings.size())
+		throw Common::Exception("NCSProgram::getString(): Index out of range (%u >= %u)",
+		                        (uint)index, (uint)_strings.size());
+
+	return _strings[index];
+}
+
+size_t NCSProgram::findInstruction(uint32 address) const {
+	if (address == _endAddress)
+		return _instructions.size();
+
+	// The instructions are sorted by address, so we can do a binary search
+	size_t low = 0, high = _instructions.size();
+	while (low < high) {
+		const size_t mid = low + (high - low) / 2;
+
+		if      (_instructions[mid].address < address)
+			low  = mid + 1;
+		else if (_instructions[mid].address > address)
+			high = mid;
+		else
+			return mid;
+	}
+
+	return kInvalidTarget;
+}
+
+size_t NCSProgram::getMemorySize() const {
+	size_t memSize = sizeof(NCSProgram) + _instructions.capacity() * sizeof(Instruction);
+
+	for (std::vector<Common::UString>::const_iterator s = _strings.begin(); s != _strings.end(); ++s)
+		memSize += sizeof(Common::UString) + s->size();
+
+	return memSize;
+}
+
+void NCSProgram::load(Common::SeekableReadStream &ncs) {
+	readHeader(ncs);
+
+	if (_id != kNCSTag)
+		throw Common::Exception("Try to load non-NCS file");
+
+	if (_version != kVersion10)
+		throw Common::Exception("Unsupported NCS file version %08X", _version);
+
+	byte lengthOpcode = ncs.readByte();
+	if (lengthOpcode != 0x42)
+		throw Common::Exception("Script size opcode != 0x42 (0x%02X)", lengthOpcode);
+
+	uint32 length = ncs.readUint32BE();
+	if (length > ((uint32) ncs.size()))
+		throw Common::Exception("Script size %u > stream size %u", length, (uint)ncs.size());
+	if (length < ((uint32) ncs.size()))
+		warning("TODO: NCSProgram::load(): Script size %u < stream size %u", length, (uint)ncs.size());
+
+	readInstructions(ncs);
+}
+
+/** Is this the address of the code a jump or a stored state goes to? */
+static bool isCodeAddress(int64 address, uint32 endAddress) {
+	return (address >= 0) && (address < endAddress);
+}
+
+void NCSProgram::readInstructions(Common::SeekableReadStream &ncs) {
+	_endAddress = ncs.size();
+
+	DecodedInstructions decoded;
+
+	std::vector<uint32> starts(1, ncs.pos());
+	while (!starts.empty()) {
+		const uint32 address = starts.back();
+		starts.pop_back();
+
+		readInstructions(ncs, address, decoded, starts);
+	}
+
+	_instructions.reserve(decoded.size());
+	for (DecodedInstructions::const_iterator i = decoded.begin(); i != decoded.end(); ++i)
+		_instructions.push_back(i->second.first);
+
+	resolveTargets(decoded);
+}
+
+void NCSProgram::readInstructions(Common::SeekableReadStream &ncs, uint32 address,
+                                  DecodedInstructions &decoded, std::vector<uint32> &starts) {
+
+	while (((_endAddress - address) >= 2) && (decoded.find(address) == decoded.end())) {
+		ncs.seek(address);
+
+		Instruction instr;
+
+		instr.address = address;
+		instr.opcode  = ncs.readByte();
+		instr.type    = ncs.readByte();
+
+		bool known = false;
+		try {
+			known = readOperands(ncs, instr);
+		} catch (...) {
+			// The instruction is truncated. Running into it ends the script
+			break;
+		}
+
+		decoded.insert(std::make_pair(address, std::make_pair(instr, (uint32) ncs.pos())));
+
+		// Jump offsets are relative to the start of the jump instruction
+		if ((instr.opcode == kOpcodeJMP) || (instr.opcode == kOpcodeJSR) ||
+		    (instr.opcode == kOpcodeJZ)  || (instr.opcode == kOpcodeJNZ))
+			if (isCodeAddress((int64) address + instr.args[0], _endAddress))
+				starts.push_back(address + instr.args[0]);
+
+		// The code of a stored state follows at an offset given in the type byte
+		if (instr.opcode == kOpcodeSTORESTATE)
+			if (isCodeAddress((int64) address + instr.type, _endAddress))
+				starts.push_back(address + instr.type);
+
+		/* We don't know how long an unknown instruction is, so we can't decode
+		 * any further from here. We keep it, though: executing it is an error. */
+		if (!known)
+			break;
+
+		address = ncs.pos();
+	}
+}
+
+bool NCSProgram::readOperands(Common::SeekableReadStream &ncs, Instruction &instr) {
+	switch (instr.opcode) {
+		case kOpcodeNOP:
+		case kOpcodeRSADD:
+		case kOpcodeLOGAND:
+		case kOpcodeLOGOR:
+		case kOpcodeINCOR:
+		case kOpcodeEXCOR:
+		case kOpcodeBOOLAND:
+		case kOpcodeGEQ:
+		case kOpcodeGT:
+		case kOpcodeLT:
+		case kOpcodeLEQ:
+		case kOpcodeSHLEFT:
+		case kOpcodeSHRIGHT:
+		case kOpcodeUSHRIGHT:
+		case kOpcodeADD:
+		case kOpcodeSUB:
+		case kOpcodeMUL:
+		case kOpcodeDIV:
+		case kOpcodeMOD:
+		case kOpcodeNEG:
+		case kOpcodeCOMP:
+		case kOpcodeSTORESTATEALL:
+		case kOpcodeRETN:
+		case kOpcodeNOT:
+		case kOpcodeSAVEBP:
+		case kOpcodeRESTOREBP:
+		case kOpcodeNOP2:
+			return true;
+
+		case kOpcodeCPDOWNSP:
+		case kOpcodeCPTOPSP:
+		case kOpcodeCPDOWNBP:
+		case kOpcodeCPTOPBP:
+		case kOpcodeWRITEARRAY:
+		case kOpcodeREADARRAY:
+		case kOpcodeGETREF:
+		case kOpcodeGETREFARRAY:
+			instr.args[0] = ncs.readSint32BE();
+			instr.args[1] = ncs.readSint16BE();
+			return true;
+
+		case kOpcodeMOVSP:
+		case kOpcodeJMP:
+		case kOpcodeJSR:
+		case kOpcodeJZ:
+		case kOpcodeJNZ:
+		case kOpcodeDECSP:
+		case kOpcodeINCSP:
+		case kOpcodeDECBP:
+		case kOpcodeINCBP:
+			instr.args[0] = ncs.readSint32BE();
+			return true;
+
+		case kOpcodeACTION:
+			instr.args[0] = ncs.readUint16BE();
+			instr.args[1] = ncs.readByte();
+			return true;
+
+		case kOpcodeEQ:
+		case kOpcodeNEQ:
+			// Comparisons between two structs (or two vectors) come with the size of the type
+			if (instr.type == kInstTypeStructStruct)
+				instr.args[0] = ncs.readUint16BE();
+			return true;
+
+		case kOpcodeDESTRUCT:
+			instr.args[0] = ncs.readSint16BE();
+			instr.args[1] = ncs.readSint16BE();
+			instr.args[2] = ncs.readSint16BE();
+			return true;
+
+		case kOpcodeSTORESTATE:
+			instr.args[0] = (int32) ncs.readUint32BE();
+			instr.args[1] = (int32) ncs.readUint32BE();
+			return true;
+
+		case kOpcodeCONST:
+			switch (instr.type) {
+				case kInstTypeInt:
+					instr.args[0] = ncs.readSint32BE();
+					return true;
+
+				case kInstTypeFloat:
+					instr.constFloat = ncs.readIEEEFloatBE();
+					return true;
+
+				case kInstTypeString:
+				case kInstTypeResource:
+					instr.args[0] = _strings.size();
+					_strings.push_back(Common::readStringFixed(ncs, Common::kEncodingASCII, ncs.readUint16BE()));
+					return true;
+
+				case kInstTypeObject:
+					instr.args[0] = (int32) ncs.readUint32BE();
+					return true;
+
+				default:
+					break;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	return false;
+}
+
+void NCSProgram::resolveTargets(const DecodedInstructions &decoded) {
+	DecodedInstructions::const_iterator d = decoded.begin();
+	for (Instructions::iterator i = _instructions.begin(); i != _instructions.end(); ++i, ++d) {
+		// Without a decoded instruction following it, the script ends here
+		i->next = findInstruction(d->second.second);
+		if (i->next == kInvalidTarget)
+			i->next = _instructions.size();
+
+		if ((i->opcode != kOpcodeJMP) && (i->opcode != kOpcodeJSR) &&
+		    (i->opcode != kOpcodeJZ)  && (i->opcode != kOpcodeJNZ))
+			continue;
+
+		// Jump offsets are relative to the start of the jump instruction
+		i->target = findInstruction(i->address + i->args[0]);
+	}
+}
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
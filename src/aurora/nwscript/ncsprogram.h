@@ -0,0 +1,257 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A decoded BioWare NWN Compiled Script.
+ */
+
+#ifndef AURORA_NWSCRIPT_NCSPROGRAM_H
+#define AURORA_NWSCRIPT_NCSPROGRAM_H
+
+#include <vector>
+#include <map>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/aurorafile.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+
+namespace NWScript {
+
+enum Opcode {
+	kOpcodeNOP           = 0x00, // Doesn't exist
+	kOpcodeCPDOWNSP      = 0x01,
+	kOpcodeRSADD         = 0x02,
+	kOpcodeCPTOPSP       = 0x03,
+	kOpcodeCONST         = 0x04,
+	kOpcodeACTION        = 0x05,
+	kOpcodeLOGAND        = 0x06,
+	kOpcodeLOGOR         = 0x07,
+	kOpcodeINCOR         = 0x08,
+	kOpcodeEXCOR         = 0x09,
+	kOpcodeBOOLAND       = 0x0A,
+	kOpcodeEQ            = 0x0B,
+	kOpcodeNEQ           = 0x0C,
+	kOpcodeGEQ           = 0x0D,
+	kOpcodeGT            = 0x0E,
+	kOpcodeLT            = 0x0F,
+	kOpcodeLEQ           = 0x10,
+	kOpcodeSHLEFT        = 0x11,
+	kOpcodeSHRIGHT       = 0x12,
+	kOpcodeUSHRIGHT      = 0x13,
+	kOpcodeADD           = 0x14,
+	kOpcodeSUB           = 0x15,
+	kOpcodeMUL           = 0x16,
+	kOpcodeDIV           = 0x17,
+	kOpcodeMOD           = 0x18,
+	kOpcodeNEG           = 0x19,
+	kOpcodeCOMP          = 0x1A,
+	kOpcodeMOVSP         = 0x1B,
+	kOpcodeSTORESTATEALL = 0x1C,
+	kOpcodeJMP           = 0x1D,
+	kOpcodeJSR           = 0x1E,
+	kOpcodeJZ            = 0x1F,
+	kOpcodeRETN          = 0x20,
+	kOpcodeDESTRUCT      = 0x21,
+	kOpcodeNOT           = 0x22,
+	kOpcodeDECSP         = 0x23,
+	kOpcodeINCSP         = 0x24,
+	kOpcodeJNZ           = 0x25,
+	kOpcodeCPDOWNBP      = 0x26,
+	kOpcodeCPTOPBP       = 0x27,
+	kOpcodeDECBP         = 0x28,
+	kOpcodeINCBP         = 0x29,
+	kOpcodeSAVEBP        = 0x2A,
+	kOpcodeRESTOREBP     = 0x2B,
+	kOpcodeSTORESTATE    = 0x2C,
+	kOpcodeNOP2          = 0x2D, // Also a NOP
+	kOpcodeWRITEARRAY    = 0x30,
+	kOpcodeREADARRAY     = 0x32,
+	kOpcodeGETREF        = 0x37,
+	kOpcodeGETREFARRAY   = 0x39,
+
+	kOpcodeMAX           = 0x3A
+};
+
+enum InstructionType {
+	// Unary
+	kInstTypeNone        =  0,
+	kInstTypeDirect      =  1,
+	kInstTypeInt         =  3,
+	kInstTypeFloat       =  4,
+	kInstTypeString      =  5,
+	kInstTypeObject      =  6,
+	kInstTypeResource    = 96,
+	kInstTypeEngineType0 = 16, // NWN:     effect        DA: event
+	kInstTypeEngineType1 = 17, // NWN:     event         DA: location
+	kInstTypeEngineType2 = 18, // NWN:     location      DA: command
+	kInstTypeEngineType3 = 19, // NWN:     talent        DA: effect
+	kInstTypeEngineType4 = 20, // NWN:     itemproperty  DA: itemproperty
+	kInstTypeEngineType5 = 21, // Witcher: mod           DA: player
+
+	// Arrays
+	kInstTypeIntArray          = 64,
+	kInstTypeFloatArray        = 65,
+	kInstTypeStringArray       = 66,
+	kInstTypeObjectArray       = 67,
+	kInstTypeResourceArray     = 68,
+	kInstTypeEngineType0Array  = 80,
+	kInstTypeEngineType1Array  = 81,
+	kInstTypeEngineType2Array  = 82,
+	kInstTypeEngineType3Array  = 83,
+	kInstTypeEngineType4Array  = 84,
+	kInstTypeEngineType5Array  = 85,
+
+	// Binary
+	kInstTypeIntInt                 = 32,
+	kInstTypeFloatFloat             = 33,
+	kInstTypeObjectObject           = 34,
+	kInstTypeStringString           = 35,
+	kInstTypeStructStruct           = 36,
+	kInstTypeIntFloat               = 37,
+	kInstTypeFloatInt               = 38,
+	kInstTypeEngineType0EngineType0 = 48,
+	kInstTypeEngineType1EngineType1 = 49,
+	kInstTypeEngineType2EngineType2 = 50,
+	kInstTypeEngineType3EngineType3 = 51,
+	kInstTypeEngineType4EngineType4 = 52,
+	kInstTypeEngineType5EngineType5 = 53,
+	kInstTypeVectorVector           = 58,
+	kInstTypeVectorFloat            = 59,
+	kInstTypeFloatVector            = 60
+};
+
+/** A decoded NCS, BioWare's NWN Compile Script.
+ *
+ *  The bytecode is decoded once into an array of instructions, sorted by
+ *  address. Decoding runs linearly from the start of the script, and again
+ *  from the target of every jump, subroutine call and stored state, until
+ *  it meets already decoded code. Junk bytes the script never executes
+ *  therefore don't cut off the code behind them.
+ *
+ *  All operands are read up-front, string constants are collected into a
+ *  table and the targets of all jumps and subroutine calls, as well as the
+ *  instruction following each instruction, are resolved into indices.
+ *
+ *  An NCSProgram is immutable after loading, so one program can be shared
+ *  by any number of script executions. See NCSRegistry.
+ */
+class NCSProgram : public AuroraFile {
+public:
+	/** Marker for a jump target that doesn't point to an instruction. */
+	static const size_t kInvalidTarget = SIZE_MAX;
+
+	struct Instruction {
+		uint32 address; ///< Byte offset of the instruction within the NCS.
+
+		byte opcode; ///< The instruction's opcode.
+		byte type;   ///< The instruction's type byte.
+
+		/** The integer operands, in the order they appear in the bytecode.
+		 *
+		 *  For string CONSTs, args[0] is an index into the string table.
+		 */
+		int32 args[3];
+		/** The float operand of a float CONST. */
+		float constFloat;
+
+		/** Index of the instruction a JMP, JSR, JZ or JNZ jumps to.
+		 *
+		 *  Equal to the number of instructions if the jump goes to the very
+		 *  end of the script, and kInvalidTarget if it doesn't hit the start
+		 *  of any instruction.
+		 */
+		size_t target;
+
+		/** Index of the instruction following this one.
+		 *
+		 *  Equal to the number of instructions if the script ends after this
+		 *  instruction, either at the end of the script or before a truncated
+		 *  instruction.
+		 */
+		size_t next;
+
+		Instruction();
+	};
+
+	/** Take over this stream and decode the NCS within. */
+	NCSProgram(Common::SeekableReadStream *ncs);
+	/** Decode the NCS within this stream. */
+	NCSProgram(Common::SeekableReadStream &ncs);
+	~NCSProgram();
+
+	/** Return the number of decoded instructions. */
+	size_t size() const;
+
+	/** Return the instruction at this index. */
+	const Instruction &operator[](size_t index) const;
+
+	/** Return a string constant. */
+	const Common::UString &getString(size_t index) const;
+
+	/** Find the instruction starting at this byte offset.
+	 *
+	 *  @return The index of the instruction, the number of instructions if the
+	 *          offset is the end of the script, or kInvalidTarget if the offset
+	 *          doesn't point to the start of an instruction.
+	 */
+	size_t findInstruction(uint32 address) const;
+
+	/** Return the approximate amount of memory this program occupies, in bytes. */
+	size_t getMemorySize() const;
+
+private:
+	typedef std::vector<Instruction> Instructions;
+
+	Instructions _instructions;
+	std::vector<Common::UString> _strings;
+
+	/** Byte offset of the end of the script. */
+	uint32 _endAddress;
+
+	/** Decoded instructions, by address, with the address following each one. */
+	typedef std::map<uint32, std::pair<Instruction, uint32> > DecodedInstructions;
+
+	void load(Common::SeekableReadStream &ncs);
+	void readInstructions(Common::SeekableReadStream &ncs);
+	void resolveTargets(const DecodedInstructions &decoded);
+
+	/** Decode linearly from this address, until running into already decoded instructions.
+	 *
+	 *  The addresses of code referenced by the decoded instructions are added to starts.
+	 */
+	void readInstructions(Common::SeekableReadStream &ncs, uint32 address,
+	                      DecodedInstructions &decoded, std::vector<uint32> &starts);
+
+	/** Read the operands of an instruction. Return false if the opcode is unknown. */
+	bool readOperands(Common::SeekableReadStream &ncs, Instruction &instr);
+};
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
+
+#endif // AURORA_NWSCRIPT_NCSPROGRAM_H
@@ -0,0 +1,159 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  The global registry of decoded NWN Compiled Scripts.
+ */
+
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+
+#include "src/aurora/resman.h"
+
+#include "src/aurora/nwscript/ncsreg.h"
+#include "src/aurora/nwscript/ncsprogram.h"
+
+DECLARE_SINGLETON(Aurora::NWScript::NCSRegistry)
+
+static const size_t kDefaultMaxSize = 32 * 1024 * 1024;
+
+namespace Aurora {
+
+namespace NWScript {
+
+NCSRegistry::NCSRegistry() : _size(0), _maxSize(kDefaultMaxSize), _resourceGeneration(0) {
+}
+
+NCSRegistry::~NCSRegistry() {
+}
+
+void NCSRegistry::clear() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	clearInternal();
+}
+
+void NCSRegistry::clearInternal() {
+	_entryMap.clear();
+	_entries.clear();
+
+	_size = 0;
+}
+
+NCSRegistry::ProgramPtr NCSRegistry::get(const Common::UString &name) {
+	Common::UString lowerName = name;
+	lowerName.makeLower();
+
+	// The ResourceManager generation the program is going to be loaded in
+	uint32 generation;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// Any change in the resources might have changed what a script name refers to
+		generation = ResMan.getGeneration();
+		if (_resourceGeneration != generation) {
+			clearInternal();
+
+			_resourceGeneration = generation;
+		}
+
+		EntryMap::iterator entry = _entryMap.find(lowerName);
+		if (entry != _entryMap.end()) {
+			// Entry exists => mark as most recently used and return
+			_entries.splice(_entries.begin(), _entries, entry->second);
+
+			return entry->second->program;
+		}
+	}
+
+	// Entry doesn't exist => load and add
+
+	ProgramPtr program = load(name);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	/* The resources changed while we were loading, and the program might
+	 * have been loaded from stale resources. Use it, but don't cache it. */
+	if ((_resourceGeneration != generation) || (ResMan.getGeneration() != generation))
+		return program;
+
+	// Someone else might have been quicker
+	EntryMap::iterator entry = _entryMap.find(lowerName);
+	if (entry != _entryMap.end())
+		return entry->second->program;
+
+	_entries.push_front(Entry());
+
+	_entries.front().name    = lowerName;
+	_entries.front().program = program;
+	_entries.front().size    = program->getMemorySize();
+
+	_entryMap.insert(std::make_pair(lowerName, _entries.begin()));
+	_size += _entries.front().size;
+
+	shrink();
+
+	return program;
+}
+
+void NCSRegistry::setMaxSize(size_t maxSize) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_maxSize = maxSize;
+
+	shrink();
+}
+
+size_t NCSRegistry::getMaxSize() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _maxSize;
+}
+
+size_t NCSRegistry::getSize() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _size;
+}
+
+void NCSRegistry::shrink() {
+	// Drop the least recently used programs, but always keep the most recent one
+	while ((_size > _maxSize) && (_entries.size() > 1)) {
+		const Entry &entry = _entries.back();
+
+		_size -= entry.size;
+
+		_entryMap.erase(entry.name);
+		_entries.pop_back();
+	}
+}
+
+NCSRegistry::ProgramPtr NCSRegistry::load(const Common::UString &name) {
+	Common::SeekableReadStream *ncs = ResMan.getResource(name, kFileTypeNCS);
+	if (!ncs)
+		throw Common::Exception("No such NCS \"%s\"", name.c_str());
+
+	return ProgramPtr(new NCSProgram(ncs));
+}
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
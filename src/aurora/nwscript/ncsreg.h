@@ -0,0 +1,117 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  The global registry of decoded NWN Compiled Scripts.
+ */
+
+#ifndef AURORA_NWSCRIPT_NCSREG_H
+#define AURORA_NWSCRIPT_NCSREG_H
+
+#include <list>
+#include <map>
+
+#include <boost/shared_ptr.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/singleton.h"
+#include "src/common/mutex.h"
+
+namespace Aurora {
+
+namespace NWScript {
+
+class NCSProgram;
+
+/** The global NCS registry, caching decoded scripts.
+ *
+ *  Scripts are run very often, on every heartbeat and on every
+ *  perception event, for example. Instead of loading and decoding
+ *  the NCS out of the ResourceManager every time, NCSFile gets its
+ *  immutable, decoded NCSProgram from this registry.
+ *
+ *  The registry is bounded by the approximate memory size of all
+ *  the programs it holds. When that size is exceeded, the programs
+ *  that have been used least recently are dropped. Programs that
+ *  are still in use by a running script stay alive until that
+ *  script has finished.
+ *
+ *  Whenever resources are added to or removed from the Resource-
+ *  Manager (for example by undoing the ChangeID of an indexed
+ *  archive), the whole registry is invalidated.
+ */
+class NCSRegistry : public Common::Singleton<NCSRegistry> {
+public:
+	typedef boost::shared_ptr<const NCSProgram> ProgramPtr;
+
+	NCSRegistry();
+	~NCSRegistry();
+
+	/** Drop all cached programs. */
+	void clear();
+
+	/** Get a certain script, loading and decoding it if necessary. */
+	ProgramPtr get(const Common::UString &name);
+
+	/** Set the maximum size of all cached programs, in bytes. */
+	void setMaxSize(size_t maxSize);
+
+	/** Return the maximum size of all cached programs, in bytes. */
+	size_t getMaxSize() const;
+	/** Return the current size of all cached programs, in bytes. */
+	size_t getSize() const;
+
+private:
+	struct Entry {
+		Common::UString name;
+		ProgramPtr program;
+		size_t size;
+	};
+
+	/** All cached programs, the one used most recently first. */
+	typedef std::list<Entry> EntryList;
+	typedef std::map<Common::UString, EntryList::iterator> EntryMap;
+
+	EntryList _entries;
+	EntryMap  _entryMap;
+
+	size_t _size;
+	size_t _maxSize;
+
+	/** The ResourceManager generation our programs were loaded in. */
+	uint32 _resourceGeneration;
+
+	mutable std::mutex _mutex;
+
+	void clearInternal();
+	void shrink();
+
+	static ProgramPtr load(const Common::UString &name);
+};
+
+} // End of namespace NWScript
+
+} // End of namespace Aurora
+
+/** Shortcut for accessing the NCS registry. */
+#define NCSReg ::Aurora::NWScript::NCSRegistry::instance()
+
+#endif // AURORA_NWSCRIPT_NCSREG_H
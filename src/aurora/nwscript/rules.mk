@@ -32,6 +32,8 @@ src_aurora_nwscript_libnwscript_la_SOURCES += \
     src/aurora/nwscript/object.h \
     src/aurora/nwscript/objectcontainer.h \
     src/aurora/nwscript/functionman.h \
+    src/aurora/nwscript/ncsprogram.h \
+    src/aurora/nwscript/ncsreg.h \
     src/aurora/nwscript/ncsfile.h \
     src/aurora/nwscript/objectref.h \
     src/aurora/nwscript/objectman.h \
@@ -44,7 +46,10 @@ src_aurora_nwscript_libnwscript_la_SOURCES += \
     src/aurora/nwscript/functioncontext.cpp \
     src/aurora/nwscript/objectcontainer.cpp \
     src/aurora/nwscript/functionman.cpp \
+    src/aurora/nwscript/ncsprogram.cpp \
+    src/aurora/nwscript/ncsreg.cpp \
     src/aurora/nwscript/ncsfile.cpp \
+    src/aurora/nwscript/ncsfile_threaded.cpp \
     src/aurora/nwscript/objectref.cpp \
     src/aurora/nwscript/objectman.cpp \
     $(EMPTY)
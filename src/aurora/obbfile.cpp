@@ -191,6 +191,9 @@ Common::SeekableReadStream *OBBFile::getResource(uint32 index, bool UNUSED(tryNo
 
 	const IResource &res = getIResource(index);
 
+	// The chunks are read by seeking in the shared OBB stream
+	std::lock_guard<std::mutex> lock(_streamMutex);
+
 	_obb->seek(res.offset);
 
 	Common::ScopedArray<byte> data(new byte[res.uncompressedSize]);
@@ -54,6 +54,9 @@ Common::SeekableReadStream *PEFile::getResource(uint32 index, bool UNUSED(tryNoC
 
 	std::advance(iter, index);
 
+	// The PE resources are read by seeking in the shared EXE stream
+	std::lock_guard<std::mutex> lock(_streamMutex);
+
 	switch (iter->type) {
 		case kFileTypeBMP: {
 			Common::ScopedPtr<Common::SeekableReadStream> stream(_peFile->getResource(Common::kPEBitmap, _peIDs.at(index)));
@@ -0,0 +1,261 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A persistent cache of the resource indices of archives.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include "src/common/util.h"
+#include "src/common/scopedptr.h"
+#include "src/common/error.h"
+#include "src/common/filepath.h"
+#include "src/common/memreadstream.h"
+#include "src/common/readfile.h"
+#include "src/common/writefile.h"
+
+#include "src/aurora/resindexcache.h"
+
+/** Identifies a resource index cache file. */
+static const uint32 kCacheID      = MKTAG('X', 'R', 'I', 'C');
+/** The version of the cache file format. Files with other versions are ignored. */
+static const uint32 kCacheVersion = 1;
+
+/** The smallest possible size of an entry record: empty path, settings, file count. */
+static const size_t kEntryMinSize    = 4 + 4 + 4;
+/** The smallest possible size of a file record: empty name and path, size, time, resource count. */
+static const size_t kFileMinSize     = 4 + 4 + 8 + 8 + 4;
+/** The smallest possible size of a resource record: empty name, type, small flag, index, hash. */
+static const size_t kResourceMinSize = 4 + 4 + 1 + 4 + 8;
+
+namespace Aurora {
+
+ResourceIndexCache::Resource::Resource() : type(kFileTypeNone), isSmall(false), index(0xFFFFFFFF), hash(0) {
+}
+
+
+ResourceIndexCache::File::File() : size(0), time(0) {
+}
+
+void ResourceIndexCache::File::readStatus() {
+	size = Common::FilePath::getFileSize(path);
+	time = Common::FilePath::getModificationTime(path);
+}
+
+bool ResourceIndexCache::File::isCurrent() const {
+	if ((size == Common::kFileInvalid) || (time == (std::time_t) -1))
+		return false;
+
+	return (Common::FilePath::getModificationTime(path) == time) &&
+	       (Common::FilePath::getFileSize(path) == size);
+}
+
+
+ResourceIndexCache::Entry::Entry() : settings(0) {
+}
+
+bool ResourceIndexCache::Entry::isCurrent(uint32 s) const {
+	if ((settings != s) || files.empty())
+		return false;
+
+	for (std::vector<File>::const_iterator f = files.begin(); f != files.end(); ++f)
+		if (!f->isCurrent())
+			return false;
+
+	return true;
+}
+
+
+ResourceIndexCache::ResourceIndexCache() : _changed(false) {
+}
+
+ResourceIndexCache::~ResourceIndexCache() {
+}
+
+void ResourceIndexCache::clear() {
+	_entries.clear();
+
+	_changed = false;
+}
+
+static Common::UString readString(Common::SeekableReadStream &stream, std::vector<char> &buffer) {
+	const uint32 length = stream.readUint32LE();
+	if (length > (stream.size() - stream.pos()))
+		throw Common::Exception(Common::kReadError);
+
+	buffer.resize(length + 1);
+	if (stream.read(&buffer[0], length) != length)
+		throw Common::Exception(Common::kReadError);
+
+	return Common::UString(&buffer[0], length);
+}
+
+/** Read the number of records to follow, making sure that many could even fit into the stream. */
+static uint32 readCount(Common::SeekableReadStream &stream, size_t recordSize) {
+	const uint32 count = stream.readUint32LE();
+	if (count > ((stream.size() - stream.pos()) / recordSize))
+		throw Common::Exception(Common::kReadError);
+
+	return count;
+}
+
+static void writeString(Common::WriteStream &stream, const Common::UString &string) {
+	// UString::size() counts code points, but we need the length in bytes
+	const size_t length = std::strlen(string.c_str());
+
+	stream.writeUint32LE(length);
+	if (stream.write(string.c_str(), length) != length)
+		throw Common::Exception(Common::kWriteError);
+}
+
+void ResourceIndexCache::load(Common::SeekableReadStream &stream) {
+	_entries.clear();
+	_changed = false;
+
+	if ((stream.size() < 8) || (stream.readUint32BE() != kCacheID))
+		throw Common::Exception("Not a resource index cache");
+
+	// An older or newer version: ignore it, it will be rebuilt
+	if (stream.readUint32LE() != kCacheVersion)
+		return;
+
+	std::vector<char> buffer;
+
+	const uint32 entryCount = readCount(stream, kEntryMinSize);
+	for (uint32 i = 0; i < entryCount; i++) {
+		const Common::UString path = readString(stream, buffer);
+
+		Entry &entry = _entries[path];
+
+		entry.settings = stream.readUint32LE();
+		entry.files.resize(readCount(stream, kFileMinSize));
+
+		for (std::vector<File>::iterator f = entry.files.begin(); f != entry.files.end(); ++f) {
+			f->name = readString(stream, buffer);
+			f->path = readString(stream, buffer);
+			f->size = stream.readUint64LE();
+			f->time = (std::time_t) stream.readSint64LE();
+
+			f->resources.resize(readCount(stream, kResourceMinSize));
+
+			for (std::vector<Resource>::iterator r = f->resources.begin(); r != f->resources.end(); ++r) {
+				r->name    = readString(stream, buffer);
+				r->type    = (FileType) stream.readSint32LE();
+				r->isSmall = stream.readByte() != 0;
+				r->index   = stream.readUint32LE();
+				r->hash    = stream.readUint64LE();
+			}
+		}
+	}
+
+	// A cache file that was cut short
+	if (stream.readUint32BE() != kCacheID)
+		throw Common::Exception("Resource index cache is truncated");
+}
+
+void ResourceIndexCache::save(Common::WriteStream &stream) const {
+	stream.writeUint32BE(kCacheID);
+	stream.writeUint32LE(kCacheVersion);
+
+	stream.writeUint32LE(_entries.size());
+	for (EntryMap::const_iterator e = _entries.begin(); e != _entries.end(); ++e) {
+		writeString(stream, e->first);
+
+		stream.writeUint32LE(e->second.settings);
+		stream.writeUint32LE(e->second.files.size());
+
+		for (std::vector<File>::const_iterator f = e->second.files.begin(); f != e->second.files.end(); ++f) {
+			writeString(stream, f->name);
+			writeString(stream, f->path);
+			stream.writeUint64LE(f->size);
+			stream.writeSint64LE(f->time);
+
+			stream.writeUint32LE(f->resources.size());
+
+			for (std::vector<Resource>::const_iterator r = f->resources.begin(); r != f->resources.end(); ++r) {
+				writeString(stream, r->name);
+				stream.writeSint32LE(r->type);
+				stream.writeByte(r->isSmall ? 1 : 0);
+				stream.writeUint32LE(r->index);
+				stream.writeUint64LE(r->hash);
+			}
+		}
+	}
+
+	stream.writeUint32BE(kCacheID);
+}
+
+void ResourceIndexCache::load(const Common::UString &fileName) {
+	_entries.clear();
+	_changed = false;
+
+	if (!Common::FilePath::isRegularFile(fileName))
+		return;
+
+	try {
+		Common::ReadFile file(fileName);
+		Common::ScopedPtr<Common::MemoryReadStream> data(file.readStream(file.size()));
+
+		load(*data);
+
+	} catch (...) {
+		_entries.clear();
+
+		Common::exceptionDispatcherWarning("Ignoring broken resource index cache \"%s\"", fileName.c_str());
+	}
+}
+
+void ResourceIndexCache::save(const Common::UString &fileName) {
+	if (!_changed)
+		return;
+
+	Common::FilePath::createDirectories(Common::FilePath::getDirectory(fileName));
+
+	Common::WriteFile file(fileName);
+
+	save(file);
+
+	file.flush();
+	file.close();
+
+	_changed = false;
+}
+
+const ResourceIndexCache::Entry *ResourceIndexCache::find(const Common::UString &path) const {
+	EntryMap::const_iterator entry = _entries.find(path);
+	if (entry == _entries.end())
+		return 0;
+
+	return &entry->second;
+}
+
+void ResourceIndexCache::set(const Common::UString &path, const Entry &entry) {
+	_entries[path] = entry;
+
+	_changed = true;
+}
+
+bool ResourceIndexCache::isChanged() const {
+	return _changed;
+}
+
+} // End of namespace Aurora
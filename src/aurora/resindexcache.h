@@ -0,0 +1,147 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A persistent cache of the resource indices of archives.
+ */
+
+#ifndef AURORA_RESINDEXCACHE_H
+#define AURORA_RESINDEXCACHE_H
+
+#include <ctime>
+#include <vector>
+#include <map>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/types.h"
+
+namespace Common {
+	class SeekableReadStream;
+	class WriteStream;
+}
+
+namespace Aurora {
+
+/** A persistent cache of the resource indices of archives.
+ *
+ *  Indexing an archive means opening it, reading its directory and hashing
+ *  all resource names. For a game with hundreds of archives, that adds up
+ *  to seconds on every start. The cache records, for each indexed archive,
+ *  the resources the ResourceManager added for it, together with the size
+ *  and modification time of every file involved. As long as all these files
+ *  are unchanged, the ResourceManager can add the recorded resources
+ *  directly, and only open the archives once a resource is read from them.
+ *
+ *  The cache is stored in a single versioned binary file, read in one go.
+ *  A cache file that is broken, or has a different version, is ignored.
+ */
+class ResourceIndexCache : boost::noncopyable {
+public:
+	/** A resource as the ResourceManager added it to its index. */
+	struct Resource {
+		Common::UString name;    ///< The resource's name.
+		FileType        type;    ///< The resource's type.
+		bool            isSmall; ///< Is this a "small" (compressed Nintendo DS) file?
+		uint32          index;   ///< The resource's index within its archive.
+		uint64          hash;    ///< The resource's hashed name.
+
+		Resource();
+	};
+
+	/** A file that was read to index an archive. */
+	struct File {
+		Common::UString name; ///< The name the file was referenced by.
+		Common::UString path; ///< The full path to the file.
+
+		uint64      size; ///< The size of the file.
+		std::time_t time; ///< The modification time of the file.
+
+		/** The resources indexed from this file. */
+		std::vector<Resource> resources;
+
+		File();
+
+		/** Read the size and modification time of the file on disk. */
+		void readStatus();
+
+		/** Is the file on disk still the same size and modification time? */
+		bool isCurrent() const;
+	};
+
+	/** An indexed archive.
+	 *
+	 *  The first file is always the archive itself. Archives that reference
+	 *  other files, like a KEY referencing BIFs, add one file for each of them.
+	 */
+	struct Entry {
+		/** Fingerprint of the ResourceManager settings the resources were indexed with. */
+		uint32 settings;
+
+		std::vector<File> files; ///< All files read to index the archive.
+
+		Entry();
+
+		/** Is this entry indexed with these settings, and are all its files unchanged? */
+		bool isCurrent(uint32 s) const;
+	};
+
+	ResourceIndexCache();
+	~ResourceIndexCache();
+
+	/** Remove all entries, without marking the cache as changed. */
+	void clear();
+
+	/** Replace the cache with the contents of this cache file.
+	 *
+	 *  If the file doesn't exist, is broken or has an unknown version,
+	 *  the cache is left empty.
+	 */
+	void load(const Common::UString &fileName);
+	/** Write the cache into this file, if it has been changed. */
+	void save(const Common::UString &fileName);
+
+	/** Read the cache from this stream. Throws on a broken stream. */
+	void load(Common::SeekableReadStream &stream);
+	/** Write the cache into this stream. */
+	void save(Common::WriteStream &stream) const;
+
+	/** Return the entry for the archive at this path, or 0 if there is none. */
+	const Entry *find(const Common::UString &path) const;
+	/** Set the entry for the archive at this path. */
+	void set(const Common::UString &path, const Entry &entry);
+
+	/** Has the cache been changed since it was loaded or saved? */
+	bool isChanged() const;
+
+private:
+	typedef std::map<Common::UString, Entry> EntryMap;
+
+	EntryMap _entries;
+
+	bool _changed;
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_RESINDEXCACHE_H
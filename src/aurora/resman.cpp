@@ -23,8 +23,12 @@
  */
 
 #include <cassert>
+#include <cstring>
+
+#include <algorithm>
 
 #include <boost/scope_exit.hpp>
+#include <boost/functional/hash.hpp>
 
 #include "src/common/util.h"
 #include "src/common/scopedptr.h"
@@ -32,6 +36,7 @@
 #include "src/common/readstream.h"
 #include "src/common/filepath.h"
 #include "src/common/readfile.h"
+#include "src/common/mappedfile.h"
 #include "src/common/writefile.h"
 
 #include "src/aurora/resman.h"
@@ -58,12 +63,12 @@ DECLARE_SINGLETON(Aurora::ResourceManager)
 namespace Aurora {
 
 ResourceManager::KnownArchive::KnownArchive() :
-	type(kArchiveMAX), resource(0), opened(0) {
+	type(kArchiveMAX), resource(kResourceNone), opened(0) {
 
 }
 
-ResourceManager::KnownArchive::KnownArchive(ArchiveType t, const Common::UString &n, Resource &r) :
-	name(n), type(t), resource(&r), opened(0) {
+ResourceManager::KnownArchive::KnownArchive(ArchiveType t, const Common::UString &n, uint32 r) :
+	name(n), lowerName(n.toLower()), type(t), resource(r), opened(0) {
 
 }
 
@@ -71,8 +76,8 @@ ResourceManager::KnownArchive::KnownArchive(ArchiveType t, const Common::UString
 ResourceManager::OpenedArchive::OpenedArchive() : archive(0), known(0), parent(0) {
 }
 
-void ResourceManager::OpenedArchive::set(KnownArchive &kA, Archive &a) {
-	archive = &a;
+void ResourceManager::OpenedArchive::set(KnownArchive &kA, Archive *a, const Resource &resource) {
+	archive = a;
 	known   = &kA;
 
 	if (known->opened)
@@ -85,20 +90,19 @@ void ResourceManager::OpenedArchive::set(KnownArchive &kA, Archive &a) {
 	 * child-archives still open.
 	 */
 
-	assert(known->resource);
-	if (known->resource->source == kSourceArchive) {
-		assert(known->resource->archive);
+	if (resource.source == kSourceArchive) {
+		assert(resource.archive);
 
-		parent = known->resource->archive;
+		parent = resource.archive;
 		parent->children.push_back(this);
 	}
 }
 
 
-ResourceManager::Resource::Resource() : type(kFileTypeNone), isSmall(false), priority(0),
-		source(kSourceNone), archive(0), archiveIndex(0xFFFFFFFF) {
+ResourceManager::Resource::Resource() : hash(0), name(0), type(kFileTypeNone), isSmall(false), priority(0),
+		shadowed(kResourceNone), selfArchive(0), source(kSourceNone), path(0), archive(0),
+		archiveIndex(0xFFFFFFFF) {
 
-	selfArchive.first = 0;
 }
 
 bool ResourceManager::Resource::operator<(const Resource &right) const {
@@ -107,7 +111,11 @@ bool ResourceManager::Resource::operator<(const Resource &right) const {
 
 
 ResourceManager::ResourceManager() : _hasSmall(false),
-	_hashAlgo(Common::kHashFNV64) {
+	_hashAlgo(Common::kHashFNV64), _resourceTableUsed(0), _resourceHashes(0),
+	_nameRefs(0, NameHash(_names), NameEquals(_names)), _deadNames(0), _generation(0),
+	_rebuildIndexCache(false), _archiveOpenCount(0) {
+
+	clearResourceTable();
 
 	// These file types are archives
 
@@ -171,10 +179,15 @@ ResourceManager::ResourceManager() : _hasSmall(false),
 }
 
 ResourceManager::~ResourceManager() {
-	clearResources();
+	try {
+		clearResources();
+	} catch (...) {
+	}
 }
 
 void ResourceManager::clear() {
+	Common::WriteLock lock(_lock);
+
 	_typeAliases.clear();
 
 	_hasSmall = false;
@@ -185,6 +198,11 @@ void ResourceManager::clear() {
 }
 
 void ResourceManager::clearResources() {
+	saveIndexCache();
+
+	_indexCache.clear();
+	_indexCacheFile.clear();
+
 	_cursorRemap.clear();
 
 	_baseDir.clear();
@@ -193,16 +211,22 @@ void ResourceManager::clearResources() {
 	for (size_t i = 0; i < kArchiveMAX; i++)
 		_knownArchives[i].clear();
 
+	_decompressedCache.clear();
+
 	for (OpenedArchives::iterator a = _openedArchives.begin(); a != _openedArchives.end(); ++a)
-		delete a->archive;
+		delete a->archive.load();
 	_openedArchives.clear();
 
-	_resources.clear();
+	clearResourceTable();
 
 	_changes.clear();
+
+	_generation++;
 }
 
 void ResourceManager::setRIMsAreERFs(bool rimsAreERFs) {
+	Common::WriteLock lock(_lock);
+
 	// Treat RIM and RIMP as either RIM or ERF
 
 	_archiveTypeTypes[kArchiveRIM].erase(kFileTypeRIM);
@@ -220,21 +244,29 @@ void ResourceManager::setRIMsAreERFs(bool rimsAreERFs) {
 }
 
 void ResourceManager::setHasSmall(bool hasSmall) {
+	Common::WriteLock lock(_lock);
+
 	_hasSmall = hasSmall;
 }
 
 void ResourceManager::setHashAlgo(Common::HashAlgo algo) {
-	if ((algo != _hashAlgo) && !_resources.empty())
+	Common::WriteLock lock(_lock);
+
+	if ((algo != _hashAlgo) && (_resourceHashes != 0))
 		throw Common::Exception("ResourceManager::setHashAlgo(): We already have resources!");
 
 	_hashAlgo = algo;
 }
 
 void ResourceManager::setCursorRemap(const std::vector<Common::UString> &remap) {
+	Common::WriteLock lock(_lock);
+
 	_cursorRemap = remap;
 }
 
 void ResourceManager::registerDataBase(const Common::UString &path) {
+	Common::WriteLock lock(_lock);
+
 	clearResources();
 
 	Common::UString base = Common::FilePath::canonicalize(path);
@@ -243,12 +275,14 @@ void ResourceManager::registerDataBase(const Common::UString &path) {
 
 		_baseDir = base;
 
+		loadIndexCache();
 		indexResourceDir("", 0, 0, 1);
 
 	} else if (Common::FilePath::isRegularFile(base)) {
 
 		_baseArchive = base;
 
+		loadIndexCache();
 		indexResourceFile(_baseArchive, 1);
 		indexArchive     (_baseArchive, 1);
 
@@ -276,33 +310,55 @@ ResourceManager::KnownArchive *ResourceManager::findArchive(Common::UString file
 	file = (Common::FilePath::isPOSIXAbsolute(file) ? "" : "/") + file;
 	file = Common::FilePath::normalize(file, false).toLower();
 
+	// BZF archives are still indexed as BIF in the KEY file
+	const Common::UString bzfFile = Common::FilePath::getExtension(file).equalsIgnoreCase(".bif") ?
+		Common::FilePath::changeExtension(file, ".bzf") : "";
+
 	for (KnownArchives::iterator a = archives.begin(); a != archives.end(); ++a) {
-		if (a->name.toLower().endsWith(file))
+		if (a->lowerName.endsWith(file))
 			return &*a;
 
-		// BZF archives are still indexed as BIF in the KEY file
-		if (Common::FilePath::getExtension(file).equalsIgnoreCase(".bif"))
-			if (a->name.toLower().endsWith(Common::FilePath::changeExtension(file, ".bzf")))
-				return &*a;
+		if (!bzfFile.empty() && a->lowerName.endsWith(bzfFile))
+			return &*a;
 	}
 
 	return 0;
 }
 
 bool ResourceManager::hasArchive(const Common::UString &file) {
+	Common::ReadLock lock(_lock);
+
 	return findArchive(file) != 0;
 }
 
 Common::SeekableReadStream *ResourceManager::openArchiveStream(const KnownArchive &archive) const {
-	if (!archive.resource)
+	const Resource *resource = getResourceRecord(archive);
+	if (!resource)
 		throw Common::Exception("Archive without resource reference");
 
-	return getResource(*archive.resource, true);
+	_archiveOpenCount++;
+
+	/* Map plain KEY, BIF, ERF and RIM files directly into memory. Their resources
+	 * can then be read without any copying or seeking in the archive file. */
+	const bool canMap = (archive.type == kArchiveKEY) || (archive.type == kArchiveBIF) ||
+	                    (archive.type == kArchiveERF) || (archive.type == kArchiveRIM);
+
+	if (canMap && (resource->source == kSourceFile) && !resource->isSmall) {
+		try {
+			return new Common::MappedReadStream(getName(resource->path));
+		} catch (...) {
+			// Fall back to reading the file normally
+		}
+	}
+
+	return getResource(*resource, true);
 }
 
 void ResourceManager::indexArchive(const Common::UString &file, uint32 priority,
                                    const std::vector<byte> &password, Common::ChangeID *changeID) {
 
+	Common::WriteLock lock(_lock);
+
 	KnownArchive *knownArchive = findArchive(file);
 	if (!knownArchive)
 		throw Common::Exception("No such archive file \"%s\"", file.c_str());
@@ -314,48 +370,74 @@ void ResourceManager::indexArchive(const Common::UString &file, uint32 priority,
 	if (changeID)
 		change = newChangeSet(*changeID);
 
-	Common::SeekableReadStream *archiveStream = openArchiveStream(*knownArchive);
+	if (indexCachedArchive(*knownArchive, priority, password, change))
+		return;
 
-	Common::ScopedPtr<Archive> archive;
-	switch (knownArchive->type) {
-		case kArchiveKEY:
-			indexKEY(archiveStream, priority, change);
-			break;
+	ResourceIndexCache::Entry indexed;
+	indexed.files.resize(1);
+
+	if (knownArchive->type == kArchiveKEY)
+		indexKEY(openArchiveStream(*knownArchive), priority, change, indexed);
+	else
+		indexArchive(*knownArchive, openArchive(*knownArchive, password), priority, change, indexed.files.back());
+
+	addIndexCacheEntry(*knownArchive, indexed);
+}
+
+Archive *ResourceManager::openArchive(const KnownArchive &archive, const std::vector<byte> &password) const {
+	switch (archive.type) {
+		case kArchiveBIF:
+			// Without its KEY, a BIF has no resource names, but we only need to read by index
+			if (Common::FilePath::getExtension(archive.name).equalsIgnoreCase(".bzf"))
+				return new BZFFile(openArchiveStream(archive));
+
+			return new BIFFile(openArchiveStream(archive));
 
 		case kArchiveNDS:
-			archive.reset(new NDSFile(archiveStream));
-			break;
+			return new NDSFile(openArchiveStream(archive));
 
 		case kArchiveHERF:
-			archive.reset(new HERFFile(archiveStream));
-			break;
+			return new HERFFile(openArchiveStream(archive));
 
 		case kArchiveERF:
-			archive.reset(new ERFFile(archiveStream, password));
-			break;
+			return new ERFFile(openArchiveStream(archive), password);
 
 		case kArchiveRIM:
-			archive.reset(new RIMFile(archiveStream));
-			break;
+			return new RIMFile(openArchiveStream(archive));
 
 		case kArchiveZIP:
-			archive.reset(new ZIPFile(archiveStream));
-			break;
+			return new ZIPFile(openArchiveStream(archive));
 
 		case kArchiveEXE:
-			archive.reset(new PEFile(archiveStream, _cursorRemap));
-			break;
+			return new PEFile(openArchiveStream(archive), _cursorRemap);
 
 		case kArchiveNSBTX:
-			archive.reset(new NSBTXFile(archiveStream));
-			break;
+			return new NSBTXFile(openArchiveStream(archive));
 
 		default:
-			throw Common::Exception("Invalid archive type %d", knownArchive->type);
+			break;
+	}
+
+	throw Common::Exception("Invalid archive type %d", archive.type);
+}
+
+Archive *ResourceManager::getArchive(OpenedArchive &archive) const {
+	Archive *opened = archive.archive.load(std::memory_order_acquire);
+	if (opened)
+		return opened;
+
+	// Indexed from the cache and not opened yet. Several readers might try at once
+	std::lock_guard<std::recursive_mutex> lock(_openMutex);
+
+	opened = archive.archive.load(std::memory_order_relaxed);
+	if (!opened) {
+		assert(archive.known);
+
+		opened = openArchive(*archive.known, archive.password);
+		archive.archive.store(opened, std::memory_order_release);
 	}
 
-	if (archive)
-		indexArchive(*knownArchive, archive.release(), priority, change);
+	return opened;
 }
 
 void ResourceManager::indexArchive(const Common::UString &file, uint32 priority, Common::ChangeID *changeID) {
@@ -403,26 +485,76 @@ uint32 ResourceManager::openKEYBIFs(Common::SeekableReadStream *keyStream,
 	return archives.size();
 }
 
-void ResourceManager::indexKEY(Common::SeekableReadStream *stream, uint32 priority, Change *change) {
+void ResourceManager::indexKEY(Common::SeekableReadStream *stream, uint32 priority, Change *change,
+                               ResourceIndexCache::Entry &indexed) {
+
 	std::vector<KnownArchive *> archives;
 	std::vector<KEYDataFile *> keyData;
 
 	const uint32 count = openKEYBIFs(stream, archives, keyData);
 
-	for (uint32 i = 0; i < count; i++)
-		indexArchive(*archives[i], keyData[i], priority, change);
+	for (uint32 i = 0; i < count; i++) {
+		// Remember which BIF this is, so that we can find it again when indexing from the cache
+		indexed.files.push_back(ResourceIndexCache::File());
+		indexed.files.back().name = archives[i]->name;
+
+		const Resource *resource = getResourceRecord(*archives[i]);
+		if (resource && (resource->source == kSourceFile))
+			indexed.files.back().path = getName(resource->path);
+
+		indexArchive(*archives[i], keyData[i], priority, change, indexed.files.back());
+	}
 }
 
 void ResourceManager::indexArchive(KnownArchive &knownArchive, Archive *archive,
-                                   uint32 priority, Change *change) {
+                                   uint32 priority, Change *change, ResourceIndexCache::File &indexed) {
+
+	Common::ScopedPtr<Archive> archivePtr(archive);
 
 	const Common::HashAlgo hashAlgo = archive->getNameHashAlgo();
 	if ((hashAlgo != Common::kHashNone) && (hashAlgo != _hashAlgo))
 		throw Common::Exception("ResourceManager::indexArchive(): Archive uses a different name hashing "
 		                        "algorithm than we do (%d vs. %d)", (int) hashAlgo, (int) _hashAlgo);
 
+	const Archive::ResourceList &resources = archive->getResources();
+
+	indexed.resources.reserve(resources.size());
+	for (Archive::ResourceList::const_iterator resource = resources.begin(); resource != resources.end(); ++resource) {
+		// Build the resource record
+		indexed.resources.push_back(ResourceIndexCache::Resource());
+
+		ResourceIndexCache::Resource &record = indexed.resources.back();
+		record.name    = resource->name;
+		record.type    = resource->type;
+		record.isSmall = false;
+		record.index   = resource->index;
+
+		// Get the hash or calculate if we have to
+		record.hash = (hashAlgo == Common::kHashNone) ? getHash(record.name, record.type) : resource->hash;
+
+		// Normalize the file types if we can and recalculate the hash
+		if ((record.name != "") && (record.type != kFileTypeNone))
+			if (normalizeType(record.type))
+				record.hash = getHash(record.name, record.type);
+
+		// Handle "small" files
+		if (_hasSmall && (record.type == kFileTypeSMALL)) {
+			record.isSmall = true;
+
+			record.name = Common::FilePath::getStem(resource->name);
+			record.type = TypeMan.getFileType(resource->name);
+		}
+	}
+
+	addArchive(knownArchive, archivePtr.release(), std::vector<byte>(), indexed.resources, priority, change);
+}
+
+void ResourceManager::addArchive(KnownArchive &knownArchive, Archive *archive, const std::vector<byte> &password,
+                                 const std::vector<ResourceIndexCache::Resource> &resources,
+                                 uint32 priority, Change *change) {
+
 	bool couldSet = false;
-	_openedArchives.push_back(OpenedArchive());
+	_openedArchives.emplace_back();
 
 	BOOST_SCOPE_EXIT( (&couldSet) (&_openedArchives) (&archive) ) {
 		if (!couldSet) {
@@ -431,46 +563,158 @@ void ResourceManager::indexArchive(KnownArchive &knownArchive, Archive *archive,
 		}
 	} BOOST_SCOPE_EXIT_END
 
-	_openedArchives.back().set(knownArchive, *archive);
+	OpenedArchive &opened = _openedArchives.back();
+
+	const Resource *self = getResourceRecord(knownArchive);
+	if (!self)
+		throw Common::Exception("Archive without resource reference");
+
+	opened.set(knownArchive, archive, *self);
 	couldSet = true;
 
+	// An archive we haven't opened yet needs its password later
+	if (!archive)
+		opened.password = password;
+
 	// Add the information of the new archive to the change set
 	if (change)
 		change->_change->openedArchives.push_back(--_openedArchives.end());
 
-	const Archive::ResourceList &resources = archive->getResources();
-	for (Archive::ResourceList::const_iterator resource = resources.begin(); resource != resources.end(); ++resource) {
-		// Build the resource record
+	for (std::vector<ResourceIndexCache::Resource>::const_iterator resource = resources.begin();
+	     resource != resources.end(); ++resource) {
+
 		Resource res;
 		res.priority     = priority;
 		res.source       = kSourceArchive;
-		res.archive      = &_openedArchives.back();
+		res.archive      = &opened;
 		res.archiveIndex = resource->index;
-		res.name         = resource->name;
+		res.name         = addName(resource->name);
 		res.type         = resource->type;
+		res.isSmall      = resource->isSmall;
 
-		// Get the hash or calculate if we have to
-		uint64 hash = (hashAlgo == Common::kHashNone) ? getHash(res.name, res.type) : resource->hash;
+		addResource(res, resource->hash, change);
+	}
+}
 
-		// Normalize the file types if we can and recalculate the hash
-		if ((res.name != "") && (res.type != kFileTypeNone))
-			if (normalizeType(res))
-				hash = getHash(res.name, res.type);
+uint32 ResourceManager::getIndexSettings() const {
+	// Everything that changes which resources an archive adds, and how they're hashed
+	Common::UString settings = Common::UString::format("%d:%d:%d", (int) _hashAlgo, _hasSmall ? 1 : 0,
+			(int) (_archiveTypeTypes[kArchiveERF].find(kFileTypeRIM) != _archiveTypeTypes[kArchiveERF].end()));
 
-		// Handle "small" files
-		if (_hasSmall && (res.type == kFileTypeSMALL)) {
-			res.isSmall = true;
+	for (std::map<FileType, FileType>::const_iterator a = _typeAliases.begin(); a != _typeAliases.end(); ++a)
+		settings += Common::UString::format(",%d=%d", (int) a->first, (int) a->second);
+
+	return (uint32) Common::hashString(settings, Common::kHashFNV32);
+}
+
+void ResourceManager::setIndexCache(const Common::UString &dir, bool rebuild) {
+	Common::WriteLock lock(_lock);
+
+	_indexCacheDir     = dir;
+	_rebuildIndexCache = rebuild;
+}
+
+void ResourceManager::loadIndexCache() {
+	_indexCache.clear();
+	_indexCacheFile.clear();
+
+	if (_indexCacheDir.empty())
+		return;
+
+	// One cache file for each data base
+	const uint64 hash = Common::hashString(getDataBase(), Common::kHashFNV64);
+
+	_indexCacheFile = _indexCacheDir + "/" + Common::UString::format("%08X%08X.xri",
+			(uint) (hash >> 32), (uint) (hash & 0xFFFFFFFF));
+
+	if (!_rebuildIndexCache)
+		_indexCache.load(_indexCacheFile);
+}
+
+void ResourceManager::saveIndexCache() {
+	if (_indexCacheFile.empty() || !_indexCache.isChanged())
+		return;
+
+	try {
+		_indexCache.save(_indexCacheFile);
+	} catch (...) {
+		Common::exceptionDispatcherWarning("Failed to write the resource index cache \"%s\"",
+		                                   _indexCacheFile.c_str());
+	}
+}
+
+size_t ResourceManager::getArchiveOpenCount() const {
+	return _archiveOpenCount;
+}
+
+void ResourceManager::setDecompressedCacheBudget(size_t budget) {
+	_decompressedCache.setBudget(budget);
+}
+
+DecompressedCache::Statistics ResourceManager::getDecompressedCacheStatistics() const {
+	return _decompressedCache.getStatistics();
+}
+
+bool ResourceManager::indexCachedArchive(KnownArchive &knownArchive, uint32 priority,
+                                         const std::vector<byte> &password, Change *change) {
+
+	const Resource *resource = getResourceRecord(knownArchive);
+	if (_indexCacheFile.empty() || !resource || (resource->source != kSourceFile))
+		return false;
+
+	const ResourceIndexCache::Entry *entry = _indexCache.find(getName(resource->path));
+	if (!entry || !entry->isCurrent(getIndexSettings()))
+		return false;
 
-			res.name = Common::FilePath::getStem(resource->name);
-			res.type = TypeMan.getFileType(resource->name);
+	// A KEY lists the BIFs with the resources after itself, everything else is a single archive
+	std::vector<KnownArchive *> archives;
+	if (knownArchive.type == kArchiveKEY) {
+		for (size_t i = 1; i < entry->files.size(); i++) {
+			KnownArchive *bif = findArchive(entry->files[i].name, _knownArchives[kArchiveBIF]);
+			const Resource *bifResource = bif ? getResourceRecord(*bif) : 0;
+			if (!bifResource || (getName(bifResource->path) != entry->files[i].path))
+				return false;
+
+			archives.push_back(bif);
 		}
+	} else if (entry->files.size() == 1)
+		archives.push_back(&knownArchive);
+	else
+		return false;
+
+	const size_t first = entry->files.size() - archives.size();
+	for (size_t i = 0; i < archives.size(); i++)
+		addArchive(*archives[i], 0, password, entry->files[first + i].resources, priority, change);
+
+	return true;
+}
+
+void ResourceManager::addIndexCacheEntry(const KnownArchive &knownArchive, ResourceIndexCache::Entry &indexed) {
+	const Resource *resource = getResourceRecord(knownArchive);
+	if (_indexCacheFile.empty() || !resource || (resource->source != kSourceFile))
+		return;
+
+	assert(!indexed.files.empty());
 
-		// And add it to our list
-		addResource(res, hash, change);
+	indexed.settings = getIndexSettings();
+
+	indexed.files.front().name = knownArchive.name;
+	indexed.files.front().path = getName(resource->path);
+
+	// All the BIFs of a KEY need to be files we can check for changes, too
+	for (std::vector<ResourceIndexCache::File>::iterator f = indexed.files.begin(); f != indexed.files.end(); ++f) {
+		if (f->path.empty())
+			return;
+
+		f->readStatus();
 	}
+
+	_indexCache.set(indexed.files.front().path, indexed);
 }
 
 bool ResourceManager::hasResourceDir(const Common::UString &dir) {
+	Common::ReadLock lock(_lock);
+
 	if (_baseDir.empty())
 		return false;
 
@@ -480,6 +724,8 @@ bool ResourceManager::hasResourceDir(const Common::UString &dir) {
 void ResourceManager::indexResourceFile(const Common::UString &file, uint32 priority,
                                         Common::ChangeID *changeID) {
 
+	Common::WriteLock lock(_lock);
+
 	Common::UString path;
 	path = _baseDir.empty() ? file : (_baseDir + "/" + file);
 	path = Common::FilePath::normalize(path, false);
@@ -496,6 +742,8 @@ void ResourceManager::indexResourceFile(const Common::UString &file, uint32 prio
 
 void ResourceManager::indexResourceDir(const Common::UString &dir, const char *glob, int depth,
                                        uint32 priority, Common::ChangeID *changeID) {
+	Common::WriteLock lock(_lock);
+
 	if (_baseDir.empty())
 		throw Common::Exception("No base data directory set");
 
@@ -527,6 +775,8 @@ void ResourceManager::indexResourceDir(const Common::UString &dir, const char *g
 }
 
 void ResourceManager::undo(Common::ChangeID &changeID) {
+	Common::WriteLock lock(_lock);
+
 	Change *change = dynamic_cast<Change *>(changeID.getContent());
 	if (!change || (change->_change == _changes.end()))
 		return;
@@ -560,7 +810,11 @@ void ResourceManager::undo(Common::ChangeID &changeID) {
 				throw Common::Exception("Couldn't find archive in the parent's children list");
 		}
 
-		delete (*oaChange)->archive;
+		Archive *archive = (*oaChange)->archive.load();
+
+		_decompressedCache.remove(archive);
+
+		delete archive;
 		_openedArchives.erase(*oaChange);
 	}
 
@@ -572,75 +826,112 @@ void ResourceManager::undo(Common::ChangeID &changeID) {
 			throw Common::Exception("Attempted to deindex an archive that's still opened");
 
 		// Remove us from the resource
-		assert(kaChange->second->resource);
-		kaChange->second->resource->selfArchive.first = 0;
+		assert(kaChange->second->resource < _resources.size());
+		_resources[kaChange->second->resource].selfArchive = 0;
 
 		kaChange->first->erase(kaChange->second);
 	}
 
-	// Go through all changes in the resource map
-	for (ResourceChanges::iterator resChange = change->_change->resources.begin();
+	// Go through all changes in the resource table
+	for (ResourceChanges::const_iterator resChange = change->_change->resources.begin();
 	     resChange != change->_change->resources.end(); ++resChange) {
 
 		// If the resource still has an archive attached, it was added by a
 		// declareResources() call and needs to be removed manually
-		if (resChange->resIt->selfArchive.first) {
-			if (resChange->resIt->selfArchive.second->opened)
+		KnownArchive *selfArchive = _resources[*resChange].selfArchive;
+		if (selfArchive) {
+			if (selfArchive->opened)
 				throw Common::Exception("Attempted to deindex an archive resource that's still opened");
 
-			resChange->resIt->selfArchive.first->erase(resChange->resIt->selfArchive.second);
+			KnownArchives &archives = _knownArchives[selfArchive->type];
+			for (KnownArchives::iterator a = archives.begin(); a != archives.end(); ++a) {
+				if (&*a == selfArchive) {
+					archives.erase(a);
+					break;
+				}
+			}
 		}
 
-		// Remove the resource, and the name list too if it's empty
-		resChange->hashIt->second.erase(resChange->resIt);
-
-		if (resChange->hashIt->second.empty())
-			_resources.erase(resChange->hashIt);
+		// Remove the resource, and its table slot too if it was the last one with this hash
+		removeResource(*resChange);
 	}
 
 	// Now we can remove the change set from our list of change sets
 	_changes.erase(change->_change);
 
+	// Once most of the name arena is unused, throw the unused names out
+	if (_deadNames > (_names.size() / 2))
+		compactNames();
+
+	_generation++;
+
 	// And finally set the change ID to a defined empty state
 	changeID.clear();
 }
 
+uint32 ResourceManager::getGeneration() const {
+	return _generation;
+}
+
+size_t ResourceManager::getNameArenaSize() const {
+	Common::ReadLock lock(_lock);
+
+	return _names.size();
+}
+
 void ResourceManager::addTypeAlias(FileType alias, FileType realType) {
+	Common::WriteLock lock(_lock);
+
 	_typeAliases[alias] = realType;
+
+	_generation++;
 }
 
 void ResourceManager::blacklist(const Common::UString &name, FileType type) {
-	ResourceMap::iterator resList = _resources.find(getHash(name, type));
-	if (resList == _resources.end())
+	Common::WriteLock lock(_lock);
+
+	const size_t slot = findResourceSlot(getHash(name, type));
+	if (slot == SIZE_MAX)
 		return;
 
-	for (ResourceList::iterator res = resList->second.begin(); res != resList->second.end(); ++res)
-		res->priority = 0;
+	for (uint32 r = _resourceTable[slot].resource; r != kResourceNone; r = _resources[r].shadowed)
+		_resources[r].priority = 0;
+
+	_generation++;
 }
 
 void ResourceManager::declareResource(const Common::UString &name, FileType type) {
+	Common::WriteLock lock(_lock);
+
 	bool isSmall = false;
 
-	ResourceMap::iterator resList = _resources.find(getHash(name, type));
-	if (resList == _resources.end()) {
+	size_t slot = findResourceSlot(getHash(name, type));
+	if (slot == SIZE_MAX) {
 		if (_hasSmall) {
 			Common::UString smallName = TypeMan.addFileType(TypeMan.setFileType(name, type), kFileTypeSMALL);
 
-			resList = _resources.find(getHash(smallName));
+			slot = findResourceSlot(getHash(smallName));
 			isSmall = true;
 		}
 
-		if (resList == _resources.end())
+		if (slot == SIZE_MAX)
 			return;
 	}
 
-	for (ResourceList::iterator r = resList->second.begin(); r != resList->second.end(); ++r) {
-		r->name    = name;
-		r->type    = type;
-		r->isSmall = isSmall;
+	const uint32 nameOffset = addName(name);
 
-		checkResourceIsArchive(*r, 0);
+	for (uint32 r = _resourceTable[slot].resource; r != kResourceNone; r = _resources[r].shadowed) {
+		retainName(nameOffset);
+		releaseName(_resources[r].name);
+
+		_resources[r].name    = nameOffset;
+		_resources[r].type    = type;
+		_resources[r].isSmall = isSmall;
+
+		checkResourceIsArchive(r, 0);
 	}
+
+	releaseName(nameOffset);
 }
 
 void ResourceManager::declareResource(const Common::UString &name) {
@@ -666,10 +957,14 @@ bool ResourceManager::hasResource(const Common::UString &name) const {
 }
 
 bool ResourceManager::hasResource(const Common::UString &name, const std::vector<FileType> &types) const {
+	Common::ReadLock lock(_lock);
+
 	return getRes(name, types) != 0;
 }
 
 bool ResourceManager::hasResource(uint64 hash) const {
+	Common::ReadLock lock(_lock);
+
 	return getRes(hash) != 0;
 }
 
@@ -693,32 +988,57 @@ Common::UString ResourceManager::findResourceFile(const Common::UString &name) c
 
 Common::UString ResourceManager::findResourceFile(const Common::UString &name,
                                                   const std::vector<FileType> &types) const {
+
+	Common::ReadLock lock(_lock);
+
 	const Resource *res = getRes(name, types);
 	if (res && (res->source == kSourceFile))
-		return res->path;
+		return getName(res->path);
 
 	return "";
 }
 
 uint32 ResourceManager::getResourceSize(const Resource &res) const {
 	if (res.source == kSourceArchive) {
-		if ((res.archive == 0) || (res.archive->archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
+		if ((res.archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
 			return 0xFFFFFFFF;
 
-		return res.archive->archive->getResourceSize(res.archiveIndex);
+		return getArchive(*res.archive)->getResourceSize(res.archiveIndex);
 	}
 
 	if (res.source == kSourceFile)
-		return Common::FilePath::getFileSize(res.path);
+		return Common::FilePath::getFileSize(getName(res.path));
 
 	return 0xFFFFFFFF;
 }
 
 Common::SeekableReadStream *ResourceManager::getArchiveResource(const Resource &res, bool tryNoCopy) const {
-	if ((res.archive == 0) || (res.archive->archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
+	if ((res.archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
 		throw Common::Exception("Archive resource has no archive");
 
-	return res.archive->archive->getResource(res.archiveIndex, tryNoCopy);
+	return getArchive(*res.archive)->getResource(res.archiveIndex, tryNoCopy);
+}
+
+Common::SeekableReadStream *ResourceManager::getCachedArchiveResource(const Resource &res) const {
+	if ((res.archive == 0) || (res.archiveIndex == 0xFFFFFFFF))
+		throw Common::Exception("Archive resource has no archive");
+
+	// Only resources that need decompressing are worth caching
+	const Archive *archive = getArchive(*res.archive);
+	if (!res.isSmall && !archive->hasPackedResources())
+		return 0;
+
+	Common::SeekableReadStream *stream = _decompressedCache.get(archive, res.archiveIndex);
+	if (stream)
+		return stream;
+
+	stream = archive->getResource(res.archiveIndex);
+
+	// Transparently decompress "small" files
+	if (res.isSmall)
+		stream = Small::decompress(stream);
+
+	return _decompressedCache.add(archive, res.archiveIndex, stream);
 }
 
 Common::SeekableReadStream *ResourceManager::getResource(const Common::UString &name, FileType type) const {
@@ -736,6 +1056,8 @@ Common::SeekableReadStream *ResourceManager::getResource(const Common::UString &
 Common::SeekableReadStream *ResourceManager::getResource(const Common::UString &name,
 		const std::vector<FileType> &types, FileType *foundType) const {
 
+	Common::ReadLock lock(_lock);
+
 	const Resource *res = getRes(name, types);
 	if (!res)
 		return 0;
@@ -748,6 +1070,8 @@ Common::SeekableReadStream *ResourceManager::getResource(const Common::UString &
 }
 
 Common::SeekableReadStream *ResourceManager::getResource(uint64 hash, FileType *type) const {
+	Common::ReadLock lock(_lock);
+
 	const Resource *res = getRes(hash);
 	if (!res)
 		return 0;
@@ -762,9 +1086,13 @@ Common::SeekableReadStream *ResourceManager::getResource(uint64 hash, FileType *
 Common::SeekableReadStream *ResourceManager::getResource(const Resource &res, bool tryNoCopy) const {
 	Common::SeekableReadStream *stream = 0;
 
+	if ((res.source == kSourceArchive) && (_decompressedCache.getBudget() > 0))
+		if ((stream = getCachedArchiveResource(res)))
+			return stream;
+
 	switch (res.source) {
 		case kSourceFile:
-			stream = new Common::ReadFile(res.path);
+			stream = new Common::ReadFile(getName(res.path));
 			break;
 
 		case kSourceArchive:
@@ -773,7 +1101,7 @@ Common::SeekableReadStream *ResourceManager::getResource(const Resource &res, bo
 
 		default:
 			throw Common::Exception("Invalid source for resource \"%s\": (%d)",
-			                        TypeMan.setFileType(res.name, res.type).c_str(), res.source);
+			                        TypeMan.setFileType(getName(res.name), res.type).c_str(), res.source);
 	}
 
 	// Transparently decompress "small" files
@@ -800,13 +1128,19 @@ Common::SeekableReadStream *ResourceManager::getResource(ResourceType resType,
 void ResourceManager::getAvailableResources(FileType type,
 		std::list<ResourceID> &list) const {
 
-	for (ResourceMap::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
-		if (!r->second.empty() && (r->second.front().type == type)) {
+	Common::ReadLock lock(_lock);
+
+	for (ResourceTable::const_iterator s = _resourceTable.begin(); s != _resourceTable.end(); ++s) {
+		if ((s->resource == kResourceNone) || (s->resource == kResourceDeleted))
+			continue;
+
+		const Resource &res = _resources[s->resource];
+		if (res.type == type) {
 			list.push_back(ResourceID());
 
-			list.back().name = r->second.front().name;
-			list.back().type = r->second.front().type;
-			list.back().hash = r->first;
+			list.back().name = getName(res.name);
+			list.back().type = res.type;
+			list.back().hash = s->hash;
 		}
 	}
 }
@@ -814,14 +1148,20 @@ void ResourceManager::getAvailableResources(FileType type,
 void ResourceManager::getAvailableResources(const std::vector<FileType> &types,
 		std::list<ResourceID> &list) const {
 
-	for (ResourceMap::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
+	Common::ReadLock lock(_lock);
+
+	for (ResourceTable::const_iterator s = _resourceTable.begin(); s != _resourceTable.end(); ++s) {
+		if ((s->resource == kResourceNone) || (s->resource == kResourceDeleted))
+			continue;
+
+		const Resource &res = _resources[s->resource];
 		for (std::vector<FileType>::const_iterator t = types.begin(); t != types.end(); ++t) {
-			if (!r->second.empty() && (r->second.front().type == *t)) {
+			if (res.type == *t) {
 				list.push_back(ResourceID());
 
-				list.back().name = r->second.front().name;
-				list.back().type = r->second.front().type;
-				list.back().hash = r->first;
+				list.back().name = getName(res.name);
+				list.back().type = res.type;
+				list.back().hash = s->hash;
 			}
 		}
 
@@ -849,43 +1189,43 @@ ArchiveType ResourceManager::getArchiveType(const Common::UString &name) const {
 Common::UString ResourceManager::getArchiveName(const Resource &resource) const {
 	switch (resource.source) {
 		case kSourceFile:
-			return resource.path;
+			return getName(resource.path);
 
 		case kSourceArchive:
-			return "/" + TypeMan.addFileType(resource.name, resource.type);
+			return "/" + TypeMan.addFileType(getName(resource.name), resource.type);
 
 		default:
 			break;
 	}
 
 	throw Common::Exception("Invalid source for resource \"%s\": (%d)",
-	                        TypeMan.addFileType(resource.name, resource.type).c_str(),
+	                        TypeMan.addFileType(getName(resource.name), resource.type).c_str(),
 	                        resource.source);
 }
 
-bool ResourceManager::normalizeType(Resource &resource) {
+bool ResourceManager::normalizeType(FileType &type) {
 	// Resolve the type aliases
-	std::map<FileType, FileType>::const_iterator alias = _typeAliases.find(resource.type);
+	std::map<FileType, FileType>::const_iterator alias = _typeAliases.find(type);
 	if (alias != _typeAliases.end()) {
-		resource.type = alias->second;
+		type = alias->second;
 		return true;
 	}
 
 	// Normalize resource type *sigh*
-	if      (resource.type == kFileTypeQST2)
-		resource.type = kFileTypeQST;
-	else if (resource.type == kFileTypeMDX2)
-		resource.type = kFileTypeMDX;
-	else if (resource.type == kFileTypeTXB2)
-		resource.type = kFileTypeTXB;
-	else if (resource.type == kFileTypeMDB2)
-		resource.type = kFileTypeMDB;
-	else if (resource.type == kFileTypeMDA2)
-		resource.type = kFileTypeMDA;
-	else if (resource.type == kFileTypeSPT2)
-		resource.type = kFileTypeSPT;
-	else if (resource.type == kFileTypeJPG2)
-		resource.type = kFileTypeJPG;
+	if      (type == kFileTypeQST2)
+		type = kFileTypeQST;
+	else if (type == kFileTypeMDX2)
+		type = kFileTypeMDX;
+	else if (type == kFileTypeTXB2)
+		type = kFileTypeTXB;
+	else if (type == kFileTypeMDB2)
+		type = kFileTypeMDB;
+	else if (type == kFileTypeMDA2)
+		type = kFileTypeMDA;
+	else if (type == kFileTypeSPT2)
+		type = kFileTypeSPT;
+	else if (type == kFileTypeJPG2)
+		type = kFileTypeJPG;
 	else
 		return false;
 
@@ -900,17 +1240,17 @@ inline uint64 ResourceManager::getHash(const Common::UString &name) const {
 	return Common::hashString(name.toLower(), _hashAlgo);
 }
 
-void ResourceManager::checkHashCollision(const Resource &resource, ResourceMap::const_iterator resList) {
-	if (resource.name.empty() || resList->second.empty())
+void ResourceManager::checkHashCollision(const Resource &resource, uint32 resList) {
+	if ((resource.name == 0) || (resList == kResourceNone))
 		return;
 
-	Common::UString newName = TypeMan.setFileType(resource.name, resource.type).toLower();
+	Common::UString newName = TypeMan.setFileType(getName(resource.name), resource.type).toLower();
 
-	for (ResourceList::const_iterator r = resList->second.begin(); r != resList->second.end(); ++r) {
-		if (r->name.empty())
+	for (uint32 r = resList; r != kResourceNone; r = _resources[r].shadowed) {
+		if (_resources[r].name == 0)
 			continue;
 
-		Common::UString oldName = TypeMan.setFileType(r->name, r->type).toLower();
+		Common::UString oldName = TypeMan.setFileType(getName(_resources[r].name), _resources[r].type).toLower();
 		if (oldName != newName) {
 			warning("ResourceManager: Found hash collision: %s (\"%s\" and \"%s\")",
 					Common::formatHash(getHash(oldName)).c_str(), oldName.c_str(), newName.c_str());
@@ -919,20 +1259,21 @@ void ResourceManager::checkHashCollision(const Resource &resource, ResourceMap::
 	}
 }
 
-bool ResourceManager::checkResourceIsArchive(Resource &resource, Change *change) {
-	if ((resource.source == kSourceNone) || resource.name.empty())
+bool ResourceManager::checkResourceIsArchive(uint32 resource, Change *change) {
+	Resource &res = _resources[resource];
+	if ((res.source == kSourceNone) || (res.name == 0))
 		return false;
 
-	ArchiveType type = getArchiveType(resource.type);
+	ArchiveType type = getArchiveType(res.type);
 	if (type == kArchiveMAX)
 		return false;
 
-	Common::UString name = getArchiveName(resource);
+	Common::UString name = getArchiveName(res);
 	if (name.empty())
 		return false;
 
-	if (resource.selfArchive.first) {
-		if ((resource.selfArchive.second->type != type) || (resource.selfArchive.second->name != name))
+	if (res.selfArchive) {
+		if ((res.selfArchive->type != type) || (res.selfArchive->name != name))
 			throw Common::Exception("Tried to reclassify a resource archive (\"%s\")", name.c_str());
 
 		return false;
@@ -942,68 +1283,67 @@ bool ResourceManager::checkResourceIsArchive(Resource &resource, Change *change)
 
 	archives.push_back(KnownArchive(type, name, resource));
 
-	resource.selfArchive = std::make_pair(&archives, --archives.end());
+	res.selfArchive = &archives.back();
 
 	if (change)
-		change->_change->knownArchives.push_back(resource.selfArchive);
+		change->_change->knownArchives.push_back(std::make_pair(&archives, --archives.end()));
 
 	return true;
 }
 
-void ResourceManager::addResource(Resource &resource, uint64 hash, Change *change) {
-	ResourceMap::iterator resList = _resources.find(hash);
-	if (resList == _resources.end()) {
-		// We don't have a resource with this name yet, create a new resource list for it
-
-		std::pair<ResourceMap::iterator, bool> result;
-
-		result = _resources.insert(std::make_pair(hash, ResourceList()));
-
-		resList = result.first;
-	}
+void ResourceManager::addResource(const Resource &resource, uint64 hash, Change *change) {
+	const size_t slot = insertResourceSlot(hash);
 
 #ifdef CHECK_HASH_COLLISION
-	checkHashCollision(resource, resList);
+	checkHashCollision(resource, _resourceTable[slot].resource);
 #endif
 
-	// Add the resource to the list
-	resList->second.push_back(resource);
-	Resource *res = &resList->second.back();
+	const uint32 res = newResource(resource);
+	_resources[res].hash = hash;
+
+	/* Sort the resource into the list of resources with this hash, highest
+	 * priority first. Of several resources with the same priority, the one
+	 * added last wins. */
+	uint32 *link = &_resourceTable[slot].resource;
+	while ((*link != kResourceNone) && (_resources[*link].priority > resource.priority))
+		link = &_resources[*link].shadowed;
 
-	checkResourceIsArchive(*res, change);
+	_resources[res].shadowed = *link;
+	*link = res;
+
+	checkResourceIsArchive(res, change);
 
 	// Remember the resource in the change set
-	if (change) {
-		change->_change->resources.push_back(ResourceChange());
-		change->_change->resources.back().hashIt = resList;
-		change->_change->resources.back().resIt  = --resList->second.end();
-	}
+	if (change)
+		change->_change->resources.push_back(res);
 
-	// Resort the list by priority
-	resList->second.sort();
+	_generation++;
 }
 
 void ResourceManager::addResource(const Common::UString &path, Change *change, uint32 priority) {
-	Resource res;
-	res.priority = priority;
-	res.source   = kSourceFile;
-	res.path     = path;
-	res.name     = Common::FilePath::getStem(path);
-	res.type     = TypeMan.getFileType(path);
+	Common::UString name = Common::FilePath::getStem(path);
+	FileType type = TypeMan.getFileType(path);
+	bool isSmall = false;
 
 	// Handle "small" files
-	if (_hasSmall && (res.type == kFileTypeSMALL)) {
-		const Common::UString name = res.name;
+	if (_hasSmall && (type == kFileTypeSMALL)) {
+		isSmall = true;
 
-		res.isSmall = true;
-
-		res.name = Common::FilePath::getStem(name);
-		res.type = TypeMan.getFileType(name);
+		type = TypeMan.getFileType(name);
+		name = Common::FilePath::getStem(name);
 	}
 
-	uint64 hash = getHash(res.name, res.type);
-	if (normalizeType(res))
-		hash = getHash(res.name, res.type);
+	uint64 hash = getHash(name, type);
+	if (normalizeType(type))
+		hash = getHash(name, type);
+
+	Resource res;
+	res.priority = priority;
+	res.source   = kSourceFile;
+	res.path     = addName(path);
+	res.name     = addName(name);
+	res.type     = type;
+	res.isSmall  = isSmall;
 
 	addResource(res, hash, change);
 }
@@ -1013,12 +1353,264 @@ void ResourceManager::addResources(const Common::FileList &files, Change *change
 		addResource(*file, change, priority);
 }
 
+void ResourceManager::clearResourceTable() {
+	_resources.clear();
+	_freeResources.clear();
+
+	_resourceTable.clear();
+	_resourceTableUsed = 0;
+	_resourceHashes    = 0;
+
+	_names.clear();
+	_names.push_back('\0');
+
+	_nameRefs.clear();
+	_deadNames = 0;
+}
+
+/** Map a hash onto the start of its probing sequence in a table of the given power-of-two size. */
+static inline size_t getResourceSlotStart(uint64 hash, size_t tableSize) {
+	// Fibonacci hashing, so that hashes differing only in their upper bits still spread out
+	return (size_t) ((hash * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (tableSize - 1);
+}
+
+size_t ResourceManager::findResourceSlot(uint64 hash) const {
+	if (_resourceTable.empty())
+		return SIZE_MAX;
+
+	const size_t mask = _resourceTable.size() - 1;
+
+	for (size_t slot = getResourceSlotStart(hash, _resourceTable.size()); ; slot = (slot + 1) & mask) {
+		const ResourceSlot &s = _resourceTable[slot];
+
+		if (s.resource == kResourceNone)
+			return SIZE_MAX;
+
+		if ((s.resource != kResourceDeleted) && (s.hash == hash))
+			return slot;
+	}
+}
+
+size_t ResourceManager::insertResourceSlot(uint64 hash) {
+	const size_t found = findResourceSlot(hash);
+	if (found != SIZE_MAX)
+		return found;
+
+	// Keep the table at most 3/4 full, counting deleted slots
+	if (((_resourceTableUsed + 1) * 4) > (_resourceTable.size() * 3))
+		growResourceTable();
+
+	const size_t mask = _resourceTable.size() - 1;
+
+	size_t slot = getResourceSlotStart(hash, _resourceTable.size());
+	while ((_resourceTable[slot].resource != kResourceNone) && (_resourceTable[slot].resource != kResourceDeleted))
+		slot = (slot + 1) & mask;
+
+	if (_resourceTable[slot].resource == kResourceNone)
+		_resourceTableUsed++;
+
+	_resourceTable[slot].hash     = hash;
+	_resourceTable[slot].resource = kResourceNone;
+
+	_resourceHashes++;
+
+	return slot;
+}
+
+void ResourceManager::growResourceTable() {
+	// Rehash into a table with room for twice the live hashes, dropping the deleted slots
+	size_t size = 64;
+	while (size < ((_resourceHashes + 1) * 2))
+		size *= 2;
+
+	ResourceTable table(size);
+	for (ResourceTable::iterator s = table.begin(); s != table.end(); ++s)
+		s->resource = kResourceNone;
+
+	const size_t mask = size - 1;
+	for (ResourceTable::const_iterator s = _resourceTable.begin(); s != _resourceTable.end(); ++s) {
+		if ((s->resource == kResourceNone) || (s->resource == kResourceDeleted))
+			continue;
+
+		size_t slot = getResourceSlotStart(s->hash, size);
+		while (table[slot].resource != kResourceNone)
+			slot = (slot + 1) & mask;
+
+		table[slot] = *s;
+	}
+
+	_resourceTable.swap(table);
+	_resourceTableUsed = _resourceHashes;
+}
+
+uint32 ResourceManager::newResource(const Resource &resource) {
+	if (!_freeResources.empty()) {
+		const uint32 res = _freeResources.back();
+		_freeResources.pop_back();
+
+		_resources[res] = resource;
+		return res;
+	}
+
+	if (_resources.size() >= kResourceDeleted)
+		throw Common::Exception("ResourceManager: Too many resources");
+
+	_resources.push_back(resource);
+	return _resources.size() - 1;
+}
+
+void ResourceManager::removeResource(uint32 resource) {
+	assert(resource < _resources.size());
+
+	const size_t slot = findResourceSlot(_resources[resource].hash);
+	if (slot == SIZE_MAX)
+		throw Common::Exception("ResourceManager: Resource missing from the resource table");
+
+	// Unlink the resource from the list of resources with this hash
+	uint32 *link = &_resourceTable[slot].resource;
+	while ((*link != kResourceNone) && (*link != resource))
+		link = &_resources[*link].shadowed;
+
+	if (*link == kResourceNone)
+		throw Common::Exception("ResourceManager: Resource missing from the resource table");
+
+	*link = _resources[resource].shadowed;
+
+	// That was the last resource with this hash, so leave a tombstone for probing
+	if (_resourceTable[slot].resource == kResourceNone) {
+		_resourceTable[slot].resource = kResourceDeleted;
+		_resourceHashes--;
+	}
+
+	releaseName(_resources[resource].name);
+	releaseName(_resources[resource].path);
+
+	_resources[resource] = Resource();
+	_freeResources.push_back(resource);
+}
+
+const ResourceManager::Resource *ResourceManager::getResourceRecord(const KnownArchive &archive) const {
+	if (archive.resource >= _resources.size())
+		return 0;
+
+	return &_resources[archive.resource];
+}
+
+size_t ResourceManager::NameHash::operator()(uint32 name) const {
+	const char *str = &(*names)[name];
+
+	return boost::hash_range(str, str + std::strlen(str));
+}
+
+bool ResourceManager::NameEquals::operator()(uint32 name1, uint32 name2) const {
+	return std::strcmp(&(*names)[name1], &(*names)[name2]) == 0;
+}
+
+uint32 ResourceManager::addName(const Common::UString &name) {
+	const char *str = name.c_str();
+	const size_t length = std::strlen(str);
+	if (length == 0)
+		return 0;
+
+	if ((_names.size() + length + 1) > 0xFFFFFFFF)
+		throw Common::Exception("ResourceManager: Too many resource names");
+
+	/* Put the name at the end of the arena, and look it up there. If we
+	 * already have it, use that one and drop the new copy again. */
+	const uint32 offset = _names.size();
+	_names.insert(_names.end(), str, str + length + 1);
+
+	std::pair<NameMap::iterator, bool> known = _nameRefs.insert(std::make_pair(offset, 0));
+	if (!known.second)
+		_names.resize(offset);
+
+	known.first->second++;
+
+	return known.first->first;
+}
+
+void ResourceManager::retainName(uint32 name) {
+	if (name == 0)
+		return;
+
+	NameMap::iterator n = _nameRefs.find(name);
+	assert(n != _nameRefs.end());
+
+	n->second++;
+}
+
+void ResourceManager::releaseName(uint32 name) {
+	if (name == 0)
+		return;
+
+	NameMap::iterator n = _nameRefs.find(name);
+	assert((n != _nameRefs.end()) && (n->second > 0));
+
+	if (--n->second > 0)
+		return;
+
+	_deadNames += std::strlen(&_names[name]) + 1;
+	_nameRefs.erase(n);
+}
+
+void ResourceManager::compactNames() {
+	// The names still in use, in arena order
+	std::vector<std::pair<uint32, uint32> > used(_nameRefs.begin(), _nameRefs.end());
+	std::sort(used.begin(), used.end());
+
+	std::vector<char> names;
+	names.reserve(_names.size() - _deadNames);
+	names.push_back('\0');
+
+	std::vector<uint32> moved(used.size());
+	for (size_t i = 0; i < used.size(); i++) {
+		const char *str = &_names[used[i].first];
+
+		moved[i] = names.size();
+		names.insert(names.end(), str, str + std::strlen(str) + 1);
+	}
+
+	// Point all resource records to the names' new places
+	for (ResourceRecords::iterator r = _resources.begin(); r != _resources.end(); ++r) {
+		uint32 *offsets[] = { &r->name, &r->path };
+
+		for (size_t i = 0; i < ARRAYSIZE(offsets); i++) {
+			if (*offsets[i] == 0)
+				continue;
+
+			const std::vector<std::pair<uint32, uint32> >::const_iterator n =
+				std::lower_bound(used.begin(), used.end(), std::make_pair(*offsets[i], (uint32) 0));
+			assert((n != used.end()) && (n->first == *offsets[i]));
+
+			*offsets[i] = moved[n - used.begin()];
+		}
+	}
+
+	_names.swap(names);
+
+	_nameRefs.clear();
+	for (size_t i = 0; i < used.size(); i++)
+		_nameRefs.insert(std::make_pair(moved[i], used[i].second));
+
+	_deadNames = 0;
+}
+
+Common::UString ResourceManager::getName(uint32 name) const {
+	assert(name < _names.size());
+
+	return Common::UString(&_names[name]);
+}
+
 const ResourceManager::Resource *ResourceManager::getRes(uint64 hash) const {
-	ResourceMap::const_iterator r = _resources.find(hash);
-	if ((r == _resources.end()) || r->second.empty() || (r->second.back().priority == 0))
+	const size_t slot = findResourceSlot(hash);
+	if (slot == SIZE_MAX)
+		return 0;
+
+	const uint32 res = _resourceTable[slot].resource;
+	if ((res == kResourceNone) || (_resources[res].priority == 0))
 		return 0;
 
-	return &r->second.back();
+	return &_resources[res];
 }
 
 const ResourceManager::Resource *ResourceManager::getRes(const Common::UString &name,
@@ -1050,6 +1642,8 @@ const ResourceManager::Resource *ResourceManager::getRes(const Common::UString &
 }
 
 void ResourceManager::dumpResourcesList(const Common::UString &fileName) const {
+	Common::ReadLock lock(_lock);
+
 	Common::WriteFile file;
 
 	if (!file.open(fileName))
@@ -1058,13 +1652,20 @@ void ResourceManager::dumpResourcesList(const Common::UString &fileName) const {
 	file.writeString("                Name                 |        Hash        |     Size    \n");
 	file.writeString("-------------------------------------|--------------------|-------------\n");
 
-	for (ResourceMap::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
-		if (r->second.empty())
-			continue;
+	// Sort by hash, so that the list is the same no matter the indexing order
+	std::vector<std::pair<uint64, uint32> > resources;
+	resources.reserve(_resourceHashes);
+
+	for (ResourceTable::const_iterator s = _resourceTable.begin(); s != _resourceTable.end(); ++s)
+		if ((s->resource != kResourceNone) && (s->resource != kResourceDeleted))
+			resources.push_back(std::make_pair(s->hash, s->resource));
+
+	std::sort(resources.begin(), resources.end());
 
-		const Resource &res = r->second.back();
+	for (std::vector<std::pair<uint64, uint32> >::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+		const Resource &res = _resources[r->second];
 
-		const Common::UString &name = res.name;
+		const Common::UString  name = getName(res.name);
 		const Common::UString   ext = TypeMan.setFileType("", res.type);
 		const uint64           hash = r->first;
 		const uint32           size = getResourceSize(res);
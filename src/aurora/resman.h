@@ -29,6 +29,9 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <atomic>
+
+#include <boost/unordered/unordered_map.hpp>
 
 #include "src/common/types.h"
 #include "src/common/ustring.h"
@@ -36,8 +39,12 @@
 #include "src/common/filelist.h"
 #include "src/common/hash.h"
 #include "src/common/changeid.h"
+#include "src/common/readwritelock.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/types.h"
+#include "src/aurora/resindexcache.h"
+#include "src/aurora/decompressedcache.h"
 
 namespace Common {
 	class SeekableReadStream;
@@ -51,6 +58,17 @@ class KEYDataFile;
 
 /** A resource manager holding information about and handling all request for all
  *  resources usable by the game.
+ *
+ *  The resource manager can be used from several threads at once. Looking up
+ *  and reading resources (hasResource(), getResource(), findResourceFile(),
+ *  getAvailableResources(), ...) only takes a shared read lock, so any number
+ *  of threads can do that concurrently. The archives read the resources with
+ *  positional reads that never disturb each other. Everything that changes
+ *  the index (indexArchive(), indexResourceDir(), undo(), declareResource(),
+ *  ...) takes the exclusive write lock and waits for all readers to finish.
+ *
+ *  The returned resource streams belong to the caller and are independent
+ *  of each other, so they can be read from different threads.
  */
 class ResourceManager : public Common::Singleton<ResourceManager> {
 public:
@@ -107,6 +125,44 @@ public:
 	const Common::UString &getDataBase() const;
 	// '---
 
+	// .--- Resource index cache
+	/** Cache the resource indices of archives in this directory.
+	 *
+	 *  Each data base gets its own cache file there. It is read when the
+	 *  data base is registered, and written when the resources are cleared.
+	 *  Archives whose files are unchanged since they were cached are then
+	 *  indexed from the cache, and only opened once a resource is read
+	 *  from them. An empty directory disables the cache.
+	 *
+	 *  @param dir The directory to keep the cache files in.
+	 *  @param rebuild Ignore the existing cache files and index all archives anew.
+	 */
+	void setIndexCache(const Common::UString &dir, bool rebuild = false);
+
+	/** Write the resource index cache of the current data base, if it changed. */
+	void saveIndexCache();
+
+	/** Return the number of times an archive file has been opened so far.
+	 *
+	 *  Archives indexed from the cache are only opened once a resource
+	 *  is read from them, so this shows the work the cache saved.
+	 */
+	size_t getArchiveOpenCount() const;
+	// '---
+
+	// .--- Decompressed resource cache
+	/** Set the number of bytes of decompressed resources to keep in memory.
+	 *
+	 *  Resources read out of compressed or encrypted archives, and "small"
+	 *  files, are kept in an LRU cache, so that requesting them again doesn't
+	 *  decompress them anew. 0, the default, disables the cache.
+	 */
+	void setDecompressedCacheBudget(size_t budget);
+
+	/** Return statistics about the use of the decompressed resource cache. */
+	DecompressedCache::Statistics getDecompressedCacheStatistics() const;
+	// '---
+
 	// .--- Archives
 	/** Does a specific archive exist?
 	 *
@@ -180,6 +236,22 @@ public:
 	/** Undo the changes done in the specified change ID. */
 	void undo(Common::ChangeID &changeID);
 
+	/** Return the current generation of the resource index.
+	 *
+	 *  The generation changes whenever resources are added or removed,
+	 *  for example by indexing an archive or undoing a change ID. Caches
+	 *  of data derived from resources can use it to find out when their
+	 *  contents might have gone stale.
+	 */
+	uint32 getGeneration() const;
+
+	/** Return the number of bytes taken up by the names and paths of all resources.
+	 *
+	 *  Every distinct name is stored only once. The space of names no
+	 *  longer used is reclaimed when undoing a change ID.
+	 */
+	size_t getNameArenaSize() const;
+
 	/** Blacklist a specific resource.
 	 *
 	 *  That resource will never be returned when asked for. The ResourceManager
@@ -352,22 +424,26 @@ private:
 
 	// .--- Archives
 	struct KnownArchive {
-		Common::UString name; ///< The archive's name.
-		ArchiveType     type; ///< The archive's type.
+		Common::UString name;      ///< The archive's name.
+		Common::UString lowerName; ///< The archive's name, in lowercase.
+		ArchiveType     type;      ///< The archive's type.
 
-		/** The resource this archive is. */
-		Resource *resource;
+		/** The resource this archive is, as an index into the resource records. */
+		uint32 resource;
 
 		/** The opened archive, if it was. */
 		OpenedArchive *opened;
 
 		KnownArchive();
-		KnownArchive(ArchiveType t, const Common::UString &n, Resource &r);
+		KnownArchive(ArchiveType t, const Common::UString &n, uint32 r);
 	};
 
 	struct OpenedArchive {
-		/** The actual archive. */
-		Archive *archive;
+		/** The actual archive. 0 if it was indexed from the cache and hasn't been opened yet. */
+		std::atomic<Archive *> archive;
+
+		/** The password to open the archive with, if it hasn't been opened yet. */
+		std::vector<byte> password;
 
 		/** The information we know about this archive. */
 		KnownArchive *known;
@@ -379,7 +455,7 @@ private:
 
 		OpenedArchive();
 
-		void set(KnownArchive &kA, Archive &a);
+		void set(KnownArchive &kA, Archive *a, const Resource &resource);
 	};
 
 	/** List of all known archive files. */
@@ -396,10 +472,12 @@ private:
 		kSourceArchive  ///< Within an archive.
 	};
 
-	/** A resource. */
+	/** A resource record. */
 	struct Resource {
-		Common::UString name; ///< The resource's name.
-		FileType        type; ///< The resource's type.
+		uint64 hash; ///< The resource's hashed name.
+
+		uint32   name; ///< The resource's name, as an offset into the name arena.
+		FileType type; ///< The resource's type.
 
 		/** Is this a "small" (compressed Nintendo DS) file? */
 		bool isSmall;
@@ -407,14 +485,17 @@ private:
 		/** The resource's priority over others with the same name and type. */
 		uint32 priority;
 
+		/** The next resource with the same hash, shadowed by this one. */
+		uint32 shadowed;
+
 		/** The archive this resource itself is. */
-		std::pair<KnownArchives *, KnownArchives::iterator> selfArchive;
+		KnownArchive *selfArchive;
 
 		/** Where can the resource be found? */
 		Source source;
 
 		// For kSourceFile
-		Common::UString path; ///< The file's path.
+		uint32 path; ///< The file's path, as an offset into the name arena.
 
 		// For kSourceArchive
 		OpenedArchive *archive;      ///< Pointer to the opened archive.
@@ -425,10 +506,40 @@ private:
 		bool operator<(const Resource &right) const;
 	};
 
-	/** List of resources, sorted by priority. */
-	typedef std::list<Resource> ResourceList;
-	/** Map over resources, indexed by their hashed name. */
-	typedef std::map<uint64, ResourceList> ResourceMap;
+	/** A slot in the open-addressing resource table. */
+	struct ResourceSlot {
+		uint64 hash;     ///< The hashed name of the resources in this slot.
+		uint32 resource; ///< The resource with the highest priority, kResourceNone or kResourceDeleted.
+	};
+
+	/** All resource records, live and free ones. */
+	typedef std::vector<Resource> ResourceRecords;
+	/** Open-addressing hash table over the resource records, indexed by their hashed name. */
+	typedef std::vector<ResourceSlot> ResourceTable;
+
+	/** An empty resource table slot, or the end of a list of shadowed resources. */
+	static const uint32 kResourceNone    = 0xFFFFFFFF;
+	/** A resource table slot that was used once, and has to be probed over. */
+	static const uint32 kResourceDeleted = 0xFFFFFFFE;
+
+	/** Hashes a name in the name arena, given by its offset. */
+	struct NameHash {
+		const std::vector<char> *names;
+
+		NameHash(const std::vector<char> &n) : names(&n) { }
+		size_t operator()(uint32 name) const;
+	};
+
+	/** Compares two names in the name arena, given by their offsets. */
+	struct NameEquals {
+		const std::vector<char> *names;
+
+		NameEquals(const std::vector<char> &n) : names(&n) { }
+		bool operator()(uint32 name1, uint32 name2) const;
+	};
+
+	/** Each distinct name in the name arena, and the number of resource records using it. */
+	typedef boost::unordered_map<uint32, uint32, NameHash, NameEquals> NameMap;
 	// '---
 
 	// .--- Changes
@@ -437,14 +548,11 @@ private:
 	/** A change produced by indexing/opening an archive. */
 	typedef OpenedArchives::iterator OpenedArchiveChange;
 	/** A change produced by indexing archive resources. */
-	struct ResourceChange {
-		ResourceMap::iterator  hashIt;
-		ResourceList::iterator resIt;
-	};
+	typedef uint32 ResourceChange;
 
 	typedef std::list<KnownArchiveChange>  KnownArchiveChanges;
 	typedef std::list<OpenedArchiveChange> OpenedArchiveChanges;
-	typedef std::list<ResourceChange>      ResourceChanges;
+	typedef std::vector<ResourceChange>    ResourceChanges;
 
 	/** A set of changes produced by a manager operation. */
 	struct ChangeSet {
@@ -491,8 +599,39 @@ private:
 	/** The current type aliases, changing one type to another. */
 	std::map<FileType, FileType> _typeAliases;
 
-	ResourceMap   _resources; ///< All currently known resources.
-	ChangeSetList _changes;   ///< Changes produced by indexing the currently known resources.
+	ResourceRecords     _resources;     ///< All currently known resources.
+	std::vector<uint32> _freeResources; ///< Resource records that can be reused.
+
+	ResourceTable _resourceTable;     ///< Hash table over the resources with the highest priority.
+	size_t        _resourceTableUsed; ///< Number of used and deleted slots in the resource table.
+	size_t        _resourceHashes;    ///< Number of distinct resource hashes in the resource table.
+
+	/** The names and paths of all resources, '\0'-terminated. Offset 0 is the empty string. */
+	std::vector<char> _names;
+
+	NameMap _nameRefs;  ///< The names in the name arena, to store each one only once.
+	size_t  _deadNames; ///< Number of bytes in the name arena taken up by unused names.
+
+	ChangeSetList _changes; ///< Changes produced by indexing the currently known resources.
+
+	std::atomic<uint32> _generation; ///< The current generation of the resource index.
+
+	Common::UString _indexCacheDir;     ///< The directory to keep the resource index caches in.
+	Common::UString _indexCacheFile;    ///< The resource index cache file of the current data base.
+	bool            _rebuildIndexCache; ///< Ignore the existing resource index caches?
+
+	ResourceIndexCache _indexCache; ///< The resource index cache of the current data base.
+
+	mutable std::atomic<size_t> _archiveOpenCount; ///< Number of times an archive file was opened.
+
+	/** Recently read decompressed resources. */
+	mutable DecompressedCache _decompressedCache;
+
+	/** Guards opening archives that were indexed from the cache. */
+	mutable std::recursive_mutex _openMutex;
+
+	/** Separates changes of the resource index from lookups. */
+	mutable Common::ReadWriteLock _lock;
 
 	FileTypeSet  _archiveTypeTypes [kArchiveMAX];  ///< All valid archive types file types.
 	FileTypeList _resourceTypeTypes[kResourceMAX]; ///< All valid resource type file types.
@@ -506,21 +645,39 @@ private:
 	// '---
 
 	// .--- Indexing archives
-	void indexKEY(Common::SeekableReadStream *stream, uint32 priority, Change *change);
+	void indexKEY(Common::SeekableReadStream *stream, uint32 priority, Change *change,
+	              ResourceIndexCache::Entry &indexed);
 	uint32 openKEYBIFs(Common::SeekableReadStream *keyStream,
 	                   std::vector<KnownArchive *> &archives, std::vector<KEYDataFile *> &keyData);
 
 	void indexArchive(KnownArchive &knownArchive, Archive *archive,
-	                  uint32 priority, Change *change);
+	                  uint32 priority, Change *change, ResourceIndexCache::File &indexed);
+
+	void addArchive(KnownArchive &knownArchive, Archive *archive, const std::vector<byte> &password,
+	                const std::vector<ResourceIndexCache::Resource> &resources,
+	                uint32 priority, Change *change);
 
 	Common::SeekableReadStream *openArchiveStream(const KnownArchive &archive) const;
+	Archive *openArchive(const KnownArchive &archive, const std::vector<byte> &password) const;
+
+	Archive *getArchive(OpenedArchive &archive) const;
+	// '---
+
+	// .--- Resource index cache
+	uint32 getIndexSettings() const;
+
+	bool indexCachedArchive(KnownArchive &knownArchive, uint32 priority,
+	                        const std::vector<byte> &password, Change *change);
+	void addIndexCacheEntry(const KnownArchive &knownArchive, ResourceIndexCache::Entry &indexed);
+
+	void loadIndexCache();
 	// '---
 
 	// .--- Adding resources
 
-	bool checkResourceIsArchive(Resource &resource, Change *change);
+	bool checkResourceIsArchive(uint32 resource, Change *change);
 
-	void addResource(Resource &resource, uint64 hash, Change *change);
+	void addResource(const Resource &resource, uint64 hash, Change *change);
 	void addResource(const Common::UString &path, Change *change, uint32 priority);
 
 	void addResources(const Common::FileList &files, Change *change, uint32 priority);
@@ -534,12 +691,33 @@ private:
 	Common::SeekableReadStream *getResource(const Resource &res, bool tryNoCopy = false) const;
 
 	Common::SeekableReadStream *getArchiveResource(const Resource &res, bool tryNoCopy = false) const;
+	Common::SeekableReadStream *getCachedArchiveResource(const Resource &res) const;
 
 	uint32 getResourceSize(const Resource &res) const;
 	// '---
 
+	// .--- Resource records
+	void clearResourceTable();
+
+	size_t findResourceSlot(uint64 hash) const;
+	size_t insertResourceSlot(uint64 hash);
+	void growResourceTable();
+
+	uint32 newResource(const Resource &resource);
+	void removeResource(uint32 resource);
+
+	const Resource *getResourceRecord(const KnownArchive &archive) const;
+
+	uint32 addName(const Common::UString &name);
+	void retainName(uint32 name);
+	void releaseName(uint32 name);
+	Common::UString getName(uint32 name) const;
+
+	void compactNames();
+	// '---
+
 	// .--- Resource utility methods
-	bool normalizeType(Resource &resource);
+	bool normalizeType(FileType &type);
 
 	ArchiveType     getArchiveType(FileType type) const;
 	ArchiveType     getArchiveType(const Common::UString &name) const;
@@ -548,7 +726,7 @@ private:
 	inline uint64 getHash(const Common::UString &name, FileType type) const;
 	inline uint64 getHash(const Common::UString &name) const;
 
-	void checkHashCollision(const Resource &resource, ResourceMap::const_iterator resList);
+	void checkHashCollision(const Resource &resource, uint32 resList);
 
 	Change *newChangeSet(Common::ChangeID &changeID);
 	// '---
@@ -22,6 +22,7 @@
  *  A ZIP archive.
  */
 
+#include "src/common/system.h"
 #include "src/common/zipfile.h"
 #include "src/common/filepath.h"
 
@@ -49,8 +50,17 @@ uint32 ZIPFile::getResourceSize(uint32 index) const {
 	return _zipFile->getFileSize(index);
 }
 
-Common::SeekableReadStream *ZIPFile::getResource(uint32 index, bool tryNoCopy) const {
-	return _zipFile->getFile(index, tryNoCopy);
+Common::SeekableReadStream *ZIPFile::getResource(uint32 index, bool UNUSED(tryNoCopy)) const {
+	/* Common::ZipFile seeks in the shared ZIP stream, and a non-copying
+	 * sub stream would keep on using it after we let go of the lock. */
+	std::lock_guard<std::mutex> lock(_streamMutex);
+
+	return _zipFile->getFile(index, false);
+}
+
+bool ZIPFile::hasPackedResources() const {
+	// ZIP files are usually deflated, we don't look at each resource
+	return true;
 }
 
 void ZIPFile::load() {
@@ -54,6 +54,9 @@ public:
 	/** Return a stream of the resource's contents. */
 	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
 
+	/** Are the resources stored compressed or encrypted? */
+	bool hasPackedResources() const;
+
 private:
 	/** The actual zip file. */
 	Common::ScopedPtr<Common::ZipFile> _zipFile;
@@ -61,6 +61,9 @@ static void displayUsage(const Common::UString &name) {
 	std::printf("          --nologfile=BOOL    Don't write a log file.\n");
 	std::printf("          --consolelog=FILE   Write all debug console output into this file too.\n");
 	std::printf("          --noconsolelog=BOOL Don't write a debug console log file.\n");
+	std::printf("          --rebuild-resource-cache\n");
+	std::printf("                              Index all game archives anew, instead of reading\n");
+	std::printf("                              the resource index cache.\n");
 	std::printf("\n");
 	std::printf("FILE: Absolute or relative path to a file.\n");
 	std::printf("DIR:  Absolute or relative path to a directory.\n");
@@ -237,6 +240,11 @@ bool parseCommandline(const std::vector<Common::UString> &argv, Common::UString
 				key.clear();
 			}
 
+			if (key == "rebuild-resource-cache") {
+				setOption(key, "true");
+				key.clear();
+			}
+
 			continue;
 		}
 
@@ -26,6 +26,7 @@
 #include "src/common/geometry.h"
 #include "src/common/util.h"
 #include "src/common/aabbnode.h"
+#include "src/common/frustum.h"
 
 namespace Common {
 
@@ -150,6 +151,36 @@ void AABBNode::getNodes(float x1, float y1, float z1, float x2, float y2, float
 	_rightChild->getNodes(x1, y1, z1, x2, y2, z2, nodes);
 }
 
+void AABBNode::getNodes(const Frustum &frustum, std::vector<AABBNode *> &nodes) {
+	const Frustum::Intersection intersection = frustum.intersect(_min, _max);
+	if (intersection == Frustum::kOutside)
+		return;
+
+	if (!hasChildren()) {
+		nodes.push_back(this);
+		return;
+	}
+
+	// Everything in a branch completely inside the frustum is inside as well
+	if (intersection == Frustum::kInside) {
+		getLeaves(nodes);
+		return;
+	}
+
+	_leftChild->getNodes(frustum, nodes);
+	_rightChild->getNodes(frustum, nodes);
+}
+
+void AABBNode::getLeaves(std::vector<AABBNode *> &nodes) {
+	if (!hasChildren()) {
+		nodes.push_back(this);
+		return;
+	}
+
+	_leftChild->getLeaves(nodes);
+	_rightChild->getLeaves(nodes);
+}
+
 int32 AABBNode::getProperty() const {
 	return _property;
 }
@@ -239,4 +270,24 @@ void AABBNode::getNodesInSegment(glm::vec3 start, glm::vec3 end, std::vector<AAB
 	_rightChild->getNodesInSegment(start, end, nodes);
 }
 
+void AABBNode::refit(const float min[3], const float max[3]) {
+	for (int i = 0; i < 3; ++i) {
+		_min[i] = min[i];
+		_max[i] = max[i];
+	}
+
+	for (AABBNode *node = _parent; node; node = node->_parent)
+		node->fitChildren();
+}
+
+void AABBNode::fitChildren() {
+	if (!hasChildren())
+		return;
+
+	for (int i = 0; i < 3; ++i) {
+		_min[i] = MIN(_leftChild->_min[i], _rightChild->_min[i]);
+		_max[i] = MAX(_leftChild->_max[i], _rightChild->_max[i]);
+	}
+}
+
 } // End of namespace Common
@@ -32,6 +32,8 @@
 
 namespace Common {
 
+class Frustum;
+
 class AABBNode : public BoundingBox {
 public:
 	/** Construct an axis-align bounding box.
@@ -73,6 +75,10 @@ public:
 	void getNodesInAABox2D(glm::vec2 min, glm::vec2 max, std::vector<AABBNode *> &nodes);
 	/** Get the nodes that intersect a given segment in the XY plane. */
 	void getNodesInSegment(glm::vec3 start, glm::vec3 end, std::vector<AABBNode *> &nodes);
+	/** Get the nodes that are at least partially inside a given view frustum. */
+	void getNodes(const Frustum &frustum, std::vector<AABBNode *> &nodes);
+	/** Get all the leaf nodes of this branch. */
+	void getLeaves(std::vector<AABBNode *> &nodes);
 	/** Get the property of the AABB. */
 	int32 getProperty() const;
 	/** Add a given value to the leaves nodes. */
@@ -80,7 +86,17 @@ public:
 	/** Ensure the parent surrounds the node. */
 	void surroundParent();
 
+	/** Give the node new bounds, and tightly refit all its ancestors around their children.
+	 *
+	 *  Unlike surroundParent(), this also shrinks the ancestors when
+	 *  the node got smaller or moved away.
+	 */
+	void refit(const float min[3], const float max[3]);
+
 private:
+	/** Tightly fit this node around its children. */
+	void fitChildren();
+
 	AABBNode *_parent;     ///< The parent node.
 	AABBNode *_leftChild;  ///< Left child.
 	AABBNode *_rightChild; ///< Right child.
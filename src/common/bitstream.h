@@ -30,6 +30,7 @@
 #include <boost/noncopyable.hpp>
 
 #include "src/common/types.h"
+#include "src/common/util.h"
 #include "src/common/disposableptr.h"
 #include "src/common/error.h"
 #include "src/common/readstream.h"
@@ -63,9 +64,19 @@ public:
 	/** Read a multi-bit value from the bit stream. */
 	virtual uint32 getBits(size_t n) = 0;
 
+	/** Read a multi-bit value from the bit stream, without consuming it.
+	 *
+	 *  The bits are returned in the same order getBits() would return them.
+	 *  Bits past the end of the stream are read as 0.
+	 */
+	virtual uint32 peekBits(size_t n) = 0;
+
 	/** Add a bit to the n-bit value x, making it an (n+1)-bit value. */
 	virtual void addBit(uint32 &x, size_t n) = 0;
 
+	/** Are the bits of each data value handed out MSB first? */
+	virtual bool isMSBFirst() const = 0;
+
 protected:
 	BitStream() {
 	}
@@ -125,7 +136,15 @@ private:
 		// If we're reading the bits MSB first, we need to shift the value to that position
 		if (isMSB2LSB)
 			_value <<= 64 - valueBits;
-		}
+	}
+
+	/** Shift n bits out of the current value. */
+	inline void shiftValue(size_t n) {
+		if (isMSB2LSB)
+			_value <<= n;
+		else
+			_value >>= n;
+	}
 
 public:
 	/** Create a bit stream using this input data stream and optionally delete it on destruction. */
@@ -209,6 +228,11 @@ public:
 			x = (x & ~(1 << n)) | (getBit() << n);
 	}
 
+	/** Are the bits of each data value handed out MSB first? */
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
 	/** Rewind the bit stream back to the start. */
 	void rewind() {
 		_stream->seek(0);
@@ -219,8 +243,71 @@ public:
 
 	/** Skip the specified amount of bits. */
 	void skip(size_t n) {
-		while (n-- > 0)
-			getBit();
+		// Use up what's left in the current value
+		if ((n > 0) && (_inValue != 0)) {
+			const size_t count = MIN<size_t>(n, valueBits - _inValue);
+
+			shiftValue(count);
+			_inValue = (_inValue + count) % valueBits;
+
+			n -= count;
+		}
+
+		// Skip whole values directly in the data stream
+		if (n >= valueBits) {
+			const size_t values = n / valueBits;
+			if ((size() - pos()) < (values * valueBits))
+				throw Exception("BitStream::skip(): End of bit stream reached");
+
+			_stream->skip(values * (valueBits / 8));
+
+			n -= values * valueBits;
+		}
+
+		// And read a new value for the remaining bits
+		if (n > 0) {
+			readValue();
+
+			shiftValue(n);
+			_inValue = n;
+		}
+	}
+
+	/** Read a multi-bit value from the bit stream, without consuming it. */
+	uint32 peekBits(size_t n) {
+		if (n == 0)
+			return 0;
+
+		if (n > 32)
+			throw Exception("Too many bits requested to be read");
+
+		// The bits still left in the current value. Consumed bits have been shifted out
+		uint64 value = _value;
+		size_t count = (_inValue == 0) ? 0 : (valueBits - _inValue);
+
+		if (count < n) {
+			// Temporarily read ahead as many values as we need and that are available
+			const size_t streamPos = _stream->pos();
+			size_t valuesLeft = (_stream->size() - streamPos) / (valueBits / 8);
+
+			while ((count < n) && (valuesLeft-- > 0)) {
+				const uint64 data = readData();
+
+				if (isMSB2LSB)
+					value |= (data << (64 - valueBits)) >> count;
+				else
+					value |= data << count;
+
+				count += valueBits;
+			}
+
+			_stream->seek(streamPos);
+		}
+
+		if (isMSB2LSB)
+			return (uint32) (value >> (64 - n));
+
+		return (uint32) (value & (0xFFFFFFFFFFFFFFFFULL >> (64 - n)));
 	}
 
 	/** Return the stream position in bits. */
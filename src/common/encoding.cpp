@@ -33,6 +33,7 @@
 #include "src/common/error.h"
 #include "src/common/scopedptr.h"
 #include "src/common/singleton.h"
+#include "src/common/mutex.h"
 #include "src/common/ustring.h"
 #include "src/common/memreadstream.h"
 #include "src/common/writestream.h"
@@ -116,6 +117,9 @@ private:
 	iconv_t _contextFrom[kEncodingMAX];
 	iconv_t _contextTo  [kEncodingMAX];
 
+	/** The iconv contexts carry conversion state, so only one thread may use them at a time. */
+	std::mutex _mutex;
+
 	byte *doConvert(iconv_t &ctx, byte *data, size_t nIn, size_t nOut, size_t &size) {
 		size_t inBytes  = nIn;
 		size_t outBytes = nOut;
@@ -124,6 +128,8 @@ private:
 
 		byte *outBuf = convData.get();
 
+		std::lock_guard<std::mutex> lock(_mutex);
+
 		// Reset the converter's state
 		iconv(ctx, 0, 0, 0, 0);
 
@@ -177,12 +183,20 @@ private:
 
 }
 
-#define ConvMan Common::ConversionManager::instance()
-
 DECLARE_SINGLETON(Common::ConversionManager)
 
 namespace Common {
 
+/** Strings are read from several threads at once, so create the manager exactly once. */
+static ConversionManager &getConversionManager() {
+	static std::once_flag created;
+	std::call_once(created, []() { ConversionManager::instance(); });
+
+	return ConversionManager::instance();
+}
+
+#define ConvMan Common::getConversionManager()
+
 UString getEncodingName(Encoding encoding) {
 	if (((size_t) encoding) >= kEncodingMAX)
 		return "Invalid";
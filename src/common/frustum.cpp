@@ -0,0 +1,98 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A view frustum.
+ */
+
+#include "external/glm/geometric.hpp"
+
+#include "src/common/frustum.h"
+
+namespace Common {
+
+Frustum::Frustum() {
+	// Planes that no point can be behind of
+	for (int i = 0; i < 6; i++)
+		_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+Frustum::Frustum(const glm::mat4 &matrix) {
+	set(matrix);
+}
+
+void Frustum::set(const glm::mat4 &matrix) {
+	/* A point p is within the clip volume when -w <= x, y, z <= w, with
+	 * (x, y, z, w) = matrix * p. Each of these inequalities is a plane,
+	 * made up of the sum or difference of two rows of the matrix.
+	 * (Gribb & Hartmann, "Fast Extraction of Viewing Frustum Planes
+	 * from the World-View-Projection Matrix") */
+
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+
+	_planes[0] = rows[3] + rows[0];
+	_planes[1] = rows[3] - rows[0];
+	_planes[2] = rows[3] + rows[1];
+	_planes[3] = rows[3] - rows[1];
+	_planes[4] = rows[3] + rows[2];
+	_planes[5] = rows[3] - rows[2];
+
+	for (int i = 0; i < 6; i++) {
+		const float length = glm::length(glm::vec3(_planes[i]));
+		if (length > 0.0f)
+			_planes[i] /= length;
+	}
+}
+
+Frustum::Intersection Frustum::intersect(const float min[3], const float max[3]) const {
+	Intersection result = kInside;
+
+	for (int i = 0; i < 6; i++) {
+		const glm::vec4 &plane = _planes[i];
+
+		// The corners of the box the farthest along and against the plane normal
+		float pDist = plane[3], nDist = plane[3];
+		for (int j = 0; j < 3; j++) {
+			if (plane[j] >= 0.0f) {
+				pDist += plane[j] * max[j];
+				nDist += plane[j] * min[j];
+			} else {
+				pDist += plane[j] * min[j];
+				nDist += plane[j] * max[j];
+			}
+		}
+
+		if (pDist < 0.0f)
+			return kOutside;
+
+		if (nDist < 0.0f)
+			result = kIntersecting;
+	}
+
+	return result;
+}
+
+bool Frustum::isIn(const float min[3], const float max[3]) const {
+	return intersect(min, max) != kOutside;
+}
+
+} // End of namespace Common
@@ -0,0 +1,68 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A view frustum.
+ */
+
+#ifndef COMMON_FRUSTUM_H
+#define COMMON_FRUSTUM_H
+
+#include "external/glm/mat4x4.hpp"
+#include "external/glm/vec4.hpp"
+
+namespace Common {
+
+/** The six clipping planes of a view frustum, used to cull axis-aligned boxes.
+ *
+ *  The planes are extracted from a combined projection and modelview matrix,
+ *  so they live in the same space the matrix transforms from. They are
+ *  normalized, with their normals pointing into the frustum.
+ */
+class Frustum {
+public:
+	/** Where a box lies in relation to the frustum. */
+	enum Intersection {
+		kOutside,      ///< The box is completely outside the frustum.
+		kIntersecting, ///< The box is partially inside the frustum.
+		kInside        ///< The box is completely inside the frustum.
+	};
+
+	/** Create a frustum enclosing all of space. */
+	Frustum();
+	/** Create the frustum of a combined projection and modelview matrix. */
+	Frustum(const glm::mat4 &matrix);
+
+	/** Extract the planes of a combined projection and modelview matrix. */
+	void set(const glm::mat4 &matrix);
+
+	/** Where does an axis-aligned box lie in relation to the frustum? */
+	Intersection intersect(const float min[3], const float max[3]) const;
+
+	/** Is an axis-aligned box at least partially inside the frustum? */
+	bool isIn(const float min[3], const float max[3]) const;
+
+private:
+	glm::vec4 _planes[6]; ///< Left, right, bottom, top, near and far plane.
+};
+
+} // End of namespace Common
+
+#endif // COMMON_FRUSTUM_H
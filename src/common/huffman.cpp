@@ -24,6 +24,9 @@
 
 #include <cassert>
 
+#include <algorithm>
+#include <map>
+
 #include "src/common/huffman.h"
 #include "src/common/util.h"
 #include "src/common/error.h"
@@ -31,7 +34,26 @@
 
 namespace Common {
 
-Huffman::Symbol::Symbol(uint32 c, uint32 s) : code(c), symbol(s) {
+/** The maximum number of bits looked up at once. */
+static const uint8 kTableBits = 9;
+
+static uint32 reverseBits(uint32 value, uint8 n) {
+	uint32 reversed = 0;
+	for (uint8 i = 0; i < n; i++, value >>= 1)
+		reversed = (reversed << 1) | (value & 1);
+
+	return reversed;
+}
+
+
+Huffman::TableEntry::TableEntry() : value(0), length(0) {
+}
+
+Huffman::Code::Code(uint32 c, uint8 l, uint32 i) : code(c), length(l), index(i) {
+}
+
+bool Huffman::Code::operator<(const Code &c) const {
+	return length < c.length;
 }
 
 
@@ -59,41 +81,120 @@ void Huffman::init(uint8 maxLength, size_t codeCount, const uint32 *codes,
 
 	assert(maxLength <= 32);
 
-	_codes.resize(maxLength);
 	_symbols.resize(codeCount);
+	setSymbols(symbols);
+
+	CodeList codesMSB, codesLSB;
+	codesMSB.reserve(codeCount);
+	codesLSB.reserve(codeCount);
 
 	for (size_t i = 0; i < codeCount; i++) {
-		// The symbol. If none were specified, just assume it's identical to the code index
-		uint32 symbol = symbols ? symbols[i] : i;
+		assert((lengths[i] > 0) && (lengths[i] <= maxLength));
 
-		// Put the code and symbol into the correct list
-		_codes[lengths[i] - 1].push_back(Symbol(codes[i], symbol));
+		// A code with bits set beyond its length can never be matched
+		if ((lengths[i] < 32) && ((codes[i] >> lengths[i]) != 0))
+			continue;
 
-		// And put the pointer to the symbol/code struct into the symbol list.
-		_symbols[i] = &_codes[lengths[i] - 1].back();
+		// Bring the code into stream order, for both bit orders
+		codesMSB.push_back(Code(codes[i], lengths[i], i));
+		codesLSB.push_back(Code(reverseBits(codes[i], lengths[i]), lengths[i], i));
 	}
+
+	// Shorter codes take precedence, and then the ones that come first
+	std::stable_sort(codesMSB.begin(), codesMSB.end());
+	std::stable_sort(codesLSB.begin(), codesLSB.end());
+
+	_tableBits = MIN(maxLength, kTableBits);
+
+	_tableMSB.resize(1 << _tableBits);
+	_tableLSB.resize(1 << _tableBits);
+
+	buildTable(_tableMSB, 0, _tableBits, codesMSB, false);
+	buildTable(_tableLSB, 0, _tableBits, codesLSB, true);
 }
 
 Huffman::~Huffman() {
 }
 
+void Huffman::buildTable(Table &table, size_t offset, uint8 tableBits, const CodeList &codes, bool lsb) {
+	// Codes too long for this table, by their table index
+	std::map<uint32, CodeList> longCodes;
+
+	for (CodeList::const_iterator c = codes.begin(); c != codes.end(); ++c) {
+		if (c->length > tableBits) {
+			const uint8  restLength = c->length - tableBits;
+			const uint32 prefix     = c->code >> restLength;
+			const uint32 index      = lsb ? reverseBits(prefix, tableBits) : prefix;
+
+			// Already taken by a shorter code
+			if (table[offset + index].length > 0)
+				continue;
+
+			longCodes[index].push_back(Code(c->code & ((1U << restLength) - 1), restLength, c->index));
+			continue;
+		}
+
+		// Fill all entries that start with this code
+		const uint8 fillLength = tableBits - c->length;
+		for (uint32 i = 0; i < (1U << fillLength); i++) {
+			const uint32 bits  = (c->code << fillLength) | i;
+			const uint32 index = lsb ? reverseBits(bits, tableBits) : bits;
+
+			TableEntry &entry = table[offset + index];
+			if (entry.length != 0)
+				continue;
+
+			entry.value  = c->index;
+			entry.length = c->length;
+		}
+	}
+
+	for (std::map<uint32, CodeList>::const_iterator l = longCodes.begin(); l != longCodes.end(); ++l) {
+		// The codes are sorted by length, so the last one is the longest
+		const uint8  subBits   = MIN(l->second.back().length, kTableBits);
+		const size_t subOffset = table.size();
+
+		table.resize(subOffset + (1 << subBits));
+
+		table[offset + l->first].value  = subOffset;
+		table[offset + l->first].length = -((int8) subBits);
+
+		buildTable(table, subOffset, subBits, l->second, lsb);
+	}
+}
+
 void Huffman::setSymbols(const uint32 *symbols) {
 	for (size_t i = 0; i < _symbols.size(); i++)
-		_symbols[i]->symbol = symbols ? *symbols++ : i;
+		_symbols[i] = symbols ? *symbols++ : i;
 }
 
 uint32 Huffman::getSymbol(BitStream &bits) const {
-	uint32 code = 0;
+	if (bits.isMSBFirst())
+		return _symbols[getSymbol(bits, _tableMSB, _tableBits)];
 
-	for (size_t i = 0; i < _codes.size(); i++) {
-		bits.addBit(code, i);
+	return _symbols[getSymbol(bits, _tableLSB, _tableBits)];
+}
 
-		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
-			if (code == cCode->code)
-				return cCode->symbol;
-	}
+uint32 Huffman::getSymbol(BitStream &bits, const Table &table, uint8 tableBits) {
+	size_t offset = 0;
+
+	while (true) {
+		const TableEntry &entry = table[offset + bits.peekBits(tableBits)];
+
+		if (entry.length > 0) {
+			bits.skip(entry.length);
+			return entry.value;
+		}
 
-	throw Exception("Unknown Huffman code");
+		if (entry.length == 0)
+			throw Exception("Unknown Huffman code");
+
+		// Continue in the secondary table
+		bits.skip(tableBits);
+
+		offset    = entry.value;
+		tableBits = -entry.length;
+	}
 }
 
 } // End of namespace Common
@@ -26,7 +26,6 @@
 #define COMMON_HUFFMAN_H
 
 #include <vector>
-#include <list>
 
 #include "src/common/types.h"
 
@@ -62,29 +61,62 @@ public:
 	/** Modify the codes' symbols. */
 	void setSymbols(const uint32 *symbols = 0);
 
-	/** Return the next symbol in the bitstream. */
+	/** Return the next symbol in the bitstream.
+	 *
+	 *  Several bits are looked up at once. For bit streams reading the MSB
+	 *  first, the first bit read is the MSB of a code. Otherwise, it's the LSB.
+	 */
 	uint32 getSymbol(BitStream &bits) const;
 
 private:
-	struct Symbol {
+	/** An entry in a lookup table.
+	 *
+	 *  If length is positive, value is the index of the code that consists of
+	 *  the first length bits of the table index. If length is negative, value
+	 *  is the offset of a secondary table indexed by -length further bits.
+	 *  If length is 0, no code starts with these bits.
+	 */
+	struct TableEntry {
+		uint32 value;
+		int8   length;
+
+		TableEntry();
+	};
+
+	/** A code, with its bits in stream order, i.e. the first bit in the MSB. */
+	struct Code {
 		uint32 code;
-		uint32 symbol;
+		uint8  length;
+		uint32 index;
+
+		Code(uint32 c, uint8 l, uint32 i);
 
-		Symbol(uint32 c, uint32 s);
+		/** Order codes by length. */
+		bool operator<(const Code &c) const;
 	};
 
-	typedef std::list<Symbol>     CodeList;
-	typedef std::vector<CodeList> CodeLists;
-	typedef std::vector<Symbol *> SymbolList;
+	typedef std::vector<TableEntry> Table;
+	typedef std::vector<Code>       CodeList;
+
+	/** Number of bits we look up at once. */
+	uint8 _tableBits;
 
-	/** Lists of codes and their symbols, sorted by code length. */
-	CodeLists _codes;
+	/** Lookup tables for bit streams reading the MSB first. */
+	Table _tableMSB;
+	/** Lookup tables for bit streams reading the LSB first. */
+	Table _tableLSB;
 
-	/** Sorted list of pointers to the symbols. */
-	SymbolList _symbols;
+	/** The symbols of all codes. */
+	std::vector<uint32> _symbols;
 
 	void init(uint8 maxLength, size_t codeCount, const uint32 *codes,
 	          const uint8 *lengths, const uint32 *symbols);
+
+	/** Fill a lookup table with the given codes, recursively creating secondary tables. */
+	static void buildTable(Table &table, size_t offset, uint8 tableBits,
+	                       const CodeList &codes, bool lsb);
+
+	static uint32 getSymbol(BitStream &bits, const Table &table, uint8 tableBits);
 };
 
 } // End of namespace Common
@@ -0,0 +1,176 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Implementing the stream reading interfaces for memory-mapped files.
+ */
+
+#include "src/common/system.h"
+
+#if defined(WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include <boost/filesystem/path.hpp>
+
+#include "src/common/mappedfile.h"
+#include "src/common/error.h"
+#include "src/common/ustring.h"
+
+namespace Common {
+
+#if defined(WIN32)
+
+MappedFile::MappedFile(const UString &fileName) : _data(0), _size(0), _file(0), _mapping(0) {
+	HANDLE file = CreateFileW(boost::filesystem::path(fileName.c_str()).c_str(), GENERIC_READ,
+	                          FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		throw Exception("Can't open file \"%s\"", fileName.c_str());
+
+	_file = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || ((uint64)fileSize.QuadPart > (uint64)SIZE_MAX)) {
+		unmap();
+		throw Exception("Can't map file \"%s\"", fileName.c_str());
+	}
+
+	_size = (size_t)fileSize.QuadPart;
+
+	// Windows can't map empty files. There's nothing to read anyway
+	if (_size == 0)
+		return;
+
+	_mapping = CreateFileMappingW(file, 0, PAGE_READONLY, 0, 0, 0);
+	if (_mapping)
+		_data = static_cast<const byte *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (!_data) {
+		unmap();
+		throw Exception("Can't map file \"%s\"", fileName.c_str());
+	}
+}
+
+void MappedFile::unmap() {
+	if (_data)
+		UnmapViewOfFile(_data);
+	if (_mapping)
+		CloseHandle(_mapping);
+	if (_file)
+		CloseHandle(_file);
+
+	_data    = 0;
+	_size    = 0;
+	_mapping = 0;
+	_file    = 0;
+}
+
+#else
+
+MappedFile::MappedFile(const UString &fileName) : _data(0), _size(0) {
+	const int fd = ::open(boost::filesystem::path(fileName.c_str()).c_str(), O_RDONLY);
+	if (fd < 0)
+		throw Exception("Can't open file \"%s\"", fileName.c_str());
+
+	struct stat fileStat;
+	if ((fstat(fd, &fileStat) != 0) || (fileStat.st_size < 0) ||
+	    ((uint64)fileStat.st_size > (uint64)SIZE_MAX)) {
+
+		::close(fd);
+		throw Exception("Can't map file \"%s\"", fileName.c_str());
+	}
+
+	_size = (size_t)fileStat.st_size;
+
+	// Empty files can't be mapped. There's nothing to read anyway
+	if (_size == 0) {
+		::close(fd);
+		return;
+	}
+
+	void *data = mmap(0, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// The mapping holds its own reference to the file
+	::close(fd);
+
+	if (data == MAP_FAILED) {
+		_size = 0;
+		throw Exception("Can't map file \"%s\"", fileName.c_str());
+	}
+
+	_data = static_cast<const byte *>(data);
+}
+
+void MappedFile::unmap() {
+	if (_data)
+		munmap(const_cast<byte *>(_data), _size);
+
+	_data = 0;
+	_size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+	unmap();
+}
+
+const byte *MappedFile::getData() const {
+	return _data;
+}
+
+size_t MappedFile::size() const {
+	return _size;
+}
+
+
+MappedReadStream::MappedReadStream(const UString &fileName) :
+	MappedReadStream(boost::shared_ptr<MappedFile>(new MappedFile(fileName))) {
+
+}
+
+MappedReadStream::MappedReadStream(const boost::shared_ptr<MappedFile> &file) :
+	MemoryReadStream(file->getData(), file->size()), _file(file) {
+
+}
+
+MappedReadStream::MappedReadStream(const boost::shared_ptr<MappedFile> &file, const byte *data, size_t size) :
+	MemoryReadStream(data, size), _file(file) {
+
+}
+
+MappedReadStream::~MappedReadStream() {
+}
+
+MappedReadStream *MappedReadStream::getSubStream(size_t begin, size_t end) const {
+	if ((begin > end) || (end > size()))
+		throw Exception("Sub stream [%u, %u) out of range (%u)", (uint)begin, (uint)end, (uint)size());
+
+	return new MappedReadStream(_file, getData() + begin, end - begin);
+}
+
+} // End of namespace Common
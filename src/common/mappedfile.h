@@ -0,0 +1,91 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Implementing the stream reading interfaces for memory-mapped files.
+ */
+
+#ifndef COMMON_MAPPEDFILE_H
+#define COMMON_MAPPEDFILE_H
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "src/common/types.h"
+#include "src/common/memreadstream.h"
+
+namespace Common {
+
+class UString;
+
+/** A whole file, mapped read-only into memory. */
+class MappedFile : boost::noncopyable {
+public:
+	/** Map the file with the given fileName. Throws when that fails. */
+	MappedFile(const UString &fileName);
+	~MappedFile();
+
+	const byte *getData() const;
+	size_t size() const;
+
+private:
+	const byte *_data; ///< The start of the mapping.
+	size_t _size;      ///< The file's size.
+
+#if defined(WIN32)
+	void *_file;    ///< The Windows file handle.
+	void *_mapping; ///< The Windows file mapping handle.
+#endif
+
+	void unmap();
+};
+
+/** A stream reading directly out of a memory-mapped file.
+ *
+ *  Reading never does any system calls or file seeks; the data is
+ *  simply copied out of the mapping. Since the mapping is immutable,
+ *  getSubStream() can be called from several threads at the same time.
+ *  Each sub stream keeps the mapping alive and has its own position,
+ *  so it stays valid even after the stream it was created from has
+ *  been deleted.
+ */
+class MappedReadStream : public MemoryReadStream {
+public:
+	/** Map the file with the given fileName. Throws when that fails. */
+	MappedReadStream(const UString &fileName);
+	~MappedReadStream();
+
+	/** Create a new stream viewing a part of this stream, without copying.
+	 *
+	 *  The part is given by offsets from the start of this stream. The
+	 *  position of this stream is neither used nor changed.
+	 */
+	MappedReadStream *getSubStream(size_t begin, size_t end) const;
+
+private:
+	MappedReadStream(const boost::shared_ptr<MappedFile> &file);
+	MappedReadStream(const boost::shared_ptr<MappedFile> &file, const byte *data, size_t size);
+
+	boost::shared_ptr<MappedFile> _file;
+};
+
+} // End of namespace Common
+
+#endif // COMMON_MAPPEDFILE_H
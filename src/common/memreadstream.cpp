@@ -51,6 +51,7 @@
 #include <cstring>
 
 #include "src/common/memreadstream.h"
+#include "src/common/scopedptr.h"
 #include "src/common/error.h"
 #include "src/common/util.h"
 
@@ -115,4 +116,18 @@ MemoryReadStreamEndian::MemoryReadStreamEndian(const byte *dataPtr, size_t dataS
 MemoryReadStreamEndian::~MemoryReadStreamEndian() {
 }
 
+
+MemoryReadStream *toMemoryStream(SeekableReadStream *stream) {
+	assert(stream);
+
+	MemoryReadStream *memory = dynamic_cast<MemoryReadStream *>(stream);
+	if (memory)
+		return memory;
+
+	ScopedPtr<SeekableReadStream> original(stream);
+
+	original->seek(0);
+	return original->readStream(original->size());
+}
+
 } // End of namespace Common
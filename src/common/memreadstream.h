@@ -138,15 +138,15 @@ public:
 		return _bigEndian ? readUint64BE() : readUint64LE();
 	}
 
-	uint16 readSint16() {
+	int16 readSint16() {
 		return _bigEndian ? readSint16BE() : readSint16LE();
 	}
 
-	uint32 readSint32() {
+	int32 readSint32() {
 		return _bigEndian ? readSint32BE() : readSint32LE();
 	}
 
-	uint64 readSint64() {
+	int64 readSint64() {
 		return _bigEndian ? readSint64BE() : readSint64LE();
 	}
 
@@ -159,6 +159,14 @@ public:
 	}
 };
 
+/** Take over this stream and return a MemoryReadStream holding its whole contents.
+ *
+ *  If the stream already is a MemoryReadStream (including a memory-mapped one),
+ *  it is returned directly, without copying. Otherwise, the complete stream is
+ *  read into memory and the original stream is deleted.
+ */
+MemoryReadStream *toMemoryStream(SeekableReadStream *stream);
+
 } // End of namespace Common
 
 #endif // COMMON_MEMREADSTREAM_H
@@ -0,0 +1,120 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A lock allowing either many readers or one writer.
+ */
+
+#include <cassert>
+
+#include "src/common/readwritelock.h"
+
+namespace Common {
+
+ReadWriteLock::ReadWriteLock() : _readers(0), _writersWaiting(0), _writeDepth(0) {
+}
+
+ReadWriteLock::~ReadWriteLock() {
+	assert((_readers == 0) && (_writeDepth == 0));
+}
+
+bool ReadWriteLock::isWriter() const {
+	return (_writeDepth > 0) && (_writer == std::this_thread::get_id());
+}
+
+void ReadWriteLock::lockRead() {
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	// The writer may read what it has written
+	if (isWriter()) {
+		_writeDepth++;
+		return;
+	}
+
+	while ((_writeDepth > 0) || (_writersWaiting > 0))
+		_condition.wait(lock);
+
+	_readers++;
+}
+
+void ReadWriteLock::unlockRead() {
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	if (isWriter()) {
+		_writeDepth--;
+		return;
+	}
+
+	assert(_readers > 0);
+
+	if (--_readers == 0)
+		_condition.notify_all();
+}
+
+void ReadWriteLock::lockWrite() {
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	if (isWriter()) {
+		_writeDepth++;
+		return;
+	}
+
+	_writersWaiting++;
+
+	while ((_writeDepth > 0) || (_readers > 0))
+		_condition.wait(lock);
+
+	_writersWaiting--;
+
+	_writeDepth = 1;
+	_writer     = std::this_thread::get_id();
+}
+
+void ReadWriteLock::unlockWrite() {
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	assert(isWriter());
+
+	if (--_writeDepth == 0) {
+		_writer = std::thread::id();
+
+		_condition.notify_all();
+	}
+}
+
+
+ReadLock::ReadLock(ReadWriteLock &lock) : _lock(&lock) {
+	_lock->lockRead();
+}
+
+ReadLock::~ReadLock() {
+	_lock->unlockRead();
+}
+
+
+WriteLock::WriteLock(ReadWriteLock &lock) : _lock(&lock) {
+	_lock->lockWrite();
+}
+
+WriteLock::~WriteLock() {
+	_lock->unlockWrite();
+}
+
+} // End of namespace Common
@@ -0,0 +1,97 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A lock allowing either many readers or one writer.
+ */
+
+#ifndef COMMON_READWRITELOCK_H
+#define COMMON_READWRITELOCK_H
+
+#if defined(__MINGW32__ ) && !defined(_GLIBCXX_HAS_GTHREADS)
+	#include "external/mingw-std-threads/mingw.thread.h"
+#else
+	#include <thread>
+#endif
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/mutex.h"
+
+namespace Common {
+
+/** A lock that can be held by many readers at once, or by one writer.
+ *
+ *  Writers are preferred: once a writer is waiting, no new readers are let
+ *  in, so a steady stream of readers can't starve the writer out.
+ *
+ *  The thread holding the write lock may lock again, for reading or for
+ *  writing, as long as every lock is matched with an unlock. A thread
+ *  holding a read lock must neither lock for reading again, nor try to
+ *  get the write lock.
+ */
+class ReadWriteLock : boost::noncopyable {
+public:
+	ReadWriteLock();
+	~ReadWriteLock();
+
+	void lockRead();
+	void unlockRead();
+
+	void lockWrite();
+	void unlockWrite();
+
+private:
+	std::mutex _mutex;
+	std::condition_variable _condition;
+
+	size_t _readers;        ///< Number of threads currently reading.
+	size_t _writersWaiting; ///< Number of threads waiting to write.
+	size_t _writeDepth;     ///< How often the writing thread has locked.
+
+	std::thread::id _writer; ///< The thread currently writing.
+
+	bool isWriter() const;
+};
+
+/** Hold the read lock of a ReadWriteLock for the lifetime of this object. */
+class ReadLock : boost::noncopyable {
+public:
+	ReadLock(ReadWriteLock &lock);
+	~ReadLock();
+
+private:
+	ReadWriteLock *_lock;
+};
+
+/** Hold the write lock of a ReadWriteLock for the lifetime of this object. */
+class WriteLock : boost::noncopyable {
+public:
+	WriteLock(ReadWriteLock &lock);
+	~WriteLock();
+
+private:
+	ReadWriteLock *_lock;
+};
+
+} // End of namespace Common
+
+#endif // COMMON_READWRITELOCK_H
@@ -67,6 +67,7 @@ src_common_libcommon_la_SOURCES += \
     src/common/stringmap.h \
     src/common/readline.h \
     src/common/readfile.h \
+    src/common/mappedfile.h \
     src/common/writefile.h \
     src/common/filepath.h \
     src/common/filelist.h \
@@ -87,9 +88,12 @@ src_common_libcommon_la_SOURCES += \
     src/common/timestamp.h \
     src/common/geometry.h \
     src/common/aabbnode.h \
+    src/common/frustum.h \
     src/common/random.h \
     src/common/mutex.h \
+    src/common/readwritelock.h \
     src/common/semaphore.h \
+    src/common/threadpool.h \
     $(EMPTY)
 
 src_common_libcommon_la_SOURCES += \
@@ -124,6 +128,7 @@ src_common_libcommon_la_SOURCES += \
     src/common/stringmap.cpp \
     src/common/readline.cpp \
     src/common/readfile.cpp \
+    src/common/mappedfile.cpp \
     src/common/writefile.cpp \
     src/common/filepath.cpp \
     src/common/filelist.cpp \
@@ -140,8 +145,11 @@ src_common_libcommon_la_SOURCES += \
     src/common/rational.cpp \
     src/common/timestamp.cpp \
     src/common/aabbnode.cpp \
+    src/common/frustum.cpp \
     src/common/random.cpp \
     src/common/semaphore.cpp \
+    src/common/threadpool.cpp \
+    src/common/readwritelock.cpp \
     $(EMPTY)
 
 lzma_sources = \
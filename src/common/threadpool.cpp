@@ -0,0 +1,213 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A pool of worker threads shared by all subsystems.
+ */
+
+#include <cassert>
+
+#include "src/common/threadpool.h"
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+DECLARE_SINGLETON(Common::ThreadPool)
+
+namespace Common {
+
+ThreadPool::ThreadPool(size_t threadCount) : _stop(false) {
+	if (threadCount == 0)
+		threadCount = MAX<size_t>(std::thread::hardware_concurrency(), 2) - 1;
+
+	_workers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; i++)
+		_workers.push_back(std::thread(&ThreadPool::workerMethod, this));
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_stop = true;
+	}
+
+	_jobsQueued.notify_all();
+
+	for (std::vector<std::thread>::iterator w = _workers.begin(); w != _workers.end(); ++w)
+		w->join();
+}
+
+size_t ThreadPool::getThreadCount() const {
+	return _workers.size();
+}
+
+bool ThreadPool::isWorkerThread() const {
+	const std::thread::id id = std::this_thread::get_id();
+
+	for (std::vector<std::thread>::const_iterator w = _workers.begin(); w != _workers.end(); ++w)
+		if (w->get_id() == id)
+			return true;
+
+	return false;
+}
+
+void ThreadPool::run(const Task &task, Priority priority) {
+	queue(Job(task), priority);
+}
+
+void ThreadPool::queue(const Job &job, Priority priority) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_jobs[priority].push_back(job);
+	}
+
+	_jobsQueued.notify_one();
+}
+
+bool ThreadPool::hasJobs() const {
+	for (int i = 0; i < kPriorityMAX; i++)
+		if (!_jobs[i].empty())
+			return true;
+
+	return false;
+}
+
+ThreadPool::Job ThreadPool::takeJob() {
+	for (int i = kPriorityMAX - 1; i >= 0; i--) {
+		if (!_jobs[i].empty()) {
+			Job job = _jobs[i].front();
+			_jobs[i].pop_front();
+
+			return job;
+		}
+	}
+
+	assert(false);
+	return Job();
+}
+
+bool ThreadPool::takeJob(const TaskGroup &group, Job &job) {
+	std::deque<Job> &jobs = _jobs[group._priority];
+
+	for (std::deque<Job>::iterator j = jobs.begin(); j != jobs.end(); ++j) {
+		if (j->group == &group) {
+			job = *j;
+			jobs.erase(j);
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::execute(Job &job) {
+	try {
+		job.task();
+	} catch (...) {
+		if (job.group) {
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			if (!job.group->_exception)
+				job.group->_exception = std::current_exception();
+		} else
+			Common::exceptionDispatcherWarning("Task on the thread pool failed");
+	}
+
+	if (!job.group)
+		return;
+
+	/* Notify while holding the lock, so that the group can't return
+	 * from wait() and be destroyed before we're done with it. */
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (--job.group->_pending == 0)
+		job.group->_finished.notify_all();
+}
+
+void ThreadPool::workerMethod() {
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (true) {
+		while (!_stop && !hasJobs())
+			_jobsQueued.wait(lock);
+
+		// Only stop once everything queued has been run
+		if (!hasJobs())
+			break;
+
+		Job job = takeJob();
+
+		lock.unlock();
+		execute(job);
+		lock.lock();
+	}
+}
+
+
+TaskGroup::TaskGroup(ThreadPool &pool, ThreadPool::Priority priority) :
+	_pool(&pool), _priority(priority), _pending(0) {
+
+}
+
+TaskGroup::~TaskGroup() {
+	try {
+		wait();
+	} catch (...) {
+	}
+}
+
+void TaskGroup::run(const ThreadPool::Task &task) {
+	{
+		std::lock_guard<std::mutex> lock(_pool->_mutex);
+
+		_pending++;
+	}
+
+	_pool->queue(ThreadPool::Job(task, this), _priority);
+}
+
+void TaskGroup::wait() {
+	std::unique_lock<std::mutex> lock(_pool->_mutex);
+
+	while (_pending > 0) {
+		// Help out with our own tasks, instead of waiting for a worker to pick them up
+		ThreadPool::Job job;
+		if (_pool->takeJob(*this, job)) {
+			lock.unlock();
+			_pool->execute(job);
+			lock.lock();
+
+			continue;
+		}
+
+		_finished.wait(lock);
+	}
+
+	if (_exception) {
+		std::exception_ptr exception = _exception;
+		_exception = std::exception_ptr();
+
+		std::rethrow_exception(exception);
+	}
+}
+
+} // End of namespace Common
@@ -0,0 +1,152 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A pool of worker threads shared by all subsystems.
+ */
+
+#ifndef COMMON_THREADPOOL_H
+#define COMMON_THREADPOOL_H
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include <exception>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/singleton.h"
+#include "src/common/thread.h"
+#include "src/common/mutex.h"
+
+namespace Common {
+
+class TaskGroup;
+
+/** A pool of worker threads.
+ *
+ *  Instead of every subsystem creating threads of its own, they all
+ *  queue tasks onto one global pool, with one worker thread per core
+ *  the main thread doesn't occupy. Idle workers sleep until tasks
+ *  are queued.
+ *
+ *  Tasks of high priority, like decoding sound that is about to be
+ *  played, are run before all tasks of normal priority.
+ *
+ *  Tasks can be collected in a TaskGroup, to wait for all of them
+ *  together. A thread waiting for a group runs the group's tasks
+ *  that are still queued itself, so it's safe to wait for a group
+ *  from within a task on the pool.
+ */
+class ThreadPool : public Singleton<ThreadPool> {
+public:
+	typedef std::function<void()> Task;
+
+	enum Priority {
+		kPriorityNormal = 0,
+		kPriorityHigh      ,
+		kPriorityMAX
+	};
+
+	/** Create a pool with this many worker threads (0 means one less than the number of cores). */
+	ThreadPool(size_t threadCount = 0);
+	/** Run all queued tasks and stop the worker threads. */
+	~ThreadPool();
+
+	/** Return the number of worker threads. */
+	size_t getThreadCount() const;
+
+	/** Is the calling thread one of the pool's worker threads? */
+	bool isWorkerThread() const;
+
+	/** Queue a task, without waiting for it.
+	 *
+	 *  Exceptions thrown by the task are logged as warnings.
+	 */
+	void run(const Task &task, Priority priority = kPriorityNormal);
+
+private:
+	struct Job {
+		Task task;
+		TaskGroup *group;
+
+		Job(const Task &t = Task(), TaskGroup *g = 0) : task(t), group(g) { }
+	};
+
+	std::vector<std::thread> _workers;
+
+	std::deque<Job> _jobs[kPriorityMAX];
+
+	bool _stop;
+
+	mutable std::mutex _mutex;
+	std::condition_variable _jobsQueued;
+
+	void queue(const Job &job, Priority priority);
+
+	bool hasJobs() const;
+	/** Take the next job off the queue. */
+	Job takeJob();
+	/** Take the next job of a group off the queue, if there is one. */
+	bool takeJob(const TaskGroup &group, Job &job);
+
+	void execute(Job &job);
+
+	void workerMethod();
+
+	friend class TaskGroup;
+};
+
+/** A group of tasks on a thread pool, that can be waited for together. */
+class TaskGroup : boost::noncopyable {
+public:
+	TaskGroup(ThreadPool &pool, ThreadPool::Priority priority = ThreadPool::kPriorityNormal);
+	/** Wait for all tasks of the group, ignoring their exceptions. */
+	~TaskGroup();
+
+	/** Queue a task as part of this group. */
+	void run(const ThreadPool::Task &task);
+
+	/** Wait for all tasks of the group to finish.
+	 *
+	 *  Tasks of the group still queued are run on the calling thread.
+	 *  If a task threw an exception, the first one is rethrown.
+	 */
+	void wait();
+
+private:
+	ThreadPool *_pool;
+	ThreadPool::Priority _priority;
+
+	size_t _pending; ///< Number of tasks not yet finished. Guarded by the pool's mutex.
+	std::exception_ptr _exception;
+
+	std::condition_variable _finished;
+
+	friend class ThreadPool;
+};
+
+} // End of namespace Common
+
+/** Shortcut for accessing the global thread pool. */
+#define ThreadPoolMan Common::ThreadPool::instance()
+
+#endif // COMMON_THREADPOOL_H
@@ -63,6 +63,13 @@ public:
 		}
 	};
 
+	// Case insensitive equality
+	struct iequal {
+		bool operator() (const UString &str1, const UString &str2) const {
+			return str1.equalsIgnoreCase(str2);
+		}
+	};
+
 	/** Construct an empty string. */
 	UString();
 	/** Copy constructor. */
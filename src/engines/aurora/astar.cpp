@@ -31,7 +31,7 @@
 
 namespace Engines {
 
-AStar::AStar(Engines::Pathfinding* pathfinding) : _pathfinding(pathfinding) {
+AStar::AStar(Engines::Pathfinding* pathfinding) : _pathfinding(pathfinding), _generation(0) {
 }
 
 AStar::~AStar() {
@@ -50,7 +50,6 @@ bool AStar::Node::operator<(const Node &node) const {
 
 bool AStar::findPath(float startX, float startY, float endX, float endY,
                      std::vector<uint32> &facePath, float width, uint32 maxIteration) {
-
 	// Cleaning the futur path.
 	facePath.clear();
 
@@ -68,39 +67,42 @@ bool AStar::findPath(float startX, float startY, float endX, float endY,
 		return true;
 	}
 
+	resetNodes();
+
 	// Init nodes and lists.
-	Node startNode = Node(startFace, startX, startY);
-	Node endNode   = Node(endFace, endX, endY);
+	Node endNode = Node(endFace, endX, endY);
 
-	startNode.G = 0.f;
+	Node &startNode = visitNode(startFace, startX, startY);
 	startNode.H = getHeuristic(startNode, endNode);
+	pushOpen(startFace);
+
 	// Get track of the closest node near the end in case of the unavailable path.
-	Node closestToEnd = startNode;
+	uint32 closestToEnd = startFace;
 
-	std::vector<Node> openList;
-	std::vector<Node> closedList;
-	openList.push_back(startNode);
+	std::vector<uint32> adjFaces;
 
 	// Searching...
 	for (uint32 it = 0; it < maxIteration; ++it) {
-		if (openList.empty())
+		if (_openHeap.empty())
 			break;
 
-		Node current = openList.front();
-
-		if (current.face == endNode.face) {
-			reconstructPath(current, closedList, facePath);
+		const uint32 currentFace = popOpen();
+		if (currentFace == endNode.face) {
+			reconstructPath(currentFace, facePath);
 			return true;
 		}
 
-		openList.erase(openList.begin());
-		closedList.push_back(current);
+		_nodeState[currentFace] = kNodeStateClosed;
+
+		// Copy, as visiting new faces must not invalidate what we are working on.
+		Node current = _nodes[currentFace];
 
-		std::vector<uint32> adjFaces;
 		_pathfinding->getAdjacentFaces(current.face, current.parent, adjFaces);
 		for (std::vector<uint32>::iterator a = adjFaces.begin(); a != adjFaces.end(); ++a) {
+			const bool isThere = isVisited(*a);
+
 			// Check if it has been already evaluated.
-			if (hasNode(*a, closedList))
+			if (isThere && _nodeState[*a] == kNodeStateClosed)
 				continue;
 
 			// Check if the creature can go through to the adjacent face.
@@ -112,31 +114,29 @@ bool AStar::findPath(float startX, float startY, float endX, float endY,
 			float gScore = current.G + getGValue(current, *a, x, y);
 
 			// Check if it is a new node.
-			Node *adjNode = getNode(*a, openList);
-			bool isThere = adjNode != 0;
-			if (!isThere) {
-				adjNode = new Node(*a, x, y);
-				adjNode->parent = current.face;
-			} else if (gScore >= adjNode->G) {
+			if (isThere && gScore >= _nodes[*a].G)
 				continue;
-			}
+
+			Node &adjNode = isThere ? _nodes[*a] : visitNode(*a, x, y);
 
 			// adjNode is the best node up to now, update/add.
-			adjNode->parent = current.face;
-			adjNode->G = gScore;
-			adjNode->H = getHeuristic(*adjNode, endNode);
-			if (adjNode->H < closestToEnd.H)
-				closestToEnd = *adjNode;
-			if (!isThere) {
-				openList.push_back(*adjNode);
-				delete adjNode;
-			}
-
-			std::sort(openList.begin(), openList.end());
+			adjNode.x = x;
+			adjNode.y = y;
+			adjNode.parent = current.face;
+			adjNode.G = gScore;
+			adjNode.H = getHeuristic(adjNode, endNode);
+
+			if (adjNode.H < _nodes[closestToEnd].H)
+				closestToEnd = adjNode.face;
+
+			if (!isThere)
+				pushOpen(*a);
+			else
+				siftUp(_heapIndex[*a]);
 		}
 	}
 
-	reconstructPath(closestToEnd, closedList, facePath);
+	reconstructPath(closestToEnd, facePath);
 	return false;
 }
 
@@ -150,47 +150,108 @@ float AStar::getHeuristic(Node &node, Node &endNode) const {
 	return getEuclideanDistance(node.x,node.y, endNode.x,endNode.y);
 }
 
-AStar::Node *AStar::getNode(uint32 face, std::vector<Node> &nodes) const {
-	for (std::vector<Node>::iterator n = nodes.begin(); n != nodes.end(); ++n) {
-		if ((*n).face == face) {
-			return &(*n);
-		}
+float AStar::getEuclideanDistance(float xA, float yA, float xB, float yB) const {
+	return sqrt(pow(xA - xB, 2.f) + pow(yA - yB, 2.f));
+}
+
+void AStar::resetNodes() {
+	const size_t facesCount = _pathfinding->_faces.size() / _pathfinding->_polygonEdges;
+	if (_nodes.size() < facesCount) {
+		_nodes.resize(facesCount);
+		_nodeGeneration.resize(facesCount, 0);
+		_nodeState.resize(facesCount, kNodeStateOpen);
+		_heapIndex.resize(facesCount, UINT32_MAX);
+	}
+
+	// On wrap-around, stale generations could look current again.
+	if (++_generation == 0) {
+		std::fill(_nodeGeneration.begin(), _nodeGeneration.end(), 0);
+		_generation = 1;
 	}
 
-	return 0;
+	_openHeap.clear();
 }
 
-bool AStar::hasNode(uint32 face, std::vector<Node> &nodes) const {
-	for (std::vector<Node>::iterator n = nodes.begin(); n != nodes.end(); ++n) {
-		if ((*n).face == face) {
-			return true;
-		}
-	}
+bool AStar::isVisited(uint32 face) const {
+	return _nodeGeneration[face] == _generation;
+}
 
-	return false;
+AStar::Node &AStar::visitNode(uint32 face, float x, float y) {
+	_nodeGeneration[face] = _generation;
+	_nodeState[face] = kNodeStateOpen;
+	_heapIndex[face] = UINT32_MAX;
+
+	_nodes[face] = Node(face, x, y);
+	return _nodes[face];
 }
 
-float AStar::getEuclideanDistance(float xA, float yA, float xB, float yB) const {
-	return sqrt(pow(xA - xB, 2.f) + pow(yA - yB, 2.f));
+void AStar::pushOpen(uint32 face) {
+	_heapIndex[face] = _openHeap.size();
+	_openHeap.push_back(face);
+
+	siftUp(_heapIndex[face]);
 }
 
-void AStar::reconstructPath(Node &endNode, std::vector<Node> &closedList, std::vector<uint32> &path) {
-	Node &cNode = endNode;
-	path.push_back(endNode.face);
-	path.push_back(endNode.parent);
+uint32 AStar::popOpen() {
+	const uint32 face = _openHeap.front();
 
-	while (cNode.parent != UINT32_MAX) {
-		for (std::vector<Node>::iterator n = closedList.begin(); n != closedList.end(); ++n) {
-			if (cNode.parent != (*n).face)
-				continue;
+	heapSwap(0, _openHeap.size() - 1);
+	_openHeap.pop_back();
+	_heapIndex[face] = UINT32_MAX;
+
+	if (!_openHeap.empty())
+		siftDown(0);
 
-			cNode = (*n);
-			if (cNode.parent != UINT32_MAX)
-				path.push_back(cNode.parent);
+	return face;
+}
 
+void AStar::siftUp(uint32 index) {
+	while (index > 0) {
+		const uint32 parent = (index - 1) / 2;
+		if (!heapLess(index, parent))
 			break;
-		}
+
+		heapSwap(index, parent);
+		index = parent;
+	}
+}
+
+void AStar::siftDown(uint32 index) {
+	const uint32 size = _openHeap.size();
+
+	while (true) {
+		const uint32 left  = 2 * index + 1;
+		const uint32 right = left + 1;
+
+		uint32 smallest = index;
+		if ((left < size) && heapLess(left, smallest))
+			smallest = left;
+		if ((right < size) && heapLess(right, smallest))
+			smallest = right;
+
+		if (smallest == index)
+			break;
+
+		heapSwap(index, smallest);
+		index = smallest;
 	}
+}
+
+bool AStar::heapLess(uint32 a, uint32 b) const {
+	return _nodes[_openHeap[a]] < _nodes[_openHeap[b]];
+}
+
+void AStar::heapSwap(uint32 a, uint32 b) {
+	std::swap(_openHeap[a], _openHeap[b]);
+
+	_heapIndex[_openHeap[a]] = a;
+	_heapIndex[_openHeap[b]] = b;
+}
+
+void AStar::reconstructPath(uint32 endFace, std::vector<uint32> &path) const {
+	for (uint32 face = endFace; face != UINT32_MAX; face = _nodes[face].parent)
+		path.push_back(face);
+
 	std::reverse(path.begin(), path.end());
 }
 
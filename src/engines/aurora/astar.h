@@ -93,16 +93,50 @@ protected:
 	/** Compute the euclidean distance (usual distance) between two points in th XY plan. */
 	float getEuclideanDistance(float xA, float yA, float xB, float yB) const;
 
-	/** Find a node in a vector of nodes. */
-	Node *getNode(uint32 face, std::vector<Node> &nodes) const;
-	/** Check if a vector of nodes contains a specific node. */
-	bool hasNode(uint32 face, std::vector<Node> &nodes) const;
-
 	Pathfinding *_pathfinding; ///< Pathfinding object that contains the walkmesh.
 
 private:
-	/** Reconstruct the path of faces from the closed list and the end node. */
-	void reconstructPath(Node &endNode, std::vector<Node> &closedList, std::vector<uint32> &path);
+	/** The state of a face within the current query. */
+	enum NodeState {
+		kNodeStateOpen,  ///< The face is waiting in the open heap.
+		kNodeStateClosed ///< The face has been expanded.
+	};
+
+	/** Per-face node table, indexed by face ID and reused across queries. */
+	std::vector<Node>   _nodes;
+	/** The query that last touched a face. Faces from older queries are unvisited. */
+	std::vector<uint32> _nodeGeneration;
+	/** The state of each face visited in the current query. */
+	std::vector<byte>   _nodeState;
+	/** The position of each open face inside _openHeap. */
+	std::vector<uint32> _heapIndex;
+	/** Binary min-heap of open faces, ordered by G + H. */
+	std::vector<uint32> _openHeap;
+
+	uint32 _generation; ///< The ID of the current query.
+
+	/** Make sure the node tables can hold all faces and start a new query. */
+	void resetNodes();
+	/** Was the face already visited in the current query? */
+	bool isVisited(uint32 face) const;
+	/** Start tracking a face in the current query. */
+	Node &visitNode(uint32 face, float x, float y);
+
+	/** Add a face to the open heap. */
+	void pushOpen(uint32 face);
+	/** Remove and return the open face with the lowest G + H. */
+	uint32 popOpen();
+	/** Move an open face up the heap after its cost decreased. */
+	void siftUp(uint32 index);
+	/** Move an open face down the heap after the top was replaced. */
+	void siftDown(uint32 index);
+	/** Does the face at heap index a have a lower cost than the one at index b? */
+	bool heapLess(uint32 a, uint32 b) const;
+	/** Swap two entries of the open heap, updating their heap indices. */
+	void heapSwap(uint32 a, uint32 b);
+
+	/** Reconstruct the path of faces from the parent links of the end face. */
+	void reconstructPath(uint32 endFace, std::vector<uint32> &path) const;
 };
 
 } // End of namespace Engines
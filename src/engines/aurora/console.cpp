@@ -26,6 +26,8 @@
 #include <cstdarg>
 #include <cstdio>
 
+#include <algorithm>
+
 #include <boost/bind.hpp>
 
 #include "external/glm/gtc/matrix_transform.hpp"
@@ -815,6 +817,14 @@ Console::Console(Engine &engine, const Common::UString &font, int fontHeight) :
 	registerCommand("setcamera"  , boost::bind(&Console::cmdSetCamera  , this, _1),
 			"Usage: setcamera <posX> <posY> <posZ> [<orientX> <orientY> <orientZ>]\n"
 			"Set the camera position (and orientation)");
+	registerCommand("texmemory"  , boost::bind(&Console::cmdTexMemory  , this, _1),
+			"Usage: texmemory [<count>] [<budget>]\n"
+			"Print the memory used by the <count> largest texture images,\n"
+			"and optionally set the image memory budget in MB (-1 for unlimited)");
+	registerCommand("rescache"   , boost::bind(&Console::cmdResCache   , this, _1),
+			"Usage: rescache [<budget>]\n"
+			"Print the statistics of the decompressed resource cache,\n"
+			"and optionally set its memory budget in MB (0 to disable)");
 
 	_console->print("Console ready...");
 }
@@ -1474,6 +1484,90 @@ void Console::cmdGetString(const CommandLine &cl) {
 	printf("\"%s\"", TalkMan.getString(strRef).c_str());
 }
 
+static bool compareTextureMemory(const Graphics::Aurora::TextureManager::TextureMemory &a,
+                                 const Graphics::Aurora::TextureManager::TextureMemory &b) {
+
+	return a.size > b.size;
+}
+
+void Console::cmdTexMemory(const CommandLine &cl) {
+	std::vector<Common::UString> args;
+	splitArguments(cl.args, args);
+
+	size_t count = 10;
+	int budget = 0;
+
+	try {
+		if (args.size() >= 1)
+			Common::parseString(args[0], count);
+		if (args.size() >= 2)
+			Common::parseString(args[1], budget);
+	} catch (...) {
+		printCommandHelp(cl.cmd);
+		return;
+	}
+
+	if (args.size() >= 2)
+		TextureMan.setImageBudget((budget < 0) ? Graphics::Aurora::TextureManager::kImageBudgetUnlimited :
+		                                         ((size_t) budget) * 1024 * 1024);
+
+	std::vector<Graphics::Aurora::TextureManager::TextureMemory> textures;
+	TextureMan.getTextureMemory(textures);
+
+	std::sort(textures.begin(), textures.end(), compareTextureMemory);
+
+	size_t totalSize = 0, residentSize = 0, residentCount = 0;
+	for (size_t i = 0; i < textures.size(); i++) {
+		totalSize += textures[i].size;
+
+		if (textures[i].resident) {
+			residentSize += textures[i].size;
+			residentCount++;
+		}
+
+		if (i < count)
+			printf("%10u %s%s", (uint)textures[i].size, textures[i].name.c_str(),
+			       textures[i].resident ? "" : " (dropped)");
+	}
+
+	printf("%u textures, %u KB", (uint)textures.size(), (uint)(totalSize / 1024));
+	printf("%u images in memory, %u KB", (uint)residentCount, (uint)(residentSize / 1024));
+
+	const size_t imageBudget = TextureMan.getImageBudget();
+	if (imageBudget == Graphics::Aurora::TextureManager::kImageBudgetUnlimited)
+		printf("Uploaded images in memory: %u KB, no budget",
+		       (uint)(TextureMan.getResidentImageSize() / 1024));
+	else
+		printf("Uploaded images in memory: %u KB, budget %u KB",
+		       (uint)(TextureMan.getResidentImageSize() / 1024), (uint)(imageBudget / 1024));
+}
+
+void Console::cmdResCache(const CommandLine &cl) {
+	if (!cl.args.empty()) {
+		size_t budget = 0;
+
+		try {
+			Common::parseString(cl.args, budget);
+		} catch (...) {
+			printCommandHelp(cl.cmd);
+			return;
+		}
+
+		ResMan.setDecompressedCacheBudget(budget * 1024 * 1024);
+	}
+
+	const Aurora::DecompressedCache::Statistics stats = ResMan.getDecompressedCacheStatistics();
+
+	const uint64 requests = stats.hits + stats.misses;
+	const double hitRate  = (requests > 0) ? ((100.0 * stats.hits) / requests) : 0.0;
+
+	printf("%u resources cached, %u KB, budget %u KB", (uint)stats.count,
+	       (uint)(stats.size / 1024), (uint)(stats.budget / 1024));
+	printf("%s hits, %s misses (%.1f%% hit rate), %s evictions",
+	       Common::composeString(stats.hits).c_str(), Common::composeString(stats.misses).c_str(), hitRate,
+	       Common::composeString(stats.evictions).c_str());
+}
+
 void Console::cmdGetCamera(const CommandLine &UNUSED(cl)) {
 	const float *pos    = CameraMan.getPosition();
 	const float *orient = CameraMan.getOrientation();
@@ -313,6 +313,8 @@ private:
 	void cmdGetString  (const CommandLine &cl);
 	void cmdGetCamera  (const CommandLine &cl);
 	void cmdSetCamera  (const CommandLine &cl);
+	void cmdTexMemory  (const CommandLine &cl);
+	void cmdResCache   (const CommandLine &cl);
 
 	void updateHelpArguments();
 
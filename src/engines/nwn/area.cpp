@@ -461,6 +461,12 @@ void Area::unloadTileset() {
 }
 
 void Area::loadTiles() {
+	const bool loadWalkmeshes = !_pathfinding->loaded();
+
+	std::vector<Pathfinding::TileDefinition> walkmeshes;
+	if (loadWalkmeshes)
+		walkmeshes.resize(_tiles.size());
+
 	for (uint32 y = 0; y < _height; y++) {
 		for (uint32 x = 0; x < _width; x++) {
 			uint32 n = y * _width + x;
@@ -469,6 +475,35 @@ void Area::loadTiles() {
 
 			t.tile = &_tileset->getTile(t.tileID);
 
+			if (loadWalkmeshes) {
+				Pathfinding::TileDefinition &walkmesh = walkmeshes[n];
+
+				walkmesh.wokFile = t.tile->model;
+
+				walkmesh.orientation[0] = 0.0f;
+				walkmesh.orientation[1] = 0.0f;
+				walkmesh.orientation[2] = 1.0f;
+				walkmesh.orientation[3] = ((int) t.orientation) * (float) M_PI * 0.5f;
+
+				walkmesh.position[0] = x * 10.0f + 5.0f;
+				walkmesh.position[1] = y * 10.0f + 5.0f;
+				walkmesh.position[2] = t.height * _tileset->getTilesHeight();
+			}
+		}
+	}
+
+	// The walkmeshes only need the resource manager, so they can be parsed in parallel
+	if (loadWalkmeshes)
+		_pathfinding->addTiles(walkmeshes);
+
+	/* Most areas only use a handful of distinct tile models. The first instance
+	 * of each decodes the geometry, all other instances share its meshes. */
+	for (uint32 y = 0; y < _height; y++) {
+		for (uint32 x = 0; x < _width; x++) {
+			uint32 n = y * _width + x;
+
+			Tile &t = _tiles[n];
+
 			t.model = loadModelObject(t.tile->model);
 			if (!t.model)
 				throw Common::Exception("Can't load tile model \"%s\"", t.tile->model.c_str());
@@ -483,16 +518,10 @@ void Area::loadTiles() {
 
 			t.model->setPosition(tileX, tileY, tileZ);
 			t.model->setOrientation(0.0f, 0.0f, 1.0f, ((int) t.orientation) * 90.0f);
-
-			if (!_pathfinding->loaded()) {
-				float position[3] = { tileX, tileY, tileZ };
-				float orientation[4] = {0.0f, 0.0f, 1.0f, ((int) t.orientation) * (float) M_PI * 0.5f};
-				_pathfinding->addTile(t.tile->model, orientation, position);
-			}
 		}
 	}
 
-	if (!_pathfinding->loaded())
+	if (loadWalkmeshes)
 		_pathfinding->finalize();
 }
 
@@ -24,11 +24,16 @@
  */
 
 #include <algorithm>
+#include <map>
+#include <cstring>
 
+#include "src/common/util.h"
 #include "src/common/ustring.h"
 #include "src/common/streamtokenizer.h"
 #include "src/common/strutil.h"
 #include "src/common/aabbnode.h"
+#include "src/common/scopedptr.h"
+#include "src/common/threadpool.h"
 
 #include "src/aurora/resman.h"
 
@@ -57,25 +62,128 @@ Pathfinding::~Pathfinding() {
 	delete _walkmeshLoader;
 }
 
+Pathfinding::TileWalkmesh::TileWalkmesh() : aabb(0) {
+	position[0] = position[1] = position[2] = 0.0f;
+}
+
 void Pathfinding::addTile(const Common::UString &wokFile, float *orientation, float *position) {
+	TileWalkmesh walkmesh;
+
+	_walkmeshLoader->load(::Aurora::kFileTypeWOK, wokFile, orientation, position, walkmesh.vertices,
+	                      walkmesh.faces, walkmesh.facesProperty);
+
+	walkmesh.aabb = _walkmeshLoader->getAABB();
+	std::memcpy(walkmesh.position, position, sizeof(walkmesh.position));
+
+	addTileWalkmesh(walkmesh);
+}
+
+void Pathfinding::addTiles(const std::vector<TileDefinition> &tiles) {
+	std::vector<TileWalkmesh> walkmeshes;
+	loadTileWalkmeshes(tiles, walkmeshes);
+
+	for (std::vector<TileWalkmesh>::iterator w = walkmeshes.begin(); w != walkmeshes.end(); ++w)
+		addTileWalkmesh(*w);
+}
+
+void Pathfinding::loadTileWalkmeshes(const std::vector<TileDefinition> &tiles,
+                                     std::vector<TileWalkmesh> &walkmeshes) {
+
+	walkmeshes.resize(tiles.size());
+
+	/* Areas use the same few tile walkmeshes over and over again.
+	 * Parse every one of them only once, then place it at each tile. */
+	typedef std::map<Common::UString, Common::ScopedPtr<WalkmeshLoader::File>, Common::UString::iless> FileMap;
+	FileMap files;
+
+	for (std::vector<TileDefinition>::const_iterator t = tiles.begin(); t != tiles.end(); ++t)
+		files[t->wokFile];
+
+	try {
+		Common::TaskGroup parsing(ThreadPoolMan);
+		for (FileMap::iterator f = files.begin(); f != files.end(); ++f) {
+			parsing.run([f]() {
+				f->second.reset(WalkmeshLoader::parse(::Aurora::kFileTypeWOK, f->first));
+			});
+		}
+
+		parsing.wait();
+
+		Common::TaskGroup placing(ThreadPoolMan);
+		for (size_t n = 0; n < tiles.size(); n++) {
+			const WalkmeshLoader::File *file = files.find(tiles[n].wokFile)->second.get();
+			if (!file) {
+				// A tile without a walkmesh
+				std::memcpy(walkmeshes[n].position, tiles[n].position, sizeof(walkmeshes[n].position));
+				continue;
+			}
+
+			placing.run([&tiles, &walkmeshes, file, n]() {
+				WalkmeshLoader loader;
+				TileWalkmesh &walkmesh = walkmeshes[n];
+
+				float orientation[4], position[3];
+				std::memcpy(orientation, tiles[n].orientation, sizeof(orientation));
+				std::memcpy(position   , tiles[n].position   , sizeof(position));
+
+				loader.load(*file, ::Aurora::kFileTypeWOK, orientation, position,
+				            walkmesh.vertices, walkmesh.faces, walkmesh.facesProperty);
+
+				walkmesh.aabb = loader.getAABB();
+				std::memcpy(walkmesh.position, position, sizeof(walkmesh.position));
+			});
+		}
+
+		placing.wait();
+
+	} catch (...) {
+		for (std::vector<TileWalkmesh>::iterator w = walkmeshes.begin(); w != walkmeshes.end(); ++w) {
+			delete w->aabb;
+			w->aabb = 0;
+		}
+
+		throw;
+	}
+}
+
+void Pathfinding::addTileWalkmesh(TileWalkmesh &walkmesh) {
 	Tile tile = Tile();
 	tile.tileId = _tiles.size();
 
-	_walkmeshLoader->load(::Aurora::kFileTypeWOK, wokFile, orientation, position, _vertices,
-	                      tile.faces, tile.facesProperty);
+	// The walkmesh was parsed on its own, so shift its vertex indices behind ours
+	const uint32 startVertex = _vertices.size() / 3;
+
+	_vertices.insert(_vertices.end(), walkmesh.vertices.begin(), walkmesh.vertices.end());
+
+	tile.faces.swap(walkmesh.faces);
+	for (std::vector<uint32>::iterator f = tile.faces.begin(); f != tile.faces.end(); ++f)
+		*f += startVertex;
+
+	tile.facesProperty.swap(walkmesh.facesProperty);
+
 	_facesCount += tile.faces.size() / 3;
 	_verticesCount = _vertices.size() / 3;
 
 	tile.adjFaces.resize(tile.faces.size(), UINT32_MAX);
 	_tiles.push_back(tile);
 
-	_AABBTrees.push_back(_walkmeshLoader->getAABB());
+	_AABBTrees.push_back(walkmesh.aabb);
+	walkmesh.aabb = 0;
+
+	// A tile without a walkmesh can't be connected to anything
+	if (!_AABBTrees.back())
+		return;
+
+	const float *position = walkmesh.position;
 
 	// Find Adjacent tiles.
 	glm::vec3 leftMax(position[0] - 5.f, position[1] + 5.f, 0.f);
 	glm::vec3 bottomMax(position[0] + 5.f, position[1] - 5.f, 0.f);
 
 	for (size_t n = 0; n < _AABBTrees.size(); ++n) {
+		if (!_AABBTrees[n])
+			continue;
+
 		float x, y, z;
 		_AABBTrees[n]->getMax(x, y, z);
 		if (fabs(x - leftMax[0]) < 4.f && fabs(y - leftMax[1]) < 4.f) {
@@ -119,7 +227,8 @@ void Pathfinding::finalize() {
 		_faceProperty.insert(_faceProperty.end(), _tiles[t].facesProperty.begin(), _tiles[t].facesProperty.end());
 
 		// Adjust AABB.
-		_AABBTrees[t]->adjustChildrenProperty(prevFacesCount);
+		if (_AABBTrees[t])
+			_AABBTrees[t]->adjustChildrenProperty(prevFacesCount);
 	}
 
 	// Set adjacencies between tiles.
@@ -48,8 +48,23 @@ public:
 	Pathfinding(std::vector<bool> walkableProperties);
 	~Pathfinding();
 
+	/** Where to place the walkmesh of a tile. */
+	struct TileDefinition {
+		Common::UString wokFile; ///< The name of the walkmesh.
+		float orientation[4];    ///< Rotation axis and angle, in radians.
+		float position[3];       ///< Position of the tile's center.
+	};
+
 	/** Add wok tile data. */
 	void addTile(const Common::UString &wokFile, float *orientation, float *position);
+	/** Add the wok data of several tiles, in order.
+	 *
+	 *  Each distinct walkmesh is read and parsed only once, and the
+	 *  walkmeshes are parsed and placed on the thread pool.
+	 *  Connecting the tiles still happens on the calling thread, in
+	 *  the same order as with consecutive calls to addTile().
+	 */
+	void addTiles(const std::vector<TileDefinition> &tiles);
 	/** Connect all tiles together. Should be called before any path request. */
 	void finalize();
 	/** Is the the walkmesh already loaded and ready to be used? */
@@ -91,6 +106,22 @@ private:
 		std::vector<Face> borderTop;
 	};
 
+	/** The walkmesh of a single tile, parsed independently of all other tiles. */
+	struct TileWalkmesh {
+		std::vector<float> vertices;       ///< Vertices, indexed from 0.
+		std::vector<uint32> faces;         ///< Faces, indexing into vertices.
+		std::vector<uint32> facesProperty; ///< Surface type of each face.
+		Common::AABBNode *aabb;            ///< AABB tree of the walkmesh.
+		float position[3];                 ///< Position of the tile, as adjusted by the walkmesh.
+
+		TileWalkmesh();
+	};
+
+	/** Parse the walkmeshes of these tiles, on the thread pool. */
+	static void loadTileWalkmeshes(const std::vector<TileDefinition> &tiles, std::vector<TileWalkmesh> &walkmeshes);
+	/** Append a parsed tile walkmesh and connect it to the previous tiles. */
+	void addTileWalkmesh(TileWalkmesh &walkmesh);
+
 	/** Find face adjacencies between two tiles and make all border faces match an other face. */
 	void connectTiles(uint32 tileA, uint32 tileB, bool yAxis, float axisPosition);
 	/** Find face adjacencies within a tile. */
@@ -23,6 +23,8 @@
  *  Class that reads a WalkmeshLoader file.
  */
 
+#include <cstring>
+
 #include "external/glm/mat4x4.hpp"
 #include "external/glm/gtc/matrix_transform.hpp"
 
@@ -48,13 +50,10 @@ WalkmeshLoader::~WalkmeshLoader() {
 }
 
 
-void WalkmeshLoader::load(::Aurora::FileType fileType, const Common::UString &name,
-                          float orientation[4], float position[3],
-                          std::vector<float> &vertices, std::vector<uint32> &faces,
-                          std::vector<uint32> &facesProperty, const Common::UString &filterNode) {
+WalkmeshLoader::File *WalkmeshLoader::parse(::Aurora::FileType fileType, const Common::UString &name) {
 	Common::ScopedPtr<Common::SeekableReadStream> stream(ResMan.getResource(name, fileType));
 	if (!stream)
-		return;
+		return 0;
 
 	stream->seek(0);
 
@@ -63,6 +62,80 @@ void WalkmeshLoader::load(::Aurora::FileType fileType, const Common::UString &na
 	tokenize->addChunkEnd('\n');
 	tokenize->addIgnore('\r');
 
+	Common::ScopedPtr<File> file(new File);
+
+	while (!stream->eos()) {
+		std::vector<Common::UString> line;
+		size_t count = tokenize->getTokens(*stream, line, 3);
+		tokenize->nextChunk(*stream);
+		// Ignore empty lines and comments.
+		if ((count == 0) || line[0].empty() || (*line[0].begin() == '#'))
+			continue;
+
+		line[0].makeLower();
+
+		if (line[0] == "node") {
+			file->entries.push_back(File::Entry(File::kEntryNode));
+			file->entries.back().name = line[2];
+		} else if (line[0] == "position") {
+			file->entries.push_back(File::Entry(File::kEntryPosition));
+			file->entries.back().values.resize(3);
+			readFloats(line, &file->entries.back().values[0], 3, 1);
+		} else if (line[0] == "orientation") {
+			file->entries.push_back(File::Entry(File::kEntryOrientation));
+			file->entries.back().values.resize(4);
+			readFloats(line, &file->entries.back().values[0], 4, 1);
+		} else if (line[0] == "verts") {
+			size_t vertsCount;
+			Common::parseString(line[1], vertsCount);
+
+			file->entries.push_back(File::Entry(File::kEntryVerts));
+			readVerts(vertsCount, stream.get(), tokenize.get(), file->entries.back().values);
+		} else if (line[0] == "faces") {
+			size_t facesCount;
+			Common::parseString(line[1], facesCount);
+
+			file->entries.push_back(File::Entry(File::kEntryFaces));
+			readFaces(facesCount, stream.get(), tokenize.get(), file->entries.back().faces);
+		} else if (line[0] == "aabb") {
+			file->entries.push_back(File::Entry(File::kEntryAABB));
+
+			File::Entry &aabb = file->entries.back();
+
+			aabb.values.resize(6);
+			readFloats(line, &aabb.values[0], 3, 1);
+			readFloats(line, &aabb.values[3], 3, 4);
+
+			// Two children below the root
+			readAABB(stream.get(), tokenize.get(), aabb.values, aabb.aabbs);
+			readAABB(stream.get(), tokenize.get(), aabb.values, aabb.aabbs);
+		} else if (line[0] == "endnode") {
+			file->entries.push_back(File::Entry(File::kEntryEndNode));
+		}
+	}
+
+	return file.release();
+}
+
+void WalkmeshLoader::load(::Aurora::FileType fileType, const Common::UString &name,
+                          float orientation[4], float position[3],
+                          std::vector<float> &vertices, std::vector<uint32> &faces,
+                          std::vector<uint32> &facesProperty, const Common::UString &filterNode) {
+	_node = 0;
+
+	Common::ScopedPtr<File> file(parse(fileType, name));
+	if (!file)
+		return;
+
+	load(*file, fileType, orientation, position, vertices, faces, facesProperty, filterNode);
+}
+
+void WalkmeshLoader::load(const File &file, ::Aurora::FileType fileType,
+                          float orientation[4], float position[3],
+                          std::vector<float> &vertices, std::vector<uint32> &faces,
+                          std::vector<uint32> &facesProperty, const Common::UString &filterNode) {
+	_node = 0;
+
 	if (fileType == Aurora::kFileTypePWK)
 		orientation[3] = Common::deg2rad(orientation[3]);
 
@@ -79,26 +152,16 @@ void WalkmeshLoader::load(::Aurora::FileType fileType, const Common::UString &na
 	Common::UString currentNode = "";
 	bool goodNode = filterNode.empty();
 
-	while (!stream->eos()) {
-		std::vector<Common::UString> line;
-		size_t count = tokenize->getTokens(*stream, line, 3);
-		tokenize->nextChunk(*stream);
-		// Ignore empty lines and comments.
-		if ((count == 0) || line[0].empty() || (*line[0].begin() == '#'))
-			continue;
-
-		line[0].makeLower();
-
-		if (line[0] == "node" && !filterNode.empty()) {
-			currentNode = line[2];
+	for (std::vector<File::Entry>::const_iterator e = file.entries.begin(); e != file.entries.end(); ++e) {
+		if (e->type == File::kEntryNode && !filterNode.empty()) {
+			currentNode = e->name;
 			goodNode = currentNode.contains(filterNode);
 		} else if (!goodNode) {
 			continue;
-		} else if (line[0] == "position") {
-			readFloats(line, localPosition, 3, 1);
-		} else if (line[0] == "orientation") {
-			float ori[4];
-			readFloats(line, ori, 4, 1);
+		} else if (e->type == File::kEntryPosition) {
+			std::memcpy(localPosition, &e->values[0], sizeof(localPosition));
+		} else if (e->type == File::kEntryOrientation) {
+			const float *ori = &e->values[0];
 			if (abs(ori[3]) > 0.01) {
 				rotation = glm::rotate(rotation, ori[3],
 				                       glm::vec3(ori[0], ori[1], ori[2]));
@@ -119,44 +182,22 @@ void WalkmeshLoader::load(::Aurora::FileType fileType, const Common::UString &na
 			for (uint8 i = 0; i < 3; ++i)
 				position[i] += shift[i];
 
-		} else if (line[0] == "verts") {
-			size_t vertsCount;
-			Common::parseString(line[1], vertsCount);
-			readVerts(vertsCount, position, stream.get(), tokenize.get(), rotation, vertices);
-		} else if (line[0] == "faces") {
-			size_t facesCount;
-			Common::parseString(line[1], facesCount);
-			readFaces(facesCount, stream.get(), tokenize.get(), faces, facesProperty, startVertex);
-		} else if (line[0] == "aabb") {
-			float rawMin[3], rawMax[3], min[3], max[3];
-			readFloats(line, rawMin, 3, 1);
-			readFloats(line, rawMax, 3, 4);
-
-			changeOrientation(axisAlignedOrientation, rawMin);
-			changeOrientation(axisAlignedOrientation, rawMax);
-			for (uint32 i = 0; i < 3; ++i) {
-				rawMin[i] += position[i];
-				rawMax[i] += position[i];
-				min[i] = MIN(rawMin[i], rawMax[i]);
-				max[i] = MAX(rawMin[i], rawMax[i]);
-			}
-
+		} else if (e->type == File::kEntryVerts) {
+			placeVerts(e->values, position, rotation, vertices);
+		} else if (e->type == File::kEntryFaces) {
+			placeFaces(e->faces, faces, facesProperty, startVertex);
+		} else if (e->type == File::kEntryAABB) {
 			Common::AABBNode *rootNode = 0;
 
 			if (axisRotation) {
-				rootNode = new Common::AABBNode(min, max);
-
-				Common::AABBNode *leftChild = readAABB(position, axisAlignedOrientation, stream.get(),
-													   tokenize.get());
-				Common::AABBNode *rightChild = readAABB(position, axisAlignedOrientation, stream.get(),
-														tokenize.get());
-				rootNode->setChildren(leftChild, rightChild);
+				size_t index = 0;
+				rootNode = placeAABB(*e, index, position, axisAlignedOrientation);
 			} else {
 				rootNode = buildAABBTree(vertices, faces);
 			}
 
 			_node = rootNode;
-		} else if (line[0] == "endnode") {
+		} else if (e->type == File::kEntryEndNode) {
 			if (filterNode.empty())
 				break;
 
@@ -179,32 +220,94 @@ void WalkmeshLoader::readFloats(const std::vector<Common::UString> &strings,
 		Common::parseString(strings[start + i], floats[i]);
 }
 
-void WalkmeshLoader::readVerts(size_t n, float *position, Common::SeekableReadStream *stream,
-                               Common::StreamTokenizer *tokenize, glm::mat4x4 &rotation,
-                               std::vector<float> &vertices) {
+void WalkmeshLoader::readVerts(size_t n, Common::SeekableReadStream *stream,
+                               Common::StreamTokenizer *tokenize, std::vector<float> &vertices) {
 
-	size_t startVertex = vertices.size() / 3;
-	vertices.resize(vertices.size() + n * 3);
+	vertices.resize(n * 3);
 
-	for (size_t i = startVertex; i < startVertex + n; ++i) {
+	for (size_t i = 0; i < n; ++i) {
 		std::vector<Common::UString> line;
 		size_t count = tokenize->getTokens(*stream, line, 3);
 		tokenize->nextChunk(*stream);
 
 		// Ignore empty lines and comments.
 		if ((count == 0) || line[0].empty() || (*line[0].begin() == '#')) {
+			if (stream->eos())
+				throw Common::Exception("Missing vertices");
+
 			--i;
 			continue;
 		}
 
-		for (uint32 vi = 0; vi < 3; ++vi) {
-			float val;
-			Common::parseString(line[vi], val);
-			vertices[3 * i + vi] = val;
+		readFloats(line, &vertices[3 * i], 3, 0);
+	}
+}
+
+void WalkmeshLoader::readFaces(size_t n, Common::SeekableReadStream *stream,
+                               Common::StreamTokenizer *tokenize, std::vector<uint32> &faces) {
+	faces.resize(n * 4);
+
+	for (size_t i = 0; i < n; ++i) {
+		std::vector<Common::UString> line;
+		size_t count = tokenize->getTokens(*stream, line, 3);
+		tokenize->nextChunk(*stream);
+
+		// Ignore empty lines and comments
+		if ((count == 0) || line[0].empty() || (*line[0].begin() == '#')) {
+			if (stream->eos())
+				throw Common::Exception("Missing faces");
+
+			--i;
+			continue;
 		}
 
+		if (line.size() < 8)
+			throw Common::Exception("Missing tokens");
+
+		for (uint32 vi = 0; vi < 3; ++vi)
+			Common::parseString(line[vi], faces[4 * i + vi]);
+
+		// Surface type
+		Common::parseString(line[7], faces[4 * i + 3]);
+	}
+}
+
+void WalkmeshLoader::readAABB(Common::SeekableReadStream *stream, Common::StreamTokenizer *tokenize,
+                              std::vector<float> &boxes, std::vector<int32> &aabbFaces) {
+	std::vector<Common::UString> line;
+	tokenize->getTokens(*stream, line, 7);
+	tokenize->nextChunk(*stream);
+
+	const size_t box = boxes.size();
+	boxes.resize(box + 6);
+
+	readFloats(line, &boxes[box], 6, 0);
+
+	// If it's a child node, record the related face.
+	int32 face;
+	Common::parseString(line[6], face);
+
+	aabbFaces.push_back(face);
+
+	if (face < 0) {
+		readAABB(stream, tokenize, boxes, aabbFaces);
+		readAABB(stream, tokenize, boxes, aabbFaces);
+	}
+}
+
+void WalkmeshLoader::placeVerts(const std::vector<float> &rawVertices, float *position,
+                                glm::mat4x4 &rotation, std::vector<float> &vertices) {
+
+	size_t startVertex = vertices.size() / 3;
+	size_t n = rawVertices.size() / 3;
+
+	vertices.resize(vertices.size() + n * 3);
+
+	for (size_t i = startVertex; i < startVertex + n; ++i) {
+		const float *raw = &rawVertices[3 * (i - startVertex)];
+
 		// Adjust vertex.
-		glm::vec4 vert = rotation * glm::vec4(vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2], 1.f);
+		glm::vec4 vert = rotation * glm::vec4(raw[0], raw[1], raw[2], 1.f);
 		for (uint32 vi = 0; vi < 3; ++vi)
 			vertices[3 * i + vi] = vert[vi] + position[vi];
 
@@ -221,28 +324,19 @@ void WalkmeshLoader::readVerts(size_t n, float *position, Common::SeekableReadSt
 	}
 }
 
-void WalkmeshLoader::readFaces(size_t n, Common::SeekableReadStream *stream,
-                               Common::StreamTokenizer *tokenize,
-                               std::vector<uint32> &faces, std::vector<uint32> &facesProperty,
-                               uint32 startVertex) {
+void WalkmeshLoader::placeFaces(const std::vector<uint32> &rawFaces, std::vector<uint32> &faces,
+                                std::vector<uint32> &facesProperty, uint32 startVertex) {
 	uint32 startFace = faces.size() / 3;
+	size_t n = rawFaces.size() / 4;
+
 	faces.resize((startFace + n) * 3);
 	facesProperty.resize(startFace + n);
 
 	for (size_t i = startFace; i < startFace + n; ++i) {
-		std::vector<Common::UString> line;
-		size_t count = tokenize->getTokens(*stream, line, 3);
-		tokenize->nextChunk(*stream);
-
-		// Ignore empty lines and comments
-		if ((count == 0) || line[0].empty() || (*line[0].begin() == '#')) {
-			--i;
-			continue;
-		}
+		const uint32 *raw = &rawFaces[4 * (i - startFace)];
 
 		for (uint32 vi = 0; vi < 3; ++vi) {
-			uint32 val;
-			Common::parseString(line[vi], val);
+			uint32 val = raw[vi];
 			if (_sameVertex.find(val + startVertex) != _sameVertex.end()) {
 				// Replace redundant vertex.
 				faces[3 * i + vi] = _sameVertex[val + startVertex];
@@ -252,7 +346,7 @@ void WalkmeshLoader::readFaces(size_t n, Common::SeekableReadStream *stream,
 		}
 
 		// Surface type
-		Common::parseString(line[7], facesProperty[i]);
+		facesProperty[i] = raw[3];
 	}
 }
 
@@ -264,16 +358,11 @@ void WalkmeshLoader::changeOrientation(uint8 orientation, float *position) const
 	}
 }
 
-Common::AABBNode *WalkmeshLoader::readAABB(float *position, uint8 orientation,
-                                           Common::SeekableReadStream *stream,
-                                           Common::StreamTokenizer *tokenize) {
-	std::vector<Common::UString> line;
-	tokenize->getTokens(*stream, line, 7);
-	tokenize->nextChunk(*stream);
-
+Common::AABBNode *WalkmeshLoader::placeAABB(const File::Entry &entry, size_t &index,
+                                            float *position, uint8 orientation) const {
 	float rawMin[3], rawMax[3], min[3], max[3];
-	readFloats(line, rawMin, 3, 0);
-	readFloats(line, rawMax, 3, 3);
+	std::memcpy(rawMin, &entry.values[6 * index + 0], sizeof(rawMin));
+	std::memcpy(rawMax, &entry.values[6 * index + 3], sizeof(rawMax));
 
 	changeOrientation(orientation, rawMin);
 	changeOrientation(orientation, rawMax);
@@ -284,14 +373,15 @@ Common::AABBNode *WalkmeshLoader::readAABB(float *position, uint8 orientation,
 		max[i] = MAX(rawMin[i], rawMax[i]);
 	}
 
-	// If it's a child node, record the related face.
-	int32 face;
-	Common::parseString(line[6], face);
+	// The root node has two children, but no face of its own
+	const int32 face = (index == 0) ? -1 : entry.aabbs[index - 1];
 
 	Common::AABBNode *node = new Common::AABBNode(min, max, face);
+	index++;
+
 	if (face < 0) {
-		Common::AABBNode *leftChild = readAABB(position, orientation, stream, tokenize);
-		Common::AABBNode *rightChild = readAABB(position, orientation, stream, tokenize);
+		Common::AABBNode *leftChild = placeAABB(entry, index, position, orientation);
+		Common::AABBNode *rightChild = placeAABB(entry, index, position, orientation);
 		node->setChildren(leftChild, rightChild);
 	}
 
@@ -27,6 +27,9 @@
 #ifndef ENGINES_NWN_WALKMESHLOADER_H
 #define ENGINES_NWN_WALKMESHLOADER_H
 
+#include <vector>
+#include <map>
+
 #include "external/glm/mat4x4.hpp"
 
 #include "src/aurora/types.h"
@@ -44,29 +47,78 @@ namespace NWN {
 
 class WalkmeshLoader {
 public:
+	/** The contents of an ASCII walkmesh file, parsed but not yet placed anywhere.
+	 *
+	 *  Tokenizing and parsing the text is the expensive part of loading a
+	 *  walkmesh. Area tiles use the same few walkmeshes over and over again,
+	 *  so a parsed file can be shared and placed at every tile using it.
+	 */
+	struct File {
+		enum EntryType {
+			kEntryNode,        ///< Start of a node.
+			kEntryPosition,    ///< Position of the node.
+			kEntryOrientation, ///< Orientation of the node.
+			kEntryVerts,       ///< Vertices of the node.
+			kEntryFaces,       ///< Faces of the node.
+			kEntryAABB,        ///< AABB tree of the node.
+			kEntryEndNode      ///< End of a node.
+		};
+
+		/** A single statement of the file, in the order they appear. */
+		struct Entry {
+			EntryType type;
+
+			Common::UString name;       ///< Name of a node.
+			std::vector<float> values;  ///< Position, orientation, vertices or AABB boxes.
+			std::vector<uint32> faces;  ///< Three vertex indices and the surface type per face.
+			std::vector<int32> aabbs;   ///< Face of each AABB box below the root, depth first.
+
+			Entry(EntryType t = kEntryNode) : type(t) { }
+		};
+
+		std::vector<Entry> entries;
+	};
+
 	WalkmeshLoader();
 	~WalkmeshLoader();
 
+	/** Read and parse a walkmesh file. Returns 0 if the file doesn't exist. */
+	static File *parse(Aurora::FileType fileType, const Common::UString &name);
+
 	void load(Aurora::FileType fileType, const Common::UString &name, float orientation[4], float position[3],
 	          std::vector<float> &vertices, std::vector<uint32> &faces, std::vector<uint32> &facesProperty,
 	          const Common::UString &filterNode = "");
 
+	/** Place an already parsed walkmesh file, like load() does. */
+	void load(const File &file, Aurora::FileType fileType, float orientation[4], float position[3],
+	          std::vector<float> &vertices, std::vector<uint32> &faces, std::vector<uint32> &facesProperty,
+	          const Common::UString &filterNode = "");
+
 	Common::AABBNode *getAABB();
 
 private:
 	/** Read the vertices positions from an ASCII stream. */
-	void readVerts(size_t n, float *position, Common::SeekableReadStream *stream,
-	               Common::StreamTokenizer *tokenize, glm::mat4x4 &rotation, std::vector<float> &vertices);
+	static void readVerts(size_t n, Common::SeekableReadStream *stream,
+	                      Common::StreamTokenizer *tokenize, std::vector<float> &vertices);
 	/** Read the faces vertices from an ASCII stream. */
-	void readFaces(size_t n, Common::SeekableReadStream *stream, Common::StreamTokenizer *tokenize,
-	               std::vector<uint32> &faces, std::vector<uint32> &facesProperty, uint32 startVertex);
+	static void readFaces(size_t n, Common::SeekableReadStream *stream, Common::StreamTokenizer *tokenize,
+	                      std::vector<uint32> &faces);
 	/** Read floats number from lines of Common::UString. */
-	void readFloats(const std::vector<Common::UString> &strings,
-	                float *floats, uint32 n, uint32 start);
-	/** Read and construct an AABB tree/node from an ASCII stream. */
-	Common::AABBNode *readAABB(float *position, uint8 orientation,
-	                           Common::SeekableReadStream *stream,
-	                           Common::StreamTokenizer *tokenize);
+	static void readFloats(const std::vector<Common::UString> &strings,
+	                       float *floats, uint32 n, uint32 start);
+	/** Read the boxes of an AABB tree/node from an ASCII stream. */
+	static void readAABB(Common::SeekableReadStream *stream, Common::StreamTokenizer *tokenize,
+	                     std::vector<float> &boxes, std::vector<int32> &aabbFaces);
+
+	/** Place the vertices of a node. */
+	void placeVerts(const std::vector<float> &rawVertices, float *position,
+	                glm::mat4x4 &rotation, std::vector<float> &vertices);
+	/** Place the faces of a node. */
+	void placeFaces(const std::vector<uint32> &rawFaces, std::vector<uint32> &faces,
+	                std::vector<uint32> &facesProperty, uint32 startVertex);
+	/** Construct an AABB tree/node out of parsed boxes. */
+	Common::AABBNode *placeAABB(const File::Entry &entry, size_t &index,
+	                            float *position, uint8 orientation) const;
 	Common::AABBNode *buildAABBTree(std::vector<float> &vertices, std::vector<uint32> &faces);
 	Common::AABBNode *createAABB(uint32 face, std::vector<float> &vertices,
 	                             std::vector<uint32> &faces) const;
@@ -22,6 +22,8 @@
  *  An animation to be applied to a model.
  */
 
+#include <algorithm>
+
 #include "external/glm/gtc/type_ptr.hpp"
 #include "external/glm/gtc/matrix_transform.hpp"
 
@@ -74,21 +76,26 @@ void Animation::setTransTime(float transtime) {
 void Animation::update(Model *model,
                        float UNUSED(lastFrame),
                        float nextFrame,
-                       const std::vector<ModelNode *> &modelNodeMap) {
+                       const std::vector<ModelNode *> &modelNodeMap,
+                       Cursor &cursor) {
 	// TODO: Also need to fire off associated events
 	//       for event in _events event->fire()
 
+	if (cursor.position.size() != _nodeData.size()) {
+		cursor.position.assign(_nodeData.size(), 0);
+		cursor.orientation.assign(_nodeData.size(), 0);
+	}
 
 	float scale = model->getAnimationScale(_name);
-	for (NodeList::iterator n = nodeList.begin(); n != nodeList.end(); ++n) {
-		ModelNode *animNode = (*n)->_nodedata;
+	for (size_t n = 0; n < _nodeData.size(); n++) {
+		ModelNode *animNode = _nodeData[n];
 		ModelNode *target = modelNodeMap[animNode->_nodeNumber];
 		if (!target)
 			continue;
 
 		// Update position and orientation based on time
 		if (!animNode->_positionFrames.empty()) {
-			glm::vec3 pos(interpolatePosition(animNode, nextFrame));
+			glm::vec3 pos(interpolatePosition(animNode, nextFrame, cursor.position[n]));
 
 			if (model->arePositionFramesRelative())
 				pos += target->getBasePosition();
@@ -99,7 +106,7 @@ void Animation::update(Model *model,
 		}
 
 		if (!animNode->_orientationFrames.empty()) {
-			glm::quat ori(interpolateOrientation(animNode, nextFrame));
+			glm::quat ori(interpolateOrientation(animNode, nextFrame, cursor.orientation[n]));
 			target->setBufferedOrientation(ori.x, ori.y, ori.z, Common::rad2deg(acosf(ori.w) * 2.0f));
 		}
 	}
@@ -107,6 +114,7 @@ void Animation::update(Model *model,
 
 void Animation::addAnimNode(AnimNode *node) {
 	nodeList.push_back(node);
+	_nodeData.push_back(node->_nodedata);
 	nodeMap.insert(std::make_pair(node->getName(), node));
 }
 
@@ -153,21 +161,14 @@ static void normQuaternion(float  xIn , float  yIn , float  zIn , float  qIn,
 	qOut = qIn / magnitude;
 }
 
-glm::vec3 Animation::interpolatePosition(ModelNode *animNode, float time) const {
+glm::vec3 Animation::interpolatePosition(ModelNode *animNode, float time, size_t &cursor) const {
 	// If only one keyframe, don't interpolate, just set the only position
 	if (animNode->_positionFrames.size() == 1) {
 		const PositionKeyFrame &pos = animNode->_positionFrames[0];
 		return glm::vec3(pos.x, pos.y, pos.z);
 	}
 
-	size_t lastFrame = 0;
-	for (size_t i = 0; i < animNode->_positionFrames.size(); i++) {
-		const PositionKeyFrame &pos = animNode->_positionFrames[i];
-		if (pos.time >= time)
-			break;
-
-		lastFrame = i;
-	}
+	const size_t lastFrame = findKeyFrame(animNode->_positionFrames, time, cursor);
 
 	const PositionKeyFrame &last = animNode->_positionFrames[lastFrame];
 	if (lastFrame + 1 >= animNode->_positionFrames.size() || last.time >= time)
@@ -183,21 +184,14 @@ glm::vec3 Animation::interpolatePosition(ModelNode *animNode, float time) const
 	return glm::vec3(x, y, z);
 }
 
-glm::quat Animation::interpolateOrientation(ModelNode *animNode, float time) const {
+glm::quat Animation::interpolateOrientation(ModelNode *animNode, float time, size_t &cursor) const {
 	// If only one keyframe, don't interpolate just set the only orientation
 	if (animNode->_orientationFrames.size() == 1) {
 		const QuaternionKeyFrame &ori = animNode->_orientationFrames[0];
 		return glm::quat(ori.q, ori.x, ori.y, ori.z);
 	}
 
-	size_t lastFrame = 0;
-	for (size_t i = 0; i < animNode->_orientationFrames.size(); i++) {
-		const QuaternionKeyFrame &ori = animNode->_orientationFrames[i];
-		if (ori.time >= time)
-			break;
-
-		lastFrame = i;
-	}
+	const size_t lastFrame = findKeyFrame(animNode->_orientationFrames, time, cursor);
 
 	const QuaternionKeyFrame &last = animNode->_orientationFrames[lastFrame];
 	if (lastFrame + 1 >= animNode->_orientationFrames.size() || last.time >= time) {
@@ -27,6 +27,8 @@
 
 #include <list>
 #include <map>
+#include <vector>
+#include <algorithm>
 
 #include "src/common/ustring.h"
 #include "src/common/boundingbox.h"
@@ -49,6 +51,20 @@ class AnimNode;
 
 class Animation {
 public:
+	/** Where one model last found the keyframes of an animation.
+	 *
+	 *  Consecutive updates sample times close to each other. Searching
+	 *  the keyframes from where the last update found them is nearly
+	 *  always a hit. Only on larger jumps do we need a binary search.
+	 *
+	 *  Animations are shared between models, so every user of an
+	 *  animation keeps a cursor of its own.
+	 */
+	struct Cursor {
+		std::vector<size_t> position;    ///< Last position keyframe, per animation node.
+		std::vector<size_t> orientation; ///< Last orientation keyframe, per animation node.
+	};
+
 	Animation();
 	virtual ~Animation();
 
@@ -63,7 +79,8 @@ public:
 	void setTransTime(float transtime);
 
 	/** Update the model position and orientation */
-	virtual void update(Model *model, float lastFrame, float nextFrame, const std::vector<ModelNode *> &modelNodeMap);
+	virtual void update(Model *model, float lastFrame, float nextFrame,
+	                    const std::vector<ModelNode *> &modelNodeMap, Cursor &cursor);
 
 	// Nodes
 
@@ -79,6 +96,14 @@ public:
 	/** Get all animation nodes. */
 	const std::list<AnimNode *> &getNodes() const;
 
+	/** Find the last keyframe before this time, or the first keyframe if there is none.
+	 *
+	 *  The cursor holds the keyframe found the last time. It is checked first,
+	 *  then the keyframe right after it. Otherwise, we binary search.
+	 */
+	template<typename KeyFrame>
+	static size_t findKeyFrame(const std::vector<KeyFrame> &frames, float time, size_t &cursor);
+
 protected:
 	typedef std::list<AnimNode *> NodeList;
 	typedef std::map<Common::UString, AnimNode *, Common::UString::iless> NodeMap;
@@ -88,14 +113,39 @@ protected:
 
 	NodeList rootNodes; ///< The nodes in the state without a parent.
 
+	/** The keyframe data of all nodes, in the same order as nodeList. */
+	std::vector<ModelNode *> _nodeData;
+
 	Common::UString _name; ///< The model's name.
 	float _length;
 	float _transtime;
 
-	glm::vec3 interpolatePosition(ModelNode *animNode, float time) const;
-	glm::quat interpolateOrientation(ModelNode *animNode, float time) const;
+	glm::vec3 interpolatePosition(ModelNode *animNode, float time, size_t &cursor) const;
+	glm::quat interpolateOrientation(ModelNode *animNode, float time, size_t &cursor) const;
 };
 
+template<typename KeyFrame>
+size_t Animation::findKeyFrame(const std::vector<KeyFrame> &frames, float time, size_t &cursor) {
+	const size_t count = frames.size();
+
+	for (size_t i = cursor; (i < count) && (i <= cursor + 1); i++) {
+		if ((i > 0) && (frames[i].time >= time))
+			break;
+
+		if (((i + 1) >= count) || (frames[i + 1].time >= time)) {
+			cursor = i;
+			return i;
+		}
+	}
+
+	typename std::vector<KeyFrame>::const_iterator next =
+		std::lower_bound(frames.begin(), frames.end(), time,
+		                 [](const KeyFrame &frame, float t) { return frame.time < t; });
+
+	cursor = (next == frames.begin()) ? 0 : (next - frames.begin() - 1);
+	return cursor;
+}
+
 } // End of namespace Aurora
 
 } // End of namespace Graphics
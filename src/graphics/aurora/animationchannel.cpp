@@ -131,7 +131,7 @@ void AnimationChannel::manageAnimations(float dt) {
 
 	// The loop of the animation ended: make sure to play the last frame
 	if (lastFrame < _animationLoopLength && nextFrame >= _animationLoopLength) {
-		_currentAnimation->update(_model, lastFrame, _animationLoopLength, _modelNodeMap);
+		_currentAnimation->update(_model, lastFrame, _animationLoopLength, _modelNodeMap, _cursor);
 
 		_animationTime += dt;
 		_animationLoopTime = _animationLoopLength;
@@ -146,7 +146,7 @@ void AnimationChannel::manageAnimations(float dt) {
 		_nextAnimation = 0;
 
 		if (_currentAnimation)
-			_currentAnimation->update(_model, 0.0f, 0.0f, _modelNodeMap);
+			_currentAnimation->update(_model, 0.0f, 0.0f, _modelNodeMap, _cursor);
 
 		_model->createBound();
 		_manageMutex.unlock();
@@ -155,7 +155,7 @@ void AnimationChannel::manageAnimations(float dt) {
 
 	// Start the next loop of the animation
 	if (lastFrame >= _animationLoopLength) {
-		_currentAnimation->update(_model, 0.0f, 0.0f, _modelNodeMap);
+		_currentAnimation->update(_model, 0.0f, 0.0f, _modelNodeMap, _cursor);
 
 		lastFrame = 0.0f;
 		nextFrame = _animationSpeed * dt;
@@ -164,7 +164,7 @@ void AnimationChannel::manageAnimations(float dt) {
 	}
 
 	// Update the animation
-	_currentAnimation->update(_model, lastFrame, nextFrame, _modelNodeMap);
+	_currentAnimation->update(_model, lastFrame, nextFrame, _modelNodeMap, _cursor);
 
 	_animationTime += dt;
 	_animationLoopTime = nextFrame;
@@ -213,6 +213,9 @@ void AnimationChannel::setCurrentAnimation(Animation *anim) {
 	_currentAnimation = anim;
 	_animationLoopTime = 0.0f;
 
+	_cursor.position.clear();
+	_cursor.orientation.clear();
+
 	if (_currentAnimation)
 		makeModelNodeMap();
 }
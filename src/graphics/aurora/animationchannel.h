@@ -30,13 +30,14 @@
 
 #include "src/common/mutex.h"
 
+#include "src/graphics/aurora/animation.h"
+
 namespace Graphics {
 
 namespace Aurora {
 
 class Model;
 class ModelNode;
-class Animation;
 
 class AnimationChannel {
 public:
@@ -92,6 +93,7 @@ private:
 	float _animationLoopTime; ///< The time the current loop of the current animation has played.
 	DefaultAnimations _defaultAnimations;
 	std::vector<ModelNode *> _modelNodeMap;
+	Animation::Cursor _cursor; ///< Where we last found the keyframes of the current animation.
 	std::recursive_mutex _manageMutex;
 
 	void playDefaultAnimationInternal();
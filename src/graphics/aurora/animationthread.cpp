@@ -22,8 +22,13 @@
  *  Dedicated animation thread.
  */
 
+#include <algorithm>
+
 #include "external/glm/gtc/type_ptr.hpp"
 
+#include "src/common/util.h"
+#include "src/common/threadpool.h"
+
 #include "src/events/events.h"
 
 #include "src/graphics/camera.h"
@@ -38,9 +43,24 @@ namespace Aurora {
 const int kPauseDuration = 10;
 const int kYieldDuration = 1;
 
+/** Time between two updates of a model right in front of the camera, in ms. */
+const uint32 kMinUpdateInterval = 16;
+/** Time between two updates of a model far away from the camera, in ms. */
+const uint32 kMaxUpdateInterval = 250;
+/** With every step of this distance to the camera, the minimal interval is added. */
+const float kUpdateDistanceStep = 8.0f;
+
 AnimationThread::PoolModel::PoolModel(Model *m) : model(m) {
 }
 
+AnimationThread::AnimationThread() : _nextDueModel(0) {
+}
+
+AnimationThread::~AnimationThread() {
+	for (ModelMap::iterator m = _models.begin(); m != _models.end(); ++m)
+		delete m->second;
+}
+
 void AnimationThread::pause() {
 	PauseStatus expected = kPauseResumed;
 	if (!_pause.compare_exchange_strong(expected, kPauseRequested, std::memory_order_seq_cst))
@@ -63,6 +83,18 @@ void AnimationThread::registerModel(Model *model) {
 }
 
 void AnimationThread::unregisterModel(Model *model) {
+	{
+		// The model might not even have made it out of the registration queue
+		std::lock_guard<std::recursive_mutex> lock(_registerMutex);
+
+		ModelQueue queue;
+		for (; !_registerQueue.empty(); _registerQueue.pop())
+			if (_registerQueue.front() != model)
+				queue.push(_registerQueue.front());
+
+		_registerQueue.swap(queue);
+	}
+
 	if (_pause.load(std::memory_order_seq_cst) == kPausePaused) {
 		unregisterModelInternal(model);
 	} else {
@@ -72,21 +104,31 @@ void AnimationThread::unregisterModel(Model *model) {
 }
 
 void AnimationThread::flush() {
-	FlushStatus expected = kFlushReady;
-	if (!_flush.compare_exchange_strong(expected, kFlushRequested, std::memory_order_seq_cst))
-		return;
+	ModelList models;
 
-	bool inProgress = false;
-	while (!inProgress && (_pause.load(std::memory_order_seq_cst) != kPausePaused)) {
-		expected = kFlushGranted;
-		inProgress = _flush.compare_exchange_strong(expected, kFlushInProgress, std::memory_order_seq_cst);
-	}
+	{
+		std::lock_guard<std::mutex> lock(_updatedMutex);
+
+		models.swap(_updatedModels);
 
-	for (auto &m : _models) {
-		m.second.model->flushNodeBuffers();
+		ModelList::iterator flushing = models.begin();
+		for (ModelList::iterator m = models.begin(); m != models.end(); ++m) {
+			(*m)->queued = false;
+
+			// Models being updated again will queue themselves up again afterwards
+			ModelStatus expected = kModelUpdated;
+			if ((*m)->status.compare_exchange_strong(expected, kModelFlushing, std::memory_order_seq_cst))
+				*flushing++ = *m;
+		}
+
+		models.erase(flushing, models.end());
 	}
 
-	_flush.store(kFlushReady, std::memory_order_seq_cst);
+	for (ModelList::iterator m = models.begin(); m != models.end(); ++m) {
+		(*m)->model->flushNodeBuffers();
+
+		(*m)->status.store(kModelIdle, std::memory_order_seq_cst);
+	}
 }
 
 void AnimationThread::threadMethod() {
@@ -108,31 +150,80 @@ void AnimationThread::threadMethod() {
 			continue;
 		}
 
-		for (auto &m : _models) {
-			if (EventMan.quitRequested() || (_pause.load(std::memory_order_seq_cst) == kPausePaused))
-				break;
+		const uint32 now = EventMan.getTimestamp();
 
-			if (m.second.skippedCount < getNumIterationsToSkip(m.second.model)) {
-				++m.second.skippedCount;
+		for (ModelMap::iterator m = _models.begin(); m != _models.end(); ++m) {
+			// Attached models are animated by the model they're attached to
+			if (m->second->model->_attached.load(std::memory_order_relaxed))
 				continue;
-			} else {
-				m.second.skippedCount = 0;
-			}
 
-			handleFlush();
+			if (now >= m->second->nextUpdate)
+				_dueModels.push_back(m->second);
+		}
+
+		runTick();
+	}
+}
 
-			uint32 now = EventMan.getTimestamp();
-			float dt = 0;
-			if (m.second.lastChanged > 0) {
-				dt = (now - m.second.lastChanged) / 1000.0f;
-			}
-			m.second.lastChanged = now;
+void AnimationThread::runTick() {
+	if (_dueModels.empty())
+		return;
 
-			m.second.model->manageAnimations(dt);
-		}
+	_nextDueModel.store(0);
+
+	// Only bother the pool if there's enough to do for more than one thread
+	const size_t helpers = MIN(ThreadPoolMan.getThreadCount(), _dueModels.size() - 1);
+
+	Common::TaskGroup helping(ThreadPoolMan);
+	for (size_t i = 0; i < helpers; i++)
+		helping.run([this]() { updateDueModels(); });
+
+	updateDueModels();
+
+	helping.wait();
+
+	_dueModels.clear();
+}
+
+void AnimationThread::updateDueModels() {
+	for (size_t n = _nextDueModel++; n < _dueModels.size(); n = _nextDueModel++) {
+		if (EventMan.quitRequested() || (_pause.load(std::memory_order_seq_cst) == kPausePaused))
+			break;
+
+		updateModel(*_dueModels[n]);
 	}
 }
 
+void AnimationThread::updateModel(PoolModel &m) {
+	// A model being flushed right now will be due again in the next tick
+	ModelStatus expected = kModelIdle;
+	if (!m.status.compare_exchange_strong(expected, kModelUpdating, std::memory_order_seq_cst)) {
+		expected = kModelUpdated;
+		if (!m.status.compare_exchange_strong(expected, kModelUpdating, std::memory_order_seq_cst))
+			return;
+	}
+
+	const uint32 now = EventMan.getTimestamp();
+
+	float dt = 0;
+	if (m.lastChanged > 0) {
+		dt = (now - m.lastChanged) / 1000.0f;
+	}
+	m.lastChanged = now;
+	m.nextUpdate  = now + getUpdateInterval(m.model);
+
+	m.model->manageAnimations(dt);
+
+	std::lock_guard<std::mutex> lock(_updatedMutex);
+
+	if (!m.queued) {
+		_updatedModels.push_back(&m);
+		m.queued = true;
+	}
+
+	m.status.store(kModelUpdated, std::memory_order_seq_cst);
+}
+
 void AnimationThread::registerQueuedModels() {
 	std::unique_lock<std::recursive_mutex> lock(_registerMutex, std::try_to_lock);
 	if (!lock.owns_lock())
@@ -149,21 +240,41 @@ void AnimationThread::registerModelInternal(Model *model) {
 	if (it != _models.end())
 		return;
 
-	_models.insert(std::make_pair(model->getID(), PoolModel(model)));
+	_models.insert(std::make_pair(model->getID(), new PoolModel(model)));
 }
 
 void AnimationThread::unregisterModelInternal(Model *model) {
-	_models.erase(model->getID());
+	ModelMap::iterator it = _models.find(model->getID());
+	if (it == _models.end())
+		return;
+
+	PoolModel *poolModel = it->second;
+	_models.erase(it);
+
+	{
+		std::lock_guard<std::mutex> lock(_updatedMutex);
+
+		_updatedModels.erase(std::remove(_updatedModels.begin(), _updatedModels.end(), poolModel),
+		                     _updatedModels.end());
+	}
+
+	// Wait for the render thread to finish flushing the model
+	while (poolModel->status.load(std::memory_order_seq_cst) == kModelFlushing)
+		std::this_thread::yield();
+
+	delete poolModel;
 }
 
-uint8 AnimationThread::getNumIterationsToSkip(Model *model) const {
+uint32 AnimationThread::getUpdateInterval(Model *model) const {
 	const float *campos = CameraMan.getPosition();
 
 	float x, y, z;
 	model->getPosition(x, y, z);
 
-	float dist = glm::distance(glm::make_vec3(campos), glm::vec3(x, y, z));
-	return roundf(dist) / 8.0f;
+	const float dist = glm::distance(glm::make_vec3(campos), glm::vec3(x, y, z));
+	const uint32 interval = kMinUpdateInterval * (1 + static_cast<uint32>(dist / kUpdateDistanceStep));
+
+	return MIN(interval, kMaxUpdateInterval);
 }
 
 bool AnimationThread::handlePause() {
@@ -181,14 +292,6 @@ bool AnimationThread::handlePause() {
 	return false;
 }
 
-void AnimationThread::handleFlush() {
-	FlushStatus expected = kFlushRequested;
-	if (_flush.compare_exchange_strong(expected, kFlushGranted, std::memory_order_seq_cst)) {
-		while (_flush.load(std::memory_order_seq_cst) != kFlushReady)
-			; // Spin until flushing is finished
-	}
-}
-
 } // End of namespace Aurora
 
 } // End of namespace Engines
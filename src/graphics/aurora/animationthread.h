@@ -25,6 +25,7 @@
 #ifndef GRAPHICS_AURORA_ANIMATIONTHREAD_H
 #define GRAPHICS_AURORA_ANIMATIONTHREAD_H
 
+#include <vector>
 #include <map>
 #include <queue>
 #include <atomic>
@@ -41,8 +42,29 @@ namespace Aurora {
 
 class Model;
 
+/** The animation scheduler.
+ *
+ *  Every tick, the animation thread collects all models that are due for an
+ *  update and animates them together with the global thread pool. Each of
+ *  these threads grabs the next model nobody else has taken yet, until all
+ *  due models are updated.
+ *
+ *  How often a model is due depends on its distance to the camera: close
+ *  models are updated up to 60 times a second, models far away only a few
+ *  times a second.
+ *
+ *  Models attached to another model are animated by that model.
+ *
+ *  An updated model waits for the render thread to flush its changes. flush()
+ *  never waits for the workers: it takes over the list of all models updated
+ *  since the last flush. A model that is being updated again right now is
+ *  simply flushed with the next frame.
+ */
 class AnimationThread : public Common::Thread {
 public:
+	AnimationThread();
+	~AnimationThread();
+
 	void pause();
 	void resume();
 
@@ -62,32 +84,41 @@ private:
 		kPausePaused
 	};
 
-	enum FlushStatus {
-		kFlushReady,
-		kFlushRequested,
-		kFlushGranted,
-		kFlushInProgress
+	enum ModelStatus {
+		kModelIdle,     ///< Nothing to do.
+		kModelUpdating, ///< A worker is updating the model.
+		kModelUpdated,  ///< The model waits to be flushed.
+		kModelFlushing  ///< The render thread is flushing the model.
 	};
 
 	struct PoolModel {
 		Model *model;
 		uint32 lastChanged { 0 };
-		uint8 skippedCount { 0 }; ///< Number of skipped loop iterations.
+		uint32 nextUpdate { 0 };  ///< Timestamp when the model is due for the next update.
+		bool queued { false };    ///< Is the model in the list of updated models?
+
+		std::atomic<ModelStatus> status { kModelIdle };
 
 		PoolModel(Model *m);
 	};
 
-	typedef std::map<uint32, PoolModel> ModelMap;
+	typedef std::map<uint32, PoolModel *> ModelMap;
+	typedef std::vector<PoolModel *> ModelList;
 	typedef std::queue<Model *> ModelQueue;
 
 	ModelMap _models;
 	ModelQueue _registerQueue;
 
+	ModelList _dueModels;               ///< Models to update in the current tick.
+	std::atomic<size_t> _nextDueModel;  ///< Index of the next due model to hand out.
+
+	ModelList _updatedModels; ///< Models with changes waiting for a flush.
+
 	std::atomic<PauseStatus> _pause { kPauseResumed };
-	std::atomic<FlushStatus> _flush { kFlushReady };
 
 	std::recursive_mutex _modelsMutex;   ///< Mutex protecting access to the model map.
 	std::recursive_mutex _registerMutex; ///< Mutex protecting access to the registration queue.
+	std::mutex _updatedMutex;            ///< Mutex protecting access to the updated models.
 
 	// Model registration
 
@@ -97,9 +128,16 @@ private:
 
 
 	void threadMethod();
-	uint8 getNumIterationsToSkip(Model *model) const;
 	bool handlePause();
-	void handleFlush();
+
+	/** Update all due models, together with the thread pool. */
+	void runTick();
+	/** Update due models until there are none left. */
+	void updateDueModels();
+	void updateModel(PoolModel &m);
+
+	/** Return the time in ms between two updates of this model. */
+	uint32 getUpdateInterval(Model *model) const;
 };
 
 } // End of namespace Aurora
@@ -65,6 +65,7 @@ Model::Model(ModelType type) :
 		_currentState(0),
 		_hasSkinNodes(false),
 		_positionRelative(false),
+		_attached(false),
 		_drawBound(false),
 		_drawSkeleton(false),
 		_drawSkeletonInvisible(false) {
@@ -159,6 +160,16 @@ bool Model::isIn(float x1, float y1, float z1, float x2, float y2, float z2) con
 	return _absoluteBoundBox.isIn(x1, y1, z1, x2, y2, z2);
 }
 
+bool Model::getWorldBound(float min[3], float max[3]) const {
+	if ((_type == kModelTypeGUIFront) || _absoluteBoundBox.empty())
+		return false;
+
+	_absoluteBoundBox.getMin(min[0], min[1], min[2]);
+	_absoluteBoundBox.getMax(max[0], max[1], max[2]);
+
+	return true;
+}
+
 float Model::getWidth() const {
 	return _boundBox.getWidth() * _scale[0];
 }
@@ -315,6 +326,8 @@ void Model::createAbsolutePosition() {
 	_absoluteBoundBox = _boundBox;
 	_absoluteBoundBox.transform(_absolutePosition);
 	_absoluteBoundBox.absolutize();
+
+	boundChanged();
 }
 
 const std::list<Common::UString> &Model::getStates() const {
@@ -490,8 +503,10 @@ void Model::attachModel(const Common::UString &nodeName, Model *model) {
 
 	node->_attachedModel = model;
 
-	if (model)
+	if (model) {
+		model->_attached.store(true);
 		_attachedModels.insert(std::pair<Common::UString, Model *>(nodeName, model));
+	}
 
 	createBound();
 }
@@ -869,8 +884,10 @@ void Model::createStateNamesList(std::list<Common::UString> *stateNames) {
 void Model::createBound() {
 	_boundBox.clear();
 
-	if (!_currentState)
+	if (!_currentState) {
+		boundChanged();
 		return;
+	}
 
 	for (NodeList::iterator n = _currentState->rootNodes.begin();
 	     n != _currentState->rootNodes.end(); ++n) {
@@ -894,6 +911,8 @@ void Model::createBound() {
 	_absoluteBoundBox = _boundBox;
 	_absoluteBoundBox.transform(_absolutePosition);
 	_absoluteBoundBox.absolutize();
+
+	boundChanged();
 }
 
 void Model::readValue(Common::SeekableReadStream &stream, uint32 &value) {
@@ -28,6 +28,7 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <atomic>
 
 #include "external/glm/mat4x4.hpp"
 
@@ -93,6 +94,9 @@ public:
 	/** Does the line from x1.y1.z1 to x2.y2.z2 intersect with model's bounding box? */
 	bool isIn(float x1, float y1, float z1, float x2, float y2, float z2) const;
 
+	/** Get the model's absolute bounding box. */
+	bool getWorldBound(float min[3], float max[3]) const;
+
 	// Positioning
 
 	/** Get the current scale of the model. */
@@ -265,6 +269,9 @@ protected:
 	bool _hasSkinNodes;
 	bool _positionRelative;
 
+	/** Is this model attached to another model, which animates it? */
+	std::atomic<bool> _attached;
+
 
 	// Rendering
 	void queueDrawBound();
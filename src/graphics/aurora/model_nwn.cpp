@@ -808,13 +808,39 @@ void ModelNode_NWN_Binary::readMesh(Model_NWN::ParserContext &ctx) {
 
 	_render = _mesh->render;
 	_mesh->data = new MeshData();
-	_mesh->data->rawMesh = new Graphics::Mesh::Mesh();
 
 	textures.resize(textureCount);
 	loadTextures(textures);
 
 	size_t endPos = ctx.mdl->pos();
 
+	Common::UString meshName = ctx.mdlName;
+	meshName += ".";
+	if (ctx.state->name.size() != 0) {
+		meshName += ctx.state->name;
+	} else {
+		meshName += "xoreos.default";
+	}
+	meshName += ".";
+	meshName += _name;
+
+	/* The geometry of a mesh only depends on the model, not on the instance.
+	 * Area tiles, for example, use the same few models over and over again.
+	 * If we already decoded this mesh, share it instead of decoding it again. */
+	Graphics::Mesh::Mesh *checkMesh = MeshMan.getMesh(meshName);
+	if (checkMesh) {
+		_mesh->data->rawMesh = checkMesh;
+
+		createBound();
+
+		if (GfxMan.isRendererExperimental())
+			buildMaterial();
+
+		return;
+	}
+
+	_mesh->data->rawMesh = new Graphics::Mesh::Mesh();
+
 
 	// Read vertices
 
@@ -945,25 +971,9 @@ void ModelNode_NWN_Binary::readMesh(Model_NWN::ParserContext &ctx) {
 
 	ctx.mdl->seek(endPos);
 
-	Common::UString meshName = ctx.mdlName;
-	meshName += ".";
-	if (ctx.state->name.size() != 0) {
-		meshName += ctx.state->name;
-	} else {
-		meshName += "xoreos.default";
-	}
-	meshName += ".";
-	meshName += _name;
-
-	Graphics::Mesh::Mesh *checkMesh = MeshMan.getMesh(meshName);
-	if (checkMesh) {
-		delete _mesh->data->rawMesh;
-		_mesh->data->rawMesh = checkMesh;
-	} else {
-		_mesh->data->rawMesh->setName(meshName);
-		_mesh->data->rawMesh->init();
-		MeshMan.addMesh(_mesh->data->rawMesh);
-	}
+	_mesh->data->rawMesh->setName(meshName);
+	_mesh->data->rawMesh->init();
+	MeshMan.addMesh(_mesh->data->rawMesh);
 
 	if (GfxMan.isRendererExperimental())
 		buildMaterial();
@@ -1079,7 +1079,7 @@ void ModelNode_Witcher::buildMaterial() {
 	}
 
 	if (penvmap) {
-		if (penvmap->getTexture().getImage().isCubeMap()) {
+		if (penvmap->getTexture().isCubeMap()) {
 			cripter.declareInput(Graphics::Shader::ShaderDescriptor::INPUT_UV_CUBE);
 			cripter.declareSampler(Graphics::Shader::ShaderDescriptor::SAMPLER_TEXTURE_7,
 			                       Graphics::Shader::ShaderDescriptor::SAMPLER_CUBE);
@@ -1098,7 +1098,7 @@ void ModelNode_Witcher::buildMaterial() {
 		if (envmapmode == kModeEnvironmentBlendedUnder) {
 			materialName += penvmap->getName();
 			// Figure out if a cube or sphere map is used.
-			if (penvmap->getTexture().getImage().isCubeMap()) {
+			if (penvmap->getTexture().isCubeMap()) {
 				if (!pmesh->isTransparent) {
 					materialFlags |= Shader::ShaderMaterial::MATERIAL_OPAQUE;
 				}
@@ -1207,7 +1207,7 @@ void ModelNode_Witcher::buildMaterial() {
 		if (envmapmode == kModeEnvironmentBlendedOver) {
 			materialName += penvmap->getName();
 			// Figure out if a cube or sphere map is used.
-			if (penvmap->getTexture().getImage().isCubeMap()) {
+			if (penvmap->getTexture().isCubeMap()) {
 				cripter.addPass(Graphics::Shader::ShaderDescriptor::ENV_CUBE,
 				                Graphics::Shader::ShaderDescriptor::BLEND_DST_ALPHA);
 			} else {
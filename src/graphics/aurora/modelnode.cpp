@@ -457,6 +457,17 @@ void ModelNode::loadTextures(const std::vector<Common::UString> &textures) {
 
 	Common::UString envMap;
 
+	/* Start loading all textures in the background first, so that they're
+	 * decoded in parallel. Each get() then only waits for its texture. */
+	std::vector<TextureHandle> requested;
+	for (size_t t = 0; t != textures.size(); t++) {
+		try {
+			if (!textures[t].empty() && (textures[t] != "NULL"))
+				requested.push_back(TextureMan.request(textures[t]));
+		} catch (...) {
+		}
+	}
+
 	for (size_t t = 0; t != textures.size(); t++) {
 
 		try {
@@ -1307,7 +1318,7 @@ void ModelNode::declareShaderInputs(MaterialConfiguration &UNUSED(config), Shade
 }
 
 void ModelNode::setupEnvMapSampler(MaterialConfiguration &config, Shader::ShaderDescriptor &cripter) {
-	if (config.penvmap->getTexture().getImage().isCubeMap()) {
+	if (config.penvmap->getTexture().isCubeMap()) {
 		cripter.declareInput(Shader::ShaderDescriptor::INPUT_UV_CUBE);
 
 		cripter.declareSampler(Shader::ShaderDescriptor::SAMPLER_TEXTURE_7,
@@ -1333,7 +1344,7 @@ void ModelNode::addBlendedUnderEnvMapPass(MaterialConfiguration &config, Shader:
 	config.materialName += config.penvmap->getName();
 
 	// Figure out if a cube or sphere map is used.
-	if (config.penvmap->getTexture().getImage().isCubeMap()) {
+	if (config.penvmap->getTexture().isCubeMap()) {
 		if (!config.pmesh->isTransparent)
 			config.materialFlags |= Shader::ShaderMaterial::MATERIAL_OPAQUE;
 
@@ -1435,7 +1446,7 @@ void ModelNode::addBlendedOverEnvMapPass(MaterialConfiguration &config, Shader::
 	config.materialName += config.penvmap->getName();
 
 	// Figure out if a cube or sphere map is used.
-	if (config.penvmap->getTexture().getImage().isCubeMap()) {
+	if (config.penvmap->getTexture().isCubeMap()) {
 		cripter.addPass(Shader::ShaderDescriptor::ENV_CUBE,
 		                Shader::ShaderDescriptor::BLEND_DST_ALPHA);
 
@@ -188,6 +188,9 @@ public:
 		std::vector<float>       boneMappingId;
 		std::vector<ModelNode *> boneNodeMap;
 
+		/** Combined skinning matrix of each bone, kept to avoid reallocating it every frame. */
+		std::vector<glm::mat4>   boneMatrices;
+
 		Skin();
 	};
 
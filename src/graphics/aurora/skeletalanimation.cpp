@@ -25,6 +25,8 @@
 #include "external/glm/gtc/type_ptr.hpp"
 #include "external/glm/gtc/matrix_transform.hpp"
 
+#include "src/graphics/skinning.h"
+
 #include "src/graphics/aurora/skeletalanimation.h"
 #include "src/graphics/aurora/model.h"
 #include "src/graphics/aurora/animnode.h"
@@ -41,9 +43,10 @@ SkeletalAnimation::SkeletalAnimation(int bonesPerVertex) :
 void SkeletalAnimation::update(Model *model,
                                float lastFrame,
                                float nextFrame,
-                               const std::vector<ModelNode *> &modelNodeMap) {
+                               const std::vector<ModelNode *> &modelNodeMap,
+                               Cursor &cursor) {
 
-	Animation::update(model, lastFrame, nextFrame, modelNodeMap);
+	Animation::update(model, lastFrame, nextFrame, modelNodeMap, cursor);
 	updateModel(model, lastFrame);
 }
 
@@ -51,12 +54,13 @@ void SkeletalAnimation::updateModel(Model *model, float time) {
 	if (!model->hasSkinNodes())
 		return;
 
+	// The node transformations don't change between the skin nodes of one model
+	model->computeNodeTransforms();
+
 	for (const auto &n : model->getNodes()) {
 		if (!n->hasSkinNode())
 			continue;
 
-		model->computeNodeTransforms();
-
 		if (GfxMan.isRendererExperimental()) {
 			fillBoneTransforms(n);
 			continue;
@@ -99,55 +103,31 @@ void SkeletalAnimation::transform(ModelNode *node,
                                   const std::vector<float> &boneWeights,
                                   VertexBuffer *vertexBuffer) {
 
-	const int vertexCount = static_cast<int>(vertsIn.size()) / 3;
-	const float *vertsInData = vertsIn.data();
-
-	const float *boneIndicesData = boneIndices.data();
-	const float *boneWeightsData = boneWeights.data();
-	const int boneStride = _bonesPerVertex;
-
-	float *bufferData = static_cast<float *>(vertexBuffer->getData());
-	const int bufferStride = static_cast<int>(vertexBuffer->getVertexDecl()[0].stride) / sizeof(float);
+	ModelNode::Skin *skin = node->getMesh()->skin;
 
-	for (int i = 0; i < vertexCount; ++i) {
-		bufferData[0] = 0.0f;
-		bufferData[1] = 0.0f;
-		bufferData[2] = 0.0f;
+	const std::vector<ModelNode *> &boneNodes = skin->boneNodeMap;
 
-		for (int j = 0; j < _bonesPerVertex; ++j) {
-			const int boneIndex = static_cast<int>(boneIndicesData[j]);
-			if (boneIndex == -1)
-				continue;
+	/* Combine the transformations each vertex goes through into one matrix per
+	 * bone: into the model space, by the bone, and back into the node space.
+	 *
+	 * Animations are shared between models through their supermodels, and
+	 * several models are animated at once. The matrices are therefore kept
+	 * with the skin, which belongs to only one model. */
+	std::vector<glm::mat4> &boneMatrices = skin->boneMatrices;
+	boneMatrices.resize(boneNodes.size());
 
-			const glm::mat4 &boneTransform = node->getBoneNode(boneIndex)->getBoneTransform();
-			const float boneWeight = boneWeightsData[j];
-			float v0[3], v1[3];
+	const glm::mat4 &base = node->getAbsoluteBaseTransform();
+	const glm::mat4 &baseInverse = node->getAbsoluteBaseTransformInverse();
 
-			multiply(vertsInData, node->getAbsoluteBaseTransform(), v0);
-			multiply(v0, boneTransform, v1);
-			multiply(v1, node->getAbsoluteBaseTransformInverse(), v0);
-
-			bufferData[0] += v0[0] * boneWeight;
-			bufferData[1] += v0[1] * boneWeight;
-			bufferData[2] += v0[2] * boneWeight;
-		}
-
-		vertsInData += 3;
-		boneIndicesData += boneStride;
-		boneWeightsData += boneStride;
-		bufferData += bufferStride;
-	}
-}
+	for (size_t i = 0; i < boneNodes.size(); ++i)
+		boneMatrices[i] = boneNodes[i] ? (baseInverse * boneNodes[i]->getBoneTransform() * base) : glm::mat4(1.0f);
 
-void SkeletalAnimation::multiply(const float *v, const glm::mat4 &m, float *vOut) {
-	float x = v[0] * m[0][0] + v[1] * m[1][0] + v[2] * m[2][0] + m[3][0];
-	float y = v[0] * m[0][1] + v[1] * m[1][1] + v[2] * m[2][1] + m[3][1];
-	float z = v[0] * m[0][2] + v[1] * m[1][2] + v[2] * m[2][2] + m[3][2];
-	float w = v[0] * m[0][3] + v[1] * m[1][3] + v[2] * m[2][3] + m[3][3];
+	const size_t vertexCount = vertsIn.size() / 3;
+	const size_t bufferStride = vertexBuffer->getVertexDecl()[0].stride / sizeof(float);
 
-	vOut[0] = x / w;
-	vOut[1] = y / w;
-	vOut[2] = z / w;
+	skinVertices(vertsIn.data(), vertexCount, boneIndices.data(), boneWeights.data(), _bonesPerVertex,
+	             boneMatrices.data(), boneMatrices.size(),
+	             static_cast<float *>(vertexBuffer->getData()), bufferStride);
 }
 
 } // End of namespace Aurora
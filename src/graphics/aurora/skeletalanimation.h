@@ -47,7 +47,8 @@ public:
 	void update(Model *model,
 	            float lastFrame,
 	            float nextFrame,
-	            const std::vector<ModelNode *> &modelNodeMap);
+	            const std::vector<ModelNode *> &modelNodeMap,
+	            Cursor &cursor);
 
 private:
 	int _bonesPerVertex;
@@ -56,6 +57,9 @@ private:
 	void fillBoneTransforms(ModelNode *node);
 
 	/** Transform vertex coordinates.
+	 *
+	 *  Combines the transformations of each bone into one matrix, then
+	 *  skins all vertices of the node in one go.
 	 *
 	 *  @param node         Model node whose vertices are being transformed.
 	 *  @param vertsIn      Input array of vertex coordinates.
@@ -68,9 +72,6 @@ private:
 	               const std::vector<float> &boneIndices,
 	               const std::vector<float> &boneWeights,
 	               VertexBuffer *vertexBuffer);
-
-	/** Multiply a specified vector by a specified matrix. */
-	static void multiply(const float *v, const glm::mat4 &m, float *vOut);
 };
 
 } // End of namespace Aurora
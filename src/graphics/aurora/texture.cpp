@@ -31,6 +31,7 @@
 #include "src/common/readstream.h"
 
 #include "src/graphics/aurora/texture.h"
+#include "src/graphics/aurora/textureman.h"
 #include "src/graphics/aurora/pltfile.h"
 
 #include "src/graphics/types.h"
@@ -55,12 +56,21 @@ namespace Graphics {
 
 namespace Aurora {
 
-Texture::Texture() : _type(::Aurora::kFileTypeNone), _width(0), _height(0), _deswizzle(false) {
+Texture::Texture() : _type(::Aurora::kFileTypeNone), _width(0), _height(0), _deswizzle(false), _loaded(true),
+	_hasAlpha(false), _isCubeMap(false), _dataSize(0), _lastUsed(0), _imageTracked(false) {
+
+}
+
+Texture::Texture(const Common::UString &name, bool deswizzle) :
+	_name(name), _type(::Aurora::kFileTypeNone), _width(0), _height(0), _deswizzle(deswizzle), _loaded(false),
+	_hasAlpha(false), _isCubeMap(false), _dataSize(0), _lastUsed(0), _imageTracked(false) {
+
 }
 
 Texture::Texture(const Common::UString &name, ImageDecoder *image,
                  ::Aurora::FileType type, TXI *txi, bool deswizzle) :
-	_name(name), _type(type), _width(0), _height(0), _deswizzle(deswizzle) {
+	_name(name), _type(type), _width(0), _height(0), _deswizzle(deswizzle), _loaded(true),
+	_hasAlpha(false), _isCubeMap(false), _dataSize(0), _lastUsed(0), _imageTracked(false) {
 
 	set(name, image, type, txi, deswizzle);
 	addToQueues();
@@ -69,6 +79,9 @@ Texture::Texture(const Common::UString &name, ImageDecoder *image,
 Texture::~Texture() {
 	removeFromQueues();
 
+	if (_imageTracked.load())
+		TextureMan.untrackImage(*this);
+
 	if (_textureID != 0)
 		GfxMan.abandon(&_textureID, 1);
 }
@@ -82,33 +95,81 @@ uint32 Texture::getHeight() const {
 }
 
 bool Texture::hasAlpha() const {
-	if (!_image)
-		return false;
+	return _hasAlpha;
+}
 
-	return _image->hasAlpha();
+bool Texture::isCubeMap() const {
+	return _isCubeMap;
 }
 
 bool Texture::isDynamic() const {
 	return false;
 }
 
+bool Texture::isLoaded() const {
+	return _loaded.load(std::memory_order_acquire);
+}
+
 static const TXI kEmptyTXI;
 const TXI &Texture::getTXI() const {
 	if (_txi)
 		return *_txi;
 
-	if (_image)
-		return _image->getTXI();
+	if (_imageTXI)
+		return *_imageTXI;
 
 	return kEmptyTXI;
 }
 
 const ImageDecoder &Texture::getImage() const {
-	assert(_image);
+	// Whoever wants the image gets to keep it, until the texture is rebuilt
+	if (_imageTracked.load())
+		TextureMan.untrackImage(*this);
+
+	std::lock_guard<std::recursive_mutex> lock(_imageMutex);
+
+	restoreImage();
+	if (!_image)
+		throw Common::Exception("Texture \"%s\" has no image", _name.c_str());
 
 	return *_image;
 }
 
+size_t Texture::getDataSize() const {
+	return _dataSize;
+}
+
+bool Texture::isImageResident() const {
+	std::lock_guard<std::recursive_mutex> lock(_imageMutex);
+
+	return _image.get() != 0;
+}
+
+bool Texture::canEvictImage() const {
+	// We need to be able to read the image again. Dynamic textures change their image themselves
+	return isLoaded() && !_name.empty() && !isDynamic();
+}
+
+void Texture::evictImage() {
+	std::lock_guard<std::recursive_mutex> lock(_imageMutex);
+
+	_image.reset();
+}
+
+void Texture::restoreImage() const {
+	if (_image || !canEvictImage())
+		return;
+
+	::Aurora::FileType type = ::Aurora::kFileTypeNone;
+
+	try {
+		_image.reset(loadImage(_name, type, _txi.get(), _deswizzle));
+	} catch (Common::Exception &e) {
+		e.add("Failed to read the image of texture \"%s\" again", _name.c_str());
+		throw;
+	}
+}
+
 bool Texture::reload() {
 	if (_name.empty())
 		return false;
@@ -137,10 +198,10 @@ bool Texture::reload() {
 }
 
 bool Texture::dumpTGA(const Common::UString &fileName) const {
-	if (!_image)
+	if (!isLoaded())
 		return false;
 
-	return _image->dumpTGA(fileName);
+	return getImage().dumpTGA(fileName);
 }
 
 void Texture::doDestroy() {
@@ -153,20 +214,33 @@ void Texture::doDestroy() {
 }
 
 void Texture::doRebuild() {
-	if (!_image)
-		// No image
-		return;
+	{
+		std::lock_guard<std::recursive_mutex> lock(_imageMutex);
+
+		// The image might have been dropped after the last upload
+		try {
+			restoreImage();
+		} catch (...) {
+			Common::exceptionDispatcherWarning();
+		}
 
-	// Generate the texture ID
-	if (_textureID == 0)
-		glGenTextures(1, &_textureID);
+		if (!_image)
+			// No image
+			return;
 
-	if (_image->isCubeMap()) {
-		createCubeMapTexture();
-		return;
+		// Generate the texture ID
+		if (_textureID == 0)
+			glGenTextures(1, &_textureID);
+
+		if (_image->isCubeMap())
+			createCubeMapTexture();
+		else
+			create2DTexture();
 	}
 
-	create2DTexture();
+	// The image is uploaded now, so the TextureManager may drop it when memory runs short
+	if (canEvictImage())
+		TextureMan.trackImage(*this);
 }
 
 void Texture::setWrap(GLenum target, GLint wrapModeX, GLint wrapModeY) {
@@ -386,15 +460,28 @@ Texture *Texture::create(ImageDecoder *image, ::Aurora::FileType type, TXI *txi,
 void Texture::set(const Common::UString &name, ImageDecoder *image, ::Aurora::FileType type,
                   TXI *txi, bool deswizzle) {
 
+	std::lock_guard<std::recursive_mutex> lock(_imageMutex);
+
 	_name = name;
 	_type = type;
 
 	_image.reset(image);
 	_txi.reset(txi);
 
+	// Keep the image's own TXI around, for when the image is dropped
+	_imageTXI.reset(_txi ? 0 : new TXI(_image->getTXI()));
+
 	_width  = _image->getMipMap(0).width;
 	_height = _image->getMipMap(0).height;
 
+	_hasAlpha  = _image->hasAlpha();
+	_isCubeMap = _image->isCubeMap();
+
+	_dataSize = 0;
+	for (size_t i = 0; i < _image->getLayerCount(); i++)
+		for (size_t j = 0; j < _image->getMipMapCount(); j++)
+			_dataSize += _image->getMipMap(j, i).size;
+
 	_deswizzle = deswizzle;
 }
 
@@ -25,8 +25,11 @@
 #ifndef GRAPHICS_AURORA_TEXTURE_H
 #define GRAPHICS_AURORA_TEXTURE_H
 
+#include <atomic>
+
 #include "src/common/scopedptr.h"
 #include "src/common/ustring.h"
+#include "src/common/mutex.h"
 
 #include "src/graphics/types.h"
 #include "src/graphics/texture.h"
@@ -53,15 +56,34 @@ public:
 	uint32 getHeight() const;
 
 	bool hasAlpha() const;
+	bool isCubeMap() const;
 
 	/** Is this a dynamic texture, or a shared static one? */
 	virtual bool isDynamic() const;
 
+	/** Has the image been loaded?
+	 *
+	 *  A texture requested from the TextureManager asynchronously is only a
+	 *  placeholder without an image until a loader thread has decoded it.
+	 *  Only then are the dimensions, the TXI and the image available.
+	 */
+	bool isLoaded() const;
+
 	/** Return the TXI. */
 	const TXI &getTXI() const;
-	/** Return the image. */
+	/** Return the image.
+	 *
+	 *  If the TextureManager dropped the image after it was uploaded, it is
+	 *  read from the resources again, and kept until the texture is rebuilt.
+	 *  Throws if the texture has no image, or if reading it again failed.
+	 */
 	const ImageDecoder &getImage() const;
 
+	/** Return the size of the image data in bytes, whether it's held in memory or not. */
+	size_t getDataSize() const;
+	/** Is the image data held in memory? */
+	bool isImageResident() const;
+
 	/** Try to reload the texture. */
 	virtual bool reload();
 
@@ -86,16 +108,30 @@ protected:
 	Common::UString    _name; ///< The name of the texture's image's file.
 	::Aurora::FileType _type; ///< The type of the texture's image's file.
 
-	Common::ScopedPtr<ImageDecoder> _image; ///< The actual image.
-	Common::ScopedPtr<TXI> _txi;            ///< The TXI.
+	mutable Common::ScopedPtr<ImageDecoder> _image; ///< The actual image.
+	Common::ScopedPtr<TXI> _txi;                    ///< The TXI.
+	Common::ScopedPtr<TXI> _imageTXI;               ///< A copy of the image's own TXI.
 
 	uint32 _width;
 	uint32 _height;
 
 	bool _deswizzle;
 
+	std::atomic<bool> _loaded; ///< Has the image been loaded?
+
+	bool _hasAlpha;
+	bool _isCubeMap;
+	size_t _dataSize;
+
+	std::atomic<uint64> _lastUsed;     ///< When was the texture last used for rendering?
+	mutable std::atomic<bool> _imageTracked; ///< Is the TextureManager tracking the image in memory?
+
+	mutable std::recursive_mutex _imageMutex; ///< Mutex protecting the image against being dropped.
+
 
 	Texture();
+	/** Create a placeholder texture, with the image to be loaded later. */
+	Texture(const Common::UString &name, bool deswizzle);
 	Texture(const Common::UString &name, ImageDecoder *image, ::Aurora::FileType type, TXI *txi = 0,
 	        bool deswizzle = false);
 
@@ -106,6 +142,16 @@ protected:
 	void removeFromQueues();
 	void refresh();
 
+	/** Can the image be dropped from memory, to be read from the resources again when needed? */
+	bool canEvictImage() const;
+	/** Drop the image from memory. */
+	void evictImage();
+	/** Read the image from the resources again, if it has been dropped. The image mutex has to be locked.
+	 *
+	 *  Throws if reading the image failed.
+	 */
+	void restoreImage() const;
+
 
 	// GLContainer
 	void doRebuild();
@@ -129,6 +175,8 @@ protected:
 	                               bool deswizzle = false);
 
 	static Texture *createPLT(const Common::UString &name, Common::SeekableReadStream *imageStream);
+
+	friend class TextureManager;
 };
 
 } // End of namespace Aurora
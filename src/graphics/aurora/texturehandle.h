@@ -41,6 +41,8 @@ struct ManagedTexture {
 	Texture *texture;
 	uint32 referenceCount;
 
+	bool failed; ///< Did loading the texture in the background fail?
+
 	ManagedTexture(Texture *t);
 	~ManagedTexture();
 };
@@ -22,20 +22,27 @@
  *  The Aurora texture manager.
  */
 
+#include <algorithm>
+
 #include "src/common/scopedptr.h"
+#include "src/common/configman.h"
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/uuid.h"
+#include "src/common/threadpool.h"
 
 #include "src/graphics/aurora/textureman.h"
 #include "src/graphics/aurora/texture.h"
 
 #include "src/graphics/images/decoder.h"
+#include "src/graphics/images/txi.h"
 
 #include "src/graphics/graphics.h"
 
 #include "src/events/requests.h"
 
+#include "src/aurora/resman.h"
+
 DECLARE_SINGLETON(Graphics::Aurora::TextureManager)
 
 namespace Graphics {
@@ -79,17 +86,43 @@ static GLenum kTextureUnit[] = {
 
 static const size_t kTextureUnitCount = ARRAYSIZE(kTextureUnit);
 
+TextureManager::TextureLoad::TextureLoad(Texture *t, LoadPriority p, float d, uint64 o) :
+	texture(t), priority(p), distance(d), order(o), loading(false), cancelled(false) {
+
+}
+
+bool TextureManager::TextureLoad::operator<(const TextureLoad &right) const {
+	if (priority != right.priority)
+		return priority < right.priority;
+
+	if (distance != right.distance)
+		return distance < right.distance;
 
-TextureManager::TextureManager() : _deswizzleSBM(false), _recordNewTextures(false) {
+	return order < right.order;
+}
+
+
+TextureManager::TextureManager() : _deswizzleSBM(false), _recordNewTextures(false),
+	_loadOrder(0), _loadTasks(0), _residentImageSize(0), _imageBudget(kImageBudgetUnlimited), _useCounter(0) {
+
+	const int budget = ConfigMan.getInt("textureimagebudget", -1);
+	if (budget >= 0)
+		_imageBudget = ((size_t) budget) * 1024 * 1024;
 }
 
 TextureManager::~TextureManager() {
 	clear();
+
+	// Wait for the load tasks still queued on the thread pool
+	std::unique_lock<std::mutex> lock(_loadMutex);
+	_loadDone.wait(lock, [&]() { return _loadTasks == 0; });
 }
 
 void TextureManager::clear() {
 	std::lock_guard<std::recursive_mutex> lock(_mutex);
 
+	cancelLoads();
+
 	_bogusTextures.clear();
 
 	for (TextureMap::iterator t = _textures.begin(); t != _textures.end(); ++t)
@@ -117,7 +150,9 @@ bool TextureManager::hasTexture(const Common::UString &name) {
 
 	if (_bogusTextures.find(name) != _bogusTextures.end())
 		return true;
-	if (_textures.find(name) != _textures.end())
+
+	TextureMap::const_iterator texture = _textures.find(name);
+	if ((texture != _textures.end()) && !texture->second->failed)
 		return true;
 
 	return false;
@@ -150,12 +185,38 @@ TextureHandle TextureManager::add(Texture *texture, Common::UString name) {
 }
 
 TextureHandle TextureManager::get(Common::UString name) {
+	TextureHandle loading;
+
+	{
+		std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+		TextureMap::iterator texture = _textures.find(name);
+		if ((texture != _textures.end()) && (_bogusTextures.find(name) == _bogusTextures.end())) {
+			// Try again to load a texture that failed to load in the background
+			if (texture->second->failed) {
+				texture->second->failed = false;
+
+				queueLoad(*texture->second->texture, kLoadPriorityUI, 0.0f);
+			}
+
+			loading = TextureHandle(texture);
+		}
+	}
+
+	/* A texture that's still loading in the background is finished now. Wait
+	 * without holding the textures, since the load needs them once it's done. */
+	if (!loading.empty())
+		waitForLoad(*loading._it->second->texture);
+
 	std::lock_guard<std::recursive_mutex> lock(_mutex);
 
 	if (_bogusTextures.find(name) != _bogusTextures.end())
 		return TextureHandle();
 
 	TextureMap::iterator texture = _textures.find(name);
+	if ((texture != _textures.end()) && texture->second->failed)
+		throw Common::Exception("Failed to load texture \"%s\"", name.c_str());
+
 	if (texture == _textures.end()) {
 		std::pair<TextureMap::iterator, bool> result;
 
@@ -182,12 +243,227 @@ TextureHandle TextureManager::getIfExist(const Common::UString &name) {
 		return TextureHandle();
 
 	TextureMap::iterator texture = _textures.find(name);
-	if (texture != _textures.end())
+	if ((texture != _textures.end()) && !texture->second->failed)
 		return TextureHandle(texture);
 
 	return TextureHandle();
 }
 
+TextureHandle TextureManager::request(Common::UString name, LoadPriority priority, float distance) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	if (_bogusTextures.find(name) != _bogusTextures.end())
+		return TextureHandle();
+
+	TextureMap::iterator texture = _textures.find(name);
+	if (texture == _textures.end()) {
+		// PLT textures are dynamic and a class of their own, so we can't give out a placeholder
+		if (ResMan.hasResource(name, ::Aurora::kFileTypePLT))
+			return get(name);
+
+		Common::ScopedPtr<ManagedTexture> managedTexture(new ManagedTexture(new Texture(name, _deswizzleSBM)));
+
+		texture = _textures.insert(std::make_pair(name, managedTexture.get())).first;
+		queueLoad(*managedTexture.release()->texture, priority, distance);
+
+	} else if (texture->second->failed) {
+		// Try again to load a texture that failed to load in the background
+		texture->second->failed = false;
+
+		queueLoad(*texture->second->texture, priority, distance);
+
+	} else {
+		// Someone else requested it already. Load it sooner if we need it more urgently
+		std::lock_guard<std::mutex> loadLock(_loadMutex);
+
+		TextureLoadMap::iterator textureLoad = _loads.find(texture->second->texture);
+		if ((textureLoad != _loads.end()) && !textureLoad->second->loading) {
+			const TextureLoad wanted(0, priority, distance, textureLoad->second->order);
+
+			if (wanted < *textureLoad->second) {
+				textureLoad->second->priority = priority;
+				textureLoad->second->distance = distance;
+			}
+		}
+	}
+
+	if (_recordNewTextures)
+		_newTextureNames.push_back(name);
+
+	return TextureHandle(texture);
+}
+
+void TextureManager::setLoadPriority(const TextureHandle &handle, LoadPriority priority, float distance) {
+	if (handle.empty())
+		return;
+
+	std::lock_guard<std::mutex> lock(_loadMutex);
+
+	TextureLoadMap::iterator textureLoad = _loads.find(handle._it->second->texture);
+	if ((textureLoad == _loads.end()) || textureLoad->second->loading)
+		return;
+
+	textureLoad->second->priority = priority;
+	textureLoad->second->distance = distance;
+}
+
+size_t TextureManager::getPendingLoadCount() {
+	std::lock_guard<std::mutex> lock(_loadMutex);
+
+	return _loads.size();
+}
+
+void TextureManager::waitForLoads() {
+	std::unique_lock<std::mutex> lock(_loadMutex);
+
+	_loadDone.wait(lock, [&]() { return _loads.empty(); });
+}
+
+void TextureManager::queueLoad(Texture &texture, LoadPriority priority, float distance) {
+	{
+		std::lock_guard<std::mutex> lock(_loadMutex);
+
+		TextureLoad *textureLoad = new TextureLoad(&texture, priority, distance, _loadOrder++);
+
+		_loads.insert(std::make_pair(&texture, textureLoad));
+		_loadQueue.push_back(textureLoad);
+
+		_loadTasks++;
+	}
+
+	ThreadPoolMan.run([this]() { loadNext(); });
+}
+
+void TextureManager::loadNext() {
+	std::unique_lock<std::mutex> lock(_loadMutex);
+
+	// The texture this task was queued for might have been cancelled or loaded by get() already
+	if (!_loadQueue.empty())
+		load(popLoad(), lock);
+
+	_loadTasks--;
+	_loadDone.notify_all();
+}
+
+TextureManager::TextureLoad *TextureManager::popLoad() {
+	std::vector<TextureLoad *>::iterator next =
+		std::min_element(_loadQueue.begin(), _loadQueue.end(),
+		                 [](const TextureLoad *a, const TextureLoad *b) { return *a < *b; });
+
+	TextureLoad *textureLoad = *next;
+	_loadQueue.erase(next);
+
+	return textureLoad;
+}
+
+void TextureManager::load(TextureLoad *textureLoad, std::unique_lock<std::mutex> &lock) {
+	textureLoad->loading = true;
+
+	// A placeholder doesn't change until it's loaded, and it's not deleted while we're loading
+	const Common::UString name = textureLoad->texture->_name;
+	const bool deswizzle = textureLoad->texture->_deswizzle;
+
+	lock.unlock();
+
+	::Aurora::FileType type = ::Aurora::kFileTypeNone;
+	ImageDecoder *image = 0;
+	TXI *txi = 0;
+
+	try {
+		txi   = Texture::loadTXI  (name);
+		image = Texture::loadImage(name, type, txi, deswizzle);
+	} catch (...) {
+		delete txi;
+		txi = 0;
+
+		Common::exceptionDispatcherWarning("Failed to load texture \"%s\"", name.c_str());
+	}
+
+	std::lock_guard<std::recursive_mutex> textureLock(_mutex);
+	lock.lock();
+
+	if (!textureLoad->cancelled) {
+		Texture &texture = *textureLoad->texture;
+
+		_loads.erase(&texture);
+
+		if (image) {
+			texture.set(name, image, type, txi, deswizzle);
+			texture._loaded.store(true, std::memory_order_release);
+
+			// The render thread uploads the texture
+			texture.addToQueues();
+
+			image = 0;
+			txi   = 0;
+		} else {
+			/* Don't hand out the placeholder anymore, until someone asks for it again.
+			 * It's removed once the last handle to it is released. */
+			TextureMap::iterator managed = _textures.find(name);
+			if ((managed != _textures.end()) && (managed->second->texture == &texture))
+				managed->second->failed = true;
+		}
+	}
+
+	delete image;
+	delete txi;
+	delete textureLoad;
+
+	_loadDone.notify_all();
+}
+
+void TextureManager::waitForLoad(Texture &texture) {
+	std::unique_lock<std::mutex> lock(_loadMutex);
+
+	TextureLoadMap::iterator textureLoad = _loads.find(&texture);
+	if (textureLoad == _loads.end())
+		return;
+
+	if (!textureLoad->second->loading) {
+		// Nobody started loading it yet, so we might as well do it ourselves
+		_loadQueue.erase(std::find(_loadQueue.begin(), _loadQueue.end(), textureLoad->second));
+
+		load(textureLoad->second, lock);
+		return;
+	}
+
+	_loadDone.wait(lock, [&]() { return _loads.find(&texture) == _loads.end(); });
+}
+
+void TextureManager::cancelLoad(Texture &texture) {
+	std::lock_guard<std::mutex> lock(_loadMutex);
+
+	TextureLoadMap::iterator textureLoad = _loads.find(&texture);
+	if (textureLoad == _loads.end())
+		return;
+
+	TextureLoad *load = textureLoad->second;
+	_loads.erase(textureLoad);
+
+	// A load in progress is cleaned up by its task
+	load->cancelled = true;
+	if (load->loading)
+		return;
+
+	_loadQueue.erase(std::find(_loadQueue.begin(), _loadQueue.end(), load));
+	delete load;
+}
+
+void TextureManager::cancelLoads() {
+	std::lock_guard<std::mutex> lock(_loadMutex);
+
+	for (TextureLoadMap::iterator l = _loads.begin(); l != _loads.end(); ++l) {
+		l->second->cancelled = true;
+		if (!l->second->loading)
+			delete l->second;
+	}
+
+	_loads.clear();
+	_loadQueue.clear();
+
+	_loadDone.notify_all();
+}
+
 void TextureManager::startRecordNewTextures() {
 	std::lock_guard<std::recursive_mutex> lock(_mutex);
 
@@ -219,6 +495,8 @@ void TextureManager::release(TextureHandle &texture) {
 
 	if (!texture._empty && (texture._it != _textures.end())) {
 		if (--texture._it->second->referenceCount == 0) {
+			cancelLoad(*texture._it->second->texture);
+
 			delete texture._it->second;
 			_textures.erase(texture._it);
 		}
@@ -234,6 +512,10 @@ void TextureManager::reloadAll() {
 	GfxMan.lockFrame();
 
 	for (TextureMap::iterator texture = _textures.begin(); texture != _textures.end(); ++texture) {
+		// Textures still loading are loaded fresh anyway
+		if (!texture->second->texture->isLoaded())
+			continue;
+
 		try {
 			texture->second->texture->reload();
 		} catch (...) {
@@ -245,6 +527,99 @@ void TextureManager::reloadAll() {
 	GfxMan.unlockFrame();
 }
 
+size_t TextureManager::getImageBudget() {
+	std::lock_guard<std::mutex> lock(_residentMutex);
+
+	return _imageBudget;
+}
+
+void TextureManager::setImageBudget(size_t budget) {
+	std::lock_guard<std::mutex> lock(_residentMutex);
+
+	_imageBudget = budget;
+	enforceImageBudget();
+}
+
+size_t TextureManager::getResidentImageSize() {
+	std::lock_guard<std::mutex> lock(_residentMutex);
+
+	return _residentImageSize;
+}
+
+void TextureManager::getTextureMemory(std::vector<TextureMemory> &textures) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	textures.clear();
+	textures.reserve(_textures.size());
+
+	for (TextureMap::const_iterator t = _textures.begin(); t != _textures.end(); ++t) {
+		const Texture &texture = *t->second->texture;
+		if (!texture.isLoaded())
+			continue;
+
+		TextureMemory memory;
+
+		memory.name     = t->first;
+		memory.size     = texture.getDataSize();
+		memory.resident = texture.isImageResident();
+
+		textures.push_back(memory);
+	}
+}
+
+void TextureManager::trackImage(Texture &texture) {
+	std::lock_guard<std::mutex> lock(_residentMutex);
+
+	std::pair<ResidentImageMap::iterator, bool> result =
+		_residentImages.insert(std::make_pair(&texture, texture.getDataSize()));
+
+	if (result.second)
+		_residentImageSize += result.first->second;
+
+	texture._imageTracked.store(true);
+
+	enforceImageBudget();
+}
+
+void TextureManager::untrackImage(const Texture &texture) {
+	std::lock_guard<std::mutex> lock(_residentMutex);
+
+	ResidentImageMap::iterator image = _residentImages.find(const_cast<Texture *>(&texture));
+	if (image != _residentImages.end()) {
+		_residentImageSize -= image->second;
+		_residentImages.erase(image);
+	}
+
+	texture._imageTracked.store(false);
+}
+
+void TextureManager::enforceImageBudget() {
+	if (_residentImageSize <= _imageBudget)
+		return;
+
+	std::vector< std::pair<uint64, Texture *> > images;
+	images.reserve(_residentImages.size());
+
+	for (ResidentImageMap::const_iterator i = _residentImages.begin(); i != _residentImages.end(); ++i)
+		images.push_back(std::make_pair(i->first->_lastUsed.load(std::memory_order_relaxed), i->first));
+
+	std::sort(images.begin(), images.end());
+
+	for (std::vector< std::pair<uint64, Texture *> >::iterator i = images.begin(); i != images.end(); ++i) {
+		if (_residentImageSize <= _imageBudget)
+			break;
+
+		ResidentImageMap::iterator image = _residentImages.find(i->second);
+
+		_residentImageSize -= image->second;
+		_residentImages.erase(image);
+
+		// Only mark it untracked after dropping, or the texture might be deleted in the meantime
+		i->second->evictImage();
+		i->second->_imageTracked.store(false);
+	}
+}
+
 void TextureManager::reset() {
 	for (size_t i = 0; i < kTextureUnitCount; i++) {
 		activeTexture(i);
@@ -279,11 +654,19 @@ void TextureManager::set(const TextureHandle &handle, TextureMode mode) {
 		return;
 	}
 
+	// Placeholders of textures still loading in the background render untextured
+	if (!handle._it->second->texture->isLoaded()) {
+		set();
+		return;
+	}
+
+	handle._it->second->texture->_lastUsed.store(++_useCounter, std::memory_order_relaxed);
+
 	TextureID id = handle._it->second->texture->getID();
 	if (id == 0)
 		warning("Empty texture ID for texture \"%s\"", handle._it->first.c_str());
 
-	if (handle._it->second->texture->getImage().isCubeMap()) {
+	if (handle._it->second->texture->isCubeMap()) {
 		glBindTexture(GL_TEXTURE_CUBE_MAP, id);
 
 		glDisable(GL_TEXTURE_2D);
@@ -297,7 +680,7 @@ void TextureManager::set(const TextureHandle &handle, TextureMode mode) {
 
 	switch (mode) {
 		case kModeEnvironmentMapReflective:
-			if (handle._it->second->texture->getImage().isCubeMap()) {
+			if (handle._it->second->texture->isCubeMap()) {
 				glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP);
 				glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP);
 				glTexGeni(GL_R, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP);
@@ -27,6 +27,8 @@
 
 #include <set>
 #include <list>
+#include <map>
+#include <vector>
 
 #include "src/common/types.h"
 #include "src/common/singleton.h"
@@ -48,6 +50,22 @@ public:
 		kModeEnvironmentMapReflective ///< A reflective environment map.
 	};
 
+	/** The memory used by the image of a managed texture. */
+	struct TextureMemory {
+		Common::UString name;
+		size_t size;   ///< The size of the image data in bytes.
+		bool resident; ///< Is the image data held in memory?
+	};
+
+	/** Keep all images in memory. */
+	static const size_t kImageBudgetUnlimited = SIZE_MAX;
+
+	/** How urgently an asynchronously requested texture is needed. */
+	enum LoadPriority {
+		kLoadPriorityUI,   ///< A texture of a GUI element, loaded before all world textures.
+		kLoadPriorityWorld ///< A texture in the world, loaded by distance to the camera.
+	};
+
 	TextureManager();
 	~TextureManager();
 
@@ -81,6 +99,31 @@ public:
 	/** Retrieve this named texture, returning an empty handle if it's not managed. */
 	TextureHandle getIfExist(const Common::UString &name);
 
+	/** Retrieve this named texture, loading it in the background if it's not yet managed.
+	 *
+	 *  If the texture isn't managed yet, the returned handle points to a placeholder
+	 *  texture without an image, which renders as untextured. The image is read and
+	 *  decoded on the thread pool, and then uploaded by the render thread like any
+	 *  other new texture. Texture::isLoaded() tells when it's done. A texture that
+	 *  fails to load stays untextured, isn't found by hasTexture() and getIfExist(),
+	 *  and is tried again by the next get() or request().
+	 *
+	 *  UI textures are loaded first, world textures closer to the camera before
+	 *  those further away. If all handles to a texture are released before it is
+	 *  loaded, the loading is cancelled.
+	 *
+	 *  A get() on a texture that's still being loaded waits for it to finish, and
+	 *  throws if it fails.
+	 */
+	TextureHandle request(Common::UString name, LoadPriority priority = kLoadPriorityWorld, float distance = 0.0f);
+	/** Change the priority of a texture that's still waiting to be loaded. */
+	void setLoadPriority(const TextureHandle &handle, LoadPriority priority, float distance = 0.0f);
+
+	/** Return the number of textures that are waiting to be loaded or are being loaded. */
+	size_t getPendingLoadCount();
+	/** Wait until all asynchronously requested textures are loaded. */
+	void waitForLoads();
+
 	/** Start recording all names of newly created textures. */
 	void startRecordNewTextures();
 	/** Stop the recording of texture names, and return a list of previously recorded names. */
@@ -90,6 +133,26 @@ public:
 	void reloadAll();
 	// '---
 
+	// .--- Texture memory
+	/** Return the number of bytes of image data kept in memory after the textures have been uploaded. */
+	size_t getImageBudget();
+	/** Set the number of bytes of image data kept in memory after the textures have been uploaded.
+	 *
+	 *  Once a texture is uploaded, the image is only needed again when the texture
+	 *  has to be rebuilt, or if someone explicitly looks at it. If the images of all
+	 *  uploaded textures take more memory than the budget, the images of the textures
+	 *  used least recently are dropped. They are read from the resources again when
+	 *  needed. Textures without a resource to read from are never dropped.
+	 */
+	void setImageBudget(size_t budget);
+
+	/** Return the number of bytes of image data of uploaded textures still held in memory. */
+	size_t getResidentImageSize();
+
+	/** Return the memory used by the images of all managed textures. */
+	void getTextureMemory(std::vector<TextureMemory> &textures);
+	// '---
+
 	// .--- Texture rendering
 	/** Bind this texture to the current texture unit. */
 	void set(const TextureHandle &handle, TextureMode mode = kModeDiffuse);
@@ -113,10 +176,76 @@ private:
 	bool _recordNewTextures;
 	std::list<Common::UString> _newTextureNames;
 
+	/** A texture waiting to be loaded on the thread pool. */
+	struct TextureLoad {
+		Texture *texture;
+
+		LoadPriority priority;
+		float distance;
+		uint64 order; ///< Order of the request, to load equal priorities first come, first served.
+
+		bool loading;   ///< Is it being loaded right now?
+		bool cancelled; ///< Has the texture been deleted in the meantime?
+
+		TextureLoad(Texture *t, LoadPriority p, float d, uint64 o);
+
+		bool operator<(const TextureLoad &right) const;
+	};
+
+	typedef std::map<Texture *, TextureLoad *> TextureLoadMap;
+
+	TextureLoadMap _loads;                  ///< All textures waiting for or being loaded.
+	std::vector<TextureLoad *> _loadQueue;  ///< The textures waiting to be loaded.
+	uint64 _loadOrder;
+
+	size_t _loadTasks; ///< Number of load tasks queued on the thread pool.
+
+	/** Mutex protecting the loads. Always locked after _mutex, never before. */
+	std::mutex _loadMutex;
+	std::condition_variable _loadDone; ///< Signals that a texture or a load task has finished.
+
+	typedef std::map<Texture *, size_t> ResidentImageMap;
+
+	ResidentImageMap _residentImages; ///< Images of uploaded textures that can be dropped, with their sizes.
+	size_t _residentImageSize;
+	size_t _imageBudget;
+
+	uint64 _useCounter; ///< Counts up with every texture set for rendering.
+
+	/** Mutex protecting the resident images. Locked by the render thread, so never lock _mutex with it. */
+	std::mutex _residentMutex;
+
 	void assign(TextureHandle &texture, const TextureHandle &from);
 	void release(TextureHandle &texture);
 
+	/** The image of this texture has been uploaded, and can be dropped if memory runs short. */
+	void trackImage(Texture &texture);
+	/** The image of this texture can't be dropped anymore. */
+	void untrackImage(const Texture &texture);
+	/** Drop the least recently used images until they fit into the budget. _residentMutex has to be locked. */
+	void enforceImageBudget();
+
+	/** Load the most urgent texture in the load queue. Run on the thread pool. */
+	void loadNext();
+
+	/** Queue this placeholder texture to be loaded on the thread pool. */
+	void queueLoad(Texture &texture, LoadPriority priority, float distance);
+	/** Take the most urgent texture out of the load queue. */
+	TextureLoad *popLoad();
+	/** Load the image of a placeholder texture. The _loadMutex has to be locked. */
+	void load(TextureLoad *textureLoad, std::unique_lock<std::mutex> &lock);
+	/** Wait until this texture is not loading anymore, loading it right here if nobody else is.
+	 *
+	 *  A finished load needs _mutex, so it must not be locked while waiting.
+	 */
+	void waitForLoad(Texture &texture);
+	/** Cancel the loading of this texture, because it's going away. */
+	void cancelLoad(Texture &texture);
+	/** Cancel all loads. */
+	void cancelLoads();
+
 	friend class TextureHandle;
+	friend class Texture;
 };
 
 } // End of namespace Aurora
@@ -38,6 +38,7 @@
 #include "src/common/configman.h"
 #include "src/common/debugman.h"
 #include "src/common/threads.h"
+#include "src/common/frustum.h"
 
 #include "src/events/requests.h"
 #include "src/events/events.h"
@@ -781,8 +782,8 @@ void GraphicsManager::recalculateObjectDistances() {
 	// World objects
 	QueueMan.lockQueue(kQueueVisibleWorldObject);
 
-	const std::list<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
-	for (std::list<Queueable *>::const_iterator o = objects.begin(); o != objects.end(); ++o)
+	const std::vector<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
+	for (std::vector<Queueable *>::const_iterator o = objects.begin(); o != objects.end(); ++o)
 		static_cast<Renderable *>(*o)->calculateDistance();
 
 	QueueMan.sortQueue(kQueueVisibleWorldObject);
@@ -791,8 +792,8 @@ void GraphicsManager::recalculateObjectDistances() {
 	// GUI front objects
 	QueueMan.lockQueue(kQueueVisibleGUIFrontObject);
 
-	const std::list<Queueable *> &guiFront = QueueMan.getQueue(kQueueVisibleGUIFrontObject);
-	for (std::list<Queueable *>::const_iterator g = guiFront.begin(); g != guiFront.end(); ++g)
+	const std::vector<Queueable *> &guiFront = QueueMan.getQueue(kQueueVisibleGUIFrontObject);
+	for (std::vector<Queueable *>::const_iterator g = guiFront.begin(); g != guiFront.end(); ++g)
 		static_cast<Renderable *>(*g)->calculateDistance();
 
 	QueueMan.sortQueue(kQueueVisibleGUIFrontObject);
@@ -801,8 +802,8 @@ void GraphicsManager::recalculateObjectDistances() {
 	// GUI back objects
 	QueueMan.lockQueue(kQueueVisibleGUIBackObject);
 
-	const std::list<Queueable *> &guiBack = QueueMan.getQueue(kQueueVisibleGUIBackObject);
-	for (std::list<Queueable *>::const_iterator g = guiBack.begin(); g != guiBack.end(); ++g)
+	const std::vector<Queueable *> &guiBack = QueueMan.getQueue(kQueueVisibleGUIBackObject);
+	for (std::vector<Queueable *>::const_iterator g = guiBack.begin(); g != guiBack.end(); ++g)
 		static_cast<Renderable *>(*g)->calculateDistance();
 
 	QueueMan.sortQueue(kQueueVisibleGUIBackObject);
@@ -872,10 +873,11 @@ Renderable *GraphicsManager::getGUIObjectAt(float x, float y) const {
 	Renderable *object = 0;
 
 	QueueMan.lockQueue(kQueueVisibleGUIFrontObject);
-	const std::list<Queueable *> &gui = QueueMan.getQueue(kQueueVisibleGUIFrontObject);
+	QueueMan.orderQueue(kQueueVisibleGUIFrontObject);
+	const std::vector<Queueable *> &gui = QueueMan.getQueue(kQueueVisibleGUIFrontObject);
 
 	// Go through the GUI elements, from nearest to furthest
-	for (std::list<Queueable *>::const_iterator g = gui.begin(); g != gui.end(); ++g) {
+	for (std::vector<Queueable *>::const_iterator g = gui.begin(); g != gui.end(); ++g) {
 		Renderable &r = static_cast<Renderable &>(**g);
 
 		if (!r.isClickable())
@@ -901,24 +903,13 @@ Renderable *GraphicsManager::getWorldObjectAt(float x, float y) const {
 	if (!unproject(x, y, x1, y1, z1, x2, y2, z2))
 		return 0;
 
-	Renderable *object = 0;
-
 	QueueMan.lockQueue(kQueueVisibleWorldObject);
-	const std::list<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
-
-	for (std::list<Queueable *>::const_iterator o = objects.begin(); o != objects.end(); ++o) {
-		Renderable &r = static_cast<Renderable &>(**o);
+	const std::vector<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
 
-		if (!r.isClickable())
-			// Object isn't clickable, don't check
-			continue;
+	_worldObjects.update(objects, QueueMan.getQueueGeneration(kQueueVisibleWorldObject));
 
-		// If the line intersects with the object, return it
-		if (r.isIn(x1, y1, z1, x2, y2, z2)) {
-			object = &r;
-			break;
-		}
-	}
+	// Find the nearest clickable object the line intersects with
+	Renderable *object = _worldObjects.getObjectAt(x1, y1, z1, x2, y2, z2);
 
 	QueueMan.unlockQueue(kQueueVisibleWorldObject);
 	return object;
@@ -938,11 +929,11 @@ Renderable *GraphicsManager::getObjectAt(float x, float y) {
 
 void GraphicsManager::buildNewTextures() {
 	QueueMan.lockQueue(kQueueNewShader);
-	const std::list<Queueable *> &shadq = QueueMan.getQueue(kQueueNewShader);
+	const std::vector<Queueable *> &shadq = QueueMan.getQueue(kQueueNewShader);
 	if (shadq.empty()) {
 		QueueMan.unlockQueue(kQueueNewShader);
 	} else {
-		for (std::list<Queueable *>::const_iterator t = shadq.begin(); t != shadq.end(); ++t)
+		for (std::vector<Queueable *>::const_iterator t = shadq.begin(); t != shadq.end(); ++t)
 			static_cast<GLContainer *>(*t)->rebuild();
 
 		QueueMan.clearQueue(kQueueNewShader);
@@ -950,13 +941,13 @@ void GraphicsManager::buildNewTextures() {
 	}
 
 	QueueMan.lockQueue(kQueueNewTexture);
-	const std::list<Queueable *> &text = QueueMan.getQueue(kQueueNewTexture);
+	const std::vector<Queueable *> &text = QueueMan.getQueue(kQueueNewTexture);
 	if (text.empty()) {
 		QueueMan.unlockQueue(kQueueNewTexture);
 		return;
 	}
 
-	for (std::list<Queueable *>::const_iterator t = text.begin(); t != text.end(); ++t)
+	for (std::vector<Queueable *>::const_iterator t = text.begin(); t != text.end(); ++t)
 		static_cast<GLContainer *>(*t)->rebuild();
 
 	QueueMan.clearQueue(kQueueNewTexture);
@@ -987,9 +978,9 @@ bool GraphicsManager::playVideo() {
 	glLoadIdentity();
 
 	QueueMan.lockQueue(kQueueVisibleVideo);
-	const std::list<Queueable *> &videos = QueueMan.getQueue(kQueueVisibleVideo);
+	const std::vector<Queueable *> &videos = QueueMan.getQueue(kQueueVisibleVideo);
 
-	for (std::list<Queueable *>::const_iterator v = videos.begin(); v != videos.end(); ++v) {
+	for (std::vector<Queueable *>::const_iterator v = videos.begin(); v != videos.end(); ++v) {
 		glPushMatrix();
 		static_cast<Renderable *>(*v)->render(kRenderPassAll);
 		glPopMatrix();
@@ -1034,27 +1025,38 @@ bool GraphicsManager::renderWorld() {
 	_modelview = glm::translate(_modelview, glm::vec3(-cPos[0], -cPos[1], -cPos[2]));
 
 	QueueMan.lockQueue(kQueueVisibleWorldObject);
-	const std::list<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
+	QueueMan.orderQueue(kQueueVisibleWorldObject);
+	const std::vector<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
 
 	buildNewTextures();
 
 	_animationThread.flush();
 
+	cullWorld(objects);
+
 	// Draw opaque objects
-	for (std::list<Queueable *>::const_reverse_iterator o = objects.rbegin();
+	for (std::vector<Queueable *>::const_reverse_iterator o = objects.rbegin();
 	     o != objects.rend(); ++o) {
 
+		Renderable &r = static_cast<Renderable &>(**o);
+		if (!_worldObjects.isVisible(r))
+			continue;
+
 		glPushMatrix();
-		static_cast<Renderable *>(*o)->render(kRenderPassOpaque);
+		r.render(kRenderPassOpaque);
 		glPopMatrix();
 	}
 
 	// Draw transparent objects
-	for (std::list<Queueable *>::const_reverse_iterator o = objects.rbegin();
+	for (std::vector<Queueable *>::const_reverse_iterator o = objects.rbegin();
 	     o != objects.rend(); ++o) {
 
+		Renderable &r = static_cast<Renderable &>(**o);
+		if (!_worldObjects.isVisible(r))
+			continue;
+
 		glPushMatrix();
-		static_cast<Renderable *>(*o)->render(kRenderPassTransparent);
+		r.render(kRenderPassTransparent);
 		glPopMatrix();
 	}
 
@@ -1062,6 +1064,11 @@ bool GraphicsManager::renderWorld() {
 	return true;
 }
 
+void GraphicsManager::cullWorld(const std::vector<Queueable *> &objects) {
+	_worldObjects.update(objects, QueueMan.getQueueGeneration(kQueueVisibleWorldObject));
+	_worldObjects.cull(Common::Frustum(_projection * _modelview));
+}
+
 bool GraphicsManager::renderGUIFront() {
 	return renderGUI(_scalingType, kQueueVisibleGUIFrontObject, false);
 }
@@ -1098,11 +1105,12 @@ bool GraphicsManager::renderGUI(ScalingType scalingType, QueueType guiQueue, boo
 	glLoadIdentity();
 
 	QueueMan.lockQueue(guiQueue);
-	const std::list<Queueable *> &gui = QueueMan.getQueue(guiQueue);
+	QueueMan.orderQueue(guiQueue);
+	const std::vector<Queueable *> &gui = QueueMan.getQueue(guiQueue);
 
 	buildNewTextures();
 
-	for (std::list<Queueable *>::const_reverse_iterator g = gui.rbegin();
+	for (std::vector<Queueable *>::const_reverse_iterator g = gui.rbegin();
 	     g != gui.rend(); ++g) {
 
 		glPushMatrix();
@@ -1161,17 +1169,23 @@ bool GraphicsManager::renderWorldShader() {
 	_modelview = glm::translate(_modelview, glm::vec3(-cPos[0], -cPos[1], -cPos[2]));
 
 	QueueMan.lockQueue(kQueueVisibleWorldObject);
-	const std::list<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
+	QueueMan.orderQueue(kQueueVisibleWorldObject);
+	const std::vector<Queueable *> &objects = QueueMan.getQueue(kQueueVisibleWorldObject);
 
 	buildNewTextures();
 
 	_animationThread.flush();
 
+	cullWorld(objects);
+
 	glm::mat4 ident;
 	RenderMan.clear();
-	for (std::list<Queueable *>::const_reverse_iterator o = objects.rbegin();
+	for (std::vector<Queueable *>::const_reverse_iterator o = objects.rbegin();
 	     o != objects.rend(); ++o) {
-		static_cast<Renderable *>(*o)->queueRender(ident);
+
+		Renderable &r = static_cast<Renderable &>(**o);
+		if (_worldObjects.isVisible(r))
+			r.queueRender(ident);
 	}
 	RenderMan.sort();
 	RenderMan.render();
@@ -1204,13 +1218,14 @@ bool GraphicsManager::renderGUIShader(ScalingType UNUSED(scalingType), QueueType
 	_projectionInv = _orthoInv;
 
 	QueueMan.lockQueue(guiQueue);
-	const std::list<Queueable *> &gui = QueueMan.getQueue(guiQueue);
+	QueueMan.orderQueue(guiQueue);
+	const std::vector<Queueable *> &gui = QueueMan.getQueue(guiQueue);
 	_modelview = glm::mat4();
 
 	buildNewTextures();
 
 	glm::mat4 ident;
-	for (std::list<Queueable *>::const_reverse_iterator g = gui.rbegin();
+	for (std::vector<Queueable *>::const_reverse_iterator g = gui.rbegin();
 	     g != gui.rend(); ++g) {
 		static_cast<Renderable *>(*g)->renderImmediate(ident);
 	}
@@ -1344,8 +1359,8 @@ bool GraphicsManager::isGL3() const {
 void GraphicsManager::rebuildGLContainers() {
 	QueueMan.lockQueue(kQueueGLContainer);
 
-	const std::list<Queueable *> &cont = QueueMan.getQueue(kQueueGLContainer);
-	for (std::list<Queueable *>::const_iterator c = cont.begin(); c != cont.end(); ++c)
+	const std::vector<Queueable *> &cont = QueueMan.getQueue(kQueueGLContainer);
+	for (std::vector<Queueable *>::const_iterator c = cont.begin(); c != cont.end(); ++c)
 		static_cast<GLContainer *>(*c)->rebuild();
 
 	QueueMan.unlockQueue(kQueueGLContainer);
@@ -1354,8 +1369,8 @@ void GraphicsManager::rebuildGLContainers() {
 void GraphicsManager::destroyGLContainers() {
 	QueueMan.lockQueue(kQueueGLContainer);
 
-	const std::list<Queueable *> &cont = QueueMan.getQueue(kQueueGLContainer);
-	for (std::list<Queueable *>::const_iterator c = cont.begin(); c != cont.end(); ++c)
+	const std::vector<Queueable *> &cont = QueueMan.getQueue(kQueueGLContainer);
+	for (std::vector<Queueable *>::const_iterator c = cont.begin(); c != cont.end(); ++c)
 		static_cast<GLContainer *>(*c)->destroy();
 
 	QueueMan.unlockQueue(kQueueGLContainer);
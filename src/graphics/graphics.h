@@ -39,6 +39,7 @@
 
 #include "src/graphics/types.h"
 #include "src/graphics/windowman.h"
+#include "src/graphics/worldobjecttree.h"
 
 #include "src/graphics/aurora/animationthread.h"
 
@@ -52,6 +53,7 @@ namespace Aurora {
 
 class FPSCounter;
 class Cursor;
+class Queueable;
 class Renderable;
 
 /** The graphics manager. */
@@ -229,6 +231,9 @@ private:
 	glm::mat4 _modelview;      ///< Our base modelview matrix (i.e camera view).
 	glm::mat4 _modelviewInv;   ///< The inverse of our modelview matrix.
 
+	/** Hierarchy over the visible world objects, for culling and picking. */
+	mutable WorldObjectTree _worldObjects;
+
 	std::atomic<uint32> _frameLock;
 	std::atomic<bool>   _frameEndSignal;
 
@@ -273,6 +278,9 @@ private:
 
 	void buildNewTextures();
 
+	/** Bring the world object tree up to date and cull it against the current view. */
+	void cullWorld(const std::vector<Queueable *> &objects);
+
 	void beginScene();
 	bool playVideo();
 	bool renderWorld();
@@ -22,8 +22,18 @@
  *  Manual S3TC DXTn decompression methods.
  */
 
+#include <cstring>
+
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define XOREOS_S3TC_SSE2 1
+	#include <emmintrin.h>
+#endif
+
 #include "src/common/util.h"
+#include "src/common/error.h"
 #include "src/common/readstream.h"
+#include "src/common/threadpool.h"
 
 #include "src/graphics/images/s3tc.h"
 
@@ -216,4 +226,294 @@ void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32 width, u
 	}
 }
 
+/* The in-memory decoders below work on whole blocks read straight out of the
+ * buffer, with integer blends that are bit-exact to interpolate32() and the
+ * DXT5 alpha formulas above. Output row 4 * n + r of an image with complete
+ * blocks always takes texel row r of block row n, so those images are
+ * decoded block row by block row, which also lets us split them into bands.
+ * Everything else takes the generic path that mirrors the stream decoders,
+ * quirks for images narrower or lower than a block included. */
+
+static const size_t kDXT1BlockSize  =  8;
+static const size_t kDXT35BlockSize = 16;
+
+/** Images with fewer pixels than this are not worth splitting across threads. */
+static const uint32 kParallelMinPixels = 256 * 256;
+
+static size_t getDXTBlockSize(PixelFormatRaw format) {
+	switch (format) {
+		case kPixelFormatDXT1:
+			return kDXT1BlockSize;
+
+		case kPixelFormatDXT3:
+		case kPixelFormatDXT5:
+			return kDXT35BlockSize;
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Unknown compressed format %d", format);
+}
+
+static inline byte blendThird(uint32 a, uint32 b) {
+	return (2 * a + b - (b > a)) / 3;
+}
+
+static inline byte blendTwoThirds(uint32 a, uint32 b) {
+	return (a + 2 * b - (b > a)) / 3;
+}
+
+/** Build the four RGBA colors of a block, in memory order. */
+static inline void buildPalette(byte palette[4][4], uint16 color0, uint16 color1, bool dxt1) {
+#ifdef XOREOS_S3TC_SSE2
+	// Lanes 0-3 hold the channels of color 0, lanes 4-7 those of color 1
+	__m128i c = _mm_cvtsi32_si128(color0 | (color1 << 16));
+	c = _mm_unpacklo_epi16(c, c);
+	c = _mm_unpacklo_epi32(c, c);
+
+	const __m128i rg = _mm_mulhi_epu16(_mm_and_si128(c, _mm_setr_epi16((short)0xF800, 0x07E0, 0, 0, (short)0xF800, 0x07E0, 0, 0)),
+	                                   _mm_setr_epi16(256, 8192, 0, 0, 256, 8192, 0, 0));
+	const __m128i b  = _mm_slli_epi16(_mm_and_si128(c, _mm_setr_epi16(0, 0, 0x1F, 0, 0, 0, 0x1F, 0)), 3);
+	const __m128i a  = dxt1 ? _mm_setr_epi16(0, 0, 0, 0xFF, 0, 0, 0, 0xFF) : _mm_setzero_si128();
+
+	const __m128i endpoints = _mm_or_si128(_mm_or_si128(rg, b), a);
+	const __m128i swapped   = _mm_shuffle_epi32(endpoints, _MM_SHUFFLE(1, 0, 3, 2));
+
+	__m128i blended;
+	if (!dxt1 || (color0 > color1)) {
+		// 2 * c0 + c1 in the low, c0 + 2 * c1 in the high half, both less one where c1 > c0
+		__m128i greater = _mm_cmpgt_epi16(swapped, endpoints);
+		greater = _mm_unpacklo_epi64(greater, greater);
+
+		const __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(endpoints, 1), swapped), greater);
+
+		// x / 3 == (x * 0xAAAB) >> 17 for all x we can get here
+		blended = _mm_srli_epi16(_mm_mulhi_epu16(sum, _mm_set1_epi16((short)0xAAAB)), 1);
+	} else {
+		blended = _mm_srli_epi16(_mm_add_epi16(endpoints, swapped), 1);
+		blended = _mm_unpacklo_epi64(blended, _mm_setzero_si128());
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(palette), _mm_packus_epi16(endpoints, blended));
+#else
+	palette[0][0] = (color0 & 0xF800) >> 8;
+	palette[0][1] = (color0 & 0x07E0) >> 3;
+	palette[0][2] = (color0 & 0x001F) << 3;
+	palette[0][3] = dxt1 ? 0xFF : 0x00;
+	palette[1][0] = (color1 & 0xF800) >> 8;
+	palette[1][1] = (color1 & 0x07E0) >> 3;
+	palette[1][2] = (color1 & 0x001F) << 3;
+	palette[1][3] = dxt1 ? 0xFF : 0x00;
+
+	if (!dxt1 || (color0 > color1)) {
+		for (size_t i = 0; i < 4; i++) {
+			palette[2][i] = blendThird    (palette[0][i], palette[1][i]);
+			palette[3][i] = blendTwoThirds(palette[0][i], palette[1][i]);
+		}
+	} else {
+		for (size_t i = 0; i < 4; i++) {
+			palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+			palette[3][i] = 0;
+		}
+	}
+#endif
+}
+
+/** Build the eight alpha values of a DXT5 block. */
+static inline void buildAlphaPalette(byte alpha[8], byte alpha0, byte alpha1) {
+	alpha[0] = alpha0;
+	alpha[1] = alpha1;
+
+	if (alpha0 > alpha1) {
+		for (uint32 i = 1; i < 7; i++)
+			alpha[i + 1] = ((7 - i) * alpha0 + i * alpha1 + 3) / 7;
+	} else {
+		for (uint32 i = 1; i < 5; i++)
+			alpha[i + 1] = ((5 - i) * alpha0 + i * alpha1 + 2) / 5;
+
+		alpha[6] = 0;
+		alpha[7] = 255;
+	}
+}
+
+static inline uint64 readDXT5AlphaBits(const byte *block) {
+	return READ_LE_UINT32(block + 2) | ((uint64)READ_LE_UINT16(block + 6) << 32);
+}
+
+/** Decompress the block rows [rowStart, rowEnd) of an image made of complete blocks. */
+template<PixelFormatRaw kFormat>
+static void decompressBlockRows(byte *dest, const byte *src, uint32 blocksX, uint32 pitch,
+                                uint32 rowStart, uint32 rowEnd) {
+
+	const size_t blockSize = (kFormat == kPixelFormatDXT1) ? kDXT1BlockSize : kDXT35BlockSize;
+
+	for (uint32 by = rowStart; by < rowEnd; by++) {
+		const byte *block = src  + by * blocksX * blockSize;
+		byte       *out   = dest + by * 4 * pitch;
+
+		for (uint32 bx = 0; bx < blocksX; bx++, block += blockSize, out += 16) {
+			const byte *color = block + blockSize - kDXT1BlockSize;
+
+			byte palette[4][4];
+			buildPalette(palette, READ_LE_UINT16(color), READ_LE_UINT16(color + 2), kFormat == kPixelFormatDXT1);
+
+			byte alpha[16];
+			if (kFormat == kPixelFormatDXT3) {
+				for (uint32 y = 0; y < 4; y++) {
+					const uint16 row = READ_LE_UINT16(block + 2 * (3 - y));
+
+					for (uint32 x = 0; x < 4; x++)
+						alpha[4 * y + x] = ((row >> (4 * x)) & 0xF) << 4;
+				}
+			} else if (kFormat == kPixelFormatDXT5) {
+				byte alphaPalette[8];
+				buildAlphaPalette(alphaPalette, block[0], block[1]);
+
+				const uint64 bits = readDXT5AlphaBits(block);
+				for (uint32 i = 0; i < 16; i++)
+					alpha[i] = alphaPalette[(bits >> (3 * i)) & 7];
+			}
+
+			for (uint32 y = 0; y < 4; y++) {
+				byte *pixel = out + y * pitch;
+				const byte indices = color[4 + y];
+
+				for (uint32 x = 0; x < 4; x++, pixel += 4) {
+					std::memcpy(pixel, palette[(indices >> (2 * x)) & 3], 4);
+
+					if (kFormat != kPixelFormatDXT1)
+						pixel[3] = alpha[4 * y + x];
+				}
+			}
+		}
+	}
+}
+
+/** Decompress an image of any size, exactly like the stream decoders do. */
+template<PixelFormatRaw kFormat>
+static void decompressBlocksGeneric(byte *dest, const byte *src, uint32 width, uint32 height, uint32 pitch) {
+	const size_t blockSize = (kFormat == kPixelFormatDXT1) ? kDXT1BlockSize : kDXT35BlockSize;
+
+	const uint32 blockWidth  = MIN<uint32>(width , 4);
+	const uint32 blockHeight = MIN<uint32>(height, 4);
+
+	for (int32 ty = height; ty > 0; ty -= 4) {
+		for (uint32 tx = 0; tx < width; tx += 4, src += blockSize) {
+			const byte *color = src + blockSize - kDXT1BlockSize;
+
+			byte palette[4][4];
+			buildPalette(palette, READ_LE_UINT16(color), READ_LE_UINT16(color + 2), kFormat == kPixelFormatDXT1);
+
+			byte alphaPalette[8];
+			uint64 alphaBits = 0;
+			if (kFormat == kPixelFormatDXT5) {
+				buildAlphaPalette(alphaPalette, src[0], src[1]);
+				alphaBits = readDXT5AlphaBits(src);
+			}
+
+			uint32 cpx = READ_BE_UINT32(color + 4);
+
+			for (uint32 y = 0; y < blockHeight; ++y) {
+				for (uint32 x = 0; x < blockWidth; ++x) {
+					const uint32 destX = tx + x;
+					const uint32 destY = height - 1 - (ty - blockHeight + y);
+
+					const byte *pixel = palette[cpx & 3];
+
+					cpx >>= 2;
+
+					if ((destX >= width) || (destY >= height))
+						continue;
+
+					byte *out = dest + destY * pitch + destX * 4;
+					std::memcpy(out, pixel, 4);
+
+					if      (kFormat == kPixelFormatDXT3)
+						out[3] = ((READ_LE_UINT16(src + 2 * y) >> (x * 4)) & 0xF) << 4;
+					else if (kFormat == kPixelFormatDXT5)
+						out[3] = alphaPalette[(alphaBits >> (3 * (4 * (3 - y) + x))) & 7];
+				}
+			}
+		}
+	}
+}
+
+template<PixelFormatRaw kFormat>
+static void decompressMemory(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch,
+                             size_t maxThreads) {
+
+	const uint32 blocksX = (width  + 3) / 4;
+	const uint32 blocksY = (height + 3) / 4;
+
+	const uint64 needSize = (uint64)blocksX * blocksY * getDXTBlockSize(kFormat);
+	if (needSize > srcSize)
+		throw Common::Exception("DXT data too short (%u < %u)", (uint)srcSize, (uint)needSize);
+
+	if (((width % 4) != 0) || ((height % 4) != 0)) {
+		decompressBlocksGeneric<kFormat>(dest, src, width, height, pitch);
+		return;
+	}
+
+	// Already on the pool, its other threads are busy with work of their own
+	size_t bandCount = 1;
+	if (((uint64)width * height >= kParallelMinPixels) && !ThreadPoolMan.isWorkerThread()) {
+		bandCount = (maxThreads == 0) ? (ThreadPoolMan.getThreadCount() + 1) : maxThreads;
+		bandCount = MIN<size_t>(MAX<size_t>(bandCount, 1), blocksY);
+	}
+
+	if (bandCount <= 1) {
+		decompressBlockRows<kFormat>(dest, src, blocksX, pitch, 0, blocksY);
+		return;
+	}
+
+	// Split the block rows into bands, and decode the first band ourselves
+	Common::TaskGroup bands(ThreadPoolMan);
+	for (size_t i = 1; i < bandCount; i++) {
+		const uint32 rowStart = (uint32)((uint64)blocksY *  i      / bandCount);
+		const uint32 rowEnd   = (uint32)((uint64)blocksY * (i + 1) / bandCount);
+
+		bands.run([=]() {
+			decompressBlockRows<kFormat>(dest, src, blocksX, pitch, rowStart, rowEnd);
+		});
+	}
+
+	decompressBlockRows<kFormat>(dest, src, blocksX, pitch, 0, (uint32)(blocksY / bandCount));
+
+	bands.wait();
+}
+
+void decompressDXT1(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch) {
+	decompressMemory<kPixelFormatDXT1>(dest, src, srcSize, width, height, pitch, 1);
+}
+
+void decompressDXT3(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch) {
+	decompressMemory<kPixelFormatDXT3>(dest, src, srcSize, width, height, pitch, 1);
+}
+
+void decompressDXT5(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch) {
+	decompressMemory<kPixelFormatDXT5>(dest, src, srcSize, width, height, pitch, 1);
+}
+
+void decompressDXT(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch,
+                   PixelFormatRaw format, size_t maxThreads) {
+
+	switch (format) {
+		case kPixelFormatDXT1:
+			decompressMemory<kPixelFormatDXT1>(dest, src, srcSize, width, height, pitch, maxThreads);
+			break;
+
+		case kPixelFormatDXT3:
+			decompressMemory<kPixelFormatDXT3>(dest, src, srcSize, width, height, pitch, maxThreads);
+			break;
+
+		case kPixelFormatDXT5:
+			decompressMemory<kPixelFormatDXT5>(dest, src, srcSize, width, height, pitch, maxThreads);
+			break;
+
+		default:
+			throw Common::Exception("Unknown compressed format %d", format);
+	}
+}
+
 } // End of namespace Graphics
@@ -27,6 +27,8 @@
 
 #include "src/common/types.h"
 
+#include "src/graphics/types.h"
+
 namespace Common {
 	class SeekableReadStream;
 }
@@ -37,6 +39,30 @@ void decompressDXT1(byte *dest, Common::SeekableReadStream &src, uint32 width, u
 void decompressDXT3(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
 void decompressDXT5(byte *dest, Common::SeekableReadStream &src, uint32 width, uint32 height, uint32 pitch);
 
+/** Decompress DXT1 data that's already in memory.
+ *
+ *  Produces exactly the same output as the stream variant, but reads the
+ *  blocks straight out of the buffer. Throws if srcSize is too small to
+ *  hold all blocks of a width x height image.
+ */
+void decompressDXT1(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch);
+/** Decompress DXT3 data that's already in memory. */
+void decompressDXT3(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch);
+/** Decompress DXT5 data that's already in memory. */
+void decompressDXT5(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch);
+
+/** Decompress DXTn data that's already in memory.
+ *
+ *  Large images are split into up to maxThreads bands of block rows, which
+ *  are decompressed in parallel on the global thread pool. 0 means one band
+ *  for each pool thread, plus one for the calling thread.
+ *
+ *  When called from a thread of the pool itself, like a texture loader,
+ *  the image is always decompressed on the calling thread alone.
+ */
+void decompressDXT(byte *dest, const byte *src, size_t srcSize, uint32 width, uint32 height, uint32 pitch,
+                   PixelFormatRaw format, size_t maxThreads = 0);
+
 } // End of namespace Graphics
 
 #endif // GRAPHICS_IMAGES_S3TC_H
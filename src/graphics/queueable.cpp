@@ -30,8 +30,11 @@
 namespace Graphics {
 
 Queueable::Queueable() {
-	for (int i = 0; i < kQueueMAX; i++)
-		_isInQueue[i] = false;
+	for (int i = 0; i < kQueueMAX; i++) {
+		_isInQueue  [i] = false;
+		_queueRef   [i] = 0;
+		_queueSerial[i] = 0;
+	}
 }
 
 Queueable::~Queueable() {
@@ -46,7 +49,7 @@ void Queueable::addToQueue(QueueType queue) {
 	QueueMan.lockQueue(queue);
 
 	if (!_isInQueue[queue]) {
-		_queueRef[queue] = QueueMan.addToQueue(queue, *this);
+		QueueMan.addToQueue(queue, *this);
 		_isInQueue[queue] = true;
 	}
 
@@ -57,7 +60,7 @@ void Queueable::removeFromQueue(QueueType queue) {
 	QueueMan.lockQueue(queue);
 
 	if (_isInQueue[queue]) {
-		QueueMan.removeFromQueue(queue, _queueRef[queue]);
+		QueueMan.removeFromQueue(queue, *this);
 		_isInQueue[queue] = false;
 	}
 
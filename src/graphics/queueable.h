@@ -25,7 +25,7 @@
 #ifndef GRAPHICS_QUEUEABLE_H
 #define GRAPHICS_QUEUEABLE_H
 
-#include <list>
+#include "src/common/types.h"
 
 #include "src/graphics/types.h"
 
@@ -52,7 +52,8 @@ protected:
 
 private:
 	bool _isInQueue[kQueueMAX];
-	std::list<Queueable *>::iterator _queueRef[kQueueMAX];
+	size_t _queueRef[kQueueMAX];    ///< Our position within each queue.
+	uint64 _queueSerial[kQueueMAX]; ///< When we entered each queue, relative to the other objects.
 
 	void removeFromAll();
 	void kickedOut(QueueType queue);
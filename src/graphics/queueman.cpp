@@ -22,6 +22,8 @@
  *  The graphics queue manager.
  */
 
+#include <algorithm>
+
 #include "src/graphics/queueman.h"
 #include "src/graphics/queueable.h"
 
@@ -29,12 +31,30 @@ DECLARE_SINGLETON(Graphics::QueueManager)
 
 namespace Graphics {
 
-static bool queueComp(Queueable *a, Queueable *b) {
-	return *a < *b;
-}
+/** Orders objects within a queue, keeping equal objects in the order they entered it. */
+struct QueueManager::QueueComp {
+	QueueType queue;
+
+	QueueComp(QueueType q) : queue(q) {
+	}
+
+	bool operator()(const Queueable *a, const Queueable *b) const {
+		if (*a < *b)
+			return true;
+		if (*b < *a)
+			return false;
+
+		return a->_queueSerial[queue] < b->_queueSerial[queue];
+	}
+};
 
 
 QueueManager::QueueManager() {
+	for (int i = 0; i < kQueueMAX; i++) {
+		_queueGeneration[i] = 0;
+		_queueSerial    [i] = 0;
+		_queueDisordered[i] = false;
+	}
 }
 
 QueueManager::~QueueManager() {
@@ -55,35 +75,96 @@ bool QueueManager::isQueueEmpty(QueueType queue) {
 	return _queue[queue].empty();
 }
 
-const std::list<Queueable *> &QueueManager::getQueue(QueueType queue) const {
+const std::vector<Queueable *> &QueueManager::getQueue(QueueType queue) const {
 	return _queue[queue];
 }
 
+uint32 QueueManager::getQueueGeneration(QueueType queue) const {
+	return _queueGeneration[queue];
+}
+
 void QueueManager::sortQueue(QueueType queue) {
 	lockQueue(queue);
 
-	_queue[queue].sort(queueComp);
+	std::vector<Queueable *> &objects = _queue[queue];
+	const QueueComp comp(queue);
+
+	/* Insertion sort, which only needs a single pass over a sorted queue.
+	 * Should the queue turn out to be badly out of order, like after the
+	 * camera jumped, give up and fall back to a full sort instead. */
+
+	const size_t maxMoves = 4 * objects.size();
+	size_t moves = 0;
+
+	bool sorted = true;
+	for (size_t i = 1; (i < objects.size()) && sorted; i++) {
+		Queueable *object = objects[i];
+
+		size_t j = i;
+		while ((j > 0) && comp(object, objects[j - 1])) {
+			if (++moves > maxMoves) {
+				sorted = false;
+				break;
+			}
+
+			objects[j] = objects[j - 1];
+			objects[j]->_queueRef[queue] = j;
+			j--;
+		}
+
+		objects[j] = object;
+		object->_queueRef[queue] = j;
+	}
+
+	if (!sorted) {
+		std::sort(objects.begin(), objects.end(), comp);
+
+		for (size_t i = 0; i < objects.size(); i++)
+			objects[i]->_queueRef[queue] = i;
+	}
+
+	_queueDisordered[queue] = false;
+
+	unlockQueue(queue);
+}
+
+void QueueManager::orderQueue(QueueType queue) {
+	lockQueue(queue);
+
+	if (_queueDisordered[queue])
+		sortQueue(queue);
 
 	unlockQueue(queue);
 }
 
-std::list<Queueable *>::iterator QueueManager::addToQueue(QueueType queue, Queueable &q) {
+void QueueManager::addToQueue(QueueType queue, Queueable &q) {
 	lockQueue(queue);
 
+	q._queueRef   [queue] = _queue[queue].size();
+	q._queueSerial[queue] = _queueSerial[queue]++;
+
 	_queue[queue].push_back(&q);
-	std::list<Queueable *>::iterator ref = --_queue[queue].end();
+	_queueGeneration[queue]++;
 
 	unlockQueue(queue);
-
-	return ref;
 }
 
-void QueueManager::removeFromQueue(QueueType queue,
-		const std::list<Queueable *>::iterator &ref) {
-
+void QueueManager::removeFromQueue(QueueType queue, Queueable &q) {
 	lockQueue(queue);
 
-	_queue[queue].erase(ref);
+	std::vector<Queueable *> &objects = _queue[queue];
+	const size_t ref = q._queueRef[queue];
+
+	// Move the last object into the gap
+	if (ref != (objects.size() - 1)) {
+		objects[ref] = objects.back();
+		objects[ref]->_queueRef[queue] = ref;
+
+		_queueDisordered[queue] = true;
+	}
+
+	objects.pop_back();
+	_queueGeneration[queue]++;
 
 	unlockQueue(queue);
 }
@@ -91,11 +172,13 @@ void QueueManager::removeFromQueue(QueueType queue,
 void QueueManager::clearQueue(QueueType queue) {
 	lockQueue(queue);
 
-	for (std::list<Queueable *>::iterator q = _queue[queue].begin();
+	for (std::vector<Queueable *>::iterator q = _queue[queue].begin();
 	     q != _queue[queue].end(); ++q)
 		(*q)->kickedOut(queue);
 
 	_queue[queue].clear();
+	_queueGeneration[queue]++;
+	_queueDisordered[queue] = false;
 
 	unlockQueue(queue);
 }
@@ -25,7 +25,7 @@
 #ifndef GRAPHICS_QUEUEMAN_H
 #define GRAPHICS_QUEUEMAN_H
 
-#include <list>
+#include <vector>
 
 #include "src/common/types.h"
 #include "src/common/singleton.h"
@@ -37,7 +37,16 @@ namespace Graphics {
 
 class Queueable;
 
-/** The graphics queue manager. */
+/** The graphics queue manager.
+ *
+ *  Each queue is a contiguous array of objects. Every object remembers
+ *  its position within the queues it's in, so that it can be added and
+ *  removed in constant time. Removing an object moves the last object
+ *  into its place, though, which disturbs the order of a sorted queue.
+ *  orderQueue() restores that order before the queue is walked.
+ *
+ *  Objects must not enter or leave a queue while it's being iterated over.
+ */
 class QueueManager : public Common::Singleton<QueueManager> {
 public:
 	QueueManager();
@@ -48,19 +57,39 @@ public:
 	void lockQueue(QueueType queue);
 	void unlockQueue(QueueType queue);
 
-	const std::list<Queueable *> &getQueue(QueueType queue) const;
+	const std::vector<Queueable *> &getQueue(QueueType queue) const;
 
+	/** Return a counter that changes whenever objects enter or leave the queue.
+	 *
+	 *  Sorting the queue does not change it. Like getQueue(), this should
+	 *  only be called while the queue is locked.
+	 */
+	uint32 getQueueGeneration(QueueType queue) const;
+
+	/** Sort the queue by the objects' order, falling back to the order they entered the queue.
+	 *
+	 *  The sort is adaptive: when the queue is nearly sorted already, as
+	 *  after objects or the camera moved a bit, it only takes linear time.
+	 */
 	void sortQueue(QueueType queue);
+	/** Sort the queue, if removing objects has disturbed its order since it was last sorted. */
+	void orderQueue(QueueType queue);
+
 	void clearQueue(QueueType queue);
 
 	void clearAllQueues();
 
 private:
+	struct QueueComp;
+
 	std::recursive_mutex _queueMutex[kQueueMAX];
-	std::list<Queueable *> _queue[kQueueMAX];
+	std::vector<Queueable *> _queue[kQueueMAX];
+	uint32 _queueGeneration[kQueueMAX];
+	uint64 _queueSerial[kQueueMAX];     ///< The serial number given to the next object in the queue.
+	bool   _queueDisordered[kQueueMAX]; ///< Were objects removed since the queue was last sorted?
 
-	std::list<Queueable *>::iterator addToQueue(QueueType queue, Queueable &q);
-	void removeFromQueue(QueueType queue, const std::list<Queueable *>::iterator &ref);
+	void addToQueue(QueueType queue, Queueable &q);
+	void removeFromQueue(QueueType queue, Queueable &q);
 
 	friend class Queueable;
 };
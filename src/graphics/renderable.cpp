@@ -30,7 +30,9 @@
 
 namespace Graphics {
 
-Renderable::Renderable(RenderableType type) : _clickable(false), _distance(0.0f) {
+Renderable::Renderable(RenderableType type) : _clickable(false), _distance(0.0f),
+	_boundVersion(0), _cullFrame(0) {
+
 	switch (type) {
 		case kRenderableTypeVideo:
 			_queueExists  = kQueueVideo;
@@ -138,6 +140,18 @@ bool Renderable::isIn(float UNUSED(x1), float UNUSED(y1), float UNUSED(z1),
 	return false;
 }
 
+bool Renderable::getWorldBound(float *UNUSED(min), float *UNUSED(max)) const {
+	return false;
+}
+
+uint32 Renderable::getBoundVersion() const {
+	return _boundVersion;
+}
+
+void Renderable::boundChanged() {
+	_boundVersion++;
+}
+
 void Renderable::lockFrame() {
 	GfxMan.lockFrame();
 }
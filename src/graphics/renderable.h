@@ -25,6 +25,8 @@
 #ifndef GRAPHICS_RENDERABLE_H
 #define GRAPHICS_RENDERABLE_H
 
+#include <atomic>
+
 #include <boost/noncopyable.hpp>
 
 #include "external/glm/mat4x4.hpp"
@@ -89,6 +91,16 @@ public:
 	/** Does the line from x1.y1.z1 to x2.y2.z2 intersect with the object? */
 	virtual bool isIn(float x1, float y1, float z1, float x2, float y2, float z2) const;
 
+	/** Get the axis-aligned box enclosing the object in world space.
+	 *
+	 *  Objects without a world bound are never culled, and always
+	 *  considered when picking.
+	 */
+	virtual bool getWorldBound(float min[3], float max[3]) const;
+
+	/** Get a counter that changes whenever the object's world bound changes. */
+	uint32 getBoundVersion() const;
+
 protected:
 	QueueType _queueExists;
 	QueueType _queueVisible;
@@ -102,11 +114,20 @@ protected:
 
 	void resort();
 
+	/** Notify the world object tree that the world bound has changed. */
+	void boundChanged();
+
 	void lockFrame();
 	void unlockFrame();
 
 	void lockFrameIfVisible();
 	void unlockFrameIfVisible();
+
+private:
+	std::atomic<uint32> _boundVersion; ///< Counter of world bound changes, bumped after the bound is updated.
+	uint32 _cullFrame;    ///< The last world object tree frame the object was found visible in.
+
+	friend class WorldObjectTree;
 };
 
 } // End of namespace Graphics
@@ -43,6 +43,8 @@ src_graphics_libgraphics_la_SOURCES += \
     src/graphics/ttf.h \
     src/graphics/indexbuffer.h \
     src/graphics/vertexbuffer.h \
+    src/graphics/skinning.h \
+    src/graphics/worldobjecttree.h \
     $(EMPTY)
 
 src_graphics_libgraphics_la_SOURCES += \
@@ -62,6 +64,8 @@ src_graphics_libgraphics_la_SOURCES += \
     src/graphics/ttf.cpp \
     src/graphics/indexbuffer.cpp \
     src/graphics/vertexbuffer.cpp \
+    src/graphics/skinning.cpp \
+    src/graphics/worldobjecttree.cpp \
     $(EMPTY)
 
 src_graphics_libgraphics_la_LIBADD = \
@@ -0,0 +1,140 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  CPU vertex skinning.
+ */
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+	#define XOREOS_SKINNING_SSE 1
+	#include <xmmintrin.h>
+#endif
+
+#include "src/graphics/skinning.h"
+
+namespace Graphics {
+
+/** Return the bone matrix a bone index refers to, or 0 if there is none. */
+static inline const glm::mat4 *getBoneMatrix(float boneIndex, const glm::mat4 *boneMatrices, size_t boneCount) {
+	const int index = static_cast<int>(boneIndex);
+	if ((index < 0) || (static_cast<size_t>(index) >= boneCount))
+		return 0;
+
+	return &boneMatrices[index];
+}
+
+void skinVerticesScalar(const float *vertsIn, size_t vertexCount,
+                        const float *boneIndices, const float *boneWeights, size_t bonesPerVertex,
+                        const glm::mat4 *boneMatrices, size_t boneCount,
+                        float *vertsOut, size_t outStride) {
+
+	for (size_t i = 0; i < vertexCount; ++i) {
+		const float x = vertsIn[0];
+		const float y = vertsIn[1];
+		const float z = vertsIn[2];
+
+		float outX = 0.0f, outY = 0.0f, outZ = 0.0f;
+
+		for (size_t j = 0; j < bonesPerVertex; ++j) {
+			const glm::mat4 *m = getBoneMatrix(boneIndices[j], boneMatrices, boneCount);
+			if (!m)
+				continue;
+
+			const float w = boneWeights[j];
+
+			outX += (x * (*m)[0][0] + y * (*m)[1][0] + z * (*m)[2][0] + (*m)[3][0]) * w;
+			outY += (x * (*m)[0][1] + y * (*m)[1][1] + z * (*m)[2][1] + (*m)[3][1]) * w;
+			outZ += (x * (*m)[0][2] + y * (*m)[1][2] + z * (*m)[2][2] + (*m)[3][2]) * w;
+		}
+
+		vertsOut[0] = outX;
+		vertsOut[1] = outY;
+		vertsOut[2] = outZ;
+
+		vertsIn     += 3;
+		boneIndices += bonesPerVertex;
+		boneWeights += bonesPerVertex;
+		vertsOut    += outStride;
+	}
+}
+
+#ifdef XOREOS_SKINNING_SSE
+
+/* With glm's column-major matrices, transforming a point is a weighted sum
+ * of the matrix columns. So we keep the point's coordinates splatted into
+ * full registers and add up whole columns, one bone after the other. */
+static void skinVerticesSSE(const float *vertsIn, size_t vertexCount,
+                            const float *boneIndices, const float *boneWeights, size_t bonesPerVertex,
+                            const glm::mat4 *boneMatrices, size_t boneCount,
+                            float *vertsOut, size_t outStride) {
+
+	for (size_t i = 0; i < vertexCount; ++i) {
+		const __m128 x = _mm_set1_ps(vertsIn[0]);
+		const __m128 y = _mm_set1_ps(vertsIn[1]);
+		const __m128 z = _mm_set1_ps(vertsIn[2]);
+
+		__m128 out = _mm_setzero_ps();
+
+		for (size_t j = 0; j < bonesPerVertex; ++j) {
+			const glm::mat4 *m = getBoneMatrix(boneIndices[j], boneMatrices, boneCount);
+			if (!m)
+				continue;
+
+			const float *c = &(*m)[0][0];
+
+			__m128 v = _mm_loadu_ps(c + 12);
+			v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(c + 0), x));
+			v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(c + 4), y));
+			v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(c + 8), z));
+
+			out = _mm_add_ps(out, _mm_mul_ps(v, _mm_set1_ps(boneWeights[j])));
+		}
+
+		float result[4];
+		_mm_storeu_ps(result, out);
+
+		vertsOut[0] = result[0];
+		vertsOut[1] = result[1];
+		vertsOut[2] = result[2];
+
+		vertsIn     += 3;
+		boneIndices += bonesPerVertex;
+		boneWeights += bonesPerVertex;
+		vertsOut    += outStride;
+	}
+}
+
+#endif // XOREOS_SKINNING_SSE
+
+void skinVertices(const float *vertsIn, size_t vertexCount,
+                  const float *boneIndices, const float *boneWeights, size_t bonesPerVertex,
+                  const glm::mat4 *boneMatrices, size_t boneCount,
+                  float *vertsOut, size_t outStride) {
+
+#ifdef XOREOS_SKINNING_SSE
+	skinVerticesSSE(vertsIn, vertexCount, boneIndices, boneWeights, bonesPerVertex,
+	                boneMatrices, boneCount, vertsOut, outStride);
+#else
+	skinVerticesScalar(vertsIn, vertexCount, boneIndices, boneWeights, bonesPerVertex,
+	                   boneMatrices, boneCount, vertsOut, outStride);
+#endif
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,67 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  CPU vertex skinning.
+ */
+
+#ifndef GRAPHICS_SKINNING_H
+#define GRAPHICS_SKINNING_H
+
+#include "external/glm/mat4x4.hpp"
+
+#include "src/common/types.h"
+
+namespace Graphics {
+
+/** Skin vertex positions by blending them with precomputed bone matrices.
+ *
+ *  Each bone matrix already combines all transformations a vertex undergoes
+ *  when influenced by that bone, for example the inverse base transformation
+ *  times the bone transformation times the base transformation. The bone
+ *  matrices have to be affine, no perspective divide happens.
+ *
+ *  Uses SSE where available, and scalar code otherwise.
+ *
+ *  @param vertsIn        Input vertex positions, 3 floats per vertex.
+ *  @param vertexCount    Number of vertices to skin.
+ *  @param boneIndices    bonesPerVertex indices into boneMatrices for each vertex.
+ *                        Negative or out-of-range indices are ignored.
+ *  @param boneWeights    bonesPerVertex weights for each vertex.
+ *  @param bonesPerVertex Number of bone influences per vertex.
+ *  @param boneMatrices   The combined transformation of each bone.
+ *  @param boneCount      Number of bone matrices.
+ *  @param vertsOut       Receives 3 floats for each skinned vertex position.
+ *  @param outStride      Distance between two output vertices, in floats.
+ */
+void skinVertices(const float *vertsIn, size_t vertexCount,
+                  const float *boneIndices, const float *boneWeights, size_t bonesPerVertex,
+                  const glm::mat4 *boneMatrices, size_t boneCount,
+                  float *vertsOut, size_t outStride);
+
+/** Skin vertex positions like skinVertices(), but always use the scalar code. */
+void skinVerticesScalar(const float *vertsIn, size_t vertexCount,
+                        const float *boneIndices, const float *boneWeights, size_t bonesPerVertex,
+                        const glm::mat4 *boneMatrices, size_t boneCount,
+                        float *vertsOut, size_t outStride);
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_SKINNING_H
@@ -0,0 +1,225 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A bounding volume hierarchy over the visible world objects.
+ */
+
+#include <cfloat>
+#include <algorithm>
+
+#include "src/common/util.h"
+#include "src/common/frustum.h"
+
+#include "src/graphics/worldobjecttree.h"
+#include "src/graphics/renderable.h"
+
+namespace Graphics {
+
+WorldObjectTree::WorldObjectTree() : _built(false), _generation(0), _refitCount(0), _frame(0) {
+}
+
+WorldObjectTree::~WorldObjectTree() {
+}
+
+void WorldObjectTree::clear() {
+	_root.reset();
+
+	_items.clear();
+	_unbounded.clear();
+
+	_built      = false;
+	_refitCount = 0;
+}
+
+void WorldObjectTree::update(const std::vector<Queueable *> &objects, uint32 generation) {
+	if (!_built || (generation != _generation)) {
+		rebuild(objects);
+		_generation = generation;
+		return;
+	}
+
+	for (std::vector<Item>::iterator i = _items.begin(); i != _items.end(); ++i) {
+		const uint32 version = i->object->getBoundVersion();
+		if (version == i->boundVersion)
+			continue;
+
+		i->boundVersion = version;
+
+		const bool bounded = i->object->getWorldBound(i->min, i->max);
+		if (bounded != (i->node != 0)) {
+			// The object gained or lost its bound, the leaves need to be reshuffled
+			rebuild(objects);
+			return;
+		}
+
+		if (bounded) {
+			i->node->refit(i->min, i->max);
+			_refitCount++;
+		}
+	}
+
+	// Refitting keeps the tree correct, but makes it looser and looser as objects move around
+	if (_refitCount > _items.size())
+		rebuild(objects);
+}
+
+size_t WorldObjectTree::getObjectCount() const {
+	return _items.size();
+}
+
+size_t WorldObjectTree::getUnboundedCount() const {
+	return _unbounded.size();
+}
+
+void WorldObjectTree::cull(const Common::Frustum &frustum) {
+	// 0 is the stamp of objects never found visible
+	if (++_frame == 0)
+		_frame = 1;
+
+	_nodes.clear();
+	if (_root)
+		_root->getNodes(frustum, _nodes);
+
+	for (std::vector<Common::AABBNode *>::const_iterator n = _nodes.begin(); n != _nodes.end(); ++n)
+		_items[(*n)->getProperty()].object->_cullFrame = _frame;
+
+	for (std::vector<size_t>::const_iterator u = _unbounded.begin(); u != _unbounded.end(); ++u)
+		_items[*u].object->_cullFrame = _frame;
+}
+
+bool WorldObjectTree::isVisible(const Renderable &object) const {
+	return object._cullFrame == _frame;
+}
+
+Renderable *WorldObjectTree::getObjectAt(float x1, float y1, float z1, float x2, float y2, float z2) {
+	_nodes.clear();
+	if (_root)
+		_root->getNodes(x1, y1, z1, x2, y2, z2, _nodes);
+
+	Renderable *nearest = 0;
+
+	const size_t candidateCount = _nodes.size() + _unbounded.size();
+	for (size_t i = 0; i < candidateCount; i++) {
+		const size_t index = (i < _nodes.size()) ? _nodes[i]->getProperty() : _unbounded[i - _nodes.size()];
+
+		Renderable *object = _items[index].object;
+
+		if (!object->isClickable())
+			// Object isn't clickable, don't check
+			continue;
+
+		if (nearest && (nearest->getDistance() <= object->getDistance()))
+			continue;
+
+		if (object->isIn(x1, y1, z1, x2, y2, z2))
+			nearest = object;
+	}
+
+	return nearest;
+}
+
+void WorldObjectTree::rebuild(const std::vector<Queueable *> &objects) {
+	clear();
+
+	_items.reserve(objects.size());
+
+	std::vector<size_t> bounded;
+	bounded.reserve(objects.size());
+
+	for (std::vector<Queueable *>::const_iterator o = objects.begin(); o != objects.end(); ++o) {
+		Item item;
+
+		item.object       = static_cast<Renderable *>(*o);
+		item.boundVersion = item.object->getBoundVersion();
+		item.node         = 0;
+
+		if (item.object->getWorldBound(item.min, item.max))
+			bounded.push_back(_items.size());
+		else
+			_unbounded.push_back(_items.size());
+
+		_items.push_back(item);
+	}
+
+	if (!bounded.empty())
+		_root.reset(build(&bounded[0], &bounded[0] + bounded.size()));
+
+	_built = true;
+}
+
+Common::AABBNode *WorldObjectTree::build(size_t *begin, size_t *end) {
+	if ((end - begin) == 1) {
+		Item &item = _items[*begin];
+
+		item.node = new Common::AABBNode(item.min, item.max, *begin);
+		return item.node;
+	}
+
+	// Split the objects in half along the axis their centers are spread the widest
+
+	float centerMin[3], centerMax[3];
+	for (int i = 0; i < 3; i++) {
+		centerMin[i] =  FLT_MAX;
+		centerMax[i] = -FLT_MAX;
+	}
+
+	for (size_t *o = begin; o != end; ++o) {
+		const Item &item = _items[*o];
+
+		for (int i = 0; i < 3; i++) {
+			const float center = item.min[i] + item.max[i];
+
+			centerMin[i] = MIN(centerMin[i], center);
+			centerMax[i] = MAX(centerMax[i], center);
+		}
+	}
+
+	int axis = 0;
+	for (int i = 1; i < 3; i++)
+		if ((centerMax[i] - centerMin[i]) > (centerMax[axis] - centerMin[axis]))
+			axis = i;
+
+	size_t *middle = begin + (end - begin) / 2;
+	std::nth_element(begin, middle, end, [&](size_t a, size_t b) {
+		return (_items[a].min[axis] + _items[a].max[axis]) < (_items[b].min[axis] + _items[b].max[axis]);
+	});
+
+	Common::AABBNode *left  = build(begin, middle);
+	Common::AABBNode *right = build(middle, end);
+
+	float leftMin[3], leftMax[3], rightMin[3], rightMax[3], min[3], max[3];
+	left->getMin(leftMin[0], leftMin[1], leftMin[2]);
+	left->getMax(leftMax[0], leftMax[1], leftMax[2]);
+	right->getMin(rightMin[0], rightMin[1], rightMin[2]);
+	right->getMax(rightMax[0], rightMax[1], rightMax[2]);
+
+	for (int i = 0; i < 3; i++) {
+		min[i] = MIN(leftMin[i], rightMin[i]);
+		max[i] = MAX(leftMax[i], rightMax[i]);
+	}
+
+	Common::AABBNode *node = new Common::AABBNode(min, max);
+	node->setChildren(left, right);
+
+	return node;
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,120 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A bounding volume hierarchy over the visible world objects.
+ */
+
+#ifndef GRAPHICS_WORLDOBJECTTREE_H
+#define GRAPHICS_WORLDOBJECTTREE_H
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/scopedptr.h"
+#include "src/common/aabbnode.h"
+
+namespace Common {
+	class Frustum;
+}
+
+namespace Graphics {
+
+class Queueable;
+class Renderable;
+
+/** A bounding volume hierarchy over the visible world objects.
+ *
+ *  The tree holds the world bounds of a list of renderables, so that the
+ *  ones inside the view frustum, or the ones along a picking ray, can be
+ *  found without checking every single object.
+ *
+ *  It is kept in sync with the list by update(): when objects entered or
+ *  left the list, the tree is rebuilt. Otherwise, only the leaves of
+ *  objects whose world bound changed are refitted.
+ *
+ *  Renderables without a world bound are kept apart, and are always
+ *  considered visible and always checked when picking.
+ *
+ *  A renderable can only be part of one tree at a time.
+ */
+class WorldObjectTree : boost::noncopyable {
+public:
+	WorldObjectTree();
+	~WorldObjectTree();
+
+	/** Remove all objects from the tree. */
+	void clear();
+
+	/** Bring the tree up to date with a list of renderables.
+	 *
+	 *  @param objects    The renderables the tree should hold.
+	 *  @param generation A counter that changes whenever the objects list
+	 *                    changes, like QueueManager::getQueueGeneration().
+	 */
+	void update(const std::vector<Queueable *> &objects, uint32 generation);
+
+	/** Return the number of objects in the tree. */
+	size_t getObjectCount() const;
+	/** Return the number of objects without a world bound. */
+	size_t getUnboundedCount() const;
+
+	/** Find all objects at least partially inside a view frustum. */
+	void cull(const Common::Frustum &frustum);
+	/** Was this object found inside the view frustum by the last cull()? */
+	bool isVisible(const Renderable &object) const;
+
+	/** Find the nearest clickable object intersected by the line from x1.y1.z1 to x2.y2.z2. */
+	Renderable *getObjectAt(float x1, float y1, float z1, float x2, float y2, float z2);
+
+private:
+	/** An object in the tree. */
+	struct Item {
+		Renderable *object;   ///< The renderable itself.
+		uint32 boundVersion;  ///< The bound version of the renderable the leaf represents.
+		float min[3];         ///< The world bound of the renderable.
+		float max[3];         ///< The world bound of the renderable.
+
+		Common::AABBNode *node; ///< The leaf node of the object, or 0 if it has no world bound.
+	};
+
+	std::vector<Item> _items;       ///< All objects in the tree.
+	std::vector<size_t> _unbounded; ///< Indices of all objects without a world bound.
+
+	Common::ScopedPtr<Common::AABBNode> _root; ///< The root node of the hierarchy.
+
+	bool   _built;      ///< Was the tree built yet?
+	uint32 _generation; ///< The generation of the objects list the tree was built from.
+	size_t _refitCount; ///< The number of leaves refitted since the tree was built.
+
+	uint32 _frame; ///< Counts the calls to cull(), stamped onto visible objects.
+
+	/** Scratch space for the leaves found by a query. */
+	std::vector<Common::AABBNode *> _nodes;
+
+	void rebuild(const std::vector<Queueable *> &objects);
+	Common::AABBNode *build(size_t *begin, size_t *end);
+};
+
+} // End of namespace Graphics
+
+#endif // GRAPHICS_WORLDOBJECTTREE_H
@@ -86,6 +86,19 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define XOREOS_YUV_SSE2 1
+	#include <emmintrin.h>
+
+	// AVX2 needs the GCC/Clang target attribute and CPU detection
+	#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+		#define XOREOS_YUV_AVX2 1
+		#include <immintrin.h>
+	#endif
+#endif
+
+#include <vector>
+
 #include "src/common/error.h"
 #include "src/common/singleton.h"
 #include "src/common/util.h"
@@ -158,7 +171,7 @@ YUVToRGBLookup::YUVToRGBLookup(YUVToRGBManager::LuminanceScale scale) {
 	}
 }
 
-YUVToRGBManager::YUVToRGBManager() {
+YUVToRGBManager::YUVToRGBManager() : _implementation(kImplementationLookup) {
 	int16 *Cr_r_tab = &_colorTab[0 * 256];
 	int16 *Cr_g_tab = &_colorTab[1 * 256];
 	int16 *Cb_g_tab = &_colorTab[2 * 256];
@@ -176,11 +189,50 @@ YUVToRGBManager::YUVToRGBManager() {
 		Cb_g_tab[i] = (int16) (-(0.114 / 0.331) * CB);
 		Cb_b_tab[i] = (int16) ( (0.587 / 0.331) * CB) + 2 * 768 + 256;
 	}
+
+	if      (hasImplementation(kImplementationAVX2))
+		_implementation = kImplementationAVX2;
+	else if (hasImplementation(kImplementationSSE2))
+		_implementation = kImplementationSSE2;
 }
 
 YUVToRGBManager::~YUVToRGBManager() {
 }
 
+bool YUVToRGBManager::hasImplementation(Implementation implementation) {
+	switch (implementation) {
+		case kImplementationLookup:
+			return true;
+
+		case kImplementationSSE2:
+#ifdef XOREOS_YUV_SSE2
+			return true;
+#else
+			return false;
+#endif
+
+		case kImplementationAVX2:
+#ifdef XOREOS_YUV_AVX2
+			return __builtin_cpu_supports("avx2");
+#else
+			return false;
+#endif
+	}
+
+	return false;
+}
+
+YUVToRGBManager::Implementation YUVToRGBManager::getImplementation() const {
+	return _implementation;
+}
+
+void YUVToRGBManager::setImplementation(Implementation implementation) {
+	if (!hasImplementation(implementation))
+		throw Common::Exception("YUV to RGB implementation %d is not supported", (int) implementation);
+
+	_implementation = implementation;
+}
+
 const YUVToRGBLookup *YUVToRGBManager::getLookup(LuminanceScale scale) {
 	if (_lookup && _lookup->getScale() == scale)
 		return _lookup.get();
@@ -197,6 +249,20 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(LuminanceScale scale) {
 	*((d) + 3) = (a)
 
 void YUVToRGBManager::convert420(LuminanceScale scale, byte *dst, int dstPitch, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	if (_implementation == kImplementationLookup)
+		convert420Lookup(scale, dst, dstPitch, ySrc, uSrc, vSrc, aSrc, yWidth, yHeight, yPitch, uvPitch);
+	else
+		convert420Rows(scale, dst, dstPitch, ySrc, uSrc, vSrc, aSrc, yWidth, yHeight, yPitch, uvPitch);
+}
+
+void YUVToRGBManager::convert420(LuminanceScale scale, byte *dst, int dstPitch, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	if (_implementation == kImplementationLookup)
+		convert420Lookup(scale, dst, dstPitch, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	else
+		convert420Rows(scale, dst, dstPitch, ySrc, uSrc, vSrc, 0, yWidth, yHeight, yPitch, uvPitch);
+}
+
+void YUVToRGBManager::convert420Lookup(LuminanceScale scale, byte *dst, int dstPitch, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	const YUVToRGBLookup *lookup = YUVToRGBMan.getLookup(scale);
 	const byte *rgbToPix = lookup->getRGBToPix();
 
@@ -227,15 +293,15 @@ void YUVToRGBManager::convert420(LuminanceScale scale, byte *dst, int dstPitch,
 			dst += 4;
 		}
 
-		dst -= yWidth * 4 + dstPitch * 2;
-		ySrc += (yPitch << 1) - yWidth;
-		aSrc += (yPitch << 1) - yWidth;
+		dst -= halfWidth * 8 + dstPitch * 2;
+		ySrc += (yPitch << 1) - (halfWidth << 1);
+		aSrc += (yPitch << 1) - (halfWidth << 1);
 		uSrc += uvPitch - halfWidth;
 		vSrc += uvPitch - halfWidth;
 	}
 }
 
-void YUVToRGBManager::convert420(LuminanceScale scale, byte *dst, int dstPitch, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+void YUVToRGBManager::convert420Lookup(LuminanceScale scale, byte *dst, int dstPitch, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	const YUVToRGBLookup *lookup = YUVToRGBMan.getLookup(scale);
 	const byte *rgbToPix = lookup->getRGBToPix();
 
@@ -264,11 +330,271 @@ void YUVToRGBManager::convert420(LuminanceScale scale, byte *dst, int dstPitch,
 			dst += 4;
 		}
 
-		dst -= yWidth * 4 + dstPitch * 2;
-		ySrc += (yPitch << 1) - yWidth;
+		dst -= halfWidth * 8 + dstPitch * 2;
+		ySrc += (yPitch << 1) - (halfWidth << 1);
 		uSrc += uvPitch - halfWidth;
 		vSrc += uvPitch - halfWidth;
 	}
 }
 
+/* The row converters compute what the lookup tables contain: the luma value plus
+ * a chroma offset, clipped to [0, 255] or [16, 235], and then scaled to [0, 255].
+ * The chroma offsets are taken out of the same tables as in the lookup code, so
+ * the output is exactly the same.
+ *
+ * Each converter takes the chroma offsets of every second pixel, and converts
+ * as many pixels of a row as it can, returning the number of chroma values used.
+ */
+
+/** Scale a clipped luminance value in the ITU range to [0, 255]. */
+static inline byte scaleITU(int x) {
+	return ((CLIP(x, 16, 235) - 16) * 255) / 219;
+}
+
+static void convertRowScalar(byte *dst, const byte *ySrc, const byte *aSrc, const int16 *crR, const int16 *crbG,
+                             const int16 *cbB, int start, int halfWidth, bool itu) {
+
+	for (int w = start; w < halfWidth; w++) {
+		for (int i = 0; i < 2; i++) {
+			const int x = 2 * w + i;
+			const int y = ySrc[x];
+
+			if (itu) {
+				dst[4 * x + 0] = scaleITU(y + cbB [w]);
+				dst[4 * x + 1] = scaleITU(y + crbG[w]);
+				dst[4 * x + 2] = scaleITU(y + crR [w]);
+			} else {
+				dst[4 * x + 0] = CLIP(y + cbB [w], 0, 255);
+				dst[4 * x + 1] = CLIP(y + crbG[w], 0, 255);
+				dst[4 * x + 2] = CLIP(y + crR [w], 0, 255);
+			}
+
+			dst[4 * x + 3] = aSrc ? aSrc[x] : 0xFF;
+		}
+	}
+}
+
+#ifdef XOREOS_YUV_SSE2
+
+/** Clip and scale 16-bit luminance values, leaving the final clip to [0, 255] to the byte packing. */
+static inline __m128i scaleSSE2(__m128i x, bool itu) {
+	if (!itu)
+		return x;
+
+	// (x - 16) * 255 / 219 == ((x - 16) * 2 * 38155) >> 16, for x in [16, 235]
+	x = _mm_min_epi16(_mm_max_epi16(x, _mm_set1_epi16(16)), _mm_set1_epi16(235));
+	x = _mm_slli_epi16(_mm_sub_epi16(x, _mm_set1_epi16(16)), 1);
+
+	return _mm_mulhi_epu16(x, _mm_set1_epi16((int16) 38155));
+}
+
+/** Convert 16 luma values plus the 8 chroma offsets belonging to them into one color channel. */
+static inline __m128i channelSSE2(__m128i yLo, __m128i yHi, const int16 *offsets, bool itu) {
+	const __m128i offset = _mm_loadu_si128(reinterpret_cast<const __m128i *>(offsets));
+
+	const __m128i lo = scaleSSE2(_mm_add_epi16(yLo, _mm_unpacklo_epi16(offset, offset)), itu);
+	const __m128i hi = scaleSSE2(_mm_add_epi16(yHi, _mm_unpackhi_epi16(offset, offset)), itu);
+
+	return _mm_packus_epi16(lo, hi);
+}
+
+/** Multiply the absolute chroma values by a table coefficient, rounding down like the table does. */
+static inline __m128i chromaSSE2(__m128i absChroma, __m128i sign, int shift, uint16 multiplier) {
+	const __m128i x = _mm_mulhi_epu16(_mm_slli_epi16(absChroma, shift), _mm_set1_epi16((int16) multiplier));
+
+	return _mm_sub_epi16(_mm_xor_si128(x, sign), sign);
+}
+
+/** Calculate the chroma offsets of a row, 8 at once. */
+static int chromaOffsetsSSE2(int16 *crR, int16 *crbG, int16 *cbB, const byte *uSrc, const byte *vSrc, int halfWidth) {
+	/* The tables hold each (value - 128) multiplied by a coefficient and truncated
+	 * towards zero. The fixed-point multipliers here produce the same value for
+	 * the whole [-128, 127] range. */
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+
+	int w = 0;
+	for (; (w + 8) <= halfWidth; w += 8) {
+		const __m128i cr = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(vSrc + w)), zero), bias);
+		const __m128i cb = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(uSrc + w)), zero), bias);
+
+		const __m128i crSign = _mm_srai_epi16(cr, 15);
+		const __m128i cbSign = _mm_srai_epi16(cb, 15);
+
+		const __m128i crAbs = _mm_sub_epi16(_mm_xor_si128(cr, crSign), crSign);
+		const __m128i cbAbs = _mm_sub_epi16(_mm_xor_si128(cb, cbSign), cbSign);
+
+		const __m128i r =                 chromaSSE2(crAbs, crSign, 1, 45876);  //  (0.419 / 0.299)
+		const __m128i g = _mm_sub_epi16(zero, _mm_add_epi16(
+		                                  chromaSSE2(crAbs, crSign, 0, 46735),  // -(0.299 / 0.419)
+		                                  chromaSSE2(cbAbs, cbSign, 0, 22562))); // -(0.114 / 0.331)
+		const __m128i b =                 chromaSSE2(cbAbs, cbSign, 1, 58109);  //  (0.587 / 0.331)
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(crR  + w), r);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(crbG + w), g);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(cbB  + w), b);
+	}
+
+	return w;
+}
+
+static int convertRowSSE2(byte *dst, const byte *ySrc, const byte *aSrc, const int16 *crR, const int16 *crbG,
+                          const int16 *cbB, int halfWidth, bool itu) {
+
+	const __m128i zero   = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi8((char) 0xFF);
+
+	int w = 0;
+	for (; (w + 8) <= halfWidth; w += 8, ySrc += 16, dst += 64) {
+		const __m128i y   = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ySrc));
+		const __m128i yLo = _mm_unpacklo_epi8(y, zero);
+		const __m128i yHi = _mm_unpackhi_epi8(y, zero);
+
+		const __m128i r = channelSSE2(yLo, yHi, crR  + w, itu);
+		const __m128i g = channelSSE2(yLo, yHi, crbG + w, itu);
+		const __m128i b = channelSSE2(yLo, yHi, cbB  + w, itu);
+		const __m128i a = aSrc ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(aSrc + 2 * w)) : opaque;
+
+		const __m128i bg0 = _mm_unpacklo_epi8(b, g);
+		const __m128i bg1 = _mm_unpackhi_epi8(b, g);
+		const __m128i ra0 = _mm_unpacklo_epi8(r, a);
+		const __m128i ra1 = _mm_unpackhi_epi8(r, a);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst +  0), _mm_unpacklo_epi16(bg0, ra0));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), _mm_unpackhi_epi16(bg0, ra0));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 32), _mm_unpacklo_epi16(bg1, ra1));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 48), _mm_unpackhi_epi16(bg1, ra1));
+	}
+
+	return w;
+}
+
+#endif // XOREOS_YUV_SSE2
+
+#ifdef XOREOS_YUV_AVX2
+
+/* The AVX2 unpack instructions work within each 128-bit half. Unpacking the
+ * 32 luma values and the 16 chroma offsets the same way keeps them matched up,
+ * and packing them back together restores the original order. Only the final
+ * interleaving into BGRA needs the halves swapped around. */
+
+__attribute__((target("avx2")))
+static inline __m256i scaleAVX2(__m256i x, bool itu) {
+	if (!itu)
+		return x;
+
+	x = _mm256_min_epi16(_mm256_max_epi16(x, _mm256_set1_epi16(16)), _mm256_set1_epi16(235));
+	x = _mm256_slli_epi16(_mm256_sub_epi16(x, _mm256_set1_epi16(16)), 1);
+
+	return _mm256_mulhi_epu16(x, _mm256_set1_epi16((int16) 38155));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i channelAVX2(__m256i yLo, __m256i yHi, const int16 *offsets, bool itu) {
+	const __m256i offset = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(offsets));
+
+	const __m256i lo = scaleAVX2(_mm256_add_epi16(yLo, _mm256_unpacklo_epi16(offset, offset)), itu);
+	const __m256i hi = scaleAVX2(_mm256_add_epi16(yHi, _mm256_unpackhi_epi16(offset, offset)), itu);
+
+	return _mm256_packus_epi16(lo, hi);
+}
+
+__attribute__((target("avx2")))
+static int convertRowAVX2(byte *dst, const byte *ySrc, const byte *aSrc, const int16 *crR, const int16 *crbG,
+                          const int16 *cbB, int halfWidth, bool itu) {
+
+	const __m256i zero   = _mm256_setzero_si256();
+	const __m256i opaque = _mm256_set1_epi8((char) 0xFF);
+
+	int w = 0;
+	for (; (w + 16) <= halfWidth; w += 16, ySrc += 32, dst += 128) {
+		const __m256i y   = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ySrc));
+		const __m256i yLo = _mm256_unpacklo_epi8(y, zero);
+		const __m256i yHi = _mm256_unpackhi_epi8(y, zero);
+
+		const __m256i r = channelAVX2(yLo, yHi, crR  + w, itu);
+		const __m256i g = channelAVX2(yLo, yHi, crbG + w, itu);
+		const __m256i b = channelAVX2(yLo, yHi, cbB  + w, itu);
+		const __m256i a = aSrc ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(aSrc + 2 * w)) : opaque;
+
+		const __m256i bg0 = _mm256_unpacklo_epi8(b, g);
+		const __m256i bg1 = _mm256_unpackhi_epi8(b, g);
+		const __m256i ra0 = _mm256_unpacklo_epi8(r, a);
+		const __m256i ra1 = _mm256_unpackhi_epi8(r, a);
+
+		// Pixels 0-3 | 16-19, 4-7 | 20-23, 8-11 | 24-27 and 12-15 | 28-31
+		const __m256i p0 = _mm256_unpacklo_epi16(bg0, ra0);
+		const __m256i p1 = _mm256_unpackhi_epi16(bg0, ra0);
+		const __m256i p2 = _mm256_unpacklo_epi16(bg1, ra1);
+		const __m256i p3 = _mm256_unpackhi_epi16(bg1, ra1);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst +  0), _mm256_permute2x128_si256(p0, p1, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 32), _mm256_permute2x128_si256(p2, p3, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 64), _mm256_permute2x128_si256(p0, p1, 0x31));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 96), _mm256_permute2x128_si256(p2, p3, 0x31));
+	}
+
+	return w;
+}
+
+#endif // XOREOS_YUV_AVX2
+
+void YUVToRGBManager::convert420Rows(LuminanceScale scale, byte *dst, int dstPitch, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	const int halfHeight = yHeight >> 1;
+	const int halfWidth  = yWidth  >> 1;
+
+	const bool itu = scale == kScaleITU;
+
+	// The chroma offsets of the current row, without the offsets into the lookup tables
+	std::vector<int16> offsets(3 * (halfWidth + 1));
+	int16 *crR  = &offsets[0 * (halfWidth + 1)];
+	int16 *crbG = &offsets[1 * (halfWidth + 1)];
+	int16 *cbB  = &offsets[2 * (halfWidth + 1)];
+
+	for (int h = 0; h < halfHeight; h++, uSrc += uvPitch, vSrc += uvPitch) {
+		int w = 0;
+
+#ifdef XOREOS_YUV_SSE2
+		if (_implementation != kImplementationLookup)
+			w = chromaOffsetsSSE2(crR, crbG, cbB, uSrc, vSrc, halfWidth);
+#endif
+
+		for (; w < halfWidth; w++) {
+			crR [w] = _colorTab[vSrc[w] + 0 * 256] - (0 * 768 + 256);
+			crbG[w] = _colorTab[vSrc[w] + 1 * 256] + _colorTab[uSrc[w] + 2 * 256] - (1 * 768 + 256);
+			cbB [w] = _colorTab[uSrc[w] + 3 * 256] - (2 * 768 + 256);
+		}
+
+		// Both luma rows use the same chroma row. The image is stored upside down.
+		for (int i = 0; i < 2; i++) {
+			const int row = 2 * h + i;
+
+			byte       *rowDst = dst  + (yHeight - 1 - row) * dstPitch;
+			const byte *rowY   = ySrc + row * yPitch;
+			const byte *rowA   = aSrc ? (aSrc + row * yPitch) : 0;
+
+			int done = 0;
+			switch (_implementation) {
+#ifdef XOREOS_YUV_AVX2
+				case kImplementationAVX2:
+					done = convertRowAVX2(rowDst, rowY, rowA, crR, crbG, cbB, halfWidth, itu);
+					break;
+#endif
+
+#ifdef XOREOS_YUV_SSE2
+				case kImplementationSSE2:
+					done = convertRowSSE2(rowDst, rowY, rowA, crR, crbG, cbB, halfWidth, itu);
+					break;
+#endif
+
+				default:
+					break;
+			}
+
+			convertRowScalar(rowDst, rowY, rowA, crR, crbG, cbB, done, halfWidth, itu);
+		}
+	}
+}
+
 } // End of namespace Graphics
@@ -42,6 +42,21 @@ public:
 		kScaleITU   /** Luminance values range from [16, 235], the range from ITU-R BT.601 */
 	};
 
+	/** The code used for the conversion. All of them produce the exact same output. */
+	enum Implementation {
+		kImplementationLookup, ///< Per-pixel lookup tables.
+		kImplementationSSE2,   ///< SSE2, 16 pixels at once.
+		kImplementationAVX2    ///< AVX2, 32 pixels at once.
+	};
+
+	/** Is this implementation supported by the compiler and the CPU? */
+	static bool hasImplementation(Implementation implementation);
+
+	/** Return the implementation used for the conversion. By default, the fastest one supported. */
+	Implementation getImplementation() const;
+	/** Force a specific implementation. It has to be supported. */
+	void setImplementation(Implementation implementation);
+
 	/**
 	 * Convert a YUV420 image to an RGBA surface
 	 *
@@ -82,8 +97,18 @@ private:
 
 	const YUVToRGBLookup *getLookup(LuminanceScale scale);
 
+	/** Convert with the lookup tables. */
+	void convert420Lookup(LuminanceScale scale, byte *dst, int dstPitch, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
+	/** Convert with the lookup tables. */
+	void convert420Lookup(LuminanceScale scale, byte *dst, int dstPitch, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
+
+	/** Convert row by row, with the chroma offsets precomputed for each row. aSrc can be 0. */
+	void convert420Rows(LuminanceScale scale, byte *dst, int dstPitch, const byte *ySrc, const byte *uSrc, const byte *vSrc, const byte *aSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
+
 	Common::ScopedPtr<YUVToRGBLookup> _lookup;
 	int16 _colorTab[4 * 256]; // 2048 bytes
+
+	Implementation _implementation;
 };
 
 } // End of namespace Graphics
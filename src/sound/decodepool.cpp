@@ -0,0 +1,298 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Decoding audio streams ahead of playback.
+ */
+
+#include <cassert>
+
+#include "src/common/util.h"
+#include "src/common/strutil.h"
+#include "src/common/error.h"
+#include "src/common/threadpool.h"
+
+#include "src/sound/decodepool.h"
+#include "src/sound/audiostream.h"
+
+namespace Sound {
+
+/** Number of streams to preallocate decode buffers for. */
+static const size_t kPreallocatedStreams = 4;
+
+PCMBuffer::PCMBuffer(size_t s) : data(new int16[s]), size(s), length(0) {
+}
+
+
+class DecodePool::Stream : boost::noncopyable {
+public:
+	AudioStream *audio;
+
+	std::deque<PCMBuffer *> buffers; ///< The decoded buffers, oldest first.
+
+	bool busy;   ///< Is a task currently decoding this stream?
+	bool failed; ///< Did decoding this stream fail?
+
+	Stream(AudioStream &a) : audio(&a), busy(false), failed(false) {
+	}
+};
+
+
+DecodePool::DecodePool(Common::ThreadPool &threads, size_t bufferSize, size_t readAhead, size_t maxTasks,
+                       const ReadyFunction &ready) :
+	_threads(&threads), _bufferSize(bufferSize), _readAhead(readAhead), _ready(ready),
+	_maxTasks(maxTasks), _tasks(0) {
+
+	if ((_bufferSize == 0) || (_readAhead == 0) || (_maxTasks == 0))
+		throw Common::Exception("DecodePool: Invalid parameters (%s, %s, %s)",
+		                        Common::composeString(bufferSize).c_str(),
+		                        Common::composeString(readAhead).c_str(),
+		                        Common::composeString(maxTasks).c_str());
+
+	_buffers.reserve(kPreallocatedStreams * _readAhead);
+	for (size_t i = 0; i < kPreallocatedStreams * _readAhead; i++)
+		_buffers.push_back(new PCMBuffer(_bufferSize));
+
+	_freeBuffers = _buffers;
+}
+
+DecodePool::~DecodePool() {
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		assert(_streams.empty());
+
+		// Without streams, the tasks still queued end right away
+		_streamIdle.wait(lock, [&]() { return _tasks == 0; });
+	}
+
+	for (std::vector<PCMBuffer *>::iterator b = _buffers.begin(); b != _buffers.end(); ++b)
+		delete *b;
+}
+
+DecodePool::Stream *DecodePool::addStream(AudioStream &audio) {
+	Stream *stream = new Stream(audio);
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_streams.push_front(stream);
+	}
+
+	schedule();
+
+	return stream;
+}
+
+void DecodePool::removeStream(Stream *stream) {
+	if (!stream)
+		return;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	_streamIdle.wait(lock, [&]() { return !stream->busy; });
+
+	_streams.remove(stream);
+
+	_freeBuffers.insert(_freeBuffers.end(), stream->buffers.begin(), stream->buffers.end());
+
+	delete stream;
+}
+
+PCMBuffer *DecodePool::getBuffer(Stream &stream) {
+	PCMBuffer *buffer = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (!stream.buffers.empty()) {
+			buffer = stream.buffers.front();
+			stream.buffers.pop_front();
+		}
+	}
+
+	/* The stream now has space for another buffer. Or, if it had none,
+	 * new data might have been added to the audio stream in the meantime. */
+	schedule();
+
+	return buffer;
+}
+
+void DecodePool::releaseBuffer(PCMBuffer *buffer) {
+	if (!buffer)
+		return;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_freeBuffers.push_back(buffer);
+}
+
+bool DecodePool::endOfStream(Stream &stream) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (!stream.buffers.empty())
+		return false;
+
+	if (stream.failed)
+		return true;
+
+	// Only look at the audio stream while no task is decoding it
+	if (stream.busy)
+		return false;
+
+	return stream.audio->endOfStream();
+}
+
+void DecodePool::notify() {
+	schedule();
+}
+
+void DecodePool::wait(Stream &stream) {
+	// Make sure the stream is decoded at all, should it need it
+	schedule();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	_streamIdle.wait(lock, [&]() { return !stream.busy && !needsWork(stream); });
+}
+
+size_t DecodePool::getBufferCount() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _buffers.size();
+}
+
+void DecodePool::schedule() {
+	size_t newTasks = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// One task for each stream waiting to be decoded, as far as allowed
+		for (std::list<Stream *>::iterator s = _streams.begin(); s != _streams.end(); ++s)
+			if (((_tasks + newTasks) < _maxTasks) && !(*s)->busy && needsWork(**s))
+				newTasks++;
+
+		_tasks += newTasks;
+	}
+
+	for (size_t i = 0; i < newTasks; i++)
+		_threads->run([this]() { decodeTask(); });
+}
+
+bool DecodePool::needsWork(Stream &stream) const {
+	if (stream.failed || (stream.buffers.size() >= _readAhead))
+		return false;
+
+	return !stream.audio->endOfData();
+}
+
+DecodePool::Stream *DecodePool::findWork() {
+	for (std::list<Stream *>::iterator s = _streams.begin(); s != _streams.end(); ++s) {
+		Stream &stream = **s;
+
+		if (stream.busy || !needsWork(stream))
+			continue;
+
+		// Let the other streams go first next time
+		_streams.splice(_streams.end(), _streams, s);
+
+		return &stream;
+	}
+
+	return 0;
+}
+
+PCMBuffer *DecodePool::getFreeBuffer() {
+	if (_freeBuffers.empty()) {
+		_buffers.push_back(new PCMBuffer(_bufferSize));
+
+		return _buffers.back();
+	}
+
+	PCMBuffer *buffer = _freeBuffers.back();
+	_freeBuffers.pop_back();
+
+	return buffer;
+}
+
+void DecodePool::decodeTask() {
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	Stream *stream;
+	while ((stream = findWork())) {
+		PCMBuffer *buffer = getFreeBuffer();
+
+		stream->busy = true;
+		lock.unlock();
+
+		const bool success = decode(*stream->audio, *buffer);
+
+		lock.lock();
+		stream->busy = false;
+
+		const bool wasEmpty = stream->buffers.empty();
+
+		if (success && (buffer->length > 0))
+			stream->buffers.push_back(buffer);
+		else
+			_freeBuffers.push_back(buffer);
+
+		if (!success)
+			stream->failed = true;
+
+		const bool ready = wasEmpty && !stream->buffers.empty();
+
+		_streamIdle.notify_all();
+
+		if (ready && _ready) {
+			lock.unlock();
+			_ready();
+			lock.lock();
+		}
+	}
+
+	_tasks--;
+	_streamIdle.notify_all();
+}
+
+bool DecodePool::decode(AudioStream &audio, PCMBuffer &buffer) {
+	buffer.length = 0;
+
+	try {
+		// Only ever read whole sample frames
+		const size_t channels = MAX<int>(audio.getChannels(), 1);
+		const size_t samples  = buffer.size - (buffer.size % channels);
+
+		const size_t length = audio.readBuffer(buffer.data.get(), samples);
+		if (length == AudioStream::kSizeInvalid) {
+			warning("DecodePool::decode(): Failed reading from the audio stream");
+			return false;
+		}
+
+		buffer.length = length;
+
+	} catch (...) {
+		Common::exceptionDispatcherWarning("Failed decoding audio stream");
+		return false;
+	}
+
+	return true;
+}
+
+} // End of namespace Sound
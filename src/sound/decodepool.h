@@ -0,0 +1,152 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Decoding audio streams ahead of playback.
+ */
+
+#ifndef SOUND_DECODEPOOL_H
+#define SOUND_DECODEPOOL_H
+
+#include <list>
+#include <deque>
+#include <vector>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/scopedptr.h"
+#include "src/common/mutex.h"
+
+namespace Common {
+	class ThreadPool;
+}
+
+namespace Sound {
+
+class AudioStream;
+
+/** A buffer of decoded 16-bit PCM samples. */
+struct PCMBuffer : boost::noncopyable {
+	Common::ScopedArray<int16> data; ///< The samples.
+
+	size_t size;   ///< Number of samples the buffer can hold.
+	size_t length; ///< Number of samples decoded into the buffer.
+
+	PCMBuffer(size_t s);
+};
+
+/** Decodes audio streams ahead of playback, on a thread pool.
+ *
+ *  Every stream added to the pool gets its own queue of decoded buffers.
+ *  Decode tasks are queued onto the thread pool when a stream is added and
+ *  when a buffer is taken out. They take turns between the streams, decoding
+ *  one buffer at a time, until each queue holds readAhead buffers, and then
+ *  end. At most maxTasks of them run at the same time. An expensive stream
+ *  therefore never occupies more than one pool thread, and only for one
+ *  buffer at a time.
+ *
+ *  Nothing is checked periodically: a stream that has run out of data and
+ *  gets new data added from outside is decoded further the next time a
+ *  buffer is asked for, or after notify().
+ *
+ *  The buffers are recycled: buffers handed back with releaseBuffer(), and
+ *  the buffers of removed streams, are reused for later decoding.
+ *
+ *  If a stream fails to decode, it is not decoded any further and counts
+ *  as ended.
+ */
+class DecodePool : boost::noncopyable {
+public:
+	/** A stream being decoded ahead by the pool. */
+	class Stream;
+
+	/** Called on a pool thread when a stream without decoded buffers got one. */
+	typedef std::function<void ()> ReadyFunction;
+
+	/** Decode buffers of bufferSize samples, readAhead per stream, in at most maxTasks tasks at once. */
+	DecodePool(Common::ThreadPool &threads, size_t bufferSize, size_t readAhead, size_t maxTasks,
+	           const ReadyFunction &ready = ReadyFunction());
+	/** Wait for the running decode tasks and free all buffers. All streams need to have been removed. */
+	~DecodePool();
+
+	/** Start decoding this audio stream ahead. The audio stream is not taken over. */
+	Stream *addStream(AudioStream &audio);
+	/** Stop decoding this stream and free it, waiting for a task still decoding it. */
+	void removeStream(Stream *stream);
+
+	/** Take out the oldest decoded buffer of this stream, or return 0 if none has been decoded. */
+	PCMBuffer *getBuffer(Stream &stream);
+	/** Hand a buffer taken out by getBuffer() back to the pool. */
+	void releaseBuffer(PCMBuffer *buffer);
+
+	/** Has this stream ended, and all its decoded buffers been taken out? */
+	bool endOfStream(Stream &stream);
+
+	/** Look for streams to decode, because new data might have been added to a stream. */
+	void notify();
+
+	/** Wait until this stream is not being decoded, and either holds readAhead
+	 *  buffers or can't be decoded any further for now. */
+	void wait(Stream &stream);
+
+	/** Return the number of buffers allocated so far. */
+	size_t getBufferCount() const;
+
+private:
+	Common::ThreadPool *_threads;
+
+	size_t _bufferSize;
+	size_t _readAhead;
+
+	ReadyFunction _ready;
+
+	std::list<Stream *> _streams; ///< All streams, in the order they'll be looked at.
+
+	std::vector<PCMBuffer *> _buffers;     ///< All buffers.
+	std::vector<PCMBuffer *> _freeBuffers; ///< Buffers not holding any decoded data.
+
+	size_t _maxTasks; ///< Maximum number of decode tasks running at the same time.
+	size_t _tasks;    ///< Number of decode tasks queued or running.
+
+	mutable std::mutex _mutex;
+	std::condition_variable _streamIdle; ///< Signals that a task finished decoding a buffer, or ended.
+
+	/** Decode buffers until no stream needs decoding anymore. */
+	void decodeTask();
+
+	/** Queue as many decode tasks as are useful and allowed. */
+	void schedule();
+
+	/** Does this stream need another buffer decoded? */
+	bool needsWork(Stream &stream) const;
+	/** Find the next stream that needs decoding, and move it to the back of the list. */
+	Stream *findWork();
+	/** Take a free buffer, or allocate a new one. */
+	PCMBuffer *getFreeBuffer();
+
+	/** Decode one buffer full from the audio stream. Returns false on error. */
+	static bool decode(AudioStream &audio, PCMBuffer &buffer);
+};
+
+} // End of namespace Sound
+
+#endif // SOUND_DECODEPOOL_H
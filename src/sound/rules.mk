@@ -25,6 +25,7 @@ src_sound_libsound_la_SOURCES =
 src_sound_libsound_la_SOURCES += \
     src/sound/types.h \
     src/sound/sound.h \
+    src/sound/decodepool.h \
     src/sound/audiostream.h \
     src/sound/interleaver.h \
     src/sound/xactwavebank.h \
@@ -40,6 +41,7 @@ src_sound_libsound_la_SOURCES += \
 
 src_sound_libsound_la_SOURCES += \
     src/sound/sound.cpp \
+    src/sound/decodepool.cpp \
     src/sound/audiostream.cpp \
     src/sound/interleaver.cpp \
     src/sound/xactwavebank.cpp \
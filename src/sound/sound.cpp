@@ -33,6 +33,7 @@
 #include "src/common/error.h"
 #include "src/common/configman.h"
 #include "src/common/debug.h"
+#include "src/common/threadpool.h"
 
 #include "src/sound/sound.h"
 #include "src/sound/audiostream.h"
@@ -62,12 +63,15 @@ static const size_t kOpenALBufferCount = 5;
  */
 static const size_t kOpenALBufferSize = 32768;
 
+/** Maximum number of pool threads decoding the audio streams ahead of playback at once. */
+static const size_t kDecodeTaskCount = 2;
+
 namespace Sound {
 
 SoundManager::Channel::Channel(uint32 i, size_t idx, SoundType t,
                                const TypeList::iterator &ti, AudioStream *s, bool d) :
-	id(i), index(idx), state(AL_PAUSED), stream(s, d), source(0),
-	type(t), typeIt(ti), finishedBuffers(0), gain(1.0f) {
+	id(i), index(idx), state(AL_PAUSED), stream(s, d), decoder(0), format(0), source(0),
+	type(t), typeIt(ti), finishedBuffers(0), gain(1.0f), underruns(0), starved(false) {
 
 }
 
@@ -109,12 +113,18 @@ void SoundManager::init() {
 		_hasMultiChannel = alIsExtensionPresent("AL_EXT_MCFORMATS") != 0;
 		_format51        = alGetEnumValue("AL_FORMAT_51CHN16");
 
+		// Wake up the sound thread when a channel got new data to queue
+		_decodePool.reset(new DecodePool(ThreadPoolMan, kOpenALBufferSize / 2, kOpenALBufferCount,
+		                                 kDecodeTaskCount, [this]() { _needUpdate.notify_one(); }));
+
 		if (!createThread("SoundManager"))
 			throw Common::Exception("Failed to create sound thread: %s", SDL_GetError());
 
 		_hasSound = true;
 
 	} catch (...) {
+		_decodePool.reset();
+
 		Common::exceptionDispatcherWarning("Failed to initialize OpenAL. Disabling sound output!");
 	}
 
@@ -142,6 +152,8 @@ void SoundManager::deinit() {
 	for (size_t i = 0; i < kChannelCount; i++)
 		freeChannel(i);
 
+	_decodePool.reset();
+
 	if (_hasSound) {
 		alcMakeContextCurrent(0);
 		alcDestroyContext(_ctx);
@@ -203,7 +215,8 @@ bool SoundManager::isPlaying(size_t channel) const {
 		                        formatChannel(_channels[channel].get()).c_str(), error);
 
 	if (val != AL_PLAYING) {
-		if (!_channels[channel]->stream || _channels[channel]->stream->endOfStream()) {
+		const Channel &c = *_channels[channel];
+		if (!c.stream || !c.decoder || _decodePool->endOfStream(*c.decoder)) {
 			ALint buffersQueued;
 			alGetSourcei(_channels[channel]->source, AL_BUFFERS_QUEUED, &buffersQueued);
 			if ((error = alGetError()) != AL_NO_ERROR)
@@ -361,7 +374,7 @@ ChannelHandle SoundManager::playAudioStream(AudioStream *audStream, SoundType ty
 		if ((error = alGetError()) != AL_NO_ERROR)
 			throw Common::Exception("OpenAL error while generating sources: 0x%X", error);
 
-		// Create all needed buffers
+		// Create all needed buffers. The sound thread fills them once the data is decoded
 		for (size_t i = 0; i < kOpenALBufferCount; i++) {
 			ALuint buffer;
 
@@ -369,20 +382,16 @@ ChannelHandle SoundManager::playAudioStream(AudioStream *audStream, SoundType ty
 			if ((error = alGetError()) != AL_NO_ERROR)
 				throw Common::Exception("OpenAL error while generating buffers: 0x%X", error);
 
-			if (fillBuffer(channel, buffer, channel.stream.get(), channel.bufferSize[buffer])) {
-				// If we could fill the buffer with data, queue it
-
-				alSourceQueueBuffers(channel.source, 1, &buffer);
-				if ((error = alGetError()) != AL_NO_ERROR)
-					throw Common::Exception("OpenAL error while queueing buffers: 0x%X", error);
-
-			} else
-				// If not, put it into our free list
-				channel.freeBuffers.push_back(buffer);
-
 			channel.buffers.push_back(buffer);
+			channel.freeBuffers.push_back(buffer);
+			channel.bufferSize[buffer] = 0;
 		}
 
+		// Start decoding, unless we can't play the stream at all
+		channel.format = getFormat(channel);
+		if (channel.format != 0)
+			channel.decoder = _decodePool->addStream(*channel.stream);
+
 		// Set the gain to the current sound type gain
 		alSourcef(channel.source, AL_GAIN, _types[channel.type].gain);
 		// Set the sound per default as relative.
@@ -642,6 +651,16 @@ uint64 SoundManager::getChannelDurationPlayed(const ChannelHandle &handle) {
 	return (getChannelSamplesPlayed(handle) * 1000) / channel->stream->getRate();
 }
 
+uint32 SoundManager::getChannelUnderruns(const ChannelHandle &handle) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	const Channel *channel = getChannel(handle);
+	if (!channel)
+		return 0;
+
+	return channel->underruns;
+}
+
 void SoundManager::setTypeGain(SoundType type, float gain) {
 	assert((type >= 0) && (type < kSoundTypeMAX));
 
@@ -659,56 +678,42 @@ void SoundManager::setTypeGain(SoundType type, float gain) {
 	}
 }
 
-bool SoundManager::fillBuffer(const Channel &channel, ALuint alBuffer,
-                              AudioStream *stream, ALsizei &bufferedSize) const {
-
-	bufferedSize = 0;
-
-	if (!stream)
-		throw Common::Exception("No stream in %s", formatChannel(&channel).c_str());
-
-	if (!_hasSound)
-		return true;
-
-	if (stream->endOfData())
-		return false;
+ALenum SoundManager::getFormat(const Channel &channel) const {
+	const int channelCount = channel.stream->getChannels();
+	if (channelCount == 1)
+		return AL_FORMAT_MONO16;
+	if (channelCount == 2)
+		return AL_FORMAT_STEREO16;
 
-	ALenum format;
-
-	const int channelCount = stream->getChannels();
-	if        (channelCount == 1) {
-		format = AL_FORMAT_MONO16;
-	} else if (channelCount == 2) {
-		format = AL_FORMAT_STEREO16;
-	} else if (channelCount == 6) {
+	if (channelCount == 6) {
 		if (!_hasMultiChannel) {
-			warning("SoundManager::fillBuffer(): TODO: !_hasMultiChannel in %s",
+			warning("SoundManager::getFormat(): TODO: !_hasMultiChannel in %s",
 			        formatChannel(&channel).c_str());
-			return false;
+			return 0;
 		}
 
-		format = _format51;
-
-	} else {
-		warning("SoundManager::fillBuffer(): Unsupported channel count in %s: %d",
-		        formatChannel(&channel).c_str(), channelCount);
-		return false;
+		return _format51;
 	}
 
-	// Read in the required amount of samples
-	size_t numSamples = kOpenALBufferSize / 2;
+	warning("SoundManager::getFormat(): Unsupported channel count in %s: %d",
+	        formatChannel(&channel).c_str(), channelCount);
+	return 0;
+}
 
-	Common::ScopedArray<byte> buffer(new byte[kOpenALBufferSize]);
-	std::memset(buffer.get(), 0, kOpenALBufferSize);
+bool SoundManager::fillBuffer(Channel &channel, ALuint alBuffer, ALsizei &bufferedSize) {
+	bufferedSize = 0;
 
-	numSamples = stream->readBuffer(reinterpret_cast<int16 *>(buffer.get()), numSamples);
-	if (numSamples == AudioStream::kSizeInvalid) {
-		warning("Failed reading from stream while filling buffer in %s", formatChannel(&channel).c_str());
+	if (!channel.decoder)
 		return false;
-	}
 
-	bufferedSize = numSamples * 2;
-	alBufferData(alBuffer, format, buffer.get(), bufferedSize, stream->getRate());
+	PCMBuffer *buffer = _decodePool->getBuffer(*channel.decoder);
+	if (!buffer)
+		return false;
+
+	bufferedSize = buffer->length * 2;
+	alBufferData(alBuffer, channel.format, buffer->data.get(), bufferedSize, channel.stream->getRate());
+
+	_decodePool->releaseBuffer(buffer);
 
 	ALenum error = alGetError();
 	if (error != AL_NO_ERROR) {
@@ -727,7 +732,7 @@ void SoundManager::bufferData(size_t channel) {
 }
 
 void SoundManager::bufferData(Channel &channel) {
-	if (!channel.stream)
+	if (!channel.stream || !channel.decoder)
 		return;
 
 	if (!_hasSound)
@@ -762,10 +767,10 @@ void SoundManager::bufferData(Channel &channel) {
 		channel.finishedBuffers += channel.bufferSize[freeBuffers[i]];
 	}
 
-	// Buffer as long as we still have data and free buffers
+	// Buffer as long as we still have decoded data and free buffers
 	std::list<ALuint>::iterator buffer = channel.freeBuffers.begin();
 	while (buffer != channel.freeBuffers.end()) {
-		if (!fillBuffer(channel, *buffer, channel.stream.get(), channel.bufferSize[*buffer]))
+		if (!fillBuffer(channel, *buffer, channel.bufferSize[*buffer]))
 			break;
 
 		alSourceQueueBuffers(channel.source, 1, &*buffer);
@@ -775,6 +780,22 @@ void SoundManager::bufferData(Channel &channel) {
 
 		buffer = channel.freeBuffers.erase(buffer);
 	}
+
+	/* If the source played all its buffers before the decode pool could
+	 * provide new ones, the channel underran. Only count it once until data
+	 * arrives again, and not before the channel has played anything. */
+	const bool starved = (channel.state == AL_PLAYING) && (channel.finishedBuffers > 0) &&
+	                     (channel.freeBuffers.size() == channel.buffers.size()) &&
+	                     !_decodePool->endOfStream(*channel.decoder);
+
+	if (starved && !channel.starved) {
+		channel.underruns++;
+
+		debugC(Common::kDebugSound, 1, "Sound channel %s ran out of decoded data",
+		       formatChannel(&channel).c_str());
+	}
+
+	channel.starved = starved;
 }
 
 void SoundManager::checkReady() {
@@ -792,14 +813,12 @@ void SoundManager::update() {
 
 		channelCount++;
 
+		// Queue the data decoded so far
+		bufferData(i);
+
 		// Free the channel if it is no longer playing
-		if (!isPlaying(i)) {
+		if (!isPlaying(i))
 			freeChannel(i);
-			continue;
-		}
-
-		// Try to buffer some more data
-		bufferData(i);
 	}
 
 	debugC(Common::kDebugSound, 9, "Active sound channel: %s", Common::composeString(channelCount).c_str());
@@ -877,7 +896,11 @@ void SoundManager::freeChannel(size_t channel) {
 		// Nothing to do
 		return;
 
-	// Discard the stream
+	// Stop decoding, then discard the stream
+	if (_decodePool)
+		_decodePool->removeStream(c->decoder);
+
+	c->decoder = 0;
 	c->stream.reset();
 
 	if (_hasSound) {
@@ -47,6 +47,7 @@
 #include "src/common/mutex.h"
 
 #include "src/sound/types.h"
+#include "src/sound/decodepool.h"
 
 namespace Common {
 	class SeekableReadStream;
@@ -88,6 +89,9 @@ public:
 	uint64 getChannelSamplesPlayed(const ChannelHandle &handle);
 	/** Return the time this channel has already played in milliseconds. */
 	uint64 getChannelDurationPlayed(const ChannelHandle &handle);
+
+	/** Return how often this channel ran out of decoded data while playing. */
+	uint32 getChannelUnderruns(const ChannelHandle &handle);
 	// '---
 
 	// .--- Playing sounds
@@ -207,6 +211,9 @@ private:
 
 		Common::DisposablePtr<AudioStream> stream;  ///< The actual audio stream.
 
+		DecodePool::Stream *decoder; ///< The stream decoding ahead in the decode pool.
+		ALenum format;               ///< The OpenAL format of the decoded data.
+
 		ALuint source; ///< OpenAL source for this channel.
 
 		std::list<ALuint> buffers;     ///< List of buffers for that channel.
@@ -222,6 +229,9 @@ private:
 
 		float gain; ///< The channel's gain.
 
+		uint32 underruns; ///< Number of times the channel ran out of decoded data while playing.
+		bool   starved;   ///< Is the channel currently out of decoded data?
+
 		Channel(uint32 i, size_t idx, SoundType t, const TypeList::iterator &ti, AudioStream *s, bool d);
 	};
 
@@ -243,6 +253,9 @@ private:
 	std::condition_variable_any _needUpdate;
 	std::recursive_mutex _needUpdateMutex;
 
+	/** Decodes the channels' audio streams ahead, for the sound thread to queue. */
+	Common::ScopedPtr<DecodePool> _decodePool;
+
 	ALCdevice *_dev;
 	ALCcontext *_ctx;
 
@@ -280,9 +293,11 @@ private:
 
 	void threadMethod();
 
-	/** Fill the buffer with data from the audio stream. */
-	bool fillBuffer(const Channel &channel, ALuint alBuffer,
-	                AudioStream *stream, ALsizei &bufferedSize) const;
+	/** Find the OpenAL format matching the audio stream of the channel, or return 0 if there is none. */
+	ALenum getFormat(const Channel &channel) const;
+
+	/** Fill the buffer with the next buffer the decode pool decoded for the channel. */
+	bool fillBuffer(Channel &channel, ALuint alBuffer, ALsizei &bufferedSize);
 
 	/** Return a string representing this channel. */
 	Common::UString formatChannel(const Channel *channel) const;
@@ -29,6 +29,7 @@
 #include "src/common/ustring.h"
 #include "src/common/readstream.h"
 #include "src/common/debug.h"
+#include "src/common/configman.h"
 
 #include "src/video/decoder.h"
 #include "src/video/actimagine.h"
@@ -84,6 +85,10 @@ void VideoPlayer::load(const Common::UString &name) {
 		throw Common::Exception("Unsupported video resource type %d", (int) type);
 
 	_video->setScale(VideoDecoder::kScaleUpDown);
+
+	const int decodeAhead = ConfigMan.getInt("videodecodeahead", 0);
+	if (decodeAhead > 0)
+		_video->setDecodeAhead(decodeAhead);
 }
 
 void VideoPlayer::play() {
@@ -82,6 +82,8 @@
 #include "src/common/huffman.h"
 #include "src/common/rdft.h"
 #include "src/common/dct.h"
+#include "src/common/debug.h"
+#include "src/common/threadpool.h"
 
 #include "src/graphics/yuv_to_rgb.h"
 
@@ -93,6 +95,7 @@
 
 #include "src/video/bink.h"
 #include "src/video/binkdata.h"
+#include "src/video/binkdsp.h"
 
 static const uint32 kBIKfID = MKTAG('B', 'I', 'K', 'f');
 static const uint32 kBIKgID = MKTAG('B', 'I', 'K', 'g');
@@ -132,14 +135,6 @@ Bink::BinkVideoTrack::Bundle::Bundle() : countLength(0), dataEnd(0), curDec(0),
 }
 
 
-Bink::VideoFrame::VideoFrame() : bits(0) {
-}
-
-Bink::VideoFrame::~VideoFrame() {
-	delete bits;
-}
-
-
 Bink::AudioInfo::AudioInfo() : bands(0), rdft(0), dct(0) {
 }
 
@@ -158,6 +153,14 @@ Bink::Bink(Common::SeekableReadStream *bink) : _bink(bink), _audioTrack(0) {
 }
 
 Bink::~Bink() {
+	stopDecodeAhead();
+}
+
+void Bink::setParallelPlanes(bool parallel) {
+	TrackPtr track = getTrack(0);
+	assert(track && (track->getTrackType() == Track::kTrackTypeVideo));
+
+	static_cast<BinkVideoTrack &>(*track).setParallelPlanes(parallel);
 }
 
 void Bink::decodeNextTrackFrame(VideoTrack &track) {
@@ -180,18 +183,13 @@ void Bink::decodeNextTrackFrame(VideoTrack &track) {
 		frameSize -= audioPacketLength;
 	}
 
-	size_t videoPacketStart = _bink->pos();
-	size_t videoPacketEnd   = _bink->pos() + frameSize;
-
-	frame.bits =
-		new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink.get(),
-		    videoPacketStart, videoPacketEnd), true);
+	// Read the whole video packet, so that several tasks can decode different planes out of it
+	Common::ScopedArray<byte> videoPacket(new byte[frameSize]);
+	if (_bink->read(videoPacket.get(), frameSize) != frameSize)
+		throw Common::Exception(Common::kReadError);
 
 	assert(_surface);
-	videoTrack.decodePacket(*_surface, frame);
-
-	delete frame.bits;
-	frame.bits = 0;
+	videoTrack.decodePacket(*_surface, videoPacket.get(), frameSize);
 
 	_needCopy = true;
 }
@@ -200,28 +198,55 @@ void Bink::checkAudioBuffer(AudioTrack &track, const Common::Timestamp &endTime)
 	static_cast<BinkAudioTrack &>(track).decodeAudio(*_bink, _frames, _audioTracks, endTime);
 }
 
-void Bink::BinkVideoTrack::decodePacket(Graphics::Surface &surface, VideoFrame &video) {
-	assert(video.bits);
+void Bink::BinkVideoTrack::decodePacket(Graphics::Surface &surface, const byte *data, size_t size) {
+	/* The planes are decoded in groups: alpha, luma and chroma. Each group only
+	 * needs the bits of its own planes and the previous frame's planes, so the
+	 * groups can be decoded in parallel once we know where they start.
+	 * In BIKi videos, the alpha and luma planes are preceded by an offset that
+	 * tells us exactly that. */
+
+	PlaneGroup groups[kPlaneGroupMAX];
+	size_t groupCount = 0;
 
 	if (_hasAlpha) {
-		if (_id == kBIKiID)
-			video.bits->skip(32);
+		PlaneGroup &alpha = groups[groupCount++];
 
-		decodePlane(video, 3, false);
+		alpha.type       = kPlaneGroupAlpha;
+		alpha.planes[0]  = 3;
+		alpha.planeCount = 1;
+		alpha.isChroma   = false;
+		alpha.hasOffset  = _id == kBIKiID;
 	}
 
-	if (_id == kBIKiID)
-		video.bits->skip(32);
+	PlaneGroup &luma = groups[groupCount++];
 
-	for (int i = 0; i < 3; i++) {
-		int planeIdx = ((i == 0) || !_swapPlanes) ? i : (i ^ 3);
+	luma.type       = kPlaneGroupLuma;
+	luma.planes[0]  = 0;
+	luma.planeCount = 1;
+	luma.isChroma   = false;
+	luma.hasOffset  = _id == kBIKiID;
 
-		decodePlane(video, planeIdx, i != 0);
+	PlaneGroup &chroma = groups[groupCount++];
 
-		if (video.bits->pos() >= video.bits->size())
-			break;
+	chroma.type       = kPlaneGroupChroma;
+	chroma.planes[0]  = _swapPlanes ? 2 : 1;
+	chroma.planes[1]  = _swapPlanes ? 1 : 2;
+	chroma.planeCount = 2;
+	chroma.isChroma   = true;
+	chroma.hasOffset  = false;
+
+	for (size_t i = 0; i < groupCount; i++) {
+		groups[i].offset  = 0;
+		groups[i].start   = 0;
+		groups[i].end     = 0;
+		groups[i].decoded = false;
 	}
 
+	if (_parallelPlanes && ((_planeOffsets == kPlaneOffsetsAbsolute) || (_planeOffsets == kPlaneOffsetsRelative)))
+		decodePlaneGroupsParallel(data, size, groups, groupCount);
+	else
+		decodePlaneGroups(data, size, groups, groupCount);
+
 	// Convert the YUVA data we have to BGRA
 	assert(_curPlanes[0] && _curPlanes[1] && _curPlanes[2] && _curPlanes[3]);
 	YUVToRGBMan.convert420(Graphics::YUVToRGBManager::kScaleITU,
@@ -236,7 +261,163 @@ void Bink::BinkVideoTrack::decodePacket(Graphics::Surface &surface, VideoFrame &
 	_curFrame++;
 }
 
-void Bink::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
+void Bink::BinkVideoTrack::decodePlaneGroups(const byte *data, size_t size, PlaneGroup *groups, size_t groupCount) {
+	const size_t sizeBits = (size & ~3) * 8;
+
+	size_t pos = 0;
+	for (size_t i = 0; i < groupCount; i++) {
+		// No more planes in this packet
+		if ((groups[i].type == kPlaneGroupChroma) && (pos >= sizeBits))
+			break;
+
+		groups[i].start = pos;
+		decodePlaneGroup(data, size, groups[i], _bundles[0]);
+
+		checkPlaneOffsets(groups[i]);
+
+		pos = groups[i].end;
+	}
+}
+
+void Bink::BinkVideoTrack::decodePlaneGroupsParallel(const byte *data, size_t size,
+                                                     PlaneGroup *groups, size_t groupCount) {
+
+	const size_t sizeBits = (size & ~3) * 8;
+
+	// Find out where the groups start, as far as we can
+	size_t predictedCount = 1;
+	for (size_t i = 1; i < groupCount; i++, predictedCount++) {
+		if (!predictNextPlaneGroup(data, size, groups[i - 1], groups[i].start))
+			break;
+
+		if ((groups[i].type == kPlaneGroupChroma) && (groups[i].start >= sizeBits))
+			break;
+	}
+
+	// Decode the groups we know the start of on the thread pool, the first one on this thread
+	Common::TaskGroup planeTasks(ThreadPoolMan, Common::ThreadPool::kPriorityHigh);
+	for (size_t i = 1; i < predictedCount; i++) {
+		if (!_bundles[i][0].data)
+			initBundles(_bundles[i]);
+
+		PlaneGroup &group = groups[i];
+		Bundle *bundles = _bundles[i];
+
+		group.decoded = true;
+		planeTasks.run([this, data, size, &group, bundles]() {
+			try {
+				decodePlaneGroup(data, size, group, bundles);
+			} catch (...) {
+				group.error = std::current_exception();
+			}
+		});
+	}
+
+	std::exception_ptr error;
+	try {
+		decodePlaneGroup(data, size, groups[0], _bundles[0]);
+	} catch (...) {
+		error = std::current_exception();
+	}
+
+	planeTasks.wait();
+
+	if (error)
+		std::rethrow_exception(error);
+
+	/* Check that each group really started where the group before it ended.
+	 * If not, or if the group failed to decode, decode it again from the right
+	 * position. A group that failed to decode from the right position fails
+	 * again, and throws this time. */
+	size_t pos = groups[0].end;
+	for (size_t i = 1; i < groupCount; i++) {
+		if ((groups[i].type == kPlaneGroupChroma) && (pos >= sizeBits))
+			break;
+
+		if (groups[i].decoded && (groups[i].start == pos) && !groups[i].error) {
+			pos = groups[i].end;
+			continue;
+		}
+
+		if (groups[i].decoded && (groups[i].start != pos)) {
+			debugC(Common::kDebugVideo, 1, "Bink plane offset mismatch (%u != %u), decoding planes serially",
+			       (uint) groups[i].start, (uint) pos);
+
+			_planeOffsets = kPlaneOffsetsNone;
+		}
+
+		groups[i].start = pos;
+		decodePlaneGroup(data, size, groups[i], _bundles[0]);
+
+		pos = groups[i].end;
+	}
+}
+
+void Bink::BinkVideoTrack::decodePlaneGroup(const byte *data, size_t size, PlaneGroup &group, Bundle *bundles) {
+	Common::MemoryReadStream stream(data, size);
+	Common::BitStream32LELSB bits(stream);
+
+	bits.skip(group.start);
+
+	if (group.hasOffset)
+		group.offset = bits.getBits(32);
+
+	for (size_t i = 0; i < group.planeCount; i++) {
+		if ((i > 0) && (bits.pos() >= bits.size()))
+			break;
+
+		decodePlane(bits, bundles, group.planes[i], group.isChroma);
+	}
+
+	group.end = bits.pos();
+}
+
+void Bink::BinkVideoTrack::checkPlaneOffsets(const PlaneGroup &group) {
+	if (!group.hasOffset || (_planeOffsets == kPlaneOffsetsNone))
+		return;
+
+	const bool absolute = (group.offset * 8) == group.end;
+	const bool relative = (group.start + 32 + group.offset * 8) == group.end;
+
+	// Can't tell the two apart with this group
+	if (absolute && relative)
+		return;
+
+	PlaneOffsets planeOffsets = kPlaneOffsetsNone;
+	if (absolute)
+		planeOffsets = kPlaneOffsetsAbsolute;
+	else if (relative)
+		planeOffsets = kPlaneOffsetsRelative;
+
+	if ((_planeOffsets != kPlaneOffsetsUnknown) && (_planeOffsets != planeOffsets))
+		planeOffsets = kPlaneOffsetsNone;
+
+	if (planeOffsets == kPlaneOffsetsNone)
+		debugC(Common::kDebugVideo, 1, "Bink plane offsets don't point to the next planes");
+
+	_planeOffsets = planeOffsets;
+}
+
+bool Bink::BinkVideoTrack::predictNextPlaneGroup(const byte *data, size_t size,
+                                                 const PlaneGroup &group, size_t &next) const {
+
+	if (!group.hasOffset || ((group.start % 32) != 0) || (((group.start / 8) + 4) > size))
+		return false;
+
+	const uint32 offset = READ_LE_UINT32(data + group.start / 8);
+
+	if      (_planeOffsets == kPlaneOffsetsAbsolute)
+		next = offset * 8;
+	else if (_planeOffsets == kPlaneOffsetsRelative)
+		next = group.start + 32 + offset * 8;
+	else
+		return false;
+
+	// The planes in a group always end on a 32-bit boundary
+	return ((next % 32) == 0) && (next > (group.start + 32)) && (next <= ((size & ~3) * 8));
+}
+
+void Bink::BinkVideoTrack::decodePlane(Common::BitStream &bits, Bundle *bundles, int planeIdx, bool isChroma) {
 	uint32 blockWidth  = isChroma ? ((_width  + 15) >> 4) : ((_width  + 7) >> 3);
 	uint32 blockHeight = isChroma ? ((_height + 15) >> 4) : ((_height + 7) >> 3);
 	uint32 width       = isChroma ?  (_width        >> 1) :   _width;
@@ -244,8 +425,10 @@ void Bink::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isC
 
 	DecodeContext ctx;
 
-	ctx.video     = &video;
-	ctx.planeIdx  = planeIdx;
+	ctx.bits       = &bits;
+	ctx.bundles    = bundles;
+	ctx.colLastVal = 0;
+	ctx.planeIdx   = planeIdx;
 	ctx.destStart = _curPlanes[planeIdx].get();
 	ctx.destEnd   = _curPlanes[planeIdx].get() + width * height;
 	ctx.prevStart = _oldPlanes[planeIdx].get();
@@ -262,27 +445,27 @@ void Bink::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isC
 	}
 
 	for (int i = 0; i < kSourceMAX; i++) {
-		_bundles[i].countLength = _bundles[i].countLengths[isChroma ? 1 : 0];
+		bundles[i].countLength = bundles[i].countLengths[isChroma ? 1 : 0];
 
-		readBundle(video, (Source) i);
+		readBundle(ctx, (Source) i);
 	}
 
 	for (ctx.blockY = 0; ctx.blockY < blockHeight; ctx.blockY++) {
-		readBlockTypes  (video, _bundles[kSourceBlockTypes]);
-		readBlockTypes  (video, _bundles[kSourceSubBlockTypes]);
-		readColors      (video, _bundles[kSourceColors]);
-		readPatterns    (video, _bundles[kSourcePattern]);
-		readMotionValues(video, _bundles[kSourceXOff]);
-		readMotionValues(video, _bundles[kSourceYOff]);
-		readDCS         (video, _bundles[kSourceIntraDC], kDCStartBits, false);
-		readDCS         (video, _bundles[kSourceInterDC], kDCStartBits, true);
-		readRuns        (video, _bundles[kSourceRun]);
+		readBlockTypes  (bits, bundles[kSourceBlockTypes]);
+		readBlockTypes  (bits, bundles[kSourceSubBlockTypes]);
+		readColors      (ctx , bundles[kSourceColors]);
+		readPatterns    (bits, bundles[kSourcePattern]);
+		readMotionValues(bits, bundles[kSourceXOff]);
+		readMotionValues(bits, bundles[kSourceYOff]);
+		readDCS         (bits, bundles[kSourceIntraDC], kDCStartBits, false);
+		readDCS         (bits, bundles[kSourceInterDC], kDCStartBits, true);
+		readRuns        (bits, bundles[kSourceRun]);
 
 		ctx.dest = ctx.destStart + 8 * ctx.blockY * ctx.pitch;
 		ctx.prev = ctx.prevStart + 8 * ctx.blockY * ctx.pitch;
 
 		for (ctx.blockX = 0; ctx.blockX < blockWidth; ctx.blockX++, ctx.dest += 8, ctx.prev += 8) {
-			BlockType blockType = (BlockType) getBundleValue(kSourceBlockTypes);
+			BlockType blockType = (BlockType) getBundleValue(ctx, kSourceBlockTypes);
 
 			// 16x16 block type on odd line means part of the already decoded block, so skip it
 			if ((ctx.blockY & 1) && (blockType == kBlockScaled)) {
@@ -341,28 +524,28 @@ void Bink::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isC
 
 	}
 
-	if (video.bits->pos() & 0x1F) // next plane data starts at 32-bit boundary
-		video.bits->skip(32 - (video.bits->pos() & 0x1F));
+	if (bits.pos() & 0x1F) // next plane data starts at 32-bit boundary
+		bits.skip(32 - (bits.pos() & 0x1F));
 
 }
 
-void Bink::BinkVideoTrack::readBundle(VideoFrame &video, Source source) {
+void Bink::BinkVideoTrack::readBundle(DecodeContext &ctx, Source source) {
 	if (source == kSourceColors) {
 		for (int i = 0; i < 16; i++)
-			readHuffman(video, _colHighHuffman[i]);
+			readHuffman(*ctx.bits, ctx.colHighHuffman[i]);
 
-		_colLastVal = 0;
+		ctx.colLastVal = 0;
 	}
 
 	if ((source != kSourceIntraDC) && (source != kSourceInterDC))
-		readHuffman(video, _bundles[source].huffman);
+		readHuffman(*ctx.bits, ctx.bundles[source].huffman);
 
-	_bundles[source].curDec = _bundles[source].data.get();
-	_bundles[source].curPtr = _bundles[source].data.get();
+	ctx.bundles[source].curDec = ctx.bundles[source].data.get();
+	ctx.bundles[source].curPtr = ctx.bundles[source].data.get();
 }
 
-void Bink::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffman) {
-	huffman.index = video.bits->getBits(4);
+void Bink::BinkVideoTrack::readHuffman(Common::BitStream &bits, Huffman &huffman) {
+	huffman.index = bits.getBits(4);
 
 	if (huffman.index == 0) {
 		// The first tree always gives raw nibbles
@@ -375,14 +558,14 @@ void Bink::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffman) {
 
 	byte hasSymbol[16];
 
-	if (video.bits->getBit()) {
+	if (bits.getBit()) {
 		// Symbol selection
 
 		std::memset(hasSymbol, 0, 16);
 
-		uint8 length = video.bits->getBits(3);
+		uint8 length = bits.getBits(3);
 		for (int i = 0; i <= length; i++) {
-			huffman.symbols[i] = video.bits->getBits(4);
+			huffman.symbols[i] = bits.getBits(4);
 			hasSymbol[huffman.symbols[i]] = 1;
 		}
 
@@ -398,7 +581,7 @@ void Bink::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffman) {
 	byte tmp1[16], tmp2[16];
 	byte *in = tmp1, *out = tmp2;
 
-	uint8 depth = video.bits->getBits(2);
+	uint8 depth = bits.getBits(2);
 
 	for (int i = 0; i < 16; i++)
 		in[i] = i;
@@ -407,7 +590,7 @@ void Bink::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffman) {
 		int size = 1 << i;
 
 		for (int j = 0; j < 16; j += (size << 1))
-			mergeHuffmanSymbols(video, out + j, in + j, size);
+			mergeHuffmanSymbols(bits, out + j, in + j, size);
 
 		SWAP(in, out);
 	}
@@ -415,12 +598,12 @@ void Bink::BinkVideoTrack::readHuffman(VideoFrame &video, Huffman &huffman) {
 	std::memcpy(huffman.symbols, in, 16);
 }
 
-void Bink::BinkVideoTrack::mergeHuffmanSymbols(VideoFrame &video, byte *dst, const byte *src, int size) {
+void Bink::BinkVideoTrack::mergeHuffmanSymbols(Common::BitStream &bits, byte *dst, const byte *src, int size) {
 	const byte *src2  = src + size;
 	int         size2 = size;
 
 	do {
-		if (!video.bits->getBit()) {
+		if (!bits.getBit()) {
 			*dst++ = *src++;
 			size--;
 		} else {
@@ -504,8 +687,6 @@ void Bink::load() {
 
 		if (i != 0)
 			_frames[i - 1].size = _frames[i].offset - _frames[i - 1].offset;
-
-		_frames[i].bits = 0;
 	}
 
 	_frames[frameCount - 1].size = _bink->size() - _frames[frameCount - 1].offset;
@@ -580,14 +761,14 @@ void Bink::initAudioTrack(AudioInfo &audio) {
 		audio.dct  = new Common::DCT(frameLenBits, Common::DCT::DCT_III);
 }
 
-void Bink::BinkVideoTrack::initBundles() {
+void Bink::BinkVideoTrack::initBundles(Bundle *bundles) {
 	uint32 bw     = (_width  + 7) >> 3;
 	uint32 bh     = (_height + 7) >> 3;
 	uint32 blocks = bw * bh;
 
 	for (int i = 0; i < kSourceMAX; i++) {
-		_bundles[i].data.reset(new byte[blocks * 64]);
-		_bundles[i].dataEnd = _bundles[i].data.get() + blocks * 64;
+		bundles[i].data.reset(new byte[blocks * 64]);
+		bundles[i].dataEnd = bundles[i].data.get() + blocks * 64;
 	}
 
 	uint32 cbw[2] = { (_width + 7) >> 3, (_width  + 15) >> 4 };
@@ -597,15 +778,15 @@ void Bink::BinkVideoTrack::initBundles() {
 	for (int i = 0; i < 2; i++) {
 		int width = MAX<uint32>(cw[i], 8);
 
-		_bundles[kSourceBlockTypes   ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceSubBlockTypes].countLengths[i] = Common::intLog2(((width + 7) >> 4) + 511) + 1;
-		_bundles[kSourceColors       ].countLengths[i] = Common::intLog2((cbw[i])     * 64  + 511) + 1;
-		_bundles[kSourceIntraDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceInterDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceXOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourceYOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
-		_bundles[kSourcePattern      ].countLengths[i] = Common::intLog2((cbw[i]      << 3) + 511) + 1;
-		_bundles[kSourceRun          ].countLengths[i] = Common::intLog2((cbw[i])     * 48  + 511) + 1;
+		bundles[kSourceBlockTypes   ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+		bundles[kSourceSubBlockTypes].countLengths[i] = Common::intLog2(((width + 7) >> 4) + 511) + 1;
+		bundles[kSourceColors       ].countLengths[i] = Common::intLog2((cbw[i])     * 64  + 511) + 1;
+		bundles[kSourceIntraDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+		bundles[kSourceInterDC      ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+		bundles[kSourceXOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+		bundles[kSourceYOff         ].countLengths[i] = Common::intLog2((width       >> 3) + 511) + 1;
+		bundles[kSourcePattern      ].countLengths[i] = Common::intLog2((cbw[i]      << 3) + 511) + 1;
+		bundles[kSourceRun          ].countLengths[i] = Common::intLog2((cbw[i])     * 48  + 511) + 1;
 	}
 }
 
@@ -614,29 +795,31 @@ void Bink::BinkVideoTrack::initHuffman() {
 		_huffman[i].reset(new Common::Huffman(binkHuffmanLengths[i][15], 16, binkHuffmanCodes[i], binkHuffmanLengths[i]));
 }
 
-byte Bink::BinkVideoTrack::getHuffmanSymbol(VideoFrame &video, Huffman &huffman) {
-	return huffman.symbols[_huffman[huffman.index]->getSymbol(*video.bits)];
+byte Bink::BinkVideoTrack::getHuffmanSymbol(Common::BitStream &bits, Huffman &huffman) {
+	return huffman.symbols[_huffman[huffman.index]->getSymbol(bits)];
 }
 
-int32 Bink::BinkVideoTrack::getBundleValue(Source source) {
+int32 Bink::BinkVideoTrack::getBundleValue(DecodeContext &ctx, Source source) {
+	Bundle &bundle = ctx.bundles[source];
+
 	if ((source < kSourceXOff) || (source == kSourceRun))
-		return *_bundles[source].curPtr++;
+		return *bundle.curPtr++;
 
 	if ((source == kSourceXOff) || (source == kSourceYOff))
-		return (int8) *_bundles[source].curPtr++;
+		return (int8) *bundle.curPtr++;
 
-	int16 ret = *reinterpret_cast<int16 *>(_bundles[source].curPtr);
+	int16 ret = *reinterpret_cast<int16 *>(bundle.curPtr);
 
-	_bundles[source].curPtr += 2;
+	bundle.curPtr += 2;
 
 	return ret;
 }
 
-uint32 Bink::BinkVideoTrack::readBundleCount(VideoFrame &video, Bundle &bundle) {
+uint32 Bink::BinkVideoTrack::readBundleCount(Common::BitStream &bits, Bundle &bundle) {
 	if (!bundle.curDec || (bundle.curDec > bundle.curPtr))
 		return 0;
 
-	uint32 n = video.bits->getBits(bundle.countLength);
+	uint32 n = bits.getBits(bundle.countLength);
 	if (n == 0)
 		bundle.curDec = 0;
 
@@ -660,19 +843,19 @@ void Bink::BinkVideoTrack::blockScaledSkip(DecodeContext &ctx) {
 }
 
 void Bink::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
-	const uint8 *scan = binkPatterns[ctx.video->bits->getBits(4)];
+	const uint8 *scan = binkPatterns[ctx.bits->getBits(4)];
 
 	int i = 0;
 	do {
-		int run = getBundleValue(kSourceRun) + 1;
+		int run = getBundleValue(ctx, kSourceRun) + 1;
 
 		i += run;
 		if (i > 64)
 			throw Common::Exception("Run went out of bounds");
 
-		if (ctx.video->bits->getBit()) {
+		if (ctx.bits->getBit()) {
 
-			byte v = getBundleValue(kSourceColors);
+			byte v = getBundleValue(ctx, kSourceColors);
 			for (int j = 0; j < run; j++, scan++)
 				ctx.dest[ctx.coordScaledMap1[*scan]] =
 				ctx.dest[ctx.coordScaledMap2[*scan]] =
@@ -684,7 +867,7 @@ void Bink::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
 				ctx.dest[ctx.coordScaledMap1[*scan]] =
 				ctx.dest[ctx.coordScaledMap2[*scan]] =
 				ctx.dest[ctx.coordScaledMap3[*scan]] =
-				ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(kSourceColors);
+				ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(ctx, kSourceColors);
 
 	} while (i < 63);
 
@@ -692,18 +875,18 @@ void Bink::BinkVideoTrack::blockScaledRun(DecodeContext &ctx) {
 		ctx.dest[ctx.coordScaledMap1[*scan]] =
 		ctx.dest[ctx.coordScaledMap2[*scan]] =
 		ctx.dest[ctx.coordScaledMap3[*scan]] =
-		ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(kSourceColors);
+		ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(ctx, kSourceColors);
 }
 
 void Bink::BinkVideoTrack::blockScaledIntra(DecodeContext &ctx) {
 	int16 block[64];
 	std::memset(block, 0, 64 * sizeof(int16));
 
-	block[0] = getBundleValue(kSourceIntraDC);
+	block[0] = getBundleValue(ctx, kSourceIntraDC);
 
-	readDCTCoeffs(*ctx.video, block, true);
+	readDCTCoeffs(*ctx.bits, block, true);
 
-	IDCT(block);
+	binkIDCT(block);
 
 	int16 *src   = block;
 	byte  *dest1 = ctx.dest;
@@ -717,7 +900,7 @@ void Bink::BinkVideoTrack::blockScaledIntra(DecodeContext &ctx) {
 }
 
 void Bink::BinkVideoTrack::blockScaledFill(DecodeContext &ctx) {
-	byte v = getBundleValue(kSourceColors);
+	byte v = getBundleValue(ctx, kSourceColors);
 
 	byte *dest = ctx.dest;
 	for (int i = 0; i < 16; i++, dest += ctx.pitch)
@@ -728,12 +911,12 @@ void Bink::BinkVideoTrack::blockScaledPattern(DecodeContext &ctx) {
 	byte col[2];
 
 	for (int i = 0; i < 2; i++)
-		col[i] = getBundleValue(kSourceColors);
+		col[i] = getBundleValue(ctx, kSourceColors);
 
 	byte *dest1 = ctx.dest;
 	byte *dest2 = ctx.dest + ctx.pitch;
 	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16) {
-		byte v = getBundleValue(kSourcePattern);
+		byte v = getBundleValue(ctx, kSourcePattern);
 
 		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2, v >>= 1)
 			dest1[0] = dest1[1] = dest2[0] = dest2[1] = col[v & 1];
@@ -746,17 +929,17 @@ void Bink::BinkVideoTrack::blockScaledRaw(DecodeContext &ctx) {
 	byte *dest1 = ctx.dest;
 	byte *dest2 = ctx.dest + ctx.pitch;
 	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16) {
-		std::memcpy(row, _bundles[kSourceColors].curPtr, 8);
+		std::memcpy(row, ctx.bundles[kSourceColors].curPtr, 8);
 
 		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2)
 			dest1[0] = dest1[1] = dest2[0] = dest2[1] = row[i];
 
-		_bundles[kSourceColors].curPtr += 8;
+		ctx.bundles[kSourceColors].curPtr += 8;
 	}
 }
 
 void Bink::BinkVideoTrack::blockScaled(DecodeContext &ctx) {
-	BlockType blockType = (BlockType) getBundleValue(kSourceSubBlockTypes);
+	BlockType blockType = (BlockType) getBundleValue(ctx, kSourceSubBlockTypes);
 
 	switch (blockType) {
 		case kBlockRun:
@@ -789,8 +972,8 @@ void Bink::BinkVideoTrack::blockScaled(DecodeContext &ctx) {
 }
 
 void Bink::BinkVideoTrack::blockMotion(DecodeContext &ctx) {
-	int8 xOff = getBundleValue(kSourceXOff);
-	int8 yOff = getBundleValue(kSourceYOff);
+	int8 xOff = getBundleValue(ctx, kSourceXOff);
+	int8 yOff = getBundleValue(ctx, kSourceYOff);
 
 	byte *dest = ctx.dest;
 	byte *prev = ctx.prev + yOff * ((int32) ctx.pitch) + xOff;
@@ -802,62 +985,58 @@ void Bink::BinkVideoTrack::blockMotion(DecodeContext &ctx) {
 }
 
 void Bink::BinkVideoTrack::blockRun(DecodeContext &ctx) {
-	const uint8 *scan = binkPatterns[ctx.video->bits->getBits(4)];
+	const uint8 *scan = binkPatterns[ctx.bits->getBits(4)];
 
 	int i = 0;
 	do {
-		int run = getBundleValue(kSourceRun) + 1;
+		int run = getBundleValue(ctx, kSourceRun) + 1;
 
 		i += run;
 		if (i > 64)
 			throw Common::Exception("Run went out of bounds");
 
-		if (ctx.video->bits->getBit()) {
+		if (ctx.bits->getBit()) {
 
-			byte v = getBundleValue(kSourceColors);
+			byte v = getBundleValue(ctx, kSourceColors);
 			for (int j = 0; j < run; j++)
 				ctx.dest[ctx.coordMap[*scan++]] = v;
 
 		} else
 			for (int j = 0; j < run; j++)
-				ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(kSourceColors);
+				ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(ctx, kSourceColors);
 
 	} while (i < 63);
 
 	if (i == 63)
-		ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(kSourceColors);
+		ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(ctx, kSourceColors);
 }
 
 void Bink::BinkVideoTrack::blockResidue(DecodeContext &ctx) {
 	blockMotion(ctx);
 
-	byte v = ctx.video->bits->getBits(7);
+	byte v = ctx.bits->getBits(7);
 
 	int16 block[64];
 	std::memset(block, 0, 64 * sizeof(int16));
 
-	readResidue(*ctx.video, block, v);
+	readResidue(*ctx.bits, block, v);
 
-	byte  *dst = ctx.dest;
-	int16 *src = block;
-	for (int i = 0; i < 8; i++, dst += ctx.pitch, src += 8)
-		for (int j = 0; j < 8; j++)
-			dst[j] += src[j];
+	binkAddBlock(ctx.dest, ctx.pitch, block);
 }
 
 void Bink::BinkVideoTrack::blockIntra(DecodeContext &ctx) {
 	int16 block[64];
 	std::memset(block, 0, 64 * sizeof(int16));
 
-	block[0] = getBundleValue(kSourceIntraDC);
+	block[0] = getBundleValue(ctx, kSourceIntraDC);
 
-	readDCTCoeffs(*ctx.video, block, true);
+	readDCTCoeffs(*ctx.bits, block, true);
 
-	IDCTPut(ctx, block);
+	binkIDCTPut(ctx.dest, ctx.pitch, block);
 }
 
 void Bink::BinkVideoTrack::blockFill(DecodeContext &ctx) {
-	byte v = getBundleValue(kSourceColors);
+	byte v = getBundleValue(ctx, kSourceColors);
 
 	byte *dest = ctx.dest;
 	for (int i = 0; i < 8; i++, dest += ctx.pitch)
@@ -870,22 +1049,22 @@ void Bink::BinkVideoTrack::blockInter(DecodeContext &ctx) {
 	int16 block[64];
 	std::memset(block, 0, 64 * sizeof(int16));
 
-	block[0] = getBundleValue(kSourceInterDC);
+	block[0] = getBundleValue(ctx, kSourceInterDC);
 
-	readDCTCoeffs(*ctx.video, block, false);
+	readDCTCoeffs(*ctx.bits, block, false);
 
-	IDCTAdd(ctx, block);
+	binkIDCTAdd(ctx.dest, ctx.pitch, block);
 }
 
 void Bink::BinkVideoTrack::blockPattern(DecodeContext &ctx) {
 	byte col[2];
 
 	for (int i = 0; i < 2; i++)
-		col[i] = getBundleValue(kSourceColors);
+		col[i] = getBundleValue(ctx, kSourceColors);
 
 	byte *dest = ctx.dest;
 	for (int i = 0; i < 8; i++, dest += ctx.pitch - 8) {
-		byte v = getBundleValue(kSourcePattern);
+		byte v = getBundleValue(ctx, kSourcePattern);
 
 		for (int j = 0; j < 8; j++, v >>= 1)
 			*dest++ = col[v & 1];
@@ -894,15 +1073,15 @@ void Bink::BinkVideoTrack::blockPattern(DecodeContext &ctx) {
 
 void Bink::BinkVideoTrack::blockRaw(DecodeContext &ctx) {
 	byte *dest = ctx.dest;
-	byte *data = _bundles[kSourceColors].curPtr;
+	byte *data = ctx.bundles[kSourceColors].curPtr;
 	for (int i = 0; i < 8; i++, dest += ctx.pitch, data += 8)
 		std::memcpy(dest, data, 8);
 
-	_bundles[kSourceColors].curPtr += 64;
+	ctx.bundles[kSourceColors].curPtr += 64;
 }
 
-void Bink::BinkVideoTrack::readRuns(VideoFrame &video, Bundle &bundle) {
-	uint32 n = readBundleCount(video, bundle);
+void Bink::BinkVideoTrack::readRuns(Common::BitStream &bits, Bundle &bundle) {
+	uint32 n = readBundleCount(bits, bundle);
 	if (n == 0)
 		return;
 
@@ -910,19 +1089,19 @@ void Bink::BinkVideoTrack::readRuns(VideoFrame &video, Bundle &bundle) {
 	if (decEnd > bundle.dataEnd)
 		throw Common::Exception("Run value went out of bounds");
 
-	if (video.bits->getBit()) {
-		byte v = video.bits->getBits(4);
+	if (bits.getBit()) {
+		byte v = bits.getBits(4);
 
 		std::memset(bundle.curDec, v, n);
 		bundle.curDec += n;
 
 	} else
 		while (bundle.curDec < decEnd)
-			*bundle.curDec++ = getHuffmanSymbol(video, bundle.huffman);
+			*bundle.curDec++ = getHuffmanSymbol(bits, bundle.huffman);
 }
 
-void Bink::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bundle) {
-	uint32 n = readBundleCount(video, bundle);
+void Bink::BinkVideoTrack::readMotionValues(Common::BitStream &bits, Bundle &bundle) {
+	uint32 n = readBundleCount(bits, bundle);
 	if (n == 0)
 		return;
 
@@ -930,11 +1109,11 @@ void Bink::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bundle) {
 	if (decEnd > bundle.dataEnd)
 		throw Common::Exception("Too many motion values");
 
-	if (video.bits->getBit()) {
-		byte v = video.bits->getBits(4);
+	if (bits.getBit()) {
+		byte v = bits.getBits(4);
 
 		if (v) {
-			int sign = -((int)video.bits->getBit());
+			int sign = -((int)bits.getBit());
 			v = (v ^ sign) - sign;
 		}
 
@@ -945,10 +1124,10 @@ void Bink::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bundle) {
 	}
 
 	do {
-		byte v = getHuffmanSymbol(video, bundle.huffman);
+		byte v = getHuffmanSymbol(bits, bundle.huffman);
 
 		if (v) {
-			int sign = -((int)video.bits->getBit());
+			int sign = -((int)bits.getBit());
 			v = (v ^ sign) - sign;
 		}
 
@@ -958,8 +1137,8 @@ void Bink::BinkVideoTrack::readMotionValues(VideoFrame &video, Bundle &bundle) {
 }
 
 const uint8 rleLens[4] = { 4, 8, 12, 32 };
-void Bink::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bundle) {
-	uint32 n = readBundleCount(video, bundle);
+void Bink::BinkVideoTrack::readBlockTypes(Common::BitStream &bits, Bundle &bundle) {
+	uint32 n = readBundleCount(bits, bundle);
 	if (n == 0)
 		return;
 
@@ -967,8 +1146,8 @@ void Bink::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bundle) {
 	if (decEnd > bundle.dataEnd)
 		throw Common::Exception("Too many block type values");
 
-	if (video.bits->getBit()) {
-		byte v = video.bits->getBits(4);
+	if (bits.getBit()) {
+		byte v = bits.getBits(4);
 
 		std::memset(bundle.curDec, v, n);
 
@@ -979,13 +1158,15 @@ void Bink::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bundle) {
 	byte last = 0;
 	do {
 
-		byte v = getHuffmanSymbol(video, bundle.huffman);
+		byte v = getHuffmanSymbol(bits, bundle.huffman);
 
 		if (v < 12) {
 			last = v;
 			*bundle.curDec++ = v;
 		} else {
 			int run = rleLens[v - 12];
+			if ((decEnd - bundle.curDec) < run)
+				throw Common::Exception("Block type run went out of bounds");
 
 			std::memset(bundle.curDec, last, run);
 
@@ -995,8 +1176,8 @@ void Bink::BinkVideoTrack::readBlockTypes(VideoFrame &video, Bundle &bundle) {
 	} while (bundle.curDec < decEnd);
 }
 
-void Bink::BinkVideoTrack::readPatterns(VideoFrame &video, Bundle &bundle) {
-	uint32 n = readBundleCount(video, bundle);
+void Bink::BinkVideoTrack::readPatterns(Common::BitStream &bits, Bundle &bundle) {
+	uint32 n = readBundleCount(bits, bundle);
 	if (n == 0)
 		return;
 
@@ -1006,15 +1187,15 @@ void Bink::BinkVideoTrack::readPatterns(VideoFrame &video, Bundle &bundle) {
 
 	byte v;
 	while (bundle.curDec < decEnd) {
-		v  = getHuffmanSymbol(video, bundle.huffman);
-		v |= getHuffmanSymbol(video, bundle.huffman) << 4;
+		v  = getHuffmanSymbol(bits, bundle.huffman);
+		v |= getHuffmanSymbol(bits, bundle.huffman) << 4;
 		*bundle.curDec++ = v;
 	}
 }
 
 
-void Bink::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle) {
-	uint32 n = readBundleCount(video, bundle);
+void Bink::BinkVideoTrack::readColors(DecodeContext &ctx, Bundle &bundle) {
+	uint32 n = readBundleCount(*ctx.bits, bundle);
 	if (n == 0)
 		return;
 
@@ -1022,12 +1203,12 @@ void Bink::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle) {
 	if (decEnd > bundle.dataEnd)
 		throw Common::Exception("Too many color values");
 
-	if (video.bits->getBit()) {
-		_colLastVal = getHuffmanSymbol(video, _colHighHuffman[_colLastVal]);
+	if (ctx.bits->getBit()) {
+		ctx.colLastVal = getHuffmanSymbol(*ctx.bits, ctx.colHighHuffman[ctx.colLastVal]);
 
 		byte v;
-		v = getHuffmanSymbol(video, bundle.huffman);
-		v = (_colLastVal << 4) | v;
+		v = getHuffmanSymbol(*ctx.bits, bundle.huffman);
+		v = (ctx.colLastVal << 4) | v;
 
 		if (_id != kBIKiID) {
 			int sign = ((int8) v) >> 7;
@@ -1042,11 +1223,11 @@ void Bink::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle) {
 	}
 
 	while (bundle.curDec < decEnd) {
-		_colLastVal = getHuffmanSymbol(video, _colHighHuffman[_colLastVal]);
+		ctx.colLastVal = getHuffmanSymbol(*ctx.bits, ctx.colHighHuffman[ctx.colLastVal]);
 
 		byte v;
-		v = getHuffmanSymbol(video, bundle.huffman);
-		v = (_colLastVal << 4) | v;
+		v = getHuffmanSymbol(*ctx.bits, bundle.huffman);
+		v = (ctx.colLastVal << 4) | v;
 
 		if (_id != kBIKiID) {
 			int sign = ((int8) v) >> 7;
@@ -1057,16 +1238,19 @@ void Bink::BinkVideoTrack::readColors(VideoFrame &video, Bundle &bundle) {
 	}
 }
 
-void Bink::BinkVideoTrack::readDCS(VideoFrame &video, Bundle &bundle, int startBits, bool hasSign) {
-	uint32 length = readBundleCount(video, bundle);
+void Bink::BinkVideoTrack::readDCS(Common::BitStream &bits, Bundle &bundle, int startBits, bool hasSign) {
+	uint32 length = readBundleCount(bits, bundle);
 	if (length == 0)
 		return;
 
+	if ((bundle.dataEnd - bundle.curDec) < (ptrdiff_t) (length * sizeof(int16)))
+		throw Common::Exception("Too many DC values");
+
 	int16 *dest = reinterpret_cast<int16 *>(bundle.curDec);
 
-	int32 v = video.bits->getBits(startBits - (hasSign ? 1 : 0));
+	int32 v = bits.getBits(startBits - (hasSign ? 1 : 0));
 	if (v && hasSign) {
-		int sign = -((int)video.bits->getBit());
+		int sign = -((int)bits.getBit());
 		v = (v ^ sign) - sign;
 	}
 
@@ -1076,14 +1260,14 @@ void Bink::BinkVideoTrack::readDCS(VideoFrame &video, Bundle &bundle, int startB
 	for (uint32 i = 0; i < length; i += 8) {
 		uint32 length2 = MIN<uint32>(length - i, 8);
 
-		byte bSize = video.bits->getBits(4);
+		byte bSize = bits.getBits(4);
 
 		if (bSize) {
 
 			for (uint32 j = 0; j < length2; j++) {
-				int16 v2 = video.bits->getBits(bSize);
+				int16 v2 = bits.getBits(bSize);
 				if (v2) {
-					int sign = -((int)video.bits->getBit());
+					int sign = -((int)bits.getBit());
 					v2 = (v2 ^ sign) - sign;
 				}
 
@@ -1123,7 +1307,7 @@ static inline int16 dequant(int16 in, uint32 quant, bool dc) {
 }
 
 /** Reads 8x8 block of DCT coefficients. */
-void Bink::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block, bool isIntra) {
+void Bink::BinkVideoTrack::readDCTCoeffs(Common::BitStream &bits, int16 *block, bool isIntra) {
 	int coefCount = 0;
 	int coefIdx[64];
 
@@ -1138,13 +1322,13 @@ void Bink::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block, bool i
 	coefList[listEnd] = 2;  modeList[listEnd++] = 3;
 	coefList[listEnd] = 3;  modeList[listEnd++] = 3;
 
-	int bits = video.bits->getBits(4) - 1;
-	for (int mask = 1 << (MAX<int>(bits, 0)); bits >= 0; mask >>= 1, bits--) {
+	int coefBits = bits.getBits(4) - 1;
+	for (int mask = 1 << (MAX<int>(coefBits, 0)); coefBits >= 0; mask >>= 1, coefBits--) {
 		int listPos = listStart;
 
 		while (listPos < listEnd) {
 
-			if (!(modeList[listPos] | coefList[listPos]) || !video.bits->getBit()) {
+			if (!(modeList[listPos] | coefList[listPos]) || !bits.getBit()) {
 				listPos++;
 				continue;
 			}
@@ -1163,17 +1347,17 @@ void Bink::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block, bool i
 					modeList[listPos++] = 0;
 				}
 				for (int i = 0; i < 4; i++, ccoef++) {
-					if (video.bits->getBit()) {
+					if (bits.getBit()) {
 						coefList[--listStart] = ccoef;
 						modeList[  listStart] = 3;
 					} else {
 						int t;
-						if (!bits) {
-							t = 1 - (video.bits->getBit() << 1);
+						if (!coefBits) {
+							t = 1 - (bits.getBit() << 1);
 						} else {
-							t = video.bits->getBits(bits) | mask;
+							t = bits.getBits(coefBits) | mask;
 
-							int sign = -((int)video.bits->getBit());
+							int sign = -((int)bits.getBit());
 							t = (t ^ sign) - sign;
 						}
 						block[binkScan[ccoef]] = t;
@@ -1193,12 +1377,12 @@ void Bink::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block, bool i
 
 			case 3:
 				int t;
-				if (!bits) {
-					t = 1 - (video.bits->getBit() << 1);
+				if (!coefBits) {
+					t = 1 - (bits.getBit() << 1);
 				} else {
-					t = video.bits->getBits(bits) | mask;
+					t = bits.getBits(coefBits) | mask;
 
-					int sign = -((int)video.bits->getBit());
+					int sign = -((int)bits.getBit());
 					t = (t ^ sign) - sign;
 				}
 				block[binkScan[ccoef]] = t;
@@ -1210,7 +1394,7 @@ void Bink::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block, bool i
 		}
 	}
 
-	uint8 quantIdx = video.bits->getBits(4);
+	uint8 quantIdx = bits.getBits(4);
 	const uint32 *quant = isIntra ? binkIntraQuant[quantIdx] : binkInterQuant[quantIdx];
 	block[0] = dequant(block[0], quant[0], true);
 
@@ -1222,7 +1406,7 @@ void Bink::BinkVideoTrack::readDCTCoeffs(VideoFrame &video, int16 *block, bool i
 }
 
 /** Reads 8x8 block with residue after motion compensation. */
-void Bink::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, int masksCount) {
+void Bink::BinkVideoTrack::readResidue(Common::BitStream &bits, int16 *block, int masksCount) {
 	int nzCoeff[64];
 	int nzCoeffCount = 0;
 
@@ -1235,10 +1419,10 @@ void Bink::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, int mask
 	coefList[listEnd] = 44; modeList[listEnd++] = 0;
 	coefList[listEnd] =  0; modeList[listEnd++] = 2;
 
-	for (int mask = 1 << video.bits->getBits(3); mask; mask >>= 1) {
+	for (int mask = 1 << bits.getBits(3); mask; mask >>= 1) {
 
 		for (int i = 0; i < nzCoeffCount; i++) {
-			if (!video.bits->getBit())
+			if (!bits.getBit())
 				continue;
 			if (block[nzCoeff[i]] < 0)
 				block[nzCoeff[i]] -= mask;
@@ -1252,7 +1436,7 @@ void Bink::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, int mask
 		int listPos = listStart;
 		while (listPos < listEnd) {
 
-			if (!(coefList[listPos] | modeList[listPos]) || !video.bits->getBit()) {
+			if (!(coefList[listPos] | modeList[listPos]) || !bits.getBit()) {
 				listPos++;
 				continue;
 			}
@@ -1272,13 +1456,13 @@ void Bink::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, int mask
 				}
 
 				for (int i = 0; i < 4; i++, ccoef++) {
-					if (video.bits->getBit()) {
+					if (bits.getBit()) {
 						coefList[--listStart] = ccoef;
 						modeList[  listStart] = 3;
 					} else {
 						nzCoeff[nzCoeffCount++] = binkScan[ccoef];
 
-						int sign = -((int)video.bits->getBit());
+						int sign = -((int)bits.getBit());
 						block[binkScan[ccoef]] = (mask ^ sign) - sign;
 
 						masksCount--;
@@ -1300,7 +1484,7 @@ void Bink::BinkVideoTrack::readResidue(VideoFrame &video, int16 *block, int mask
 			case 3:
 				nzCoeff[nzCoeffCount++] = binkScan[ccoef];
 
-				int sign = -((int)video.bits->getBit());
+				int sign = -((int)bits.getBit());
 				block[binkScan[ccoef]] = (mask ^ sign) - sign;
 
 				coefList[listPos]   = 0;
@@ -1522,91 +1706,9 @@ void Bink::BinkAudioTrack::readAudioCoeffs(Common::BitStream &bits, float *coeff
 
 }
 
-#define A1  2896 /* (1/sqrt(2))<<12 */
-#define A2  2217
-#define A3  3784
-#define A4 -5352
-
-#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
-    const int a0 = (src)[s0] + (src)[s4]; \
-    const int a1 = (src)[s0] - (src)[s4]; \
-    const int a2 = (src)[s2] + (src)[s6]; \
-    const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
-    const int a4 = (src)[s5] + (src)[s3]; \
-    const int a5 = (src)[s5] - (src)[s3]; \
-    const int a6 = (src)[s1] + (src)[s7]; \
-    const int a7 = (src)[s1] - (src)[s7]; \
-    const int b0 = a4 + a6; \
-    const int b1 = (A3*(a5 + a7)) >> 11; \
-    const int b2 = ((A4*a5) >> 11) - b0 + b1; \
-    const int b3 = (A1*(a6 - a4) >> 11) - b2; \
-    const int b4 = ((A2*a7) >> 11) + b3 - b1; \
-    (dest)[d0] = munge(a0+a2   +b0); \
-    (dest)[d1] = munge(a1+a3-a2+b2); \
-    (dest)[d2] = munge(a1-a3+a2+b3); \
-    (dest)[d3] = munge(a0-a2   -b4); \
-    (dest)[d4] = munge(a0-a2   +b4); \
-    (dest)[d5] = munge(a1-a3+a2-b3); \
-    (dest)[d6] = munge(a1+a3-a2-b2); \
-    (dest)[d7] = munge(a0+a2   -b0); \
-}
-/* end IDCT_TRANSFORM macro */
-
-#define MUNGE_NONE(x) (x)
-#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
-
-#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
-#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
-
-static inline void IDCTCol(int16 *dest, const int16 *src)
-{
-	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
-		dest[ 0] =
-		dest[ 8] =
-		dest[16] =
-		dest[24] =
-		dest[32] =
-		dest[40] =
-		dest[48] =
-		dest[56] = src[0];
-	} else {
-		IDCT_COL(dest, src);
-	}
-}
-
-void Bink::BinkVideoTrack::IDCT(int16 *block) {
-	int i;
-	int16 temp[64];
-
-	for (i = 0; i < 8; i++)
-		IDCTCol(&temp[i], &block[i]);
-	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
-	}
-}
-
-void Bink::BinkVideoTrack::IDCTAdd(DecodeContext &ctx, int16 *block) {
-	int i, j;
-
-	IDCT(block);
-	byte *dest = ctx.dest;
-	for (i = 0; i < 8; i++, dest += ctx.pitch, block += 8)
-		for (j = 0; j < 8; j++)
-			 dest[j] += block[j];
-}
-
-void Bink::BinkVideoTrack::IDCTPut(DecodeContext &ctx, int16 *block) {
-	int i;
-	int16 temp[64];
-	for (i = 0; i < 8; i++)
-		IDCTCol(&temp[i], &block[i]);
-	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&ctx.dest[i*ctx.pitch]), (&temp[8*i]) );
-	}
-}
-
 Bink::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, uint32 frameCount, const Common::Rational &frameRate, bool swapPlanes, bool hasAlpha, uint32 id) :
-		_width(width), _height(height), _curFrame(-1), _frameCount(frameCount), _frameRate(frameRate), _swapPlanes(swapPlanes), _hasAlpha(hasAlpha), _id(id) {
+		_width(width), _height(height), _curFrame(-1), _frameCount(frameCount), _frameRate(frameRate), _swapPlanes(swapPlanes), _hasAlpha(hasAlpha), _id(id),
+		_parallelPlanes(ThreadPoolMan.getThreadCount() > 0), _planeOffsets(kPlaneOffsetsUnknown) {
 	// Give the planes a bit extra space
 	width  = _width  + 32;
 	height = _height + 32;
@@ -1630,7 +1732,7 @@ Bink::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, uint32 frameCo
 	std::memset(_oldPlanes[2].get(),   0, (width >> 1) * (height >> 1));
 	std::memset(_oldPlanes[3].get(), 255,  width       *  height      );
 
-	initBundles();
+	initBundles(_bundles[0]);
 	initHuffman();
 }
 
@@ -72,6 +72,7 @@
 #define VIDEO_BINK_H
 
 #include <vector>
+#include <exception>
 
 #include "src/common/types.h"
 #include "src/common/rational.h"
@@ -100,6 +101,15 @@ public:
 	Bink(Common::SeekableReadStream *bink);
 	~Bink();
 
+	/** Decode independent groups of planes within a frame in parallel, on the thread pool?
+	 *
+	 *  Enabled by default if the thread pool has any worker threads. Only BIKi
+	 *  videos can be decoded in parallel, all others are always decoded serially.
+	 *
+	 *  Has to be set before the video is started.
+	 */
+	void setParallelPlanes(bool parallel);
+
 protected:
 	void decodeNextTrackFrame(VideoTrack &track);
 	void checkAudioBuffer(AudioTrack &track, const Common::Timestamp &endTime);
@@ -155,11 +165,6 @@ private:
 
 		uint32 offset;
 		uint32 size;
-
-		Common::BitStream *bits;
-
-		VideoFrame();
-		~VideoFrame();
 	};
 
 	Common::ScopedPtr<Common::SeekableReadStream> _bink;
@@ -181,37 +186,15 @@ private:
 		int getCurFrame() const { return _curFrame; }
 		int getFrameCount() const { return _frameCount; }
 
+		void setParallelPlanes(bool parallel) { _parallelPlanes = parallel; }
+
 		/** Decode a video packet. */
-		void decodePacket(Graphics::Surface &surface, VideoFrame &frame);
+		void decodePacket(Graphics::Surface &surface, const byte *data, size_t size);
 
 	protected:
 		Common::Rational getFrameRate() const { return _frameRate; }
 
 	private:
-		/** A decoder state. */
-		struct DecodeContext {
-			VideoFrame *video;
-
-			uint32 planeIdx;
-
-			uint32 blockX;
-			uint32 blockY;
-
-			byte *dest;
-			byte *prev;
-
-			byte *destStart, *destEnd;
-			byte *prevStart, *prevEnd;
-
-			uint32 pitch;
-
-			int coordMap[64];
-			int coordScaledMap1[64];
-			int coordScaledMap2[64];
-			int coordScaledMap3[64];
-			int coordScaledMap4[64];
-		};
-
 		/** IDs for different data types used in Bink video codec. */
 		enum Source {
 			kSourceBlockTypes    = 0, ///< 8x8 block types.
@@ -265,6 +248,71 @@ private:
 			Bundle();
 		};
 
+		/** A decoder state. */
+		struct DecodeContext {
+			Common::BitStream *bits; ///< The bitstream the plane is read from.
+			Bundle *bundles;         ///< The bundles used for decoding the plane.
+
+			/** Huffman codebooks to use for decoding high nibbles in color data types. */
+			Huffman colHighHuffman[16];
+			/** Value of the last decoded high nibble in color data types. */
+			int colLastVal;
+
+			uint32 planeIdx;
+
+			uint32 blockX;
+			uint32 blockY;
+
+			byte *dest;
+			byte *prev;
+
+			byte *destStart, *destEnd;
+			byte *prevStart, *prevEnd;
+
+			uint32 pitch;
+
+			int coordMap[64];
+			int coordScaledMap1[64];
+			int coordScaledMap2[64];
+			int coordScaledMap3[64];
+			int coordScaledMap4[64];
+		};
+
+		/** The groups of planes that can be decoded independently of each other. */
+		enum PlaneGroupType {
+			kPlaneGroupAlpha = 0, ///< The alpha plane.
+			kPlaneGroupLuma     , ///< The Y plane.
+			kPlaneGroupChroma   , ///< The U and V planes.
+
+			kPlaneGroupMAX
+		};
+
+		/** A group of planes, decoded in one go. */
+		struct PlaneGroup {
+			PlaneGroupType type;
+
+			int    planes[2];  ///< Indices of the planes in this group.
+			size_t planeCount; ///< Number of planes in this group.
+			bool   isChroma;   ///< Are these chroma planes?
+
+			bool   hasOffset; ///< Is there a 32-bit offset in front of the planes?
+			uint32 offset;    ///< The offset in front of the planes.
+
+			size_t start; ///< Position of the group in the packet, in bits.
+			size_t end;   ///< Position after the group in the packet, in bits.
+
+			bool decoded; ///< Was this group decoded in parallel?
+			std::exception_ptr error; ///< The exception thrown while decoding in parallel.
+		};
+
+		/** How the offsets in front of the planes in BIKi videos point to the next planes. */
+		enum PlaneOffsets {
+			kPlaneOffsetsUnknown = 0, ///< Not yet seen a frame that shows it.
+			kPlaneOffsetsAbsolute   , ///< Offset in bytes from the start of the packet.
+			kPlaneOffsetsRelative   , ///< Offset in bytes from the end of the offset itself.
+			kPlaneOffsetsNone         ///< The offsets don't point to the next planes.
+		};
+
 		uint32 _width;
 		uint32 _height;
 
@@ -278,45 +326,57 @@ private:
 
 		uint32 _id; ///< The BIK FourCC.
 
-		Bundle _bundles[kSourceMAX]; ///< Bundles for decoding all data types.
+		/** Bundles for decoding all data types, one set for each group of planes.
+		 *
+		 *  Only the first set is used when decoding the planes one after the other.
+		 */
+		Bundle _bundles[kPlaneGroupMAX][kSourceMAX];
 
 		Common::ScopedPtr<Common::Huffman> _huffman[16]; ///< The 16 Huffman codebooks used in Bink decoding.
 
-		/** Huffman codebooks to use for decoding high nibbles in color data types. */
-		Huffman _colHighHuffman[16];
-		/** Value of the last decoded high nibble in color data types. */
-		int _colLastVal;
+		bool _parallelPlanes; ///< Decode independent groups of planes in parallel?
+		PlaneOffsets _planeOffsets; ///< How the offsets in front of the planes work.
 
 		Common::ScopedArray<byte> _curPlanes[4]; ///< The 4 color planes, YUVA, current frame.
 		Common::ScopedArray<byte> _oldPlanes[4]; ///< The 4 color planes, YUVA, last frame.
 
-		/** Initialize the bundles. */
-		void initBundles();
+		/** Initialize a set of bundles. */
+		void initBundles(Bundle *bundles);
 
 		/** Initialize the Huffman decoders. */
 		void initHuffman();
 
-		/** Decode a video packet. */
-		void videoPacket(VideoFrame &video);
+		/** Decode the groups of planes in a video packet one after the other. */
+		void decodePlaneGroups(const byte *data, size_t size, PlaneGroup *groups, size_t groupCount);
+		/** Decode the groups of planes in a video packet in parallel, on the thread pool. */
+		void decodePlaneGroupsParallel(const byte *data, size_t size, PlaneGroup *groups, size_t groupCount);
+
+		/** Decode a group of planes, starting at the group's start position. */
+		void decodePlaneGroup(const byte *data, size_t size, PlaneGroup &group, Bundle *bundles);
+
+		/** Check how the offset in front of a decoded group of planes relates to its end. */
+		void checkPlaneOffsets(const PlaneGroup &group);
+		/** Predict where the group of planes following this one starts, or return false if we can't. */
+		bool predictNextPlaneGroup(const byte *data, size_t size, const PlaneGroup &group, size_t &next) const;
 
 		/** Decode a plane. */
-		void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
+		void decodePlane(Common::BitStream &bits, Bundle *bundles, int planeIdx, bool isChroma);
 
 		/** Read/Initialize a bundle for decoding a plane. */
-		void readBundle(VideoFrame &video, Source source);
+		void readBundle(DecodeContext &ctx, Source source);
 
 		/** Read the symbols for a Huffman code. */
-		void readHuffman(VideoFrame &video, Huffman &huffman);
+		void readHuffman(Common::BitStream &bits, Huffman &huffman);
 		/** Merge two Huffman symbol lists. */
-		void mergeHuffmanSymbols(VideoFrame &video, byte *dst, const byte *src, int size);
+		void mergeHuffmanSymbols(Common::BitStream &bits, byte *dst, const byte *src, int size);
 
 		/** Read and translate a symbol out of a Huffman code. */
-		byte getHuffmanSymbol(VideoFrame &video, Huffman &huffman);
+		byte getHuffmanSymbol(Common::BitStream &bits, Huffman &huffman);
 
 		/** Get a direct value out of a bundle. */
-		int32 getBundleValue(Source source);
+		int32 getBundleValue(DecodeContext &ctx, Source source);
 		/** Read a count value out of a bundle. */
-		uint32 readBundleCount(VideoFrame &video, Bundle &bundle);
+		uint32 readBundleCount(Common::BitStream &bits, Bundle &bundle);
 
 		// Handle the block types
 		void blockSkip         (DecodeContext &ctx);
@@ -337,19 +397,14 @@ private:
 		void blockRaw          (DecodeContext &ctx);
 
 		// Read the bundles
-		void readRuns        (VideoFrame &video, Bundle &bundle);
-		void readMotionValues(VideoFrame &video, Bundle &bundle);
-		void readBlockTypes  (VideoFrame &video, Bundle &bundle);
-		void readPatterns    (VideoFrame &video, Bundle &bundle);
-		void readColors      (VideoFrame &video, Bundle &bundle);
-		void readDCS         (VideoFrame &video, Bundle &bundle, int startBits, bool hasSign);
-		void readDCTCoeffs   (VideoFrame &video, int16 *block, bool isIntra);
-		void readResidue     (VideoFrame &video, int16 *block, int masksCount);
-
-		// Bink video IDCT
-		void IDCT(int16 *block);
-		void IDCTPut(DecodeContext &ctx, int16 *block);
-		void IDCTAdd(DecodeContext &ctx, int16 *block);
+		void readRuns        (Common::BitStream &bits, Bundle &bundle);
+		void readMotionValues(Common::BitStream &bits, Bundle &bundle);
+		void readBlockTypes  (Common::BitStream &bits, Bundle &bundle);
+		void readPatterns    (Common::BitStream &bits, Bundle &bundle);
+		void readColors      (DecodeContext     &ctx , Bundle &bundle);
+		void readDCS         (Common::BitStream &bits, Bundle &bundle, int startBits, bool hasSign);
+		void readDCTCoeffs   (Common::BitStream &bits, int16 *block, bool isIntra);
+		void readResidue     (Common::BitStream &bits, int16 *block, int masksCount);
 	};
 
 	class BinkAudioTrack : public AudioTrack {
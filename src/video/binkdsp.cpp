@@ -0,0 +1,347 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  DSP routines for decoding RAD Game Tools' Bink videos.
+ */
+
+/* Based on the Bink DSP routines in FFmpeg (<https://ffmpeg.org/)>,
+ * which are released under the terms of version 2 or later of the GNU
+ * Lesser General Public License.
+ *
+ * The original copyright note in the file libavcodec/binkdsp.c reads
+ * as follows:
+ *
+ * Bink DSP routines
+ * Copyright (c) 2009 Konstantin Shishkov
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define XOREOS_BINKDSP_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+#include "src/video/binkdsp.h"
+
+#define A1  2896 /* (1/sqrt(2))<<12 */
+#define A2  2217
+#define A3  3784
+#define A4 -5352
+
+#define IDCT_TRANSFORM(dest,s0,s1,s2,s3,s4,s5,s6,s7,d0,d1,d2,d3,d4,d5,d6,d7,munge,src) {\
+    const int a0 = (src)[s0] + (src)[s4]; \
+    const int a1 = (src)[s0] - (src)[s4]; \
+    const int a2 = (src)[s2] + (src)[s6]; \
+    const int a3 = (A1*((src)[s2] - (src)[s6])) >> 11; \
+    const int a4 = (src)[s5] + (src)[s3]; \
+    const int a5 = (src)[s5] - (src)[s3]; \
+    const int a6 = (src)[s1] + (src)[s7]; \
+    const int a7 = (src)[s1] - (src)[s7]; \
+    const int b0 = a4 + a6; \
+    const int b1 = (A3*(a5 + a7)) >> 11; \
+    const int b2 = ((A4*a5) >> 11) - b0 + b1; \
+    const int b3 = (A1*(a6 - a4) >> 11) - b2; \
+    const int b4 = ((A2*a7) >> 11) + b3 - b1; \
+    (dest)[d0] = munge(a0+a2   +b0); \
+    (dest)[d1] = munge(a1+a3-a2+b2); \
+    (dest)[d2] = munge(a1-a3+a2+b3); \
+    (dest)[d3] = munge(a0-a2   -b4); \
+    (dest)[d4] = munge(a0-a2   +b4); \
+    (dest)[d5] = munge(a1-a3+a2-b3); \
+    (dest)[d6] = munge(a1+a3-a2-b2); \
+    (dest)[d7] = munge(a0+a2   -b0); \
+}
+/* end IDCT_TRANSFORM macro */
+
+#define MUNGE_NONE(x) (x)
+#define IDCT_COL(dest,src) IDCT_TRANSFORM(dest,0,8,16,24,32,40,48,56,0,8,16,24,32,40,48,56,MUNGE_NONE,src)
+
+#define MUNGE_ROW(x) (((x) + 0x7F)>>8)
+#define IDCT_ROW(dest,src) IDCT_TRANSFORM(dest,0,1,2,3,4,5,6,7,0,1,2,3,4,5,6,7,MUNGE_ROW,src)
+
+namespace Video {
+
+static inline void IDCTCol(int16 *dest, const int16 *src)
+{
+	if ((src[8] | src[16] | src[24] | src[32] | src[40] | src[48] | src[56]) == 0) {
+		dest[ 0] =
+		dest[ 8] =
+		dest[16] =
+		dest[24] =
+		dest[32] =
+		dest[40] =
+		dest[48] =
+		dest[56] = src[0];
+	} else {
+		IDCT_COL(dest, src);
+	}
+}
+
+void binkIDCTScalar(int16 *block) {
+	int i;
+	int16 temp[64];
+
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&block[8*i]), (&temp[8*i]) );
+	}
+}
+
+void binkIDCTPutScalar(byte *dest, uint32 pitch, const int16 *block) {
+	int i;
+	int16 temp[64];
+	for (i = 0; i < 8; i++)
+		IDCTCol(&temp[i], &block[i]);
+	for (i = 0; i < 8; i++) {
+		IDCT_ROW( (&dest[i*pitch]), (&temp[8*i]) );
+	}
+}
+
+void binkIDCTAddScalar(byte *dest, uint32 pitch, const int16 *block) {
+	int16 temp[64];
+	for (int i = 0; i < 64; i++)
+		temp[i] = block[i];
+
+	binkIDCTScalar(temp);
+	binkAddBlockScalar(dest, pitch, temp);
+}
+
+void binkAddBlockScalar(byte *dest, uint32 pitch, const int16 *block) {
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8)
+		for (int j = 0; j < 8; j++)
+			dest[j] += block[j];
+}
+
+#ifdef XOREOS_BINKDSP_SSE2
+
+/* The SSE2 IDCT works on four columns or rows at once, in 32-bit lanes.
+ * The intermediate values are truncated to 16 bits between the passes,
+ * and the final values to 16 or 8 bits, exactly like in the scalar code.
+ * Skipping the column transform for columns without AC coefficients, like
+ * the scalar code does, is only a shortcut: the transform of such a column
+ * gives the same result. */
+
+/** Multiply each 32-bit lane by a constant, keeping the lower 32 bits of the products. */
+static inline __m128i mul32(__m128i a, int32 c) {
+	const __m128i constant = _mm_set1_epi32(c);
+
+	const __m128i even = _mm_mul_epu32(a, constant);
+	const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), constant);
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+	                          _mm_shuffle_epi32(odd , _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+/** Truncate each 32-bit lane to a signed 16-bit value. */
+static inline __m128i truncate16(__m128i a) {
+	return _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+}
+
+/** Transpose four vectors of four 32-bit lanes each. */
+static inline void transpose4(__m128i &r0, __m128i &r1, __m128i &r2, __m128i &r3) {
+	const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+	const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+	const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+	const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+	r0 = _mm_unpacklo_epi64(t0, t1);
+	r1 = _mm_unpackhi_epi64(t0, t1);
+	r2 = _mm_unpacklo_epi64(t2, t3);
+	r3 = _mm_unpackhi_epi64(t2, t3);
+}
+
+/** The IDCT_TRANSFORM macro, on four sets of values at once. */
+static inline void idctTransform(const __m128i *s, __m128i *d) {
+	const __m128i a0 = _mm_add_epi32(s[0], s[4]);
+	const __m128i a1 = _mm_sub_epi32(s[0], s[4]);
+	const __m128i a2 = _mm_add_epi32(s[2], s[6]);
+	const __m128i a3 = _mm_srai_epi32(mul32(_mm_sub_epi32(s[2], s[6]), A1), 11);
+	const __m128i a4 = _mm_add_epi32(s[5], s[3]);
+	const __m128i a5 = _mm_sub_epi32(s[5], s[3]);
+	const __m128i a6 = _mm_add_epi32(s[1], s[7]);
+	const __m128i a7 = _mm_sub_epi32(s[1], s[7]);
+
+	const __m128i b0 = _mm_add_epi32(a4, a6);
+	const __m128i b1 = _mm_srai_epi32(mul32(_mm_add_epi32(a5, a7), A3), 11);
+	const __m128i b2 = _mm_add_epi32(_mm_sub_epi32(_mm_srai_epi32(mul32(a5, A4), 11), b0), b1);
+	const __m128i b3 = _mm_sub_epi32(_mm_srai_epi32(mul32(_mm_sub_epi32(a6, a4), A1), 11), b2);
+	const __m128i b4 = _mm_sub_epi32(_mm_add_epi32(_mm_srai_epi32(mul32(a7, A2), 11), b3), b1);
+
+	const __m128i a0Pa2 = _mm_add_epi32(a0, a2);
+	const __m128i a0Ma2 = _mm_sub_epi32(a0, a2);
+	const __m128i a1Pa3Ma2 = _mm_sub_epi32(_mm_add_epi32(a1, a3), a2);
+	const __m128i a1Ma3Pa2 = _mm_add_epi32(_mm_sub_epi32(a1, a3), a2);
+
+	d[0] = _mm_add_epi32(a0Pa2, b0);
+	d[1] = _mm_add_epi32(a1Pa3Ma2, b2);
+	d[2] = _mm_add_epi32(a1Ma3Pa2, b3);
+	d[3] = _mm_sub_epi32(a0Ma2, b4);
+	d[4] = _mm_add_epi32(a0Ma2, b4);
+	d[5] = _mm_sub_epi32(a1Ma3Pa2, b3);
+	d[6] = _mm_sub_epi32(a1Pa3Ma2, b2);
+	d[7] = _mm_sub_epi32(a0Pa2, b0);
+}
+
+/** Inverse-transform a block. rows[i][0] receives columns 0-3 of row i, rows[i][1] columns 4-7. */
+static inline void idctSSE2(const int16 *block, __m128i rows[8][2]) {
+	__m128i temp[8][2];
+
+	// Columns, four at a time
+	for (int half = 0; half < 2; half++) {
+		__m128i s[8], d[8];
+
+		for (int i = 0; i < 8; i++) {
+			const __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 8 * i));
+
+			s[i] = _mm_srai_epi32((half == 0) ? _mm_unpacklo_epi16(row, row) : _mm_unpackhi_epi16(row, row), 16);
+		}
+
+		idctTransform(s, d);
+
+		for (int i = 0; i < 8; i++)
+			temp[i][half] = truncate16(d[i]);
+	}
+
+	// Rows, four at a time, with the values of each column transposed into a vector
+	const __m128i round = _mm_set1_epi32(0x7F);
+	for (int quarter = 0; quarter < 8; quarter += 4) {
+		__m128i s[8], d[8];
+
+		for (int i = 0; i < 4; i++) {
+			s[i    ] = temp[quarter + i][0];
+			s[i + 4] = temp[quarter + i][1];
+		}
+
+		transpose4(s[0], s[1], s[2], s[3]);
+		transpose4(s[4], s[5], s[6], s[7]);
+
+		idctTransform(s, d);
+
+		for (int i = 0; i < 8; i++)
+			d[i] = _mm_srai_epi32(_mm_add_epi32(d[i], round), 8);
+
+		transpose4(d[0], d[1], d[2], d[3]);
+		transpose4(d[4], d[5], d[6], d[7]);
+
+		for (int i = 0; i < 4; i++) {
+			rows[quarter + i][0] = d[i    ];
+			rows[quarter + i][1] = d[i + 4];
+		}
+	}
+}
+
+/** Pack eight 32-bit lanes into the lower 8 bits of eight bytes. */
+static inline __m128i packBytes(__m128i lo, __m128i hi) {
+	const __m128i mask = _mm_set1_epi32(0xFF);
+
+	const __m128i words = _mm_packs_epi32(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+
+	return _mm_packus_epi16(words, words);
+}
+
+static void binkIDCTSSE2(int16 *block) {
+	__m128i rows[8][2];
+	idctSSE2(block, rows);
+
+	for (int i = 0; i < 8; i++)
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(block + 8 * i),
+		                 _mm_packs_epi32(truncate16(rows[i][0]), truncate16(rows[i][1])));
+}
+
+static void binkIDCTPutSSE2(byte *dest, uint32 pitch, const int16 *block) {
+	__m128i rows[8][2];
+	idctSSE2(block, rows);
+
+	for (int i = 0; i < 8; i++, dest += pitch)
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dest), packBytes(rows[i][0], rows[i][1]));
+}
+
+static void binkIDCTAddSSE2(byte *dest, uint32 pitch, const int16 *block) {
+	__m128i rows[8][2];
+	idctSSE2(block, rows);
+
+	for (int i = 0; i < 8; i++, dest += pitch) {
+		const __m128i old = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(dest));
+
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dest), _mm_add_epi8(old, packBytes(rows[i][0], rows[i][1])));
+	}
+}
+
+static void binkAddBlockSSE2(byte *dest, uint32 pitch, const int16 *block) {
+	const __m128i mask = _mm_set1_epi16(0xFF);
+
+	for (int i = 0; i < 8; i++, dest += pitch, block += 8) {
+		const __m128i values = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(block)), mask);
+		const __m128i old    = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(dest));
+
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(dest), _mm_add_epi8(old, _mm_packus_epi16(values, values)));
+	}
+}
+
+#endif // XOREOS_BINKDSP_SSE2
+
+void binkIDCT(int16 *block) {
+#ifdef XOREOS_BINKDSP_SSE2
+	binkIDCTSSE2(block);
+#else
+	binkIDCTScalar(block);
+#endif
+}
+
+void binkIDCTPut(byte *dest, uint32 pitch, const int16 *block) {
+#ifdef XOREOS_BINKDSP_SSE2
+	binkIDCTPutSSE2(dest, pitch, block);
+#else
+	binkIDCTPutScalar(dest, pitch, block);
+#endif
+}
+
+void binkIDCTAdd(byte *dest, uint32 pitch, const int16 *block) {
+#ifdef XOREOS_BINKDSP_SSE2
+	binkIDCTAddSSE2(dest, pitch, block);
+#else
+	binkIDCTAddScalar(dest, pitch, block);
+#endif
+}
+
+void binkAddBlock(byte *dest, uint32 pitch, const int16 *block) {
+#ifdef XOREOS_BINKDSP_SSE2
+	binkAddBlockSSE2(dest, pitch, block);
+#else
+	binkAddBlockScalar(dest, pitch, block);
+#endif
+}
+
+} // End of namespace Video
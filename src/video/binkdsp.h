@@ -0,0 +1,81 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  DSP routines for decoding RAD Game Tools' Bink videos.
+ */
+
+/* Based on the Bink DSP routines in FFmpeg (<https://ffmpeg.org/)>,
+ * which are released under the terms of version 2 or later of the GNU
+ * Lesser General Public License.
+ *
+ * The original copyright note in the file libavcodec/binkdsp.c reads
+ * as follows:
+ *
+ * Bink DSP routines
+ * Copyright (c) 2009 Konstantin Shishkov
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef VIDEO_BINKDSP_H
+#define VIDEO_BINKDSP_H
+
+#include "src/common/types.h"
+
+namespace Video {
+
+/* All functions work on 8x8 blocks of 16-bit coefficients, stored row by row.
+ * They use SSE2 where available, and scalar code otherwise. The results of
+ * both are bit-exact. */
+
+/** Inverse-transform a block of Bink DCT coefficients, in place. */
+void binkIDCT(int16 *block);
+/** Inverse-transform a block of coefficients and write it into an 8-bit plane. */
+void binkIDCTPut(byte *dest, uint32 pitch, const int16 *block);
+/** Inverse-transform a block of coefficients and add it onto an 8-bit plane. */
+void binkIDCTAdd(byte *dest, uint32 pitch, const int16 *block);
+/** Add a block of residue values onto an 8-bit plane. */
+void binkAddBlock(byte *dest, uint32 pitch, const int16 *block);
+
+/** Inverse-transform a block like binkIDCT(), but always use the scalar code. */
+void binkIDCTScalar(int16 *block);
+/** Inverse-transform a block like binkIDCTPut(), but always use the scalar code. */
+void binkIDCTPutScalar(byte *dest, uint32 pitch, const int16 *block);
+/** Inverse-transform a block like binkIDCTAdd(), but always use the scalar code. */
+void binkIDCTAddScalar(byte *dest, uint32 pitch, const int16 *block);
+/** Add a block of residue values like binkAddBlock(), but always use the scalar code. */
+void binkAddBlockScalar(byte *dest, uint32 pitch, const int16 *block);
+
+} // End of namespace Video
+
+#endif // VIDEO_BINKDSP_H
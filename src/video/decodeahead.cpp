@@ -0,0 +1,184 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Decoding video frames ahead of time.
+ */
+
+#include "src/common/error.h"
+#include "src/common/threadpool.h"
+
+#include "src/graphics/images/surface.h"
+
+#include "src/video/decodeahead.h"
+
+namespace Video {
+
+DecodeAhead::DecodeAhead(size_t frameCount, int width, int height, const DecodeFunction &decode) :
+	_decode(decode), _head(0), _count(0), _stop(false), _end(false), _running(false) {
+
+	if (frameCount == 0)
+		throw Common::Exception("DecodeAhead: Need to decode at least one frame ahead");
+
+	_surfaces.resize(frameCount + 1, 0);
+	_times.resize(frameCount + 1, 0);
+
+	try {
+		for (std::vector<Graphics::Surface *>::iterator s = _surfaces.begin(); s != _surfaces.end(); ++s)
+			*s = new Graphics::Surface(width, height);
+	} catch (...) {
+		for (std::vector<Graphics::Surface *>::iterator s = _surfaces.begin(); s != _surfaces.end(); ++s)
+			delete *s;
+
+		throw;
+	}
+}
+
+DecodeAhead::~DecodeAhead() {
+	stop();
+
+	for (std::vector<Graphics::Surface *>::iterator s = _surfaces.begin(); s != _surfaces.end(); ++s)
+		delete *s;
+}
+
+void DecodeAhead::start() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_stop = false;
+
+	schedule();
+}
+
+void DecodeAhead::stop() {
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	_stop = true;
+
+	_progress.wait(lock, [&]() { return !_running; });
+}
+
+size_t DecodeAhead::waitForFrames(size_t count) const {
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	_progress.wait(lock, [&]() { return (_count >= count) || !_running; });
+
+	return _count;
+}
+
+bool DecodeAhead::getNextFrameTime(uint32 &time) const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_count == 0)
+		return false;
+
+	time = _times[_head];
+	return true;
+}
+
+const Graphics::Surface *DecodeAhead::getFrame(uint32 time) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if ((_count == 0) && _error) {
+		std::exception_ptr error = _error;
+		_error = std::exception_ptr();
+
+		std::rethrow_exception(error);
+	}
+
+	const Graphics::Surface *frame = 0;
+	while ((_count > 0) && (_times[_head] <= time)) {
+		frame = _surfaces[_head];
+
+		_head = (_head + 1) % _surfaces.size();
+		_count--;
+	}
+
+	if (frame)
+		schedule();
+
+	return frame;
+}
+
+bool DecodeAhead::endOfStream() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _end && (_count == 0) && !_error;
+}
+
+void DecodeAhead::schedule() {
+	/* The frame taken out last is still in use by the consumer. So with one
+	 * surface more than frames to decode ahead, the surface behind the newest
+	 * decoded frame is always free while fewer than that are waiting. */
+	if (_running || _stop || _end || (_count >= (_surfaces.size() - 1)))
+		return;
+
+	_running = true;
+
+	ThreadPoolMan.run([this]() { decodeFrames(); });
+}
+
+void DecodeAhead::decodeFrames() {
+	while (true) {
+		size_t slot;
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			if (_stop || _end || (_count >= (_surfaces.size() - 1))) {
+				_running = false;
+				_progress.notify_all();
+				return;
+			}
+
+			slot = (_head + _count) % _surfaces.size();
+		}
+
+		uint32 time = 0;
+		bool decoded = false;
+
+		try {
+			decoded = _decode(*_surfaces[slot], time);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			_error   = std::current_exception();
+			_end     = true;
+			_running = false;
+			_progress.notify_all();
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (!decoded) {
+			_end     = true;
+			_running = false;
+			_progress.notify_all();
+			return;
+		}
+
+		_times[slot] = time;
+		_count++;
+
+		_progress.notify_all();
+	}
+}
+
+} // End of namespace Video
@@ -0,0 +1,132 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Decoding video frames ahead of time.
+ */
+
+#ifndef VIDEO_DECODEAHEAD_H
+#define VIDEO_DECODEAHEAD_H
+
+#include <vector>
+#include <exception>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/mutex.h"
+
+namespace Graphics {
+	class Surface;
+}
+
+namespace Video {
+
+/** Decodes video frames ahead of time, on the global thread pool.
+ *
+ *  The frames are decoded into a ring of preallocated surfaces, together
+ *  with the time they should be shown at. The consumer then only takes
+ *  out the frame whose time has come. A frame that takes especially long
+ *  to decode is compensated by the frames decoded before it.
+ *
+ *  While there are free surfaces, one task on the pool decodes frames
+ *  into them. Once the ring is full, the task ends, and taking out a
+ *  frame queues a new one.
+ *
+ *  If the decode function throws, decoding stops. The exception is
+ *  rethrown by the next call to getFrame() after all frames decoded
+ *  before it have been taken out.
+ */
+class DecodeAhead : boost::noncopyable {
+public:
+	/** Decode the next frame into this surface and set the time it should be shown at, in ms.
+	 *
+	 *  Called on the worker thread. Returns false if there are no more frames.
+	 */
+	typedef std::function<bool (Graphics::Surface &surface, uint32 &time)> DecodeFunction;
+
+	/** Create a ring of frameCount surfaces of this size, to be filled by the decode function. */
+	DecodeAhead(size_t frameCount, int width, int height, const DecodeFunction &decode);
+	~DecodeAhead();
+
+	/** Start decoding frames on the thread pool. */
+	void start();
+	/** Stop decoding, keeping all frames decoded so far.
+	 *
+	 *  Waits for the frame currently being decoded. Afterwards, the
+	 *  decode function is not called anymore until the next start().
+	 */
+	void stop();
+
+	/** Wait until at least count frames are waiting to be taken out, or decoding has stopped.
+	 *
+	 *  Decoding stops when all surfaces are full, the decode function ran
+	 *  out of frames or threw, or stop() was called. Returns the number of
+	 *  decoded frames waiting to be taken out.
+	 */
+	size_t waitForFrames(size_t count) const;
+
+	/** Return the time of the next decoded frame, or false if none has been decoded yet. */
+	bool getNextFrameTime(uint32 &time) const;
+
+	/** Take out all frames that should be shown at this time, and return the newest one.
+	 *
+	 *  Older frames are skipped. Returns 0 if no frame is due yet.
+	 *  The returned surface stays valid until the next call to getFrame().
+	 */
+	const Graphics::Surface *getFrame(uint32 time);
+
+	/** Has the decode function run out of frames, and all of them been taken out?
+	 *
+	 *  Not while an exception of the decode function still waits to be
+	 *  rethrown by getFrame().
+	 */
+	bool endOfStream() const;
+
+private:
+	DecodeFunction _decode;
+
+	/** All surfaces. One more than frames to decode ahead, for the frame taken out last. */
+	std::vector<Graphics::Surface *> _surfaces;
+	std::vector<uint32> _times; ///< The times of the frames in the surfaces.
+
+	size_t _head;  ///< Index of the oldest decoded frame.
+	size_t _count; ///< Number of decoded frames waiting to be taken out.
+
+	bool _stop;    ///< Should decoding stop?
+	bool _end;     ///< Has the decode function run out of frames?
+	bool _running; ///< Is a task decoding frames on the thread pool?
+
+	std::exception_ptr _error; ///< The exception thrown by the decode function.
+
+	mutable std::mutex _mutex;
+	/** Signals that a frame has been decoded, or that the decoding task has ended. */
+	mutable std::condition_variable _progress;
+
+	/** Queue a decoding task, if none is running and there's a free surface. Needs the mutex. */
+	void schedule();
+	/** Decode frames until there are no more free surfaces. */
+	void decodeFrames();
+};
+
+} // End of namespace Video
+
+#endif // VIDEO_DECODEAHEAD_H
@@ -23,6 +23,7 @@
  */
 
 #include <cassert>
+#include <cstring>
 
 #include <boost/pointer_cast.hpp>
 
@@ -38,6 +39,7 @@
 #include "src/graphics/images/surface.h"
 
 #include "src/video/decoder.h"
+#include "src/video/decodeahead.h"
 
 #include "src/sound/sound.h"
 #include "src/sound/audiostream.h"
@@ -49,11 +51,13 @@ VideoDecoder::VideoDecoder() : Renderable(Graphics::kRenderableTypeVideo),
 	_needCopy(false),
 	_texture(0),
 	_textureWidth(0.0f), _textureHeight(0.0f), _scale(kScaleNone),
-	_startTime(0), _pauseLevel(0), _pauseStartTime(0) {
+	_startTime(0), _decodeAheadFrames(0), _pauseLevel(0), _pauseStartTime(0) {
 
 }
 
 VideoDecoder::~VideoDecoder() {
+	stopDecodeAhead();
+
 	deinit();
 
 	if (_texture != 0)
@@ -105,7 +109,7 @@ uint32 VideoDecoder::getHeight() const {
 
 bool VideoDecoder::endOfVideo() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->endOfTrack())
+		if (!hasTrackEnded(**it))
 			return false;
 
 	return true;
@@ -113,12 +117,20 @@ bool VideoDecoder::endOfVideo() const {
 
 bool VideoDecoder::endOfVideoTracks() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack())
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !hasTrackEnded(**it))
 			return false;
 
 	return true;
 }
 
+bool VideoDecoder::hasTrackEnded(const Track &track) const {
+	// When decoding ahead, the video tracks are done once their last frame has been shown
+	if (_decodeAhead && (track.getTrackType() == Track::kTrackTypeVideo))
+		return _decodeAhead->endOfStream();
+
+	return track.endOfTrack();
+}
+
 bool VideoDecoder::needsUpdate() const {
 	return !endOfVideoTracks() && getTimeToNextFrame() == 0;
 }
@@ -276,32 +288,50 @@ void VideoDecoder::copyData() {
 
 	if (!_surface)
 		throw Common::Exception("No video data while trying to copy");
+
+	copyData(*_surface);
+
+	_needCopy = false;
+}
+
+void VideoDecoder::copyData(const Graphics::Surface &surface) {
 	if (_texture == 0)
 		throw Common::Exception("No texture while trying to copy");
 
 	glBindTexture(GL_TEXTURE_2D, _texture);
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _surface->getWidth(), _surface->getHeight(),
-	                GL_BGRA, GL_UNSIGNED_BYTE, _surface->getData());
-
-	_needCopy = false;
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, surface.getWidth(), surface.getHeight(),
+	                GL_BGRA, GL_UNSIGNED_BYTE, surface.getData());
 }
 
 void VideoDecoder::setScale(Scale scale) {
 	_scale = scale;
 }
 
+void VideoDecoder::setDecodeAhead(size_t frameCount) {
+	_decodeAheadFrames = frameCount;
+}
+
 bool VideoDecoder::isPlaying() const {
 	if (_startTime == 0)
 		return false;
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->endOfTrack())
+		if (!hasTrackEnded(**it))
 			return true;
 
 	return false;
 }
 
 void VideoDecoder::update() {
+	if (_decodeAhead) {
+		// The worker has already decoded the frame, we only need to show it
+		const Graphics::Surface *frame = _decodeAhead->getFrame(getTime());
+		if (frame)
+			copyData(*frame);
+
+		return;
+	}
+
 	if (!needsUpdate() || !_nextVideoTrack)
 		return;
 
@@ -316,6 +346,10 @@ void VideoDecoder::update() {
 	// Look for the next video track here for the next decode.
 	findNextVideoTrack();
 
+	bufferAudio();
+}
+
+void VideoDecoder::bufferAudio() {
 	// Figure out how much audio we need
 	Common::Timestamp audioNeeded;
 	if (_nextVideoTrack)
@@ -329,6 +363,28 @@ void VideoDecoder::update() {
 			checkAudioBuffer(static_cast<AudioTrack&>(**it), audioNeeded);
 }
 
+bool VideoDecoder::decodeAheadFrame(Graphics::Surface &surface, uint32 &time) {
+	if (!findNextVideoTrack())
+		return false;
+
+	time = _nextVideoTrack->getNextFrameStartTime().msecs();
+
+	debugC(Common::kDebugVideo, 9, "New video frame, decoded ahead for %u", time);
+
+	decodeNextTrackFrame(*_nextVideoTrack);
+
+	assert((surface.getWidth() == _surface->getWidth()) && (surface.getHeight() == _surface->getHeight()));
+	std::memcpy(surface.getData(), _surface->getData(), _surface->getPitch() * _surface->getHeight());
+
+	_needCopy = false;
+
+	// The audio comes out of the same stream as the video, so buffer it here, too
+	findNextVideoTrack();
+	bufferAudio();
+
+	return true;
+}
+
 void VideoDecoder::getQuadDimensions(float &width, float &height) const {
 	width  = getWidth();
 	height = getHeight();
@@ -395,6 +451,16 @@ void VideoDecoder::render(Graphics::RenderPass pass) {
 }
 
 void VideoDecoder::start() {
+	if ((_decodeAheadFrames > 0) && _surface && !_decodeAhead) {
+		_decodeAhead.reset(new DecodeAhead(_decodeAheadFrames, _surface->getWidth(), _surface->getHeight(),
+			[this](Graphics::Surface &surface, uint32 &time) { return decodeAheadFrame(surface, time); }));
+
+		_decodeAhead->start();
+
+		// Don't start the clock before the first frame is there
+		_decodeAhead->waitForFrames(1);
+	}
+
 	_startTime = EventMan.getTimestamp();
 
 	startAudio();
@@ -405,9 +471,15 @@ void VideoDecoder::start() {
 void VideoDecoder::abort() {
 	hide();
 
+	stopDecodeAhead();
 	stopAudio();
 }
 
+void VideoDecoder::stopDecodeAhead() {
+	if (_decodeAhead)
+		_decodeAhead->stop();
+}
+
 uint32 VideoDecoder::getTime() const {
 	if (!isPlaying())
 		return 0;
@@ -421,11 +493,21 @@ uint32 VideoDecoder::getTime() const {
 }
 
 uint32 VideoDecoder::getTimeToNextFrame() const {
-	if (!_nextVideoTrack || endOfVideo())
+	if (endOfVideo())
 		return 0;
 
+	uint32 nextFrameStartTime = 0;
+	if (_decodeAhead) {
+		if (!_decodeAhead->getNextFrameTime(nextFrameStartTime))
+			return 0;
+	} else {
+		if (!_nextVideoTrack)
+			return 0;
+
+		nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime().msecs();
+	}
+
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime().msecs();
 
 	if (nextFrameStartTime <= currentTime)
 		return 0;
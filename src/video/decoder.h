@@ -51,6 +51,8 @@ namespace Sound {
 
 namespace Video {
 
+class DecodeAhead;
+
 /** A generic interface for video decoders. */
 class VideoDecoder : public Graphics::GLContainer, public Graphics::Renderable {
 public:
@@ -66,6 +68,17 @@ public:
 
 	void setScale(Scale scale);
 
+	/** Decode this many frames ahead of time, on the thread pool.
+	 *
+	 *  Without decoding ahead (frameCount == 0, the default), each frame is
+	 *  decoded on the render thread once it is due. With decoding ahead, the
+	 *  video frames are decoded and the audio buffered on the thread pool,
+	 *  and the render thread only shows the frames that are due.
+	 *
+	 *  Has to be set before the video is started.
+	 */
+	void setDecodeAhead(size_t frameCount);
+
 	/** Is the video currently playing? */
 	bool isPlaying() const;
 
@@ -97,6 +110,13 @@ public:
 	/** Abort the playing of the video. */
 	void abort();
 
+	/** Stop decoding frames ahead of time, waiting for the frame currently being decoded.
+	 *
+	 *  The decoding calls into the subclass, so every subclass has to call
+	 *  this first thing in its destructor.
+	 */
+	void stopDecodeAhead();
+
 	/**
 	 * Check whether a new frame should be decoded, i.e. because enough
 	 * time has elapsed since the last frame was decoded.
@@ -392,6 +412,9 @@ protected:
 
 	Common::ScopedPtr<Graphics::Surface> _surface; ///< The video's surface.
 
+	/** Update the video, if necessary. */
+	void update();
+
 	/**
 	 * Create a surface for video of these dimensions.
 	 *
@@ -487,17 +510,30 @@ private:
 	/** The start time of the video, or -1 for not set */
 	uint32 _startTime;
 
+	/** Number of frames to decode ahead; 0 to decode each frame when it is due. */
+	size_t _decodeAheadFrames;
+	/** The frames decoded ahead, if decoding ahead. */
+	Common::ScopedPtr<DecodeAhead> _decodeAhead;
+
 	/** The pause level of the video; 0 for not paused. */
 	uint32 _pauseLevel;
 
 	/** The time when the track was first paused. */
 	uint32 _pauseStartTime;
 
-	/** Update the video, if necessary. */
-	void update();
-
 	/** Copy the video image data to the texture. */
 	void copyData();
+	/** Copy the image data of this surface to the texture. */
+	void copyData(const Graphics::Surface &surface);
+
+	/** Has this track finished, as far as displaying it is concerned? */
+	bool hasTrackEnded(const Track &track) const;
+
+	/** Make sure all audio tracks are buffered up to the next video frame. */
+	void bufferAudio();
+
+	/** Decode the next video frame into this surface. Called by the decode ahead worker. */
+	bool decodeAheadFrame(Graphics::Surface &surface, uint32 &time);
 
 	/** Get the dimensions of the quad to draw the texture on. */
 	void getQuadDimensions(float &width, float &height) const;
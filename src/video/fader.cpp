@@ -37,6 +37,10 @@ Fader::Fader(uint32 width, uint32 height, int n) {
 	initVideo();
 }
 
+Fader::~Fader() {
+	stopDecodeAhead();
+}
+
 void Fader::decodeNextTrackFrame(VideoTrack &track) {
 	assert(_surface);
 	static_cast<FaderVideoTrack &>(track).drawFrame(*_surface);
@@ -35,6 +35,7 @@ namespace Video {
 class Fader : public VideoDecoder {
 public:
 	Fader(uint32 width, uint32 height, int n);
+	~Fader();
 
 protected:
 	void decodeNextTrackFrame(VideoTrack &track);
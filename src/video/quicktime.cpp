@@ -105,6 +105,7 @@ QuickTimeDecoder::QuickTimeDecoder(Common::SeekableReadStream *stream) : _fd(str
 }
 
 QuickTimeDecoder::~QuickTimeDecoder() {
+	stopDecodeAhead();
 }
 
 void QuickTimeDecoder::load() {
@@ -24,8 +24,10 @@ src_video_libvideo_la_SOURCES =
 
 src_video_libvideo_la_SOURCES += \
     src/video/decoder.h \
+    src/video/decodeahead.h \
     src/video/bink.h \
     src/video/binkdata.h \
+    src/video/binkdsp.h \
     src/video/fader.h \
     src/video/quicktime.h \
     src/video/xmv.h \
@@ -34,7 +36,9 @@ src_video_libvideo_la_SOURCES += \
 
 src_video_libvideo_la_SOURCES += \
     src/video/decoder.cpp \
+    src/video/decodeahead.cpp \
     src/video/bink.cpp \
+    src/video/binkdsp.cpp \
     src/video/fader.cpp \
     src/video/quicktime.cpp \
     src/video/xmv.cpp \
@@ -59,6 +59,7 @@ XboxMediaVideo::XboxMediaVideo(Common::SeekableReadStream *xmv) :
 }
 
 XboxMediaVideo::~XboxMediaVideo() {
+	stopDecodeAhead();
 }
 
 void XboxMediaVideo::queueNewAudio(PacketAudio &audioPacket) {
@@ -38,6 +38,7 @@
 #include "src/common/platform.h"
 #include "src/common/filepath.h"
 #include "src/common/threads.h"
+#include "src/common/threadpool.h"
 #include "src/common/debugman.h"
 #include "src/common/configman.h"
 #include "src/common/random.h"
@@ -53,6 +54,8 @@
 
 #include "src/aurora/nwscript/objectman.h"
 #include "src/aurora/nwscript/functionman.h"
+#include "src/aurora/nwscript/ncsreg.h"
+#include "src/aurora/nwscript/ncsfile.h"
 
 #include "src/graphics/queueman.h"
 #include "src/graphics/graphics.h"
@@ -274,6 +277,14 @@ static void initConfig() {
 	ConfigMan.setBool(Common::kConfigRealmDefault, "showfps", false);
 
 	ConfigMan.setBool(Common::kConfigRealmDefault, "skipvideos", false);
+	ConfigMan.setInt (Common::kConfigRealmDefault, "videodecodeahead", 0);
+
+	ConfigMan.setInt(Common::kConfigRealmDefault, "textureimagebudget", 256);
+
+	ConfigMan.setBool(Common::kConfigRealmDefault, "threadedscripts", false);
+
+	ConfigMan.setBool(Common::kConfigRealmDefault, "resourcecache", true);
+	ConfigMan.setInt (Common::kConfigRealmDefault, "decompressedcache", 0);
 
 	ConfigMan.setBool(Common::kConfigRealmDefault, "saveconf", true);
 
@@ -304,6 +315,9 @@ static void init() {
 	// Init threading system
 	Common::initThreads();
 
+	// Create the worker threads shared by all subsystems
+	status("Thread pool with %u workers initialized", (uint) ThreadPoolMan.getThreadCount());
+
 #ifdef ENABLE_XML
 	// Init libxml2
 	Common::initXML();
@@ -316,6 +330,20 @@ static void init() {
 	status("Sound subsystem initialized");
 	EventMan.init();
 	status("Event subsystem initialized");
+
+	// Cache the resource indices of the game archives
+	if (ConfigMan.getBool("resourcecache", true))
+		ResMan.setIndexCache(Common::FilePath::getUserDataFile("resourcecache"),
+		                     ConfigMan.getBool("rebuild-resource-cache", false));
+
+	// Keep recently read decompressed resources in memory
+	const int decompressedCache = ConfigMan.getInt("decompressedcache", 0);
+	if (decompressedCache > 0)
+		ResMan.setDecompressedCacheBudget(((size_t) decompressedCache) * 1024 * 1024);
+
+	// Select the engine running the game scripts
+	if (ConfigMan.getBool("threadedscripts", false))
+		Aurora::NWScript::NCSFile::setDefaultEngine(Aurora::NWScript::NCSFile::kEngineThreaded);
 }
 
 static void deinit() {
@@ -329,6 +357,9 @@ static void deinit() {
 	} catch (...) {
 	}
 
+	// Finish the remaining background work while the subsystems still exist
+	Common::ThreadPool::destroy();
+
 #ifdef ENABLE_XML
 	// Deinit libxml2
 	Common::deinitXML();
@@ -345,6 +376,7 @@ static void deinit() {
 	Aurora::ResourceManager::destroy();
 	Aurora::FileTypeManager::destroy();
 
+	Aurora::NWScript::NCSRegistry::destroy();
 	Aurora::NWScript::ObjectManager::destroy();
 	Aurora::NWScript::FunctionManager::destroy();
 
@@ -22,6 +22,8 @@
  *  Unit tests for our TwoDAFile class.
  */
 
+#include <cstdio>
+#include <chrono>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -707,3 +709,122 @@ GTEST_TEST(TwoDAFile, fromGDA) {
 		for (size_t j = 0; j < 3; j++)
 			EXPECT_EQ(twoda.getRow(j).getInt(i), j);
 }
+
+// --- 2DA, large synthetic ---
+
+/** Create an ASCII 2DA with a unique label column, followed by alternating int, float and string columns. */
+static Common::UString createLarge2DA(size_t rowCount, size_t columnCount) {
+	Common::UString twoda = "2DA V2.0\n\nLabel";
+
+	for (size_t j = 1; j < columnCount; j++)
+		twoda += Common::UString::format(" Column%u", (uint) j);
+	twoda += "\n";
+
+	for (size_t i = 0; i < rowCount; i++) {
+		twoda += Common::UString::format("%u Row%u", (uint) i, (uint) i);
+
+		for (size_t j = 1; j < columnCount; j++) {
+			if (((i + j) % 7) == 0)
+				twoda += " ****";
+			else if ((j % 3) == 1)
+				twoda += Common::UString::format(" %d", (int) ((i * j) % 1000) - 500);
+			else if ((j % 3) == 2)
+				twoda += Common::UString::format(" %.2f", ((i + j) % 100) * 0.25f);
+			else
+				twoda += Common::UString::format(" str%u", (uint) ((i + j) % 50));
+		}
+
+		twoda += "\n";
+	}
+
+	return twoda;
+}
+
+GTEST_TEST(TwoDAFile, largeSynthetic) {
+	static const size_t kRowCount    = 500;
+	static const size_t kColumnCount = 12;
+
+	const Common::UString data = createLarge2DA(kRowCount, kColumnCount);
+
+	Common::MemoryReadStream stream(data.c_str());
+	const Aurora::TwoDAFile twoda(stream);
+
+	ASSERT_EQ(twoda.getRowCount(), kRowCount);
+	ASSERT_EQ(twoda.getColumnCount(), kColumnCount);
+
+	for (size_t i = 0; i < kRowCount; i++) {
+		const Aurora::TwoDARow &row = twoda.getRow(i);
+
+		EXPECT_STREQ(row.getString("Label").c_str(), Common::UString::format("Row%u", (uint) i).c_str());
+		EXPECT_EQ(&twoda.getRow("Label", Common::UString::format("rOW%u", (uint) i)), &row);
+
+		for (size_t j = 1; j < kColumnCount; j++) {
+			if (((i + j) % 7) == 0) {
+				EXPECT_TRUE(row.empty(j)) << i << "." << j;
+				EXPECT_EQ(row.getInt(j), 0) << i << "." << j;
+				EXPECT_STREQ(row.getString(j).c_str(), "") << i << "." << j;
+				continue;
+			}
+
+			EXPECT_FALSE(row.empty(j)) << i << "." << j;
+
+			if ((j % 3) == 1)
+				EXPECT_EQ(row.getInt(j), (int) ((i * j) % 1000) - 500) << i << "." << j;
+			else if ((j % 3) == 2)
+				EXPECT_FLOAT_EQ(row.getFloat(j), ((i + j) % 100) * 0.25f) << i << "." << j;
+			else
+				EXPECT_STREQ(row.getString(j).c_str(), Common::UString::format("str%u", (uint) ((i + j) % 50)).c_str());
+		}
+	}
+
+	// The first row with a value is found, and empty cells match the default string
+	EXPECT_EQ(&twoda.getRow("Column3", "str4"), &twoda.getRow(1));
+	EXPECT_EQ(&twoda.getRow("Column1", ""), &twoda.getRow(6));
+}
+
+/** Measure and print how fast a 2DA with 10000 rows and 100 columns is parsed and queried. */
+GTEST_TEST(TwoDAFile, DISABLED_throughput) {
+	static const size_t kRowCount    = 10000;
+	static const size_t kColumnCount = 100;
+
+	const Common::UString data = createLarge2DA(kRowCount, kColumnCount);
+
+	const auto start = std::chrono::steady_clock::now();
+
+	Common::MemoryReadStream stream(data.c_str());
+	const Aurora::TwoDAFile twoda(stream);
+
+	const auto loaded = std::chrono::steady_clock::now();
+
+	int64 sumInt = 0;
+	double sumFloat = 0.0;
+	for (size_t i = 0; i < kRowCount; i++) {
+		const Aurora::TwoDARow &row = twoda.getRow(i);
+
+		for (size_t j = 1; j < kColumnCount; j += 3) {
+			sumInt   += row.getInt(j);
+			sumFloat += row.getFloat(j + 1);
+		}
+	}
+
+	const auto queriedValues = std::chrono::steady_clock::now();
+
+	size_t found = 0;
+	for (size_t i = 0; i < kRowCount; i += 10)
+		found += twoda.getRow("Label", Common::UString::format("Row%u", (uint) i)).empty(0) ? 0 : 1;
+
+	const auto queriedRows = std::chrono::steady_clock::now();
+
+	EXPECT_NE(sumInt, 0);
+	EXPECT_GT(sumFloat, 0.0);
+	EXPECT_EQ(found, kRowCount / 10);
+
+	const std::chrono::duration<double> loadTime  = loaded        - start;
+	const std::chrono::duration<double> valueTime = queriedValues - loaded;
+	const std::chrono::duration<double> rowTime   = queriedRows   - queriedValues;
+
+	std::printf("2DA with %u rows, %u columns: load %.1f ms, %u int/float reads %.1f ms, %u row lookups %.1f ms\n",
+	            (uint) kRowCount, (uint) kColumnCount, loadTime.count() * 1000.0,
+	            (uint) (kRowCount * 2 * ((kColumnCount + 1) / 3)), valueTime.count() * 1000.0,
+	            (uint) (kRowCount / 10), rowTime.count() * 1000.0);
+}
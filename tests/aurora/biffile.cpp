@@ -22,10 +22,15 @@
  *  Unit tests for our BIF file archive class.
  */
 
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
 #include "gtest/gtest.h"
 
 #include "src/common/error.h"
+#include "src/common/scopedptr.h"
 #include "src/common/memreadstream.h"
+#include "src/common/mappedfile.h"
 
 #include "src/aurora/biffile.h"
 #include "src/aurora/keyfile.h"
@@ -161,6 +166,32 @@ GTEST_TEST(BIFFile10, getResource) {
 	delete file;
 }
 
+GTEST_TEST(BIFFile10, getResourceMapped) {
+	const boost::filesystem::path path = boost::filesystem::temp_directory_path() /
+	                                     boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+	boost::filesystem::ofstream bifFile(path, std::ofstream::binary);
+	bifFile.write(reinterpret_cast<const char *>(kBIF10File), sizeof(kBIF10File));
+	bifFile.close();
+
+	Common::ScopedPtr<Aurora::BIFFile> bif(new Aurora::BIFFile(new Common::MappedReadStream(path.generic_string())));
+
+	Common::ScopedPtr<Common::SeekableReadStream> file(bif->getResource(0));
+	ASSERT_TRUE(file);
+
+	// The resource is a view into the mapping, and stays valid without the BIF
+	EXPECT_TRUE(dynamic_cast<Common::MappedReadStream *>(file.get()) != 0);
+	bif.reset();
+
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	file.reset();
+	boost::filesystem::remove(path);
+}
+
 GTEST_TEST(BIFFile10, mergeKEY) {
 	Common::MemoryReadStream *stream = new Common::MemoryReadStream(kBIF10File);
 	Aurora::BIFFile bif(stream);
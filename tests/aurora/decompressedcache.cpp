@@ -0,0 +1,172 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our cache of decompressed archive resources.
+ */
+
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/scopedptr.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/decompressedcache.h"
+
+/** Distinct archive addresses to key the cache with. The archives are never used. */
+static const Aurora::Archive *getArchive(size_t i) {
+	static const byte kArchives[4] = { 0 };
+
+	return reinterpret_cast<const Aurora::Archive *>(&kArchives[i]);
+}
+
+/** A stream of size bytes, all with the same value. */
+static Common::SeekableReadStream *createStream(byte value, size_t size) {
+	byte *data = new byte[size];
+	std::memset(data, value, size);
+
+	return new Common::MemoryReadStream(data, size, true);
+}
+
+static bool checkStream(Common::SeekableReadStream *stream, byte value, size_t size) {
+	Common::ScopedPtr<Common::SeekableReadStream> s(stream);
+	if (!s || (s->size() != size))
+		return false;
+
+	for (size_t i = 0; i < size; i++)
+		if (s->readByte() != value)
+			return false;
+
+	return true;
+}
+
+GTEST_TEST(DecompressedCache, disabled) {
+	Aurora::DecompressedCache cache;
+
+	Common::SeekableReadStream *stream = createStream(1, 16);
+	Common::SeekableReadStream *added  = cache.add(getArchive(0), 0, stream);
+
+	// Without a budget, the stream is handed back as it is
+	EXPECT_EQ(added, stream);
+	delete added;
+
+	EXPECT_EQ(cache.get(getArchive(0), 0), static_cast<Common::SeekableReadStream *>(0));
+	EXPECT_EQ(cache.getStatistics().count, 0);
+}
+
+GTEST_TEST(DecompressedCache, getAdd) {
+	Aurora::DecompressedCache cache;
+	cache.setBudget(1024);
+
+	EXPECT_EQ(cache.get(getArchive(0), 5), static_cast<Common::SeekableReadStream *>(0));
+	EXPECT_TRUE(checkStream(cache.add(getArchive(0), 5, createStream(5, 100)), 5, 100));
+	EXPECT_TRUE(checkStream(cache.add(getArchive(1), 5, createStream(6, 50)), 6, 50));
+
+	EXPECT_TRUE(checkStream(cache.get(getArchive(0), 5), 5, 100));
+	EXPECT_TRUE(checkStream(cache.get(getArchive(1), 5), 6, 50));
+	EXPECT_TRUE(checkStream(cache.get(getArchive(0), 5), 5, 100));
+
+	const Aurora::DecompressedCache::Statistics stats = cache.getStatistics();
+	EXPECT_EQ(stats.hits     , 3);
+	EXPECT_EQ(stats.misses   , 1);
+	EXPECT_EQ(stats.evictions, 0);
+	EXPECT_EQ(stats.count    , 2);
+	EXPECT_EQ(stats.size     , 150);
+	EXPECT_EQ(stats.budget   , 1024);
+}
+
+GTEST_TEST(DecompressedCache, addExisting) {
+	Aurora::DecompressedCache cache;
+	cache.setBudget(1024);
+
+	EXPECT_TRUE(checkStream(cache.add(getArchive(0), 0, createStream(1, 100)), 1, 100));
+
+	// The data already in the cache wins
+	EXPECT_TRUE(checkStream(cache.add(getArchive(0), 0, createStream(2, 100)), 1, 100));
+
+	EXPECT_EQ(cache.getStatistics().count, 1);
+	EXPECT_EQ(cache.getStatistics().size , 100);
+}
+
+GTEST_TEST(DecompressedCache, evict) {
+	Aurora::DecompressedCache cache;
+	cache.setBudget(100);
+
+	delete cache.add(getArchive(0), 0, createStream(0, 40));
+	delete cache.add(getArchive(0), 1, createStream(1, 40));
+
+	// Use the first one, so that the second one is the least recently used
+	delete cache.get(getArchive(0), 0);
+
+	delete cache.add(getArchive(0), 2, createStream(2, 40));
+
+	EXPECT_TRUE(checkStream(cache.get(getArchive(0), 0), 0, 40));
+	EXPECT_EQ(cache.get(getArchive(0), 1), static_cast<Common::SeekableReadStream *>(0));
+	EXPECT_TRUE(checkStream(cache.get(getArchive(0), 2), 2, 40));
+
+	EXPECT_EQ(cache.getStatistics().evictions, 1);
+	EXPECT_EQ(cache.getStatistics().size     , 80);
+
+	// Lowering the budget evicts right away
+	cache.setBudget(50);
+	EXPECT_EQ(cache.getStatistics().count, 1);
+	EXPECT_TRUE(checkStream(cache.get(getArchive(0), 2), 2, 40));
+}
+
+GTEST_TEST(DecompressedCache, tooLarge) {
+	Aurora::DecompressedCache cache;
+	cache.setBudget(100);
+
+	EXPECT_TRUE(checkStream(cache.add(getArchive(0), 0, createStream(3, 101)), 3, 101));
+	EXPECT_EQ(cache.getStatistics().count, 0);
+}
+
+GTEST_TEST(DecompressedCache, streamOutlivesData) {
+	Aurora::DecompressedCache cache;
+	cache.setBudget(100);
+
+	Common::SeekableReadStream *stream = cache.add(getArchive(0), 0, createStream(7, 60));
+
+	// Evict the data the stream reads from, and then throw everything away
+	delete cache.add(getArchive(0), 1, createStream(8, 60));
+	cache.clear();
+
+	EXPECT_TRUE(checkStream(stream, 7, 60));
+}
+
+GTEST_TEST(DecompressedCache, remove) {
+	Aurora::DecompressedCache cache;
+	cache.setBudget(1024);
+
+	delete cache.add(getArchive(0), 0, createStream(0, 10));
+	delete cache.add(getArchive(1), 0, createStream(1, 10));
+	delete cache.add(getArchive(0), 1, createStream(2, 10));
+
+	cache.remove(getArchive(0));
+
+	EXPECT_EQ(cache.get(getArchive(0), 0), static_cast<Common::SeekableReadStream *>(0));
+	EXPECT_EQ(cache.get(getArchive(0), 1), static_cast<Common::SeekableReadStream *>(0));
+	EXPECT_TRUE(checkStream(cache.get(getArchive(1), 0), 1, 10));
+
+	EXPECT_EQ(cache.getStatistics().count, 1);
+	EXPECT_EQ(cache.getStatistics().size , 10);
+}
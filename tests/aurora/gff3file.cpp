@@ -22,17 +22,24 @@
  *  Unit tests for our GFF3 file reader class.
  */
 
+#include <cstdio>
+#include <chrono>
 #include <vector>
+#include <thread>
+#include <atomic>
 
 #include "gtest/gtest.h"
 
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+#include "src/common/readstream.h"
 
 #include "src/aurora/locstring.h"
 #include "src/aurora/language.h"
 #include "src/aurora/gff3file.h"
+#include "src/aurora/gff3writer.h"
 
 // --- GFF3, single struct ---
 
@@ -165,6 +172,47 @@ GTEST_TEST(GFF3Struct, getFieldType) {
 		EXPECT_EQ(strct.getFieldType(kFieldNamesSingle[i]), kFieldTypesSingle[i]) << "At index " << i;
 }
 
+GTEST_TEST(GFF3Struct, getLabelID) {
+	Aurora::GFF3File gff3(new Common::MemoryReadStream(kGFF3SingleStruct));
+	const Aurora::GFF3Struct &strct = gff3.getTopLevel();
+
+	for (size_t i = 0; i < ARRAYSIZE(kFieldNamesSingle); i++) {
+		const uint32 id = gff3.getLabelID(kFieldNamesSingle[i]);
+
+		ASSERT_NE(id, Aurora::GFF3File::kLabelNone) << "At index " << i;
+		EXPECT_EQ(strct.getLabelID(kFieldNamesSingle[i]), id) << "At index " << i;
+		EXPECT_STREQ(gff3.getLabel(id).c_str(), kFieldNamesSingle[i]) << "At index " << i;
+
+		EXPECT_TRUE(strct.hasField(id)) << "At index " << i;
+		EXPECT_EQ(strct.getFieldType(id), kFieldTypesSingle[i]) << "At index " << i;
+	}
+
+	EXPECT_EQ(gff3.getLabelID("Nope"), Aurora::GFF3File::kLabelNone);
+	EXPECT_FALSE(strct.hasField(Aurora::GFF3File::kLabelNone));
+	EXPECT_EQ(strct.getFieldType(Aurora::GFF3File::kLabelNone), Aurora::GFF3Struct::kFieldTypeNone);
+
+	EXPECT_THROW(gff3.getLabel(ARRAYSIZE(kFieldNamesSingle)), Common::Exception);
+}
+
+GTEST_TEST(GFF3Struct, getByLabelID) {
+	Aurora::GFF3File gff3(new Common::MemoryReadStream(kGFF3SingleStruct));
+	const Aurora::GFF3Struct &strct = gff3.getTopLevel();
+
+	EXPECT_EQ(strct.getChar(gff3.getLabelID("FieldChar")), 'x');
+	EXPECT_EQ(strct.getUint(gff3.getLabelID("FieldUint32")), strct.getUint("FieldUint32"));
+	EXPECT_EQ(strct.getSint(gff3.getLabelID("FieldSint32")), strct.getSint("FieldSint32"));
+	EXPECT_EQ(strct.getDouble(gff3.getLabelID("FieldDouble")), strct.getDouble("FieldDouble"));
+
+	EXPECT_STREQ(strct.getString(gff3.getLabelID("FieldExoString")).c_str(), strct.getString("FieldExoString").c_str());
+	EXPECT_STREQ(strct.getString(gff3.getLabelID("FieldResRef")).c_str(), strct.getString("FieldResRef").c_str());
+
+	EXPECT_EQ(strct.getUint(Aurora::GFF3File::kLabelNone, 23), 23);
+	EXPECT_STREQ(strct.getString(Aurora::GFF3File::kLabelNone, "Nope").c_str(), "Nope");
+
+	EXPECT_THROW(strct.getChar(gff3.getLabelID("FieldLocString")), Common::Exception);
+	EXPECT_THROW(strct.getStruct(Aurora::GFF3File::kLabelNone), Common::Exception);
+}
+
 GTEST_TEST(GFF3Struct, getChar) {
 	Aurora::GFF3File gff3(new Common::MemoryReadStream(kGFF3SingleStruct));
 	const Aurora::GFF3Struct &strct = gff3.getTopLevel();
@@ -654,3 +702,252 @@ GTEST_TEST(GFF3File, GFF3V33) {
 	EXPECT_EQ(strct.getID(), 23);
 	EXPECT_EQ(strct.getUint("FieldUint32"), 32);
 }
+
+// --- Large synthetic GFF3 ---
+
+struct SyntheticField {
+	const char *label;
+	Aurora::GFF3Struct::FieldType type;
+};
+
+static const SyntheticField kSyntheticFields[] = {
+	{ "Tag"             , Aurora::GFF3Struct::kFieldTypeExoString },
+	{ "TemplateResRef"  , Aurora::GFF3Struct::kFieldTypeResRef    },
+	{ "Appearance_Type" , Aurora::GFF3Struct::kFieldTypeUint16    },
+	{ "CurrentHitPoints", Aurora::GFF3Struct::kFieldTypeSint16    },
+	{ "XPosition"       , Aurora::GFF3Struct::kFieldTypeFloat     },
+	{ "YPosition"       , Aurora::GFF3Struct::kFieldTypeFloat     },
+	{ "ZPosition"       , Aurora::GFF3Struct::kFieldTypeFloat     },
+	{ "XOrientation"    , Aurora::GFF3Struct::kFieldTypeFloat     },
+	{ "YOrientation"    , Aurora::GFF3Struct::kFieldTypeFloat     },
+	{ "Str"             , Aurora::GFF3Struct::kFieldTypeByte      },
+	{ "Dex"             , Aurora::GFF3Struct::kFieldTypeByte      },
+	{ "Con"             , Aurora::GFF3Struct::kFieldTypeByte      },
+	{ "Int"             , Aurora::GFF3Struct::kFieldTypeByte      },
+	{ "Wis"             , Aurora::GFF3Struct::kFieldTypeByte      },
+	{ "Cha"             , Aurora::GFF3Struct::kFieldTypeByte      },
+	{ "FactionID"       , Aurora::GFF3Struct::kFieldTypeUint32    }
+};
+
+/** Write a GFF3 resembling an area GIT: a top-level struct with a list of many creature-like structs.
+ *
+ *  GFF3Writer deduplicates field values with linear searches, which is far too slow for this
+ *  many fields, so we lay out the sections ourselves.
+ */
+static Common::MemoryWriteStreamDynamic *createLargeGFF3(uint32 structCount) {
+	const uint32 fieldsPerStruct = ARRAYSIZE(kSyntheticFields);
+
+	Common::MemoryWriteStreamDynamic fieldData(true), fields(true);
+
+	// The top-level struct's only field is the list
+	fields.writeUint32LE(Aurora::GFF3Struct::kFieldTypeList);
+	fields.writeUint32LE(0);
+	fields.writeUint32LE(0);
+
+	for (uint32 i = 0; i < structCount; i++) {
+		for (uint32 j = 0; j < fieldsPerStruct; j++) {
+			fields.writeUint32LE(kSyntheticFields[j].type);
+			fields.writeUint32LE(j + 1);
+
+			if        (kSyntheticFields[j].type == Aurora::GFF3Struct::kFieldTypeExoString) {
+				const Common::UString tag = Common::UString::format("creature%u", i);
+
+				fields.writeUint32LE(fieldData.size());
+				fieldData.writeUint32LE(tag.size());
+				fieldData.writeString(tag);
+
+			} else if (kSyntheticFields[j].type == Aurora::GFF3Struct::kFieldTypeResRef) {
+				const Common::UString resRef = Common::UString::format("c_%u", i % 100);
+
+				fields.writeUint32LE(fieldData.size());
+				fieldData.writeByte(resRef.size());
+				fieldData.writeString(resRef);
+
+			} else if (kSyntheticFields[j].type == Aurora::GFF3Struct::kFieldTypeFloat) {
+				fields.writeIEEEFloatLE(i * (j + 1) * 0.25f);
+			} else
+				fields.writeUint32LE((i + j) % 200);
+		}
+	}
+
+	const uint32 labelCount        = fieldsPerStruct + 1;
+	const uint32 fieldCount        = fieldsPerStruct * structCount + 1;
+	const uint32 fieldIndicesCount = fieldsPerStruct * structCount * 4;
+	const uint32 listIndicesCount  = (structCount + 1) * 4;
+
+	const uint32 structOffset       = 56;
+	const uint32 fieldOffset        = structOffset + (structCount + 1) * 12;
+	const uint32 labelOffset        = fieldOffset + fieldCount * 12;
+	const uint32 fieldDataOffset    = labelOffset + labelCount * 16;
+	const uint32 fieldIndicesOffset = fieldDataOffset + fieldData.size();
+	const uint32 listIndicesOffset  = fieldIndicesOffset + fieldIndicesCount;
+
+	Common::MemoryWriteStreamDynamic *gff3 = new Common::MemoryWriteStreamDynamic(true);
+
+	gff3->writeUint32BE(MKTAG('G', 'I', 'T', ' '));
+	gff3->writeUint32BE(MKTAG('V', '3', '.', '2'));
+
+	gff3->writeUint32LE(structOffset);
+	gff3->writeUint32LE(structCount + 1);
+	gff3->writeUint32LE(fieldOffset);
+	gff3->writeUint32LE(fieldCount);
+	gff3->writeUint32LE(labelOffset);
+	gff3->writeUint32LE(labelCount);
+	gff3->writeUint32LE(fieldDataOffset);
+	gff3->writeUint32LE(fieldData.size());
+	gff3->writeUint32LE(fieldIndicesOffset);
+	gff3->writeUint32LE(fieldIndicesCount);
+	gff3->writeUint32LE(listIndicesOffset);
+	gff3->writeUint32LE(listIndicesCount);
+
+	gff3->writeUint32LE(0xFFFFFFFF);
+	gff3->writeUint32LE(0);
+	gff3->writeUint32LE(1);
+
+	for (uint32 i = 0; i < structCount; i++) {
+		gff3->writeUint32LE(i);
+		gff3->writeUint32LE(i * fieldsPerStruct * 4);
+		gff3->writeUint32LE(fieldsPerStruct);
+	}
+
+	gff3->write(fields.getData(), fields.size());
+
+	gff3->writeString("Creature List");
+	gff3->writeZeros(3);
+	for (uint32 j = 0; j < fieldsPerStruct; j++) {
+		gff3->writeString(kSyntheticFields[j].label);
+		gff3->writeZeros(16 - strlen(kSyntheticFields[j].label));
+	}
+
+	gff3->write(fieldData.getData(), fieldData.size());
+
+	for (uint32 i = 0; i < fieldsPerStruct * structCount; i++)
+		gff3->writeUint32LE(i + 1);
+
+	gff3->writeUint32LE(structCount);
+	for (uint32 i = 0; i < structCount; i++)
+		gff3->writeUint32LE(i + 1);
+
+	return gff3;
+}
+
+GTEST_TEST(GFF3File, largeSynthetic) {
+	static const uint32 kStructCount = 2000;
+
+	Common::ScopedPtr<Common::MemoryWriteStreamDynamic> data(createLargeGFF3(kStructCount));
+	Aurora::GFF3File gff3(new Common::MemoryReadStream(data->getData(), data->size()));
+
+	const Aurora::GFF3List &list = gff3.getTopLevel().getList("Creature List");
+	ASSERT_EQ(list.size(), kStructCount);
+
+	for (size_t i = 0; i < kStructCount; i += 97) {
+		const Aurora::GFF3Struct &strct = *list[i];
+
+		EXPECT_EQ(strct.getID(), i) << i;
+		EXPECT_EQ(strct.getFieldCount(), ARRAYSIZE(kSyntheticFields)) << i;
+
+		EXPECT_STREQ(strct.getString("Tag").c_str(), Common::UString::format("creature%u", (uint) i).c_str()) << i;
+		EXPECT_STREQ(strct.getString("TemplateResRef").c_str(), Common::UString::format("c_%u", (uint) (i % 100)).c_str()) << i;
+
+		EXPECT_EQ(strct.getUint("Appearance_Type"), (i + 2) % 200) << i;
+		EXPECT_EQ(strct.getSint("CurrentHitPoints"), (int64) ((i + 3) % 200)) << i;
+		EXPECT_FLOAT_EQ(strct.getDouble("XPosition"), i * 5 * 0.25f) << i;
+		EXPECT_EQ(strct.getUint("FactionID"), (i + 15) % 200) << i;
+	}
+}
+
+GTEST_TEST(GFF3File, nonMemoryStream) {
+	// A stream that isn't held in memory yet is read into memory completely
+	Common::MemoryReadStream *data = new Common::MemoryReadStream(kGFF3SingleStruct);
+	Aurora::GFF3File gff3(new Common::SeekableSubReadStream(data, 0, data->size(), true));
+
+	const Aurora::GFF3Struct &strct = gff3.getTopLevel();
+
+	EXPECT_EQ(strct.getUint("FieldUint64"), 42);
+	EXPECT_DOUBLE_EQ(strct.getDouble("FieldDouble"), 25.6);
+	EXPECT_STREQ(strct.getString("FieldExoString").c_str(), "Foobar");
+}
+
+/** A reader thread, checking the fields of every nth struct in the list. */
+static void readStructs(const Aurora::GFF3List *list, size_t first, size_t step,
+                        std::atomic<size_t> *failures) {
+
+	for (size_t n = 0; n < 20; n++) {
+		for (size_t i = first; i < list->size(); i += step) {
+			const Aurora::GFF3Struct &strct = *(*list)[i];
+
+			if (strct.getString("Tag") != Common::UString::format("creature%u", (uint) i))
+				(*failures)++;
+			if (strct.getString("TemplateResRef") != Common::UString::format("c_%u", (uint) (i % 100)))
+				(*failures)++;
+			if (strct.getUint("Appearance_Type") != ((i + 2) % 200))
+				(*failures)++;
+			if (strct.getDouble("XPosition") != (i * 5 * 0.25f))
+				(*failures)++;
+		}
+	}
+}
+
+GTEST_TEST(GFF3File, concurrentReads) {
+	static const uint32 kStructCount = 2000;
+	static const size_t kThreadCount = 4;
+
+	Common::ScopedPtr<Common::MemoryWriteStreamDynamic> data(createLargeGFF3(kStructCount));
+	Aurora::GFF3File gff3(new Common::MemoryReadStream(data->getData(), data->size()));
+
+	const Aurora::GFF3List &list = gff3.getTopLevel().getList("Creature List");
+	ASSERT_EQ(list.size(), kStructCount);
+
+	std::atomic<size_t> failures(0);
+
+	// All threads read interleaved structs, so they constantly hit neighbouring field data
+	std::vector<std::thread> readers;
+	for (size_t i = 0; i < kThreadCount; i++)
+		readers.push_back(std::thread(readStructs, &list, i, kThreadCount - 1, &failures));
+
+	for (std::vector<std::thread>::iterator r = readers.begin(); r != readers.end(); ++r)
+		r->join();
+
+	EXPECT_EQ(failures, 0);
+}
+
+/** Measure and print how fast a GIT-like GFF3 with 50000 structs is parsed and queried. */
+GTEST_TEST(GFF3File, DISABLED_throughput) {
+	static const uint32 kStructCount = 50000;
+
+	Common::ScopedPtr<Common::MemoryWriteStreamDynamic> data(createLargeGFF3(kStructCount));
+
+	const auto start = std::chrono::steady_clock::now();
+
+	Aurora::GFF3File gff3(new Common::MemoryReadStream(data->getData(), data->size()));
+	const Aurora::GFF3List &list = gff3.getTopLevel().getList("Creature List");
+
+	const auto loaded = std::chrono::steady_clock::now();
+
+	uint64 sumByName = 0;
+	for (Aurora::GFF3List::const_iterator s = list.begin(); s != list.end(); ++s)
+		sumByName += (*s)->getUint("Appearance_Type") + (*s)->getUint("FactionID") + (*s)->getUint("Str");
+
+	const auto queriedByName = std::chrono::steady_clock::now();
+
+	const uint32 appearance = gff3.getLabelID("Appearance_Type");
+	const uint32 faction    = gff3.getLabelID("FactionID");
+	const uint32 strength   = gff3.getLabelID("Str");
+
+	uint64 sumByID = 0;
+	for (Aurora::GFF3List::const_iterator s = list.begin(); s != list.end(); ++s)
+		sumByID += (*s)->getUint(appearance) + (*s)->getUint(faction) + (*s)->getUint(strength);
+
+	const auto queriedByID = std::chrono::steady_clock::now();
+
+	EXPECT_GT(sumByName, 0U);
+	EXPECT_EQ(sumByName, sumByID);
+
+	const std::chrono::duration<double> loadTime  = loaded        - start;
+	const std::chrono::duration<double> nameTime  = queriedByName - loaded;
+	const std::chrono::duration<double> labelTime  = queriedByID   - queriedByName;
+
+	std::printf("GFF3 with %u structs: load %.1f ms, %u lookups by name %.1f ms, by label ID %.1f ms\n",
+	            kStructCount, loadTime.count() * 1000.0, (uint) (3 * list.size()),
+	            nameTime.count() * 1000.0, labelTime.count() * 1000.0);
+}
@@ -34,6 +34,8 @@
 
 #include <algorithm>
 #include <vector>
+#include <thread>
+#include <atomic>
 
 #include "gtest/gtest.h"
 
@@ -3200,6 +3202,39 @@ GTEST_TEST(GFF4StructGeneric, getGeneric) {
 	EXPECT_THROW(generic1->getGeneric(0), Common::Exception);
 }
 
+/** A reader thread, repeatedly reading values of all types from the same struct. */
+static void readSingleValues(const Aurora::GFF4Struct *strct, std::atomic<size_t> *failures) {
+	for (size_t i = 0; i < 2000; i++) {
+		if ((strct->getUint(256) != 23) || (strct->getSint(263) != -26))
+			(*failures)++;
+
+		if ((strct->getString(1024) != "Barfoo") || (strct->getString(1026) != "Foobar"))
+			(*failures)++;
+
+		std::vector<int64> list;
+		if (!strct->getSint(259, list) || (list.size() != 1) || (list[0] != -24))
+			(*failures)++;
+	}
+}
+
+GTEST_TEST(GFF4StructSingle, concurrentReads) {
+	static const size_t kThreadCount = 4;
+
+	Aurora::GFF4File gff4(new Common::MemoryReadStream(kGFF4SingleValues));
+	const Aurora::GFF4Struct &strct = gff4.getTopLevel();
+
+	std::atomic<size_t> failures(0);
+
+	std::vector<std::thread> readers;
+	for (size_t i = 0; i < kThreadCount; i++)
+		readers.push_back(std::thread(readSingleValues, &strct, &failures));
+
+	for (std::vector<std::thread>::iterator r = readers.begin(); r != readers.end(); ++r)
+		r->join();
+
+	EXPECT_EQ(failures, 0);
+}
+
 // --- GFF4, shared strings ---
 
 static const byte kGFF4Shared[] = {
@@ -0,0 +1,575 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our NCSProgram and NCSFile classes.
+ */
+
+#include <cstdlib>
+
+#include <list>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+#include "src/common/filelist.h"
+#include "src/common/filepath.h"
+
+#include "src/aurora/resman.h"
+
+#include "src/aurora/nwscript/ncsprogram.h"
+#include "src/aurora/nwscript/ncsfile.h"
+#include "src/aurora/nwscript/functionman.h"
+#include "src/aurora/nwscript/util.h"
+
+/* int sub(int arg) { if (arg > 3) return arg * 10; return -1; }
+ * int main() { return sub(5); } */
+static const byte kNCSSubroutine[] = {
+	0x4E, 0x43, 0x53, 0x20, 0x56, 0x31, 0x2E, 0x30, 0x42, 0x00, 0x00, 0x00, 0x6F,
+	0x02, 0x03,                                     //  13: RSADDI
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x05,             //  15: CONSTI 5
+	0x1E, 0x00, 0x00, 0x00, 0x00, 0x0E,             //  21: JSR 35
+	0x1B, 0x00, 0xFF, 0xFF, 0xFF, 0xFC,             //  27: MOVSP -4
+	0x20, 0x00,                                     //  33: RETN
+	0x03, 0x01, 0xFF, 0xFF, 0xFF, 0xFC, 0x00, 0x04, //  35: CPTOPSP -4, 4
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x03,             //  43: CONSTI 3
+	0x0E, 0x20,                                     //  49: GTII
+	0x1F, 0x00, 0x00, 0x00, 0x00, 0x26,             //  51: JZ 89
+	0x03, 0x01, 0xFF, 0xFF, 0xFF, 0xFC, 0x00, 0x04, //  57: CPTOPSP -4, 4
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x0A,             //  65: CONSTI 10
+	0x16, 0x20,                                     //  71: MULII
+	0x01, 0x01, 0xFF, 0xFF, 0xFF, 0xF4, 0x00, 0x04, //  73: CPDOWNSP -12, 4
+	0x1B, 0x00, 0xFF, 0xFF, 0xFF, 0xFC,             //  81: MOVSP -4
+	0x20, 0x00,                                     //  87: RETN
+	0x04, 0x03, 0xFF, 0xFF, 0xFF, 0xFF,             //  89: CONSTI -1
+	0x01, 0x01, 0xFF, 0xFF, 0xFF, 0xF4, 0x00, 0x04, //  95: CPDOWNSP -12, 4
+	0x1B, 0x00, 0xFF, 0xFF, 0xFF, 0xFC,             // 103: MOVSP -4
+	0x20, 0x00                                      // 109: RETN
+};
+
+/* string main() { return "foo" + "bar"; } */
+static const byte kNCSStrings[] = {
+	0x4E, 0x43, 0x53, 0x20, 0x56, 0x31, 0x2E, 0x30, 0x42, 0x00, 0x00, 0x00, 0x1F,
+	0x04, 0x05, 0x00, 0x03, 0x66, 0x6F, 0x6F,       //  13: CONSTS "foo"
+	0x04, 0x05, 0x00, 0x03, 0x62, 0x61, 0x72,       //  20: CONSTS "bar"
+	0x14, 0x23,                                     //  27: ADDSS
+	0x20, 0x00                                      //  29: RETN
+};
+
+/* Loops over globals and locals, vector arithmetic, engine function calls,
+ * string and struct comparisons, DESTRUCT, arrays and STORESTATE. */
+static const byte kNCSMixed[] = {
+	0x4E, 0x43, 0x53, 0x20, 0x56, 0x31, 0x2E, 0x30, 0x42, 0x00, 0x00, 0x01, 0x3B,
+	0x02, 0x03,                                     //  13: RSADDI
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x07,             //  15: CONSTI 7
+	0x01, 0x01, 0xFF, 0xFF, 0xFF, 0xF8, 0x00, 0x04, //  21: CPDOWNSP -8, 4
+	0x1B, 0x00, 0xFF, 0xFF, 0xFF, 0xFC,             //  29: MOVSP -4
+	0x2A, 0x00,                                     //  35: SAVEBP
+	0x02, 0x03,                                     //  37: RSADDI
+	0x03, 0x01, 0xFF, 0xFF, 0xFF, 0xFC, 0x00, 0x04, //  39: CPTOPSP -4, 4
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x05,             //  47: CONSTI 5
+	0x0F, 0x20,                                     //  53: LTII
+	0x1F, 0x00, 0x00, 0x00, 0x00, 0x30,             //  55: JZ 103
+	0x24, 0x03, 0xFF, 0xFF, 0xFF, 0xFC,             //  61: INCSPI -4
+	0x27, 0x01, 0xFF, 0xFF, 0xFF, 0xFC, 0x00, 0x04, //  67: CPTOPBP -4, 4
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x02,             //  75: CONSTI 2
+	0x16, 0x20,                                     //  81: MULII
+	0x26, 0x01, 0xFF, 0xFF, 0xFF, 0xFC, 0x00, 0x04, //  83: CPDOWNBP -4, 4
+	0x1B, 0x00, 0xFF, 0xFF, 0xFF, 0xFC,             //  91: MOVSP -4
+	0x1D, 0x00, 0xFF, 0xFF, 0xFF, 0xC6,             //  97: JMP 39
+	0x04, 0x04, 0x3F, 0xC0, 0x00, 0x00,             // 103: CONSTF 1.5
+	0x04, 0x04, 0x40, 0x00, 0x00, 0x00,             // 109: CONSTF 2.0
+	0x04, 0x04, 0x40, 0x40, 0x00, 0x00,             // 115: CONSTF 3.0
+	0x04, 0x04, 0x3F, 0x00, 0x00, 0x00,             // 121: CONSTF 0.5
+	0x16, 0x3B,                                     // 127: MULVF
+	0x04, 0x04, 0x3F, 0x80, 0x00, 0x00,             // 129: CONSTF 1.0
+	0x04, 0x04, 0x3F, 0x80, 0x00, 0x00,             // 135: CONSTF 1.0
+	0x04, 0x04, 0x3F, 0x80, 0x00, 0x00,             // 141: CONSTF 1.0
+	0x14, 0x3A,                                     // 147: ADDVV
+	0x05, 0x00, 0x00, 0x00, 0x01,                   // 149: ACTION 0, 1
+	0x04, 0x05, 0x00, 0x02, 0x61, 0x62,             // 154: CONSTS "ab"
+	0x05, 0x00, 0x00, 0x02, 0x01,                   // 160: ACTION 2, 1
+	0x04, 0x04, 0x40, 0x20, 0x00, 0x00,             // 165: CONSTF 2.5
+	0x27, 0x01, 0xFF, 0xFF, 0xFF, 0xFC, 0x00, 0x04, // 171: CPTOPBP -4, 4
+	0x05, 0x00, 0x00, 0x01, 0x02,                   // 179: ACTION 1, 2
+	0x05, 0x00, 0x00, 0x03, 0x00,                   // 184: ACTION 3, 0
+	0x03, 0x01, 0xFF, 0xFF, 0xFF, 0xF4, 0x00, 0x0C, // 189: CPTOPSP -12, 12
+	0x0B, 0x24, 0x00, 0x0C,                         // 197: EQTT 12
+	0x04, 0x05, 0x00, 0x03, 0x61, 0x62, 0x21,       // 201: CONSTS "ab!"
+	0x03, 0x01, 0xFF, 0xFF, 0xFF, 0xE4, 0x00, 0x04, // 208: CPTOPSP -28, 4
+	0x0B, 0x23,                                     // 216: EQSS
+	0x06, 0x20,                                     // 218: LOGANDII
+	0x21, 0x01, 0x00, 0x10, 0x00, 0x0C, 0x00, 0x04, // 220: DESTRUCT 16, 12, 4
+	0x02, 0x40,                                     // 228: RSADD int[]
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x2A,             // 230: CONSTI 42
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x02,             // 236: CONSTI 2
+	0x30, 0x01, 0xFF, 0xFF, 0xFF, 0xF4, 0x00, 0x04, // 242: WRITEARRAY -12, 4
+	0x1B, 0x00, 0xFF, 0xFF, 0xFF, 0xFC,             // 250: MOVSP -4
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x02,             // 256: CONSTI 2
+	0x32, 0x01, 0xFF, 0xFF, 0xFF, 0xF8, 0x00, 0x04, // 262: READARRAY -8, 4
+	0x2C, 0x10, 0x00, 0x00, 0x00, 0x04,             // 270: STORESTATE 16, 4, 8
+	0x00, 0x00, 0x00, 0x08,
+	0x05, 0x00, 0x00, 0x04, 0x01,                   // 280: ACTION 4, 1
+	0x04, 0x04, 0x41, 0x00, 0x00, 0x00,             // 285: CONSTF 8.0
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x03,             // 291: CONSTI 3
+	0x17, 0x26,                                     // 297: DIVFI
+	0x04, 0x03, 0xFF, 0xFF, 0xFF, 0xEC,             // 299: CONSTI -20
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x02,             // 305: CONSTI 2
+	0x12, 0x20,                                     // 311: SHRIGHTII
+	0x20, 0x00                                      // 313: RETN
+};
+
+/* An int addition on a float. */
+static const byte kNCSTypeMismatch[] = {
+	0x4E, 0x43, 0x53, 0x20, 0x56, 0x31, 0x2E, 0x30, 0x42, 0x00, 0x00, 0x00, 0x1D,
+	0x04, 0x04, 0x3F, 0x80, 0x00, 0x00,             //  13: CONSTF 1.0
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x01,             //  19: CONSTI 1
+	0x14, 0x20,                                     //  25: ADDII
+	0x20, 0x00                                      //  27: RETN
+};
+
+/* A jump past the end of the script. */
+static const byte kNCSBrokenJump[] = {
+	0x4E, 0x43, 0x53, 0x20, 0x56, 0x31, 0x2E, 0x30, 0x42, 0x00, 0x00, 0x00, 0x13,
+	0x1D, 0x00, 0x00, 0x00, 0x00, 0x64              //  13: JMP 113
+};
+
+/* Junk bytes that are jumped over, and a jump into the middle of an instruction,
+ * which ends the script after a NOP. */
+static const byte kNCSJunk[] = {
+	0x4E, 0x43, 0x53, 0x20, 0x56, 0x31, 0x2E, 0x30, 0x42, 0x00, 0x00, 0x00, 0x25,
+	0x1D, 0x00, 0x00, 0x00, 0x00, 0x08,             //  13: JMP 21
+	0xFF, 0xFF,                                     //  19: Junk
+	0x04, 0x03, 0x00, 0x00, 0x00, 0x07,             //  21: CONSTI 7
+	0x1D, 0x00, 0x00, 0x00, 0x00, 0x03,             //  27: JMP 30
+	0x20, 0x00,                                     //  33: RETN
+	0x00, 0x00                                      //  35: NOP
+};
+
+GTEST_TEST(NCSProgram, decode) {
+	Common::MemoryReadStream stream(kNCSSubroutine);
+	const Aurora::NWScript::NCSProgram program(stream);
+
+	ASSERT_EQ(program.size(), 19);
+
+	EXPECT_EQ(program[0].address, 13);
+	EXPECT_EQ(program[0].opcode, Aurora::NWScript::kOpcodeRSADD);
+	EXPECT_EQ(program[0].type, Aurora::NWScript::kInstTypeInt);
+
+	EXPECT_EQ(program[1].opcode, Aurora::NWScript::kOpcodeCONST);
+	EXPECT_EQ(program[1].args[0], 5);
+
+	EXPECT_EQ(program[5].opcode, Aurora::NWScript::kOpcodeCPTOPSP);
+	EXPECT_EQ(program[5].args[0], -4);
+	EXPECT_EQ(program[5].args[1], 4);
+
+	EXPECT_EQ(program[18].address, 109);
+	EXPECT_EQ(program[18].opcode, Aurora::NWScript::kOpcodeRETN);
+}
+
+GTEST_TEST(NCSProgram, targets) {
+	Common::MemoryReadStream stream(kNCSSubroutine);
+	const Aurora::NWScript::NCSProgram program(stream);
+
+	ASSERT_EQ(program.size(), 19);
+
+	EXPECT_EQ(program[2].opcode, Aurora::NWScript::kOpcodeJSR);
+	EXPECT_EQ(program[2].target, 5);
+
+	EXPECT_EQ(program[8].opcode, Aurora::NWScript::kOpcodeJZ);
+	EXPECT_EQ(program[8].target, 15);
+
+	EXPECT_EQ(program.findInstruction(13), 0);
+	EXPECT_EQ(program.findInstruction(89), 15);
+	EXPECT_EQ(program.findInstruction(111), 19);
+	EXPECT_EQ(program.findInstruction(14), Aurora::NWScript::NCSProgram::kInvalidTarget);
+	EXPECT_EQ(program.findInstruction(200), Aurora::NWScript::NCSProgram::kInvalidTarget);
+}
+
+GTEST_TEST(NCSProgram, strings) {
+	Common::MemoryReadStream stream(kNCSStrings);
+	const Aurora::NWScript::NCSProgram program(stream);
+
+	ASSERT_EQ(program.size(), 4);
+
+	EXPECT_STREQ(program.getString(program[0].args[0]).c_str(), "foo");
+	EXPECT_STREQ(program.getString(program[1].args[0]).c_str(), "bar");
+
+	EXPECT_THROW(program.getString(2), Common::Exception);
+}
+
+GTEST_TEST(NCSProgram, brokenJump) {
+	Common::MemoryReadStream stream(kNCSBrokenJump);
+	const Aurora::NWScript::NCSProgram program(stream);
+
+	ASSERT_EQ(program.size(), 1);
+	EXPECT_EQ(program[0].target, Aurora::NWScript::NCSProgram::kInvalidTarget);
+}
+
+GTEST_TEST(NCSProgram, junk) {
+	Common::MemoryReadStream stream(kNCSJunk);
+	const Aurora::NWScript::NCSProgram program(stream);
+
+	/* The junk is decoded as an unknown instruction, the code behind it from the
+	 * jump target on. The jump into the middle of the second JMP is decoded from there. */
+	ASSERT_EQ(program.size(), 7);
+
+	EXPECT_EQ(program[0].opcode, Aurora::NWScript::kOpcodeJMP);
+	EXPECT_EQ(program[0].target, 2);
+
+	EXPECT_EQ(program[1].address, 19);
+	EXPECT_EQ(program[1].opcode, 0xFF);
+
+	EXPECT_EQ(program[2].address, 21);
+	EXPECT_EQ(program[2].next, 3);
+	EXPECT_EQ(program[3].address, 27);
+	EXPECT_EQ(program[3].target, 4);
+
+	// Decoded from within the JMP, this NOP runs into a truncated instruction
+	EXPECT_EQ(program[4].address, 30);
+	EXPECT_EQ(program[4].opcode, Aurora::NWScript::kOpcodeNOP);
+	EXPECT_EQ(program[4].next, 7);
+	EXPECT_EQ(program[5].address, 33);
+	EXPECT_EQ(program[5].opcode, Aurora::NWScript::kOpcodeRETN);
+	EXPECT_EQ(program[6].address, 35);
+	EXPECT_EQ(program[6].next, 7);
+}
+
+GTEST_TEST(NCSFile, runSubroutine) {
+	Aurora::NWScript::NCSFile ncs(new Common::MemoryReadStream(kNCSSubroutine));
+
+	const Aurora::NWScript::Variable &result = ncs.run((Aurora::NWScript::Object *) 0);
+
+	ASSERT_EQ(result.getType(), Aurora::NWScript::kTypeInt);
+	EXPECT_EQ(result.getInt(), 50);
+}
+
+GTEST_TEST(NCSFile, runTwice) {
+	Aurora::NWScript::NCSFile ncs(new Common::MemoryReadStream(kNCSSubroutine));
+
+	EXPECT_EQ(ncs.run((Aurora::NWScript::Object *) 0).getInt(), 50);
+	EXPECT_EQ(ncs.run((Aurora::NWScript::Object *) 0).getInt(), 50);
+}
+
+GTEST_TEST(NCSFile, runStrings) {
+	Aurora::NWScript::NCSFile ncs(new Common::MemoryReadStream(kNCSStrings));
+
+	const Aurora::NWScript::Variable &result = ncs.run((Aurora::NWScript::Object *) 0);
+
+	ASSERT_EQ(result.getType(), Aurora::NWScript::kTypeString);
+	EXPECT_STREQ(result.getString().c_str(), "foobar");
+}
+
+GTEST_TEST(NCSFile, runBrokenJump) {
+	Aurora::NWScript::NCSFile ncs(new Common::MemoryReadStream(kNCSBrokenJump));
+
+	EXPECT_THROW(ncs.run((Aurora::NWScript::Object *) 0), Common::Exception);
+}
+
+GTEST_TEST(NCSFile, runJunk) {
+	Aurora::NWScript::NCSFile ncs(new Common::MemoryReadStream(kNCSJunk));
+
+	const Aurora::NWScript::Variable &result = ncs.run((Aurora::NWScript::Object *) 0);
+
+	ASSERT_EQ(result.getType(), Aurora::NWScript::kTypeInt);
+	EXPECT_EQ(result.getInt(), 7);
+}
+
+/* The differential tests below run scripts with both execution engines and
+ * compare their results, the stacks they leave behind and the engine
+ * functions they call. */
+
+/** The engine functions called by a script, in order. */
+static std::vector<Common::UString> engineTrace;
+
+static void recordCall(Aurora::NWScript::FunctionContext &ctx) {
+	engineTrace.push_back(ctx.getName() + "(" + Aurora::NWScript::formatParams(ctx) + ")");
+}
+
+static void testString(Aurora::NWScript::FunctionContext &ctx) {
+	recordCall(ctx);
+
+	ctx.getReturn() = ctx.getParams()[0].getString() + "!";
+}
+
+static void testSum(Aurora::NWScript::FunctionContext &ctx) {
+	recordCall(ctx);
+
+	ctx.getReturn() = (int32) (ctx.getParams()[0].getInt() + ctx.getParams()[1].getFloat());
+}
+
+static void testVector(Aurora::NWScript::FunctionContext &ctx) {
+	recordCall(ctx);
+
+	ctx.getReturn().setVector(1.0f, 2.0f, 3.0f);
+}
+
+static void testState(Aurora::NWScript::FunctionContext &ctx) {
+	recordCall(ctx);
+
+	const Aurora::NWScript::ScriptState &state = ctx.getParams()[0].getScriptState();
+
+	engineTrace.push_back(Common::UString::format("state %u %u %u", state.offset,
+	                      (uint) state.globals.size(), (uint) state.locals.size()));
+}
+
+static Aurora::NWScript::Signature createSignature(Aurora::NWScript::Type returnType,
+		Aurora::NWScript::Type param1 = Aurora::NWScript::kTypeVoid,
+		Aurora::NWScript::Type param2 = Aurora::NWScript::kTypeVoid) {
+
+	Aurora::NWScript::Signature signature;
+
+	signature.push_back(returnType);
+	if (param1 != Aurora::NWScript::kTypeVoid)
+		signature.push_back(param1);
+	if (param2 != Aurora::NWScript::kTypeVoid)
+		signature.push_back(param2);
+
+	return signature;
+}
+
+static void registerTestFunctions() {
+	FunctionMan.clear();
+
+	FunctionMan.registerFunction("TestVectorParam", 0, &recordCall,
+		createSignature(Aurora::NWScript::kTypeVoid, Aurora::NWScript::kTypeVector));
+	FunctionMan.registerFunction("TestSum", 1, &testSum,
+		createSignature(Aurora::NWScript::kTypeInt, Aurora::NWScript::kTypeInt, Aurora::NWScript::kTypeFloat));
+	FunctionMan.registerFunction("TestString", 2, &testString,
+		createSignature(Aurora::NWScript::kTypeString, Aurora::NWScript::kTypeString));
+	FunctionMan.registerFunction("TestVectorReturn", 3, &testVector,
+		createSignature(Aurora::NWScript::kTypeVector));
+	FunctionMan.registerFunction("TestState", 4, &testState,
+		createSignature(Aurora::NWScript::kTypeVoid, Aurora::NWScript::kTypeScriptState));
+}
+
+/** The maximum number of parameters of any engine function in any game. */
+static const size_t kMaxGenericParams = 16;
+/** The number of engine functions to register for scripts out of the game data. */
+static const size_t kGenericFunctionCount = 4096;
+
+/** Register functions taking any parameters and returning an int for all function IDs. */
+static void registerGenericFunctions() {
+	FunctionMan.clear();
+
+	Aurora::NWScript::Signature signature(1, Aurora::NWScript::kTypeInt);
+	signature.resize(kMaxGenericParams + 1, Aurora::NWScript::kTypeAny);
+
+	const Aurora::NWScript::Parameters defaults(kMaxGenericParams, Aurora::NWScript::Variable(Aurora::NWScript::kTypeAny));
+
+	for (size_t i = 0; i < kGenericFunctionCount; i++)
+		FunctionMan.registerFunction(Common::UString::format("Function%u", (uint) i), i,
+		                             &recordCall, signature, defaults);
+}
+
+struct ScriptResult {
+	bool failed;
+
+	std::vector<Common::UString> stack;
+	std::vector<Common::UString> trace;
+};
+
+static void finishResult(ScriptResult &result, const Aurora::NWScript::NCSFile &ncs, bool failed) {
+	result.failed = failed;
+	result.trace.swap(engineTrace);
+
+	// After a failure, the stack is left in whatever state the failing instruction left it in
+	if (failed)
+		return;
+
+	const std::vector<Aurora::NWScript::Variable> stack = ncs.getStack();
+	for (std::vector<Aurora::NWScript::Variable>::const_iterator v = stack.begin(); v != stack.end(); ++v) {
+		Common::UString str = Aurora::NWScript::formatType(v->getType()) + " ";
+		Aurora::NWScript::formatVariable(str, *v);
+
+		result.stack.push_back(str);
+	}
+}
+
+template<typename T>
+static ScriptResult runScript(const T &script, Aurora::NWScript::NCSFile::Engine engine) {
+	engineTrace.clear();
+
+	ScriptResult result;
+
+	try {
+		Aurora::NWScript::NCSFile ncs(script);
+		ncs.setEngine(engine);
+
+		try {
+			ncs.run((Aurora::NWScript::Object *) 0);
+		} catch (...) {
+			finishResult(result, ncs, true);
+			return result;
+		}
+
+		finishResult(result, ncs, false);
+
+	} catch (...) {
+		// Failing to load the script is not the engines' business
+		result.failed = false;
+		engineTrace.clear();
+	}
+
+	return result;
+}
+
+static ScriptResult runBuffer(const byte *data, size_t size, Aurora::NWScript::NCSFile::Engine engine) {
+	return runScript(new Common::MemoryReadStream(data, size), engine);
+}
+
+static void compareResults(const ScriptResult &interpreter, const ScriptResult &threaded) {
+	EXPECT_EQ(interpreter.failed, threaded.failed);
+	EXPECT_EQ(interpreter.stack , threaded.stack);
+	EXPECT_EQ(interpreter.trace , threaded.trace);
+}
+
+GTEST_TEST(NCSFile, threadedSubroutine) {
+	Aurora::NWScript::NCSFile ncs(new Common::MemoryReadStream(kNCSSubroutine));
+	ncs.setEngine(Aurora::NWScript::NCSFile::kEngineThreaded);
+
+	const Aurora::NWScript::Variable &result = ncs.run((Aurora::NWScript::Object *) 0);
+
+	ASSERT_EQ(result.getType(), Aurora::NWScript::kTypeInt);
+	EXPECT_EQ(result.getInt(), 50);
+}
+
+GTEST_TEST(NCSFile, threadedStrings) {
+	Aurora::NWScript::NCSFile ncs(new Common::MemoryReadStream(kNCSStrings));
+	ncs.setEngine(Aurora::NWScript::NCSFile::kEngineThreaded);
+
+	const Aurora::NWScript::Variable &result = ncs.run((Aurora::NWScript::Object *) 0);
+
+	ASSERT_EQ(result.getType(), Aurora::NWScript::kTypeString);
+	EXPECT_STREQ(result.getString().c_str(), "foobar");
+}
+
+GTEST_TEST(NCSFile, threadedBrokenJump) {
+	Aurora::NWScript::NCSFile ncs(new Common::MemoryReadStream(kNCSBrokenJump));
+	ncs.setEngine(Aurora::NWScript::NCSFile::kEngineThreaded);
+
+	EXPECT_THROW(ncs.run((Aurora::NWScript::Object *) 0), Common::Exception);
+}
+
+GTEST_TEST(NCSFile, threadedJunk) {
+	Aurora::NWScript::NCSFile ncs(new Common::MemoryReadStream(kNCSJunk));
+	ncs.setEngine(Aurora::NWScript::NCSFile::kEngineThreaded);
+
+	const Aurora::NWScript::Variable &result = ncs.run((Aurora::NWScript::Object *) 0);
+
+	ASSERT_EQ(result.getType(), Aurora::NWScript::kTypeInt);
+	EXPECT_EQ(result.getInt(), 7);
+}
+
+GTEST_TEST(NCSFile, defaultEngine) {
+	EXPECT_EQ(Aurora::NWScript::NCSFile::getDefaultEngine(), Aurora::NWScript::NCSFile::kEngineInterpreter);
+
+	Aurora::NWScript::NCSFile::setDefaultEngine(Aurora::NWScript::NCSFile::kEngineThreaded);
+	Aurora::NWScript::NCSFile ncs(new Common::MemoryReadStream(kNCSSubroutine));
+	Aurora::NWScript::NCSFile::setDefaultEngine(Aurora::NWScript::NCSFile::kEngineInterpreter);
+
+	EXPECT_EQ(ncs.getEngine(), Aurora::NWScript::NCSFile::kEngineThreaded);
+	EXPECT_EQ(ncs.run((Aurora::NWScript::Object *) 0).getInt(), 50);
+}
+
+GTEST_TEST(NCSFile, differentialMixed) {
+	registerTestFunctions();
+
+	const ScriptResult interpreter = runBuffer(kNCSMixed, sizeof(kNCSMixed),
+	                                           Aurora::NWScript::NCSFile::kEngineInterpreter);
+	const ScriptResult threaded    = runBuffer(kNCSMixed, sizeof(kNCSMixed),
+	                                           Aurora::NWScript::NCSFile::kEngineThreaded);
+
+	FunctionMan.clear();
+
+	EXPECT_FALSE(interpreter.failed);
+
+	ASSERT_EQ(interpreter.stack.size(), 7);
+	EXPECT_STREQ(interpreter.stack[0].c_str(), "int 224");
+	EXPECT_STREQ(interpreter.stack[3].c_str(), "array {0, 0, 42}");
+	EXPECT_STREQ(interpreter.stack[4].c_str(), "int 42");
+	EXPECT_STREQ(interpreter.stack[5].c_str(), "float 2.666667");
+	EXPECT_STREQ(interpreter.stack[6].c_str(), "int -5");
+
+	ASSERT_EQ(interpreter.trace.size(), 6);
+	EXPECT_STREQ(interpreter.trace[0].c_str(), "TestVectorParam([1.750000, 2.000000, 2.500000])");
+	EXPECT_STREQ(interpreter.trace[1].c_str(), "TestString(\"ab\")");
+	EXPECT_STREQ(interpreter.trace[2].c_str(), "TestSum(224, 2.500000)");
+	EXPECT_STREQ(interpreter.trace[3].c_str(), "TestVectorReturn()");
+	EXPECT_STREQ(interpreter.trace[5].c_str(), "state 286 1 2");
+
+	compareResults(interpreter, threaded);
+}
+
+GTEST_TEST(NCSFile, differentialTypeMismatch) {
+	const ScriptResult interpreter = runBuffer(kNCSTypeMismatch, sizeof(kNCSTypeMismatch),
+	                                           Aurora::NWScript::NCSFile::kEngineInterpreter);
+	const ScriptResult threaded    = runBuffer(kNCSTypeMismatch, sizeof(kNCSTypeMismatch),
+	                                           Aurora::NWScript::NCSFile::kEngineThreaded);
+
+	EXPECT_TRUE(interpreter.failed);
+
+	compareResults(interpreter, threaded);
+}
+
+/** Run all scripts found in the game directory named by XOREOS_TEST_GAMEDIR.
+ *
+ *  All loose files and all KEY, ERF, MOD, HAK, NWM and RIM archives are
+ *  indexed. Every engine function is replaced with a stub that records the
+ *  call and returns 0.
+ */
+GTEST_TEST(NCSFile, differentialGameDir) {
+	const char *gameDir = std::getenv("XOREOS_TEST_GAMEDIR");
+	if (!gameDir || !*gameDir)
+		return;
+
+	ResMan.registerDataBase(gameDir);
+	ResMan.indexResourceDir("", 0, -1, 1);
+
+	Common::FileList files(gameDir, -1), archives;
+	files.getSubListGlob(".*\\.(key|erf|mod|hak|nwm|rim)", true, archives);
+
+	for (Common::FileList::const_iterator a = archives.begin(); a != archives.end(); ++a) {
+		try {
+			ResMan.indexArchive(Common::FilePath::getFile(*a), 2);
+		} catch (...) {
+		}
+	}
+
+	std::list<Aurora::ResourceManager::ResourceID> scripts;
+	ResMan.getAvailableResources(Aurora::kFileTypeNCS, scripts);
+
+	registerGenericFunctions();
+
+	for (std::list<Aurora::ResourceManager::ResourceID>::const_iterator s = scripts.begin(); s != scripts.end(); ++s) {
+		SCOPED_TRACE(s->name.c_str());
+
+		const ScriptResult interpreter = runScript(s->name, Aurora::NWScript::NCSFile::kEngineInterpreter);
+		const ScriptResult threaded    = runScript(s->name, Aurora::NWScript::NCSFile::kEngineThreaded);
+
+		compareResults(interpreter, threaded);
+	}
+
+	FunctionMan.clear();
+	ResMan.clear();
+}
@@ -0,0 +1,556 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Stress tests for concurrently reading out of our resource manager,
+ *  and tests for its resource index cache.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/ustring.h"
+#include "src/common/error.h"
+#include "src/common/scopedptr.h"
+#include "src/common/platform.h"
+#include "src/common/thread.h"
+#include "src/common/changeid.h"
+#include "src/common/hash.h"
+#include "src/common/readfile.h"
+#include "src/common/writefile.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/resman.h"
+#include "src/aurora/erfwriter.h"
+#include "src/aurora/biffile.h"
+
+static const size_t kResourceCount = 64;
+static const size_t kThreadCount   = 8;
+static const size_t kReadCount     = 2000;
+
+static boost::filesystem::path kDataPath;
+
+/** The contents of a resource, unique and with a unique size for each name and index. */
+static Common::UString makeResourceData(const char *name, size_t index) {
+	Common::UString data;
+
+	for (size_t i = 0; i <= (index % 7); i++)
+		data += Common::UString::format("%s%03u: resource %u of %u, part %u\n",
+		                                name, (uint)index, (uint)index, (uint)kResourceCount, (uint)i);
+
+	return data;
+}
+
+static Common::UString makeResourceName(const char *name, size_t index) {
+	return Common::UString::format("%s%03u", name, (uint)index);
+}
+
+static Common::UString getFilePath(const char *file) {
+	return (kDataPath / file).generic_string();
+}
+
+static void writeERF(const char *file, const char *name, const char *dataName = 0) {
+	Common::WriteFile erfFile(getFilePath(file));
+
+	Aurora::ERFWriter erf(MKTAG('E', 'R', 'F', ' '), kResourceCount, erfFile);
+
+	for (size_t i = 0; i < kResourceCount; i++) {
+		const Common::UString data = makeResourceData(dataName ? dataName : name, i);
+
+		Common::MemoryReadStream stream(data.c_str());
+		erf.add(makeResourceName(name, i), Aurora::kFileTypeTXT, stream);
+	}
+}
+
+static void writeBIF(const char *file, const char *name) {
+	Common::WriteFile bif(getFilePath(file));
+
+	bif.writeUint32BE(MKTAG('B', 'I', 'F', 'F'));
+	bif.writeUint32BE(MKTAG('V', '1', ' ', ' '));
+	bif.writeUint32LE(kResourceCount); // Variable resources
+	bif.writeUint32LE(0);              // Fixed resources
+	bif.writeUint32LE(20);             // Offset to the variable resource table
+
+	uint32 offset = 20 + kResourceCount * 16;
+	for (size_t i = 0; i < kResourceCount; i++) {
+		const uint32 size = makeResourceData(name, i).size();
+
+		bif.writeUint32LE(i);
+		bif.writeUint32LE(offset);
+		bif.writeUint32LE(size);
+		bif.writeUint32LE(Aurora::kFileTypeTXT);
+
+		offset += size;
+	}
+
+	for (size_t i = 0; i < kResourceCount; i++)
+		bif.writeString(makeResourceData(name, i));
+}
+
+static void writeKEY(const char *file, const char *bifFile, const char *name) {
+	Common::WriteFile key(getFilePath(file));
+
+	const Common::UString bifName = bifFile;
+
+	key.writeUint32BE(MKTAG('K', 'E', 'Y', ' '));
+	key.writeUint32BE(MKTAG('V', '1', ' ', ' '));
+	key.writeUint32LE(1);                        // BIF count
+	key.writeUint32LE(kResourceCount);           // Resource count
+	key.writeUint32LE(64);                       // Offset to the BIF table
+	key.writeUint32LE(64 + 12 + bifName.size()); // Offset to the resource table
+	key.writeZeros(8 + 32);                      // Build date and reserved
+
+	key.writeUint32LE(0);              // BIF size
+	key.writeUint32LE(64 + 12);        // Offset to the BIF name
+	key.writeUint16LE(bifName.size()); // BIF name size
+	key.writeUint16LE(0);              // Drives
+
+	key.writeString(bifName);
+
+	for (size_t i = 0; i < kResourceCount; i++) {
+		const Common::UString resName = makeResourceName(name, i);
+
+		key.writeString(resName);
+		key.writeZeros(16 - resName.size());
+
+		key.writeUint16LE(Aurora::kFileTypeTXT);
+		key.writeUint32LE(i); // BIF 0, resource i
+	}
+}
+
+/** Read a resource fully and compare it against its expected contents. */
+static bool checkResource(Common::SeekableReadStream *resource, const char *name, size_t index) {
+	Common::ScopedPtr<Common::SeekableReadStream> stream(resource);
+	if (!stream)
+		return false;
+
+	const Common::UString data = makeResourceData(name, index);
+	if (stream->size() != data.size())
+		return false;
+
+	std::vector<char> buffer(data.size());
+	if (stream->read(&buffer[0], buffer.size()) != buffer.size())
+		return false;
+
+	return std::memcmp(&buffer[0], data.c_str(), buffer.size()) == 0;
+}
+
+class ResourceManager : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		kDataPath = boost::filesystem::temp_directory_path() /
+		            boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		boost::filesystem::create_directory(kDataPath);
+
+		writeBIF("stress.bif", "bif");
+		writeKEY("stress.key", "stress.bif", "bif");
+		writeERF("stress.erf", "erf");
+		writeERF("extra.erf" , "extra");
+	}
+
+	static void TearDownTestCase() {
+		ResMan.clear();
+
+		if (!kDataPath.empty())
+			boost::filesystem::remove_all(kDataPath);
+	}
+};
+
+/** A reader thread, pulling random resources out of the resource manager. */
+static void readResources(uint32 seed, std::atomic<size_t> *failures) {
+	static const char * const kNames[] = { "bif", "erf", "extra" };
+
+	for (size_t i = 0; i < kReadCount; i++) {
+		seed = seed * 1103515245 + 12345;
+
+		const char  *name  = kNames[(seed >> 16) % ARRAYSIZE(kNames)];
+		const size_t index = (seed >> 8) % kResourceCount;
+
+		try {
+			Common::SeekableReadStream *stream =
+				ResMan.getResource(makeResourceName(name, index), Aurora::kFileTypeTXT);
+
+			// The extra archive comes and goes
+			if (!stream && !strcmp(name, "extra"))
+				continue;
+
+			if (!checkResource(stream, name, index))
+				(*failures)++;
+
+		} catch (...) {
+			(*failures)++;
+		}
+	}
+}
+
+GTEST_TEST_F(ResourceManager, concurrentGetResource) {
+	ResMan.registerDataBase(kDataPath.generic_string());
+
+	ResMan.indexArchive("stress.key", 10);
+	ResMan.indexArchive("stress.erf", 20);
+
+	ASSERT_TRUE(ResMan.hasResource("bif000", Aurora::kFileTypeTXT));
+	ASSERT_TRUE(ResMan.hasResource("erf000", Aurora::kFileTypeTXT));
+
+	std::atomic<size_t> failures(0);
+
+	std::vector<std::thread> readers;
+	for (size_t i = 0; i < kThreadCount; i++)
+		readers.push_back(std::thread(readResources, (uint32)i, &failures));
+
+	// Meanwhile, repeatedly index and deindex another archive
+	size_t writerFailures = 0;
+	for (size_t i = 0; i < 50; i++) {
+		Common::ChangeID change;
+
+		ResMan.indexArchive("extra.erf", 30, &change);
+		if (!ResMan.hasResource("extra000", Aurora::kFileTypeTXT))
+			writerFailures++;
+
+		std::this_thread::yield();
+
+		ResMan.undo(change);
+		if (ResMan.hasResource("extra000", Aurora::kFileTypeTXT))
+			writerFailures++;
+	}
+
+	for (std::vector<std::thread>::iterator r = readers.begin(); r != readers.end(); ++r)
+		r->join();
+
+	EXPECT_EQ(failures, 0);
+	EXPECT_EQ(writerFailures, 0);
+
+	ResMan.clear();
+}
+
+/** A reader thread, pulling random resources out of a BIF. */
+static void readBIF(const Aurora::BIFFile *bif, uint32 seed, std::atomic<size_t> *failures) {
+	for (size_t i = 0; i < kReadCount; i++) {
+		seed = seed * 1103515245 + 12345;
+
+		const size_t index = (seed >> 8) % kResourceCount;
+
+		try {
+			if (!checkResource(bif->getResource(index), "bif", index))
+				(*failures)++;
+		} catch (...) {
+			(*failures)++;
+		}
+	}
+}
+
+GTEST_TEST_F(ResourceManager, concurrentUnmappedBIF) {
+	// A plain file stream has to be seeked, so the BIF reads under its stream lock
+	const Aurora::BIFFile bif(new Common::ReadFile(getFilePath("stress.bif")));
+
+	std::atomic<size_t> failures(0);
+
+	std::vector<std::thread> readers;
+	for (size_t i = 0; i < kThreadCount; i++)
+		readers.push_back(std::thread(readBIF, &bif, (uint32)i, &failures));
+
+	for (std::vector<std::thread>::iterator r = readers.begin(); r != readers.end(); ++r)
+		r->join();
+
+	EXPECT_EQ(failures, 0);
+}
+
+/** Index the KEY and this ERF with the resource index cache in this directory, and check their resources.
+ *
+ *  Returns the number of archive files that had to be opened while indexing.
+ */
+static size_t indexCached(const Common::UString &cacheDir, bool rebuild, const char *erf, const char *name) {
+	ResMan.setIndexCache(cacheDir, rebuild);
+	ResMan.registerDataBase(kDataPath.generic_string());
+
+	const size_t openCount = ResMan.getArchiveOpenCount();
+
+	ResMan.indexArchive("stress.key", 10);
+	ResMan.indexArchive(erf, 20);
+
+	const size_t indexOpenCount = ResMan.getArchiveOpenCount() - openCount;
+
+	for (size_t i = 0; i < kResourceCount; i++) {
+		EXPECT_TRUE(checkResource(ResMan.getResource(makeResourceName("bif", i), Aurora::kFileTypeTXT), "bif", i));
+		EXPECT_TRUE(checkResource(ResMan.getResource(makeResourceName(name, i), Aurora::kFileTypeTXT), name, i));
+	}
+
+	ResMan.clear();
+
+	return indexOpenCount;
+}
+
+GTEST_TEST_F(ResourceManager, indexCache) {
+	const Common::UString cacheDir = getFilePath("cache");
+
+	// Our own copy of the ERF, to change it without disturbing the other tests
+	writeERF("indexcache.erf", "erf");
+
+	// The first run opens the KEY, the BIF and the ERF, and writes the cache
+	EXPECT_EQ(indexCached(cacheDir, false, "indexcache.erf", "erf"), 3U);
+	ASSERT_TRUE(boost::filesystem::is_directory(cacheDir.c_str()));
+	ASSERT_FALSE(boost::filesystem::is_empty(cacheDir.c_str()));
+
+	// The second run reads the cache, and opens nothing while indexing
+	EXPECT_EQ(indexCached(cacheDir, false, "indexcache.erf", "erf"), 0U);
+
+	// A changed archive is indexed anew
+	const boost::filesystem::path erfPath = kDataPath / "indexcache.erf";
+	const std::time_t erfTime = boost::filesystem::last_write_time(erfPath);
+
+	writeERF("indexcache.erf", "changed");
+	boost::filesystem::last_write_time(erfPath, erfTime + 10);
+
+	EXPECT_EQ(indexCached(cacheDir, false, "indexcache.erf", "changed"), 1U);
+	EXPECT_EQ(indexCached(cacheDir, false, "indexcache.erf", "changed"), 0U);
+
+	// Rebuilding ignores the cache
+	EXPECT_EQ(indexCached(cacheDir, true , "indexcache.erf", "changed"), 3U);
+
+	ResMan.setIndexCache("");
+}
+
+GTEST_TEST_F(ResourceManager, indexCacheConcurrent) {
+	const Common::UString cacheDir = getFilePath("concurrentcache");
+
+	EXPECT_EQ(indexCached(cacheDir, false, "stress.erf", "erf"), 3U);
+
+	ResMan.registerDataBase(kDataPath.generic_string());
+
+	const size_t openCount = ResMan.getArchiveOpenCount();
+
+	ResMan.indexArchive("stress.key", 10);
+	ResMan.indexArchive("stress.erf", 20);
+
+	// Indexed from the cache, none of the archives has been opened yet
+	EXPECT_EQ(ResMan.getArchiveOpenCount(), openCount);
+
+	std::atomic<size_t> failures(0);
+
+	std::vector<std::thread> readers;
+	for (size_t i = 0; i < kThreadCount; i++)
+		readers.push_back(std::thread(readResources, (uint32)i, &failures));
+
+	for (std::vector<std::thread>::iterator r = readers.begin(); r != readers.end(); ++r)
+		r->join();
+
+	EXPECT_EQ(failures, 0);
+
+	// All readers together opened the BIF and the ERF only once each
+	EXPECT_EQ(ResMan.getArchiveOpenCount() - openCount, 2U);
+
+	ResMan.clear();
+	ResMan.setIndexCache("");
+}
+
+static const size_t kStartupArchiveCount = 500;
+
+static void writeStartupArchives(std::vector<Common::UString> &archives) {
+	const boost::filesystem::path archivePath = kDataPath / "startup";
+	const bool exists = boost::filesystem::is_directory(archivePath);
+
+	boost::filesystem::create_directory(archivePath);
+
+	for (size_t i = 0; i < kStartupArchiveCount; i++) {
+		archives.push_back(Common::UString::format("startup/archive%03u.erf", (uint)i));
+		if (!exists)
+			writeERF(archives.back().c_str(), Common::UString::format("a%03u_", (uint)i).c_str());
+	}
+}
+
+GTEST_TEST_F(ResourceManager, indexPriorities) {
+	writeERF("shadowlow.erf" , "erf", "low");
+	writeERF("shadowhigh.erf", "erf", "high");
+
+	ResMan.registerDataBase(kDataPath.generic_string());
+
+	Common::ChangeID erfChange, lowChange, highChange;
+	ResMan.indexArchive("stress.erf"    , 20, &erfChange);
+	ResMan.indexArchive("shadowlow.erf" , 10, &lowChange);
+
+	// The lower priority archive is shadowed
+	EXPECT_TRUE(checkResource(ResMan.getResource("erf005", Aurora::kFileTypeTXT), "erf", 5));
+
+	ResMan.indexArchive("shadowhigh.erf", 30, &highChange);
+	EXPECT_TRUE(checkResource(ResMan.getResource("erf005", Aurora::kFileTypeTXT), "high", 5));
+
+	ResMan.undo(highChange);
+	EXPECT_TRUE(checkResource(ResMan.getResource("erf005", Aurora::kFileTypeTXT), "erf", 5));
+
+	ResMan.undo(erfChange);
+	EXPECT_TRUE(checkResource(ResMan.getResource("erf005", Aurora::kFileTypeTXT), "low", 5));
+
+	// Removing the last resources of a name must not hide others probed past them
+	ResMan.undo(lowChange);
+	EXPECT_FALSE(ResMan.hasResource("erf005", Aurora::kFileTypeTXT));
+
+	ResMan.indexArchive("shadowhigh.erf", 30, &highChange);
+	ResMan.indexArchive("stress.key", 10);
+	for (size_t i = 0; i < kResourceCount; i++) {
+		EXPECT_TRUE(checkResource(ResMan.getResource(makeResourceName("erf", i), Aurora::kFileTypeTXT), "high", i));
+		EXPECT_TRUE(checkResource(ResMan.getResource(makeResourceName("bif", i), Aurora::kFileTypeTXT), "bif", i));
+	}
+
+	ResMan.blacklist("erf005", Aurora::kFileTypeTXT);
+	EXPECT_FALSE(ResMan.hasResource("erf005", Aurora::kFileTypeTXT));
+	EXPECT_TRUE(ResMan.hasResource("erf006", Aurora::kFileTypeTXT));
+
+	ResMan.clear();
+}
+
+GTEST_TEST_F(ResourceManager, names) {
+	writeERF("names.erf", "erf", "names");
+
+	ResMan.registerDataBase(kDataPath.generic_string());
+	const size_t baseSize = ResMan.getNameArenaSize();
+
+	ResMan.indexArchive("stress.erf", 20);
+	const size_t erfSize = ResMan.getNameArenaSize();
+	EXPECT_GT(erfSize, baseSize);
+
+	// The resources of another archive with the same names share them
+	Common::ChangeID namesChange;
+	ResMan.indexArchive("names.erf", 30, &namesChange);
+	EXPECT_EQ(ResMan.getNameArenaSize(), erfSize);
+	EXPECT_TRUE(checkResource(ResMan.getResource("erf005", Aurora::kFileTypeTXT), "names", 5));
+
+	// Declaring a name that's already known doesn't add it again
+	ResMan.declareResource("erf005", Aurora::kFileTypeTXT);
+	EXPECT_EQ(ResMan.getNameArenaSize(), erfSize);
+
+	// The names are still used by the first archive
+	ResMan.undo(namesChange);
+	EXPECT_EQ(ResMan.getNameArenaSize(), erfSize);
+	EXPECT_TRUE(checkResource(ResMan.getResource("erf005", Aurora::kFileTypeTXT), "erf", 5));
+
+	// The names of an archive indexed and undone over and over again don't pile up
+	Common::ChangeID extraChange;
+	ResMan.indexArchive("extra.erf", 30, &extraChange);
+	const size_t extraSize = ResMan.getNameArenaSize() - erfSize;
+	ResMan.undo(extraChange);
+
+	for (size_t i = 0; i < 100; i++) {
+		ResMan.indexArchive("extra.erf", 30, &extraChange);
+		ResMan.undo(extraChange);
+	}
+
+	EXPECT_LE(ResMan.getNameArenaSize(), 2 * (erfSize + extraSize));
+
+	for (size_t i = 0; i < kResourceCount; i++)
+		EXPECT_TRUE(checkResource(ResMan.getResource(makeResourceName("erf", i), Aurora::kFileTypeTXT), "erf", i));
+
+	ResMan.clear();
+}
+
+GTEST_TEST(ResourceIndexCache, bogusCount) {
+	static const byte kCache[] = {
+		'X', 'R', 'I', 'C', 0x01, 0x00, 0x00, 0x00,
+		0x01, 0x00, 0x00, 0x00, // One entry
+		0x00, 0x00, 0x00, 0x00, // with an empty path,
+		0x00, 0x00, 0x00, 0x00, // no settings
+		0xFF, 0xFF, 0xFF, 0x7F, // and way more files than could fit
+		'X', 'R', 'I', 'C'
+	};
+
+	Common::MemoryReadStream stream(kCache);
+
+	Aurora::ResourceIndexCache cache;
+	EXPECT_THROW(cache.load(stream), Common::Exception);
+}
+
+GTEST_TEST_F(ResourceManager, DISABLED_indexCacheStartup) {
+	const boost::filesystem::path archivePath = kDataPath / "startup";
+
+	std::vector<Common::UString> archives;
+	writeStartupArchives(archives);
+
+	ResMan.setIndexCache(getFilePath("startupcache"));
+
+	double times[2];
+	for (size_t run = 0; run < 2; run++) {
+		const auto start = std::chrono::steady_clock::now();
+
+		ResMan.registerDataBase(archivePath.generic_string());
+		for (size_t i = 0; i < kStartupArchiveCount; i++)
+			ResMan.indexArchive(archives[i], 10 + i);
+
+		const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+		times[run] = time.count() * 1000.0;
+
+		EXPECT_TRUE(checkResource(ResMan.getResource("a123_042", Aurora::kFileTypeTXT), "a123_", 42));
+		EXPECT_TRUE(checkResource(ResMan.getResource("a499_000", Aurora::kFileTypeTXT), "a499_", 0));
+
+		ResMan.clear();
+	}
+
+	ResMan.setIndexCache("");
+
+	std::printf("Indexing %u archives: %.1f ms without cache, %.1f ms with cache\n",
+	            (uint)kStartupArchiveCount, times[0], times[1]);
+}
+
+GTEST_TEST_F(ResourceManager, DISABLED_lookup) {
+	static const size_t kLookupCount = 2000000;
+
+	std::vector<Common::UString> archives;
+	writeStartupArchives(archives);
+
+	ResMan.registerDataBase((kDataPath / "startup").generic_string());
+	for (size_t i = 0; i < kStartupArchiveCount; i++)
+		ResMan.indexArchive(archives[i], 10 + i);
+
+	std::vector<uint64> hashes;
+	for (size_t i = 0; i < kStartupArchiveCount; i++) {
+		for (size_t j = 0; j < kResourceCount; j += 8) {
+			const Common::UString name = Common::UString::format("a%03u_%03u.txt", (uint)i, (uint)j);
+
+			hashes.push_back(Common::hashString(name, Common::kHashFNV64));
+			hashes.push_back(Common::hashString(name + "x", Common::kHashFNV64));
+		}
+	}
+
+	size_t found = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < kLookupCount; i++)
+		found += ResMan.hasResource(hashes[(i * 7919) % hashes.size()]) ? 1 : 0;
+
+	const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+	EXPECT_EQ(found, kLookupCount / 2);
+
+	ResMan.clear();
+
+	std::printf("Looking up %u hashes among %u resources: %.1f ns per lookup\n",
+	            (uint)kLookupCount, (uint)(kStartupArchiveCount * kResourceCount),
+	            time.count() * 1.0e9 / kLookupCount);
+}
@@ -107,6 +107,7 @@ check_PROGRAMS                     += tests/aurora/test_gff3file
 tests_aurora_test_gff3file_SOURCES  = tests/aurora/gff3file.cpp
 tests_aurora_test_gff3file_LDADD    = $(aurora_LIBS)
 tests_aurora_test_gff3file_CXXFLAGS = $(test_CXXFLAGS)
+BENCHMARKS                         += tests/aurora/test_gff3file
 
 check_PROGRAMS                     += tests/aurora/test_gff4file
 tests_aurora_test_gff4file_SOURCES  = tests/aurora/gff4file.cpp
@@ -117,6 +118,7 @@ check_PROGRAMS                    += tests/aurora/test_2dafile
 tests_aurora_test_2dafile_SOURCES  = tests/aurora/2dafile.cpp
 tests_aurora_test_2dafile_LDADD    = $(aurora_LIBS)
 tests_aurora_test_2dafile_CXXFLAGS = $(test_CXXFLAGS)
+BENCHMARKS                        += tests/aurora/test_2dafile
 
 check_PROGRAMS                    += tests/aurora/test_gdafile
 tests_aurora_test_gdafile_SOURCES  = tests/aurora/gdafile.cpp
@@ -189,3 +191,19 @@ check_PROGRAMS                     += tests/aurora/test_xmlfixer
 tests_aurora_test_xmlfixer_SOURCES  = tests/aurora/xmlfixer.cpp
 tests_aurora_test_xmlfixer_LDADD    = $(aurora_LIBS)
 tests_aurora_test_xmlfixer_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                     += tests/aurora/test_ncsfile
+tests_aurora_test_ncsfile_SOURCES  = tests/aurora/ncsfile.cpp
+tests_aurora_test_ncsfile_LDADD    = $(aurora_LIBS)
+tests_aurora_test_ncsfile_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                    += tests/aurora/test_resman
+tests_aurora_test_resman_SOURCES  = tests/aurora/resman.cpp
+tests_aurora_test_resman_LDADD    = $(aurora_LIBS)
+tests_aurora_test_resman_CXXFLAGS = $(test_CXXFLAGS)
+BENCHMARKS                        += tests/aurora/test_resman
+
+check_PROGRAMS                               += tests/aurora/test_decompressedcache
+tests_aurora_test_decompressedcache_SOURCES  = tests/aurora/decompressedcache.cpp
+tests_aurora_test_decompressedcache_LDADD    = $(aurora_LIBS)
+tests_aurora_test_decompressedcache_CXXFLAGS = $(test_CXXFLAGS)
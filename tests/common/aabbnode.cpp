@@ -24,7 +24,10 @@
 
 #include "gtest/gtest.h"
 
+#include "external/glm/gtc/matrix_transform.hpp"
+
 #include "src/common/aabbnode.h"
+#include "src/common/frustum.h"
 
 GTEST_TEST(AABBNode, hasChildren) {
 	float min[] = {0.f, 0.f, 0.f};
@@ -164,3 +167,103 @@ GTEST_TEST(AABBNode, adjustChildrenProperty) {
 	ASSERT_EQ(e->getProperty(), 5);
 }
 
+
+GTEST_TEST(AABBNode, getLeaves) {
+	float min[3] = {0.f, 0.f, 0.f};
+	float max[3] = {1.f, 1.f, 1.f};
+	Common::AABBNode a(min, max);
+	Common::AABBNode *b = new Common::AABBNode(min, max);
+	Common::AABBNode *c = new Common::AABBNode(min, max, 2);
+	Common::AABBNode *d = new Common::AABBNode(min, max, 0);
+	Common::AABBNode *e = new Common::AABBNode(min, max, 1);
+	b->setChildren(d, e);
+	a.setChildren(b, c);
+
+	std::vector<Common::AABBNode *> nodes;
+	a.getLeaves(nodes);
+	ASSERT_EQ(nodes.size(), 3U);
+	EXPECT_EQ(nodes[0]->getProperty(), 0);
+	EXPECT_EQ(nodes[1]->getProperty(), 1);
+	EXPECT_EQ(nodes[2]->getProperty(), 2);
+}
+
+GTEST_TEST(AABBNode, getNodesInFrustum) {
+	// A 90° camera at the origin, looking down the negative z axis
+	const Common::Frustum frustum(glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 100.0f));
+
+	float minIn[3]  = { -1.f, -1.f, -11.f };
+	float maxIn[3]  = {  1.f,  1.f,  -9.f };
+	float minOut[3] = { -1.f, -1.f,   9.f };
+	float maxOut[3] = {  1.f,  1.f,  11.f };
+	float minAll[3] = { -1.f, -1.f, -11.f };
+	float maxAll[3] = {  1.f,  1.f,  11.f };
+
+	Common::AABBNode a(minAll, maxAll);
+	Common::AABBNode *b = new Common::AABBNode(minIn , maxIn , 0);
+	Common::AABBNode *c = new Common::AABBNode(minOut, maxOut, 1);
+	a.setChildren(b, c);
+
+	std::vector<Common::AABBNode *> nodes;
+	a.getNodes(frustum, nodes);
+	ASSERT_EQ(nodes.size(), 1U);
+	EXPECT_EQ(nodes[0]->getProperty(), 0);
+
+	// Everything is inside a frustum enclosing all of space
+	nodes.clear();
+	a.getNodes(Common::Frustum(), nodes);
+	EXPECT_EQ(nodes.size(), 2U);
+}
+
+GTEST_TEST(AABBNode, refit) {
+	float min[3] = {0.f, 0.f, 0.f};
+	float max[3] = {1.f, 1.f, 1.f};
+	float minParent[3] = {0.f, 0.f, 0.f};
+	float maxParent[3] = {5.f, 1.f, 1.f};
+	float minMoved[3] = {4.f, 0.f, 0.f};
+	float maxMoved[3] = {5.f, 1.f, 1.f};
+
+	Common::AABBNode a(minParent, maxParent);
+	Common::AABBNode *b = new Common::AABBNode(min, max);
+	Common::AABBNode *c = new Common::AABBNode(minMoved, maxMoved);
+	Common::AABBNode *d = new Common::AABBNode(min, max);
+	Common::AABBNode *e = new Common::AABBNode(min, max);
+	b->setChildren(d, e);
+	a.setChildren(b, c);
+
+	float x, y, z;
+
+	// Moving a leaf away grows all its ancestors
+	float minFar[3] = {-3.f, 0.f, 0.f};
+	float maxFar[3] = {-2.f, 2.f, 1.f};
+	d->refit(minFar, maxFar);
+
+	b->getMin(x, y, z);
+	EXPECT_FLOAT_EQ(x, -3.f);
+	b->getMax(x, y, z);
+	EXPECT_FLOAT_EQ(x, 1.f);
+	EXPECT_FLOAT_EQ(y, 2.f);
+	a.getMin(x, y, z);
+	EXPECT_FLOAT_EQ(x, -3.f);
+	a.getMax(x, y, z);
+	EXPECT_FLOAT_EQ(x, 5.f);
+	EXPECT_FLOAT_EQ(y, 2.f);
+
+	// Moving it back shrinks them again
+	d->refit(min, max);
+
+	b->getMin(x, y, z);
+	EXPECT_FLOAT_EQ(x, 0.f);
+	b->getMax(x, y, z);
+	EXPECT_FLOAT_EQ(y, 1.f);
+	a.getMin(x, y, z);
+	EXPECT_FLOAT_EQ(x, 0.f);
+	a.getMax(x, y, z);
+	EXPECT_FLOAT_EQ(x, 5.f);
+	EXPECT_FLOAT_EQ(y, 1.f);
+
+	// Moving the right leaf next to the left shrinks the root
+	c->refit(min, max);
+
+	a.getMax(x, y, z);
+	EXPECT_FLOAT_EQ(x, 1.f);
+}
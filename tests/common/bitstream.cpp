@@ -192,3 +192,62 @@ GTEST_TEST(BitStream, BitStream64BELSB) {
 
 	testBitStream(bitStream, compValues);
 }
+
+template<class T>
+static void testPeekSkip() {
+	static const byte data[16] = {
+		0x12, 0x34, 0x56, 0x78, 0x90, 0xAB, 0xCD, 0xEF,
+		0xFE, 0xDC, 0xBA, 0x09, 0x87, 0x65, 0x43, 0x21
+	};
+	static const size_t widths[] = { 1, 3, 7, 9, 13, 32, 5, 17, 20, 11, 2 };
+
+	Common::MemoryReadStream peekStream(data);
+	Common::MemoryReadStream readStream(data);
+
+	T peekBitStream(peekStream);
+	T readBitStream(readStream);
+
+	for (size_t i = 0; i < ARRAYSIZE(widths); i++) {
+		EXPECT_EQ(peekBitStream.peekBits(widths[i]), readBitStream.getBits(widths[i])) << "At index " << i;
+
+		peekBitStream.skip(widths[i]);
+		EXPECT_EQ(peekBitStream.pos(), readBitStream.pos()) << "At index " << i;
+	}
+}
+
+GTEST_TEST(BitStream, peekSkip) {
+	testPeekSkip<Common::BitStream8MSB>();
+	testPeekSkip<Common::BitStream8LSB>();
+	testPeekSkip<Common::BitStream16LEMSB>();
+	testPeekSkip<Common::BitStream16LELSB>();
+	testPeekSkip<Common::BitStream16BEMSB>();
+	testPeekSkip<Common::BitStream16BELSB>();
+	testPeekSkip<Common::BitStream32LEMSB>();
+	testPeekSkip<Common::BitStream32LELSB>();
+	testPeekSkip<Common::BitStream32BEMSB>();
+	testPeekSkip<Common::BitStream32BELSB>();
+	testPeekSkip<Common::BitStream64LEMSB>();
+	testPeekSkip<Common::BitStream64LELSB>();
+	testPeekSkip<Common::BitStream64BEMSB>();
+	testPeekSkip<Common::BitStream64BELSB>();
+}
+
+GTEST_TEST(BitStream, peekEnd) {
+	static const byte data[2] = { 0x12, 0x34 };
+
+	Common::MemoryReadStream streamMSB(data);
+	Common::BitStream8MSB bitStreamMSB(streamMSB);
+
+	bitStreamMSB.skip(12);
+	EXPECT_EQ(bitStreamMSB.peekBits(8), 0x40);
+	EXPECT_EQ(bitStreamMSB.pos(), 12);
+
+	Common::MemoryReadStream streamLSB(data);
+	Common::BitStream8LSB bitStreamLSB(streamLSB);
+
+	bitStreamLSB.skip(12);
+	EXPECT_EQ(bitStreamLSB.peekBits(8), 0x03);
+	EXPECT_EQ(bitStreamLSB.pos(), 12);
+
+	EXPECT_THROW(bitStreamLSB.skip(5), Common::Exception);
+}
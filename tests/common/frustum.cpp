@@ -0,0 +1,106 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our view frustum class.
+ */
+
+#include "gtest/gtest.h"
+
+#include "external/glm/gtc/matrix_transform.hpp"
+
+#include "src/common/frustum.h"
+
+// A 90° camera at the origin, looking down the negative z axis
+static Common::Frustum createFrustum() {
+	return Common::Frustum(glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 100.0f));
+}
+
+static Common::Frustum::Intersection intersect(const Common::Frustum &frustum,
+		float minX, float minY, float minZ, float maxX, float maxY, float maxZ) {
+
+	const float min[3] = { minX, minY, minZ };
+	const float max[3] = { maxX, maxY, maxZ };
+
+	return frustum.intersect(min, max);
+}
+
+GTEST_TEST(Frustum, empty) {
+	const Common::Frustum frustum;
+
+	EXPECT_EQ(intersect(frustum, -1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f), Common::Frustum::kInside);
+	EXPECT_EQ(intersect(frustum, 1000.0f, 1000.0f, 1000.0f, 1001.0f, 1001.0f, 1001.0f), Common::Frustum::kInside);
+}
+
+GTEST_TEST(Frustum, inside) {
+	const Common::Frustum frustum = createFrustum();
+
+	EXPECT_EQ(intersect(frustum, -1.0f, -1.0f, -11.0f, 1.0f, 1.0f, -9.0f), Common::Frustum::kInside);
+	EXPECT_EQ(intersect(frustum, 40.0f, 40.0f, -60.0f, 45.0f, 45.0f, -50.0f), Common::Frustum::kInside);
+
+	const float min[3] = { -1.0f, -1.0f, -11.0f };
+	const float max[3] = {  1.0f,  1.0f,  -9.0f };
+	EXPECT_TRUE(frustum.isIn(min, max));
+}
+
+GTEST_TEST(Frustum, outside) {
+	const Common::Frustum frustum = createFrustum();
+
+	// Behind the camera
+	EXPECT_EQ(intersect(frustum, -1.0f, -1.0f, 9.0f, 1.0f, 1.0f, 11.0f), Common::Frustum::kOutside);
+	// Between the camera and the near plane
+	EXPECT_EQ(intersect(frustum, -0.1f, -0.1f, -0.5f, 0.1f, 0.1f, -0.2f), Common::Frustum::kOutside);
+	// Beyond the far plane
+	EXPECT_EQ(intersect(frustum, -1.0f, -1.0f, -200.0f, 1.0f, 1.0f, -150.0f), Common::Frustum::kOutside);
+
+	// Left, right, below and above the view
+	EXPECT_EQ(intersect(frustum, -15.0f, -1.0f, -11.0f, -12.0f, 1.0f, -9.0f), Common::Frustum::kOutside);
+	EXPECT_EQ(intersect(frustum,  12.0f, -1.0f, -11.0f,  15.0f, 1.0f, -9.0f), Common::Frustum::kOutside);
+	EXPECT_EQ(intersect(frustum, -1.0f, -15.0f, -11.0f, 1.0f, -12.0f, -9.0f), Common::Frustum::kOutside);
+	EXPECT_EQ(intersect(frustum, -1.0f,  12.0f, -11.0f, 1.0f,  15.0f, -9.0f), Common::Frustum::kOutside);
+
+	const float min[3] = { -1.0f, -1.0f,  9.0f };
+	const float max[3] = {  1.0f,  1.0f, 11.0f };
+	EXPECT_FALSE(frustum.isIn(min, max));
+}
+
+GTEST_TEST(Frustum, intersecting) {
+	const Common::Frustum frustum = createFrustum();
+
+	// Straddling the left and the right plane
+	EXPECT_EQ(intersect(frustum, -12.0f, -1.0f, -11.0f, -8.0f, 1.0f, -9.0f), Common::Frustum::kIntersecting);
+	EXPECT_EQ(intersect(frustum,   8.0f, -1.0f, -11.0f, 12.0f, 1.0f, -9.0f), Common::Frustum::kIntersecting);
+	// Straddling the near and the far plane
+	EXPECT_EQ(intersect(frustum, -0.1f, -0.1f, -2.0f, 0.1f, 0.1f, 0.5f), Common::Frustum::kIntersecting);
+	EXPECT_EQ(intersect(frustum, -1.0f, -1.0f, -150.0f, 1.0f, 1.0f, -50.0f), Common::Frustum::kIntersecting);
+	// Enclosing the whole frustum
+	EXPECT_EQ(intersect(frustum, -500.0f, -500.0f, -500.0f, 500.0f, 500.0f, 500.0f), Common::Frustum::kIntersecting);
+}
+
+GTEST_TEST(Frustum, modelview) {
+	// The same camera, moved to (100, 0, 0)
+	const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 100.0f);
+	const glm::mat4 modelview  = glm::translate(glm::mat4(), glm::vec3(-100.0f, 0.0f, 0.0f));
+
+	const Common::Frustum frustum(projection * modelview);
+
+	EXPECT_EQ(intersect(frustum, -1.0f, -1.0f, -11.0f, 1.0f, 1.0f, -9.0f), Common::Frustum::kOutside);
+	EXPECT_EQ(intersect(frustum, 99.0f, -1.0f, -11.0f, 101.0f, 1.0f, -9.0f), Common::Frustum::kInside);
+}
@@ -120,3 +120,98 @@ GTEST_TEST(Huffman, invalidSymbol) {
 
 	EXPECT_THROW(huffman.getSymbol(bitStream), Common::Exception);
 }
+
+/** Reference decoder, reading one bit at a time and comparing against all codes of that length. */
+static uint32 getSymbolReference(Common::BitStream &bits, size_t codeCount, const uint32 *codes,
+                                 const uint8 *lengths, const uint32 *symbols, uint8 maxLength) {
+	uint32 code = 0;
+
+	for (uint8 i = 0; i < maxLength; i++) {
+		bits.addBit(code, i);
+
+		for (size_t j = 0; j < codeCount; j++)
+			if ((lengths[j] == (i + 1)) && (codes[j] == code))
+				return symbols[j];
+	}
+
+	throw Common::Exception("Unknown Huffman code");
+}
+
+/** Simple xorshift PRNG, to get the same pseudo-random data on every platform. */
+static uint32 nextRandom(uint32 &state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+
+	return state;
+}
+
+/** Create a complete prefix code by randomly splitting leaves of a code tree. */
+static void createRandomCodes(uint32 seed, size_t codeCount, uint8 maxLength,
+                              std::vector<uint32> &codes, std::vector<uint8> &lengths) {
+
+	codes.assign(1, 0);
+	lengths.assign(1, 0);
+
+	while (codes.size() < codeCount) {
+		const size_t leaf = nextRandom(seed) % codes.size();
+		if (lengths[leaf] >= maxLength)
+			continue;
+
+		codes[leaf] <<= 1;
+		lengths[leaf]++;
+
+		codes.push_back(codes[leaf] | 1);
+		lengths.push_back(lengths[leaf]);
+	}
+}
+
+template<class T>
+static void testRandomCodes(uint32 seed, size_t codeCount, uint8 maxLength) {
+	std::vector<uint32> codes, symbols;
+	std::vector<uint8>  lengths;
+
+	createRandomCodes(seed, codeCount, maxLength, codes, lengths);
+
+	for (size_t i = 0; i < codes.size(); i++)
+		symbols.push_back(nextRandom(seed));
+
+	byte data[512];
+	for (size_t i = 0; i < ARRAYSIZE(data); i++)
+		data[i] = nextRandom(seed);
+
+	Common::MemoryReadStream referenceStream(data);
+	Common::MemoryReadStream testStream(data);
+
+	T referenceBitStream(referenceStream);
+	T testBitStream(testStream);
+
+	Common::Huffman huffman(0, codes.size(), &codes[0], &lengths[0], &symbols[0]);
+
+	for (size_t i = 0; ; i++) {
+		uint32 symbol = 0;
+
+		try {
+			symbol = getSymbolReference(referenceBitStream, codes.size(), &codes[0], &lengths[0],
+			                            &symbols[0], maxLength);
+		} catch (...) {
+			EXPECT_THROW(huffman.getSymbol(testBitStream), Common::Exception) << "At index " << i;
+			break;
+		}
+
+		ASSERT_EQ(huffman.getSymbol(testBitStream), symbol) << "At index " << i;
+		ASSERT_EQ(testBitStream.pos(), referenceBitStream.pos()) << "At index " << i;
+	}
+}
+
+GTEST_TEST(Huffman, randomShortCodes) {
+	testRandomCodes<Common::BitStream8MSB>   (0x1234567, 16, 8);
+	testRandomCodes<Common::BitStream32LELSB>(0x1234567, 16, 8);
+}
+
+GTEST_TEST(Huffman, randomLongCodes) {
+	testRandomCodes<Common::BitStream8MSB>   (0x7654321, 300, 24);
+	testRandomCodes<Common::BitStream32LELSB>(0x7654321, 300, 24);
+	testRandomCodes<Common::BitStream16LEMSB>(0xDEADBEE, 1000, 32);
+	testRandomCodes<Common::BitStream8LSB>   (0xDEADBEE, 1000, 32);
+}
@@ -0,0 +1,138 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our memory-mapped file read stream.
+ */
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/scopedptr.h"
+#include "src/common/platform.h"
+#include "src/common/mappedfile.h"
+
+static const byte kData[8] = { 0x12, 0x34, 0x56, 0x78, 0x90, 0xAB, 0xCD, 0xEF };
+
+boost::filesystem::path kFilePath;
+boost::filesystem::path kEmptyFilePath;
+
+class MappedReadStream : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		boost::filesystem::path tmpPath = boost::filesystem::temp_directory_path();
+
+		kFilePath      = tmpPath / boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+		kEmptyFilePath = tmpPath / boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		boost::filesystem::ofstream testFile(kFilePath, std::ofstream::binary);
+		testFile.write(reinterpret_cast<const char *>(kData), ARRAYSIZE(kData));
+		testFile.close();
+
+		boost::filesystem::ofstream emptyFile(kEmptyFilePath, std::ofstream::binary);
+		emptyFile.close();
+	}
+
+	static void TearDownTestCase() {
+		if (!kFilePath.empty())
+			boost::filesystem::remove(kFilePath);
+		if (!kEmptyFilePath.empty())
+			boost::filesystem::remove(kEmptyFilePath);
+	}
+};
+
+GTEST_TEST_F(MappedReadStream, read) {
+	Common::MappedReadStream file(kFilePath.generic_string());
+
+	ASSERT_EQ(file.size(), ARRAYSIZE(kData));
+
+	byte readData[ARRAYSIZE(kData)];
+	EXPECT_EQ(file.read(readData, sizeof(readData)), ARRAYSIZE(kData));
+
+	for (size_t i = 0; i < ARRAYSIZE(kData); i++)
+		EXPECT_EQ(readData[i], kData[i]) << "At index " << i;
+
+	EXPECT_EQ(file.read(readData, 1), 0);
+	EXPECT_TRUE(file.eos());
+
+	file.seek(2);
+	EXPECT_EQ(file.readUint16BE(), 0x5678);
+}
+
+GTEST_TEST_F(MappedReadStream, getSubStream) {
+	Common::MappedReadStream file(kFilePath.generic_string());
+
+	file.seek(5);
+
+	Common::ScopedPtr<Common::MappedReadStream> sub(file.getSubStream(2, 6));
+
+	// The sub stream is independent of the position of its parent
+	EXPECT_EQ(file.pos(), 5);
+
+	ASSERT_EQ(sub->size(), 4);
+	EXPECT_EQ(sub->pos(), 0);
+	EXPECT_EQ(sub->getData(), file.getData() + 2);
+
+	EXPECT_EQ(sub->readUint32BE(), 0x567890ABU);
+	EXPECT_EQ(file.readByte(), 0xAB);
+
+	// Sub streams of sub streams are relative to their parent
+	Common::ScopedPtr<Common::MappedReadStream> subSub(sub->getSubStream(1, 3));
+
+	ASSERT_EQ(subSub->size(), 2);
+	EXPECT_EQ(subSub->readUint16BE(), 0x7890);
+
+	EXPECT_THROW(file.getSubStream(4, 9), Common::Exception);
+	EXPECT_THROW(file.getSubStream(5, 4), Common::Exception);
+	EXPECT_THROW(sub->getSubStream(0, 5), Common::Exception);
+}
+
+GTEST_TEST_F(MappedReadStream, outliveParent) {
+	Common::ScopedPtr<Common::MappedReadStream> file(new Common::MappedReadStream(kFilePath.generic_string()));
+	Common::ScopedPtr<Common::MappedReadStream> sub(file->getSubStream(4, 8));
+
+	// The sub stream keeps the mapping alive
+	file.reset();
+
+	EXPECT_EQ(sub->readUint32BE(), 0x90ABCDEFU);
+}
+
+GTEST_TEST_F(MappedReadStream, emptyFile) {
+	Common::MappedReadStream file(kEmptyFilePath.generic_string());
+
+	EXPECT_EQ(file.size(), 0);
+
+	byte readData[1];
+	EXPECT_EQ(file.read(readData, 1), 0);
+	EXPECT_TRUE(file.eos());
+}
+
+GTEST_TEST_F(MappedReadStream, missingFile) {
+	boost::filesystem::path missingPath = boost::filesystem::temp_directory_path() /
+	                                      boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+	EXPECT_THROW(Common::MappedReadStream file(missingPath.generic_string()), Common::Exception);
+}
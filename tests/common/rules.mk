@@ -90,6 +90,11 @@ tests_common_test_readfile_SOURCES  = tests/common/readfile.cpp
 tests_common_test_readfile_LDADD    = $(common_LIBS)
 tests_common_test_readfile_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                       += tests/common/test_mappedfile
+tests_common_test_mappedfile_SOURCES  = tests/common/mappedfile.cpp
+tests_common_test_mappedfile_LDADD    = $(common_LIBS)
+tests_common_test_mappedfile_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                      += tests/common/test_writefile
 tests_common_test_writefile_SOURCES  = tests/common/writefile.cpp
 tests_common_test_writefile_LDADD    = $(common_LIBS)
@@ -260,3 +265,13 @@ check_PROGRAMS                     += tests/common/test_aabbnode
 tests_common_test_aabbnode_SOURCES  = tests/common/aabbnode.cpp
 tests_common_test_aabbnode_LDADD    = $(common_LIBS)
 tests_common_test_aabbnode_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                    += tests/common/test_frustum
+tests_common_test_frustum_SOURCES  = tests/common/frustum.cpp
+tests_common_test_frustum_LDADD    = $(common_LIBS)
+tests_common_test_frustum_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                       += tests/common/test_threadpool
+tests_common_test_threadpool_SOURCES  = tests/common/threadpool.cpp
+tests_common_test_threadpool_LDADD    = $(common_LIBS)
+tests_common_test_threadpool_CXXFLAGS = $(test_CXXFLAGS)
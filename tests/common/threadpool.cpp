@@ -0,0 +1,135 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our thread pool.
+ */
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/threadpool.h"
+#include "src/common/error.h"
+
+GTEST_TEST(ThreadPool, threadCount) {
+	Common::ThreadPool pool(3);
+
+	EXPECT_EQ(pool.getThreadCount(), 3U);
+	EXPECT_FALSE(pool.isWorkerThread());
+
+	Common::TaskGroup group(pool);
+
+	std::atomic<bool> onWorker(false);
+	group.run([&]() {
+		onWorker = pool.isWorkerThread();
+	});
+
+	// Keep the main thread from running the task itself
+	while (!onWorker)
+		std::this_thread::yield();
+
+	group.wait();
+	EXPECT_TRUE(onWorker);
+}
+
+GTEST_TEST(ThreadPool, taskGroup) {
+	Common::ThreadPool pool(2);
+
+	std::atomic<int> count(0);
+
+	Common::TaskGroup group(pool);
+	for (int i = 0; i < 100; i++)
+		group.run([&]() { count++; });
+
+	group.wait();
+	EXPECT_EQ(count, 100);
+
+	// A group can be reused after waiting
+	group.run([&]() { count++; });
+	group.wait();
+	EXPECT_EQ(count, 101);
+}
+
+GTEST_TEST(ThreadPool, exception) {
+	Common::ThreadPool pool(2);
+
+	std::atomic<int> count(0);
+
+	Common::TaskGroup group(pool);
+	group.run([&]() { count++; });
+	group.run([]() { throw Common::Exception("Nope"); });
+	group.run([&]() { count++; });
+
+	EXPECT_THROW(group.wait(), Common::Exception);
+	EXPECT_EQ(count, 2);
+
+	// The exception has been consumed
+	EXPECT_NO_THROW(group.wait());
+}
+
+GTEST_TEST(ThreadPool, nested) {
+	// Waiting for a group from within a task must not deadlock, even with a single worker
+	Common::ThreadPool pool(1);
+
+	std::atomic<int> count(0);
+
+	Common::TaskGroup outer(pool);
+	for (int i = 0; i < 4; i++) {
+		outer.run([&]() {
+			Common::TaskGroup inner(pool);
+			for (int j = 0; j < 4; j++)
+				inner.run([&]() { count++; });
+
+			inner.wait();
+		});
+	}
+
+	outer.wait();
+	EXPECT_EQ(count, 16);
+}
+
+GTEST_TEST(ThreadPool, priority) {
+	std::vector<int> order;
+
+	{
+		Common::ThreadPool pool(1);
+
+		// Block the only worker until everything is queued
+		std::promise<void> queued;
+		std::shared_future<void> queuedFuture = queued.get_future().share();
+		pool.run([queuedFuture]() { queuedFuture.wait(); });
+
+		pool.run([&]() { order.push_back(1); });
+		pool.run([&]() { order.push_back(2); }, Common::ThreadPool::kPriorityHigh);
+		pool.run([&]() { order.push_back(3); });
+
+		queued.set_value();
+
+		// The pool runs all queued tasks before it's destroyed
+	}
+
+	ASSERT_EQ(order.size(), 3U);
+	EXPECT_EQ(order[0], 2);
+	EXPECT_EQ(order[1], 1);
+	EXPECT_EQ(order[2], 3);
+}
@@ -0,0 +1,266 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+  *  Unit tests for the Engines::AStar class.
+  */
+
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+
+#include "src/engines/aurora/astar.h"
+#include "src/engines/aurora/pathfinding.h"
+
+namespace Engines {
+
+static const bool kWalkableProperties[] = { false, true };
+
+/** A synthetic walkmesh: a grid of unit-sized square faces. */
+class GridPathfinding : public Pathfinding {
+public:
+	GridPathfinding(uint32 width, uint32 height);
+
+	void setWall(uint32 x, uint32 y);
+
+	uint32 getFace(uint32 x, uint32 y) const;
+	bool adjacent(uint32 faceA, uint32 faceB) const;
+
+protected:
+	uint32 findFace(float x, float y, bool onlyWalkable);
+
+private:
+	uint32 _width;
+	uint32 _height;
+};
+
+GridPathfinding::GridPathfinding(uint32 width, uint32 height) :
+	Pathfinding(std::vector<bool>(kWalkableProperties, kWalkableProperties + ARRAYSIZE(kWalkableProperties)), 4),
+	_width(width), _height(height) {
+
+	_facesCount    = _width * _height;
+	_verticesCount = (_width + 1) * (_height + 1);
+
+	_vertices.resize(_verticesCount * 3);
+	for (uint32 y = 0; y <= _height; ++y) {
+		for (uint32 x = 0; x <= _width; ++x) {
+			const uint32 vertexID = x + y * (_width + 1);
+
+			_vertices[3 * vertexID + 0] = x;
+			_vertices[3 * vertexID + 1] = y;
+			_vertices[3 * vertexID + 2] = 0.f;
+		}
+	}
+
+	_faces.resize(_facesCount * 4);
+	_adjFaces.resize(_facesCount * 4);
+	_faceProperty.resize(_facesCount, 1);
+
+	for (uint32 y = 0; y < _height; ++y) {
+		for (uint32 x = 0; x < _width; ++x) {
+			const uint32 face = getFace(x, y);
+
+			_faces[4 * face + 0] = x     + (y       * (_width + 1));
+			_faces[4 * face + 1] = x + 1 + (y       * (_width + 1));
+			_faces[4 * face + 2] = x + 1 + ((y + 1) * (_width + 1));
+			_faces[4 * face + 3] = x     + ((y + 1) * (_width + 1));
+
+			_adjFaces[4 * face + 0] = (y != 0)           ? face - _width : UINT32_MAX;
+			_adjFaces[4 * face + 1] = (x != _width - 1)  ? face + 1      : UINT32_MAX;
+			_adjFaces[4 * face + 2] = (y != _height - 1) ? face + _width : UINT32_MAX;
+			_adjFaces[4 * face + 3] = (x != 0)           ? face - 1      : UINT32_MAX;
+		}
+	}
+}
+
+void GridPathfinding::setWall(uint32 x, uint32 y) {
+	_faceProperty[getFace(x, y)] = 0;
+}
+
+uint32 GridPathfinding::getFace(uint32 x, uint32 y) const {
+	return x + y * _width;
+}
+
+bool GridPathfinding::adjacent(uint32 faceA, uint32 faceB) const {
+	for (uint32 i = 0; i < 4; ++i)
+		if (_adjFaces[4 * faceA + i] == faceB)
+			return true;
+
+	return false;
+}
+
+uint32 GridPathfinding::findFace(float x, float y, bool onlyWalkable) {
+	if ((x < 0.f) || (y < 0.f) || (x >= _width) || (y >= _height))
+		return UINT32_MAX;
+
+	const uint32 face = getFace(static_cast<uint32>(x), static_cast<uint32>(y));
+	if (onlyWalkable && !faceWalkable(face))
+		return UINT32_MAX;
+
+	return face;
+}
+
+static void checkPath(const GridPathfinding &grid, const std::vector<uint32> &path,
+                      uint32 startFace, uint32 endFace) {
+
+	ASSERT_FALSE(path.empty());
+
+	EXPECT_EQ(path.front(), startFace);
+	EXPECT_EQ(path.back(), endFace);
+
+	for (size_t i = 1; i < path.size(); ++i) {
+		EXPECT_TRUE(grid.adjacent(path[i - 1], path[i])) << "At index " << i;
+		EXPECT_TRUE(grid.faceWalkable(path[i])) << "At index " << i;
+	}
+}
+
+GTEST_TEST(AStar, sameFace) {
+	GridPathfinding grid(4, 4);
+	AStar aStar(&grid);
+
+	std::vector<uint32> path;
+	EXPECT_TRUE(aStar.findPath(1.2f, 1.2f, 1.8f, 1.7f, path));
+
+	ASSERT_EQ(path.size(), 1);
+	EXPECT_EQ(path[0], grid.getFace(1, 1));
+}
+
+GTEST_TEST(AStar, outside) {
+	GridPathfinding grid(4, 4);
+	AStar aStar(&grid);
+
+	std::vector<uint32> path;
+	EXPECT_FALSE(aStar.findPath(1.5f, 1.5f, 10.5f, 1.5f, path));
+	EXPECT_TRUE(path.empty());
+}
+
+GTEST_TEST(AStar, straight) {
+	GridPathfinding grid(16, 16);
+	AStar aStar(&grid);
+
+	std::vector<uint32> path;
+	EXPECT_TRUE(aStar.findPath(0.5f, 3.5f, 15.5f, 3.5f, path));
+
+	checkPath(grid, path, grid.getFace(0, 3), grid.getFace(15, 3));
+	EXPECT_EQ(path.size(), 16);
+}
+
+GTEST_TEST(AStar, diagonal) {
+	GridPathfinding grid(16, 16);
+	AStar aStar(&grid);
+
+	std::vector<uint32> path;
+	EXPECT_TRUE(aStar.findPath(0.5f, 0.5f, 15.5f, 15.5f, path));
+
+	checkPath(grid, path, grid.getFace(0, 0), grid.getFace(15, 15));
+	EXPECT_EQ(path.size(), 31);
+}
+
+GTEST_TEST(AStar, wallWithGap) {
+	GridPathfinding grid(16, 16);
+
+	// Vertical wall at x = 8, with a single gap at y = 14.
+	for (uint32 y = 0; y < 16; ++y)
+		if (y != 14)
+			grid.setWall(8, y);
+
+	AStar aStar(&grid);
+
+	std::vector<uint32> path;
+	EXPECT_TRUE(aStar.findPath(2.5f, 2.5f, 13.5f, 2.5f, path));
+
+	checkPath(grid, path, grid.getFace(2, 2), grid.getFace(13, 2));
+	EXPECT_NE(std::find(path.begin(), path.end(), grid.getFace(8, 14)), path.end());
+}
+
+GTEST_TEST(AStar, unreachable) {
+	GridPathfinding grid(16, 16);
+
+	// Closed vertical wall at x = 8.
+	for (uint32 y = 0; y < 16; ++y)
+		grid.setWall(8, y);
+
+	AStar aStar(&grid);
+
+	std::vector<uint32> path;
+	EXPECT_FALSE(aStar.findPath(2.5f, 5.5f, 13.5f, 5.5f, path));
+
+	/* We should get the path to the node closest to the end point. Nodes lie
+	 * on the edges they were entered through. The closest ones are on the
+	 * edges between faces in front of the wall, at (7.5, 5) and (7.5, 6).
+	 * The first of them found is (7, 4), entered from (7, 5). */
+	checkPath(grid, path, grid.getFace(2, 5), grid.getFace(7, 4));
+}
+
+GTEST_TEST(AStar, iterationLimit) {
+	GridPathfinding grid(16, 16);
+	AStar aStar(&grid);
+
+	std::vector<uint32> path;
+	EXPECT_FALSE(aStar.findPath(0.5f, 0.5f, 15.5f, 15.5f, path, 0.f, 4));
+
+	ASSERT_FALSE(path.empty());
+	EXPECT_EQ(path.front(), grid.getFace(0, 0));
+}
+
+GTEST_TEST(AStar, replay) {
+	// Recorded start/end pairs, replayed on a walkmesh with a few obstacles.
+	static const float kQueries[][4] = {
+		{  0.5f,  0.5f, 31.5f, 31.5f }, { 31.5f,  0.5f,  0.5f, 31.5f },
+		{ 12.2f, 30.1f, 14.8f,  1.3f }, {  3.3f, 17.7f, 28.4f, 17.2f },
+		{ 20.5f, 20.5f, 20.5f, 21.5f }, { 15.5f,  9.5f, 17.5f, 25.5f },
+		{  1.1f, 30.9f, 30.9f,  1.1f }, { 25.0f,  5.0f,  5.0f, 25.0f },
+		{  0.5f,  0.5f, 31.5f, 31.5f }, {  9.9f,  9.9f,  9.9f, 22.2f }
+	};
+
+	GridPathfinding grid(32, 32);
+
+	for (uint32 i = 4; i < 28; ++i) {
+		grid.setWall(i, 16);
+		grid.setWall(16, i);
+	}
+
+	// Reusing one A* object must give the same result as fresh ones.
+	AStar reused(&grid);
+
+	for (size_t i = 0; i < ARRAYSIZE(kQueries); ++i) {
+		const float *q = kQueries[i];
+
+		std::vector<uint32> pathReused;
+		const bool foundReused = reused.findPath(q[0], q[1], q[2], q[3], pathReused);
+
+		AStar fresh(&grid);
+
+		std::vector<uint32> pathFresh;
+		const bool foundFresh = fresh.findPath(q[0], q[1], q[2], q[3], pathFresh);
+
+		EXPECT_TRUE(foundReused) << "At query " << i;
+		EXPECT_EQ(foundReused, foundFresh) << "At query " << i;
+		EXPECT_EQ(pathReused, pathFresh) << "At query " << i;
+
+		checkPath(grid, pathReused,
+		          grid.getFace(static_cast<uint32>(q[0]), static_cast<uint32>(q[1])),
+		          grid.getFace(static_cast<uint32>(q[2]), static_cast<uint32>(q[3])));
+	}
+}
+
+} // End of namespace Engines
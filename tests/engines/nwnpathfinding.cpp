@@ -0,0 +1,315 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+  *  Unit tests for loading the tile walkmeshes of NWN areas.
+  */
+
+#include <cstring>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/ustring.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+#include "src/common/aabbnode.h"
+#include "src/common/writefile.h"
+
+#include "src/aurora/resman.h"
+
+#include "src/engines/nwn/pathfinding.h"
+
+/** A square tile, made out of two faces. */
+static const char * const kTileSquare =
+	"# A square tile\n"
+	"beginwalkmeshgeom tile_square\n"
+	"node aabb tile_square\n"
+	"  parent NULL\n"
+	"  position 0.0 0.0 0.0\n"
+	"  orientation 0.0 0.0 0.0 0.0\n"
+	"  verts 4\n"
+	"    -5.0 -5.0 0.0\n"
+	"    5.0 -5.0 0.0\n"
+	"    5.0 5.0 0.0\n"
+	"    -5.0 5.0 0.0\n"
+	"  faces 2\n"
+	"    0 1 2 1 0 0 0 4\n"
+	"    0 2 3 1 0 0 0 4\n"
+	"  aabb -5.0 -5.0 0.0 5.0 5.0 0.0 -1\n"
+	"    -5.0 -5.0 0.0 5.0 5.0 0.0 0\n"
+	"    -5.0 -5.0 0.0 5.0 5.0 0.0 1\n"
+	"endnode\n"
+	"endwalkmeshgeom tile_square\n";
+
+/** A raised tile, made out of four faces around its center, one of them not walkable. */
+static const char * const kTileRaised =
+	"beginwalkmeshgeom tile_raised\n"
+	"node aabb tile_raised\n"
+	"  parent NULL\n"
+	"  position 0.0 0.0 1.0\n"
+	"  orientation 0.0 0.0 0.0 0.0\n"
+	"  verts 6\n"
+	"    -5.0 -5.0 0.0\n"
+	"    5.0 -5.0 0.0\n"
+	"    5.0 5.0 0.0\n"
+	"    -5.0 5.0 0.0\n"
+	"    0.0 0.0 0.0\n"
+	"    -5.0 -5.0 0.0\n"
+	"  faces 4\n"
+	"    5 1 4 1 0 0 0 4\n"
+	"    1 2 4 1 0 0 0 4\n"
+	"    2 3 4 1 0 0 0 4\n"
+	"    3 0 4 1 0 0 0 7\n"
+	"  aabb -5.0 -5.0 0.0 5.0 5.0 0.0 -1\n"
+	"    -5.0 -5.0 0.0 5.0 0.0 0.0 -1\n"
+	"      -5.0 -5.0 0.0 5.0 0.0 0.0 0\n"
+	"      0.0 -5.0 0.0 5.0 5.0 0.0 1\n"
+	"    -5.0 -5.0 0.0 5.0 5.0 0.0 -1\n"
+	"      -5.0 0.0 0.0 5.0 5.0 0.0 2\n"
+	"      -5.0 -5.0 0.0 0.0 5.0 0.0 3\n"
+	"endnode\n"
+	"endwalkmeshgeom tile_raised\n";
+
+/** A tile whose faces end in the middle of the file. */
+static const char * const kTileBroken =
+	"node aabb tile_broken\n"
+	"  verts 3\n"
+	"    -5.0 -5.0 0.0\n"
+	"    5.0 -5.0 0.0\n"
+	"    5.0 5.0 0.0\n"
+	"  faces 1\n"
+	"    0 1 2\n"
+	"endnode\n";
+
+static const uint32 kAreaWidth  = 4;
+static const uint32 kAreaHeight = 3;
+
+static boost::filesystem::path kDataPath;
+
+static void writeWalkmesh(const char *name, const char *data) {
+	Common::WriteFile file((kDataPath / (Common::UString(name) + ".wok").c_str()).generic_string());
+
+	file.write(data, std::strlen(data));
+	file.flush();
+}
+
+static std::vector<bool> getWalkableProperties() {
+	std::vector<bool> walkable(8, false);
+	walkable[4] = true;
+
+	return walkable;
+}
+
+/** A NWN pathfinding object that allows looking into the loaded walkmesh. */
+class TestPathfinding : public Engines::NWN::Pathfinding {
+public:
+	TestPathfinding() : Engines::NWN::Pathfinding(getWalkableProperties()) {
+	}
+
+	void compare(const TestPathfinding &other) const {
+		EXPECT_EQ(_vertices    , other._vertices);
+		EXPECT_EQ(_faces       , other._faces);
+		EXPECT_EQ(_adjFaces    , other._adjFaces);
+		EXPECT_EQ(_faceProperty, other._faceProperty);
+
+		ASSERT_EQ(_AABBTrees.size(), other._AABBTrees.size());
+		for (size_t i = 0; i < _AABBTrees.size(); i++) {
+			ASSERT_EQ(_AABBTrees[i] == 0, other._AABBTrees[i] == 0) << "At tile " << i;
+			if (!_AABBTrees[i])
+				continue;
+
+			std::vector<Common::AABBNode *> leaves, otherLeaves;
+			_AABBTrees[i]->getLeaves(leaves);
+			other._AABBTrees[i]->getLeaves(otherLeaves);
+
+			ASSERT_EQ(leaves.size(), otherLeaves.size()) << "At tile " << i;
+			for (size_t j = 0; j < leaves.size(); j++) {
+				float min[3], max[3], otherMin[3], otherMax[3];
+				leaves[j]->getMin(min[0], min[1], min[2]);
+				leaves[j]->getMax(max[0], max[1], max[2]);
+				otherLeaves[j]->getMin(otherMin[0], otherMin[1], otherMin[2]);
+				otherLeaves[j]->getMax(otherMax[0], otherMax[1], otherMax[2]);
+
+				EXPECT_EQ(std::memcmp(min, otherMin, sizeof(min)), 0) << "At tile " << i << ", leaf " << j;
+				EXPECT_EQ(std::memcmp(max, otherMax, sizeof(max)), 0) << "At tile " << i << ", leaf " << j;
+				EXPECT_EQ(leaves[j]->getProperty(), otherLeaves[j]->getProperty()) << "At tile " << i << ", leaf " << j;
+			}
+		}
+	}
+
+	size_t getTileCount() const {
+		return _AABBTrees.size();
+	}
+
+	bool hasTileWalkmesh(size_t tile) const {
+		return _AABBTrees[tile] != 0;
+	}
+};
+
+class NWNPathfinding : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		kDataPath = boost::filesystem::temp_directory_path() /
+		            boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		boost::filesystem::create_directory(kDataPath);
+
+		writeWalkmesh("tile_square", kTileSquare);
+		writeWalkmesh("tile_raised", kTileRaised);
+		writeWalkmesh("tile_broken", kTileBroken);
+
+		ResMan.registerDataBase(kDataPath.generic_string());
+		ResMan.indexResourceFile("tile_square.wok", 10);
+		ResMan.indexResourceFile("tile_raised.wok", 10);
+		ResMan.indexResourceFile("tile_broken.wok", 10);
+	}
+
+	static void TearDownTestCase() {
+		ResMan.clear();
+
+		boost::system::error_code error;
+		boost::filesystem::remove_all(kDataPath, error);
+	}
+
+	/** Lay out an area, like Engines::NWN::Area does, with each tile turned a different way. */
+	static std::vector<Engines::NWN::Pathfinding::TileDefinition> getTiles(bool missing) {
+		static const char * const kNames[] = { "tile_square", "tile_raised", "TILE_SQUARE" };
+
+		std::vector<Engines::NWN::Pathfinding::TileDefinition> tiles(kAreaWidth * kAreaHeight);
+		for (uint32 y = 0; y < kAreaHeight; y++) {
+			for (uint32 x = 0; x < kAreaWidth; x++) {
+				const uint32 n = y * kAreaWidth + x;
+
+				Engines::NWN::Pathfinding::TileDefinition &tile = tiles[n];
+
+				tile.wokFile = kNames[n % ARRAYSIZE(kNames)];
+				if (missing && (n == 5))
+					tile.wokFile = "tile_missing";
+
+				tile.orientation[0] = 0.0f;
+				tile.orientation[1] = 0.0f;
+				tile.orientation[2] = 1.0f;
+				tile.orientation[3] = (n % 4) * (float) M_PI * 0.5f;
+
+				tile.position[0] = x * 10.0f + 5.0f;
+				tile.position[1] = y * 10.0f + 5.0f;
+				tile.position[2] = 2.0f;
+			}
+		}
+
+		return tiles;
+	}
+
+	/** Add the tiles one by one, parsing each walkmesh again. */
+	static void addSingleTiles(TestPathfinding &pathfinding,
+	                           const std::vector<Engines::NWN::Pathfinding::TileDefinition> &tiles) {
+
+		for (size_t i = 0; i < tiles.size(); i++) {
+			float orientation[4], position[3];
+			std::memcpy(orientation, tiles[i].orientation, sizeof(orientation));
+			std::memcpy(position   , tiles[i].position   , sizeof(position));
+
+			pathfinding.addTile(tiles[i].wokFile, orientation, position);
+		}
+
+		pathfinding.finalize();
+	}
+};
+
+GTEST_TEST_F(NWNPathfinding, addTilesMatchesAddTile) {
+	const std::vector<Engines::NWN::Pathfinding::TileDefinition> tiles = getTiles(false);
+
+	TestPathfinding single, shared;
+
+	addSingleTiles(single, tiles);
+
+	shared.addTiles(tiles);
+	shared.finalize();
+
+	ASSERT_EQ(shared.getTileCount(), tiles.size());
+
+	shared.compare(single);
+}
+
+GTEST_TEST_F(NWNPathfinding, placeTiles) {
+	TestPathfinding pathfinding;
+
+	pathfinding.addTiles(getTiles(false));
+	pathfinding.finalize();
+
+	for (uint32 y = 0; y < kAreaHeight; y++) {
+		for (uint32 x = 0; x < kAreaWidth; x++) {
+			const uint32 n = y * kAreaWidth + x;
+
+			// Tile walkmeshes are shifted by the position of their node
+			const float height = ((n % 3) == 1) ? 3.0f : 2.0f;
+
+			EXPECT_FLOAT_EQ(pathfinding.getHeight(x * 10.0f + 2.5f, y * 10.0f + 5.5f), height) << "At tile " << n;
+		}
+	}
+
+}
+
+GTEST_TEST_F(NWNPathfinding, connectTiles) {
+	std::vector<Engines::NWN::Pathfinding::TileDefinition> tiles = getTiles(false);
+	for (size_t i = 0; i < tiles.size(); i++)
+		tiles[i].wokFile = "tile_square";
+
+	TestPathfinding pathfinding;
+
+	pathfinding.addTiles(tiles);
+	pathfinding.finalize();
+
+	// The tiles are connected, so we can walk from one corner of the area to the other
+	std::vector<uint32> path;
+	EXPECT_TRUE(pathfinding.findPath(1.0f, 1.0f, kAreaWidth * 10.0f - 1.0f, kAreaHeight * 10.0f - 1.0f, path));
+	EXPECT_GT(path.size(), 2);
+}
+
+GTEST_TEST_F(NWNPathfinding, missingWalkmesh) {
+	const std::vector<Engines::NWN::Pathfinding::TileDefinition> tiles = getTiles(true);
+
+	TestPathfinding single, shared;
+
+	addSingleTiles(single, tiles);
+
+	shared.addTiles(tiles);
+	shared.finalize();
+
+	ASSERT_EQ(shared.getTileCount(), tiles.size());
+	EXPECT_FALSE(shared.hasTileWalkmesh(5));
+	EXPECT_TRUE(shared.hasTileWalkmesh(4));
+
+	shared.compare(single);
+}
+
+GTEST_TEST_F(NWNPathfinding, brokenWalkmesh) {
+	std::vector<Engines::NWN::Pathfinding::TileDefinition> tiles = getTiles(false);
+	tiles[7].wokFile = "tile_broken";
+
+	TestPathfinding pathfinding;
+	EXPECT_THROW(pathfinding.addTiles(tiles), Common::Exception);
+}
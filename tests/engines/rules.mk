@@ -33,3 +33,15 @@ check_PROGRAMS                     += tests/engines/test_trigger
 tests_engines_test_trigger_SOURCES  = tests/engines/trigger.cpp
 tests_engines_test_trigger_LDADD    = $(engines_LIBS)
 tests_engines_test_trigger_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                   += tests/engines/test_astar
+tests_engines_test_astar_SOURCES  = tests/engines/astar.cpp
+tests_engines_test_astar_LDADD    = $(engines_LIBS)
+tests_engines_test_astar_CXXFLAGS = $(test_CXXFLAGS)
+
+if ENABLE_NWN
+check_PROGRAMS                            += tests/engines/test_nwnpathfinding
+tests_engines_test_nwnpathfinding_SOURCES  = tests/engines/nwnpathfinding.cpp
+tests_engines_test_nwnpathfinding_LDADD    = src/engines/nwn/libnwn.la $(engines_LIBS)
+tests_engines_test_nwnpathfinding_CXXFLAGS = $(test_CXXFLAGS)
+endif
@@ -0,0 +1,169 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for finding the keyframes of an animation.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/graphics/aurora/animation.h"
+
+struct KeyFrame {
+	float time;
+};
+
+using Graphics::Aurora::Animation;
+
+/** Keyframes at 0.0, 0.5, 1.0, ... */
+static std::vector<KeyFrame> makeKeyFrames(size_t count) {
+	std::vector<KeyFrame> frames(count);
+	for (size_t i = 0; i < count; i++)
+		frames[i].time = i * 0.5f;
+
+	return frames;
+}
+
+/** Find the keyframe by scanning all of them from the start. */
+static size_t findKeyFrameLinear(const std::vector<KeyFrame> &frames, float time) {
+	size_t frame = 0;
+	for (size_t i = 1; i < frames.size(); i++)
+		if (frames[i].time < time)
+			frame = i;
+
+	return frame;
+}
+
+GTEST_TEST(AnimationKeyFrames, forward) {
+	const std::vector<KeyFrame> frames = makeKeyFrames(20);
+
+	size_t cursor = 0;
+	for (float time = 0.0f; time < 11.0f; time += 0.05f) {
+		const size_t lastCursor = cursor;
+
+		const size_t frame = Animation::findKeyFrame(frames, time, cursor);
+
+		EXPECT_EQ(frame, findKeyFrameLinear(frames, time)) << "At " << time;
+		EXPECT_EQ(cursor, frame) << "At " << time;
+
+		// Playing forward, the cursor only ever moves forward, one keyframe at a time
+		EXPECT_GE(cursor, lastCursor) << "At " << time;
+		EXPECT_LE(cursor, lastCursor + 1) << "At " << time;
+	}
+
+	EXPECT_EQ(cursor, frames.size() - 1);
+}
+
+GTEST_TEST(AnimationKeyFrames, keyFrameTimes) {
+	const std::vector<KeyFrame> frames = makeKeyFrames(4);
+
+	// On a keyframe, we still interpolate from the keyframe before it
+	size_t cursor = 0;
+	EXPECT_EQ(Animation::findKeyFrame(frames, 0.0f, cursor), 0);
+	EXPECT_EQ(Animation::findKeyFrame(frames, 0.5f, cursor), 0);
+	EXPECT_EQ(Animation::findKeyFrame(frames, 1.0f, cursor), 1);
+	EXPECT_EQ(Animation::findKeyFrame(frames, 1.5f, cursor), 2);
+	EXPECT_EQ(Animation::findKeyFrame(frames, 1.6f, cursor), 3);
+
+	// Before the first keyframe
+	EXPECT_EQ(Animation::findKeyFrame(frames, -1.0f, cursor), 0);
+	EXPECT_EQ(cursor, 0);
+}
+
+GTEST_TEST(AnimationKeyFrames, seekBackward) {
+	const std::vector<KeyFrame> frames = makeKeyFrames(20);
+
+	size_t cursor = 0;
+	EXPECT_EQ(Animation::findKeyFrame(frames, 8.2f, cursor), 16);
+	EXPECT_EQ(cursor, 16);
+
+	// One keyframe back
+	EXPECT_EQ(Animation::findKeyFrame(frames, 7.8f, cursor), 15);
+	EXPECT_EQ(cursor, 15);
+
+	// A long way back
+	EXPECT_EQ(Animation::findKeyFrame(frames, 2.2f, cursor), 4);
+	EXPECT_EQ(cursor, 4);
+
+	// And forward again from there
+	EXPECT_EQ(Animation::findKeyFrame(frames, 2.6f, cursor), 5);
+	EXPECT_EQ(cursor, 5);
+
+	// Every jump in both directions, from every keyframe
+	for (size_t from = 0; from < frames.size(); from++) {
+		for (float time = -0.25f; time < 10.5f; time += 0.25f) {
+			cursor = from;
+
+			const size_t frame = Animation::findKeyFrame(frames, time, cursor);
+
+			EXPECT_EQ(frame, findKeyFrameLinear(frames, time)) << "From " << from << " to " << time;
+			EXPECT_EQ(cursor, frame) << "From " << from << " to " << time;
+		}
+	}
+}
+
+GTEST_TEST(AnimationKeyFrames, loop) {
+	const std::vector<KeyFrame> frames = makeKeyFrames(8);
+	const float length = 3.5f;
+
+	// Play the animation in a loop three times, wrapping the time around at its end
+	size_t cursor = 0;
+	float time = 0.0f;
+	for (size_t i = 0; i < 3 * 40; i++) {
+		time += length / 37.0f;
+		if (time > length)
+			time -= length;
+
+		const size_t frame = Animation::findKeyFrame(frames, time, cursor);
+
+		EXPECT_EQ(frame, findKeyFrameLinear(frames, time)) << "At " << time;
+		EXPECT_EQ(cursor, frame) << "At " << time;
+	}
+
+	// Right at the wrap-around, from the last keyframe back to the first
+	cursor = frames.size() - 1;
+	EXPECT_EQ(Animation::findKeyFrame(frames, 0.1f, cursor), 0);
+	EXPECT_EQ(cursor, 0);
+}
+
+GTEST_TEST(AnimationKeyFrames, single) {
+	const std::vector<KeyFrame> frames = makeKeyFrames(1);
+
+	size_t cursor = 0;
+	EXPECT_EQ(Animation::findKeyFrame(frames, -1.0f, cursor), 0);
+	EXPECT_EQ(Animation::findKeyFrame(frames,  0.0f, cursor), 0);
+	EXPECT_EQ(Animation::findKeyFrame(frames,  1.0f, cursor), 0);
+	EXPECT_EQ(cursor, 0);
+}
+
+GTEST_TEST(AnimationKeyFrames, staleCursor) {
+	const std::vector<KeyFrame> frames = makeKeyFrames(4);
+
+	// A cursor left behind by a longer track
+	size_t cursor = 10;
+	EXPECT_EQ(Animation::findKeyFrame(frames, 0.7f, cursor), 1);
+	EXPECT_EQ(cursor, 1);
+
+	cursor = 10;
+	EXPECT_EQ(Animation::findKeyFrame(frames, 5.0f, cursor), 3);
+	EXPECT_EQ(cursor, 3);
+}
@@ -0,0 +1,210 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the graphics queue manager.
+ */
+
+#include <vector>
+#include <algorithm>
+
+#include "gtest/gtest.h"
+
+#include "src/graphics/queueman.h"
+#include "src/graphics/queueable.h"
+
+// QueueMan expects to be used from within the Graphics namespace
+using Graphics::QueueManager;
+
+static const Graphics::QueueType kQueue = Graphics::kQueueVisibleGUIBackObject;
+
+class FakeQueueable : public Graphics::Queueable {
+public:
+	FakeQueueable(int value = 0, int id = 0) : _value(value), _id(id) {
+	}
+
+	~FakeQueueable() {
+		hide();
+	}
+
+	bool operator<(const Graphics::Queueable &q) const {
+		return _value < static_cast<const FakeQueueable &>(q)._value;
+	}
+
+	int getValue() const {
+		return _value;
+	}
+
+	void setValue(int value) {
+		_value = value;
+	}
+
+	int getID() const {
+		return _id;
+	}
+
+	void show() {
+		addToQueue(kQueue);
+	}
+
+	void hide() {
+		removeFromQueue(kQueue);
+	}
+
+	bool isShown() const {
+		return isInQueue(kQueue);
+	}
+
+private:
+	int _value;
+	int _id;
+};
+
+static const FakeQueueable &getQueued(size_t i) {
+	return *static_cast<const FakeQueueable *>(QueueMan.getQueue(kQueue)[i]);
+}
+
+/** Is the queue sorted by value, with equal values in ascending ID order? */
+static bool isQueueSorted() {
+	const std::vector<Graphics::Queueable *> &queue = QueueMan.getQueue(kQueue);
+
+	for (size_t i = 1; i < queue.size(); i++) {
+		const FakeQueueable &a = getQueued(i - 1), &b = getQueued(i);
+
+		if ( a.getValue() >  b.getValue())
+			return false;
+		if ((a.getValue() == b.getValue()) && (a.getID() > b.getID()))
+			return false;
+	}
+
+	return true;
+}
+
+GTEST_TEST(QueueManager, addRemove) {
+	std::vector<FakeQueueable> objects(16);
+
+	ASSERT_TRUE(QueueMan.isQueueEmpty(kQueue));
+
+	for (size_t i = 0; i < objects.size(); i++)
+		objects[i].show();
+
+	EXPECT_EQ(QueueMan.getQueue(kQueue).size(), 16U);
+
+	// Remove the objects in an order that moves others around
+	for (size_t i = 0; i < objects.size(); i += 3)
+		objects[i].hide();
+	objects[15].hide();
+	objects[1].hide();
+
+	const std::vector<Graphics::Queueable *> &queue = QueueMan.getQueue(kQueue);
+	for (size_t i = 0; i < objects.size(); i++) {
+		const bool queued = std::find(queue.begin(), queue.end(), &objects[i]) != queue.end();
+
+		EXPECT_EQ(queued, objects[i].isShown()) << "At index " << i;
+		EXPECT_EQ(queued, (i % 3) != 0 && i != 1 && i != 15) << "At index " << i;
+	}
+
+	// Removing everything that is left has to find all of them at their new positions
+	for (size_t i = 0; i < objects.size(); i++)
+		objects[i].hide();
+
+	EXPECT_TRUE(QueueMan.isQueueEmpty(kQueue));
+}
+
+GTEST_TEST(QueueManager, generation) {
+	FakeQueueable a(1), b(2);
+
+	const uint32 generation = QueueMan.getQueueGeneration(kQueue);
+
+	a.show();
+	b.show();
+	EXPECT_NE(QueueMan.getQueueGeneration(kQueue), generation);
+
+	const uint32 shown = QueueMan.getQueueGeneration(kQueue);
+
+	QueueMan.sortQueue(kQueue);
+	EXPECT_EQ(QueueMan.getQueueGeneration(kQueue), shown);
+
+	a.hide();
+	EXPECT_NE(QueueMan.getQueueGeneration(kQueue), shown);
+
+	b.hide();
+}
+
+GTEST_TEST(QueueManager, sortQueue) {
+	std::vector<FakeQueueable> objects;
+	for (int i = 0; i < 64; i++)
+		objects.push_back(FakeQueueable((i * 37) % 11, i));
+
+	for (size_t i = 0; i < objects.size(); i++)
+		objects[i].show();
+
+	QueueMan.sortQueue(kQueue);
+	EXPECT_TRUE(isQueueSorted());
+
+	// Slight changes, the queue stays nearly sorted
+	for (size_t i = 0; i < objects.size(); i += 5)
+		objects[i].setValue(objects[i].getValue() + 1);
+
+	QueueMan.sortQueue(kQueue);
+	EXPECT_TRUE(isQueueSorted());
+
+	// Completely reverse the order
+	for (size_t i = 0; i < objects.size(); i++)
+		objects[i].setValue(-objects[i].getValue());
+
+	QueueMan.sortQueue(kQueue);
+	EXPECT_TRUE(isQueueSorted());
+
+	// Objects are still found at their new positions
+	for (size_t i = 0; i < objects.size(); i += 2)
+		objects[i].hide();
+
+	EXPECT_EQ(QueueMan.getQueue(kQueue).size(), 32U);
+
+	for (size_t i = 0; i < objects.size(); i++)
+		objects[i].hide();
+
+	EXPECT_TRUE(QueueMan.isQueueEmpty(kQueue));
+}
+
+GTEST_TEST(QueueManager, orderQueue) {
+	std::vector<FakeQueueable> objects;
+	for (int i = 0; i < 32; i++)
+		objects.push_back(FakeQueueable(i / 4, i));
+
+	for (size_t i = 0; i < objects.size(); i++)
+		objects[i].show();
+
+	QueueMan.sortQueue(kQueue);
+	ASSERT_TRUE(isQueueSorted());
+
+	// Removing moves the last object into the gap
+	objects[5].hide();
+	objects[0].hide();
+	EXPECT_FALSE(isQueueSorted());
+
+	QueueMan.orderQueue(kQueue);
+	EXPECT_TRUE(isQueueSorted());
+	EXPECT_EQ(QueueMan.getQueue(kQueue).size(), 30U);
+
+	for (size_t i = 0; i < objects.size(); i++)
+		objects[i].hide();
+}
@@ -0,0 +1,82 @@
+# xoreos - A reimplementation of BioWare's Aurora engine
+#
+# xoreos is the legal property of its developers, whose names
+# can be found in the AUTHORS file distributed with this source
+# distribution.
+#
+# xoreos is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 3
+# of the License, or (at your option) any later version.
+#
+# xoreos is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+
+
+# Unit tests for the Graphics namespace.
+
+graphics_LIBS = \
+    $(test_LIBS) \
+    src/graphics/libgraphics.la \
+    src/aurora/libaurora.la \
+    src/common/libcommon.la \
+    tests/version/libversion.la \
+    $(LDADD)
+
+check_PROGRAMS                        += tests/graphics/test_skinning
+tests_graphics_test_skinning_SOURCES  = tests/graphics/skinning.cpp
+tests_graphics_test_skinning_LDADD    = $(graphics_LIBS)
+tests_graphics_test_skinning_CXXFLAGS = $(test_CXXFLAGS)
+BENCHMARKS                            += tests/graphics/test_skinning
+
+check_PROGRAMS                          += tests/graphics/test_yuv_to_rgb
+tests_graphics_test_yuv_to_rgb_SOURCES  = tests/graphics/yuv_to_rgb.cpp
+tests_graphics_test_yuv_to_rgb_LDADD    = $(graphics_LIBS)
+tests_graphics_test_yuv_to_rgb_CXXFLAGS = $(test_CXXFLAGS)
+BENCHMARKS                              += tests/graphics/test_yuv_to_rgb
+
+check_PROGRAMS                          += tests/graphics/test_textureman
+tests_graphics_test_textureman_SOURCES  = tests/graphics/textureman.cpp
+tests_graphics_test_textureman_LDADD    = \
+    $(test_LIBS) \
+    src/graphics/libgraphics.la \
+    src/aurora/libaurora.la \
+    src/common/libcommon.la \
+    src/events/libevents.la \
+    tests/version/libversion.la \
+    $(LDADD)
+tests_graphics_test_textureman_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                               += tests/graphics/test_worldobjecttree
+tests_graphics_test_worldobjecttree_SOURCES  = tests/graphics/worldobjecttree.cpp
+tests_graphics_test_worldobjecttree_LDADD    = \
+    $(test_LIBS) \
+    src/graphics/libgraphics.la \
+    src/aurora/libaurora.la \
+    src/common/libcommon.la \
+    src/events/libevents.la \
+    tests/version/libversion.la \
+    $(LDADD)
+tests_graphics_test_worldobjecttree_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                        += tests/graphics/test_queueman
+tests_graphics_test_queueman_SOURCES  = tests/graphics/queueman.cpp
+tests_graphics_test_queueman_LDADD    = \
+    $(test_LIBS) \
+    src/graphics/libgraphics.la \
+    src/aurora/libaurora.la \
+    src/common/libcommon.la \
+    src/events/libevents.la \
+    tests/version/libversion.la \
+    $(LDADD)
+tests_graphics_test_queueman_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                         += tests/graphics/test_keyframes
+tests_graphics_test_keyframes_SOURCES  = tests/graphics/keyframes.cpp
+tests_graphics_test_keyframes_LDADD    = $(graphics_LIBS)
+tests_graphics_test_keyframes_CXXFLAGS = $(test_CXXFLAGS)
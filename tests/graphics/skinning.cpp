@@ -0,0 +1,217 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the CPU vertex skinning.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "external/glm/gtc/matrix_transform.hpp"
+
+#include "src/graphics/skinning.h"
+
+static const size_t kBonesPerVertex = 4;
+static const size_t kBoneCount      = 32;
+
+/** A synthetic skinned mesh, with the bone transformations split the way a model node has them. */
+struct SkinnedMesh {
+	std::vector<float> vertices;
+	std::vector<float> boneIndices;
+	std::vector<float> boneWeights;
+
+	glm::mat4 base;
+	glm::mat4 baseInverse;
+	std::vector<glm::mat4> bones;
+
+	/** The combined matrix of each bone. */
+	std::vector<glm::mat4> boneMatrices;
+
+	SkinnedMesh(size_t vertexCount) {
+		uint32 seed = 0x1234567;
+		auto random = [&seed]() {
+			seed = seed * 1664525 + 1013904223;
+			return (seed >> 8) / 16777216.0f;
+		};
+
+		base = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, -2.0f, 0.5f));
+		base = glm::rotate(base, 0.3f, glm::vec3(0.0f, 0.0f, 1.0f));
+		baseInverse = glm::inverse(base);
+
+		for (size_t i = 0; i < kBoneCount; i++) {
+			glm::mat4 bone = glm::translate(glm::mat4(1.0f), glm::vec3(random(), random(), random()));
+			bone = glm::rotate(bone, random() * 6.0f, glm::normalize(glm::vec3(random() + 0.1f, random(), random())));
+
+			bones.push_back(bone);
+			boneMatrices.push_back(baseInverse * bone * base);
+		}
+
+		for (size_t i = 0; i < vertexCount; i++) {
+			vertices.push_back(random() * 2.0f - 1.0f);
+			vertices.push_back(random() * 2.0f - 1.0f);
+			vertices.push_back(random() * 2.0f - 1.0f);
+
+			float weightSum = 0.0f;
+			for (size_t j = 0; j < kBonesPerVertex; j++) {
+				// Leave some influences unused
+				const bool used = (j == 0) || (random() < 0.7f);
+
+				boneIndices.push_back(used ? static_cast<int>(random() * kBoneCount) : -1.0f);
+				boneWeights.push_back(used ? random() + 0.01f : 0.0f);
+
+				weightSum += boneWeights.back();
+			}
+
+			for (size_t j = 0; j < kBonesPerVertex; j++)
+				boneWeights[i * kBonesPerVertex + j] /= weightSum;
+		}
+	}
+};
+
+static void multiply(const float *v, const glm::mat4 &m, float *vOut) {
+	float x = v[0] * m[0][0] + v[1] * m[1][0] + v[2] * m[2][0] + m[3][0];
+	float y = v[0] * m[0][1] + v[1] * m[1][1] + v[2] * m[2][1] + m[3][1];
+	float z = v[0] * m[0][2] + v[1] * m[1][2] + v[2] * m[2][2] + m[3][2];
+	float w = v[0] * m[0][3] + v[1] * m[1][3] + v[2] * m[2][3] + m[3][3];
+
+	vOut[0] = x / w;
+	vOut[1] = y / w;
+	vOut[2] = z / w;
+}
+
+/** Skin the mesh with three full matrix multiplications per bone influence. */
+static void skinReference(const SkinnedMesh &mesh, float *out, size_t outStride) {
+	for (size_t i = 0; i < mesh.vertices.size() / 3; i++, out += outStride) {
+		const float *v = &mesh.vertices[i * 3];
+
+		out[0] = out[1] = out[2] = 0.0f;
+
+		for (size_t j = 0; j < kBonesPerVertex; j++) {
+			const int boneIndex = static_cast<int>(mesh.boneIndices[i * kBonesPerVertex + j]);
+			if (boneIndex == -1)
+				continue;
+
+			const float boneWeight = mesh.boneWeights[i * kBonesPerVertex + j];
+
+			float v0[3], v1[3];
+			multiply(v, mesh.base, v0);
+			multiply(v0, mesh.bones[boneIndex], v1);
+			multiply(v1, mesh.baseInverse, v0);
+
+			out[0] += v0[0] * boneWeight;
+			out[1] += v0[1] * boneWeight;
+			out[2] += v0[2] * boneWeight;
+		}
+	}
+}
+
+static void skin(const SkinnedMesh &mesh, float *out, size_t outStride, bool scalar) {
+	if (scalar)
+		Graphics::skinVerticesScalar(mesh.vertices.data(), mesh.vertices.size() / 3,
+		                             mesh.boneIndices.data(), mesh.boneWeights.data(), kBonesPerVertex,
+		                             mesh.boneMatrices.data(), mesh.boneMatrices.size(), out, outStride);
+	else
+		Graphics::skinVertices(mesh.vertices.data(), mesh.vertices.size() / 3,
+		                       mesh.boneIndices.data(), mesh.boneWeights.data(), kBonesPerVertex,
+		                       mesh.boneMatrices.data(), mesh.boneMatrices.size(), out, outStride);
+}
+
+static void compareToReference(bool scalar) {
+	static const size_t kVertexCount = 1000;
+	static const size_t kStride      = 8;
+
+	const SkinnedMesh mesh(kVertexCount);
+
+	std::vector<float> reference(kVertexCount * kStride, 0.0f);
+	std::vector<float> skinned(kVertexCount * kStride, 42.0f);
+
+	skinReference(mesh, reference.data(), kStride);
+	skin(mesh, skinned.data(), kStride, scalar);
+
+	for (size_t i = 0; i < kVertexCount; i++) {
+		for (size_t j = 0; j < 3; j++)
+			EXPECT_NEAR(skinned[i * kStride + j], reference[i * kStride + j], 1e-4f) << "At " << i << "." << j;
+
+		// Only the position has been written
+		for (size_t j = 3; j < kStride; j++)
+			EXPECT_EQ(skinned[i * kStride + j], 42.0f) << "At " << i << "." << j;
+	}
+}
+
+GTEST_TEST(Skinning, scalar) {
+	compareToReference(true);
+}
+
+GTEST_TEST(Skinning, vectorized) {
+	compareToReference(false);
+}
+
+GTEST_TEST(Skinning, invalidBones) {
+	const glm::mat4 bone = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+
+	const float vertex[3]  = { 1.0f, 1.0f, 1.0f };
+	const float indices[3] = { -1.0f, 0.0f, 5.0f };
+	const float weights[3] = { 0.25f, 0.5f, 0.25f };
+
+	float out[3];
+
+	Graphics::skinVertices(vertex, 1, indices, weights, 3, &bone, 1, out, 3);
+	EXPECT_FLOAT_EQ(out[0], 1.0f);
+	EXPECT_FLOAT_EQ(out[1], 1.5f);
+	EXPECT_FLOAT_EQ(out[2], 2.0f);
+
+	Graphics::skinVerticesScalar(vertex, 1, indices, weights, 3, &bone, 1, out, 3);
+	EXPECT_FLOAT_EQ(out[0], 1.0f);
+	EXPECT_FLOAT_EQ(out[1], 1.5f);
+	EXPECT_FLOAT_EQ(out[2], 2.0f);
+}
+
+/** Measure and print how many vertices per second the different ways to skin manage. */
+GTEST_TEST(Skinning, DISABLED_throughput) {
+	static const size_t kVertexCount = 20000;
+	static const size_t kStride      = 8;
+	static const size_t kRuns        = 20;
+
+	const SkinnedMesh mesh(kVertexCount);
+	std::vector<float> out(kVertexCount * kStride);
+
+	const char *names[3] = { "reference", "scalar", "vectorized" };
+	for (int method = 0; method < 3; method++) {
+		const auto start = std::chrono::steady_clock::now();
+
+		for (size_t i = 0; i < kRuns; i++) {
+			if (method == 0)
+				skinReference(mesh, out.data(), kStride);
+			else
+				skin(mesh, out.data(), kStride, method == 1);
+		}
+
+		const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+		const double perSecond = (kVertexCount * kRuns) / std::max(time.count(), 1e-9);
+
+		std::printf("Skinning %-10s: %12.0f vertices/second\n", names[method], perSecond);
+	}
+}
@@ -0,0 +1,345 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for loading textures in the background.
+ */
+
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/ustring.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+#include "src/common/writefile.h"
+#include "src/common/threads.h"
+#include "src/common/changeid.h"
+
+#include "src/aurora/resman.h"
+
+#include "src/graphics/images/decoder.h"
+
+#include "src/graphics/aurora/textureman.h"
+#include "src/graphics/aurora/texture.h"
+
+static const size_t kTextureCount = 32;
+
+static boost::filesystem::path kDataPath;
+
+static Common::UString makeTextureName(size_t index) {
+	return Common::UString::format("tex%03u", (uint)index);
+}
+
+/** Each texture is (index + 1) pixels wide and 2 pixels high. */
+static void writeTGA(size_t index) {
+	const Common::UString fileName = makeTextureName(index) + ".tga";
+	Common::WriteFile tga((kDataPath / fileName.c_str()).generic_string());
+
+	const uint16 width = index + 1, height = 2;
+
+	tga.writeByte(0);                // ID length
+	tga.writeByte(0);                // No color map
+	tga.writeByte(2);                // Uncompressed true color
+	for (size_t i = 0; i < 5; i++)   // Color map specification
+		tga.writeByte(0);
+	tga.writeUint16LE(0);            // X origin
+	tga.writeUint16LE(0);            // Y origin
+	tga.writeUint16LE(width);
+	tga.writeUint16LE(height);
+	tga.writeByte(24);               // Bits per pixel
+	tga.writeByte(0);                // Image descriptor
+
+	for (size_t i = 0; i < (size_t)(width * height * 3); i++)
+		tga.writeByte(i * 7 + index);
+
+	tga.flush();
+}
+
+class TextureManager : public ::testing::Test {
+protected:
+	static void SetUpTestCase() {
+		Common::Platform::init();
+
+		kDataPath = boost::filesystem::temp_directory_path() /
+		            boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		boost::filesystem::create_directory(kDataPath);
+
+		// One more texture, that gets deleted by a test
+		for (size_t i = 0; i <= kTextureCount; i++)
+			writeTGA(i);
+
+		ResMan.registerDataBase(kDataPath.generic_string());
+		ResMan.indexResourceDir("", 0, 0, 100);
+	}
+
+	static void TearDownTestCase() {
+		TextureMan.clear();
+		ResMan.clear();
+
+		if (!kDataPath.empty())
+			boost::filesystem::remove_all(kDataPath);
+	}
+
+	void TearDown() {
+		TextureMan.clear();
+		TextureMan.setImageBudget(Graphics::Aurora::TextureManager::kImageBudgetUnlimited);
+	}
+};
+
+/** Upload a texture, after which its image can be dropped. */
+static void upload(const Graphics::Aurora::TextureHandle &texture) {
+	// Without a GL context, this doesn't do anything besides handing the image over to the TextureManager
+	if (!Common::initedThreads())
+		Common::initThreads();
+
+	const_cast<Graphics::Aurora::Texture &>(texture.getTexture()).rebuild();
+}
+
+static std::vector<byte> getPixels(const Graphics::Aurora::Texture &texture) {
+	const Graphics::ImageDecoder::MipMap &mipMap = texture.getImage().getMipMap(0);
+
+	return std::vector<byte>(mipMap.data.get(), mipMap.data.get() + mipMap.size);
+}
+
+GTEST_TEST_F(TextureManager, request) {
+	std::vector<Graphics::Aurora::TextureHandle> textures;
+	for (size_t i = 0; i < kTextureCount; i++)
+		textures.push_back(TextureMan.request(makeTextureName(i)));
+
+	TextureMan.waitForLoads();
+	EXPECT_EQ(TextureMan.getPendingLoadCount(), 0);
+
+	for (size_t i = 0; i < kTextureCount; i++) {
+		ASSERT_FALSE(textures[i].empty()) << i;
+
+		const Graphics::Aurora::Texture &texture = textures[i].getTexture();
+
+		EXPECT_TRUE(texture.isLoaded()) << i;
+		EXPECT_EQ(texture.getWidth() , i + 1) << i;
+		EXPECT_EQ(texture.getHeight(), 2) << i;
+	}
+}
+
+GTEST_TEST_F(TextureManager, requestTwice) {
+	Graphics::Aurora::TextureHandle texture1 = TextureMan.request(makeTextureName(3));
+	Graphics::Aurora::TextureHandle texture2 = TextureMan.request(makeTextureName(3),
+		Graphics::Aurora::TextureManager::kLoadPriorityUI);
+
+	EXPECT_EQ(&texture1.getTexture(), &texture2.getTexture());
+
+	TextureMan.waitForLoads();
+	EXPECT_TRUE(texture1.getTexture().isLoaded());
+}
+
+GTEST_TEST_F(TextureManager, getWaitsForRequest) {
+	for (size_t i = 0; i < kTextureCount; i++) {
+		Graphics::Aurora::TextureHandle requested = TextureMan.request(makeTextureName(i));
+		Graphics::Aurora::TextureHandle texture   = TextureMan.get(makeTextureName(i));
+
+		EXPECT_EQ(&requested.getTexture(), &texture.getTexture()) << i;
+
+		EXPECT_TRUE(texture.getTexture().isLoaded()) << i;
+		EXPECT_EQ(texture.getTexture().getWidth(), i + 1) << i;
+	}
+}
+
+GTEST_TEST_F(TextureManager, cancel) {
+	for (size_t n = 0; n < 4; n++) {
+		std::vector<Graphics::Aurora::TextureHandle> textures;
+		for (size_t i = 0; i < kTextureCount; i++)
+			textures.push_back(TextureMan.request(makeTextureName(i), Graphics::Aurora::TextureManager::kLoadPriorityWorld, i));
+
+		// Releasing the last handle cancels the load, or throws away the loaded image
+		textures.clear();
+
+		EXPECT_EQ(TextureMan.getPendingLoadCount(), 0);
+		for (size_t i = 0; i < kTextureCount; i++)
+			EXPECT_FALSE(TextureMan.hasTexture(makeTextureName(i))) << i;
+	}
+
+	TextureMan.waitForLoads();
+}
+
+GTEST_TEST_F(TextureManager, requestMissing) {
+	Graphics::Aurora::TextureHandle texture = TextureMan.request("nonexistent");
+	ASSERT_FALSE(texture.empty());
+
+	TextureMan.waitForLoads();
+	EXPECT_FALSE(texture.getTexture().isLoaded());
+
+	// The failed placeholder isn't handed out anymore
+	EXPECT_FALSE(TextureMan.hasTexture("nonexistent"));
+	EXPECT_TRUE(TextureMan.getIfExist("nonexistent").empty());
+
+	// Getting it tries again, and fails again
+	EXPECT_THROW(TextureMan.get("nonexistent"), Common::Exception);
+
+	// And the placeholder goes away with its last handle
+	texture.clear();
+
+	std::vector<Graphics::Aurora::TextureManager::TextureMemory> memory;
+	TextureMan.getTextureMemory(memory);
+
+	EXPECT_TRUE(memory.empty());
+}
+
+GTEST_TEST_F(TextureManager, requestRetry) {
+	const Common::UString name = makeTextureName(kTextureCount + 1);
+
+	Graphics::Aurora::TextureHandle texture = TextureMan.request(name);
+
+	TextureMan.waitForLoads();
+	EXPECT_FALSE(texture.getTexture().isLoaded());
+
+	// The texture shows up in the resources later
+	writeTGA(kTextureCount + 1);
+
+	Common::ChangeID change;
+	ResMan.indexResourceDir("", 0, 0, 101, &change);
+
+	// Requesting it again loads it into the same placeholder
+	Graphics::Aurora::TextureHandle retried = TextureMan.request(name);
+	EXPECT_EQ(&texture.getTexture(), &retried.getTexture());
+
+	TextureMan.waitForLoads();
+	EXPECT_TRUE(texture.getTexture().isLoaded());
+	EXPECT_EQ(texture.getTexture().getWidth(), kTextureCount + 2);
+
+	EXPECT_TRUE(TextureMan.hasTexture(name));
+
+	texture.clear();
+	retried.clear();
+
+	ResMan.undo(change);
+	boost::filesystem::remove(kDataPath / (name + ".tga").c_str());
+}
+
+GTEST_TEST_F(TextureManager, getMissingWhileLoading) {
+	std::vector<Graphics::Aurora::TextureHandle> textures;
+	for (size_t i = 0; i < kTextureCount; i++)
+		textures.push_back(TextureMan.request(makeTextureName(i)));
+
+	Graphics::Aurora::TextureHandle missing = TextureMan.request("nonexistent");
+
+	// Waits for the failed load, without blocking the others
+	EXPECT_THROW(TextureMan.get("nonexistent"), Common::Exception);
+
+	for (size_t i = 0; i < kTextureCount; i++)
+		EXPECT_EQ(TextureMan.get(makeTextureName(i)).getTexture().getWidth(), i + 1) << i;
+}
+
+GTEST_TEST_F(TextureManager, textureMemory) {
+	std::vector<Graphics::Aurora::TextureHandle> textures;
+	for (size_t i = 0; i < kTextureCount; i++)
+		textures.push_back(TextureMan.get(makeTextureName(i)));
+
+	std::vector<Graphics::Aurora::TextureManager::TextureMemory> memory;
+	TextureMan.getTextureMemory(memory);
+
+	ASSERT_EQ(memory.size(), kTextureCount);
+	for (size_t i = 0; i < kTextureCount; i++) {
+		const Graphics::Aurora::Texture &texture = textures[i].getTexture();
+
+		EXPECT_GE(texture.getDataSize(), (i + 1) * 2 * 3) << i;
+
+		EXPECT_EQ(memory[i].name, makeTextureName(i)) << i;
+		EXPECT_EQ(memory[i].size, texture.getDataSize()) << i;
+
+		// Nothing has been uploaded, so all images are still there
+		EXPECT_TRUE(memory[i].resident) << i;
+	}
+
+	EXPECT_EQ(TextureMan.getResidentImageSize(), 0);
+}
+
+GTEST_TEST_F(TextureManager, evictAndRestore) {
+	Graphics::Aurora::TextureHandle texture = TextureMan.get(makeTextureName(5));
+	const std::vector<byte> pixels = getPixels(texture.getTexture());
+
+	// Nothing may stay in memory
+	TextureMan.setImageBudget(0);
+
+	upload(texture);
+	EXPECT_FALSE(texture.getTexture().isImageResident());
+	EXPECT_EQ(TextureMan.getResidentImageSize(), 0);
+
+	// Read again, with the same pixels
+	EXPECT_EQ(getPixels(texture.getTexture()), pixels);
+	EXPECT_TRUE(texture.getTexture().isImageResident());
+
+	// And dropped again after the next upload
+	upload(texture);
+	EXPECT_FALSE(texture.getTexture().isImageResident());
+	EXPECT_EQ(getPixels(texture.getTexture()), pixels);
+}
+
+GTEST_TEST_F(TextureManager, exceedBudget) {
+	std::vector<Graphics::Aurora::TextureHandle> textures;
+	for (size_t i = 0; i < kTextureCount; i++) {
+		textures.push_back(TextureMan.get(makeTextureName(i)));
+
+		// Used for rendering in order, so the last ones are the most recent
+		TextureMan.set(textures.back());
+	}
+
+	TextureMan.set();
+
+	// Room for exactly the last four images
+	size_t budget = 0;
+	for (size_t i = kTextureCount - 4; i < kTextureCount; i++)
+		budget += textures[i].getTexture().getDataSize();
+
+	TextureMan.setImageBudget(budget);
+
+	for (size_t i = 0; i < kTextureCount; i++) {
+		upload(textures[i]);
+
+		EXPECT_LE(TextureMan.getResidentImageSize(), budget) << i;
+	}
+
+	EXPECT_EQ(TextureMan.getResidentImageSize(), budget);
+	for (size_t i = 0; i < kTextureCount; i++)
+		EXPECT_EQ(textures[i].getTexture().isImageResident(), i >= (kTextureCount - 4)) << i;
+
+	// Dropped images are still there when needed
+	for (size_t i = 0; i < kTextureCount; i++)
+		EXPECT_EQ(textures[i].getTexture().getImage().getMipMap(0).width, (int) (i + 1)) << i;
+}
+
+GTEST_TEST_F(TextureManager, restoreFails) {
+	const Common::UString name = makeTextureName(kTextureCount);
+
+	Graphics::Aurora::TextureHandle texture = TextureMan.get(name);
+
+	TextureMan.setImageBudget(0);
+	upload(texture);
+	ASSERT_FALSE(texture.getTexture().isImageResident());
+
+	// The image can't be read again
+	boost::filesystem::remove(kDataPath / (name + ".tga").c_str());
+
+	EXPECT_THROW(texture.getTexture().getImage(), Common::Exception);
+	EXPECT_FALSE(texture.getTexture().isImageResident());
+}
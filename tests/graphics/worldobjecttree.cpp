@@ -0,0 +1,224 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the bounding volume hierarchy over world objects.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "external/glm/gtc/matrix_transform.hpp"
+
+#include "src/common/util.h"
+#include "src/common/boundingbox.h"
+#include "src/common/frustum.h"
+
+#include "src/graphics/renderable.h"
+#include "src/graphics/worldobjecttree.h"
+
+/** A unit cube in the world, or an object without a bound. */
+class FakeObject : public Graphics::Renderable {
+public:
+	FakeObject(float x, float y, float z, bool bounded = true) :
+		Graphics::Renderable(Graphics::kRenderableTypeObject), _bounded(bounded) {
+
+		setPosition(x, y, z);
+		setClickable(true);
+	}
+
+	void setPosition(float x, float y, float z) {
+		_position[0] = x;
+		_position[1] = y;
+		_position[2] = z;
+
+		_distance = ABS(x) + ABS(y) + ABS(z);
+
+		boundChanged();
+	}
+
+	void calculateDistance() {
+	}
+
+	void render(Graphics::RenderPass UNUSED(pass)) {
+	}
+
+	bool getWorldBound(float min[3], float max[3]) const {
+		if (!_bounded)
+			return false;
+
+		for (int i = 0; i < 3; i++) {
+			min[i] = _position[i] - 0.5f;
+			max[i] = _position[i] + 0.5f;
+		}
+
+		return true;
+	}
+
+	bool isIn(float x1, float y1, float z1, float x2, float y2, float z2) const {
+		Common::BoundingBox box;
+
+		box.add(_position[0] - 0.5f, _position[1] - 0.5f, _position[2] - 0.5f);
+		box.add(_position[0] + 0.5f, _position[1] + 0.5f, _position[2] + 0.5f);
+
+		return box.isIn(x1, y1, z1, x2, y2, z2);
+	}
+
+private:
+	bool _bounded;
+	float _position[3];
+};
+
+// A 90° camera at the origin, looking down the negative z axis
+static Common::Frustum createFrustum() {
+	return Common::Frustum(glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 100.0f));
+}
+
+GTEST_TEST(WorldObjectTree, update) {
+	FakeObject a(0.0f, 0.0f, -10.0f), b(5.0f, 0.0f, -10.0f), c(0.0f, 0.0f, 0.0f, false);
+
+	std::vector<Graphics::Queueable *> objects;
+	objects.push_back(&a);
+	objects.push_back(&b);
+	objects.push_back(&c);
+
+	Graphics::WorldObjectTree tree;
+	EXPECT_EQ(tree.getObjectCount(), 0U);
+
+	tree.update(objects, 0);
+	EXPECT_EQ(tree.getObjectCount(), 3U);
+	EXPECT_EQ(tree.getUnboundedCount(), 1U);
+
+	// Same generation, the list is assumed to be unchanged
+	objects.pop_back();
+	tree.update(objects, 0);
+	EXPECT_EQ(tree.getObjectCount(), 3U);
+
+	tree.update(objects, 1);
+	EXPECT_EQ(tree.getObjectCount(), 2U);
+	EXPECT_EQ(tree.getUnboundedCount(), 0U);
+
+	tree.clear();
+	EXPECT_EQ(tree.getObjectCount(), 0U);
+}
+
+GTEST_TEST(WorldObjectTree, cull) {
+	FakeObject front(0.0f, 0.0f, -10.0f), behind(0.0f, 0.0f, 10.0f), side(50.0f, 0.0f, -10.0f);
+	FakeObject unbounded(0.0f, 0.0f, 10.0f, false);
+
+	std::vector<Graphics::Queueable *> objects;
+	objects.push_back(&front);
+	objects.push_back(&behind);
+	objects.push_back(&side);
+	objects.push_back(&unbounded);
+
+	Graphics::WorldObjectTree tree;
+	tree.update(objects, 0);
+	tree.cull(createFrustum());
+
+	EXPECT_TRUE (tree.isVisible(front));
+	EXPECT_FALSE(tree.isVisible(behind));
+	EXPECT_FALSE(tree.isVisible(side));
+	EXPECT_TRUE (tree.isVisible(unbounded));
+
+	// Move objects in and out of view, without changing the list
+	behind.setPosition(0.0f, 0.0f, -20.0f);
+	front.setPosition(0.0f, 0.0f, 20.0f);
+
+	tree.update(objects, 0);
+	tree.cull(createFrustum());
+
+	EXPECT_FALSE(tree.isVisible(front));
+	EXPECT_TRUE (tree.isVisible(behind));
+	EXPECT_FALSE(tree.isVisible(side));
+	EXPECT_TRUE (tree.isVisible(unbounded));
+}
+
+GTEST_TEST(WorldObjectTree, cullMany) {
+	std::vector<FakeObject *> objects;
+	std::vector<Graphics::Queueable *> queue;
+
+	for (int x = -20; x < 20; x++) {
+		for (int z = -40; z < 10; z++) {
+			objects.push_back(new FakeObject(x * 3.0f, (x + z) % 7, z * 3.0f));
+			queue.push_back(objects.back());
+		}
+	}
+
+	const Common::Frustum frustum = createFrustum();
+
+	Graphics::WorldObjectTree tree;
+
+	for (int pass = 0; pass < 2; pass++) {
+		tree.update(queue, 0);
+		tree.cull(frustum);
+
+		size_t visible = 0;
+		for (std::vector<FakeObject *>::const_iterator o = objects.begin(); o != objects.end(); ++o) {
+			float min[3], max[3];
+			ASSERT_TRUE((*o)->getWorldBound(min, max));
+
+			EXPECT_EQ(tree.isVisible(**o), frustum.isIn(min, max));
+
+			visible += tree.isVisible(**o) ? 1 : 0;
+		}
+
+		EXPECT_GT(visible, 0U);
+		EXPECT_LT(visible, objects.size());
+
+		// Shift every other object sideways, so that the second pass works on a refitted tree
+		for (size_t i = 0; i < objects.size(); i += 2) {
+			float min[3], max[3];
+			objects[i]->getWorldBound(min, max);
+			objects[i]->setPosition(min[0] + 0.5f + 7.0f, min[1] + 0.5f, min[2] + 0.5f);
+		}
+	}
+
+	for (std::vector<FakeObject *>::iterator o = objects.begin(); o != objects.end(); ++o)
+		delete *o;
+}
+
+GTEST_TEST(WorldObjectTree, getObjectAt) {
+	FakeObject near(0.0f, 0.0f, -10.0f), far(0.0f, 0.0f, -20.0f), off(5.0f, 0.0f, -5.0f);
+
+	std::vector<Graphics::Queueable *> objects;
+	objects.push_back(&far);
+	objects.push_back(&off);
+	objects.push_back(&near);
+
+	Graphics::WorldObjectTree tree;
+	tree.update(objects, 0);
+
+	EXPECT_EQ(tree.getObjectAt(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -100.0f), &near);
+
+	near.setClickable(false);
+	EXPECT_EQ(tree.getObjectAt(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -100.0f), &far);
+
+	EXPECT_EQ(tree.getObjectAt(5.0f, 0.0f, 0.0f, 5.0f, 0.0f, -100.0f), &off);
+	EXPECT_EQ(tree.getObjectAt(9.0f, 0.0f, 0.0f, 9.0f, 0.0f, -100.0f), (Graphics::Renderable *) 0);
+
+	// Picking follows objects that moved
+	off.setPosition(9.0f, 0.0f, -5.0f);
+	tree.update(objects, 0);
+
+	EXPECT_EQ(tree.getObjectAt(5.0f, 0.0f, 0.0f, 5.0f, 0.0f, -100.0f), (Graphics::Renderable *) 0);
+	EXPECT_EQ(tree.getObjectAt(9.0f, 0.0f, 0.0f, 9.0f, 0.0f, -100.0f), &off);
+}
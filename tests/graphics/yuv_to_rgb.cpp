@@ -0,0 +1,209 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the YUV to RGB conversion.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+#include "src/graphics/yuv_to_rgb.h"
+
+typedef Graphics::YUVToRGBManager YUVManager;
+
+/** A synthetic YUV420 image with alpha, with the pitches wider than the image. */
+struct YUVImage {
+	int width, height;
+	int yPitch, uvPitch;
+
+	std::vector<byte> y, u, v, a;
+
+	YUVImage(int w, int h) : width(w), height(h), yPitch(w + 7), uvPitch((w >> 1) + 5) {
+		uint32 seed = 0x2345678;
+		auto random = [&seed]() {
+			seed = seed * 1664525 + 1013904223;
+			return (byte) (seed >> 24);
+		};
+
+		y.resize(yPitch * height);
+		u.resize(uvPitch * (height >> 1));
+		v.resize(uvPitch * (height >> 1));
+		a.resize(yPitch * height);
+
+		std::generate(y.begin(), y.end(), random);
+		std::generate(u.begin(), u.end(), random);
+		std::generate(v.begin(), v.end(), random);
+		std::generate(a.begin(), a.end(), random);
+	}
+
+	std::vector<byte> convert(YUVManager::LuminanceScale scale, bool alpha) const {
+		std::vector<byte> rgba(width * height * 4, 0x55);
+
+		if (alpha)
+			YUVToRGBMan.convert420(scale, rgba.data(), width * 4, y.data(), u.data(), v.data(), a.data(),
+			                       width, height, yPitch, uvPitch);
+		else
+			YUVToRGBMan.convert420(scale, rgba.data(), width * 4, y.data(), u.data(), v.data(),
+			                       width, height, yPitch, uvPitch);
+
+		return rgba;
+	}
+};
+
+static const YUVManager::Implementation kImplementations[] = {
+	YUVManager::kImplementationLookup,
+	YUVManager::kImplementationSSE2,
+	YUVManager::kImplementationAVX2
+};
+
+static const char * const kImplementationNames[] = { "lookup", "SSE2", "AVX2" };
+
+/** Compare every supported implementation against the lookup tables. */
+static void compareImplementations(const YUVImage &image) {
+	const int width  = image.width;
+	const int height = image.height;
+
+	const YUVManager::Implementation previous = YUVToRGBMan.getImplementation();
+
+	for (int scale = 0; scale < 2; scale++) {
+		for (int alpha = 0; alpha < 2; alpha++) {
+			const YUVManager::LuminanceScale lumScale = (YUVManager::LuminanceScale) scale;
+
+			YUVToRGBMan.setImplementation(YUVManager::kImplementationLookup);
+			const std::vector<byte> reference = image.convert(lumScale, alpha != 0);
+
+			for (size_t i = 1; i < ARRAYSIZE(kImplementations); i++) {
+				if (!YUVManager::hasImplementation(kImplementations[i]))
+					continue;
+
+				YUVToRGBMan.setImplementation(kImplementations[i]);
+				const std::vector<byte> rgba = image.convert(lumScale, alpha != 0);
+
+				EXPECT_TRUE(rgba == reference) << kImplementationNames[i] << ", " << width << "x" << height <<
+				                                  ", scale " << scale << ", alpha " << alpha;
+			}
+		}
+	}
+
+	YUVToRGBMan.setImplementation(previous);
+}
+
+static void compareImplementations(int width, int height) {
+	compareImplementations(YUVImage(width, height));
+}
+
+GTEST_TEST(YUVToRGB, lookupAlwaysAvailable) {
+	EXPECT_TRUE(YUVManager::hasImplementation(YUVManager::kImplementationLookup));
+}
+
+GTEST_TEST(YUVToRGB, convertWide) {
+	compareImplementations(128, 16);
+}
+
+GTEST_TEST(YUVToRGB, convertAllChroma) {
+	// Every U value against every V value
+	YUVImage image(512, 512);
+	for (int h = 0; h < 256; h++) {
+		for (int w = 0; w < 256; w++) {
+			image.u[h * image.uvPitch + w] = w;
+			image.v[h * image.uvPitch + w] = h;
+		}
+	}
+
+	compareImplementations(image);
+}
+
+GTEST_TEST(YUVToRGB, convertTails) {
+	// Widths that leave a few pixels for the scalar tail, down to none at all for the vector code
+	compareImplementations(  2,  2);
+	compareImplementations( 30,  4);
+	compareImplementations( 46,  6);
+	compareImplementations( 66,  8);
+	compareImplementations(126, 10);
+}
+
+GTEST_TEST(YUVToRGB, convertOddSize) {
+	// The odd last column and row are never written
+	compareImplementations(99, 7);
+}
+
+GTEST_TEST(YUVToRGB, convertFlipped) {
+	// Black in the top image row, white in the bottom one
+	std::vector<byte> y(4 * 2, 0), u(2, 128), v(2, 128);
+	std::fill(y.begin() + 4, y.end(), 255);
+
+	std::vector<byte> rgba(4 * 2 * 4);
+	YUVToRGBMan.convert420(YUVManager::kScaleFull, rgba.data(), 4 * 4, y.data(), u.data(), v.data(), 4, 2, 4, 2);
+
+	for (int x = 0; x < 4; x++) {
+		EXPECT_EQ(rgba[0 * 16 + x * 4 + 0], 255) << x;
+		EXPECT_EQ(rgba[0 * 16 + x * 4 + 3], 255) << x;
+		EXPECT_EQ(rgba[1 * 16 + x * 4 + 0],   0) << x;
+		EXPECT_EQ(rgba[1 * 16 + x * 4 + 3], 255) << x;
+	}
+}
+
+GTEST_TEST(YUVToRGB, setUnsupported) {
+	for (size_t i = 0; i < ARRAYSIZE(kImplementations); i++) {
+		if (!YUVManager::hasImplementation(kImplementations[i])) {
+			EXPECT_THROW(YUVToRGBMan.setImplementation(kImplementations[i]), Common::Exception);
+		}
+	}
+}
+
+/** Measure and print how many megapixels per second the implementations convert in a 1080p frame. */
+GTEST_TEST(YUVToRGB, DISABLED_throughput) {
+	static const int kWidth  = 1920;
+	static const int kHeight = 1080;
+	static const int kRuns   = 20;
+
+	const YUVImage image(kWidth, kHeight);
+	std::vector<byte> rgba(kWidth * kHeight * 4);
+
+	const YUVManager::Implementation previous = YUVToRGBMan.getImplementation();
+
+	for (size_t i = 0; i < ARRAYSIZE(kImplementations); i++) {
+		if (!YUVManager::hasImplementation(kImplementations[i]))
+			continue;
+
+		YUVToRGBMan.setImplementation(kImplementations[i]);
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int j = 0; j < kRuns; j++)
+			YUVToRGBMan.convert420(YUVManager::kScaleITU, rgba.data(), kWidth * 4, image.y.data(), image.u.data(),
+			                       image.v.data(), kWidth, kHeight, image.yPitch, image.uvPitch);
+
+		const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+		const double perSecond = (double(kWidth) * kHeight * kRuns) / std::max(time.count(), 1e-9);
+
+		std::printf("YUV to RGB %-6s: %8.1f Mpx/s\n", kImplementationNames[i], perSecond / 1000000.0);
+	}
+
+	YUVToRGBMan.setImplementation(previous);
+}
@@ -0,0 +1,226 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the S3TC DXTn decompression methods.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+#include "src/common/threadpool.h"
+
+#include "src/graphics/images/s3tc.h"
+
+static const Graphics::PixelFormatRaw kFormats[] = {
+	Graphics::kPixelFormatDXT1, Graphics::kPixelFormatDXT3, Graphics::kPixelFormatDXT5
+};
+
+static const char * const kFormatNames[] = { "DXT1", "DXT3", "DXT5" };
+
+static size_t getBlockSize(Graphics::PixelFormatRaw format) {
+	return (format == Graphics::kPixelFormatDXT1) ? 8 : 16;
+}
+
+static size_t getDataSize(Graphics::PixelFormatRaw format, uint32 width, uint32 height) {
+	return ((width + 3) / 4) * ((height + 3) / 4) * getBlockSize(format);
+}
+
+/** Fill a buffer with reproducible pseudo-random bytes. */
+static std::vector<byte> createRandomData(size_t size, uint32 seed) {
+	std::vector<byte> data(size);
+
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = seed >> 16;
+	}
+
+	return data;
+}
+
+/** Decompress with the original stream-based decoders. */
+static void decompressStream(byte *dest, const std::vector<byte> &data, Graphics::PixelFormatRaw format,
+                             uint32 width, uint32 height) {
+
+	Common::MemoryReadStream stream(data.data(), data.size());
+
+	if      (format == Graphics::kPixelFormatDXT1)
+		Graphics::decompressDXT1(dest, stream, width, height, width * 4);
+	else if (format == Graphics::kPixelFormatDXT3)
+		Graphics::decompressDXT3(dest, stream, width, height, width * 4);
+	else if (format == Graphics::kPixelFormatDXT5)
+		Graphics::decompressDXT5(dest, stream, width, height, width * 4);
+}
+
+/** Check that decompressing from memory matches the stream decoders byte for byte. */
+static void compareDecoders(const std::vector<byte> &data, Graphics::PixelFormatRaw format,
+                            uint32 width, uint32 height, size_t maxThreads) {
+
+	// Pre-fill both, so that pixels a decoder leaves alone have to match as well
+	std::vector<byte> expected(width * height * 4, 0xCD), actual(width * height * 4, 0xCD);
+
+	decompressStream(expected.data(), data, format, width, height);
+	Graphics::decompressDXT(actual.data(), data.data(), data.size(), width, height, width * 4, format, maxThreads);
+
+	for (size_t i = 0; i < expected.size(); i++) {
+		if (expected[i] != actual[i]) {
+			ADD_FAILURE() << "Format " << format << ", " << width << "x" << height << ", " << maxThreads <<
+			                 " threads: mismatch at pixel " << (i / 4) << ", channel " << (i % 4) << ": " <<
+			                 (uint)expected[i] << " != " << (uint)actual[i];
+			return;
+		}
+	}
+}
+
+static void compareRandom(uint32 width, uint32 height, size_t maxThreads = 1) {
+	for (size_t i = 0; i < ARRAYSIZE(kFormats); i++) {
+		const std::vector<byte> data = createRandomData(getDataSize(kFormats[i], width, height), width * 31 + height);
+
+		compareDecoders(data, kFormats[i], width, height, maxThreads);
+	}
+}
+
+GTEST_TEST(S3TC, compareBlocks) {
+	compareRandom( 4,  4);
+	compareRandom( 8,  8);
+	compareRandom(64, 32);
+	compareRandom(32, 64);
+}
+
+GTEST_TEST(S3TC, compareSmall) {
+	compareRandom(1, 1);
+	compareRandom(2, 2);
+	compareRandom(1, 4);
+	compareRandom(4, 1);
+	compareRandom(8, 2);
+	compareRandom(2, 8);
+}
+
+GTEST_TEST(S3TC, compareUnaligned) {
+	compareRandom(12,  6);
+	compareRandom( 6, 12);
+	compareRandom(13,  7);
+}
+
+GTEST_TEST(S3TC, compareThreaded) {
+	compareRandom(512, 512, 4);
+	compareRandom(512, 256, 3);
+	compareRandom(256, 512, 0);
+}
+
+GTEST_TEST(S3TC, compareOnThreadPool) {
+	// Decoding from within a pool task, like a texture loader, stays on that thread
+	Common::TaskGroup group(ThreadPoolMan);
+	group.run([]() {
+		compareRandom(512, 512, 0);
+	});
+
+	group.wait();
+}
+
+GTEST_TEST(S3TC, compareColorEndpoints) {
+	// Equal, extreme and swapped endpoints, which select the different DXT1 blending modes
+	static const uint16 kColors[] = { 0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0x1234, 0x1235, 0x8410 };
+
+	for (size_t i = 0; i < ARRAYSIZE(kFormats); i++) {
+		const size_t blockSize = getBlockSize(kFormats[i]);
+
+		std::vector<byte> data = createRandomData(ARRAYSIZE(kColors) * ARRAYSIZE(kColors) * blockSize, 23);
+		for (size_t c0 = 0; c0 < ARRAYSIZE(kColors); c0++) {
+			for (size_t c1 = 0; c1 < ARRAYSIZE(kColors); c1++) {
+				byte *color = data.data() + (c0 * ARRAYSIZE(kColors) + c1 + 1) * blockSize - 8;
+
+				WRITE_LE_UINT16(color    , kColors[c0]);
+				WRITE_LE_UINT16(color + 2, kColors[c1]);
+			}
+		}
+
+		compareDecoders(data, kFormats[i], ARRAYSIZE(kColors) * 4, ARRAYSIZE(kColors) * 4, 1);
+	}
+}
+
+GTEST_TEST(S3TC, compareAllAlphaEndpoints) {
+	// One DXT5 block for every pair of alpha endpoints
+	std::vector<byte> data = createRandomData(256 * 256 * 16, 42);
+	for (size_t i = 0; i < 256 * 256; i++) {
+		data[i * 16 + 0] = i >> 8;
+		data[i * 16 + 1] = i & 0xFF;
+	}
+
+	compareDecoders(data, Graphics::kPixelFormatDXT5, 1024, 256, 1);
+}
+
+GTEST_TEST(S3TC, tooShort) {
+	for (size_t i = 0; i < ARRAYSIZE(kFormats); i++) {
+		const std::vector<byte> data(getDataSize(kFormats[i], 8, 8) - 1);
+		std::vector<byte> image(8 * 8 * 4);
+
+		EXPECT_THROW(Graphics::decompressDXT(image.data(), data.data(), data.size(), 8, 8, 8 * 4, kFormats[i]),
+		             Common::Exception);
+	}
+}
+
+GTEST_TEST(S3TC, unknownFormat) {
+	const std::vector<byte> data(64);
+	std::vector<byte> image(4 * 4 * 4);
+
+	EXPECT_THROW(Graphics::decompressDXT(image.data(), data.data(), data.size(), 4, 4, 4 * 4,
+	                                     Graphics::kPixelFormatRGBA8), Common::Exception);
+}
+
+/** Measure and print how many megabytes of RGBA the decoders produce per second for a 2048x2048 image. */
+GTEST_TEST(S3TC, DISABLED_throughput) {
+	static const uint32 kWidth  = 2048;
+	static const uint32 kHeight = 2048;
+	static const int    kRuns   = 4;
+
+	static const size_t kThreads[] = { 1, 0 };
+
+	std::vector<byte> image(kWidth * kHeight * 4);
+
+	for (size_t i = 0; i < ARRAYSIZE(kFormats); i++) {
+		const std::vector<byte> data = createRandomData(getDataSize(kFormats[i], kWidth, kHeight), 7);
+
+		auto start = std::chrono::steady_clock::now();
+		for (int j = 0; j < kRuns; j++)
+			decompressStream(image.data(), data, kFormats[i], kWidth, kHeight);
+
+		std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+		std::printf("%s stream   : %8.1f MB/s\n", kFormatNames[i], (image.size() * kRuns) / std::max(time.count(), 1e-9) / 1000000.0);
+
+		for (size_t t = 0; t < ARRAYSIZE(kThreads); t++) {
+			start = std::chrono::steady_clock::now();
+			for (int j = 0; j < kRuns; j++)
+				Graphics::decompressDXT(image.data(), data.data(), data.size(), kWidth, kHeight, kWidth * 4, kFormats[i], kThreads[t]);
+
+			time = std::chrono::steady_clock::now() - start;
+			std::printf("%s memory %s: %8.1f MB/s\n", kFormatNames[i], (kThreads[t] == 1) ? "1" : "n",
+			            (image.size() * kRuns) / std::max(time.count(), 1e-9) / 1000000.0);
+		}
+	}
+}
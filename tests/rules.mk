@@ -40,6 +40,17 @@ include tests/version/rules.mk
 include tests/common/rules.mk
 include tests/aurora/rules.mk
 include tests/images/rules.mk
+include tests/graphics/rules.mk
+include tests/sound/rules.mk
+include tests/video/rules.mk
 include tests/engines/nwn2/rules.mk
 
 TESTS += $(check_PROGRAMS)
+
+# Benchmarks are disabled tests in some of the unit test programs.
+# They are only run by "make bench".
+
+BENCH_FLAGS = --gtest_also_run_disabled_tests --gtest_filter='*.DISABLED_*'
+
+bench: $(BENCHMARKS)
+	@for b in $(BENCHMARKS); do ./$$b $(BENCH_FLAGS) || exit 1; done
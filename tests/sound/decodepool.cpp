@@ -0,0 +1,266 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for decoding audio streams ahead of playback.
+ */
+
+#include <atomic>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/mutex.h"
+#include "src/common/threadpool.h"
+
+#include "src/sound/audiostream.h"
+#include "src/sound/decodepool.h"
+
+static const size_t kBufferSize = 64;
+static const size_t kReadAhead  = 3;
+
+/** A synthetic audio stream: sample n has the value n, wrapping around.
+ *
+ *  A blocked stream doesn't return from reading until it is unblocked.
+ */
+class CountingStream : public Sound::AudioStream {
+public:
+	CountingStream(size_t samples, int channels = 1, bool blocked = false, size_t failAt = SIZE_MAX) :
+		_samples(samples), _channels(channels), _failAt(failAt), _blocked(blocked), _pos(0), _reads(0) {
+	}
+
+	size_t readBuffer(int16 *buffer, const size_t numSamples) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_unblocked.wait(lock, [&]() { return !_blocked; });
+		}
+
+		if (_pos >= _failAt)
+			return kSizeInvalid;
+
+		const size_t count = MIN(numSamples, _samples - _pos);
+		for (size_t i = 0; i < count; i++)
+			buffer[i] = static_cast<int16>(_pos + i);
+
+		_pos += count;
+		_reads++;
+
+		return count;
+	}
+
+	int getChannels() const {
+		return _channels;
+	}
+
+	int getRate() const {
+		return 22050;
+	}
+
+	bool endOfData() const {
+		return _pos >= _samples;
+	}
+
+	size_t getReads() const {
+		return _reads;
+	}
+
+	void unblock() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_blocked = false;
+		}
+
+		_unblocked.notify_all();
+	}
+
+private:
+	const size_t _samples;
+	const int    _channels;
+	const size_t _failAt;
+
+	bool _blocked;
+	std::mutex _mutex;
+	std::condition_variable _unblocked;
+
+	std::atomic<size_t> _pos;
+	std::atomic<size_t> _reads;
+};
+
+/** Wait until the pool decoded a buffer for the stream, and take it out. Return 0 at the end. */
+static Sound::PCMBuffer *waitForBuffer(Sound::DecodePool &pool, Sound::DecodePool::Stream &stream) {
+	Sound::PCMBuffer *buffer = pool.getBuffer(stream);
+	if (buffer)
+		return buffer;
+
+	pool.wait(stream);
+
+	return pool.getBuffer(stream);
+}
+
+/** Take out all buffers of the stream, checking the samples. Returns the number of samples. */
+static size_t drainStream(Sound::DecodePool &pool, Sound::DecodePool::Stream &stream) {
+	size_t samples = 0;
+
+	Sound::PCMBuffer *buffer;
+	while ((buffer = waitForBuffer(pool, stream))) {
+		for (size_t i = 0; i < buffer->length; i++)
+			EXPECT_EQ(buffer->data[i], static_cast<int16>(samples + i)) << "At sample " << (samples + i);
+
+		samples += buffer->length;
+		pool.releaseBuffer(buffer);
+	}
+
+	return samples;
+}
+
+GTEST_TEST(DecodePool, invalidParameters) {
+	Common::ThreadPool threads(1);
+
+	EXPECT_THROW(Sound::DecodePool pool(threads, 0, kReadAhead, 1), Common::Exception);
+	EXPECT_THROW(Sound::DecodePool pool(threads, kBufferSize, 0, 1), Common::Exception);
+	EXPECT_THROW(Sound::DecodePool pool(threads, kBufferSize, kReadAhead, 0), Common::Exception);
+}
+
+GTEST_TEST(DecodePool, decodeAll) {
+	CountingStream audio(1000);
+
+	Common::ThreadPool threads(2);
+	Sound::DecodePool pool(threads, kBufferSize, kReadAhead, 2);
+	Sound::DecodePool::Stream *stream = pool.addStream(audio);
+
+	EXPECT_EQ(drainStream(pool, *stream), 1000U);
+	EXPECT_TRUE(pool.endOfStream(*stream));
+
+	pool.removeStream(stream);
+}
+
+GTEST_TEST(DecodePool, readAhead) {
+	CountingStream audio(100 * kBufferSize);
+
+	Common::ThreadPool threads(2);
+	Sound::DecodePool pool(threads, kBufferSize, kReadAhead, 2);
+	Sound::DecodePool::Stream *stream = pool.addStream(audio);
+
+	// Once the queue is filled, nothing more is decoded
+	pool.wait(*stream);
+	EXPECT_EQ(audio.getReads(), kReadAhead);
+
+	// Taking out a buffer makes space for exactly one more
+	Sound::PCMBuffer *buffer = pool.getBuffer(*stream);
+	ASSERT_NE(buffer, static_cast<Sound::PCMBuffer *>(0));
+	pool.releaseBuffer(buffer);
+
+	pool.wait(*stream);
+	EXPECT_EQ(audio.getReads(), kReadAhead + 1);
+
+	pool.removeStream(stream);
+}
+
+GTEST_TEST(DecodePool, recycleBuffers) {
+	CountingStream audio1(50 * kBufferSize), audio2(50 * kBufferSize);
+
+	Common::ThreadPool threads(2);
+	Sound::DecodePool pool(threads, kBufferSize, kReadAhead, 2);
+	const size_t bufferCount = pool.getBufferCount();
+
+	Sound::DecodePool::Stream *stream1 = pool.addStream(audio1);
+	Sound::DecodePool::Stream *stream2 = pool.addStream(audio2);
+
+	EXPECT_EQ(drainStream(pool, *stream1), 50 * kBufferSize);
+	EXPECT_EQ(drainStream(pool, *stream2), 50 * kBufferSize);
+
+	pool.removeStream(stream1);
+	pool.removeStream(stream2);
+
+	// Two streams fit into the preallocated buffers
+	EXPECT_EQ(pool.getBufferCount(), bufferCount);
+}
+
+GTEST_TEST(DecodePool, wholeFrames) {
+	CountingStream audio(600, 6);
+
+	Common::ThreadPool threads(2);
+	Sound::DecodePool pool(threads, kBufferSize, kReadAhead, 1);
+	Sound::DecodePool::Stream *stream = pool.addStream(audio);
+
+	size_t samples = 0;
+
+	Sound::PCMBuffer *buffer;
+	while ((buffer = waitForBuffer(pool, *stream))) {
+		EXPECT_EQ(buffer->length % 6, 0U);
+
+		samples += buffer->length;
+		pool.releaseBuffer(buffer);
+	}
+
+	EXPECT_EQ(samples, 600U);
+
+	pool.removeStream(stream);
+}
+
+GTEST_TEST(DecodePool, slowStreamDoesNotStarve) {
+	CountingStream slow(100 * kBufferSize, 1, true);
+	CountingStream fast(20 * kBufferSize);
+
+	Common::ThreadPool threads(2);
+	Sound::DecodePool pool(threads, kBufferSize, kReadAhead, 2);
+	Sound::DecodePool::Stream *slowStream = pool.addStream(slow);
+	Sound::DecodePool::Stream *fastStream = pool.addStream(fast);
+
+	// The fast stream is decoded completely, while the slow one is stuck in its first read
+	EXPECT_EQ(drainStream(pool, *fastStream), 20 * kBufferSize);
+	EXPECT_EQ(slow.getReads(), 0U);
+
+	// Removing the slow stream waits for the running decode
+	slow.unblock();
+	pool.removeStream(slowStream);
+	pool.removeStream(fastStream);
+}
+
+GTEST_TEST(DecodePool, error) {
+	CountingStream audio(1000, 1, false, 2 * kBufferSize);
+
+	Common::ThreadPool threads(2);
+	Sound::DecodePool pool(threads, kBufferSize, kReadAhead, 2);
+	Sound::DecodePool::Stream *stream = pool.addStream(audio);
+
+	// The buffers before the error are still there, then the stream counts as ended
+	EXPECT_EQ(drainStream(pool, *stream), 2 * kBufferSize);
+	EXPECT_TRUE(pool.endOfStream(*stream));
+
+	pool.removeStream(stream);
+}
+
+GTEST_TEST(DecodePool, ready) {
+	CountingStream audio(10 * kBufferSize);
+	std::atomic<size_t> readyCount(0);
+
+	Common::ThreadPool threads(2);
+	Sound::DecodePool pool(threads, kBufferSize, kReadAhead, 1, [&readyCount]() { readyCount++; });
+	Sound::DecodePool::Stream *stream = pool.addStream(audio);
+
+	// Signalled once when the first buffer is decoded, not for the ones following it
+	pool.wait(*stream);
+
+	EXPECT_EQ(audio.getReads(), kReadAhead);
+	EXPECT_EQ(readyCount, 1U);
+
+	pool.removeStream(stream);
+}
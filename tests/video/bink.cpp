@@ -0,0 +1,328 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for decoding whole Bink video frames.
+ */
+
+#include <cstring>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/threads.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+
+#include "src/graphics/yuv_to_rgb.h"
+
+#include "src/graphics/images/surface.h"
+
+#include "src/video/bink.h"
+
+static const uint32 kWidth      = 64;
+static const uint32 kHeight     = 48;
+static const uint32 kFrameCount = 8;
+
+static const uint32 kVideoFlagAlpha = 0x00100000;
+
+// Bink block types we generate
+static const uint32 kBlockSkip = 0;
+static const uint32 kBlockFill = 6;
+static const uint32 kBlockRaw  = 9;
+
+static const size_t kSourceColors  = 2;
+static const size_t kSourceIntraDC = 6;
+static const size_t kSourceInterDC = 7;
+static const size_t kSourceMAX     = 9;
+
+/** The length of all bundle element counts, for videos of our size. */
+static const size_t kCountLength = 10;
+
+/** A simple pseudo-random number generator, to get the same video every time. */
+struct Random {
+	uint32 seed;
+
+	Random() : seed(0x13579BD) {
+	}
+
+	uint32 next() {
+		seed = seed * 1664525 + 1013904223;
+		return seed >> 8;
+	}
+};
+
+/** Writes the bits of a Bink video packet, LSB first. */
+struct BitWriter {
+	std::vector<byte> data;
+	size_t pos;
+
+	BitWriter() : pos(0) {
+	}
+
+	void putBits(uint32 value, size_t n) {
+		for (size_t i = 0; i < n; i++, pos++) {
+			if ((pos % 8) == 0)
+				data.push_back(0);
+
+			data.back() |= ((value >> i) & 1) << (pos % 8);
+		}
+	}
+
+	void align32() {
+		while ((pos % 32) != 0)
+			putBits(0, 1);
+	}
+
+	void patchUint32(size_t offset, uint32 value) {
+		for (size_t i = 0; i < 4; i++)
+			data[offset + i] = (value >> (8 * i)) & 0xFF;
+	}
+};
+
+/** One plane of the video, as the decoder should see it. */
+struct Plane {
+	uint32 width;
+	uint32 height;
+
+	std::vector<byte> pixels;
+
+	Plane(uint32 w = 0, uint32 h = 0) : width(w), height(h), pixels(w * h, 0) {
+	}
+};
+
+/** Write a plane made of fill, raw and (for inter frames) skipped blocks, and apply it to our copy. */
+static void writePlane(BitWriter &bits, Plane &plane, Random &random, bool keyFrame) {
+	const uint32 blockWidth  = plane.width  / 8;
+	const uint32 blockHeight = plane.height / 8;
+
+	// Raw nibbles for all bundles except the DCs, and for the high nibbles of the colors
+	for (size_t i = 0; i < kSourceMAX; i++) {
+		if (i == kSourceColors)
+			for (size_t j = 0; j < 16; j++)
+				bits.putBits(0, 4);
+
+		if ((i != kSourceIntraDC) && (i != kSourceInterDC))
+			bits.putBits(0, 4);
+	}
+
+	for (uint32 y = 0; y < blockHeight; y++) {
+		std::vector<uint32> types;
+		std::vector<byte> colors;
+
+		for (uint32 x = 0; x < blockWidth; x++) {
+			// Always have at least one color in each row, so that the color bundle continues
+			uint32 type = kBlockFill;
+			if (x > 0) {
+				const uint32 r = random.next() % 3;
+
+				type = (r == 0) ? kBlockRaw : (((r == 1) && !keyFrame) ? kBlockSkip : kBlockFill);
+			}
+
+			types.push_back(type);
+
+			byte *dest = &plane.pixels[(y * 8) * plane.width + x * 8];
+
+			if (type == kBlockFill) {
+				const byte color = random.next();
+
+				colors.push_back(color);
+				for (uint32 i = 0; i < 8; i++)
+					std::memset(dest + i * plane.width, color, 8);
+
+			} else if (type == kBlockRaw) {
+				for (uint32 i = 0; i < 64; i++) {
+					const byte color = random.next();
+
+					colors.push_back(color);
+					dest[(i / 8) * plane.width + (i % 8)] = color;
+				}
+			}
+		}
+
+		// Block types, one nibble each
+		bits.putBits(types.size(), kCountLength);
+		bits.putBits(0, 1);
+		for (size_t i = 0; i < types.size(); i++)
+			bits.putBits(types[i], 4);
+
+		// No sub block types. An empty bundle ends it for the rest of the plane
+		if (y == 0)
+			bits.putBits(0, kCountLength);
+
+		// Colors, high nibble and low nibble
+		bits.putBits(colors.size(), kCountLength);
+		bits.putBits(0, 1);
+		for (size_t i = 0; i < colors.size(); i++) {
+			bits.putBits(colors[i] >> 4, 4);
+			bits.putBits(colors[i] & 0x0F, 4);
+		}
+
+		// No patterns, motion values, DCs or runs
+		if (y == 0)
+			for (size_t i = kSourceColors + 1; i < kSourceMAX; i++)
+				bits.putBits(0, kCountLength);
+	}
+
+	bits.align32();
+}
+
+/** Write a group of planes, with the offset to the next group in front, if requested. */
+static void writePlaneGroup(BitWriter &bits, Plane *planes, size_t planeCount, bool hasOffset,
+                            int32 offsetError, Random &random, bool keyFrame) {
+
+	const size_t offsetPos = bits.pos / 8;
+	if (hasOffset)
+		bits.putBits(0, 32);
+
+	for (size_t i = 0; i < planeCount; i++)
+		writePlane(bits, planes[i], random, keyFrame);
+
+	// The offset points to the end of the group, counted from the start of the packet
+	if (hasOffset)
+		bits.patchUint32(offsetPos, (bits.pos / 8) + offsetError);
+}
+
+/** A synthetic BIKi video with alpha, together with what its frames should look like. */
+struct TestVideo {
+	std::vector<byte> file;
+	std::vector<Graphics::Surface *> frames;
+
+	/** Create a video, where the offset in front of the luma planes of this frame is broken. */
+	TestVideo(uint32 brokenFrame = 0xFFFFFFFF) {
+		Random random;
+
+		// Y, V, U, A: BIKi videos have the chroma planes swapped
+		Plane planes[4] = {
+			Plane(kWidth, kHeight), Plane(kWidth / 2, kHeight / 2), Plane(kWidth / 2, kHeight / 2), Plane(kWidth, kHeight)
+		};
+
+		std::vector< std::vector<byte> > packets;
+		for (uint32 i = 0; i < kFrameCount; i++) {
+			const bool keyFrame = i == 0;
+
+			BitWriter bits;
+
+			writePlaneGroup(bits, &planes[3], 1, true, 0, random, keyFrame);
+			writePlaneGroup(bits, &planes[0], 1, true, (i == brokenFrame) ? 4 : 0, random, keyFrame);
+			writePlaneGroup(bits, &planes[1], 2, false, 0, random, keyFrame);
+
+			packets.push_back(bits.data);
+
+			Graphics::Surface *frame = new Graphics::Surface(kWidth, NEXTPOWER2(kHeight));
+			frames.push_back(frame);
+
+			frame->fill(0, 0, 0, 0);
+			YUVToRGBMan.convert420(Graphics::YUVToRGBManager::kScaleITU, frame->getData(), frame->getWidth() * 4,
+			                       &planes[0].pixels[0], &planes[2].pixels[0], &planes[1].pixels[0],
+			                       &planes[3].pixels[0], kWidth, kHeight, kWidth, kWidth / 2);
+		}
+
+		Common::MemoryWriteStreamDynamic header(true);
+
+		const uint32 headerSize = 44 + kFrameCount * 4;
+
+		uint32 fileSize = headerSize, largestFrameSize = 0;
+		for (size_t i = 0; i < packets.size(); i++) {
+			fileSize        += packets[i].size();
+			largestFrameSize = MAX<uint32>(largestFrameSize, packets[i].size());
+		}
+
+		header.writeUint32BE(MKTAG('B', 'I', 'K', 'i'));
+		header.writeUint32LE(fileSize - 8);
+		header.writeUint32LE(kFrameCount);
+		header.writeUint32LE(largestFrameSize);
+		header.writeUint32LE(0);
+		header.writeUint32LE(kWidth);
+		header.writeUint32LE(kHeight);
+		header.writeUint32LE(30);
+		header.writeUint32LE(1);
+		header.writeUint32LE(kVideoFlagAlpha);
+		header.writeUint32LE(0);
+
+		uint32 offset = headerSize;
+		for (size_t i = 0; i < packets.size(); i++) {
+			header.writeUint32LE(offset | ((i == 0) ? 1 : 0));
+			offset += packets[i].size();
+		}
+
+		file.assign(header.getData(), header.getData() + header.size());
+		for (size_t i = 0; i < packets.size(); i++)
+			file.insert(file.end(), packets[i].begin(), packets[i].end());
+	}
+
+	~TestVideo() {
+		for (std::vector<Graphics::Surface *>::iterator f = frames.begin(); f != frames.end(); ++f)
+			delete *f;
+	}
+};
+
+/** A Bink decoder we can step through frame by frame. */
+class TestBink : public Video::Bink {
+public:
+	TestBink(const std::vector<byte> &file, bool parallel) :
+		Bink(new Common::MemoryReadStream(&file[0], file.size())) {
+
+		setParallelPlanes(parallel);
+	}
+
+	const Graphics::Surface &decodeFrame() {
+		decodeNextTrackFrame(static_cast<VideoTrack &>(*getTrack(0)));
+
+		return *_surface;
+	}
+};
+
+static void compareFrames(const Graphics::Surface &frame, const Graphics::Surface &expected, uint32 n) {
+	ASSERT_EQ(frame.getWidth(), expected.getWidth()) << "At frame " << n;
+	ASSERT_EQ(frame.getHeight(), expected.getHeight()) << "At frame " << n;
+
+	const size_t size = expected.getWidth() * expected.getHeight() * 4;
+	for (size_t i = 0; i < size; i++)
+		ASSERT_EQ(frame.getData()[i], expected.getData()[i]) << "At frame " << n << ", byte " << i;
+}
+
+static void decodeVideo(const TestVideo &video) {
+	// Creating the video's texture needs to know which thread is the main thread
+	if (!Common::initedThreads())
+		Common::initThreads();
+
+	TestBink serial(video.file, false);
+	TestBink parallel(video.file, true);
+
+	for (uint32 i = 0; i < kFrameCount; i++) {
+		compareFrames(serial.decodeFrame(), *video.frames[i], i);
+		compareFrames(parallel.decodeFrame(), *video.frames[i], i);
+	}
+}
+
+GTEST_TEST(Bink, decodeFrames) {
+	TestVideo video;
+
+	decodeVideo(video);
+}
+
+GTEST_TEST(Bink, brokenPlaneOffset) {
+	// The parallel decoder has to notice and decode the planes serially again
+	TestVideo video(3);
+
+	decodeVideo(video);
+}
@@ -0,0 +1,154 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the Bink DSP routines.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/video/binkdsp.h"
+
+static const uint32 kPlaneWidth  = 64;
+static const uint32 kPlaneHeight = 48;
+
+/** A simple pseudo-random number generator, to get the same blocks every time. */
+struct Random {
+	uint32 seed;
+
+	Random() : seed(0x2468ACE) {
+	}
+
+	uint32 next() {
+		seed = seed * 1664525 + 1013904223;
+		return seed >> 8;
+	}
+};
+
+/** Fill a block of coefficients, looking roughly like real Bink data. */
+static void fillBlock(Random &random, int16 *block, size_t variant) {
+	std::memset(block, 0, 64 * sizeof(int16));
+
+	switch (variant % 4) {
+		case 0: // Only DC
+			block[0] = (random.next() % 4096) - 2048;
+			break;
+
+		case 1: // Sparse, small coefficients
+			for (int i = 0; i < 64; i++)
+				if ((random.next() % 4) == 0)
+					block[i] = (random.next() % 512) - 256;
+			break;
+
+		case 2: // Full, large coefficients
+			for (int i = 0; i < 64; i++)
+				block[i] = (random.next() % 65536) - 32768;
+			break;
+
+		case 3: // Only the first column
+			for (int i = 0; i < 64; i += 8)
+				block[i] = (random.next() % 8192) - 4096;
+			break;
+	}
+}
+
+static uint32 checksum(const byte *data, size_t size) {
+	uint32 sum = 0;
+	for (size_t i = 0; i < size; i++)
+		sum = (sum * 31) + data[i];
+
+	return sum;
+}
+
+typedef void (*BlockFunction)(byte *dest, uint32 pitch, const int16 *block);
+
+/** Decode a synthetic frame by applying a block function to every 8x8 block of a plane. */
+static void decodeFrame(std::vector<byte> &plane, BlockFunction function) {
+	Random random;
+
+	for (size_t i = 0; i < plane.size(); i++)
+		plane[i] = random.next();
+
+	for (uint32 y = 0; y < kPlaneHeight; y += 8) {
+		for (uint32 x = 0; x < kPlaneWidth; x += 8) {
+			int16 block[64];
+			fillBlock(random, block, (y / 8) * (kPlaneWidth / 8) + (x / 8));
+
+			function(&plane[y * kPlaneWidth + x], kPlaneWidth, block);
+		}
+	}
+}
+
+static void testFrame(BlockFunction simd, BlockFunction scalar) {
+	std::vector<byte> planeSIMD(kPlaneWidth * kPlaneHeight), planeScalar(kPlaneWidth * kPlaneHeight);
+
+	decodeFrame(planeSIMD  , simd);
+	decodeFrame(planeScalar, scalar);
+
+	EXPECT_EQ(checksum(&planeSIMD[0], planeSIMD.size()), checksum(&planeScalar[0], planeScalar.size()));
+
+	for (size_t i = 0; i < planeSIMD.size(); i++)
+		ASSERT_EQ(planeSIMD[i], planeScalar[i]) << "At pixel " << i;
+}
+
+GTEST_TEST(BinkDSP, IDCT) {
+	Random random;
+
+	for (size_t n = 0; n < 1024; n++) {
+		int16 blockSIMD[64], blockScalar[64];
+
+		fillBlock(random, blockSIMD, n);
+		std::memcpy(blockScalar, blockSIMD, sizeof(blockScalar));
+
+		Video::binkIDCT(blockSIMD);
+		Video::binkIDCTScalar(blockScalar);
+
+		for (int i = 0; i < 64; i++)
+			ASSERT_EQ(blockSIMD[i], blockScalar[i]) << "At block " << n << ", coefficient " << i;
+	}
+}
+
+GTEST_TEST(BinkDSP, IDCTPut) {
+	testFrame(&Video::binkIDCTPut, &Video::binkIDCTPutScalar);
+}
+
+GTEST_TEST(BinkDSP, IDCTAdd) {
+	testFrame(&Video::binkIDCTAdd, &Video::binkIDCTAddScalar);
+}
+
+GTEST_TEST(BinkDSP, addBlock) {
+	testFrame(&Video::binkAddBlock, &Video::binkAddBlockScalar);
+}
+
+GTEST_TEST(BinkDSP, IDCTDCOnly) {
+	// A block with only a DC value transforms into a flat block
+	int16 block[64];
+	std::memset(block, 0, sizeof(block));
+	block[0] = 1024;
+
+	byte dest[64];
+	Video::binkIDCTPut(dest, 8, block);
+
+	for (int i = 0; i < 64; i++)
+		EXPECT_EQ(dest[i], (1024 + 0x7F) >> 8) << "At pixel " << i;
+}
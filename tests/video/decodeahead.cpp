@@ -0,0 +1,185 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for decoding video frames ahead of time.
+ */
+
+#include <stdexcept>
+#include <atomic>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+
+#include "src/graphics/images/surface.h"
+
+#include "src/video/decodeahead.h"
+
+static const int kWidth  = 16;
+static const int kHeight = 8;
+
+/** A synthetic video stream: each frame is filled with its number and shown at 30fps. */
+struct FrameCounter {
+	uint32 frames;
+	std::atomic<uint32> current;
+	uint32 throwAt;
+
+	FrameCounter(uint32 f, uint32 t = 0xFFFFFFFF) : frames(f), current(0), throwAt(t) {
+	}
+
+	bool decode(Graphics::Surface &surface, uint32 &time) {
+		if (current == throwAt)
+			throw Common::Exception("Broken frame %u", current.load());
+
+		if (current >= frames)
+			return false;
+
+		const byte frame = current;
+
+		surface.fill(frame, frame, frame, 0xFF);
+		time = getTime(frame);
+
+		current++;
+		return true;
+	}
+
+	static uint32 getTime(uint32 frame) {
+		return (frame * 1000) / 30;
+	}
+};
+
+static Video::DecodeAhead::DecodeFunction getDecoder(FrameCounter &counter) {
+	return [&counter](Graphics::Surface &surface, uint32 &time) { return counter.decode(surface, time); };
+}
+
+static uint32 getFrameNumber(const Graphics::Surface &surface) {
+	return const_cast<Graphics::Surface &>(surface).getData()[0];
+}
+
+/** Wait until the next decoded frame is available, and return its time. */
+static bool waitForFrame(const Video::DecodeAhead &decodeAhead, uint32 &time) {
+	if (decodeAhead.waitForFrames(1) == 0)
+		return false;
+
+	return decodeAhead.getNextFrameTime(time);
+}
+
+GTEST_TEST(DecodeAhead, noFrames) {
+	FrameCounter counter(10);
+
+	EXPECT_THROW(Video::DecodeAhead decodeAhead(0, kWidth, kHeight, getDecoder(counter)), Common::Exception);
+}
+
+GTEST_TEST(DecodeAhead, inOrder) {
+	FrameCounter counter(20);
+
+	Video::DecodeAhead decodeAhead(4, kWidth, kHeight, getDecoder(counter));
+	decodeAhead.start();
+
+	for (uint32 i = 0; i < 20; i++) {
+		uint32 time = 0;
+		ASSERT_TRUE(waitForFrame(decodeAhead, time)) << "At frame " << i;
+		EXPECT_EQ(time, FrameCounter::getTime(i)) << "At frame " << i;
+
+		// Not due yet
+		if (time > 0)
+			EXPECT_EQ(decodeAhead.getFrame(time - 1), static_cast<const Graphics::Surface *>(0)) << "At frame " << i;
+
+		const Graphics::Surface *frame = decodeAhead.getFrame(time);
+		ASSERT_NE(frame, static_cast<const Graphics::Surface *>(0)) << "At frame " << i;
+		EXPECT_EQ(getFrameNumber(*frame), i) << "At frame " << i;
+	}
+
+	uint32 time = 0;
+	EXPECT_FALSE(waitForFrame(decodeAhead, time));
+	EXPECT_TRUE(decodeAhead.endOfStream());
+	EXPECT_EQ(decodeAhead.getFrame(0xFFFFFFFF), static_cast<const Graphics::Surface *>(0));
+}
+
+GTEST_TEST(DecodeAhead, bounded) {
+	FrameCounter counter(20);
+
+	Video::DecodeAhead decodeAhead(4, kWidth, kHeight, getDecoder(counter));
+	decodeAhead.start();
+
+	// Wait until all surfaces are filled, then stop
+	EXPECT_EQ(decodeAhead.waitForFrames(5), 4U);
+	decodeAhead.stop();
+
+	EXPECT_EQ(counter.current, 4U);
+	EXPECT_FALSE(decodeAhead.endOfStream());
+}
+
+GTEST_TEST(DecodeAhead, skipLateFrames) {
+	FrameCounter counter(20);
+
+	Video::DecodeAhead decodeAhead(4, kWidth, kHeight, getDecoder(counter));
+	decodeAhead.start();
+
+	// Wait until all four frames have been decoded
+	ASSERT_EQ(decodeAhead.waitForFrames(4), 4U);
+
+	// Frames 0 to 2 are due, only the newest should be shown
+	const Graphics::Surface *frame = decodeAhead.getFrame(FrameCounter::getTime(2));
+	ASSERT_NE(frame, static_cast<const Graphics::Surface *>(0));
+	EXPECT_EQ(getFrameNumber(*frame), 2U);
+
+	uint32 time = 0;
+	ASSERT_TRUE(waitForFrame(decodeAhead, time));
+	EXPECT_EQ(time, FrameCounter::getTime(3));
+
+	// Way past the end: skip to the last frame
+	uint32 last = 0;
+	while (decodeAhead.waitForFrames(1) > 0) {
+		frame = decodeAhead.getFrame(0xFFFFFFFF);
+		ASSERT_NE(frame, static_cast<const Graphics::Surface *>(0));
+
+		last = getFrameNumber(*frame);
+	}
+
+	EXPECT_TRUE(decodeAhead.endOfStream());
+	EXPECT_EQ(last, 19U);
+}
+
+GTEST_TEST(DecodeAhead, error) {
+	FrameCounter counter(20, 3);
+
+	Video::DecodeAhead decodeAhead(4, kWidth, kHeight, getDecoder(counter));
+	decodeAhead.start();
+
+	// The frames before the broken one still get shown
+	for (uint32 i = 0; i < 3; i++) {
+		uint32 time = 0;
+		ASSERT_TRUE(waitForFrame(decodeAhead, time)) << "At frame " << i;
+
+		const Graphics::Surface *frame = decodeAhead.getFrame(time);
+		ASSERT_NE(frame, static_cast<const Graphics::Surface *>(0)) << "At frame " << i;
+		EXPECT_EQ(getFrameNumber(*frame), i) << "At frame " << i;
+	}
+
+	uint32 time = 0;
+	EXPECT_FALSE(waitForFrame(decodeAhead, time));
+
+	// Not over before the error has been seen
+	EXPECT_FALSE(decodeAhead.endOfStream());
+	EXPECT_THROW(decodeAhead.getFrame(0xFFFFFFFF), Common::Exception);
+	EXPECT_TRUE(decodeAhead.endOfStream());
+}
@@ -0,0 +1,131 @@
+/* xoreos - A reimplementation of BioWare's Aurora engine
+ *
+ * xoreos is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * xoreos is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * xoreos is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the generic video decoder interface.
+ */
+
+#include <cstring>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+
+#include "src/graphics/images/surface.h"
+
+#include "src/video/decoder.h"
+
+static const uint32 kWidth  = 16;
+static const uint32 kHeight = 8;
+
+/** A synthetic video, whose decoding fails at a certain frame. */
+class TestVideo : public Video::VideoDecoder {
+public:
+	TestVideo(int frameCount, int brokenFrame) : _brokenFrame(brokenFrame), _frame(kWidth * kHeight * 4) {
+		_track = new TestVideoTrack(frameCount);
+		addTrack(_track);
+
+		// Not initVideo(), we don't have a GL context to create the texture in
+		_surface.reset(new Graphics::Surface(kWidth, kHeight));
+	}
+
+	~TestVideo() {
+		stopDecodeAhead();
+	}
+
+	using VideoDecoder::update;
+
+protected:
+	void decodeNextTrackFrame(VideoTrack &UNUSED(track)) {
+		const int frame = _track->nextFrame();
+		if (frame == _brokenFrame)
+			throw Common::Exception("Broken frame %d", frame);
+
+		std::memset(&_frame[0], frame, _frame.size());
+		std::memcpy(_surface->getData(), &_frame[0], _frame.size());
+
+		_needCopy = true;
+	}
+
+private:
+	class TestVideoTrack : public FixedRateVideoTrack {
+	public:
+		TestVideoTrack(int frameCount) : _frameCount(frameCount), _curFrame(-1) {
+		}
+
+		uint32 getWidth() const { return kWidth; }
+		uint32 getHeight() const { return kHeight; }
+		int getCurFrame() const { return _curFrame; }
+		int getFrameCount() const { return _frameCount; }
+
+		int nextFrame() { return ++_curFrame; }
+
+	protected:
+		Common::Rational getFrameRate() const { return 30; }
+
+	private:
+		int _frameCount;
+		int _curFrame;
+	};
+
+	TestVideoTrack *_track;
+
+	int _brokenFrame;
+
+	/** Lives in the subclass, so it must not be touched after its destructor ran. */
+	std::vector<byte> _frame;
+};
+
+GTEST_TEST(VideoDecoder, decodeAheadError) {
+	TestVideo video(20, 0);
+	video.setDecodeAhead(4);
+
+	// Returns once the decoding failed, since no frame could be decoded
+	video.start();
+
+	// The error has not been seen yet, so the video isn't over
+	EXPECT_FALSE(video.endOfVideo());
+
+	try {
+		video.update();
+
+		ADD_FAILURE() << "update() did not rethrow the decode error";
+	} catch (Common::Exception &e) {
+		EXPECT_STREQ(e.what(), "Broken frame 0");
+	}
+
+	EXPECT_TRUE(video.endOfVideo());
+
+	video.abort();
+}
+
+GTEST_TEST(VideoDecoder, decodeAheadDestroy) {
+	for (size_t i = 0; i < 20; i++) {
+		// Destroy the video while it is still decoding frames ahead
+		TestVideo video(1000, -1);
+		video.setDecodeAhead(8);
+
+		video.start();
+
+		EXPECT_FALSE(video.endOfVideo());
+	}
+}
@@ -0,0 +1,68 @@
+# xoreos - A reimplementation of BioWare's Aurora engine
+#
+# xoreos is the legal property of its developers, whose names
+# can be found in the AUTHORS file distributed with this source
+# distribution.
+#
+# xoreos is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 3
+# of the License, or (at your option) any later version.
+#
+# xoreos is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with xoreos. If not, see <http://www.gnu.org/licenses/>.
+
+
+# Unit tests for the Video namespace.
+
+video_LIBS = \
+    $(test_LIBS) \
+    src/video/libvideo.la \
+    src/graphics/libgraphics.la \
+    src/aurora/libaurora.la \
+    src/common/libcommon.la \
+    tests/version/libversion.la \
+    $(LDADD)
+
+check_PROGRAMS                        += tests/video/test_decodeahead
+tests_video_test_decodeahead_SOURCES  = tests/video/decodeahead.cpp
+tests_video_test_decodeahead_LDADD    = $(video_LIBS)
+tests_video_test_decodeahead_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                    += tests/video/test_binkdsp
+tests_video_test_binkdsp_SOURCES  = tests/video/binkdsp.cpp
+tests_video_test_binkdsp_LDADD    = $(video_LIBS)
+tests_video_test_binkdsp_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                    += tests/video/test_decoder
+tests_video_test_decoder_SOURCES  = tests/video/decoder.cpp
+tests_video_test_decoder_LDADD    = \
+    $(test_LIBS) \
+    src/video/libvideo.la \
+    src/sound/libsound.la \
+    src/graphics/libgraphics.la \
+    src/events/libevents.la \
+    src/aurora/libaurora.la \
+    src/common/libcommon.la \
+    tests/version/libversion.la \
+    $(LDADD)
+tests_video_test_decoder_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                 += tests/video/test_bink
+tests_video_test_bink_SOURCES  = tests/video/bink.cpp
+tests_video_test_bink_LDADD    = \
+    $(test_LIBS) \
+    src/video/libvideo.la \
+    src/sound/libsound.la \
+    src/graphics/libgraphics.la \
+    src/events/libevents.la \
+    src/aurora/libaurora.la \
+    src/common/libcommon.la \
+    tests/version/libversion.la \
+    $(LDADD)
+tests_video_test_bink_CXXFLAGS = $(test_CXXFLAGS)